@@ -3,13 +3,26 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <algorithm>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <stdlib.h>
 
+// Read every asset back after writing it and compare it with the source
+#define VALIDATE_ASSETS 0
+// Store meshes as quantized vertex streams (see quantized_mesh_vertices) instead of floats
+#define QUANTIZE_MESH_VERTICES 1
+// Compress vertex streams and indices with the mesh stream codec (see dummy_mesh_codec.h)
+#define COMPRESS_MESH_STREAMS 1
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
 
 using std::string;
 
@@ -201,7 +201,7 @@ ProcessAudioAsset(const char *FilePath, const char *OutputPath)
     LoadAudioAsset(FilePath, &Asset);
     WriteAudioAsset(OutputPath, &Asset);
 
-#if 1
+#if VALIDATE_ASSETS
     audio_clip_asset TestAsset = {};
     ReadAudioAsset(OutputPath, &TestAsset, &Asset);
 #endif
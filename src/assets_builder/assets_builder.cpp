@@ -1,12 +1,93 @@
 #define _CRT_SECURE_NO_WARNINGS
 
+// Textures first, the models compress their material textures with the same code
+#include "assets_textures.cpp"
 #include "assets_models.cpp"
 #include "assets_fonts.cpp"
 #include "assets_audio.cpp"
-#include "assets_textures.cpp"
+#include "assets_cache.cpp"
+
+enum asset_build_type
+{
+    AssetBuild_Model,
+    AssetBuild_Font,
+    AssetBuild_Audio,
+    AssetBuild_Texture
+};
+
+inline const char *
+GetAssetBuildTypeName(asset_build_type Type)
+{
+    switch (Type)
+    {
+        case AssetBuild_Model: return "model";
+        case AssetBuild_Font: return "font";
+        case AssetBuild_Audio: return "audio";
+        case AssetBuild_Texture: return "texture";
+        default: return "";
+    }
+}
+
+// Changing an option rebuilds the assets it affects
+inline const char *
+GetAssetBuildOptions(asset_build_type Type)
+{
+    const char *Result = GetAssetBuildTypeName(Type);
+
+    if (Type == AssetBuild_Model)
+    {
+        Result = QUANTIZE_MESH_VERTICES ?
+            (COMPRESS_MESH_STREAMS ? "model:quantized:compressed" : "model:quantized") :
+            (COMPRESS_MESH_STREAMS ? "model:compressed" : "model");
+    }
+
+    return Result;
+}
+
+struct asset_build_task
+{
+    asset_build_type Type;
+    string FilePath;
+
+    // Only set for models with animations (folder with the model, its animation graph and clips)
+    string AnimationConfigPath;
+    string AnimationClipsPath;
+
+    asset_build_entry Entry;
+    bool32 UpToDate;
+
+    u64 AssetSize;
+    u64 RawSize;
+};
+
+inline void
+AddBuildDependency(asset_build_task *Task, const string &FilePath)
+{
+    if (fs::is_regular_file(FilePath))
+    {
+        Task->Entry.Dependencies.push_back(GetBuildDependency(FilePath));
+    }
+}
+
+dummy_internal void
+AddBuildTask(dynamic_array<asset_build_task> &Tasks, asset_build_type Type, const string &FilePath, const char *OutputPath)
+{
+    asset_build_task Task = {};
+    Task.Type = Type;
+    Task.FilePath = FilePath;
+
+    char AssetPath[256];
+    FormatString(AssetPath, "%s/%s.%s.asset", OutputPath, fs::path(FilePath).stem().generic_string().c_str(), GetAssetBuildTypeName(Type));
+
+    Task.Entry.AssetPath = AssetPath;
+
+    AddBuildDependency(&Task, FilePath);
+
+    Tasks.push_back(Task);
+}
 
 dummy_internal void
-BuildModelAssets(const char *InputPath, const char *OutputPath)
+CollectModelAssets(dynamic_array<asset_build_task> &Tasks, const char *InputPath, const char *OutputPath)
 {
     for (const fs::directory_entry &Entry : fs::directory_iterator(InputPath))
     {
@@ -42,99 +123,329 @@ BuildModelAssets(const char *InputPath, const char *OutputPath)
             char AnimationClipsPath[256];
             FormatString(AnimationClipsPath, "%s/clips", EntryPath.generic_string().c_str());
 
-            char AssetPath[256];
-            FormatString(AssetPath, "%s/%s.model.asset", OutputPath, EntryName.generic_string().c_str());
+            AddBuildTask(Tasks, AssetBuild_Model, FilePath, OutputPath);
+
+            asset_build_task *Task = &Tasks.back();
+            Task->AnimationConfigPath = AnimationConfigPath;
+            Task->AnimationClipsPath = AnimationClipsPath;
+
+            // Model is rebuilt when its animation graph or any of its clips change
+            AddBuildDependency(Task, AnimationConfigPath);
+
+            if (fs::is_directory(AnimationClipsPath))
+            {
+                dynamic_array<string> ClipPaths;
+
+                for (const fs::directory_entry &ClipEntry : fs::recursive_directory_iterator(AnimationClipsPath))
+                {
+                    if (ClipEntry.is_regular_file())
+                    {
+                        ClipPaths.push_back(ClipEntry.path().generic_string());
+                    }
+                }
+
+                // Directory order is not guaranteed, the key must not depend on it
+                std::sort(ClipPaths.begin(), ClipPaths.end());
 
-            printf("Processing %s...\n", FilePath);
-            ProcessModelAsset(FilePath, AnimationConfigPath, AnimationClipsPath, AssetPath);
+                for (string &ClipPath : ClipPaths)
+                {
+                    AddBuildDependency(Task, ClipPath);
+                }
+            }
         }
         else
         {
-            char AssetPath[256];
-            FormatString(AssetPath, "%s/%s.model.asset", OutputPath, EntryName.generic_string().c_str());
-
-            printf("Processing %s...\n", EntryPath.generic_string().c_str());
-            ProcessModelAsset(EntryPath.generic_string().c_str(), AssetPath);
+            AddBuildTask(Tasks, AssetBuild_Model, EntryPath.generic_string(), OutputPath);
         }
     }
 }
 
 dummy_internal void
-BuildFontAssets(const char *InputPath, const char *OutputPath)
+CollectAssets(dynamic_array<asset_build_task> &Tasks, asset_build_type Type, const char *InputPath, const char *OutputPath)
 {
     for (const fs::directory_entry &Entry : fs::directory_iterator(InputPath))
     {
-        fs::path FilePath = Entry.path();
-        fs::path FileName = Entry.path().stem();
-
-        char AssetPath[256];
-        FormatString(AssetPath, "%s/%s.font.asset", OutputPath, FileName.generic_string().c_str());
-
-        printf("Processing %s...\n", FilePath.generic_string().c_str());
-        ProcessFontAsset(FilePath.generic_string().c_str(), AssetPath);
+        if (Entry.is_regular_file())
+        {
+            AddBuildTask(Tasks, Type, Entry.path().generic_string(), OutputPath);
+        }
     }
 }
 
 dummy_internal void
-BuildAudioAssets(const char *InputPath, const char *OutputPath)
+ProcessBuildTask(asset_build_task *Task)
 {
-    for (const fs::directory_entry &Entry : fs::directory_iterator(InputPath))
-    {
-        fs::path FilePath = Entry.path();
-        fs::path FileName = Entry.path().stem();
+    const char *FilePath = Task->FilePath.c_str();
+    const char *AssetPath = Task->Entry.AssetPath.c_str();
 
-        char AssetPath[256];
-        FormatString(AssetPath, "%s/%s.audio.asset", OutputPath, FileName.generic_string().c_str());
+    printf("Processing %s...\n", FilePath);
 
-        printf("Processing %s...\n", FilePath.generic_string().c_str());
-        ProcessAudioAsset(FilePath.generic_string().c_str(), AssetPath);
+    switch (Task->Type)
+    {
+        case AssetBuild_Model:
+        {
+            if (Task->AnimationConfigPath.empty())
+            {
+                ProcessModelAsset(FilePath, AssetPath);
+            }
+            else
+            {
+                ProcessModelAsset(FilePath, Task->AnimationConfigPath.c_str(), Task->AnimationClipsPath.c_str(), AssetPath);
+            }
+            break;
+        }
+        case AssetBuild_Font:
+        {
+            ProcessFontAsset(FilePath, AssetPath);
+            break;
+        }
+        case AssetBuild_Audio:
+        {
+            ProcessAudioAsset(FilePath, AssetPath);
+            break;
+        }
+        case AssetBuild_Texture:
+        {
+            ProcessTextureAsset(FilePath, AssetPath, &Task->AssetSize, &Task->RawSize);
+            break;
+        }
+        default:
+        {
+            NotImplemented;
+        }
     }
 }
 
-dummy_internal void
-BuildTextureAssets(const char *InputPath, const char *OutputPath)
+/*
+    Builds only the assets whose inputs, options or builder version changed since the last build.
+    Stale assets are processed in parallel (one asset per thread at a time), assets without a source are deleted.
+    Returns true if anything in the output folder changed.
+*/
+dummy_internal bool32
+BuildAssets(const char *OutputPath, const char *CachePath)
 {
-    for (const fs::directory_entry &Entry : fs::directory_iterator(InputPath))
+    dynamic_array<asset_build_task> Tasks;
+
+    CollectModelAssets(Tasks, "../assets/models", OutputPath);
+    CollectAssets(Tasks, AssetBuild_Font, "../assets/fonts", OutputPath);
+    CollectAssets(Tasks, AssetBuild_Audio, "../assets/audio", OutputPath);
+    CollectAssets(Tasks, AssetBuild_Texture, "../assets/textures", OutputPath);
+
+    asset_build_cache Cache;
+    LoadAssetBuildCache(&Cache, CachePath);
+
+    // Content of changed files is hashed in parallel as well
+    ParallelFor((u32)Tasks.size(), [&Tasks, &Cache](u32 TaskIndex)
+    {
+        asset_build_task *Task = &Tasks[TaskIndex];
+        Task->UpToDate = CheckAssetBuildCache(&Cache, &Task->Entry, GetAssetBuildOptions(Task->Type));
+    });
+
+    dynamic_array<asset_build_task *> StaleTasks;
+
+    for (asset_build_task &Task : Tasks)
+    {
+        if (!Task.UpToDate)
+        {
+            StaleTasks.push_back(&Task);
+        }
+    }
+
+    ParallelFor((u32)StaleTasks.size(), [&StaleTasks](u32 TaskIndex)
+    {
+        ProcessBuildTask(StaleTasks[TaskIndex]);
+    });
+
+    bool32 Result = StaleTasks.size() > 0;
+
+    hashtable<string, asset_build_entry> BuiltEntries;
+
+    for (asset_build_task &Task : Tasks)
+    {
+        BuiltEntries[Task.Entry.AssetPath] = Task.Entry;
+    }
+
+    for (const fs::directory_entry &Entry : fs::directory_iterator(OutputPath))
     {
         fs::path FilePath = Entry.path();
-        fs::path FileName = Entry.path().stem();
 
-        char AssetPath[256];
-        FormatString(AssetPath, "%s/%s.texture.asset", OutputPath, FileName.generic_string().c_str());
+        if (Entry.is_regular_file() && FilePath.extension() == ".asset" && BuiltEntries.find(FilePath.generic_string()) == BuiltEntries.end())
+        {
+            printf("Removing %s...\n", FilePath.generic_string().c_str());
+            fs::remove(FilePath);
 
-        printf("Processing %s...\n", FilePath.generic_string().c_str());
-        ProcessTextureAsset(FilePath.generic_string().c_str(), AssetPath);
+            Result = true;
+        }
+    }
+
+    Cache.Entries = BuiltEntries;
+    SaveAssetBuildCache(&Cache, CachePath);
+
+    u64 TotalAssetSize = 0;
+    u64 TotalRawSize = 0;
+
+    for (asset_build_task *Task : StaleTasks)
+    {
+        TotalAssetSize += Task->AssetSize;
+        TotalRawSize += Task->RawSize;
+    }
+
+    printf("Built %d of %d assets\n", (u32)StaleTasks.size(), (u32)Tasks.size());
+
+    if (TotalRawSize > 0)
+    {
+        // Raw size doesn't include the mips the game used to generate on load
+        printf("Textures: %.2f MB (raw pixels: %.2f MB)\n", (f32)TotalAssetSize / (f32)Megabytes(1), (f32)TotalRawSize / (f32)Megabytes(1));
     }
+
+    return Result;
 }
 
-dummy_internal void
-ClearFolder(const char *Path)
+struct asset_pack_file
+{
+    asset_pack_entry Entry;
+    string FilePath;
+};
+
+inline u64
+AlignAssetPackOffset(u64 Offset)
+{
+    u64 Result = (Offset + ASSET_PACK_ALIGNMENT - 1) & ~((u64)ASSET_PACK_ALIGNMENT - 1);
+    return Result;
+}
+
+/*
+    Concatenates all asset files into a single pack, which the game maps into memory instead of reading the files one by one.
+    Files are copied as is, so the offsets inside them stay relative to the start of the asset data.
+*/
+dummy_internal bool32
+BuildAssetPack(const char *AssetsPath, const char *PackPath)
 {
-    if (fs::is_directory(Path))
+    bool32 Result = false;
+
+    dynamic_array<asset_pack_file> PackFiles;
+
+    for (const fs::directory_entry &Entry : fs::directory_iterator(AssetsPath))
     {
-        for (const fs::directory_entry &Entry : fs::directory_iterator(Path))
+        fs::path FilePath = Entry.path();
+
+        if (!Entry.is_regular_file() || FilePath.extension() != ".asset")
         {
-            fs::remove_all(Entry.path());
+            continue;
         }
+
+        FILE *AssetFile = fopen(FilePath.generic_string().c_str(), "rb");
+        Assert(AssetFile);
+
+        asset_header Header = {};
+        fread(&Header, sizeof(asset_header), 1, AssetFile);
+
+        asset_pack_file PackFile = {};
+        PackFile.FilePath = FilePath.generic_string();
+        PackFile.Entry.Type = Header.Type;
+        PackFile.Entry.Size = GetFileSize(AssetFile);
+
+        fclose(AssetFile);
+
+        Assert(Header.MagicValue == 0x451);
+
+        // Same name as the game uses for the loose file: everything up to the first dot
+        char FileName[256];
+        CopyString(FilePath.filename().generic_string().c_str(), FileName);
+        RemoveExtension(FileName, PackFile.Entry.Name);
+
+        PackFile.Entry.NameHash = Hash(PackFile.Entry.Name);
+
+        PackFiles.push_back(PackFile);
     }
-    else
+
+    std::sort(PackFiles.begin(), PackFiles.end(), [](const asset_pack_file &A, const asset_pack_file &B)
+    {
+        bool Result = A.Entry.Type < B.Entry.Type || (A.Entry.Type == B.Entry.Type && A.Entry.NameHash < B.Entry.NameHash);
+        return Result;
+    });
+
+    asset_pack_header Header = {};
+    Header.MagicValue = ASSET_PACK_MAGIC_VALUE;
+    Header.Version = ASSET_PACK_VERSION;
+    Header.EntryCount = (u32)PackFiles.size();
+    Header.EntriesOffset = AlignAssetPackOffset(sizeof(asset_pack_header));
+
+    u64 CurrentOffset = AlignAssetPackOffset(Header.EntriesOffset + Header.EntryCount * sizeof(asset_pack_entry));
+    u64 MaxEntrySize = 0;
+
+    for (asset_pack_file &PackFile : PackFiles)
+    {
+        PackFile.Entry.Offset = CurrentOffset;
+        CurrentOffset = AlignAssetPackOffset(CurrentOffset + PackFile.Entry.Size);
+
+        MaxEntrySize = PackFile.Entry.Size > MaxEntrySize ? PackFile.Entry.Size : MaxEntrySize;
+    }
+
+    FILE *PackFile = fopen(PackPath, "wb");
+
+    if (!PackFile)
     {
-        fs::create_directory(Path);
+        // The running game keeps the pack mapped
+        printf("Could not open %s, the pack is left unchanged\n", PackPath);
+        return Result;
     }
+
+    u8 Padding[ASSET_PACK_ALIGNMENT] = {};
+
+    fwrite(&Header, sizeof(asset_pack_header), 1, PackFile);
+    fwrite(Padding, Header.EntriesOffset - sizeof(asset_pack_header), 1, PackFile);
+
+    for (asset_pack_file &File : PackFiles)
+    {
+        fwrite(&File.Entry, sizeof(asset_pack_entry), 1, PackFile);
+    }
+
+    u8 *Buffer = AllocateMemory<u8>(MaxEntrySize);
+
+    for (asset_pack_file &File : PackFiles)
+    {
+        u64 CurrentStreamPosition = ftell(PackFile);
+        Assert(CurrentStreamPosition <= File.Entry.Offset);
+
+        fwrite(Padding, File.Entry.Offset - CurrentStreamPosition, 1, PackFile);
+
+        FILE *AssetFile = fopen(File.FilePath.c_str(), "rb");
+
+        fread(Buffer, File.Entry.Size, 1, AssetFile);
+        fwrite(Buffer, File.Entry.Size, 1, PackFile);
+
+        fclose(AssetFile);
+    }
+
+    free(Buffer);
+
+    printf("Packed %d assets into %s\n", Header.EntryCount, PackPath);
+
+    fclose(PackFile);
+
+    Result = true;
+
+    return Result;
 }
 
 i32 main(i32 ArgCount, char **Args)
 {
     const char *GameAssetsPath = "assets";
+    const char *GameAssetPackPath = "assets/assets.pack";
+    const char *GameAssetBuildCachePath = "assets/build_cache.txt";
 
     if (ArgCount == 1)
     {
-        ClearFolder(GameAssetsPath);
+        // Assets from the previous build are kept, only the changed ones are rebuilt
+        fs::create_directory(GameAssetsPath);
 
-        BuildModelAssets("../assets/models", GameAssetsPath);
-        BuildFontAssets("../assets/fonts", GameAssetsPath);
-        BuildAudioAssets("../assets/audio", GameAssetsPath);
-        BuildTextureAssets("../assets/textures", GameAssetsPath);
+        bool32 AssetsChanged = BuildAssets(GameAssetsPath, GameAssetBuildCachePath);
+
+        if (AssetsChanged || !fs::exists(GameAssetPackPath))
+        {
+            BuildAssetPack(GameAssetsPath, GameAssetPackPath);
+        }
     }
     else if (ArgCount == 3)
     {
@@ -151,6 +462,30 @@ i32 main(i32 ArgCount, char **Args)
             {
                 FormatString(AssetPath, "%s/%s.model.asset", GameAssetsPath, EntryName.generic_string().c_str());
                 ProcessModelAsset(EntryPath.generic_string().c_str(), AssetPath);
+
+                // The pack can't be rewritten while the game has it mapped, the game picks up the newer loose file instead
+                if (!BuildAssetPack(GameAssetsPath, GameAssetPackPath))
+                {
+                    printf("%s is stale, run --pack %s once the game is closed\n", GameAssetPackPath, GameAssetsPath);
+                }
+                break;
+            }
+            case SID("--pack"):
+            {
+                BuildAssetPack(EntryPath.generic_string().c_str(), GameAssetPackPath);
+                break;
+            }
+            case SID("--benchmark-meshes"):
+            {
+                for (const fs::directory_entry &Entry : fs::directory_iterator(EntryPath))
+                {
+                    fs::path FilePath = Entry.path();
+
+                    if (Entry.is_regular_file() && FilePath.extension() == ".asset" && FilePath.stem().extension() == ".model")
+                    {
+                        BenchmarkMeshStreamDecoding(FilePath.generic_string().c_str());
+                    }
+                }
                 break;
             }
             default:
@@ -0,0 +1,261 @@
+#include "dummy.h"
+#include "assets.h"
+
+// Bump when the processing or the cache key changes, so every cached asset is rebuilt (asset format versions are part of the key)
+#define ASSETS_BUILDER_VERSION 4
+#define ASSET_BUILD_CACHE_VERSION 1
+
+struct asset_build_dependency
+{
+    string FilePath;
+
+    // Content is only hashed again when the size or the write time changes
+    u64 FileSize;
+    u64 WriteTime;
+    u64 ContentHash;
+};
+
+// Asset file and everything it is built from
+struct asset_build_entry
+{
+    string AssetPath;
+    // Builder version, options and the content of all dependencies
+    u64 Key;
+    dynamic_array<asset_build_dependency> Dependencies;
+};
+
+/*
+    Manifest of the last build, stored next to the assets as a text file:
+    asset <key> <dependency count> <asset path>
+    dependency <size> <write time> <content hash> <file path>
+*/
+struct asset_build_cache
+{
+    hashtable<string, asset_build_entry> Entries;
+};
+
+// FNV-1a
+inline u64
+HashBytes(const void *Data, umm Size, u64 Seed = 14695981039346656037ULL)
+{
+    u64 Result = Seed;
+    const u8 *Bytes = (const u8 *)Data;
+
+    for (umm ByteIndex = 0; ByteIndex < Size; ++ByteIndex)
+    {
+        Result ^= Bytes[ByteIndex];
+        Result *= 1099511628211ULL;
+    }
+
+    return Result;
+}
+
+dummy_internal u64
+HashFileContent(const char *FilePath)
+{
+    u64 Result = HashBytes(0, 0);
+
+    FILE *File = fopen(FilePath, "rb");
+
+    if (File)
+    {
+        u8 Buffer[Kilobytes(64)];
+        umm ReadSize;
+
+        while ((ReadSize = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+        {
+            Result = HashBytes(Buffer, ReadSize, Result);
+        }
+
+        fclose(File);
+    }
+
+    return Result;
+}
+
+inline asset_build_dependency
+GetBuildDependency(const string &FilePath)
+{
+    asset_build_dependency Result = {};
+
+    Result.FilePath = FilePath;
+    Result.FileSize = fs::file_size(FilePath);
+    Result.WriteTime = (u64)fs::last_write_time(FilePath).time_since_epoch().count();
+
+    return Result;
+}
+
+inline bool32
+DependencyUnchanged(asset_build_dependency *Dependency, asset_build_dependency *CachedDependency)
+{
+    bool32 Result =
+        Dependency->FilePath == CachedDependency->FilePath &&
+        Dependency->FileSize == CachedDependency->FileSize &&
+        Dependency->WriteTime == CachedDependency->WriteTime;
+
+    return Result;
+}
+
+dummy_internal void
+LoadAssetBuildCache(asset_build_cache *Cache, const char *CachePath)
+{
+    FILE *CacheFile = fopen(CachePath, "rb");
+
+    if (!CacheFile)
+    {
+        return;
+    }
+
+    u32 Version = 0;
+
+    if (fscanf(CacheFile, "version %u\n", &Version) == 1 && Version == ASSET_BUILD_CACHE_VERSION)
+    {
+        char Path[1024];
+        asset_build_entry Entry = {};
+        u32 DependencyCount;
+
+        while (fscanf(CacheFile, "asset %llx %u %1023[^\n]\n", &Entry.Key, &DependencyCount, Path) == 3)
+        {
+            Entry.AssetPath = Path;
+            Entry.Dependencies.clear();
+
+            for (u32 DependencyIndex = 0; DependencyIndex < DependencyCount; ++DependencyIndex)
+            {
+                asset_build_dependency Dependency = {};
+
+                if (fscanf(CacheFile, "dependency %llu %llu %llx %1023[^\n]\n", &Dependency.FileSize, &Dependency.WriteTime, &Dependency.ContentHash, Path) != 4)
+                {
+                    break;
+                }
+
+                Dependency.FilePath = Path;
+                Entry.Dependencies.push_back(Dependency);
+            }
+
+            if (Entry.Dependencies.size() == DependencyCount)
+            {
+                Cache->Entries[Entry.AssetPath] = Entry;
+            }
+        }
+    }
+
+    fclose(CacheFile);
+}
+
+dummy_internal void
+SaveAssetBuildCache(asset_build_cache *Cache, const char *CachePath)
+{
+    FILE *CacheFile = fopen(CachePath, "wb");
+
+    if (!CacheFile)
+    {
+        errno_t Error;
+        _get_errno(&Error);
+        Assert(!"Panic");
+    }
+
+    fprintf(CacheFile, "version %u\n", ASSET_BUILD_CACHE_VERSION);
+
+    for (auto &Pair : Cache->Entries)
+    {
+        asset_build_entry *Entry = &Pair.second;
+
+        fprintf(CacheFile, "asset %llx %u %s\n", Entry->Key, (u32)Entry->Dependencies.size(), Entry->AssetPath.c_str());
+
+        for (asset_build_dependency &Dependency : Entry->Dependencies)
+        {
+            fprintf(CacheFile, "dependency %llu %llu %llx %s\n", Dependency.FileSize, Dependency.WriteTime, Dependency.ContentHash, Dependency.FilePath.c_str());
+        }
+    }
+
+    fclose(CacheFile);
+}
+
+/*
+    Fills in the dependency hashes and the key of the entry.
+    Returns true if the asset file is up to date: it exists and was built from the same key.
+*/
+dummy_internal bool32
+CheckAssetBuildCache(asset_build_cache *Cache, asset_build_entry *Entry, const char *Options)
+{
+    asset_build_entry *CachedEntry = 0;
+
+    auto CachedEntryIt = Cache->Entries.find(Entry->AssetPath);
+
+    if (CachedEntryIt != Cache->Entries.end())
+    {
+        CachedEntry = &CachedEntryIt->second;
+    }
+
+    bool32 SameDependencyCount = CachedEntry && CachedEntry->Dependencies.size() == Entry->Dependencies.size();
+
+    u64 Key = HashBytes(Options, StringLength(Options));
+    u32 Versions[] = { ASSETS_BUILDER_VERSION, MODEL_ASSET_VERSION, TEXTURE_ASSET_VERSION };
+    Key = HashBytes(Versions, sizeof(Versions), Key);
+
+    for (u32 DependencyIndex = 0; DependencyIndex < Entry->Dependencies.size(); ++DependencyIndex)
+    {
+        asset_build_dependency *Dependency = &Entry->Dependencies[DependencyIndex];
+
+        if (SameDependencyCount && DependencyUnchanged(Dependency, &CachedEntry->Dependencies[DependencyIndex]))
+        {
+            Dependency->ContentHash = CachedEntry->Dependencies[DependencyIndex].ContentHash;
+        }
+        else
+        {
+            Dependency->ContentHash = HashFileContent(Dependency->FilePath.c_str());
+        }
+
+        Key = HashBytes(Dependency->FilePath.c_str(), Dependency->FilePath.size(), Key);
+        Key = HashBytes(&Dependency->ContentHash, sizeof(Dependency->ContentHash), Key);
+    }
+
+    Entry->Key = Key;
+
+    bool32 Result = CachedEntry && CachedEntry->Key == Key && fs::exists(Entry->AssetPath);
+
+    return Result;
+}
+
+/*
+    Runs Func(Index) for every index in [0, Count) on all cores.
+    Each thread takes the next index when it is done with the previous one, so long items don't hold back the rest.
+*/
+template <typename TFunc>
+dummy_internal void
+ParallelFor(u32 Count, TFunc Func)
+{
+    std::atomic<u32> NextIndex = 0;
+
+    auto Worker = [Count, &NextIndex, &Func]()
+    {
+        for (u32 Index = NextIndex++; Index < Count; Index = NextIndex++)
+        {
+            Func(Index);
+        }
+    };
+
+    u32 ThreadCount = std::thread::hardware_concurrency();
+
+    if (ThreadCount == 0)
+    {
+        ThreadCount = 1;
+    }
+
+    if (ThreadCount > Count)
+    {
+        ThreadCount = Count;
+    }
+
+    dynamic_array<std::thread> Threads;
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Threads.push_back(std::thread(Worker));
+    }
+
+    for (std::thread &Thread : Threads)
+    {
+        Thread.join();
+    }
+}
@@ -325,7 +325,7 @@ ProcessFontAsset(const char *FilePath, const char *OutputPath)
     LoadFontAsset(FilePath, &Asset);
     WriteFontAsset(OutputPath, &Asset);
 
-#if 1
+#if VALIDATE_ASSETS
     font_asset TestAsset = {};
     ReadFontAsset(OutputPath, &TestAsset, &Asset);
 #endif
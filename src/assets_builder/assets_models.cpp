@@ -8,6 +8,7 @@
 #include "overdrawoptimizer.cpp"
 #include "vfetchoptimizer.cpp"
 #include "simplifier.cpp"
+#include "clusterizer.cpp"
 
 #include "rapidjson/document.h"
 
@@ -25,6 +26,9 @@ namespace json = rapidjson;
 #define MAX_MATERIAL_PROPERTY_COUNT 16u
 #define TEXTURE_COORDINATES_SET_INDEX 0
 
+#define MESH_CLUSTER_MAX_VERTEX_COUNT 64
+#define MESH_CLUSTER_MAX_TRIANGLE_COUNT 124
+
 #define MAX_WEIGHT_COUNT 4
 #undef AI_CONFIG_PP_LBW_MAX_WEIGHTS
 #define AI_CONFIG_PP_LBW_MAX_WEIGHTS MAX_WEIGHT_COUNT
@@ -134,6 +138,7 @@ ProcessAssimpTextures(
     const aiScene *AssimpScene,
     aiMaterial *AssimpMaterial,
     aiTextureType AssimpTextureType,
+    texture_usage Usage,
     u32 *TextureCount,
     bitmap **Bitmaps
 )
@@ -163,6 +168,8 @@ ProcessAssimpTextures(
                 Bitmap->Channels = TextureChannels;
                 Bitmap->IsHDR = false;
                 Bitmap->Pixels = Pixels;
+
+                CompressMaterialBitmap(Bitmap, Usage);
             }
             else
             {
@@ -230,7 +237,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 DiffuseMapCount = 0;
             bitmap *DiffuseMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_DIFFUSE, &DiffuseMapCount, &DiffuseMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_DIFFUSE, TextureUsage_Color, &DiffuseMapCount, &DiffuseMaps);
             for (u32 DiffuseMapIndex = 0; DiffuseMapIndex < DiffuseMapCount; ++DiffuseMapIndex)
             {
                 bitmap *DiffuseMap = DiffuseMaps + DiffuseMapIndex;
@@ -244,7 +251,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 SpecularMapCount = 0;
             bitmap *SpecularMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_SPECULAR, &SpecularMapCount, &SpecularMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_SPECULAR, TextureUsage_Color, &SpecularMapCount, &SpecularMaps);
             for (u32 SpecularMapIndex = 0; SpecularMapIndex < SpecularMapCount; ++SpecularMapIndex)
             {
                 bitmap *SpecularMap = SpecularMaps + SpecularMapIndex;
@@ -258,7 +265,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 ShininessMapCount = 0;
             bitmap *ShininessMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_SHININESS, &ShininessMapCount, &ShininessMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_SHININESS, TextureUsage_Data, &ShininessMapCount, &ShininessMaps);
             for (u32 ShininessMapIndex = 0; ShininessMapIndex < ShininessMapCount; ++ShininessMapIndex)
             {
                 bitmap *ShininessMap = ShininessMaps + ShininessMapIndex;
@@ -308,7 +315,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 AlbedoMapCount = 0;
             bitmap *AlbedoMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_BASE_COLOR, &AlbedoMapCount, &AlbedoMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_BASE_COLOR, TextureUsage_Color, &AlbedoMapCount, &AlbedoMaps);
             for (u32 AlbedoMapIndex = 0; AlbedoMapIndex < AlbedoMapCount; ++AlbedoMapIndex)
             {
                 bitmap *AlbedoMap = AlbedoMaps + AlbedoMapIndex;
@@ -322,7 +329,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 MetalnessMapCount = 0;
             bitmap *MetalnessMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_METALNESS, &MetalnessMapCount, &MetalnessMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_METALNESS, TextureUsage_Data, &MetalnessMapCount, &MetalnessMaps);
             for (u32 MetalnessMapIndex = 0; MetalnessMapIndex < MetalnessMapCount; ++MetalnessMapIndex)
             {
                 bitmap *MetalnessMap = MetalnessMaps + MetalnessMapIndex;
@@ -336,7 +343,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 RoughnessMapCount = 0;
             bitmap *RoughnessMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_DIFFUSE_ROUGHNESS, &RoughnessMapCount, &RoughnessMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_DIFFUSE_ROUGHNESS, TextureUsage_Data, &RoughnessMapCount, &RoughnessMaps);
             for (u32 RoughnessMapIndex = 0; RoughnessMapIndex < RoughnessMapCount; ++RoughnessMapIndex)
             {
                 bitmap *RoughnessMap = RoughnessMaps + RoughnessMapIndex;
@@ -350,7 +357,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
             u32 AmbientOcclusionMapCount = 0;
             bitmap *AmbientOcclusionMaps = 0;
-            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_AMBIENT_OCCLUSION, &AmbientOcclusionMapCount, &AmbientOcclusionMaps);
+            ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_AMBIENT_OCCLUSION, TextureUsage_Data, &AmbientOcclusionMapCount, &AmbientOcclusionMaps);
             for (u32 AmbientOcclusionMapIndex = 0; AmbientOcclusionMapIndex < AmbientOcclusionMapCount; ++AmbientOcclusionMapIndex)
             {
                 //bitmap *AmbientOcclusionMap = AmbientOcclusionMaps + AmbientOcclusionMapIndex;
@@ -374,7 +381,7 @@ ProcessAssimpMaterial(const aiScene *AssimpScene, aiMaterial *AssimpMaterial, me
 
     u32 NormalsMapCount = 0;
     bitmap *NormalsMaps = 0;
-    ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_NORMALS, &NormalsMapCount, &NormalsMaps);
+    ProcessAssimpTextures(AssimpScene, AssimpMaterial, aiTextureType_NORMALS, TextureUsage_Normal, &NormalsMapCount, &NormalsMaps);
     for (u32 NormalsMapIndex = 0; NormalsMapIndex < NormalsMapCount; ++NormalsMapIndex)
     {
         bitmap *NormalsMap = NormalsMaps + NormalsMapIndex;
@@ -717,42 +724,187 @@ GetMeshVerticesSize(mesh *Mesh)
 {
     u32 Size = 0;
 
-    if (Mesh->Positions)
+    if (Mesh->VertexEncoding == MeshVertexEncoding_Quantized)
     {
-        Size += Mesh->VertexCount * sizeof(vec3);
+        Size = GetQuantizedMeshVerticesSize(Mesh->VertexCount, &Mesh->Quantized);
     }
-
-    if (Mesh->Normals)
+    else
     {
-        Size += Mesh->VertexCount * sizeof(vec3);
-    }
+        if (Mesh->Positions)
+        {
+            Size += Mesh->VertexCount * sizeof(vec3);
+        }
 
-    if (Mesh->Tangents)
-    {
-        Size += Mesh->VertexCount * sizeof(vec3);
-    }
+        if (Mesh->Normals)
+        {
+            Size += Mesh->VertexCount * sizeof(vec3);
+        }
 
-    if (Mesh->Bitangents)
-    {
-        Size += Mesh->VertexCount * sizeof(vec3);
+        if (Mesh->Tangents)
+        {
+            Size += Mesh->VertexCount * sizeof(vec3);
+        }
+
+        if (Mesh->Bitangents)
+        {
+            Size += Mesh->VertexCount * sizeof(vec3);
+        }
+
+        if (Mesh->TextureCoords)
+        {
+            Size += Mesh->VertexCount * sizeof(vec2);
+        }
+
+        if (Mesh->Weights)
+        {
+            Size += Mesh->VertexCount * sizeof(vec4);
+        }
+
+        if (Mesh->JointIndices)
+        {
+            Size += Mesh->VertexCount * sizeof(ivec4);
+        }
     }
 
-    if (Mesh->TextureCoords)
+    return Size;
+}
+
+// Largest difference between the decoded quantized streams and the float streams, angles are in degrees
+struct vertex_quantization_error
+{
+    f32 Position;
+    f32 Normal;
+    f32 Tangent;
+    // Relative to the coordinate, when it is greater than one
+    f32 TextureCoords;
+    f32 Weight;
+};
+
+dummy_internal vertex_quantization_error
+MeasureQuantizationError(mesh *QuantizedMesh, mesh *SourceMesh)
+{
+    vertex_quantization_error Result = {};
+
+    quantized_mesh_vertices *Quantized = &QuantizedMesh->Quantized;
+
+    Assert(QuantizedMesh->VertexCount == SourceMesh->VertexCount);
+
+    for (u32 VertexIndex = 0; VertexIndex < SourceMesh->VertexCount; ++VertexIndex)
     {
-        Size += Mesh->VertexCount * sizeof(vec2);
+        if (SourceMesh->Positions)
+        {
+            vec3 Position = GetMeshVertexPosition(QuantizedMesh, VertexIndex);
+            Result.Position = Max(Result.Position, Magnitude(Position - SourceMesh->Positions[VertexIndex]));
+        }
+
+        if (SourceMesh->Normals && Magnitude(SourceMesh->Normals[VertexIndex]) > 0.f)
+        {
+            vec3 Normal = UnpackOctahedral(Quantized->Normals[VertexIndex]);
+            f32 Angle = DEGREES(Acos(Clamp(Dot(Normal, Normalize(SourceMesh->Normals[VertexIndex])), -1.f, 1.f)));
+
+            Result.Normal = Max(Result.Normal, Angle);
+        }
+
+        if (SourceMesh->Tangents && Magnitude(SourceMesh->Tangents[VertexIndex]) > 0.f)
+        {
+            f32 BitangentSign;
+            vec3 Tangent = UnpackTangent(Quantized->Tangents[VertexIndex], &BitangentSign);
+            f32 Angle = DEGREES(Acos(Clamp(Dot(Tangent, Normalize(SourceMesh->Tangents[VertexIndex])), -1.f, 1.f)));
+
+            Result.Tangent = Max(Result.Tangent, Angle);
+        }
+
+        if (SourceMesh->TextureCoords)
+        {
+            vec2 Source = SourceMesh->TextureCoords[VertexIndex];
+            u32 Packed = Quantized->TextureCoords[VertexIndex];
+
+            f32 ErrorX = Abs(UnpackHalf((u16)(Packed & 0xFFFF)) - Source.x) / Max(Abs(Source.x), 1.f);
+            f32 ErrorY = Abs(UnpackHalf((u16)(Packed >> 16)) - Source.y) / Max(Abs(Source.y), 1.f);
+
+            Result.TextureCoords = Max(Result.TextureCoords, Max(ErrorX, ErrorY));
+        }
+
+        if (SourceMesh->Weights)
+        {
+            vec4 Weights = UnpackUnorm4x8(Quantized->Weights[VertexIndex]);
+
+            for (u32 WeightIndex = 0; WeightIndex < 4; ++WeightIndex)
+            {
+                f32 Error = Abs(Weights.Elements[WeightIndex] - SourceMesh->Weights[VertexIndex].Elements[WeightIndex]);
+                Result.Weight = Max(Result.Weight, Error);
+            }
+        }
+
+        if (SourceMesh->JointIndices)
+        {
+            u32 Packed = Quantized->JointIndices[VertexIndex];
+
+            for (u32 Index = 0; Index < 4; ++Index)
+            {
+                Assert((i32)((Packed >> (Index * 8)) & 0xFF) == SourceMesh->JointIndices[VertexIndex].Elements[Index]);
+            }
+        }
     }
 
-    if (Mesh->Weights)
+    return Result;
+}
+
+// Float streams are kept, so the source can be compared with the asset file after it is written
+dummy_internal void
+QuantizeModelAsset(model_asset *Asset, const char *FilePath)
+{
+    u32 TotalVertexCount = 0;
+    u64 TotalFloatSize = 0;
+    u64 TotalQuantizedSize = 0;
+    f32 MaxBoundsSize = 0.f;
+
+    vertex_quantization_error MaxError = {};
+
+    for (u32 MeshIndex = 0; MeshIndex < Asset->MeshCount; ++MeshIndex)
     {
-        Size += Mesh->VertexCount * sizeof(vec4);
+        mesh *Mesh = Asset->Meshes + MeshIndex;
+        quantized_mesh_vertices *Quantized = &Mesh->Quantized;
+
+        *Quantized = {};
+
+        if (Mesh->Positions) Quantized->Positions = AllocateMemory<quantized_position>(Mesh->VertexCount);
+        if (Mesh->Normals) Quantized->Normals = AllocateMemory<u32>(Mesh->VertexCount);
+        if (Mesh->Tangents) Quantized->Tangents = AllocateMemory<u32>(Mesh->VertexCount);
+        if (Mesh->TextureCoords) Quantized->TextureCoords = AllocateMemory<u32>(Mesh->VertexCount);
+        if (Mesh->Weights) Quantized->Weights = AllocateMemory<u32>(Mesh->VertexCount);
+        if (Mesh->JointIndices) Quantized->JointIndices = AllocateMemory<u32>(Mesh->VertexCount);
+
+        QuantizeMeshVertices(
+            Mesh->VertexCount, Mesh->Positions, Mesh->Normals, Mesh->Tangents, Mesh->Bitangents,
+            Mesh->TextureCoords, Mesh->Weights, Mesh->JointIndices, Quantized
+        );
+
+        TotalFloatSize += GetMeshVerticesSize(Mesh);
+
+        Mesh->VertexEncoding = MeshVertexEncoding_Quantized;
+
+        TotalQuantizedSize += GetMeshVerticesSize(Mesh);
+        TotalVertexCount += Mesh->VertexCount;
+        MaxBoundsSize = Max(MaxBoundsSize, Magnitude(Quantized->PositionScale));
+
+        vertex_quantization_error Error = MeasureQuantizationError(Mesh, Mesh);
+
+        MaxError.Position = Max(MaxError.Position, Error.Position);
+        MaxError.Normal = Max(MaxError.Normal, Error.Normal);
+        MaxError.Tangent = Max(MaxError.Tangent, Error.Tangent);
+        MaxError.TextureCoords = Max(MaxError.TextureCoords, Error.TextureCoords);
+        MaxError.Weight = Max(MaxError.Weight, Error.Weight);
     }
 
-    if (Mesh->JointIndices)
+    if (TotalVertexCount > 0)
     {
-        Size += Mesh->VertexCount * sizeof(ivec4);
+        printf(
+            "%s: %d vertices, %.1f -> %.1f bytes per vertex, max error: position %f (bounds %.2f), normal %.4f deg, tangent %.4f deg, uv %f, weight %f\n",
+            FilePath, TotalVertexCount, (f32)TotalFloatSize / TotalVertexCount, (f32)TotalQuantizedSize / TotalVertexCount,
+            MaxError.Position, MaxBoundsSize, MaxError.Normal, MaxError.Tangent, MaxError.TextureCoords, MaxError.Weight
+        );
     }
-
-    return Size;
 }
 
 dummy_internal obb
@@ -1005,53 +1157,85 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
         Mesh.VertexCount = MeshHeader->VertexCount;
         Mesh.IndexCount = MeshHeader->IndexCount;
 
-        u32 VerticesOffset = 0;
+        Mesh.VertexEncoding = MeshHeader->VertexEncoding;
 
-        if (MeshHeader->HasPositions)
+        if (Mesh.VertexEncoding == MeshVertexEncoding_Quantized)
         {
-            Mesh.Positions = (vec3 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
+            Mesh.Quantized.PositionOffset = MeshHeader->PositionOffset;
+            Mesh.Quantized.PositionScale = MeshHeader->PositionScale;
         }
 
-        if (MeshHeader->HasNormals)
-        {
-            Mesh.Normals = (vec3 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+        mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+        u32 StreamCount = GetMeshVertexStreams(&Mesh, MeshHeader, Streams);
 
-        if (MeshHeader->HasTangents)
-        {
-            Mesh.Tangents = (vec3 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+        u64 VerticesOffset = MeshHeader->VerticesOffset;
 
-        if (MeshHeader->HasBitangets)
+        if (MeshHeader->StreamCodecVersion)
         {
-            Mesh.Bitangents = (vec3 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+            Assert(MeshHeader->StreamCodecVersion == MESH_STREAM_CODEC_VERSION);
+
+            for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+            {
+                mesh_vertex_stream *Stream = Streams + StreamIndex;
+
+                *Stream->Data = AllocateMemory<u8>(Mesh.VertexCount * Stream->Stride);
+                VerticesOffset += DecodeVertexStream(*Stream->Data, Mesh.VertexCount, Stream->Stride, Buffer + VerticesOffset);
+            }
+
+            Assert(VerticesOffset == MeshHeader->IndicesOffset);
 
-        if (MeshHeader->HasTextureCoords)
+            Mesh.Indices = AllocateMemory<u32>(Mesh.IndexCount);
+            umm IndicesSize = DecodeIndexBuffer(Mesh.Indices, Mesh.IndexCount, Buffer + MeshHeader->IndicesOffset);
+
+            Assert(MeshHeader->IndicesOffset + IndicesSize == MeshHeader->ClustersOffset);
+        }
+        else
         {
-            Mesh.TextureCoords = (vec2 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec2) * MeshHeader->VertexCount;
+            for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+            {
+                mesh_vertex_stream *Stream = Streams + StreamIndex;
+
+                *Stream->Data = Buffer + VerticesOffset;
+                VerticesOffset += Mesh.VertexCount * Stream->Stride;
+            }
+
+            Mesh.Indices = (u32 *) (Buffer + MeshHeader->IndicesOffset);
         }
 
-        if (MeshHeader->HasWeights)
+        mesh *OriginalMesh = OriginalAsset->Meshes + MeshIndex;
+
+        Assert(Mesh.VertexEncoding == OriginalMesh->VertexEncoding);
+
+        // Stored streams and indices are exactly the ones that were written
+        mesh_vertex_stream OriginalStreams[MAX_MESH_VERTEX_STREAM_COUNT];
+        GetMeshVertexStreams(OriginalMesh, MeshHeader, OriginalStreams);
+
+        for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
         {
-            Mesh.Weights = (vec4 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(vec4) * MeshHeader->VertexCount;
+            Assert(memcmp(*Streams[StreamIndex].Data, *OriginalStreams[StreamIndex].Data, Mesh.VertexCount * Streams[StreamIndex].Stride) == 0);
         }
 
-        if (MeshHeader->HasJointIndices)
+        Assert(memcmp(Mesh.Indices, OriginalMesh->Indices, Mesh.IndexCount * sizeof(u32)) == 0);
+
+        if (Mesh.VertexEncoding == MeshVertexEncoding_Quantized)
         {
-            Mesh.JointIndices = (ivec4 *) (Buffer + MeshHeader->VerticesOffset + VerticesOffset);
-            VerticesOffset += sizeof(ivec4) * MeshHeader->VertexCount;
+            quantized_mesh_vertices *Quantized = &Mesh.Quantized;
+
+            // Decoded streams have to match the source within the quantization error
+            vertex_quantization_error Error = MeasureQuantizationError(&Mesh, OriginalMesh);
+
+            Assert(Error.Position <= Magnitude(Quantized->PositionScale) / 65535.f + EPSILON);
+            Assert(Error.Normal < 0.05f);
+            Assert(Error.Tangent < 0.1f);
+            Assert(Error.TextureCoords <= 1.f / 1024.f);
+            Assert(Error.Weight <= 3.f / 255.f);
         }
 
-        Mesh.Indices = (u32 *) (Buffer + MeshHeader->IndicesOffset);
+        Mesh.ClusterCount = MeshHeader->ClusterCount;
+        Mesh.Clusters = (mesh_cluster *) (Buffer + MeshHeader->ClustersOffset);
 
-        NextMeshHeaderOffset += sizeof(model_asset_mesh_header) + VerticesOffset + MeshHeader->IndexCount * sizeof(u32);
+        // Clusters are the last part of the mesh
+        NextMeshHeaderOffset = (u32) (MeshHeader->ClustersOffset + MeshHeader->ClusterCount * sizeof(mesh_cluster) - MeshesHeader->MeshesOffset);
     }
 
     // Read materials
@@ -1110,7 +1294,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1128,7 +1312,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1146,7 +1330,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1164,7 +1348,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1182,7 +1366,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1200,7 +1384,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1218,7 +1402,7 @@ ReadModelAsset(const char *FilePath, model_asset *Asset, model_asset *OriginalAs
                     stbi_write_bmp(FileName, MaterialProperty->Bitmap.Width, MaterialProperty->Bitmap.Height, MaterialProperty->Bitmap.Channels, MaterialProperty->Bitmap.Pixels);
 #endif
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -1359,9 +1543,64 @@ WriteAnimationGraph(animation_graph_asset *AnimationGraph, u64 Offset, FILE *Ass
     return TotalPrevNodeSize;
 }
 
+struct encoded_mesh_streams
+{
+    dynamic_array<u8> Vertices;
+    dynamic_array<u8> Indices;
+};
+
 dummy_internal void
+EncodeMeshStreams(mesh *Mesh, model_asset_mesh_header *MeshHeader, encoded_mesh_streams *Result)
+{
+    mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+    u32 StreamCount = GetMeshVertexStreams(Mesh, MeshHeader, Streams);
+
+    umm VerticesSize = 0;
+
+    for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+    {
+        VerticesSize += GetVertexStreamEncodeBound(Mesh->VertexCount, Streams[StreamIndex].Stride);
+    }
+
+    Result->Vertices.resize(VerticesSize);
+
+    VerticesSize = 0;
+
+    for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+    {
+        mesh_vertex_stream *Stream = Streams + StreamIndex;
+        VerticesSize += EncodeVertexStream(Result->Vertices.data() + VerticesSize, *Stream->Data, Mesh->VertexCount, Stream->Stride);
+    }
+
+    Result->Vertices.resize(VerticesSize);
+
+    Result->Indices.resize(GetIndexBufferEncodeBound(Mesh->IndexCount));
+    Result->Indices.resize(EncodeIndexBuffer(Result->Indices.data(), Mesh->Indices, Mesh->IndexCount));
+}
+
+// Memory ParseModelAsset needs to decode the mesh (every stream is 16-byte aligned)
+inline u64
+GetDecodedMeshSize(mesh *Mesh, model_asset_mesh_header *MeshHeader)
+{
+    mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+    u32 StreamCount = GetMeshVertexStreams(Mesh, MeshHeader, Streams);
+
+    u64 Result = Mesh->IndexCount * sizeof(u32) + 16;
+
+    for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+    {
+        Result += Mesh->VertexCount * Streams[StreamIndex].Stride + 16;
+    }
+
+    return Result;
+}
+
+// Returns the memory needed to decode the compressed meshes
+dummy_internal u64
 WriteMeshes(model_asset *Asset, u64 Offset, FILE *AssetFile)
 {
+    u64 DecodedMeshesSize = 0;
+
     model_asset_meshes_header MeshesHeader = {};
     MeshesHeader.MeshCount = Asset->MeshCount;
     MeshesHeader.MeshesOffset = Offset + sizeof(model_asset_meshes_header);
@@ -1377,58 +1616,93 @@ WriteMeshes(model_asset *Asset, u64 Offset, FILE *AssetFile)
         MeshHeader.MaterialIndex = Mesh->MaterialIndex;
         MeshHeader.VertexCount = Mesh->VertexCount;
         MeshHeader.IndexCount = Mesh->IndexCount;
-        MeshHeader.VerticesOffset = MeshesHeader.MeshesOffset + sizeof(model_asset_mesh_header) + TotalPrevMeshSize;
-        MeshHeader.IndicesOffset = MeshHeader.VerticesOffset + GetMeshVerticesSize(Mesh);
-
-        MeshHeader.HasPositions = Mesh->Positions != 0;
-        MeshHeader.HasNormals = Mesh->Normals != 0;
-        MeshHeader.HasTangents = Mesh->Tangents != 0;
-        MeshHeader.HasBitangets = Mesh->Bitangents != 0;
-        MeshHeader.HasTextureCoords = Mesh->TextureCoords != 0;
-        MeshHeader.HasWeights = Mesh->Weights != 0;
-        MeshHeader.HasJointIndices = Mesh->JointIndices != 0;
-
-        TotalPrevMeshSize += sizeof(model_asset_mesh_header) + GetMeshVerticesSize(Mesh) + Mesh->IndexCount * sizeof(u32);
+        MeshHeader.ClusterCount = Mesh->ClusterCount;
 
-        fwrite(&MeshHeader, sizeof(model_asset_mesh_header), 1, AssetFile);
-
-        if (MeshHeader.HasPositions)
+        if (Mesh->LodCount > 0)
         {
-            fwrite(Mesh->Positions, sizeof(vec3), Mesh->VertexCount, AssetFile);
+            MeshHeader.LodCount = Mesh->LodCount;
+            CopyMemory(Mesh->Lods, MeshHeader.Lods, Mesh->LodCount * sizeof(mesh_lod));
         }
-
-        if (MeshHeader.HasNormals)
+        else
         {
-            fwrite(Mesh->Normals, sizeof(vec3), Mesh->VertexCount, AssetFile);
+            // Mesh wasn't optimized, the whole index buffer is the only LOD
+            MeshHeader.LodCount = 1;
+            MeshHeader.Lods[0].IndexOffset = 0;
+            MeshHeader.Lods[0].IndexCount = Mesh->IndexCount;
+            MeshHeader.Lods[0].Error = 0.f;
         }
 
-        if (MeshHeader.HasTangents)
-        {
-            fwrite(Mesh->Tangents, sizeof(vec3), Mesh->VertexCount, AssetFile);
-        }
+        MeshHeader.VertexEncoding = Mesh->VertexEncoding;
 
-        if (MeshHeader.HasBitangets)
+        if (Mesh->VertexEncoding == MeshVertexEncoding_Quantized)
         {
-            fwrite(Mesh->Bitangents, sizeof(vec3), Mesh->VertexCount, AssetFile);
-        }
+            quantized_mesh_vertices *Quantized = &Mesh->Quantized;
 
-        if (MeshHeader.HasTextureCoords)
-        {
-            fwrite(Mesh->TextureCoords, sizeof(vec2), Mesh->VertexCount, AssetFile);
-        }
+            MeshHeader.PositionOffset = Quantized->PositionOffset;
+            MeshHeader.PositionScale = Quantized->PositionScale;
 
-        if (MeshHeader.HasWeights)
+            MeshHeader.HasPositions = Quantized->Positions != 0;
+            MeshHeader.HasNormals = Quantized->Normals != 0;
+            MeshHeader.HasTangents = Quantized->Tangents != 0;
+            MeshHeader.HasBitangets = false;
+            MeshHeader.HasTextureCoords = Quantized->TextureCoords != 0;
+            MeshHeader.HasWeights = Quantized->Weights != 0;
+            MeshHeader.HasJointIndices = Quantized->JointIndices != 0;
+        }
+        else
         {
-            fwrite(Mesh->Weights, sizeof(vec4), Mesh->VertexCount, AssetFile);
+            MeshHeader.HasPositions = Mesh->Positions != 0;
+            MeshHeader.HasNormals = Mesh->Normals != 0;
+            MeshHeader.HasTangents = Mesh->Tangents != 0;
+            MeshHeader.HasBitangets = Mesh->Bitangents != 0;
+            MeshHeader.HasTextureCoords = Mesh->TextureCoords != 0;
+            MeshHeader.HasWeights = Mesh->Weights != 0;
+            MeshHeader.HasJointIndices = Mesh->JointIndices != 0;
         }
 
-        if (MeshHeader.HasJointIndices)
+        u32 VerticesSize = GetMeshVerticesSize(Mesh);
+        u32 IndicesSize = Mesh->IndexCount * sizeof(u32);
+
+#if COMPRESS_MESH_STREAMS
+        encoded_mesh_streams Encoded;
+        EncodeMeshStreams(Mesh, &MeshHeader, &Encoded);
+
+        MeshHeader.StreamCodecVersion = MESH_STREAM_CODEC_VERSION;
+        VerticesSize = (u32)Encoded.Vertices.size();
+        IndicesSize = (u32)Encoded.Indices.size();
+
+        DecodedMeshesSize += GetDecodedMeshSize(Mesh, &MeshHeader);
+#endif
+
+        MeshHeader.VerticesOffset = MeshesHeader.MeshesOffset + sizeof(model_asset_mesh_header) + TotalPrevMeshSize;
+        MeshHeader.IndicesOffset = MeshHeader.VerticesOffset + VerticesSize;
+        MeshHeader.ClustersOffset = MeshHeader.IndicesOffset + IndicesSize;
+
+        TotalPrevMeshSize += 
+            sizeof(model_asset_mesh_header) + VerticesSize + 
+            IndicesSize + Mesh->ClusterCount * sizeof(mesh_cluster);
+
+        fwrite(&MeshHeader, sizeof(model_asset_mesh_header), 1, AssetFile);
+
+#if COMPRESS_MESH_STREAMS
+        fwrite(Encoded.Vertices.data(), 1, Encoded.Vertices.size(), AssetFile);
+        fwrite(Encoded.Indices.data(), 1, Encoded.Indices.size(), AssetFile);
+#else
+        mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+        u32 StreamCount = GetMeshVertexStreams(Mesh, &MeshHeader, Streams);
+
+        for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
         {
-            fwrite(Mesh->JointIndices, sizeof(ivec4), Mesh->VertexCount, AssetFile);
+            fwrite(*Streams[StreamIndex].Data, Streams[StreamIndex].Stride, Mesh->VertexCount, AssetFile);
         }
 
         fwrite(Mesh->Indices, sizeof(u32), Mesh->IndexCount, AssetFile);
+#endif
+
+        fwrite(Mesh->Clusters, sizeof(mesh_cluster), Mesh->ClusterCount, AssetFile);
     }
+
+    return DecodedMeshesSize;
 }
 
 dummy_internal void
@@ -1500,7 +1774,7 @@ WriteMaterials(model_asset *Asset, u64 Offset, FILE *AssetFile)
 
                     fwrite(&MaterialPropertyHeader, sizeof(model_asset_material_property_header), 1, AssetFile);
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    u32 BitmapSize = GetBitmapDataSize(&MaterialProperty->Bitmap);
                     fwrite(MaterialPropertyHeader.Bitmap.Pixels, sizeof(u8), BitmapSize, AssetFile);
 
                     PrevPropertiesSize += sizeof(model_asset_material_property_header) + BitmapSize;
@@ -1596,7 +1870,7 @@ WriteModelAsset(const char *FilePath, model_asset *Asset)
 
     asset_header Header = {};
     Header.MagicValue = 0x451;
-    Header.Version = 1;
+    Header.Version = MODEL_ASSET_VERSION;
     Header.DataOffset = sizeof(asset_header);
     Header.Type = AssetType_Model;
     CopyString("Dummy model asset file", Header.Description);
@@ -1644,7 +1918,7 @@ WriteModelAsset(const char *FilePath, model_asset *Asset)
     CurrentStreamPosition = ftell(AssetFile);
     ModelAssetHeader.MeshesHeaderOffset = CurrentStreamPosition;
 
-    WriteMeshes(Asset, ModelAssetHeader.MeshesHeaderOffset, AssetFile);
+    ModelAssetHeader.DecodedMeshesSize = WriteMeshes(Asset, ModelAssetHeader.MeshesHeaderOffset, AssetFile);
 
     CurrentStreamPosition = ftell(AssetFile);
     ModelAssetHeader.MaterialsHeaderOffset = CurrentStreamPosition;
@@ -2016,22 +2290,147 @@ LoadAnimationClips(const char *DirectoryPath, u32 Flags, model_asset *Asset)
     }
 }
 
+/*
+    Splits the mesh into meshlets and reorders the index buffer so that every meshlet is a contiguous range of it.
+    Bounding spheres and normal cones of the meshlets are used for culling at runtime.
+*/
 dummy_internal void
-OptimizeModelAsset(model_asset *Asset)
+BuildMeshClusters(mesh *Mesh)
 {
-    for (u32 MeshIndex = 0; MeshIndex < Asset->MeshCount; ++MeshIndex)
+    umm MaxMeshletCount = meshopt_buildMeshletsBound(Mesh->IndexCount, MESH_CLUSTER_MAX_VERTEX_COUNT, MESH_CLUSTER_MAX_TRIANGLE_COUNT);
+
+    meshopt_Meshlet *Meshlets = AllocateMemory<meshopt_Meshlet>(MaxMeshletCount);
+    u32 *MeshletVertices = AllocateMemory<u32>(MaxMeshletCount * MESH_CLUSTER_MAX_VERTEX_COUNT);
+    u8 *MeshletTriangles = AllocateMemory<u8>(MaxMeshletCount * MESH_CLUSTER_MAX_TRIANGLE_COUNT * 3);
+
+    f32 ConeWeight = 0.25f;
+
+    u32 MeshletCount = (u32) meshopt_buildMeshlets(
+        Meshlets, MeshletVertices, MeshletTriangles, Mesh->Indices, Mesh->IndexCount,
+        (f32 *) Mesh->Positions, Mesh->VertexCount, sizeof(vec3),
+        MESH_CLUSTER_MAX_VERTEX_COUNT, MESH_CLUSTER_MAX_TRIANGLE_COUNT, ConeWeight
+    );
+
+    Mesh->ClusterCount = MeshletCount;
+    Mesh->Clusters = AllocateMemory<mesh_cluster>(MeshletCount);
+
+    u32 IndexCount = 0;
+
+    for (u32 MeshletIndex = 0; MeshletIndex < MeshletCount; ++MeshletIndex)
     {
-        mesh *Mesh = Asset->Meshes + MeshIndex;
+        meshopt_Meshlet *Meshlet = Meshlets + MeshletIndex;
+        mesh_cluster *Cluster = Mesh->Clusters + MeshletIndex;
+
+        u32 *Vertices = MeshletVertices + Meshlet->vertex_offset;
+        u8 *Triangles = MeshletTriangles + Meshlet->triangle_offset;
+
+        meshopt_Bounds Bounds = meshopt_computeMeshletBounds(
+            Vertices, Triangles, Meshlet->triangle_count, (f32 *) Mesh->Positions, Mesh->VertexCount, sizeof(vec3)
+        );
 
-        f32 Threshold = 0.2f;
-        f32 TargetError = 0.002f;
+        Cluster->Center = vec3(Bounds.center[0], Bounds.center[1], Bounds.center[2]);
+        Cluster->Radius = Bounds.radius;
+        Cluster->ConeApex = vec3(Bounds.cone_apex[0], Bounds.cone_apex[1], Bounds.cone_apex[2]);
+        Cluster->ConeAxis = vec3(Bounds.cone_axis[0], Bounds.cone_axis[1], Bounds.cone_axis[2]);
+        Cluster->ConeCutoff = Bounds.cone_cutoff;
+        Cluster->IndexOffset = IndexCount;
+        Cluster->IndexCount = Meshlet->triangle_count * 3;
+
+        // Meshlet data is already copied out of the index buffer, so it's safe to overwrite it
+        for (u32 Index = 0; Index < Cluster->IndexCount; ++Index)
+        {
+            Mesh->Indices[IndexCount++] = Vertices[Triangles[Index]];
+        }
+    }
+
+    Assert(IndexCount == Mesh->IndexCount);
+
+    free(Meshlets);
+    free(MeshletVertices);
+    free(MeshletTriangles);
+}
+
+/*
+    Simplifies the mesh down to MAX_MESH_LOD_COUNT - 1 coarser levels, halving the index count each time.
+    All levels share the vertex buffer and are stored one after another in the index buffer.
+    Skinned meshes are always drawn at full detail (see SelectModelLod), so they keep the base level only.
+*/
+dummy_internal void
+GenerateMeshLods(mesh *Mesh, bool32 Skinned)
+{
+    u32 *LodIndices[MAX_MESH_LOD_COUNT] = {};
+    LodIndices[0] = Mesh->Indices;
+
+    Mesh->LodCount = 1;
+    Mesh->Lods[0].IndexOffset = 0;
+    Mesh->Lods[0].IndexCount = Mesh->IndexCount;
+    Mesh->Lods[0].Error = 0.f;
+
+    // meshopt reports errors relative to the mesh extents
+    f32 ErrorScale = meshopt_simplifyScale((f32 *) Mesh->Positions, Mesh->VertexCount, sizeof(vec3));
+
+    u32 TotalIndexCount = Mesh->IndexCount;
+    u32 MaxLodCount = Skinned ? 1 : MAX_MESH_LOD_COUNT;
+
+    for (u32 LodIndex = 1; LodIndex < MaxLodCount; ++LodIndex)
+    {
+        mesh_lod *PrevLod = Mesh->Lods + LodIndex - 1;
+
+        f32 Threshold = Power(0.5f, (f32) LodIndex);
+        f32 TargetError = 0.05f;
         u32 TargetIndexCount = (u32) (Mesh->IndexCount * Threshold);
         u32 *TargetIndices = AllocateMemory<u32>(Mesh->IndexCount);
-        
-        u32 NewIndexCount = (u32) meshopt_simplify(TargetIndices, Mesh->Indices, Mesh->IndexCount, (f32 *) Mesh->Positions, Mesh->VertexCount, sizeof(vec3), TargetIndexCount, TargetError);
+        f32 ResultError = 0.f;
 
-        Mesh->IndexCount = NewIndexCount;
-        Mesh->Indices = TargetIndices;
+        // Always simplifying the source mesh, so the errors don't accumulate
+        u32 NewIndexCount = (u32) meshopt_simplify(
+            TargetIndices, Mesh->Indices, Mesh->IndexCount, (f32 *) Mesh->Positions, Mesh->VertexCount, sizeof(vec3),
+            TargetIndexCount, TargetError, 0, &ResultError
+        );
+
+        // Simplifier is stuck (error limit or locked borders), next levels won't be any different
+        if (NewIndexCount == 0 || NewIndexCount > (u32) (PrevLod->IndexCount * 0.85f))
+        {
+            free(TargetIndices);
+            break;
+        }
+
+        meshopt_optimizeVertexCache(TargetIndices, TargetIndices, NewIndexCount, Mesh->VertexCount);
+
+        mesh_lod *Lod = Mesh->Lods + LodIndex;
+        Lod->IndexOffset = TotalIndexCount;
+        Lod->IndexCount = NewIndexCount;
+        Lod->Error = ResultError * ErrorScale;
+
+        LodIndices[LodIndex] = TargetIndices;
+        TotalIndexCount += NewIndexCount;
+        ++Mesh->LodCount;
+    }
+
+    // Base level only, the index buffer stays as it is
+    if (Mesh->LodCount > 1)
+    {
+        u32 *Indices = AllocateMemory<u32>(TotalIndexCount);
+
+        for (u32 LodIndex = 0; LodIndex < Mesh->LodCount; ++LodIndex)
+        {
+            mesh_lod *Lod = Mesh->Lods + LodIndex;
+            CopyMemory(LodIndices[LodIndex], Indices + Lod->IndexOffset, Lod->IndexCount * sizeof(u32));
+
+            free(LodIndices[LodIndex]);
+        }
+
+        Mesh->IndexCount = TotalIndexCount;
+        Mesh->Indices = Indices;
+    }
+}
+
+dummy_internal void
+OptimizeModelAsset(model_asset *Asset)
+{
+    for (u32 MeshIndex = 0; MeshIndex < Asset->MeshCount; ++MeshIndex)
+    {
+        mesh *Mesh = Asset->Meshes + MeshIndex;
 
         meshopt_Stream Streams[7] = {};
 
@@ -2136,7 +2535,93 @@ OptimizeModelAsset(model_asset *Asset)
         }
 
         Mesh->VertexCount = NewVertexCount;
+
+        // Clusters index the most detailed LOD, which stays at the beginning of the index buffer
+        BuildMeshClusters(Mesh);
+        GenerateMeshLods(Mesh, Asset->Skeleton.JointCount > 1);
+    }
+}
+
+#define MESH_STREAM_DECODE_ITERATION_COUNT 8
+
+/*
+    Decodes the compressed meshes of the written asset file a few times and prints the compression ratio and the decode throughput.
+    Runs over the built assets one at a time (--benchmark-meshes), so the throughput is not skewed by the parallel asset builds.
+*/
+dummy_internal void
+BenchmarkMeshStreamDecoding(const char *FilePath)
+{
+    FILE *AssetFile = fopen(FilePath, "rb");
+
+    u32 FileSize = GetFileSize(AssetFile);
+    u8 *Buffer = AllocateMemory<u8>(FileSize);
+
+    fread(Buffer, FileSize, 1, AssetFile);
+    fclose(AssetFile);
+
+    asset_header *Header = (asset_header *) Buffer;
+    model_asset_header *ModelHeader = (model_asset_header *) (Buffer + Header->DataOffset);
+    model_asset_meshes_header *MeshesHeader = (model_asset_meshes_header *) (Buffer + ModelHeader->MeshesHeaderOffset);
+
+    u8 *Decoded = AllocateMemory<u8>(ModelHeader->DecodedMeshesSize);
+
+    u64 EncodedSize = 0;
+    u64 DecodedSize = 0;
+    f64 DecodeTime = 0.0;
+
+    for (u32 Iteration = 0; Iteration < MESH_STREAM_DECODE_ITERATION_COUNT; ++Iteration)
+    {
+        u64 NextMeshHeaderOffset = 0;
+
+        for (u32 MeshIndex = 0; MeshIndex < MeshesHeader->MeshCount; ++MeshIndex)
+        {
+            model_asset_mesh_header *MeshHeader = (model_asset_mesh_header *) (Buffer + MeshesHeader->MeshesOffset + NextMeshHeaderOffset);
+
+            if (MeshHeader->StreamCodecVersion)
+            {
+                mesh Mesh = {};
+                mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+                u32 StreamCount = GetMeshVertexStreams(&Mesh, MeshHeader, Streams);
+
+                auto StartTime = std::chrono::high_resolution_clock::now();
+
+                u8 *At = Decoded;
+                u64 VerticesOffset = MeshHeader->VerticesOffset;
+
+                for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+                {
+                    VerticesOffset += DecodeVertexStream(At, MeshHeader->VertexCount, Streams[StreamIndex].Stride, Buffer + VerticesOffset);
+                    At += MeshHeader->VertexCount * Streams[StreamIndex].Stride;
+                }
+
+                DecodeIndexBuffer((u32 *) At, MeshHeader->IndexCount, Buffer + MeshHeader->IndicesOffset);
+                At += MeshHeader->IndexCount * sizeof(u32);
+
+                auto EndTime = std::chrono::high_resolution_clock::now();
+
+                DecodeTime += std::chrono::duration<f64>(EndTime - StartTime).count();
+                EncodedSize += MeshHeader->ClustersOffset - MeshHeader->VerticesOffset;
+                DecodedSize += At - Decoded;
+            }
+
+            NextMeshHeaderOffset = MeshHeader->ClustersOffset + MeshHeader->ClusterCount * sizeof(mesh_cluster) - MeshesHeader->MeshesOffset;
+        }
     }
+
+    if (EncodedSize > 0)
+    {
+        printf(
+            "%s: meshes %.2f MB -> %.2f MB (%.2fx), decode %.2f GB/s\n",
+            FilePath,
+            (f32)DecodedSize / MESH_STREAM_DECODE_ITERATION_COUNT / (f32)Megabytes(1),
+            (f32)EncodedSize / MESH_STREAM_DECODE_ITERATION_COUNT / (f32)Megabytes(1),
+            (f32)DecodedSize / (f32)EncodedSize,
+            DecodeTime > 0.0 ? (f64)DecodedSize / DecodeTime / (f64)Gigabytes(1) : 0.0
+        );
+    }
+
+    free(Decoded);
+    free(Buffer);
 }
 
 dummy_internal void
@@ -2164,9 +2649,13 @@ ProcessModelAsset(const char *FilePath, const char *AnimationConfigPath, const c
 
     //OptimizeModelAsset(&Asset);
 
+#if QUANTIZE_MESH_VERTICES
+    QuantizeModelAsset(&Asset, FilePath);
+#endif
+
     WriteModelAsset(OutputPath, &Asset);
 
-#if 1
+#if VALIDATE_ASSETS
     model_asset TestAsset = {};
     ReadModelAsset(OutputPath, &TestAsset, &Asset);
 #endif
@@ -2194,9 +2683,13 @@ ProcessModelAsset(const char *FilePath, const char *OutputPath)
 
     OptimizeModelAsset(&Asset);
 
+#if QUANTIZE_MESH_VERTICES
+    QuantizeModelAsset(&Asset, FilePath);
+#endif
+
     WriteModelAsset(OutputPath, &Asset);
 
-#if 1
+#if VALIDATE_ASSETS
     model_asset TestAsset = {};
     ReadModelAsset(OutputPath, &TestAsset, &Asset);
 #endif
@@ -1,6 +1,17 @@
 #include "dummy.h"
 #include "assets.h"
 
+// Picks the compressed format and the filtering of the mips
+enum texture_usage
+{
+    // Stored as sRGB, filtered in linear space
+    TextureUsage_Color,
+    // Metalness, roughness, etc., filtered as is
+    TextureUsage_Data,
+    // Tangent space, only x and y are stored (z is reconstructed in the shaders)
+    TextureUsage_Normal
+};
+
 dummy_internal void
 LoadTextureAsset(const char *FilePath, texture_asset *Asset)
 {
@@ -16,7 +27,277 @@ LoadTextureAsset(const char *FilePath, texture_asset *Asset)
     }
 }
 
+// Color channels are filtered in linear space
+inline f32
+DecodeGamma(u8 Value)
+{
+    f32 Result = Power((f32)Value / 255.f, 2.2f);
+    return Result;
+}
+
+inline u8
+EncodeGamma(f32 Value)
+{
+    u8 Result = (u8)Round(Power(Clamp(Value, 0.f, 1.f), 1.f / 2.2f) * 255.f);
+    return Result;
+}
+
+inline u8 *
+GetTexel(u8 *Pixels, i32 Width, i32 Height, i32 Channels, i32 x, i32 y)
+{
+    // Clamping to the edge for odd sizes and partial blocks
+    x = x < Width ? x : Width - 1;
+    y = y < Height ? y : Height - 1;
+
+    u8 *Result = Pixels + (y * Width + x) * Channels;
+    return Result;
+}
+
+// 2x2 box filter, the color channels of the color textures are averaged in linear space, alpha and data channels as is
+dummy_internal u8 *
+DownsampleMip(u8 *Pixels, i32 Width, i32 Height, i32 Channels, texture_usage Usage)
+{
+    i32 MipWidth = GetBitmapMipDimension(Width, 1);
+    i32 MipHeight = GetBitmapMipDimension(Height, 1);
+
+    u8 *Result = AllocateMemory<u8>(MipWidth * MipHeight * Channels);
+
+    // Gray (and gray with alpha) bitmaps have a single color channel
+    i32 ColorChannelCount = 0;
+
+    if (Usage == TextureUsage_Color)
+    {
+        ColorChannelCount = Channels >= 3 ? 3 : 1;
+    }
+
+    for (i32 y = 0; y < MipHeight; ++y)
+    {
+        for (i32 x = 0; x < MipWidth; ++x)
+        {
+            u8 *Texels[4] =
+            {
+                GetTexel(Pixels, Width, Height, Channels, 2 * x, 2 * y),
+                GetTexel(Pixels, Width, Height, Channels, 2 * x + 1, 2 * y),
+                GetTexel(Pixels, Width, Height, Channels, 2 * x, 2 * y + 1),
+                GetTexel(Pixels, Width, Height, Channels, 2 * x + 1, 2 * y + 1)
+            };
+
+            u8 *Dest = Result + (y * MipWidth + x) * Channels;
+
+            for (i32 Channel = 0; Channel < Channels; ++Channel)
+            {
+                if (Channel < ColorChannelCount)
+                {
+                    f32 Sum = 0.f;
+
+                    for (u32 TexelIndex = 0; TexelIndex < ArrayCount(Texels); ++TexelIndex)
+                    {
+                        Sum += DecodeGamma(Texels[TexelIndex][Channel]);
+                    }
+
+                    Dest[Channel] = EncodeGamma(Sum / 4.f);
+                }
+                else
+                {
+                    u32 Sum = 0;
+
+                    for (u32 TexelIndex = 0; TexelIndex < ArrayCount(Texels); ++TexelIndex)
+                    {
+                        Sum += Texels[TexelIndex][Channel];
+                    }
+
+                    Dest[Channel] = (u8)((Sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    return Result;
+}
+
+// There are no sRGB variants of BC4 and BC5, gray color textures stay linear
+inline bitmap_format
+GetCompressedBitmapFormat(i32 Channels, texture_usage Usage)
+{
+    bitmap_format Result = BitmapFormat_Raw;
+
+    if (Usage == TextureUsage_Normal)
+    {
+        Result = BitmapFormat_BC5;
+    }
+    else
+    {
+        bool32 IsColor = Usage == TextureUsage_Color;
+
+        if (Channels == 1) Result = BitmapFormat_BC4;
+        if (Channels == 2) Result = BitmapFormat_BC5;
+        if (Channels == 3) Result = IsColor ? BitmapFormat_BC1_SRGB : BitmapFormat_BC1;
+        if (Channels == 4) Result = IsColor ? BitmapFormat_BC3_SRGB : BitmapFormat_BC3;
+    }
+
+    Assert(Result != BitmapFormat_Raw);
+
+    return Result;
+}
+
+inline u32
+GetCompressedBlockChannelCount(bitmap_format Format)
+{
+    u32 Result = 4;
+
+    if (Format == BitmapFormat_BC4) Result = 1;
+    if (Format == BitmapFormat_BC5) Result = 2;
+
+    return Result;
+}
+
 dummy_internal void
+CompressBlock(u8 *Pixels, i32 Width, i32 Height, i32 Channels, i32 BlockX, i32 BlockY, bitmap_format Format, u8 *Dest)
+{
+    // stb_dxt wants RGBA for BC1/BC3 and tightly packed channels for BC4/BC5 (the first ones of the bitmap)
+    u8 Block[16 * 4];
+    i32 BlockChannels = GetCompressedBlockChannelCount(Format);
+
+    for (i32 y = 0; y < 4; ++y)
+    {
+        for (i32 x = 0; x < 4; ++x)
+        {
+            u8 *Texel = GetTexel(Pixels, Width, Height, Channels, BlockX * 4 + x, BlockY * 4 + y);
+            u8 *BlockTexel = Block + (y * 4 + x) * BlockChannels;
+
+            for (i32 Channel = 0; Channel < BlockChannels; ++Channel)
+            {
+                BlockTexel[Channel] = Channel < Channels ? Texel[Channel] : 255;
+            }
+        }
+    }
+
+    switch (Format)
+    {
+        case BitmapFormat_BC1:
+        case BitmapFormat_BC1_SRGB:
+        {
+            stb_compress_dxt_block(Dest, Block, 0, STB_DXT_HIGHQUAL);
+            break;
+        }
+        case BitmapFormat_BC3:
+        case BitmapFormat_BC3_SRGB:
+        {
+            stb_compress_dxt_block(Dest, Block, 1, STB_DXT_HIGHQUAL);
+            break;
+        }
+        case BitmapFormat_BC4:
+        {
+            stb_compress_bc4_block(Dest, Block);
+            break;
+        }
+        case BitmapFormat_BC5:
+        {
+            stb_compress_bc5_block(Dest, Block);
+            break;
+        }
+        default:
+        {
+            Assert(!"Invalid compressed format");
+        }
+    }
+}
+
+dummy_internal u8 *
+CompressMip(u8 *Pixels, i32 Width, i32 Height, i32 Channels, bitmap_format Format)
+{
+    u32 BlockSize = GetBitmapBlockSize(Format);
+    i32 BlockCountX = (Width + 3) / 4;
+    i32 BlockCountY = (Height + 3) / 4;
+
+    u8 *Result = AllocateMemory<u8>(BlockCountX * BlockCountY * BlockSize);
+
+    for (i32 BlockY = 0; BlockY < BlockCountY; ++BlockY)
+    {
+        for (i32 BlockX = 0; BlockX < BlockCountX; ++BlockX)
+        {
+            u8 *Dest = Result + (BlockY * BlockCountX + BlockX) * BlockSize;
+            CompressBlock(Pixels, Width, Height, Channels, BlockX, BlockY, Format, Dest);
+        }
+    }
+
+    return Result;
+}
+
+/*
+    Builds the whole mip chain down to 1x1 and compresses every level.
+    HDR bitmaps are left as is: the skybox reads their texels on the GPU to build the environment maps.
+*/
+dummy_internal void
+CompressBitmap(bitmap *Bitmap, texture_usage Usage, u8 **Mips, u32 *MipSizes)
+{
+    Bitmap->Format = GetCompressedBitmapFormat(Bitmap->Channels, Usage);
+    Bitmap->MipCount = 1;
+
+    while ((Bitmap->Width | Bitmap->Height) >> Bitmap->MipCount)
+    {
+        ++Bitmap->MipCount;
+    }
+
+    Assert(Bitmap->MipCount <= MAX_BITMAP_MIP_COUNT);
+
+    u8 *MipPixels = (u8 *)Bitmap->Pixels;
+
+    for (u32 MipIndex = 0; MipIndex < Bitmap->MipCount; ++MipIndex)
+    {
+        i32 MipWidth = GetBitmapMipDimension(Bitmap->Width, MipIndex);
+        i32 MipHeight = GetBitmapMipDimension(Bitmap->Height, MipIndex);
+
+        Mips[MipIndex] = CompressMip(MipPixels, MipWidth, MipHeight, Bitmap->Channels, Bitmap->Format);
+        MipSizes[MipIndex] = GetBitmapMipSize(Bitmap->Format, Bitmap->Width, Bitmap->Height, MipIndex);
+
+        if (MipIndex + 1 < Bitmap->MipCount)
+        {
+            u8 *NextMipPixels = DownsampleMip(MipPixels, MipWidth, MipHeight, Bitmap->Channels, Usage);
+
+            if (MipPixels != Bitmap->Pixels)
+            {
+                free(MipPixels);
+            }
+
+            MipPixels = NextMipPixels;
+        }
+    }
+
+    if (MipPixels != Bitmap->Pixels)
+    {
+        free(MipPixels);
+    }
+}
+
+// Material textures of the models keep the compressed mip chain in Pixels, level after level (see GetBitmapDataSize)
+dummy_internal void
+CompressMaterialBitmap(bitmap *Bitmap, texture_usage Usage)
+{
+    u8 *Mips[MAX_BITMAP_MIP_COUNT] = {};
+    u32 MipSizes[MAX_BITMAP_MIP_COUNT] = {};
+
+    CompressBitmap(Bitmap, Usage, Mips, MipSizes);
+
+    u8 *Pixels = AllocateMemory<u8>(GetBitmapDataSize(Bitmap));
+    u32 MipOffset = 0;
+
+    for (u32 MipIndex = 0; MipIndex < Bitmap->MipCount; ++MipIndex)
+    {
+        CopyMemory(Mips[MipIndex], Pixels + MipOffset, MipSizes[MipIndex]);
+        MipOffset += MipSizes[MipIndex];
+
+        free(Mips[MipIndex]);
+    }
+
+    stbi_image_free(Bitmap->Pixels);
+
+    Bitmap->Pixels = Pixels;
+    Bitmap->Mips = 0;
+}
+
+// Returns the size of the written file
+dummy_internal u64
 WriteTextureAsset(const char *FilePath, texture_asset *Asset)
 {
     FILE *AssetFile = fopen(FilePath, "wb");
@@ -30,7 +311,7 @@ WriteTextureAsset(const char *FilePath, texture_asset *Asset)
 
     asset_header Header = {};
     Header.MagicValue = 0x451;
-    Header.Version = 1;
+    Header.Version = TEXTURE_ASSET_VERSION;
     Header.DataOffset = sizeof(asset_header);
     Header.Type = AssetType_Texture;
     CopyString("Dummy texture asset file", Header.Description);
@@ -47,6 +328,7 @@ WriteTextureAsset(const char *FilePath, texture_asset *Asset)
     TextureAssetHeader.Height = Asset->Bitmap.Height;
     TextureAssetHeader.Channels = Asset->Bitmap.Channels;
     TextureAssetHeader.IsHDR = Asset->Bitmap.IsHDR;
+    TextureAssetHeader.Format = BitmapFormat_Raw;
 
     fwrite(&TextureAssetHeader, sizeof(texture_asset_header), 1, AssetFile);
 
@@ -61,13 +343,35 @@ WriteTextureAsset(const char *FilePath, texture_asset *Asset)
     }
     else
     {
-        fwrite(Asset->Bitmap.Pixels, sizeof(u8), BitmapSize, AssetFile);
+        u8 *Mips[MAX_BITMAP_MIP_COUNT] = {};
+        u32 MipSizes[MAX_BITMAP_MIP_COUNT] = {};
+
+        // Texture assets are the icons drawn into the scene
+        CompressBitmap(&Asset->Bitmap, TextureUsage_Color, Mips, MipSizes);
+
+        TextureAssetHeader.Format = Asset->Bitmap.Format;
+        TextureAssetHeader.MipCount = Asset->Bitmap.MipCount;
+
+        u64 MipOffset = 0;
+
+        for (u32 MipIndex = 0; MipIndex < Asset->Bitmap.MipCount; ++MipIndex)
+        {
+            TextureAssetHeader.MipOffsets[MipIndex] = MipOffset;
+            MipOffset += MipSizes[MipIndex];
+
+            fwrite(Mips[MipIndex], sizeof(u8), MipSizes[MipIndex], AssetFile);
+            free(Mips[MipIndex]);
+        }
     }
 
+    u64 FileSize = ftell(AssetFile);
+
     fseek(AssetFile, (long)Header.DataOffset, SEEK_SET);
     fwrite(&TextureAssetHeader, sizeof(texture_asset_header), 1, AssetFile);
 
     fclose(AssetFile);
+
+    return FileSize;
 }
 
 dummy_internal void
@@ -90,14 +394,19 @@ ReadTextureAsset(const char *FilePath, texture_asset *Asset, texture_asset *Orig
     fclose(AssetFile);
 }
 
+// Returns the size of the asset file and the size the raw pixels would take (without mips)
 dummy_internal void
-ProcessTextureAsset(const char *FilePath, const char *OutputPath)
+ProcessTextureAsset(const char *FilePath, const char *OutputPath, u64 *AssetSize, u64 *RawSize)
 {
-    texture_asset Asset;
+    texture_asset Asset = {};
     LoadTextureAsset(FilePath, &Asset);
-    WriteTextureAsset(OutputPath, &Asset);
 
-#if 1
+    *RawSize = (u64)Asset.Bitmap.Width * Asset.Bitmap.Height * Asset.Bitmap.Channels * (Asset.Bitmap.IsHDR ? sizeof(f32) : sizeof(u8));
+    *AssetSize = WriteTextureAsset(OutputPath, &Asset);
+
+    stbi_image_free(Asset.Bitmap.Pixels);
+
+#if VALIDATE_ASSETS
     texture_asset TestAsset = {};
     ReadTextureAsset(OutputPath, &TestAsset, &Asset);
 #endif
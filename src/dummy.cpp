@@ -13,7 +13,10 @@
 #include "dummy_animator.cpp"
 #include "dummy_process.cpp"
 #include "dummy_visibility.cpp"
+#include "dummy_lighting.cpp"
+#include "dummy_occlusion.cpp"
 #include "dummy_save.cpp"
+#include "dummy_microbench.cpp"
 
 inline vec3
 NormalizeRGB(vec3 RGB)
@@ -35,6 +38,7 @@ DefaultMaterialOptions()
     material_options Result = {};
     Result.Wireframe = false;
     Result.CastShadow = true;
+    Result.ShadowOnly = false;
 
     return Result;
 }
@@ -97,8 +101,20 @@ CreateMaterial(mesh_material *MeshMaterial, material_options Options = DefaultMa
     return Result;
 }
 
+inline mesh_lod
+GetMeshLod(mesh *Mesh, u32 LodIndex)
+{
+    // Meshes of the model can have less LODs than the model itself
+    Assert(Mesh->LodCount > 0);
+
+    u32 Index = LodIndex < Mesh->LodCount ? LodIndex : Mesh->LodCount - 1;
+    mesh_lod Result = Mesh->Lods[Index];
+
+    return Result;
+}
+
 inline void
-DrawModel(render_commands *RenderCommands, model *Model, transform Transform, vec3 Color)
+DrawModel(render_commands *RenderCommands, model *Model, u32 LodIndex, transform Transform, vec3 Color, mesh_cluster_ranges *ClusterRanges = 0, material_options Options = DefaultMaterialOptions())
 {
     for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
     {
@@ -107,16 +123,30 @@ DrawModel(render_commands *RenderCommands, model *Model, transform Transform, ve
         if (Mesh->Visible)
         {
             mesh_material *MeshMaterial = Model->Materials + Mesh->MaterialIndex;
-            material Material = CreateMaterial(MeshMaterial);
+            material Material = CreateMaterial(MeshMaterial, Options);
             Material.Color = vec4(Color, 1.f);
 
-            DrawMesh(RenderCommands, Mesh->MeshId, Transform, Material);
+            mesh_lod Lod = GetMeshLod(Mesh, LodIndex);
+
+            if (ClusterRanges && ClusterRanges[MeshIndex].IndexOffsets)
+            {
+                mesh_cluster_ranges *Ranges = ClusterRanges + MeshIndex;
+
+                DrawMeshClusters(
+                    RenderCommands, Mesh->MeshId, Lod.IndexOffset, Lod.IndexCount,
+                    Ranges->RangeCount, Ranges->IndexOffsets, Ranges->IndexCounts, Transform, Material
+                );
+            }
+            else
+            {
+                DrawMesh(RenderCommands, Mesh->MeshId, Lod.IndexOffset, Lod.IndexCount, Transform, Material);
+            }
         }
     }
 }
 
 inline void
-DrawModelInstanced(render_commands *RenderCommands, model *Model, u32 InstanceCount, mesh_instance *Instances)
+DrawModelInstanced(render_commands *RenderCommands, model *Model, u32 LodIndex, u32 InstanceBufferId, u32 InstanceCount, u32 *InstanceIndices, material_options Options = DefaultMaterialOptions())
 {
     for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
     {
@@ -125,15 +155,17 @@ DrawModelInstanced(render_commands *RenderCommands, model *Model, u32 InstanceCo
         if (Mesh->Visible)
         {
             mesh_material *MeshMaterial = Model->Materials + Mesh->MaterialIndex;
-            material Material = CreateMaterial(MeshMaterial);
+            material Material = CreateMaterial(MeshMaterial, Options);
 
-            DrawMeshInstanced(RenderCommands, Mesh->MeshId, InstanceCount, Instances, Material);
+            mesh_lod Lod = GetMeshLod(Mesh, LodIndex);
+
+            DrawMeshInstanced(RenderCommands, Mesh->MeshId, Lod.IndexOffset, Lod.IndexCount, InstanceBufferId, InstanceCount, InstanceIndices, Material);
         }
     }
 }
 
 inline void
-DrawSkinnedModel(render_commands *RenderCommands, model *Model, skeleton_pose *Pose, skinning_data *Skinning)
+DrawSkinnedModel(render_commands *RenderCommands, model *Model, skeleton_pose *Pose, skinning_data *Skinning, material_options Options = DefaultMaterialOptions())
 {
     Assert(Model->Skeleton);
 
@@ -144,10 +176,13 @@ DrawSkinnedModel(render_commands *RenderCommands, model *Model, skeleton_pose *P
         if (Mesh->Visible)
         {
             mesh_material *MeshMaterial = Model->Materials + Mesh->MaterialIndex;
-            material Material = CreateMaterial(MeshMaterial);
+            material Material = CreateMaterial(MeshMaterial, Options);
+
+            // Skinned meshes are always drawn at full detail
+            mesh_lod Lod = GetMeshLod(Mesh, 0);
 
             DrawSkinnedMesh(
-                RenderCommands, Mesh->MeshId, Material,
+                RenderCommands, Mesh->MeshId, Lod.IndexOffset, Lod.IndexCount, Material,
                 Model->SkinningBufferId, Skinning->SkinningMatrixCount, Skinning->SkinningMatrices
             );
         }
@@ -155,7 +190,7 @@ DrawSkinnedModel(render_commands *RenderCommands, model *Model, skeleton_pose *P
 }
 
 inline void
-DrawSkinnedModelInstanced(render_commands *RenderCommands, model *Model, skinning_data *Skinning, u32 InstanceCount, skinned_mesh_instance *Instances)
+DrawSkinnedModelInstanced(render_commands *RenderCommands, model *Model, skinning_data *Skinning, u32 InstanceCount, skinned_mesh_instance *Instances, material_options Options = DefaultMaterialOptions())
 {
     Assert(Model->Skeleton);
 
@@ -166,20 +201,15 @@ DrawSkinnedModelInstanced(render_commands *RenderCommands, model *Model, skinnin
         if (Mesh->Visible)
         {
             mesh_material *MeshMaterial = Model->Materials + Mesh->MaterialIndex;
-            material Material = CreateMaterial(MeshMaterial);
+            material Material = CreateMaterial(MeshMaterial, Options);
 
-            DrawSkinnedMeshInstanced(RenderCommands, Mesh->MeshId, Material, Model->SkinningBufferId, InstanceCount, Instances);
+            mesh_lod Lod = GetMeshLod(Mesh, 0);
+
+            DrawSkinnedMeshInstanced(RenderCommands, Mesh->MeshId, Lod.IndexOffset, Lod.IndexCount, Material, Model->SkinningBufferId, InstanceCount, Instances);
         }
     }
 }
 
-inline u32
-GenerateEntityId(game_state *State)
-{
-    u32 Result = State->NextFreeEntityId++;
-    return Result;
-}
-
 inline u32
 GenerateMeshId(game_state *State)
 {
@@ -201,6 +231,13 @@ GenerateSkinningBufferId(game_state *State)
     return Result;
 }
 
+inline u32
+GenerateInstanceBufferId(game_state *State)
+{
+    u32 Result = State->NextFreeInstanceBufferId++;
+    return Result;
+}
+
 inline u32
 GenerateGameProcessId(game_state *State)
 {
@@ -222,11 +259,157 @@ HasJoints(skeleton *Skeleton)
     return Result;
 }
 
+inline bool32
+IsModelResident(model *Model)
+{
+    bool32 Result = Model->Residency.State == AssetResidency_Resident;
+    return Result;
+}
+
+inline bool32
+IsOccluder(game_entity *Entity)
+{
+    bool32 Result = false;
+
+    if (!Entity->Destroyed && Entity->Visible && Entity->Model && IsModelResident(Entity->Model) && !HasJoints(Entity->Model->Skeleton))
+    {
+        aabb Bounds = GetEntityBounds(Entity);
+        vec3 Size = Bounds.HalfExtent * 2.f;
+
+        f32 LargestFaceArea = Max(Size.x * Size.y, Max(Size.y * Size.z, Size.x * Size.z));
+
+        Result = LargestFaceArea >= MIN_OCCLUDER_AREA;
+    }
+
+    return Result;
+}
+
+// Occluders are rasterized from the coarsest LOD
+inline u32
+GetOccluderTriangleCount(model *Model)
+{
+    u32 Result = 0;
+
+    for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
+    {
+        mesh *Mesh = Model->Meshes + MeshIndex;
+        mesh_lod Lod = GetMeshLod(Mesh, Model->LodCount - 1);
+
+        Result += Lod.IndexCount / 3;
+    }
+
+    return Result;
+}
+
+inline void
+AddOccluderModel(occlusion_buffer *Buffer, model *Model, transform ModelTransform)
+{
+    mat4 ModelToCamera = Buffer->WorldToCamera * Transform(ModelTransform);
+
+    for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
+    {
+        mesh *Mesh = Model->Meshes + MeshIndex;
+        mesh_lod Lod = GetMeshLod(Mesh, Model->LodCount - 1);
+
+        AddOccluderMesh(Buffer, Mesh, Lod, ModelToCamera);
+    }
+}
+
+inline bool32
+ShouldCullMeshClusters(game_entity *Entity, mesh *Mesh)
+{
+    // Clusters are built for the most detailed LOD only
+    bool32 Result = Entity->LodIndex == 0 && Mesh->Visible && Mesh->ClusterCount >= MIN_CULLED_MESH_CLUSTER_COUNT;
+    return Result;
+}
+
+inline u32
+GetClusterCulledMeshCount(game_entity *Entity)
+{
+    u32 Result = 0;
+
+    for (u32 MeshIndex = 0; MeshIndex < Entity->Model->MeshCount; ++MeshIndex)
+    {
+        mesh *Mesh = Entity->Model->Meshes + MeshIndex;
+
+        if (ShouldCullMeshClusters(Entity, Mesh))
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+// Picks the coarsest LOD which simplification error projects to less than MaxScreenError pixels
+dummy_internal u32
+SelectModelLod(model *Model, game_entity *Entity, aabb Bounds, vec3 CameraPosition, f32 ProjectionScale, f32 MaxScreenError)
+{
+    u32 Result = 0;
+
+    if (!HasJoints(Model->Skeleton))
+    {
+        vec3 Center = Bounds.Center;
+        f32 Radius = Magnitude(Bounds.HalfExtent);
+        f32 Distance = Max(Magnitude(Center - CameraPosition) - Radius, EPSILON);
+
+        vec3 Scale = Entity->Transform.Scale;
+        f32 MaxScale = Max(Scale.x, Max(Scale.y, Scale.z));
+        f32 PixelsPerUnit = ProjectionScale / Distance;
+
+        for (u32 LodIndex = 1; LodIndex < Model->LodCount; ++LodIndex)
+        {
+            f32 ScreenError = Model->LodErrors[LodIndex] * MaxScale * PixelsPerUnit;
+
+            if (ScreenError > MaxScreenError)
+            {
+                break;
+            }
+
+            Result = LodIndex;
+        }
+    }
+
+    return Result;
+}
+
+inline bool32
+IsTextureMaterialProperty(material_property *MaterialProperty)
+{
+    bool32 Result =
+        MaterialProperty->Type == MaterialProperty_Texture_Diffuse ||
+        MaterialProperty->Type == MaterialProperty_Texture_Specular ||
+        MaterialProperty->Type == MaterialProperty_Texture_Shininess ||
+        MaterialProperty->Type == MaterialProperty_Texture_Albedo ||
+        MaterialProperty->Type == MaterialProperty_Texture_Metalness ||
+        MaterialProperty->Type == MaterialProperty_Texture_Roughness ||
+        MaterialProperty->Type == MaterialProperty_Texture_Normal;
+
+    return Result;
+}
+
+// Mesh and texture ids are allocated in consecutive ranges, which are reused when an evicted model is loaded again
 inline void
 InitModel(game_state *State, model_asset *Asset, model *Model, const char *Name, memory_arena *Arena, render_commands *RenderCommands)
 {
+    model_residency Residency = Model->Residency;
+
     *Model = {};
 
+    Model->Residency = Residency;
+    Model->Residency.TextureCount = 0;
+
+    bool32 ReuseIds = Residency.FirstMeshId != 0;
+
+    if (!ReuseIds)
+    {
+        Model->Residency.FirstMeshId = State->NextFreeMeshId;
+        Model->Residency.FirstTextureId = State->NextFreeTextureId;
+    }
+
+    u32 NextMeshId = Model->Residency.FirstMeshId;
+    u32 NextTextureId = Model->Residency.FirstTextureId;
+
     CopyString(Name, Model->Key);
     Model->Bounds = Asset->Bounds;
     Model->BoundsOBB = Asset->BoundsOBB;
@@ -249,12 +432,24 @@ InitModel(game_state *State, model_asset *Asset, model *Model, const char *Name,
     {
         mesh *Mesh = Model->Meshes + MeshIndex;
 
-        Mesh->MeshId = GenerateMeshId(State);
+        Mesh->MeshId = ReuseIds ? NextMeshId++ : GenerateMeshId(State);
         Mesh->Visible = true;
 
+        if (Mesh->LodCount > Model->LodCount)
+        {
+            Model->LodCount = Mesh->LodCount;
+        }
+
+        for (u32 LodIndex = 0; LodIndex < MAX_MESH_LOD_COUNT; ++LodIndex)
+        {
+            mesh_lod Lod = GetMeshLod(Mesh, LodIndex);
+            Model->LodErrors[LodIndex] = Max(Model->LodErrors[LodIndex], Lod.Error);
+        }
+
         AddMesh(
             RenderCommands, Mesh->MeshId, Mesh->VertexCount,
             Mesh->Positions, Mesh->Normals, Mesh->Tangents, Mesh->Bitangents, Mesh->TextureCoords, Mesh->Weights, Mesh->JointIndices,
+            Mesh->VertexEncoding == MeshVertexEncoding_Quantized ? &Mesh->Quantized : 0,
             Mesh->IndexCount, Mesh->Indices
         );
 
@@ -264,23 +459,32 @@ InitModel(game_state *State, model_asset *Asset, model *Model, const char *Name,
         {
             material_property *MaterialProperty = MeshMaterial->Properties + MaterialPropertyIndex;
 
-            if (
-                MaterialProperty->Type == MaterialProperty_Texture_Diffuse ||
-                MaterialProperty->Type == MaterialProperty_Texture_Specular ||
-                MaterialProperty->Type == MaterialProperty_Texture_Shininess ||
-                MaterialProperty->Type == MaterialProperty_Texture_Albedo ||
-                MaterialProperty->Type == MaterialProperty_Texture_Metalness ||
-                MaterialProperty->Type == MaterialProperty_Texture_Roughness ||
-                MaterialProperty->Type == MaterialProperty_Texture_Normal
-                )
-            {
-                MaterialProperty->TextureId = GenerateTextureId(State);
+            if (IsTextureMaterialProperty(MaterialProperty))
+            {
+                MaterialProperty->TextureId = ReuseIds ? NextTextureId++ : GenerateTextureId(State);
                 AddTexture(RenderCommands, MaterialProperty->TextureId, &MaterialProperty->Bitmap);
+
+                ++Model->Residency.TextureCount;
             }
         }
     }
 }
 
+// Frees the GPU resources of the model, its ids stay reserved
+dummy_internal void
+RemoveModelFromRenderer(model *Model, render_commands *RenderCommands)
+{
+    for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
+    {
+        RemoveMesh(RenderCommands, Model->Residency.FirstMeshId + MeshIndex);
+    }
+
+    for (u32 TextureIndex = 0; TextureIndex < Model->Residency.TextureCount; ++TextureIndex)
+    {
+        RemoveTexture(RenderCommands, Model->Residency.FirstTextureId + TextureIndex);
+    }
+}
+
 dummy_internal void
 InitFont(game_state *State, font_asset *Asset, font *Font, const char *Name, render_commands *RenderCommands)
 {
@@ -301,19 +505,16 @@ InitFont(game_state *State, font_asset *Asset, font *Font, const char *Name, ren
 }
 
 dummy_internal void
-InitTexture(game_state *State, texture_asset *Asset, texture *Texture, const char *Name, render_commands *RenderCommands)
+InitTexture(texture_asset *Asset, texture *Texture, render_commands *RenderCommands)
 {
-    CopyString(Name, Texture->Key);
     Texture->Bitmap = Asset->Bitmap;
-    Texture->TextureId = GenerateTextureId(State);
 
     AddTexture(RenderCommands, Texture->TextureId, &Texture->Bitmap);
 }
 
 dummy_internal void
-InitAudioClip(audio_clip_asset *Asset, audio_clip *AudioClip, const char *Name)
+InitAudioClip(audio_clip_asset *Asset, audio_clip *AudioClip)
 {
-    CopyString(Name, AudioClip->Key);
     AudioClip->Format = Asset->Format;
     AudioClip->Channels = Asset->Channels;
     AudioClip->SamplesPerSecond = Asset->SamplesPerSecond;
@@ -323,7 +524,7 @@ InitAudioClip(audio_clip_asset *Asset, audio_clip *AudioClip, const char *Name)
 }
 
 inline void
-InitSkinningBuffer(game_state *State, skinning_data *Skinning, model *Model, memory_arena *Arena, render_commands *RenderCommands)
+InitSkinningBuffer(skinning_data *Skinning, model *Model, memory_arena *Arena)
 {
     *Skinning = {};
 
@@ -346,8 +547,6 @@ InitSkinningBuffer(game_state *State, skinning_data *Skinning, model *Model, mem
 
     Skinning->SkinningMatrixCount = Model->Skeleton->JointCount;
     Skinning->SkinningMatrices = PushArray(Arena, SkinningMatrixCount, mat4, Align(16));
-
-    AddSkinningBuffer(RenderCommands, Model->SkinningBufferId, Skinning->SkinningMatrixCount);
 }
 
 inline ray
@@ -383,48 +582,299 @@ GetRenderBatch(game_state *State, char *Name)
     return Result;
 }
 
+dummy_internal mesh_instance_buffer *
+GetInstanceBuffer(game_state *State, model *Model)
+{
+    mesh_instance_buffer *Result = HashTableLookup(&State->InstanceBuffers, Model->Key);
+
+    if (IsSlotEmpty(Result->Key))
+    {
+        CopyString(Model->Key, Result->Key);
+        Result->InstanceBufferId = GenerateInstanceBufferId(State);
+        Result->InstanceCount = 0;
+        Result->MaxInstanceCount = 0;
+        Result->Instances = 0;
+        Result->FreeInstanceCount = 0;
+        Result->FreeInstanceIndices = 0;
+        Result->DirtyStartIndex = 0;
+        Result->DirtyEndIndex = 0;
+    }
+
+    return Result;
+}
+
+dummy_internal void
+ResetInstanceBuffers(game_state *State)
+{
+    // Instance memory is kept, entities are going to take new slots
+    for (u32 InstanceBufferIndex = 0; InstanceBufferIndex < State->InstanceBuffers.Count; ++InstanceBufferIndex)
+    {
+        mesh_instance_buffer *InstanceBuffer = State->InstanceBuffers.Values + InstanceBufferIndex;
+
+        InstanceBuffer->InstanceCount = 0;
+        InstanceBuffer->FreeInstanceCount = 0;
+        InstanceBuffer->DirtyStartIndex = 0;
+        InstanceBuffer->DirtyEndIndex = 0;
+    }
+}
+
+// Slot is reused by the next entity with the same model, until then it's not drawn (batches draw the visible entities only)
+inline void
+ReleaseEntityInstance(game_entity *Entity)
+{
+    mesh_instance_buffer *InstanceBuffer = Entity->InstanceBuffer;
+
+    if (InstanceBuffer)
+    {
+        Assert(InstanceBuffer->FreeInstanceCount < InstanceBuffer->MaxInstanceCount);
+
+        InstanceBuffer->FreeInstanceIndices[InstanceBuffer->FreeInstanceCount++] = Entity->InstanceIndex;
+
+        Entity->InstanceBuffer = 0;
+        Entity->InstanceIndex = 0;
+    }
+}
+
+inline void
+MarkInstanceDirty(mesh_instance_buffer *InstanceBuffer, u32 InstanceIndex)
+{
+    if (InstanceBuffer->DirtyStartIndex == InstanceBuffer->DirtyEndIndex)
+    {
+        InstanceBuffer->DirtyStartIndex = InstanceIndex;
+        InstanceBuffer->DirtyEndIndex = InstanceIndex + 1;
+    }
+    else
+    {
+        if (InstanceIndex < InstanceBuffer->DirtyStartIndex)
+        {
+            InstanceBuffer->DirtyStartIndex = InstanceIndex;
+        }
+
+        if (InstanceIndex + 1 > InstanceBuffer->DirtyEndIndex)
+        {
+            InstanceBuffer->DirtyEndIndex = InstanceIndex + 1;
+        }
+    }
+}
+
+dummy_internal void
+UpdateEntityInstance(game_state *State, game_entity *Entity, render_commands *RenderCommands)
+{
+    Assert(Entity->Model && !Entity->Skinning);
+
+    mesh_instance_buffer *InstanceBuffer = GetInstanceBuffer(State, Entity->Model);
+
+    bool32 NewInstance = false;
+
+    if (Entity->InstanceBuffer != InstanceBuffer)
+    {
+        // Model of the entity was changed
+        ReleaseEntityInstance(Entity);
+
+        if (InstanceBuffer->FreeInstanceCount == 0 && InstanceBuffer->InstanceCount == InstanceBuffer->MaxInstanceCount)
+        {
+            u32 MaxInstanceCount = InstanceBuffer->MaxInstanceCount > 0 ? InstanceBuffer->MaxInstanceCount * 2 : 64;
+            mesh_instance *Instances = (mesh_instance *) HeapAllocate(&State->InstanceHeap, MaxInstanceCount * sizeof(mesh_instance));
+            u32 *FreeInstanceIndices = (u32 *) HeapAllocate(&State->InstanceHeap, MaxInstanceCount * sizeof(u32));
+
+            Assert(Instances && FreeInstanceIndices);
+
+            if (InstanceBuffer->Instances)
+            {
+                CopyMemory(InstanceBuffer->Instances, Instances, InstanceBuffer->InstanceCount * sizeof(mesh_instance));
+
+                HeapFree(&State->InstanceHeap, InstanceBuffer->Instances);
+                HeapFree(&State->InstanceHeap, InstanceBuffer->FreeInstanceIndices);
+            }
+
+            InstanceBuffer->Instances = Instances;
+            InstanceBuffer->MaxInstanceCount = MaxInstanceCount;
+            // Free list is empty at this point
+            InstanceBuffer->FreeInstanceIndices = FreeInstanceIndices;
+
+            // Renderer reallocates the buffer, so all instances have to be uploaded again
+            AddInstanceBuffer(RenderCommands, InstanceBuffer->InstanceBufferId, InstanceBuffer->MaxInstanceCount);
+
+            InstanceBuffer->DirtyStartIndex = 0;
+            InstanceBuffer->DirtyEndIndex = InstanceBuffer->InstanceCount;
+        }
+
+        Entity->InstanceBuffer = InstanceBuffer;
+
+        if (InstanceBuffer->FreeInstanceCount > 0)
+        {
+            Entity->InstanceIndex = InstanceBuffer->FreeInstanceIndices[--InstanceBuffer->FreeInstanceCount];
+        }
+        else
+        {
+            Entity->InstanceIndex = InstanceBuffer->InstanceCount++;
+        }
+
+        NewInstance = true;
+    }
+
+    mesh_instance *Instance = InstanceBuffer->Instances + Entity->InstanceIndex;
+    mesh_instance NewValue = EncodeMeshInstance(Entity->Transform, Entity->DebugColor);
+
+    // Static entities end up here with the same value every frame and are never re-uploaded
+    if (NewInstance || memcmp(Instance, &NewValue, sizeof(mesh_instance)) != 0)
+    {
+        *Instance = NewValue;
+        MarkInstanceDirty(InstanceBuffer, Entity->InstanceIndex);
+    }
+}
+
+dummy_internal void
+FlushInstanceBuffer(render_commands *RenderCommands, mesh_instance_buffer *InstanceBuffer)
+{
+    if (InstanceBuffer->DirtyStartIndex < InstanceBuffer->DirtyEndIndex)
+    {
+        u32 DirtyInstanceCount = InstanceBuffer->DirtyEndIndex - InstanceBuffer->DirtyStartIndex;
+        mesh_instance *DirtyInstances = InstanceBuffer->Instances + InstanceBuffer->DirtyStartIndex;
+
+        UpdateInstanceBuffer(RenderCommands, InstanceBuffer->InstanceBufferId, InstanceBuffer->DirtyStartIndex, DirtyInstanceCount, DirtyInstances);
+
+        InstanceBuffer->DirtyStartIndex = 0;
+        InstanceBuffer->DirtyEndIndex = 0;
+    }
+}
+
 dummy_internal game_asset *
-GetGameAssets(platform_api *Platform, const wchar *Wildcard, memory_arena *Arena, u32 *AssetCount)
+GetGameAssets(game_assets *Assets, platform_api *Platform, asset_type Type, const wchar *Wildcard, u32 *AssetCount)
 {
-    get_files_result GetFilesResult = Platform->GetFiles((wchar *)Wildcard, Arena);
-    *AssetCount = GetFilesResult.FileCount;
+    memory_arena *Arena = &Assets->Arena;
+    game_asset *GameAssets = 0;
+
+    if (Assets->Pack.Contents)
+    {
+        asset_pack_entry *PackEntries = GetAssetPackEntries(Assets, Type, AssetCount);
+
+        GameAssets = PushArray(Arena, *AssetCount, game_asset);
+
+        for (u32 AssetIndex = 0; AssetIndex < *AssetCount; ++AssetIndex)
+        {
+            asset_pack_entry *PackEntry = PackEntries + AssetIndex;
+            game_asset *GameAsset = GameAssets + AssetIndex;
+
+            CopyString(PackEntry->Name, GameAsset->Name);
+            GameAsset->Size = PackEntry->Size;
+            GameAsset->PackEntry = PackEntry;
+        }
 
-    game_asset *GameAssets = PushArray(Arena, *AssetCount, game_asset);
+        // Single asset rebuilds only update the loose files while the game has the pack mapped
+        get_files_result GetFilesResult = Platform->GetFiles((wchar *)Wildcard, Arena);
 
-    for (u32 AssetIndex = 0; AssetIndex < *AssetCount; ++AssetIndex)
+        for (u32 FileIndex = 0; FileIndex < GetFilesResult.FileCount; ++FileIndex)
+        {
+            platform_file *AssetFile = GetFilesResult.Files + FileIndex;
+
+            if (AssetFile->FileDate > Assets->PackFileDate)
+            {
+                char AssetFileName[256];
+                ConvertToString(AssetFile->FileName, AssetFileName);
+
+                char AssetName[256];
+                RemoveExtension(AssetFileName, AssetName);
+
+                for (u32 AssetIndex = 0; AssetIndex < *AssetCount; ++AssetIndex)
+                {
+                    game_asset *GameAsset = GameAssets + AssetIndex;
+
+                    if (StringEquals(GameAsset->Name, AssetName))
+                    {
+                        FormatString(GameAsset->Path, "assets\\%s", AssetFileName);
+                        GameAsset->Size = AssetFile->FileSize;
+                        GameAsset->PackEntry = 0;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    else
     {
-        platform_file *ModelFile = GetFilesResult.Files + AssetIndex;
-        game_asset *GameAsset = GameAssets + AssetIndex;
+        get_files_result GetFilesResult = Platform->GetFiles((wchar *)Wildcard, Arena);
+        *AssetCount = GetFilesResult.FileCount;
+
+        GameAssets = PushArray(Arena, *AssetCount, game_asset);
 
-        char AssetFileNameName[256];
-        ConvertToString(ModelFile->FileName, AssetFileNameName);
+        for (u32 AssetIndex = 0; AssetIndex < *AssetCount; ++AssetIndex)
+        {
+            platform_file *ModelFile = GetFilesResult.Files + AssetIndex;
+            game_asset *GameAsset = GameAssets + AssetIndex;
+
+            char AssetFileNameName[256];
+            ConvertToString(ModelFile->FileName, AssetFileNameName);
 
-        char AssetName[256];
-        RemoveExtension(AssetFileNameName, AssetName);
+            char AssetName[256];
+            RemoveExtension(AssetFileNameName, AssetName);
 
-        char AssetPath[256];
-        FormatString(AssetPath, "assets\\%s", AssetFileNameName);
+            char AssetPath[256];
+            FormatString(AssetPath, "assets\\%s", AssetFileNameName);
 
-        CopyString(AssetName, GameAsset->Name);
-        CopyString(AssetPath, GameAsset->Path);
+            CopyString(AssetName, GameAsset->Name);
+            CopyString(AssetPath, GameAsset->Path);
+            GameAsset->Size = ModelFile->FileSize;
+        }
     }
 
     return GameAssets;
 }
 
+// Asset data is used in place, either from the mapped pack or from the loose file read into the arena
+dummy_internal u8 *
+GetGameAssetData(game_assets *Assets, platform_api *Platform, game_asset *GameAsset, memory_arena *Arena)
+{
+    u8 *Result = 0;
+
+    if (GameAsset->PackEntry)
+    {
+        Result = GetAssetPackData(Assets, GameAsset->PackEntry);
+    }
+    else
+    {
+        read_file_result AssetFile = Platform->ReadFile(GameAsset->Path, Arena, ReadBinary());
+        Result = (u8 *)AssetFile.Contents;
+    }
+
+    return Result;
+}
+
+/*
+    Only registers the models, their data is streamed in on first use (see UpdateAssetResidency).
+    Bounds are read from the asset header, so the entities can be placed and culled before their models are loaded.
+*/
 dummy_internal void
-InitGameModelAssets(game_state *State, game_assets *Assets, render_commands *RenderCommands)
+InitGameModelAssets(game_state *State, game_assets *Assets, platform_api *Platform)
 {
     InitHashTable(&Assets->Models, 1021, &Assets->Arena);
 
     Assert(Assets->Models.Count > Assets->ModelAssetCount);
 
+    model *Sentinel = &Assets->ResidentModelSentinel;
+    Sentinel->Next = Sentinel->Prev = Sentinel;
+
     for (u32 GameAssetModelIndex = 0; GameAssetModelIndex < Assets->ModelAssetCount; ++GameAssetModelIndex)
     {
         game_asset_model *GameAssetModel = Assets->ModelAssets + GameAssetModelIndex;
+        game_asset *GameAsset = &GameAssetModel->GameAsset;
 
-        model *Model = GetModelAsset(Assets, GameAssetModel->GameAsset.Name);
-        InitModel(State, GameAssetModel->ModelAsset, Model, GameAssetModel->GameAsset.Name, &Assets->Arena, RenderCommands);
+        // Loose files are read whole, but only for the duration of this iteration
+        scoped_memory ScopedMemory(&State->FrameArena);
+
+        u8 *AssetData = GetGameAssetData(Assets, Platform, GameAsset, ScopedMemory.Arena);
+        model_asset_header *ModelHeader = GetModelAssetHeader(AssetData);
+
+        model *Model = GetModelAsset(Assets, GameAsset->Name);
+        *Model = {};
+
+        CopyString(GameAsset->Name, Model->Key);
+        Model->Bounds = ModelHeader->Bounds;
+        Model->BoundsOBB = ModelHeader->BoundsOBB;
+        Model->Residency.State = AssetResidency_Unloaded;
+        Model->Residency.AssetIndex = GameAssetModelIndex;
+
+        GameAssetModel->DecodedMeshesSize = ModelHeader->DecodedMeshesSize;
     }
 }
 
@@ -444,22 +894,33 @@ InitGameFontAssets(game_state *State, game_assets *Assets, render_commands *Rend
     }
 }
 
+// Only registers the textures, their data is streamed in on first use (see UpdateAssetResidency)
 dummy_internal void
-InitGameTextureAssets(game_state *State, game_assets *Assets, render_commands *RenderCommands)
+InitGameTextureAssets(game_state *State, game_assets *Assets)
 {
     InitHashTable(&Assets->Textures, 127, &Assets->Arena);
 
     Assert(Assets->Textures.Count > Assets->TextureAssetCount);
 
+    texture *Sentinel = &Assets->ResidentTextureSentinel;
+    Sentinel->Next = Sentinel->Prev = Sentinel;
+
     for (u32 GameAssetTextureIndex = 0; GameAssetTextureIndex < Assets->TextureAssetCount; ++GameAssetTextureIndex)
     {
         game_asset_texture *GameAssetTexture = Assets->TextureAssets + GameAssetTextureIndex;
 
         texture *Texture = GetTextureAsset(Assets, GameAssetTexture->GameAsset.Name);
-        InitTexture(State, GameAssetTexture->TextureAsset, Texture, GameAssetTexture->GameAsset.Name, RenderCommands);
+        *Texture = {};
+
+        CopyString(GameAssetTexture->GameAsset.Name, Texture->Key);
+        // Streamed in texture is added to the renderer under the same id every time
+        Texture->TextureId = GenerateTextureId(State);
+        Texture->Residency.State = AssetResidency_Unloaded;
+        Texture->Residency.AssetIndex = GameAssetTextureIndex;
     }
 }
 
+// Only registers the audio clips, their samples are streamed in on first play (see UpdateAssetResidency)
 dummy_internal void
 InitGameAudioClipAssets(game_assets *Assets)
 {
@@ -472,28 +933,11 @@ InitGameAudioClipAssets(game_assets *Assets)
         game_asset_audio_clip *GameAssetAudioClip = Assets->AudioClipAssets + GameAssetAudioClipIndex;
 
         audio_clip *AudioClip = GetAudioClipAsset(Assets, GameAssetAudioClip->GameAsset.Name);
-        InitAudioClip(GameAssetAudioClip->AudioAsset, AudioClip, GameAssetAudioClip->GameAsset.Name);
-    }
-}
-
-dummy_internal void
-LoadModelAssets(game_assets *Assets, platform_api *Platform)
-{
-    u32 ModelAssetCount;
-    game_asset *ModelAssets = GetGameAssets(Platform, L"assets\\*.model.asset", &Assets->Arena, &ModelAssetCount);
-
-    Assets->ModelAssetCount = ModelAssetCount;
-    Assets->ModelAssets = PushArray(&Assets->Arena, Assets->ModelAssetCount, game_asset_model);
-
-    for (u32 ModelAssetIndex = 0; ModelAssetIndex < ModelAssetCount; ++ModelAssetIndex)
-    {
-        game_asset GameAsset = ModelAssets[ModelAssetIndex];
-        game_asset_model *GameAssetModel = Assets->ModelAssets + ModelAssetIndex;
-
-        model_asset *LoadedAsset = LoadModelAsset(Platform, GameAsset.Path, &Assets->Arena);
-
-        GameAssetModel->GameAsset = GameAsset;
-        GameAssetModel->ModelAsset = LoadedAsset;
+        *AudioClip = {};
+
+        CopyString(GameAssetAudioClip->GameAsset.Name, AudioClip->Key);
+        AudioClip->Residency.State = AssetResidency_Unloaded;
+        AudioClip->Residency.AssetIndex = GameAssetAudioClipIndex;
     }
 }
 
@@ -501,7 +945,7 @@ dummy_internal void
 LoadFontAssets(game_assets *Assets, platform_api *Platform)
 {
     u32 FontAssetCount;
-    game_asset *FontAssets = GetGameAssets(Platform, L"assets\\*.font.asset", &Assets->Arena, &FontAssetCount);
+    game_asset *FontAssets = GetGameAssets(Assets, Platform, AssetType_Font, L"assets\\*.font.asset", &FontAssetCount);
 
     Assets->FontAssetCount = FontAssetCount;
     Assets->FontAssets = PushArray(&Assets->Arena, Assets->FontAssetCount, game_asset_font);
@@ -512,83 +956,136 @@ LoadFontAssets(game_assets *Assets, platform_api *Platform)
 
         game_asset_font *GameAssetFont = Assets->FontAssets + FontAssetIndex;
 
-        font_asset *LoadedAsset = LoadFontAsset(Platform, GameAsset.Path, &Assets->Arena);
+        font_asset *LoadedAsset = ParseFontAsset(GetGameAssetData(Assets, Platform, &GameAsset, &Assets->Arena), &Assets->Arena);
 
         GameAssetFont->GameAsset = GameAsset;
         GameAssetFont->FontAsset = LoadedAsset;
     }
 }
 
-dummy_internal void
-LoadAudioClipAssets(game_assets *Assets, platform_api *Platform)
+// Streams a texture or an audio clip into its block of the asset allocator
+struct load_game_asset_job
 {
-    u32 AudioClipAssetCount;
-    game_asset *AudioClipAssets = GetGameAssets(Platform, L"assets\\*.audio.asset", &Assets->Arena, &AudioClipAssetCount);
+    game_assets *Assets;
+    platform_api *Platform;
 
-    Assets->AudioClipAssetCount = AudioClipAssetCount;
-    Assets->AudioClipAssets = PushArray(&Assets->Arena, Assets->AudioClipAssetCount, game_asset_audio_clip);
+    asset_type Type;
+    u32 AssetIndex;
+    asset_residency *Residency;
 
-    for (u32 AudioClipAssetIndex = 0; AudioClipAssetIndex < AudioClipAssetCount; ++AudioClipAssetIndex)
-    {
-        game_asset GameAsset = AudioClipAssets[AudioClipAssetIndex];
+    // Rest of the asset block
+    memory_arena Arena;
+};
 
-        game_asset_audio_clip *GameAssetAudioClip = Assets->AudioClipAssets + AudioClipAssetIndex;
+/*
+    Parsed asset structures mirror the headers in the asset file, so a model never takes more than its file size.
+    Loose files are also read into the arena, assets from the pack are used in place.
+*/
+inline umm
+GetLoadGameAssetArenaSize(asset_type Type, game_asset *GameAsset)
+{
+    umm Result = Kilobytes(64);
 
-        audio_clip_asset *LoadedAsset = LoadAudioClipAsset(Platform, GameAsset.Path, &Assets->Arena);
+    if (!GameAsset->PackEntry)
+    {
+        Result += GameAsset->Size;
+    }
 
-        GameAssetAudioClip->GameAsset = GameAsset;
-        GameAssetAudioClip->AudioAsset = LoadedAsset;
+    if (Type == AssetType_Model)
+    {
+        Result += GameAsset->Size;
     }
+
+    return Result;
 }
 
-dummy_internal void
-LoadTextureAssets(game_assets *Assets, platform_api *Platform)
+JOB_ENTRY_POINT(LoadGameAssetJob)
 {
-    u32 TextureAssetCount;
-    game_asset *TextureAssets = GetGameAssets(Platform, L"assets\\*.texture.asset", &Assets->Arena, &TextureAssetCount);
-
-    Assets->TextureAssetCount = TextureAssetCount;
-    Assets->TextureAssets = PushArray(&Assets->Arena, Assets->TextureAssetCount, game_asset_texture);
+    load_game_asset_job *Data = (load_game_asset_job *) Parameters;
+    game_assets *Assets = Data->Assets;
+    platform_api *Platform = Data->Platform;
 
-    for (u32 TextureAssetIndex = 0; TextureAssetIndex < TextureAssetCount; ++TextureAssetIndex)
+    switch (Data->Type)
     {
-        game_asset GameAsset = TextureAssets[TextureAssetIndex];
+        case AssetType_AudioClip:
+        {
+            game_asset_audio_clip *GameAssetAudioClip = Assets->AudioClipAssets + Data->AssetIndex;
 
-        game_asset_texture *GameAssetTexture = Assets->TextureAssets + TextureAssetIndex;
+            u8 *AssetData = GetGameAssetData(Assets, Platform, &GameAssetAudioClip->GameAsset, &Data->Arena);
+            GameAssetAudioClip->AudioAsset = ParseAudioClipAsset(AssetData, &Data->Arena);
+
+            break;
+        }
+        case AssetType_Texture:
+        {
+            game_asset_texture *GameAssetTexture = Assets->TextureAssets + Data->AssetIndex;
 
-        texture_asset *LoadedAsset = LoadTextureAsset(Platform, GameAsset.Path, &Assets->Arena);
+            u8 *AssetData = GetGameAssetData(Assets, Platform, &GameAssetTexture->GameAsset, &Data->Arena);
+            GameAssetTexture->TextureAsset = ParseTextureAsset(AssetData, &Data->Arena);
 
-        GameAssetTexture->GameAsset = GameAsset;
-        GameAssetTexture->TextureAsset = LoadedAsset;
+            break;
+        }
+        default:
+        {
+            Assert(!"Invalid asset type");
+        }
     }
+
+    // Publishes the parsed asset to the main thread (see UpdateAssetResidency)
+    AtomicStoreRelease((u32 volatile *) &Data->Residency->State, AssetResidency_Loaded);
 }
 
+/*
+    Only lists the assets: models, textures and audio clips are streamed in on first use (see UpdateAssetResidency).
+    Asset lists are built up front, so the load jobs only write to their own entries.
+*/
 dummy_internal void
-LoadGameAssets(game_assets *Assets, platform_api *Platform)
+LoadGameAssets(game_assets *Assets, platform_api *Platform, platform_profiler *Profiler)
 {
-    // todo:
     Assets->State = GameAssetsState_Unloaded;
 
-    LoadModelAssets(Assets, Platform);
+    u64 StartTime = Profiler->GetTimestamp();
 
-    LoadAudioClipAssets(Assets, Platform);
-    InitGameAudioClipAssets(Assets);
+    u32 ModelAssetCount;
+    game_asset *ModelAssets = GetGameAssets(Assets, Platform, AssetType_Model, L"assets\\*.model.asset", &ModelAssetCount);
 
-    LoadTextureAssets(Assets, Platform);
+    Assets->ModelAssetCount = ModelAssetCount;
+    Assets->ModelAssets = PushArray(&Assets->Arena, Assets->ModelAssetCount, game_asset_model);
 
-    Assets->State = GameAssetsState_Loaded;
-}
+    u32 AudioClipAssetCount;
+    game_asset *AudioClipAssets = GetGameAssets(Assets, Platform, AssetType_AudioClip, L"assets\\*.audio.asset", &AudioClipAssetCount);
 
-struct load_game_assets_job
-{
-    game_assets *Assets;
-    platform_api *Platform;
-};
+    Assets->AudioClipAssetCount = AudioClipAssetCount;
+    Assets->AudioClipAssets = PushArray(&Assets->Arena, Assets->AudioClipAssetCount, game_asset_audio_clip);
 
-JOB_ENTRY_POINT(LoadGameAssetsJob)
-{
-    load_game_assets_job *Data = (load_game_assets_job *) Parameters;
-    LoadGameAssets(Data->Assets, Data->Platform);
+    u32 TextureAssetCount;
+    game_asset *TextureAssets = GetGameAssets(Assets, Platform, AssetType_Texture, L"assets\\*.texture.asset", &TextureAssetCount);
+
+    Assets->TextureAssetCount = TextureAssetCount;
+    Assets->TextureAssets = PushArray(&Assets->Arena, Assets->TextureAssetCount, game_asset_texture);
+
+    for (u32 ModelAssetIndex = 0; ModelAssetIndex < ModelAssetCount; ++ModelAssetIndex)
+    {
+        game_asset_model *GameAssetModel = Assets->ModelAssets + ModelAssetIndex;
+        GameAssetModel->GameAsset = ModelAssets[ModelAssetIndex];
+    }
+
+    for (u32 AudioClipAssetIndex = 0; AudioClipAssetIndex < AudioClipAssetCount; ++AudioClipAssetIndex)
+    {
+        game_asset_audio_clip *GameAssetAudioClip = Assets->AudioClipAssets + AudioClipAssetIndex;
+        GameAssetAudioClip->GameAsset = AudioClipAssets[AudioClipAssetIndex];
+    }
+
+    for (u32 TextureAssetIndex = 0; TextureAssetIndex < TextureAssetCount; ++TextureAssetIndex)
+    {
+        game_asset_texture *GameAssetTexture = Assets->TextureAssets + TextureAssetIndex;
+        GameAssetTexture->GameAsset = TextureAssets[TextureAssetIndex];
+    }
+
+    u64 EndTime = Profiler->GetTimestamp();
+    Assets->LoadTime = ((f32)(EndTime - StartTime) / (f32)Profiler->TicksPerSecond) * 1000.f;
+
+    Assets->State = GameAssetsState_Loaded;
 }
 
 dummy_internal void
@@ -742,52 +1239,99 @@ RenderBoundingBox(render_commands *RenderCommands, game_state *State, game_entit
 }
 
 dummy_internal void
-RenderEntity(render_commands *RenderCommands, game_state *State, game_entity *Entity)
+RenderEntity(render_commands *RenderCommands, game_state *State, game_entity *Entity, material_options Options = DefaultMaterialOptions())
 {
     if (HasJoints(Entity->Model->Skeleton))
     {
         if (State->Options.ShowSkeletons)
         {
-            DrawSkeleton(RenderCommands, State, Entity->Skinning->Pose);
+            if (!Options.ShadowOnly)
+            {
+                DrawSkeleton(RenderCommands, State, Entity->Skinning->Pose);
+            }
         }
         else
         {
-            DrawSkinnedModel(RenderCommands, Entity->Model, Entity->Skinning->Pose, Entity->Skinning);
+            DrawSkinnedModel(RenderCommands, Entity->Model, Entity->Skinning->Pose, Entity->Skinning, Options);
         }
     }
     else
     {
-        DrawModel(RenderCommands, Entity->Model, Entity->Transform, Entity->DebugColor);
+        DrawModel(RenderCommands, Entity->Model, Entity->LodIndex, Entity->Transform, Entity->DebugColor, Entity->ClusterRanges, Options);
     }
 }
 
 dummy_internal void
 RenderEntityBatch(render_commands *RenderCommands, game_state *State, entity_render_batch *Batch)
 {
+    material_options Options = DefaultMaterialOptions();
+    Options.ShadowOnly = Batch->ShadowOnly;
+
     if (Batch->Skinning)
     {
         if (State->Options.ShowSkeletons)
         {
-            for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+            if (!Batch->ShadowOnly)
             {
-                game_entity *Entity = Batch->Entities[EntityIndex];
+                for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+                {
+                    game_entity *Entity = Batch->Entities[EntityIndex];
 
-                DrawSkeleton(RenderCommands, State, Entity->Skinning->Pose);
+                    DrawSkeleton(RenderCommands, State, Entity->Skinning->Pose);
+                }
             }
         }
         else
         {
-            DrawSkinnedModelInstanced(RenderCommands, Batch->Model, Batch->Skinning, Batch->EntityCount, Batch->SkinnedMeshInstances);
+            DrawSkinnedModelInstanced(RenderCommands, Batch->Model, Batch->Skinning, Batch->EntityCount, Batch->SkinnedMeshInstances, Options);
         }
     }
     else
     {
-        DrawModelInstanced(RenderCommands, Batch->Model, Batch->EntityCount, Batch->MeshInstances);
+        FlushInstanceBuffer(RenderCommands, Batch->InstanceBuffer);
+
+        // Grouping instances by LOD, one instanced draw per LOD
+        u32 LodInstanceCounts[MAX_MESH_LOD_COUNT] = {};
+        u32 LodInstanceOffsets[MAX_MESH_LOD_COUNT] = {};
+
+        for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+        {
+            game_entity *Entity = Batch->Entities[EntityIndex];
+            ++LodInstanceCounts[Entity->LodIndex];
+        }
+
+        for (u32 LodIndex = 1; LodIndex < MAX_MESH_LOD_COUNT; ++LodIndex)
+        {
+            LodInstanceOffsets[LodIndex] = LodInstanceOffsets[LodIndex - 1] + LodInstanceCounts[LodIndex - 1];
+        }
+
+        // Instance indices are read by the renderer at the end of the frame
+        u32 *InstanceIndices = PushArray(&State->FrameArena, Batch->EntityCount, u32, NoClear());
+        u32 LodInstanceCursors[MAX_MESH_LOD_COUNT] = {};
+
+        for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+        {
+            game_entity *Entity = Batch->Entities[EntityIndex];
+            u32 LodIndex = Entity->LodIndex;
+
+            InstanceIndices[LodInstanceOffsets[LodIndex] + LodInstanceCursors[LodIndex]++] = Batch->InstanceIndices[EntityIndex];
+        }
+
+        for (u32 LodIndex = 0; LodIndex < MAX_MESH_LOD_COUNT; ++LodIndex)
+        {
+            if (LodInstanceCounts[LodIndex] > 0)
+            {
+                DrawModelInstanced(
+                    RenderCommands, Batch->Model, LodIndex, Batch->InstanceBuffer->InstanceBufferId,
+                    LodInstanceCounts[LodIndex], InstanceIndices + LodInstanceOffsets[LodIndex], Options
+                );
+            }
+        }
     }
 
     // debug drawing
     // todo: instancing
-    for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+    for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount && !Batch->ShadowOnly; ++EntityIndex)
     {
         game_entity *Entity = Batch->Entities[EntityIndex];
 
@@ -799,11 +1343,12 @@ RenderEntityBatch(render_commands *RenderCommands, game_state *State, entity_ren
 }
 
 inline void
-InitRenderBatch(entity_render_batch *Batch, game_entity *Entity, u32 MaxEntityCount, memory_arena *Arena)
+InitRenderBatch(game_state *State, entity_render_batch *Batch, char *Key, game_entity *Entity, bool32 ShadowOnly, u32 MaxEntityCount, memory_arena *Arena)
 {
     Assert(Entity->Model);
 
-    CopyString(Entity->Model->Key, Batch->Key);
+    CopyString(Key, Batch->Key);
+    Batch->ShadowOnly = ShadowOnly;
     Batch->EntityCount = 0;
     Batch->MaxEntityCount = MaxEntityCount;
     Batch->Model = Entity->Model;
@@ -816,12 +1361,13 @@ InitRenderBatch(entity_render_batch *Batch, game_entity *Entity, u32 MaxEntityCo
     }
     else
     {
-        Batch->MeshInstances = PushArray(Arena, Batch->MaxEntityCount, mesh_instance, NoClear());
+        Batch->InstanceBuffer = GetInstanceBuffer(State, Entity->Model);
+        Batch->InstanceIndices = PushArray(Arena, Batch->MaxEntityCount, u32, NoClear());
     }
 }
 
 inline void
-AddEntityToRenderBatch(entity_render_batch *Batch, game_entity *Entity)
+AddEntityToRenderBatch(game_state *State, entity_render_batch *Batch, game_entity *Entity, render_commands *RenderCommands)
 {
     Assert(Batch->EntityCount < Batch->MaxEntityCount);
 
@@ -837,32 +1383,107 @@ AddEntityToRenderBatch(entity_render_batch *Batch, game_entity *Entity)
     }
     else
     {
-        mesh_instance *NextFreeInstance = Batch->MeshInstances + Batch->EntityCount;
+        UpdateEntityInstance(State, Entity, RenderCommands);
 
-        NextFreeInstance->Model = Transform(Entity->Transform);
-        NextFreeInstance->Color = Entity->DebugColor;
+        Assert(Entity->InstanceBuffer == Batch->InstanceBuffer);
+
+        u32 *NextFreeInstanceIndex = Batch->InstanceIndices + Batch->EntityCount;
+        *NextFreeInstanceIndex = Entity->InstanceIndex;
     }
 
     Batch->EntityCount++;
 }
 
+inline bool32
+HasFreeEntitySlot(world_area *Area)
+{
+    bool32 Result = Area->FreeEntityCount > 0 || Area->EntityCount < Area->MaxEntityCount;
+    return Result;
+}
+
+// Returns 0 when all entity slots of the area are taken
 inline game_entity *
 CreateGameEntity(game_state *State)
 {
     world_area *Area = &State->WorldArea;
 
-    game_entity *Entity = Area->Entities + Area->EntityCount++;
+    game_entity *Result = 0;
 
-    *Entity = {};
+    if (Area->FreeEntityCount > 0)
+    {
+        Result = Area->Entities + Area->FreeEntityIndices[--Area->FreeEntityCount];
+    }
+    else if (Area->EntityCount < Area->MaxEntityCount)
+    {
+        Result = Area->Entities + Area->EntityCount++;
+    }
 
-    Assert(Area->EntityCount <= Area->MaxEntityCount);
+    if (Result)
+    {
+        *Result = {};
 
-    Entity->Id = GenerateEntityId(State);
-    CopyString("Unnamed", Entity->Name);
-    // todo:
-    Entity->DebugColor = vec3(1.f);
+        // Index of the slot, so the entities can be found by id (see GetGameEntity)
+        Result->Id = (u32)(Result - Area->Entities) + 1;
+        CopyString("Unnamed", Result->Name);
+        // todo:
+        Result->DebugColor = vec3(1.f);
+    }
+    else
+    {
+        Out(&State->PermanentStream, "Can't create an entity: all %d entity slots are taken", Area->MaxEntityCount);
+    }
 
-    return Entity;
+    return Result;
+}
+
+inline void
+ReleaseEntityModel(world_area *Area, game_entity *Entity)
+{
+    if (Entity->ModelMemory)
+    {
+        HeapFree(&Area->Heap, Entity->ModelMemory);
+        Entity->ModelMemory = 0;
+    }
+
+    Entity->Skinning = 0;
+    Entity->Animation = 0;
+}
+
+inline void
+ReleaseEntityComponents(world_area *Area, game_entity *Entity)
+{
+    ReleaseEntityModel(Area, Entity);
+
+    if (Entity->Collider)
+    {
+        PoolFree(&Area->Colliders, Entity->Collider);
+        Entity->Collider = 0;
+    }
+
+    if (Entity->Body)
+    {
+        PoolFree(&Area->Bodies, Entity->Body);
+        Entity->Body = 0;
+    }
+
+    if (Entity->PointLight)
+    {
+        PoolFree(&Area->PointLights, Entity->PointLight);
+        Entity->PointLight = 0;
+    }
+
+    if (Entity->ParticleEmitter)
+    {
+        HeapFree(&Area->Heap, Entity->ParticleEmitter->Particles);
+        PoolFree(&Area->ParticleEmitters, Entity->ParticleEmitter);
+        Entity->ParticleEmitter = 0;
+    }
+
+    if (Entity->AudioSource)
+    {
+        PoolFree(&Area->AudioSources, Entity->AudioSource);
+        Entity->AudioSource = 0;
+    }
 }
 
 inline void
@@ -870,331 +1491,1176 @@ RemoveGameEntity(game_state *State, game_entity *Entity)
 {
     Assert(!Entity->Destroyed);
 
-    RemoveFromSpacialGrid(&State->WorldArea.SpatialGrid, Entity);
+    world_area *Area = &State->WorldArea;
+
+    RemoveFromSpacialGrid(&Area->SpatialGrid, Entity);
+    ReleaseEntityInstance(Entity);
+    ReleaseEntityComponents(Area, Entity);
+
+    if (Entity->Cell)
+    {
+        --Entity->Cell->EntityCount;
+    }
+
+    // Record can be instantiated again, the next time its cell is loaded
+    if (Entity->HomeCell)
+    {
+        Entity->HomeCell->RecordEntityIds[Entity->HomeRecordIndex] = 0;
+    }
 
     Entity->Destroyed = true;
+
+    Area->FreeEntityIndices[Area->FreeEntityCount++] = Entity->Id - 1;
 }
 
 inline game_entity *
 GetGameEntity(game_state *State, u32 EntityId)
 {
-    // todo:
     world_area *Area = &State->WorldArea;
     game_entity *Entity = Area->Entities + (EntityId - 1);
     return Entity;
 }
 
 inline void
-AddModel(game_state *State, game_entity *Entity, game_assets *Assets, const char *ModelName, render_commands *RenderCommands, memory_arena *Arena)
+BuildEntityModel(game_entity *Entity, memory_arena *Arena)
 {
-    Entity->Model = GetModelAsset(Assets, ModelName);
+    Entity->Skinning = PushType(Arena, skinning_data, Align(16));
+    InitSkinningBuffer(Entity->Skinning, Entity->Model, Arena);
+
+    if (Entity->Model->AnimationCount > 0)
+    {
+        Entity->Animation = PushType(Arena, animation_graph, Align(16));
+        BuildAnimationGraph(Entity->Animation, Entity->Model->AnimationGraph, Entity->Model, Arena);
+    }
+}
 
+/*
+    Needs the model to be resident.
+    Skinning and the animation graph of the entity are kept in one heap block (see ReleaseEntityModel),
+    the size of the block is found by building them in the frame arena first.
+*/
+inline void
+InitEntityModel(game_state *State, game_entity *Entity, render_commands *RenderCommands)
+{
     if (HasJoints(Entity->Model->Skeleton))
     {
-        Entity->Skinning = PushType(Arena, skinning_data, Align(16));
-        InitSkinningBuffer(State, Entity->Skinning, Entity->Model, Arena, RenderCommands);
+        world_area *Area = &State->WorldArea;
+
+        umm ModelMemorySize = 0;
 
-        if (Entity->Model->AnimationCount > 0)
         {
-            Entity->Animation = PushType(Arena, animation_graph, Align(16));
-            BuildAnimationGraph(Entity->Animation, Entity->Model->AnimationGraph, Entity->Model, Arena);
+            scoped_memory ScopedMemory(&State->FrameArena);
+
+            // Heap blocks are aligned to 16 bytes as well, so both builds have the same layout
+            PushSize(ScopedMemory.Arena, 0, AlignNoClear(16));
+            umm StartUsed = ScopedMemory.Arena->Used;
+
+            BuildEntityModel(Entity, ScopedMemory.Arena);
+
+            ModelMemorySize = ScopedMemory.Arena->Used - StartUsed;
         }
+
+        // Arena needs some room past the last push
+        umm ModelArenaSize = ModelMemorySize + TLSF_ALIGNMENT;
+
+        Entity->ModelMemory = HeapAllocate(&Area->Heap, ModelArenaSize);
+        Assert(Entity->ModelMemory);
+
+        memory_arena ModelArena;
+        InitMemoryArena(&ModelArena, Entity->ModelMemory, ModelArenaSize);
+
+        BuildEntityModel(Entity, &ModelArena);
+
+        AddSkinningBuffer(RenderCommands, Entity->Model->SkinningBufferId, Entity->Skinning->SkinningMatrixCount);
     }
 }
 
 inline void
-AddBoxCollider(game_entity *Entity, vec3 HalfSize, mat4 Offset, memory_arena *Arena)
+RequestModel(model *Model)
 {
-    Entity->Collider = PushType(Arena, collider, Align(16));
-    Entity->Collider->Type = Collider_Box;
-    Entity->Collider->Box.HalfSize = HalfSize;
-    Entity->Collider->Box.Offset = Offset;
-
-    CalculateColliderState(Entity);
-
-    // todo:
-    if (Entity->Body)
+    if (Model->Residency.State == AssetResidency_Unloaded)
     {
-        Entity->Collider->Box.Body = Entity->Body;
+        Model->Residency.State = AssetResidency_Requested;
     }
 }
 
 inline void
-AddBoxCollider(game_entity *Entity, memory_arena *Arena)
+RequestTexture(texture *Texture)
 {
-    Assert(Entity->Model);
-
-    aabb Bounds = Entity->Model->Bounds;
-
-    vec3 HalfSize = Bounds.HalfExtent;
-    mat4 Offset = Translate(Bounds.Center);
-
-    AddBoxCollider(Entity, HalfSize, Offset, Arena);
+    if (Texture->Residency.State == AssetResidency_Unloaded)
+    {
+        Texture->Residency.State = AssetResidency_Requested;
+    }
 }
 
-inline void
-AddRigidBody(game_state *State, game_entity *Entity, memory_arena *Arena)
+// Nothing is loading and every requested asset is resident
+dummy_internal bool32
+IsAssetStreamingIdle(game_assets *Assets)
 {
-    Entity->Body = PushType(Arena, rigid_body, Align(16));
+    bool32 Result = Assets->LoadingAssetCount == 0;
 
-    f32 Mass = 10.f;
-    vec3 Size = vec3(1.f);
+    for (u32 ModelIndex = 0; ModelIndex < Assets->Models.Count && Result; ++ModelIndex)
+    {
+        model *Model = Assets->Models.Values + ModelIndex;
 
-    SetPosition(Entity->Body, Entity->Transform.Translation);
-    SetOrientation(Entity->Body, Entity->Transform.Rotation);
-    SetMass(Entity->Body, Mass);
-    SetCenterOfMass(Entity->Body, vec3(0.f));
-    SetInertiaTensor(Entity->Body, GetCuboidInertiaTensor(Mass, Size));
-    SetLinearDamping(Entity->Body, 0.95f);
-    SetAngularDamping(Entity->Body, 0.8f);
+        if (Model->Residency.State == AssetResidency_Requested)
+        {
+            Result = false;
+        }
+    }
 
-    CalculateRigidBodyState(Entity->Body);
+    for (u32 TextureIndex = 0; TextureIndex < Assets->Textures.Count && Result; ++TextureIndex)
+    {
+        texture *Texture = Assets->Textures.Values + TextureIndex;
 
-    // todo:
-    if (Entity->Collider)
+        if (Texture->Residency.State == AssetResidency_Requested)
+        {
+            Result = false;
+        }
+    }
+
+    for (u32 AudioClipIndex = 0; AudioClipIndex < Assets->AudioClips.Count && Result; ++AudioClipIndex)
     {
-        Entity->Collider->Box.Body = Entity->Body;
+        audio_clip *AudioClip = Assets->AudioClips.Values + AudioClipIndex;
+
+        if (AudioClip->Residency.State == AssetResidency_Requested)
+        {
+            Result = false;
+        }
     }
+
+    return Result;
 }
 
+// Moves the model to the end of the least recently used list, once per frame
 inline void
-AddPointLight(game_entity *Entity, vec3 Color, light_attenuation Attenuation, memory_arena *Arena)
+TouchModel(game_assets *Assets, model *Model)
 {
-    Entity->PointLight = PushType(Arena, point_light, Align(16));
-    Entity->PointLight->Position = Entity->Transform.Translation;
-    Entity->PointLight->Color = Color;
-    Entity->PointLight->Attenuation = Attenuation;
+    if (!Model->Residency.Pinned && Model->Residency.LastUsedFrame != Assets->FrameIndex)
+    {
+        Model->Residency.LastUsedFrame = Assets->FrameIndex;
+
+        RemoveFromLinkedList(Model);
+        AddToLinkedList(&Assets->ResidentModelSentinel, Model);
+    }
 }
 
 inline void
-AddParticleEmitter(game_entity *Entity, u32 ParticleCount, u32 ParticlesSpawn, vec4 Color, vec2 Size, memory_arena *Arena)
+TouchTexture(game_assets *Assets, texture *Texture)
 {
-    Entity->ParticleEmitter = PushType(Arena, particle_emitter, Align(16));
-    Entity->ParticleEmitter->ParticleCount = ParticleCount;
-    Entity->ParticleEmitter->Particles = PushArray(Arena, ParticleCount, particle, Align(16));
-    Entity->ParticleEmitter->ParticlesSpawn = ParticlesSpawn;
-    Entity->ParticleEmitter->Color = Color;
-    Entity->ParticleEmitter->Size = Size;
-    Entity->ParticleEmitter->NextParticleIndex = 0;
+    if (Texture->Residency.LastUsedFrame != Assets->FrameIndex)
+    {
+        Texture->Residency.LastUsedFrame = Assets->FrameIndex;
+
+        RemoveFromLinkedList(Texture);
+        AddToLinkedList(&Assets->ResidentTextureSentinel, Texture);
+    }
 }
 
-inline void
-AddAudioSource(game_state *State, game_entity *Entity, audio_clip *AudioClip, vec3 Position, f32 Volume, f32 MinDistance, f32 MaxDistance, audio_commands *AudioCommands, memory_arena *Arena)
+// Requests the texture on first use, 0 until it is streamed in (billboards are drawn untextured meanwhile)
+dummy_internal texture *
+UseTexture(game_assets *Assets, const char *Name)
 {
-    Entity->AudioSource = PushType(Arena, audio_source, Align(16));
-    Entity->AudioSource->AudioClip = AudioClip;
-    Entity->AudioSource->Volume = Volume;
-    Entity->AudioSource->MinDistance = MinDistance;
-    Entity->AudioSource->MaxDistance = MaxDistance;
-    Entity->AudioSource->IsPlaying = true;
-    Entity->AudioSource->Id = GenerateAudioSourceId(State);
+    texture *Result = 0;
 
-    // todo:
-    bool32 IsLooping = true;
-    Play3D(AudioCommands, AudioClip, Position, MinDistance, MaxDistance, SetAudioPlayOptions(Volume, IsLooping), Entity->AudioSource->Id);
-}
+    texture *Texture = GetTextureAsset(Assets, Name);
 
-inline void
-CopyGameEntity(game_state *State, render_commands *RenderCommands, audio_commands *AudioCommands, game_entity *Source, game_entity *Dest)
+    if (Texture->Residency.State == AssetResidency_Resident)
+    {
+        TouchTexture(Assets, Texture);
+        Result = Texture;
+    }
+    else if (!IsSlotEmpty(Texture->Key))
+    {
+        RequestTexture(Texture);
+    }
+
+    return Result;
+}
+
+struct load_model_job
 {
-    world_area *Area = &State->WorldArea;
+    game_assets *Assets;
+    platform_api *Platform;
+    model *Model;
+    game_asset *GameAsset;
 
-    Dest->Transform = Source->Transform;
+    // Rest of the model block
+    memory_arena Arena;
 
-    if (Source->Model)
+    model_asset *ModelAsset;
+
+    // Set by the job as the last write into the block
+    u32 volatile Finished;
+};
+
+JOB_ENTRY_POINT(LoadModelJob)
+{
+    load_model_job *Data = (load_model_job *) Parameters;
+    platform_api *Platform = Data->Platform;
+    model *Model = Data->Model;
+
+    u8 *AssetData = GetGameAssetData(Data->Assets, Platform, Data->GameAsset, &Data->Arena);
+    Data->ModelAsset = ParseModelAsset(AssetData, &Data->Arena);
+
+    // Model could have been replaced in the editor in the meantime
+    Platform->EnterCriticalSection(Platform->PlatformHandle);
+
+    if (Model->Residency.State == AssetResidency_Loading)
     {
-        AddModel(State, Dest, &State->Assets, Source->Model->Key, RenderCommands, &Area->Arena);
+        Model->Residency.State = AssetResidency_Loaded;
     }
 
-    if (Source->Collider)
+    AtomicStoreRelease(&Data->Finished, true);
+
+    Platform->LeaveCriticalSection(Platform->PlatformHandle);
+}
+
+// Keeps the model record (key, bounds and ids), so the entities can still reference it
+dummy_internal void
+EvictModel(game_assets *Assets, model *Model, render_commands *RenderCommands)
+{
+    Assert(IsModelResident(Model) && !Model->Residency.Pinned);
+
+    RemoveModelFromRenderer(Model, RenderCommands);
+    RemoveFromLinkedList(Model);
+    FreeBlock(&Assets->AssetAllocator, Model->Residency.Block);
+
+    model EvictedModel = {};
+
+    CopyString(Model->Key, EvictedModel.Key);
+    EvictedModel.Bounds = Model->Bounds;
+    EvictedModel.BoundsOBB = Model->BoundsOBB;
+    EvictedModel.Residency = Model->Residency;
+    EvictedModel.Residency.State = AssetResidency_Unloaded;
+    EvictedModel.Residency.Block = 0;
+
+    *Model = EvictedModel;
+
+    --Assets->ResidentModelCount;
+}
+
+// Keeps the texture record (key and id), the id is reused once the texture is streamed in again
+dummy_internal void
+EvictTexture(game_assets *Assets, texture *Texture, render_commands *RenderCommands)
+{
+    Assert(Texture->Residency.State == AssetResidency_Resident);
+
+    RemoveTexture(RenderCommands, Texture->TextureId);
+    RemoveFromLinkedList(Texture);
+    FreeBlock(&Assets->AssetAllocator, Texture->Residency.Block);
+
+    Texture->Bitmap = {};
+    Texture->Residency.State = AssetResidency_Unloaded;
+    Texture->Residency.Block = 0;
+
+    --Assets->ResidentTextureCount;
+}
+
+// Entities that were added before the model was resident
+dummy_internal void
+InitPendingEntityModels(game_state *State, model *Model, render_commands *RenderCommands)
+{
+    world_area *Area = &State->WorldArea;
+
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
     {
-        Assert(Source->Collider->Type == Collider_Box);
+        game_entity *Entity = Area->Entities + EntityIndex;
 
-        switch (Source->Collider->Type)
+        if (!Entity->Destroyed && Entity->Model == Model && !Entity->Skinning)
         {
-            case Collider_Box:
-            {
-                AddBoxCollider(Dest, Source->Collider->Box.HalfSize, Source->Collider->Box.Offset, &Area->Arena);
-                break;
-            }
-            default:
-            {
-                Assert(!"Invalid collider type");
-            }
+            InitEntityModel(State, Entity, RenderCommands);
         }
+    }
+}
 
-        
+// Audio sources that were added before their clip was resident
+dummy_internal void
+StartPendingAudioSources(game_state *State, audio_clip *AudioClip, audio_commands *AudioCommands)
+{
+    world_area *Area = &State->WorldArea;
+
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
+        audio_source *AudioSource = Entity->AudioSource;
+
+        if (!Entity->Destroyed && AudioSource && AudioSource->Pending && AudioSource->AudioClip == AudioClip)
+        {
+            // todo:
+            bool32 IsLooping = true;
+            Play3D(AudioCommands, AudioClip, Entity->Transform.Translation, AudioSource->MinDistance, AudioSource->MaxDistance, SetAudioPlayOptions(AudioSource->Volume, IsLooping), AudioSource->Id);
+
+            AudioSource->Pending = false;
+        }
     }
+}
 
-    if (Source->Body)
+/*
+    Models and textures used in the last frame are never evicted, so the visible set doesn't thrash.
+    Both lists are in least recently used order, the older of the two heads goes first.
+*/
+dummy_internal bool32
+EvictLeastRecentlyUsedAsset(game_assets *Assets, render_commands *RenderCommands)
+{
+    bool32 Result = false;
+
+    model *Model = Assets->ResidentModelSentinel.Next;
+    texture *Texture = Assets->ResidentTextureSentinel.Next;
+
+    bool32 CanEvictModel = Model != &Assets->ResidentModelSentinel && Model->Residency.LastUsedFrame < Assets->FrameIndex;
+    bool32 CanEvictTexture = Texture != &Assets->ResidentTextureSentinel && Texture->Residency.LastUsedFrame < Assets->FrameIndex;
+
+    if (CanEvictModel && (!CanEvictTexture || Model->Residency.LastUsedFrame <= Texture->Residency.LastUsedFrame))
+    {
+        EvictModel(Assets, Model, RenderCommands);
+        Result = true;
+    }
+    else if (CanEvictTexture)
     {
-        AddRigidBody(State, Dest, &Area->Arena);
+        EvictTexture(Assets, Texture, RenderCommands);
+        Result = true;
     }
 
-    if (Source->PointLight)
+    return Result;
+}
+
+inline umm
+GetModelBlockSize(game_asset_model *GameAssetModel)
+{
+    umm Result = sizeof(load_model_job) + GetLoadGameAssetArenaSize(AssetType_Model, &GameAssetModel->GameAsset) + GameAssetModel->DecodedMeshesSize;
+    return Result;
+}
+
+inline umm
+GetGameAssetBlockSize(asset_type Type, game_asset *GameAsset)
+{
+    umm Result = sizeof(load_game_asset_job) + GetLoadGameAssetArenaSize(Type, GameAsset);
+    return Result;
+}
+
+inline umm
+GetAssetMemoryBudget(game_state *State, game_assets *Assets)
+{
+    i32 Budget = Min(State->Options.AssetMemoryBudget, Assets->MaxMemoryBudget);
+
+    umm Result = Megabytes((umm)Budget);
+    return Result;
+}
+
+/*
+    Sized from the budget option, plus room for the largest asset: assets larger than the budget are still loaded over it (see AllocateAssetBlock).
+    Budget can be lowered in the editor afterwards, not raised above the size the allocator was created with.
+*/
+dummy_internal void
+InitAssetAllocator(game_state *State, game_assets *Assets)
+{
+    umm LargestBlockSize = 0;
+
+    for (u32 GameAssetModelIndex = 0; GameAssetModelIndex < Assets->ModelAssetCount; ++GameAssetModelIndex)
     {
-        AddPointLight(Dest, Source->PointLight->Color, Source->PointLight->Attenuation, &Area->Arena);
+        umm BlockSize = GetModelBlockSize(Assets->ModelAssets + GameAssetModelIndex);
+        LargestBlockSize = BlockSize > LargestBlockSize ? BlockSize : LargestBlockSize;
     }
 
-    if (Source->ParticleEmitter)
+    for (u32 GameAssetTextureIndex = 0; GameAssetTextureIndex < Assets->TextureAssetCount; ++GameAssetTextureIndex)
     {
-        AddParticleEmitter(Dest, Source->ParticleEmitter->ParticleCount, Source->ParticleEmitter->ParticlesSpawn, Source->ParticleEmitter->Color, Source->ParticleEmitter->Size, &Area->Arena);
+        umm BlockSize = GetGameAssetBlockSize(AssetType_Texture, &Assets->TextureAssets[GameAssetTextureIndex].GameAsset);
+        LargestBlockSize = BlockSize > LargestBlockSize ? BlockSize : LargestBlockSize;
     }
 
-    if (Source->AudioSource)
+    for (u32 GameAssetAudioClipIndex = 0; GameAssetAudioClipIndex < Assets->AudioClipAssetCount; ++GameAssetAudioClipIndex)
     {
-        AddAudioSource(State, Dest, Source->AudioSource->AudioClip, Source->Transform.Translation, Source->AudioSource->Volume, Source->AudioSource->MinDistance, Source->AudioSource->MaxDistance, AudioCommands, &Area->Arena);
+        umm BlockSize = GetGameAssetBlockSize(AssetType_AudioClip, &Assets->AudioClipAssets[GameAssetAudioClipIndex].GameAsset);
+        LargestBlockSize = BlockSize > LargestBlockSize ? BlockSize : LargestBlockSize;
     }
+
+    Assets->MaxMemoryBudget = State->Options.AssetMemoryBudget;
+
+    umm AllocatorSize = Megabytes((umm)Assets->MaxMemoryBudget) + AlignAddress(LargestBlockSize, FREE_LIST_BLOCK_ALIGNMENT);
+    InitFreeListAllocator(&Assets->AssetAllocator, PushSize(&Assets->Arena, AllocatorSize, AlignNoClear(FREE_LIST_BLOCK_ALIGNMENT)), AllocatorSize);
 }
 
+// Evicts least recently used assets until the block fits within the budget, 0 if it doesn't fit yet
 dummy_internal void *
-GetAnimatorParams(game_state *State, game_input *Input, game_entity *Entity, memory_arena *Arena)
+AllocateAssetBlock(game_state *State, game_assets *Assets, umm BlockSize, const char *Key, render_commands *RenderCommands)
 {
-    void *Params = 0;
+    umm MemoryBudget = GetAssetMemoryBudget(State, Assets);
 
-    switch (SID(Entity->Animation->Animator))
-    {
-        case SID("Bot"):
-        {
-            Params = PushType(Arena, bot_animator_params);
+    void *Result = 0;
 
-            if (State->Player == Entity && State->Mode == GameMode_World)
-            {
-                GameInput2BotAnimatorParams(State, Input, Entity, (bot_animator_params *)Params);
-            }
-            else
-            {
-                GameLogic2BotAnimatorParams(State, Entity, (bot_animator_params *)Params);
-            }
+    if (BlockSize > MemoryBudget)
+    {
+        // Evicting the other assets would never make room for it
+        Result = AllocateBlock(&Assets->AssetAllocator, BlockSize);
 
-            break;
-        }
-        case SID("Paladin"):
+        if (Result)
         {
-            Params = PushType(Arena, paladin_animator_params);
-
-            if (State->Player == Entity && State->Mode == GameMode_World)
-            {
-                GameInput2PaladinAnimatorParams(State, Input, Entity, (paladin_animator_params *)Params);
-            }
-            else
-            {
-                GameLogic2PaladinAnimatorParams(State, Entity, (paladin_animator_params *)Params);
-            }
-
-            break;
+            Out(&State->PermanentStream, "Asset %s needs %d MB, loaded over the budget (%d MB)", Key, (u32)(BlockSize / Megabytes(1)) + 1, (u32)(MemoryBudget / Megabytes(1)));
         }
-        case SID("Monstar"):
-        {
-            Params = PushType(Arena, monstar_animator_params);
-
-            if (State->Player == Entity && State->Mode == GameMode_World)
-            {
-                GameInput2MonstarAnimatorParams(State, Input, Entity, (monstar_animator_params *)Params);
-            }
-            else
-            {
-                GameLogic2MonstarAnimatorParams(State, Entity, (monstar_animator_params *)Params);
-            }
+    }
 
-            break;
+    while (!Result && BlockSize <= MemoryBudget)
+    {
+        if (Assets->AssetAllocator.Used + BlockSize <= MemoryBudget)
+        {
+            Result = AllocateBlock(&Assets->AssetAllocator, BlockSize);
         }
-        default:
+
+        if (!Result && !EvictLeastRecentlyUsedAsset(Assets, RenderCommands))
         {
-            Assert(!"Animator is not supported");
             break;
         }
     }
 
-    return Params;
+    return Result;
 }
 
-dummy_internal void
-AnimateEntity(game_state *State, game_input *Input, game_entity *Entity, memory_arena *Arena, f32 Delta)
+// Stays requested until enough memory is released, 0 in that case
+dummy_internal load_game_asset_job *
+BeginLoadGameAsset(game_state *State, game_assets *Assets, platform_api *Platform, asset_type Type, u32 AssetIndex, game_asset *GameAsset, asset_residency *Residency, render_commands *RenderCommands)
 {
-    Assert(Entity->Skinning);
+    umm BlockSize = GetGameAssetBlockSize(Type, GameAsset);
+    load_game_asset_job *Result = (load_game_asset_job *) AllocateAssetBlock(State, Assets, BlockSize, GameAsset->Name, RenderCommands);
 
-    skeleton_pose *Pose = Entity->Skinning->Pose;
-    skeleton_pose *BindPose = Entity->Skinning->BindPose;
-    transform *Root = GetRootLocalJointPose(Pose);
+    if (Result)
+    {
+        Result->Assets = Assets;
+        Result->Platform = Platform;
+        Result->Type = Type;
+        Result->AssetIndex = AssetIndex;
+        Result->Residency = Residency;
+        InitMemoryArena(&Result->Arena, Result + 1, BlockSize - sizeof(load_game_asset_job));
+
+        Residency->Block = Result;
+        Residency->State = AssetResidency_Loading;
+        ++Assets->LoadingAssetCount;
+    }
 
-    if (Entity->Animation)
+    return Result;
+}
+
+dummy_internal void
+KickLoadGameAssetJob(game_state *State, game_assets *Assets, platform_api *Platform, asset_type Type, u32 AssetIndex, game_asset *GameAsset, asset_residency *Residency, render_commands *RenderCommands)
+{
+    load_game_asset_job *JobData = BeginLoadGameAsset(State, Assets, Platform, Type, AssetIndex, GameAsset, Residency, RenderCommands);
+
+    if (JobData)
     {
-        void *Params = GetAnimatorParams(State, Input, Entity, Arena);
+        job Job = {};
+        Job.EntryPoint = LoadGameAssetJob;
+        Job.Parameters = JobData;
+        Job.Name = "LoadGameAssetJob";
 
-        AnimatorPerFrameUpdate(&State->Animator, Entity->Animation, Params, Delta);
-        AnimationGraphPerFrameUpdate(Entity->Animation, Delta);
-        CalculateSkeletonPose(Entity->Animation, BindPose, Pose, Entity->Id, &State->EventList, Arena);
+        Platform->KickJob(State->BackgroundJobQueue, Job);
+    }
+}
 
-        // Root Motion
-        Entity->Animation->AccRootMotion.x += Pose->RootMotion.x;
-        Entity->Animation->AccRootMotion.z += Pose->RootMotion.z;
+dummy_internal void
+MakeTextureResident(game_assets *Assets, texture *Texture, render_commands *RenderCommands)
+{
+    game_asset_texture *GameAssetTexture = Assets->TextureAssets + Texture->Residency.AssetIndex;
 
-        vec3 ScaledRootMotion = Entity->Animation->AccRootMotion * Entity->Transform.Scale;
-        vec3 RotatedScaledRootMotion = Rotate(ScaledRootMotion, Entity->Transform.Rotation);
+    InitTexture(GameAssetTexture->TextureAsset, Texture, RenderCommands);
 
-#if 1
-        if (Entity->Body)
-        {
-            if (NearlyEqual(Entity->Body->Velocity.x, 0.f))
-            {
-                Entity->Body->Position.x += RotatedScaledRootMotion.x;
-            }
+    Texture->Residency.State = AssetResidency_Resident;
+    Texture->Residency.LastUsedFrame = Assets->FrameIndex;
 
-            if (NearlyEqual(Entity->Body->Velocity.z, 0.f))
-            {
-                Entity->Body->Position.z += RotatedScaledRootMotion.z;
-            }
-        }
-#endif
+    --Assets->LoadingAssetCount;
+    ++Assets->ResidentTextureCount;
 
-        Entity->Animation->AccRootMotion = vec3(0.f);
-    }
+    AddToLinkedList(&Assets->ResidentTextureSentinel, Texture);
+}
 
-    Root->Translation = Entity->Transform.Translation;
-    Root->Rotation = Entity->Transform.Rotation;
-    Root->Scale = Entity->Transform.Scale;
+dummy_internal void
+MakeAudioClipResident(game_state *State, game_assets *Assets, audio_clip *AudioClip, audio_commands *AudioCommands)
+{
+    game_asset_audio_clip *GameAssetAudioClip = Assets->AudioClipAssets + AudioClip->Residency.AssetIndex;
 
-    UpdateGlobalJointPoses(Pose);
-    UpdateSkinningMatrices(Entity->Skinning);
+    InitAudioClip(GameAssetAudioClip->AudioAsset, AudioClip);
+
+    AudioClip->Residency.State = AssetResidency_Resident;
+    AudioClip->Residency.Pinned = true;
+
+    --Assets->LoadingAssetCount;
+    ++Assets->ResidentAudioClipCount;
+
+    StartPendingAudioSources(State, AudioClip, AudioCommands);
 }
 
-struct update_entity_batch_job
+// Loads on the calling thread, for the assets that are needed in the same frame (e.g. the skybox)
+dummy_internal bool32
+LoadTextureNow(game_state *State, game_assets *Assets, platform_api *Platform, texture *Texture, render_commands *RenderCommands)
 {
-    u32 StartIndex;
-    u32 EndIndex;
-    f32 UpdateRate;
-    u32 PlayerId;
-    game_entity *Entities;
-    spatial_hash_grid *SpatialGrid;
-    random_sequence *Entropy;
-    memory_arena Arena;
-    game_state *State;
-    platform_api *Platform;
-};
+    if (Texture->Residency.State == AssetResidency_Unloaded || Texture->Residency.State == AssetResidency_Requested)
+    {
+        u32 AssetIndex = Texture->Residency.AssetIndex;
+        load_game_asset_job *JobData = BeginLoadGameAsset(State, Assets, Platform, AssetType_Texture, AssetIndex, &Assets->TextureAssets[AssetIndex].GameAsset, &Texture->Residency, RenderCommands);
+
+        if (JobData)
+        {
+            LoadGameAssetJob(0, JobData);
+            MakeTextureResident(Assets, Texture, RenderCommands);
+        }
+    }
+
+    bool32 Result = Texture->Residency.State == AssetResidency_Resident;
+    return Result;
+}
 
-JOB_ENTRY_POINT(UpdateEntityBatchJob)
+// Loads on the calling thread, for the clips that are played in the same frame (e.g. the music)
+dummy_internal bool32
+LoadAudioClipNow(game_state *State, game_assets *Assets, platform_api *Platform, audio_clip *AudioClip, render_commands *RenderCommands, audio_commands *AudioCommands)
 {
-    update_entity_batch_job *Data = (update_entity_batch_job *) Parameters;
+    if (AudioClip->Residency.State == AssetResidency_Unloaded || AudioClip->Residency.State == AssetResidency_Requested)
+    {
+        u32 AssetIndex = AudioClip->Residency.AssetIndex;
+        load_game_asset_job *JobData = BeginLoadGameAsset(State, Assets, Platform, AssetType_AudioClip, AssetIndex, &Assets->AudioClipAssets[AssetIndex].GameAsset, &AudioClip->Residency, RenderCommands);
 
-    game_state *State = Data->State;
-    platform_api *Platform = Data->Platform;
-    contact_resolver *ContactResolver = &State->ContactResolver;
+        if (JobData)
+        {
+            LoadGameAssetJob(0, JobData);
+            MakeAudioClipResident(State, Assets, AudioClip, AudioCommands);
+        }
+    }
 
-    f32 dt = Data->UpdateRate;
+    bool32 Result = IsAudioClipResident(AudioClip);
+    return Result;
+}
+
+/*
+    Runs once per frame on the main thread, before anything is drawn:
+    kicks load jobs for the requested models, textures and audio clips (evicting least recently used ones to stay within the budget),
+    adds the models and textures loaded since the last frame to the renderer and starts the audio sources waiting for their clips.
+*/
+dummy_internal void
+UpdateAssetResidency(game_state *State, game_assets *Assets, platform_api *Platform, render_commands *RenderCommands, audio_commands *AudioCommands)
+{
+    umm MemoryBudget = GetAssetMemoryBudget(State, Assets);
 
-    for (u32 EntityIndex = Data->StartIndex; EntityIndex < Data->EndIndex; ++EntityIndex)
+    // Budget can be lowered in the editor
+    while (Assets->AssetAllocator.Used > MemoryBudget && EvictLeastRecentlyUsedAsset(Assets, RenderCommands)) {}
+
+    for (u32 ModelIndex = 0; ModelIndex < Assets->Models.Count; ++ModelIndex)
     {
-        game_entity *Entity = Data->Entities + EntityIndex;
+        model *Model = Assets->Models.Values + ModelIndex;
 
-        if (!Entity->Destroyed)
+        // Blocks of the models replaced in the editor while they were loading
+        if (Model->Residency.ReleasedBlock)
         {
-            rigid_body *Body = Entity->Body;
-            collider *Collider = Entity->Collider;
+            load_model_job *JobData = (load_model_job *) Model->Residency.ReleasedBlock;
 
-            if (Body)
+            if (AtomicLoadAcquire(&JobData->Finished))
             {
-                bool32 OnTheGround = NearlyEqual(Entity->Body->Position.y, 0.f);
+                FreeBlock(&Assets->AssetAllocator, Model->Residency.ReleasedBlock);
+                Model->Residency.ReleasedBlock = 0;
+                --Assets->LoadingAssetCount;
+            }
+        }
+    }
+
+    for (u32 ModelIndex = 0; ModelIndex < Assets->Models.Count; ++ModelIndex)
+    {
+        model *Model = Assets->Models.Values + ModelIndex;
+
+        if (Model->Residency.State == AssetResidency_Requested && Assets->LoadingAssetCount < MAX_LOADING_ASSET_COUNT)
+        {
+            game_asset_model *GameAssetModel = Assets->ModelAssets + Model->Residency.AssetIndex;
+            game_asset *GameAsset = &GameAssetModel->GameAsset;
+            umm BlockSize = GetModelBlockSize(GameAssetModel);
+
+            void *Block = AllocateAssetBlock(State, Assets, BlockSize, Model->Key, RenderCommands);
+
+            // Stays requested until enough memory is released
+            if (Block)
+            {
+                load_model_job *JobData = (load_model_job *) Block;
+
+                JobData->Assets = Assets;
+                JobData->Platform = Platform;
+                JobData->Model = Model;
+                JobData->GameAsset = GameAsset;
+                JobData->ModelAsset = 0;
+                JobData->Finished = false;
+                InitMemoryArena(&JobData->Arena, JobData + 1, BlockSize - sizeof(load_model_job));
+
+                Model->Residency.Block = Block;
+                Model->Residency.State = AssetResidency_Loading;
+                ++Assets->LoadingAssetCount;
+
+                job Job = {};
+                Job.EntryPoint = LoadModelJob;
+                Job.Parameters = JobData;
+                Job.Name = "LoadModelJob";
+
+                Platform->KickJob(State->BackgroundJobQueue, Job);
+            }
+        }
+    }
+
+    for (u32 TextureIndex = 0; TextureIndex < Assets->Textures.Count; ++TextureIndex)
+    {
+        texture *Texture = Assets->Textures.Values + TextureIndex;
+
+        if (Texture->Residency.State == AssetResidency_Requested && Assets->LoadingAssetCount < MAX_LOADING_ASSET_COUNT)
+        {
+            u32 AssetIndex = Texture->Residency.AssetIndex;
+            KickLoadGameAssetJob(State, Assets, Platform, AssetType_Texture, AssetIndex, &Assets->TextureAssets[AssetIndex].GameAsset, &Texture->Residency, RenderCommands);
+        }
+    }
+
+    for (u32 AudioClipIndex = 0; AudioClipIndex < Assets->AudioClips.Count; ++AudioClipIndex)
+    {
+        audio_clip *AudioClip = Assets->AudioClips.Values + AudioClipIndex;
+
+        if (AudioClip->Residency.State == AssetResidency_Requested && Assets->LoadingAssetCount < MAX_LOADING_ASSET_COUNT)
+        {
+            u32 AssetIndex = AudioClip->Residency.AssetIndex;
+            KickLoadGameAssetJob(State, Assets, Platform, AssetType_AudioClip, AssetIndex, &Assets->AudioClipAssets[AssetIndex].GameAsset, &AudioClip->Residency, RenderCommands);
+        }
+    }
+
+    ++Assets->FrameIndex;
+
+    for (u32 ModelIndex = 0; ModelIndex < Assets->Models.Count; ++ModelIndex)
+    {
+        model *Model = Assets->Models.Values + ModelIndex;
+
+        if (Model->Residency.State == AssetResidency_Loaded)
+        {
+            load_model_job *JobData = (load_model_job *) Model->Residency.Block;
+
+            char Name[64];
+            CopyString(Model->Key, Name);
+
+            InitModel(State, JobData->ModelAsset, Model, Name, &Assets->Arena, RenderCommands);
+
+            Model->Residency.State = AssetResidency_Resident;
+            Model->Residency.LastUsedFrame = Assets->FrameIndex;
+
+            --Assets->LoadingAssetCount;
+            ++Assets->ResidentModelCount;
+
+            if (HasJoints(Model->Skeleton))
+            {
+                Model->Residency.Pinned = true;
+                InitPendingEntityModels(State, Model, RenderCommands);
+            }
+            else
+            {
+                AddToLinkedList(&Assets->ResidentModelSentinel, Model);
+            }
+        }
+    }
+
+    for (u32 TextureIndex = 0; TextureIndex < Assets->Textures.Count; ++TextureIndex)
+    {
+        texture *Texture = Assets->Textures.Values + TextureIndex;
+
+        if (AtomicLoadAcquire((u32 volatile *) &Texture->Residency.State) == AssetResidency_Loaded)
+        {
+            MakeTextureResident(Assets, Texture, RenderCommands);
+        }
+    }
+
+    for (u32 AudioClipIndex = 0; AudioClipIndex < Assets->AudioClips.Count; ++AudioClipIndex)
+    {
+        audio_clip *AudioClip = Assets->AudioClips.Values + AudioClipIndex;
+
+        if (AtomicLoadAcquire((u32 volatile *) &AudioClip->Residency.State) == AssetResidency_Loaded)
+        {
+            MakeAudioClipResident(State, Assets, AudioClip, AudioCommands);
+        }
+    }
+}
+
+/*
+    Replaces the model with the asset imported in the editor, the model is never evicted afterwards.
+    Block of the previous model data is freed (or once its load job is done) and the entities of the model are built again.
+*/
+dummy_internal void
+ReplaceModel(game_state *State, game_assets *Assets, platform_api *Platform, model_asset *Asset, model *Model, const char *Name, render_commands *RenderCommands)
+{
+    world_area *Area = &State->WorldArea;
+
+    Platform->EnterCriticalSection(Platform->PlatformHandle);
+
+    asset_residency_state PrevState = Model->Residency.State;
+    Model->Residency.State = AssetResidency_Resident;
+
+    Platform->LeaveCriticalSection(Platform->PlatformHandle);
+
+    if (PrevState == AssetResidency_Resident)
+    {
+        RemoveModelFromRenderer(Model, RenderCommands);
+
+        if (!Model->Residency.Pinned)
+        {
+            RemoveFromLinkedList(Model);
+        }
+
+        // Model could have been replaced before
+        if (Model->Residency.Block)
+        {
+            FreeBlock(&Assets->AssetAllocator, Model->Residency.Block);
+        }
+
+        --Assets->ResidentModelCount;
+    }
+    else if (PrevState == AssetResidency_Loaded)
+    {
+        FreeBlock(&Assets->AssetAllocator, Model->Residency.Block);
+        --Assets->LoadingAssetCount;
+    }
+    else if (PrevState == AssetResidency_Loading)
+    {
+        // Job still writes into the block, it is freed once the job is done (see UpdateAssetResidency)
+        Model->Residency.ReleasedBlock = Model->Residency.Block;
+    }
+
+    // Mesh count can change, so the model gets new ids
+    Model->Residency.FirstMeshId = 0;
+    Model->Residency.FirstTextureId = 0;
+    Model->Residency.Block = 0;
+    Model->Residency.Pinned = true;
+
+    InitModel(State, Asset, Model, Name, &Assets->Arena, RenderCommands);
+
+    // Skinning and animation graphs of the entities point into the previous model data
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
+
+        if (!Entity->Destroyed && Entity->Model == Model)
+        {
+            ReleaseEntityModel(Area, Entity);
+            InitEntityModel(State, Entity, RenderCommands);
+        }
+    }
+
+    ++Assets->ResidentModelCount;
+}
+
+inline void
+AddModel(game_state *State, game_entity *Entity, game_assets *Assets, const char *ModelName, render_commands *RenderCommands)
+{
+    ReleaseEntityModel(&State->WorldArea, Entity);
+
+    Entity->Model = GetModelAsset(Assets, ModelName);
+
+    RequestModel(Entity->Model);
+
+    // Otherwise done once the model is streamed in
+    if (IsModelResident(Entity->Model))
+    {
+        InitEntityModel(State, Entity, RenderCommands);
+    }
+}
+
+inline void
+AddBoxCollider(world_area *Area, game_entity *Entity, vec3 HalfSize, mat4 Offset)
+{
+    Entity->Collider = PoolAllocate(&Area->Colliders);
+    Entity->Collider->Type = Collider_Box;
+    Entity->Collider->Box.HalfSize = HalfSize;
+    Entity->Collider->Box.Offset = Offset;
+
+    CalculateColliderState(Entity);
+
+    // todo:
+    if (Entity->Body)
+    {
+        Entity->Collider->Box.Body = Entity->Body;
+    }
+}
+
+inline void
+AddBoxCollider(world_area *Area, game_entity *Entity)
+{
+    Assert(Entity->Model);
+
+    aabb Bounds = Entity->Model->Bounds;
+
+    vec3 HalfSize = Bounds.HalfExtent;
+    mat4 Offset = Translate(Bounds.Center);
+
+    AddBoxCollider(Area, Entity, HalfSize, Offset);
+}
+
+inline void
+AddRigidBody(world_area *Area, game_entity *Entity)
+{
+    Entity->Body = PoolAllocate(&Area->Bodies);
+
+    f32 Mass = 10.f;
+    vec3 Size = vec3(1.f);
+
+    SetPosition(Entity->Body, Entity->Transform.Translation);
+    SetOrientation(Entity->Body, Entity->Transform.Rotation);
+    SetMass(Entity->Body, Mass);
+    SetCenterOfMass(Entity->Body, vec3(0.f));
+    SetInertiaTensor(Entity->Body, GetCuboidInertiaTensor(Mass, Size));
+    SetLinearDamping(Entity->Body, 0.95f);
+    SetAngularDamping(Entity->Body, 0.8f);
+
+    CalculateRigidBodyState(Entity->Body);
+
+    // todo:
+    if (Entity->Collider)
+    {
+        Entity->Collider->Box.Body = Entity->Body;
+    }
+}
+
+inline void
+AddPointLight(world_area *Area, game_entity *Entity, vec3 Color, light_attenuation Attenuation)
+{
+    Entity->PointLight = PoolAllocate(&Area->PointLights);
+    Entity->PointLight->Position = Entity->Transform.Translation;
+    Entity->PointLight->Color = Color;
+    Entity->PointLight->Attenuation = Attenuation;
+}
+
+inline void
+AddParticleEmitter(world_area *Area, game_entity *Entity, u32 ParticleCount, u32 ParticlesSpawn, vec4 Color, vec2 Size)
+{
+    Entity->ParticleEmitter = PoolAllocate(&Area->ParticleEmitters);
+    Entity->ParticleEmitter->ParticleCount = ParticleCount;
+    Entity->ParticleEmitter->Particles = (particle *)HeapAllocate(&Area->Heap, ParticleCount * sizeof(particle));
+    Assert(Entity->ParticleEmitter->Particles);
+    ClearMemory(Entity->ParticleEmitter->Particles, ParticleCount * sizeof(particle));
+    Entity->ParticleEmitter->ParticlesSpawn = ParticlesSpawn;
+    Entity->ParticleEmitter->Color = Color;
+    Entity->ParticleEmitter->Size = Size;
+    Entity->ParticleEmitter->NextParticleIndex = 0;
+}
+
+inline void
+AddAudioSource(game_state *State, game_entity *Entity, audio_clip *AudioClip, vec3 Position, f32 Volume, f32 MinDistance, f32 MaxDistance, audio_commands *AudioCommands)
+{
+    Entity->AudioSource = PoolAllocate(&State->WorldArea.AudioSources);
+    Entity->AudioSource->AudioClip = AudioClip;
+    Entity->AudioSource->Volume = Volume;
+    Entity->AudioSource->MinDistance = MinDistance;
+    Entity->AudioSource->MaxDistance = MaxDistance;
+    Entity->AudioSource->IsPlaying = true;
+    Entity->AudioSource->Id = GenerateAudioSourceId(State);
+    Entity->AudioSource->Pending = false;
+
+    RequestAudioClip(AudioClip);
+
+    if (IsAudioClipResident(AudioClip))
+    {
+        // todo:
+        bool32 IsLooping = true;
+        Play3D(AudioCommands, AudioClip, Position, MinDistance, MaxDistance, SetAudioPlayOptions(Volume, IsLooping), Entity->AudioSource->Id);
+    }
+    else
+    {
+        // Started once the clip is streamed in (see StartPendingAudioSources)
+        Entity->AudioSource->Pending = true;
+    }
+}
+
+inline void
+CopyGameEntity(game_state *State, render_commands *RenderCommands, audio_commands *AudioCommands, game_entity *Source, game_entity *Dest)
+{
+    world_area *Area = &State->WorldArea;
+
+    Dest->Transform = Source->Transform;
+
+    if (Source->Model)
+    {
+        AddModel(State, Dest, &State->Assets, Source->Model->Key, RenderCommands);
+    }
+
+    if (Source->Collider)
+    {
+        Assert(Source->Collider->Type == Collider_Box);
+
+        switch (Source->Collider->Type)
+        {
+            case Collider_Box:
+            {
+                AddBoxCollider(Area, Dest, Source->Collider->Box.HalfSize, Source->Collider->Box.Offset);
+                break;
+            }
+            default:
+            {
+                Assert(!"Invalid collider type");
+            }
+        }
+
+        
+    }
+
+    if (Source->Body)
+    {
+        AddRigidBody(Area, Dest);
+    }
+
+    if (Source->PointLight)
+    {
+        AddPointLight(Area, Dest, Source->PointLight->Color, Source->PointLight->Attenuation);
+    }
+
+    if (Source->ParticleEmitter)
+    {
+        AddParticleEmitter(Area, Dest, Source->ParticleEmitter->ParticleCount, Source->ParticleEmitter->ParticlesSpawn, Source->ParticleEmitter->Color, Source->ParticleEmitter->Size);
+    }
+
+    if (Source->AudioSource)
+    {
+        AddAudioSource(State, Dest, Source->AudioSource->AudioClip, Source->Transform.Translation, Source->AudioSource->Volume, Source->AudioSource->MinDistance, Source->AudioSource->MaxDistance, AudioCommands);
+    }
+}
+
+dummy_internal void *
+GetAnimatorParams(game_state *State, game_input *Input, game_entity *Entity, memory_arena *Arena)
+{
+    void *Params = 0;
+
+    switch (SID(Entity->Animation->Animator))
+    {
+        case SID("Bot"):
+        {
+            Params = PushType(Arena, bot_animator_params);
+
+            if (State->Player == Entity && State->Mode == GameMode_World)
+            {
+                GameInput2BotAnimatorParams(State, Input, Entity, (bot_animator_params *)Params);
+            }
+            else
+            {
+                GameLogic2BotAnimatorParams(State, Entity, (bot_animator_params *)Params);
+            }
+
+            break;
+        }
+        case SID("Paladin"):
+        {
+            Params = PushType(Arena, paladin_animator_params);
+
+            if (State->Player == Entity && State->Mode == GameMode_World)
+            {
+                GameInput2PaladinAnimatorParams(State, Input, Entity, (paladin_animator_params *)Params);
+            }
+            else
+            {
+                GameLogic2PaladinAnimatorParams(State, Entity, (paladin_animator_params *)Params);
+            }
+
+            break;
+        }
+        case SID("Monstar"):
+        {
+            Params = PushType(Arena, monstar_animator_params);
+
+            if (State->Player == Entity && State->Mode == GameMode_World)
+            {
+                GameInput2MonstarAnimatorParams(State, Input, Entity, (monstar_animator_params *)Params);
+            }
+            else
+            {
+                GameLogic2MonstarAnimatorParams(State, Entity, (monstar_animator_params *)Params);
+            }
+
+            break;
+        }
+        default:
+        {
+            Assert(!"Animator is not supported");
+            break;
+        }
+    }
+
+    return Params;
+}
+
+dummy_internal void
+AnimateEntity(game_state *State, game_input *Input, game_entity *Entity, memory_arena *Arena, f32 Delta)
+{
+    Assert(Entity->Skinning);
+
+    skeleton_pose *Pose = Entity->Skinning->Pose;
+    skeleton_pose *BindPose = Entity->Skinning->BindPose;
+    transform *Root = GetRootLocalJointPose(Pose);
+
+    if (Entity->Animation)
+    {
+        void *Params = GetAnimatorParams(State, Input, Entity, Arena);
+
+        AnimatorPerFrameUpdate(&State->Animator, Entity->Animation, Params, Delta);
+        AnimationGraphPerFrameUpdate(Entity->Animation, Delta);
+        CalculateSkeletonPose(Entity->Animation, BindPose, Pose, Entity->Id, &State->EventList, Arena);
+
+        // Root Motion
+        Entity->Animation->AccRootMotion.x += Pose->RootMotion.x;
+        Entity->Animation->AccRootMotion.z += Pose->RootMotion.z;
+
+        vec3 ScaledRootMotion = Entity->Animation->AccRootMotion * Entity->Transform.Scale;
+        vec3 RotatedScaledRootMotion = Rotate(ScaledRootMotion, Entity->Transform.Rotation);
+
+#if 1
+        if (Entity->Body)
+        {
+            if (NearlyEqual(Entity->Body->Velocity.x, 0.f))
+            {
+                Entity->Body->Position.x += RotatedScaledRootMotion.x;
+            }
+
+            if (NearlyEqual(Entity->Body->Velocity.z, 0.f))
+            {
+                Entity->Body->Position.z += RotatedScaledRootMotion.z;
+            }
+        }
+#endif
+
+        Entity->Animation->AccRootMotion = vec3(0.f);
+    }
+
+    Root->Translation = Entity->Transform.Translation;
+    Root->Rotation = Entity->Transform.Rotation;
+    Root->Scale = Entity->Transform.Scale;
+
+    UpdateGlobalJointPoses(Pose);
+    UpdateSkinningMatrices(Entity->Skinning);
+}
+
+JOB_ENTRY_POINT(ParallelForJob)
+{
+    parallel_for_job *Data = (parallel_for_job *) Parameters;
+    parallel_for *Loop = Data->Loop;
+    platform_profiler *Profiler = Queue->Profiler;
+
+    u64 StartTimestamp = Profiler->GetTimestamp();
+
+    while (true)
+    {
+        u64 StartIndex = AtomicAdd(&Loop->NextIndex, Loop->ChunkSize) - Loop->ChunkSize;
+
+        if (StartIndex >= Loop->ItemCount)
+        {
+            break;
+        }
+
+        u64 EndIndex = StartIndex + Loop->ChunkSize;
+
+        if (EndIndex > Loop->ItemCount)
+        {
+            EndIndex = Loop->ItemCount;
+        }
+
+        scoped_memory ScopedMemory(&Data->Arena);
+        Loop->EntryPoint(Loop->Parameters, (u32) StartIndex, (u32) EndIndex, ScopedMemory.Arena);
+    }
+
+    AtomicAdd(&Loop->Ticks, Profiler->GetTimestamp() - StartTimestamp);
+}
+
+/*
+    Runs EntryPoint over [0, ItemCount) on the job queue and waits for it.
+    Site keeps the measured cost per item of the call site, which decides how many jobs are kicked and how big the chunks are.
+    Every job gets ArenaSizePerJob of scratch memory, reset after every chunk.
+*/
+dummy_internal void
+ParallelFor(
+    platform_api *Platform,
+    job_queue *JobQueue,
+    parallel_for_site *Site,
+    const char *Name,
+    u32 ItemCount,
+    parallel_for_entry_point *EntryPoint,
+    void *Parameters,
+    memory_arena *Arena,
+    umm ArenaSizePerJob = 0
+)
+{
+    if (ItemCount > 0)
+    {
+        scoped_memory ScopedMemory(Arena);
+
+        f32 ChunkTicks = GetParallelForChunkTicks(JobQueue, JobQueue->Profiler->TicksPerSecond);
+        u32 JobCount = GetParallelForJobCount(Site, ItemCount, JobQueue->WorkerCount, ChunkTicks);
+
+        parallel_for *Loop = PushType(ScopedMemory.Arena, parallel_for);
+        Loop->EntryPoint = EntryPoint;
+        Loop->Parameters = Parameters;
+        Loop->ItemCount = ItemCount;
+        Loop->ChunkSize = GetParallelForChunkSize(Site, ItemCount, JobCount, ChunkTicks);
+        Loop->NextIndex = 0;
+        Loop->Ticks = 0;
+
+        job *Jobs = PushArray(ScopedMemory.Arena, JobCount, job);
+        parallel_for_job *JobParams = PushArray(ScopedMemory.Arena, JobCount, parallel_for_job);
+
+        for (u32 JobIndex = 0; JobIndex < JobCount; ++JobIndex)
+        {
+            job *Job = Jobs + JobIndex;
+            parallel_for_job *JobData = JobParams + JobIndex;
+
+            JobData->Loop = Loop;
+
+            if (ArenaSizePerJob > 0)
+            {
+                JobData->Arena = SubMemoryArena(ScopedMemory.Arena, ArenaSizePerJob, NoClear());
+            }
+
+            Job->EntryPoint = ParallelForJob;
+            Job->Parameters = JobData;
+            Job->Name = Name;
+        }
+
+        // Not worth waking up the workers
+        if (JobCount == 1)
+        {
+            ParallelForJob(JobQueue, JobParams);
+        }
+        else
+        {
+            Platform->KickJobsAndWait(JobQueue, JobCount, Jobs);
+        }
+
+        UpdateParallelForSite(Site, Loop, JobCount);
+    }
+}
+
+struct update_entity_range
+{
+    f32 UpdateRate;
+    u32 PlayerId;
+    u32 MaxGroundProbeEntityCount;
+    u32 MaxNearbyEntityCount;
+    game_entity *Entities;
+    spatial_hash_grid *SpatialGrid;
+    random_sequence *Entropy;
+    game_state *State;
+    platform_api *Platform;
+};
+
+PARALLEL_FOR_ENTRY_POINT(UpdateEntityRange)
+{
+    update_entity_range *Data = (update_entity_range *) Parameters;
+
+    game_state *State = Data->State;
+    platform_api *Platform = Data->Platform;
+    contact_resolver *ContactResolver = &State->ContactResolver;
+
+    f32 dt = Data->UpdateRate;
+
+    for (u32 EntityIndex = StartIndex; EntityIndex < EndIndex; ++EntityIndex)
+    {
+        game_entity *Entity = Data->Entities + EntityIndex;
+        scoped_memory ScopedMemory(Arena);
+
+        if (!Entity->Destroyed)
+        {
+            rigid_body *Body = Entity->Body;
+            collider *Collider = Entity->Collider;
+
+            if (Body)
+            {
+                bool32 OnTheGround = NearlyEqual(Entity->Body->Position.y, 0.f);
 
                 if (Collider)
                 {
@@ -1203,591 +2669,1380 @@ JOB_ENTRY_POINT(UpdateEntityBatchJob)
                     {
                         aabb EntityBounds = Entity->Collider->Bounds;
 
-                        //
-                        vec3 Acceleration = Body->Acceleration + Body->ForceAccumulator * Body->InverseMass;
-                        vec3 Velocity = Body->Velocity + Body->Acceleration * dt;
-                        Velocity *= Power(Body->LinearDamping, dt);
-                        Velocity *= dt;
-                        //
+                        //
+                        vec3 Acceleration = Body->Acceleration + Body->ForceAccumulator * Body->InverseMass;
+                        vec3 Velocity = Body->Velocity + Body->Acceleration * dt;
+                        Velocity *= Power(Body->LinearDamping, dt);
+                        Velocity *= dt;
+                        //
+
+                        f32 CollisionTime;
+                        vec3 ContactPoint;
+                        if (IntersectMovingAABBPlane(EntityBounds, State->Ground, Velocity, &CollisionTime, &ContactPoint) && InRange(CollisionTime, 0.f, 1.f))
+                        {
+                            //Body->Position.y = ContactPoint.y;
+                            OnTheGround = true;
+                        }
+                    }
+#else
+                    if (TestBoxPlane(&Collider->Box, State->Ground))
+                    {
+                        OnTheGround = true;
+                    }
+#endif
+                }
+
+                u32 MaxNearbyEntityCount = Data->MaxGroundProbeEntityCount;
+                game_entity **NearbyEntities = PushArray(ScopedMemory.Arena, MaxNearbyEntityCount, game_entity *);
+                aabb Bounds = CreateAABBMinMax(vec3(0.f, -0.01f, 0.f), vec3(0.f, 0.f, 0.f));
+
+                u32 NearbyEntityCount = FindNearbyEntities(Data->SpatialGrid, Entity, Bounds, NearbyEntities, MaxNearbyEntityCount);
+
+                f32 MinDistance = F32_MAX;
+
+                for (u32 NearbyEntityIndex = 0; NearbyEntityIndex < NearbyEntityCount; ++NearbyEntityIndex)
+                {
+                    game_entity *NearbyEntity = NearbyEntities[NearbyEntityIndex];
+                    collider *NearbyBodyCollider = NearbyEntity->Collider;
+
+                    if (NearbyBodyCollider)
+                    {
+                        ray Ray = {};
+                        Ray.Origin = Body->Position;
+                        Ray.Direction = vec3(0.f, -1.f, 0.f);
+
+                        vec3 IntersectionPoint;
+                        if (IntersectRayAABB(Ray, NearbyEntity->Collider->Bounds, IntersectionPoint))
+                        {
+                            f32 Distance = Magnitude(Body->Position - IntersectionPoint);
+
+                            if (Distance < MinDistance)
+                            {
+                                MinDistance = Distance;
+                            }
+                        }
+                    }
+                }
+
+                bool32 OnTheSurface = (MinDistance <= 0.01f);
+
+                Entity->IsGrounded = (OnTheGround || OnTheSurface);
+
+                // todo:
+#if 1
+                Body->PrevPosition = Body->Position;
+                Body->PrevVelocity = Body->Velocity;
+                Body->PrevAcceleration = Body->Acceleration;
+#endif
+
+                if (Entity->IsGrounded)
+                {
+                    if (Body->Position.y < 0.f)
+                    {
+                        Body->Position.y = 0.f;
+                    }
+
+                    if (Body->Velocity.y < 0.f)
+                    {
+                        Body->Velocity.y = 0.f;
+                    }
+
+                    if (Body->Acceleration.y < 0.f)
+                    {
+                        Body->Acceleration.y = 0.f;
+                    }
+                }
+
+                if (!Entity->IsGrounded && !Entity->IsManipulated)
+                {
+                    vec3 Gravity = vec3(0.f, -20.f, 0.f) * GetMass(Body);
+;                   AddForce(Body, Gravity);
+                }
+
+                vec2 HorizontalVelocity = vec2(Body->Velocity.x, Body->Velocity.z);
+
+                if (Entity->IsGrounded && Magnitude(HorizontalVelocity) > 0.f)
+                {
+                    vec3 Drag = -10.f * Body->Velocity * Max(Magnitude(HorizontalVelocity), 5.f);
+                    Drag.y = 0.f;
+                    AddForce(Body, Drag);
+                }
+
+                Integrate(Body, dt);
+
+                if (Collider)
+                {
+                    CalculateColliderState(Entity);
+
+                    // Collisions with nearby entities
+                    u32 MaxNearbyEntityCount = Data->MaxNearbyEntityCount;
+                    game_entity **NearbyEntities = PushArray(ScopedMemory.Arena, MaxNearbyEntityCount, game_entity *);
+                    aabb Bounds = CreateAABBMinMax(vec3(-1.0f), vec3(1.0f));
+
+                    u32 NearbyEntityCount = FindNearbyEntities(Data->SpatialGrid, Entity, Bounds, NearbyEntities, MaxNearbyEntityCount);
+
+                    for (u32 NearbyEntityIndex = 0; NearbyEntityIndex < NearbyEntityCount; ++NearbyEntityIndex)
+                    {
+                        game_entity *NearbyEntity = NearbyEntities[NearbyEntityIndex];
+                        rigid_body *NearbyBody = NearbyEntity->Body;
+                        collider *NearbyBodyCollider = NearbyEntity->Collider;
+
+                        if (NearbyEntity->Id == Entity->Id) continue;
+
+#if 0
+                        if (Entity->Id == Data->PlayerId)
+                        {
+                            NearbyEntity->DebugColor = vec3(0.f, 1.f, 0.f);
+                        }
+#endif
+
+                        if (NearbyBodyCollider)
+                        {
+                            //CalculateColliderInternalState(Entity);
+                            //CalculateColliderInternalState(NearbyEntity);
+                            vec3 mtv;
+                            if (TestAABBAABB(Collider->Bounds, NearbyBodyCollider->Bounds, &mtv))
+                            {
+                                Body->Position += mtv;
+                            }
+#if 0
+                            if (TestBoxBox(&Collider->Box, &NearbyBodyCollider->Box))
+                            {
+                                //Entity->DebugColor = vec3(0.f, 1.f, 0.f);
+                                //NearbyEntity->DebugColor = vec3(0.f, 1.f, 0.f);
+
+                                contact_params ContactParams =
+                                {
+                                    .Friction = 0.6f,
+                                    .Restitution = 0.2f
+                                };
+                                u32 ContactCount = CalculateBoxBoxContacts(&Collider->Box, &NearbyBodyCollider->Box, ContactResolver->Contacts + ContactResolver->ContactCount, ContactParams);
+                                ContactResolver->ContactCount += ContactCount;
+
+                                Assert(ContactResolver->ContactCount < ContactResolver->MaxContactCount);
+                            }
+#endif
+                        }
+                    }
+                }
+            }
+
+            if (Entity->ParticleEmitter)
+            {
+                particle_emitter *ParticleEmitter = Entity->ParticleEmitter;
+
+                for (u32 ParticleSpawnIndex = 0; ParticleSpawnIndex < ParticleEmitter->ParticlesSpawn; ++ParticleSpawnIndex)
+                {
+                    particle *Particle = ParticleEmitter->Particles + ParticleEmitter->NextParticleIndex++;
+
+                    if (ParticleEmitter->NextParticleIndex >= ParticleEmitter->ParticleCount)
+                    {
+                        ParticleEmitter->NextParticleIndex = 0;
+                    }
+
+                    random_sequence *Entropy = Data->Entropy;
+
+                    Particle->Position = Entity->Transform.Translation + vec3(
+                        RandomBetween(Entropy, -0.05f, 0.05f),
+                        RandomBetween(Entropy, 0.f, 0.1f),
+                        RandomBetween(Entropy, -0.05f, 0.05f)
+                    );
+                    Particle->Velocity = Rotate(vec3(RandomBetween(Entropy, -0.5f, 0.5f), RandomBetween(Entropy, 3.f, 6.f), RandomBetween(Entropy, -0.5f, 0.5f)), Entity->Transform.Rotation);
+                    Particle->Acceleration = Rotate(vec3(0.f, -10.f, 0.f), Entity->Transform.Rotation);
+                    Particle->Color = ParticleEmitter->Color;
+                    Particle->dColor = vec4(0.f, 0.f, 0.f, -0.5f);
+                    Particle->Size = ParticleEmitter->Size;
+                    Particle->dSize = vec2(-0.1f);
+                }
+            }
+        }
+    }
+}
+
+struct animate_entity_range
+{
+    game_state *State;
+    game_input *Input;
+    game_entity **Entities;
+    f32 *Deltas;
+};
+
+PARALLEL_FOR_ENTRY_POINT(AnimateEntityRange)
+{
+    animate_entity_range *Data = (animate_entity_range *) Parameters;
+
+    for (u32 EntityIndex = StartIndex; EntityIndex < EndIndex; ++EntityIndex)
+    {
+        scoped_memory ScopedMemory(Arena);
+        AnimateEntity(Data->State, Data->Input, Data->Entities[EntityIndex], ScopedMemory.Arena, Data->Deltas[EntityIndex]);
+    }
+}
+
+struct process_entity_range
+{
+    f32 Lag;
+    game_entity *Entities;
+    spatial_hash_grid *SpatialGrid;
+
+    u32 ShadowPlaneCount;
+    plane *ShadowPlanes;
+
+    vec3 CameraPosition;
+    // Pixels covered by a unit length at a unit distance from the camera
+    f32 LodProjectionScale;
+    f32 MaxLodScreenError;
+};
+
+PARALLEL_FOR_ENTRY_POINT(ProcessEntityRange)
+{
+    process_entity_range *Data = (process_entity_range *) Parameters;
+
+    for (u32 EntityIndex = StartIndex; EntityIndex < EndIndex; ++EntityIndex)
+    {
+        game_entity *Entity = Data->Entities + EntityIndex;
+
+        if (!Entity->Destroyed)
+        {
+            UpdateInSpacialGrid(Data->SpatialGrid, Entity);
+
+            if (Entity->Body)
+            {
+                Entity->Transform.Translation = Lerp(Entity->Body->PrevPosition, Data->Lag, Entity->Body->Position);
+                Entity->Transform.Rotation = Entity->Body->Orientation;
+            }
+
+            if (Entity->Collider)
+            {
+                CalculateColliderState(Entity);
+            }
+
+            if (Entity->Model)
+            {
+                aabb BoundingBox = GetEntityBounds(Entity);
+
+                // Frustrum culling
+                Entity->Visible = AxisAlignedBoxVisible(Data->ShadowPlaneCount, Data->ShadowPlanes, BoundingBox);
+
+                Entity->LodIndex = SelectModelLod(Entity->Model, Entity, BoundingBox, Data->CameraPosition, Data->LodProjectionScale, Data->MaxLodScreenError);
+                Entity->ClusterRanges = 0;
+            }
+        }
+    }
+}
+
+struct rasterize_occlusion_band_job
+{
+    occlusion_buffer *Buffer;
+    u32 BandIndex;
+};
+
+JOB_ENTRY_POINT(RasterizeOcclusionBandJob)
+{
+    rasterize_occlusion_band_job *Data = (rasterize_occlusion_band_job *) Parameters;
+    RasterizeOcclusionBand(Data->Buffer, Data->BandIndex);
+}
 
-                        f32 CollisionTime;
-                        vec3 ContactPoint;
-                        if (IntersectMovingAABBPlane(EntityBounds, State->Ground, Velocity, &CollisionTime, &ContactPoint) && InRange(CollisionTime, 0.f, 1.f))
-                        {
-                            //Body->Position.y = ContactPoint.y;
-                            OnTheGround = true;
-                        }
-                    }
-#else
-                    if (TestBoxPlane(&Collider->Box, State->Ground))
-                    {
-                        OnTheGround = true;
-                    }
-#endif
-                }
+struct test_entity_occlusion_range
+{
+    game_entity *Entities;
+    occlusion_buffer *Buffer;
+};
+
+PARALLEL_FOR_ENTRY_POINT(TestEntityOcclusionRange)
+{
+    test_entity_occlusion_range *Data = (test_entity_occlusion_range *) Parameters;
+
+    for (u32 EntityIndex = StartIndex; EntityIndex < EndIndex; ++EntityIndex)
+    {
+        game_entity *Entity = Data->Entities + EntityIndex;
+
+        // Occluders are never hidden, otherwise they would hide themselves
+        if (!Entity->Destroyed && Entity->Model && Entity->Visible && !IsOccluder(Entity))
+        {
+            Entity->Occluded = AxisAlignedBoxOccluded(Data->Buffer, GetEntityBounds(Entity));
+        }
+    }
+}
+
+struct cull_mesh_clusters_item
+{
+    mesh *Mesh;
+    transform Transform;
+    mesh_cluster_ranges *Ranges;
+
+    u32 VisibleClusterCount;
+};
+
+struct cull_mesh_clusters_range
+{
+    cull_mesh_clusters_item *Items;
+    u32 PlaneCount;
+    plane *Planes;
+    vec3 CameraPosition;
+};
+
+PARALLEL_FOR_ENTRY_POINT(CullMeshClustersRange)
+{
+    cull_mesh_clusters_range *Data = (cull_mesh_clusters_range *) Parameters;
+
+    for (u32 ItemIndex = StartIndex; ItemIndex < EndIndex; ++ItemIndex)
+    {
+        cull_mesh_clusters_item *Item = Data->Items + ItemIndex;
+
+        Item->VisibleClusterCount = CullMeshClusters(Item->Mesh, Item->Transform, Data->PlaneCount, Data->Planes, Data->CameraPosition, Item->Ranges);
+    }
+}
+
+struct bin_point_lights_job
+{
+    light_cluster_grid *Grid;
+    u32 SliceIndex;
+    u32 LightCount;
+    point_light_bounds *LightBounds;
+    bool32 WriteIndices;
+};
+
+JOB_ENTRY_POINT(BinPointLightsJob)
+{
+    bin_point_lights_job *Data = (bin_point_lights_job *) Parameters;
+
+    BinPointLightsInSlice(Data->Grid, Data->SliceIndex, Data->LightCount, Data->LightBounds, Data->WriteIndices);
+}
+
+struct process_particles_range
+{
+    particle_emitter **ParticleEmitters;
+    vec3 CameraPosition;
+    f32 Delta;
+};
+
+PARALLEL_FOR_ENTRY_POINT(ProcessParticlesRange)
+{
+    process_particles_range *Data = (process_particles_range *) Parameters;
+
+    for (u32 EmitterIndex = StartIndex; EmitterIndex < EndIndex; ++EmitterIndex)
+    {
+        particle_emitter *ParticleEmitter = Data->ParticleEmitters[EmitterIndex];
+
+        for (u32 ParticleIndex = 0; ParticleIndex < ParticleEmitter->ParticleCount; ++ParticleIndex)
+        {
+            particle *Particle = ParticleEmitter->Particles + ParticleIndex;
+
+            f32 dt = Data->Delta;
+
+            Particle->Position += 0.5f * Particle->Acceleration * Square(dt) + Particle->Velocity * dt;
+            Particle->Velocity += Particle->Acceleration * dt;
+            Particle->Color += Particle->dColor * dt;
+            Particle->Size += Particle->dSize * dt;
+
+            Particle->Color.a = Max(Particle->Color.a, 0.f);
+            Particle->Size.x = Max(Particle->Size.x, 0.f);
+            Particle->Size.y = Max(Particle->Size.y, 0.f);
+
+            Particle->CameraDistanceSquared = SquaredMagnitude(Particle->Position - Data->CameraPosition);
+        }
+
+        SortParticles(ParticleEmitter->ParticleCount, ParticleEmitter->Particles);
+    }
+}
+
+// Called on init and after every reload, the values are kept by the registry
+dummy_internal void
+RegisterGameCVars(game_state *State, cvar_registry *Registry)
+{
+    game_cvars *CVars = &State->CVars;
+
+    CVars->ClusterCullingBatchThreshold = RegisterCVarInt(
+        Registry, "render.cluster_culling_batch_threshold", 1, 0, 1024,
+        "Batches with up to this many entities are drawn one by one with cluster culling, larger ones are instanced"
+    );
+    CVars->MaxGroundProbeEntityCount = RegisterCVarInt(
+        Registry, "physics.max_ground_probe_entities", 10, 1, 1024,
+        "Nearby entities tested for the surface below a body"
+    );
+    CVars->MaxNearbyEntityCount = RegisterCVarInt(
+        Registry, "physics.max_nearby_entities", 100, 1, 4096,
+        "Nearby entities tested for the collisions with a body"
+    );
+    CVars->SpatialGridCellSize = RegisterCVarFloat(
+        Registry, "world.spatial_grid_cell_size", 5.f, 0.5f, 100.f,
+        "Size of the spatial grid cells, applied when the next world area is loaded"
+    );
+    CVars->AnimationArenaSize = RegisterCVarInt(
+        Registry, "anim.arena_size_kb", 512, 64, 16384,
+        "Scratch memory of each animation job"
+    );
+}
+
+dummy_internal void
+InitGameMenu(game_state *State)
+{
+    State->MenuQuads[0].Corner = 0;
+    State->MenuQuads[0].Move = 0.f;
+    State->MenuQuads[0].Color = vec4(1.f, 0.f, 0.f, 1.f);
+
+    State->MenuQuads[1].Corner = 1;
+    State->MenuQuads[1].Move = 0.f;
+    State->MenuQuads[1].Color = vec4(0.f, 1.f, 0.f, 1.f);
+
+    State->MenuQuads[2].Corner = 2;
+    State->MenuQuads[2].Move = 0.f;
+    State->MenuQuads[2].Color = vec4(0.f, 0.f, 1.f, 1.f);
+
+    State->MenuQuads[3].Corner = 3;
+    State->MenuQuads[3].Move = 0.f;
+    State->MenuQuads[3].Color = vec4(1.f, 1.f, 0.f, 1.f);
+}
+
+inline void
+LoadAnimators(animator *Animator)
+{
+    animator_controller *BotController = HashTableLookup(&Animator->Controllers, (char *) "Bot");
+    BotController->Func = BotAnimatorController;
+
+    animator_controller *PaladinController = HashTableLookup(&Animator->Controllers, (char *) "Paladin");
+    PaladinController->Func = PaladinAnimatorController;
+
+    animator_controller *MonstarController = HashTableLookup(&Animator->Controllers, (char *) "Monstar");
+    MonstarController->Func = MonstarAnimatorController;
+
+    animator_controller *SimpleController = HashTableLookup(&Animator->Controllers, (char *) "Simple");
+    SimpleController->Func = SimpleAnimatorController;
+}
+
+inline void
+Entity2Spec(game_entity *Entity, game_entity_spec *Spec)
+{
+    CopyString(Entity->Name, Spec->Name);
+    Spec->Transform = Entity->Transform;
+    Spec->DebugColor = Entity->DebugColor;
+
+    if (Entity->Model)
+    {
+        Model2Spec(Entity->Model, &Spec->ModelSpec);
+    }
+
+    if (Entity->Collider)
+    {
+        Collider2Spec(Entity->Collider, &Spec->ColliderSpec);
+    }
+
+    if (Entity->Body)
+    {
+        RigidBody2Spec(Entity->Body, &Spec->RigidBodySpec);
+    }
+
+    if (Entity->PointLight)
+    {
+        PointLight2Spec(Entity->PointLight, &Spec->PointLightSpec);
+    }
+
+    if (Entity->ParticleEmitter)
+    {
+        ParticleEmitter2Spec(Entity->ParticleEmitter, &Spec->ParticleEmitterSpec);
+    }
+
+    if (Entity->AudioSource)
+    {
+        AudioSource2Spec(Entity->AudioSource, &Spec->AudioSourceSpec);
+    }
+}
+
+dummy_internal void
+Spec2Entity(game_entity_spec *Spec, game_entity *Entity, game_state *State, render_commands *RenderCommands, audio_commands *AudioCommands)
+{
+    world_area *Area = &State->WorldArea;
+
+    CopyString(Spec->Name, Entity->Name);
+    Entity->Transform = Spec->Transform;
+
+    if (Spec->DebugColor != vec3(0.f))
+    {
+        Entity->DebugColor = Spec->DebugColor;
+    }
+
+    if (Spec->ModelSpec.Has)
+    {
+        model *Model = GetModelAsset(&State->Assets, Spec->ModelSpec.ModelRef);
+        AddModel(State, Entity, &State->Assets, Model->Key, RenderCommands);
+    }
+
+    if (Spec->ColliderSpec.Has)
+    {
+        collider_spec *ColliderSpec = &Spec->ColliderSpec;
+
+        switch (ColliderSpec->Type)
+        {
+            case Collider_Box:
+            {
+                AddBoxCollider(Area, Entity, ColliderSpec->Box.HalfSize, ColliderSpec->Box.Offset);
+                break;
+            }
+            default:
+            {
+                Assert(!"Not implemented");
+            }
+        }
+    }
+
+    if (Spec->RigidBodySpec.Has)
+    {
+        rigid_body_spec RigidBodySpec = Spec->RigidBodySpec;
+        AddRigidBody(Area, Entity);
+    }
+
+    if (Spec->PointLightSpec.Has)
+    {
+        point_light_spec PointLightSpec = Spec->PointLightSpec;
+        AddPointLight(Area, Entity, PointLightSpec.Color, PointLightSpec.Attenuation);
+    }
+
+    if (Spec->ParticleEmitterSpec.Has)
+    {
+        particle_emitter_spec ParticleEmitterSpec = Spec->ParticleEmitterSpec;
+        AddParticleEmitter(Area, Entity, ParticleEmitterSpec.ParticleCount, ParticleEmitterSpec.ParticlesSpawn, ParticleEmitterSpec.Color, ParticleEmitterSpec.Size);
+    }
+
+    if (Spec->AudioSourceSpec.Has)
+    {
+        audio_source_spec AudioSourceSpec = Spec->AudioSourceSpec;
+
+        audio_clip *AudioClip = GetAudioClipAsset(&State->Assets, Spec->AudioSourceSpec.AudioClipRef);
+        AddAudioSource(State, Entity, AudioClip, Entity->Transform.Translation, AudioSourceSpec.Volume, AudioSourceSpec.MinDistance, AudioSourceSpec.MaxDistance, AudioCommands);
+    }
+}
+
+inline ivec2
+GetWorldAreaChunkCount(aabb Bounds)
+{
+    vec3 Size = Bounds.HalfExtent * 2.f;
+
+    ivec2 Result = ivec2(Max(Ceil(Size.x / WORLD_AREA_CHUNK_SIZE), 1), Max(Ceil(Size.z / WORLD_AREA_CHUNK_SIZE), 1));
+    return Result;
+}
+
+inline u32
+GetWorldAreaChunkIndex(aabb Bounds, ivec2 ChunkCount, vec3 Position)
+{
+    vec3 BoundsMin = Bounds.Min();
+
+    i32 ChunkX = Min(Max(Floor((Position.x - BoundsMin.x) / WORLD_AREA_CHUNK_SIZE), 0), ChunkCount.x - 1);
+    i32 ChunkZ = Min(Max(Floor((Position.z - BoundsMin.z) / WORLD_AREA_CHUNK_SIZE), 0), ChunkCount.y - 1);
+
+    u32 Result = ChunkZ * ChunkCount.x + ChunkX;
+    return Result;
+}
+
+inline aabb
+GetWorldAreaChunkBounds(aabb Bounds, ivec2 ChunkCount, u32 ChunkIndex)
+{
+    vec3 BoundsMin = Bounds.Min();
+    vec3 BoundsMax = Bounds.Max();
+
+    f32 ChunkMinX = BoundsMin.x + (ChunkIndex % ChunkCount.x) * WORLD_AREA_CHUNK_SIZE;
+    f32 ChunkMinZ = BoundsMin.z + (ChunkIndex / ChunkCount.x) * WORLD_AREA_CHUNK_SIZE;
+
+    aabb Result = CreateAABBMinMax(
+        vec3(ChunkMinX, BoundsMin.y, ChunkMinZ),
+        vec3(ChunkMinX + WORLD_AREA_CHUNK_SIZE, BoundsMax.y, ChunkMinZ + WORLD_AREA_CHUNK_SIZE)
+    );
+    return Result;
+}
+
+// Components of the previous entities are gone as well
+inline void
+InitWorldAreaEntities(world_area *Area, u32 MaxEntityCount)
+{
+    Area->MaxEntityCount = MaxEntityCount;
+    Area->EntityCount = 0;
+    Area->Entities = PushArray(&Area->Arena, Area->MaxEntityCount, game_entity);
+
+    Area->FreeEntityCount = 0;
+    Area->FreeEntityIndices = PushArray(&Area->Arena, Area->MaxEntityCount, u32, NoClear());
+
+    InitMemoryPool(&Area->Colliders, MaxEntityCount, &Area->Arena);
+    InitMemoryPool(&Area->Bodies, MaxEntityCount, &Area->Arena);
+    InitMemoryPool(&Area->PointLights, MaxEntityCount, &Area->Arena);
+    InitMemoryPool(&Area->ParticleEmitters, MaxEntityCount, &Area->Arena);
+    InitMemoryPool(&Area->AudioSources, MaxEntityCount, &Area->Arena);
+
+    InitTLSFHeap(&Area->Heap, Area->Heap.Base, Area->Heap.Size);
+}
+
+/*
+    Builds the area in the chunked format (see world_area_file_header) in the arena.
+    Entities are grouped by chunk with a counting sort, then every chunk is written section by section.
+*/
+dummy_internal binary_writer
+BuildWorldAreaFile(game_state *State, memory_arena *Arena)
+{
+    world_area *Area = &State->WorldArea;
+
+    u32 EntityCount = 0;
+    umm MaxStringTableSize = 0;
+    vec3 BoundsMin = vec3(F32_MAX);
+    vec3 BoundsMax = vec3(-F32_MAX);
+
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
+
+        if (!Entity->Destroyed)
+        {
+            ++EntityCount;
 
-                u32 MaxNearbyEntityCount = 10;
-                game_entity **NearbyEntities = PushArray(&Data->Arena, MaxNearbyEntityCount, game_entity *);
-                aabb Bounds = CreateAABBMinMax(vec3(0.f, -0.01f, 0.f), vec3(0.f, 0.f, 0.f));
+            BoundsMin = Min(BoundsMin, Entity->Transform.Translation);
+            BoundsMax = Max(BoundsMax, Entity->Transform.Translation);
 
-                u32 NearbyEntityCount = FindNearbyEntities(Data->SpatialGrid, Entity, Bounds, NearbyEntities, MaxNearbyEntityCount);
+            MaxStringTableSize += StringLength(Entity->Name) + 1;
 
-                f32 MinDistance = F32_MAX;
+            if (Entity->Model)
+            {
+                MaxStringTableSize += StringLength(Entity->Model->Key) + 1;
+            }
 
-                for (u32 NearbyEntityIndex = 0; NearbyEntityIndex < NearbyEntityCount; ++NearbyEntityIndex)
-                {
-                    game_entity *NearbyEntity = NearbyEntities[NearbyEntityIndex];
-                    collider *NearbyBodyCollider = NearbyEntity->Collider;
+            if (Entity->AudioSource)
+            {
+                MaxStringTableSize += StringLength(Entity->AudioSource->AudioClip->Key) + 1;
+            }
+        }
+    }
 
-                    if (NearbyBodyCollider)
-                    {
-                        ray Ray = {};
-                        Ray.Origin = Body->Position;
-                        Ray.Direction = vec3(0.f, -1.f, 0.f);
+    aabb Bounds = EntityCount > 0 ? CreateAABBMinMax(BoundsMin, BoundsMax) : CreateAABBMinMax(vec3(0.f), vec3(0.f));
+    ivec2 ChunkGridSize = GetWorldAreaChunkCount(Bounds);
+    u32 GridChunkCount = ChunkGridSize.x * ChunkGridSize.y;
 
-                        vec3 IntersectionPoint;
-                        if (IntersectRayAABB(Ray, NearbyEntity->Collider->Bounds, IntersectionPoint))
-                        {
-                            f32 Distance = Magnitude(Body->Position - IntersectionPoint);
+    // Counting sort of the entities by chunk
+    u32 *EntityChunks = PushArray(Arena, Area->EntityCount, u32, NoClear());
+    u32 *ChunkEntityOffsets = PushArray(Arena, GridChunkCount + 1, u32);
+    u32 *SortedEntities = PushArray(Arena, EntityCount, u32, NoClear());
 
-                            if (Distance < MinDistance)
-                            {
-                                MinDistance = Distance;
-                            }
-                        }
-                    }
-                }
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
 
-                bool32 OnTheSurface = (MinDistance <= 0.01f);
+        if (!Entity->Destroyed)
+        {
+            EntityChunks[EntityIndex] = GetWorldAreaChunkIndex(Bounds, ChunkGridSize, Entity->Transform.Translation);
+            ++ChunkEntityOffsets[EntityChunks[EntityIndex] + 1];
+        }
+    }
 
-                Entity->IsGrounded = (OnTheGround || OnTheSurface);
+    u32 ChunkCount = 0;
+    u32 MaxChunkEntityCount = 0;
 
-                // todo:
-#if 1
-                Body->PrevPosition = Body->Position;
-                Body->PrevVelocity = Body->Velocity;
-                Body->PrevAcceleration = Body->Acceleration;
-#endif
+    for (u32 ChunkIndex = 0; ChunkIndex < GridChunkCount; ++ChunkIndex)
+    {
+        u32 ChunkEntityCount = ChunkEntityOffsets[ChunkIndex + 1];
 
-                if (Entity->IsGrounded)
-                {
-                    if (Body->Position.y < 0.f)
-                    {
-                        Body->Position.y = 0.f;
-                    }
+        if (ChunkEntityCount > 0)
+        {
+            ++ChunkCount;
 
-                    if (Body->Velocity.y < 0.f)
-                    {
-                        Body->Velocity.y = 0.f;
-                    }
+            if (ChunkEntityCount > MaxChunkEntityCount)
+            {
+                MaxChunkEntityCount = ChunkEntityCount;
+            }
+        }
 
-                    if (Body->Acceleration.y < 0.f)
-                    {
-                        Body->Acceleration.y = 0.f;
-                    }
-                }
+        ChunkEntityOffsets[ChunkIndex + 1] += ChunkEntityOffsets[ChunkIndex];
+    }
 
-                if (!Entity->IsGrounded && !Entity->IsManipulated)
-                {
-                    vec3 Gravity = vec3(0.f, -20.f, 0.f) * GetMass(Body);
-;                   AddForce(Body, Gravity);
-                }
+    {
+        u32 *NextChunkEntity = PushArray(Arena, GridChunkCount, u32, NoClear());
+        CopyMemory(ChunkEntityOffsets, NextChunkEntity, GridChunkCount * sizeof(u32));
 
-                vec2 HorizontalVelocity = vec2(Body->Velocity.x, Body->Velocity.z);
+        for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+        {
+            if (!Area->Entities[EntityIndex].Destroyed)
+            {
+                SortedEntities[NextChunkEntity[EntityChunks[EntityIndex]]++] = EntityIndex;
+            }
+        }
+    }
 
-                if (Entity->IsGrounded && Magnitude(HorizontalVelocity) > 0.f)
-                {
-                    vec3 Drag = -10.f * Body->Velocity * Max(Magnitude(HorizontalVelocity), 5.f);
-                    Drag.y = 0.f;
-                    AddForce(Body, Drag);
-                }
+    umm MaxSectionSizes[WorldAreaSection_Count] = {};
+    MaxSectionSizes[WorldAreaSection_Entities] = MAX_WORLD_ENTITY_RECORD_SIZE;
+    MaxSectionSizes[WorldAreaSection_Models] = sizeof(world_model_record);
+    MaxSectionSizes[WorldAreaSection_Colliders] = sizeof(world_collider_record);
+    MaxSectionSizes[WorldAreaSection_PointLights] = sizeof(world_point_light_record);
+    MaxSectionSizes[WorldAreaSection_ParticleEmitters] = sizeof(world_particle_emitter_record);
+    MaxSectionSizes[WorldAreaSection_AudioSources] = sizeof(world_audio_source_record);
 
-                Integrate(Body, dt);
+    umm MaxEntitySize = 0;
 
-                if (Collider)
-                {
-                    CalculateColliderState(Entity);
+    // Sections of the chunk that is being written
+    binary_writer Sections[WorldAreaSection_Count];
 
-                    // Collisions with nearby entities
-                    u32 MaxNearbyEntityCount = 100;
-                    game_entity **NearbyEntities = PushArray(&Data->Arena, MaxNearbyEntityCount, game_entity *);
-                    aabb Bounds = CreateAABBMinMax(vec3(-1.0f), vec3(1.0f));
+    for (u32 SectionIndex = 0; SectionIndex < WorldAreaSection_Count; ++SectionIndex)
+    {
+        Sections[SectionIndex] = CreateBinaryWriter(Arena, MaxChunkEntityCount * MaxSectionSizes[SectionIndex]);
+        MaxEntitySize += MaxSectionSizes[SectionIndex];
+    }
 
-                    u32 NearbyEntityCount = FindNearbyEntities(Data->SpatialGrid, Entity, Bounds, NearbyEntities, MaxNearbyEntityCount);
+    string_table_builder StringTable;
+    InitStringTableBuilder(&StringTable, EntityCount * 3, MaxStringTableSize, Arena);
 
-                    for (u32 NearbyEntityIndex = 0; NearbyEntityIndex < NearbyEntityCount; ++NearbyEntityIndex)
-                    {
-                        game_entity *NearbyEntity = NearbyEntities[NearbyEntityIndex];
-                        rigid_body *NearbyBody = NearbyEntity->Body;
-                        collider *NearbyBodyCollider = NearbyEntity->Collider;
+    binary_writer Writer = CreateBinaryWriter(
+        Arena,
+        sizeof(game_file_header) + sizeof(world_area_file_header) + ChunkCount * sizeof(world_area_file_chunk) +
+        EntityCount * MaxEntitySize + MaxStringTableSize
+    );
 
-                        if (NearbyEntity->Id == Entity->Id) continue;
+    game_file_header Header = {};
+    Header.MagicValue = GAME_FILE_MAGIC_VALUE;
+    Header.Version = WORLD_AREA_FILE_VERSION;
+    Header.EntityCount = EntityCount;
+    Header.Type = GameFile_Area;
 
-#if 0
-                        if (Entity->Id == Data->PlayerId)
-                        {
-                            NearbyEntity->DebugColor = vec3(0.f, 1.f, 0.f);
-                        }
-#endif
+    WriteValue(&Writer, Header);
 
-                        if (NearbyBodyCollider)
-                        {
-                            //CalculateColliderInternalState(Entity);
-                            //CalculateColliderInternalState(NearbyEntity);
-                            vec3 mtv;
-                            if (TestAABBAABB(Collider->Bounds, NearbyBodyCollider->Bounds, &mtv))
-                            {
-                                Body->Position += mtv;
-                            }
-#if 0
-                            if (TestBoxBox(&Collider->Box, &NearbyBodyCollider->Box))
-                            {
-                                //Entity->DebugColor = vec3(0.f, 1.f, 0.f);
-                                //NearbyEntity->DebugColor = vec3(0.f, 1.f, 0.f);
+    world_area_file_header *AreaHeader = (world_area_file_header *)(Writer.Base + Writer.Used);
+    Writer.Used += sizeof(world_area_file_header);
 
-                                contact_params ContactParams =
-                                {
-                                    .Friction = 0.6f,
-                                    .Restitution = 0.2f
-                                };
-                                u32 ContactCount = CalculateBoxBoxContacts(&Collider->Box, &NearbyBodyCollider->Box, ContactResolver->Contacts + ContactResolver->ContactCount, ContactParams);
-                                ContactResolver->ContactCount += ContactCount;
+    AreaHeader->Bounds = Bounds;
+    AreaHeader->ChunkCount = ChunkCount;
+    AreaHeader->ChunksOffset = Writer.Used;
 
-                                Assert(ContactResolver->ContactCount < ContactResolver->MaxContactCount);
-                            }
-#endif
-                        }
-                    }
-                }
-            }
+    world_area_file_chunk *Chunks = (world_area_file_chunk *)(Writer.Base + Writer.Used);
+    Writer.Used += ChunkCount * sizeof(world_area_file_chunk);
 
-            if (Entity->ParticleEmitter)
+    u32 FileChunkIndex = 0;
+
+    for (u32 ChunkIndex = 0; ChunkIndex < GridChunkCount; ++ChunkIndex)
+    {
+        u32 FirstEntity = ChunkEntityOffsets[ChunkIndex];
+        u32 ChunkEntityCount = ChunkEntityOffsets[ChunkIndex + 1] - FirstEntity;
+
+        if (ChunkEntityCount > 0)
+        {
+            world_area_file_chunk *Chunk = Chunks + FileChunkIndex++;
+
+            Chunk->Bounds = GetWorldAreaChunkBounds(Bounds, ChunkGridSize, ChunkIndex);
+            Chunk->EntityCount = ChunkEntityCount;
+
+            for (u32 SectionIndex = 0; SectionIndex < WorldAreaSection_Count; ++SectionIndex)
             {
-                particle_emitter *ParticleEmitter = Entity->ParticleEmitter;
+                Sections[SectionIndex].Used = 0;
+            }
 
-                for (u32 ParticleSpawnIndex = 0; ParticleSpawnIndex < ParticleEmitter->ParticlesSpawn; ++ParticleSpawnIndex)
-                {
-                    particle *Particle = ParticleEmitter->Particles + ParticleEmitter->NextParticleIndex++;
+            for (u32 Index = FirstEntity; Index < FirstEntity + ChunkEntityCount; ++Index)
+            {
+                game_entity *Entity = Area->Entities + SortedEntities[Index];
 
-                    if (ParticleEmitter->NextParticleIndex >= ParticleEmitter->ParticleCount)
-                    {
-                        ParticleEmitter->NextParticleIndex = 0;
-                    }
+                game_entity_spec Spec = {};
+                Entity2Spec(Entity, &Spec);
 
-                    random_sequence *Entropy = Data->Entropy;
+                WriteWorldEntityRecord(&Spec, &StringTable, Sections);
+            }
 
-                    Particle->Position = Entity->Transform.Translation + vec3(
-                        RandomBetween(Entropy, -0.05f, 0.05f),
-                        RandomBetween(Entropy, 0.f, 0.1f),
-                        RandomBetween(Entropy, -0.05f, 0.05f)
-                    );
-                    Particle->Velocity = Rotate(vec3(RandomBetween(Entropy, -0.5f, 0.5f), RandomBetween(Entropy, 3.f, 6.f), RandomBetween(Entropy, -0.5f, 0.5f)), Entity->Transform.Rotation);
-                    Particle->Acceleration = Rotate(vec3(0.f, -10.f, 0.f), Entity->Transform.Rotation);
-                    Particle->Color = ParticleEmitter->Color;
-                    Particle->dColor = vec4(0.f, 0.f, 0.f, -0.5f);
-                    Particle->Size = ParticleEmitter->Size;
-                    Particle->dSize = vec2(-0.1f);
-                }
+            for (u32 SectionIndex = 0; SectionIndex < WorldAreaSection_Count; ++SectionIndex)
+            {
+                Chunk->SectionOffsets[SectionIndex] = Writer.Used;
+                WriteBytes(&Writer, Sections[SectionIndex].Base, Sections[SectionIndex].Used);
             }
         }
     }
+
+    AreaHeader->StringTableSize = (u32)StringTable.Strings.Used;
+    AreaHeader->StringTableOffset = Writer.Used;
+
+    WriteBytes(&Writer, StringTable.Strings.Base, StringTable.Strings.Used);
+
+    return Writer;
 }
 
-struct animate_entity_job
+dummy_internal void
+WriteWorldAreaFile(game_state *State, char *FileName,  platform_api *Platform, memory_arena *Arena)
 {
-    game_state *State;
-    game_input *Input;
-    game_entity *Entity;
-    memory_arena Arena;
-    f32 Delta;
-};
+    binary_writer Writer = BuildWorldAreaFile(State, Arena);
 
-JOB_ENTRY_POINT(AnimateEntityJob)
-{
-    animate_entity_job *Data = (animate_entity_job *) Parameters;
-    AnimateEntity(Data->State, Data->Input, Data->Entity, &Data->Arena, Data->Delta);
+    Platform->WriteFile(FileName, Writer.Base, (u32)Writer.Used);
+
+    game_file_header *Header = GET_DATA_AT(Writer.Base, 0, game_file_header);
+    world_area_file_header *AreaHeader = GET_DATA_AT(Writer.Base, sizeof(game_file_header), world_area_file_header);
+
+    Out(&State->PermanentStream, "Saved: %s (Entity Count: %d, Chunk Count: %d, Size: %d KB)", FileName, Header->EntityCount, AreaHeader->ChunkCount, (u32)(Writer.Used / 1024));
 }
 
-struct process_entity_batch_job
+dummy_internal void
+SaveWorldAreaToFile(game_state *State, char *FileName,  platform_api *Platform, memory_arena *Arena)
 {
-    u32 StartIndex;
-    u32 EndIndex;
-    f32 Lag;
-    game_entity *Entities;
-    spatial_hash_grid *SpatialGrid;
+    world_partition *Partition = &State->WorldArea.Partition;
 
-    u32 ShadowPlaneCount;
-    plane *ShadowPlanes;
-};
+    // Entities of the cells that are not resident would be lost
+    if (Partition->Active && Partition->ResidentCellCount < (u32)(Partition->CellCount.x * Partition->CellCount.y))
+    {
+        Out(&State->PermanentStream, "Can't save %s: %s is still loading", FileName, Partition->FileName);
+    }
+    else
+    {
+        WriteWorldAreaFile(State, FileName, Platform, Arena);
+    }
+}
 
-JOB_ENTRY_POINT(ProcessEntityBatchJob)
+/*
+    Version 1 files are instantiated right away.
+    Chunked files are kept in the world area arena and streamed in by the world partition (see UpdateWorldPartition),
+    so the contents must not be in the world area arena.
+*/
+dummy_internal void
+LoadWorldArea(game_state *State, char *FileName, read_file_result Result, render_commands *RenderCommands, audio_commands *AudioCommands)
 {
-    process_entity_batch_job *Data = (process_entity_batch_job *) Parameters;
+    world_area *Area = &State->WorldArea;
+    world_partition *Partition = &Area->Partition;
+
+    game_file_header *Header = GET_DATA_AT(Result.Contents, 0, game_file_header);
+
+    Assert(Header->MagicValue == GAME_FILE_MAGIC_VALUE);
+    Assert(Header->Version == 1 || Header->Version == WORLD_AREA_FILE_VERSION);
+    Assert(Header->Type == GameFile_Area);
+
+    u32 EntityCount = Header->EntityCount;
+
+    aabb WorldBounds = CreateAABBMinMax(vec3(-100.f, 0.f, -100.f), vec3(100.f, 20.f, 100.f));
 
-    for (u32 EntityIndex = Data->StartIndex; EntityIndex < Data->EndIndex; ++EntityIndex)
+    if (Header->Version == WORLD_AREA_FILE_VERSION)
     {
-        game_entity *Entity = Data->Entities + EntityIndex;
+        world_area_file_header *AreaHeader = GET_DATA_AT(Result.Contents, sizeof(game_file_header), world_area_file_header);
 
-        if (!Entity->Destroyed)
+        // Some room for the entities that move out of the saved bounds
+        vec3 Padding = vec3(WORLD_AREA_CHUNK_SIZE, 0.f, WORLD_AREA_CHUNK_SIZE);
+
+        vec3 BoundsMin = Min(WorldBounds.Min(), AreaHeader->Bounds.Min() - Padding);
+        vec3 BoundsMax = Max(WorldBounds.Max(), AreaHeader->Bounds.Max() + Padding);
+
+        WorldBounds = CreateAABBMinMax(BoundsMin, BoundsMax);
+    }
+
+    vec3 CellSize = vec3(GetCVarFloat(State->CVars.SpatialGridCellSize));
+
+    // Cells are 2 KB each, large areas get larger cells instead of more of them
+    while ((u64)Ceil(WorldBounds.HalfExtent.x * 2.f / CellSize.x) * Ceil(WorldBounds.HalfExtent.y * 2.f / CellSize.y) * Ceil(WorldBounds.HalfExtent.z * 2.f / CellSize.z) > MAX_WORLD_AREA_GRID_CELL_COUNT)
+    {
+        CellSize.x *= 2.f;
+        CellSize.z *= 2.f;
+    }
+
+    // Grid and entities of the previous area are replaced
+    ClearMemoryArena(&Area->Arena);
+
+    InitSpatialHashGrid(&Area->SpatialGrid, WorldBounds, CellSize, &Area->Arena);
+    u32 MaxEntityCount = EntityCount + WORLD_AREA_FREE_ENTITY_COUNT;
+    InitWorldAreaEntities(Area, MaxEntityCount > WORLD_AREA_MIN_ENTITY_COUNT ? MaxEntityCount : WORLD_AREA_MIN_ENTITY_COUNT);
+
+    ResetInstanceBuffers(State);
+
+    *Partition = {};
+
+    if (Header->Version == 1)
+    {
+        game_entity_spec *Specs = GET_DATA_AT(Result.Contents, sizeof(game_file_header), game_entity_spec);
+
+        for (u32 EntityIndex = 0; EntityIndex < EntityCount; ++EntityIndex)
         {
-            UpdateInSpacialGrid(Data->SpatialGrid, Entity);
+            game_entity_spec *Spec = Specs + EntityIndex;
 
-            if (Entity->Body)
-            {
-                Entity->Transform.Translation = Lerp(Entity->Body->PrevPosition, Data->Lag, Entity->Body->Position);
-                Entity->Transform.Rotation = Entity->Body->Orientation;
-            }
+            game_entity *Entity = CreateGameEntity(State);
 
-            if (Entity->Collider)
+            if (!Entity)
             {
-                CalculateColliderState(Entity);
+                break;
             }
 
-            if (Entity->Model)
-            {
-                aabb BoundingBox = GetEntityBounds(Entity);
+            Spec2Entity(Spec, Entity, State, RenderCommands, AudioCommands);
+        }
 
-                // Frustrum culling
-                Entity->Visible = AxisAlignedBoxVisible(Data->ShadowPlaneCount, Data->ShadowPlanes, BoundingBox);
-            }
+        Out(&State->PermanentStream, "Loaded: %s (Entity Count: %d)", FileName, EntityCount);
+    }
+    else
+    {
+        u8 *Contents = (u8 *)PushSize(&Area->Arena, Result.Size, NoClear());
+        CopyMemory(Result.Contents, Contents, Result.Size);
+
+        world_area_file_header *AreaHeader = GET_DATA_AT(Contents, sizeof(game_file_header), world_area_file_header);
+        world_area_file_chunk *Chunks = GET_DATA_AT(Contents, AreaHeader->ChunksOffset, world_area_file_chunk);
+
+        Partition->Active = true;
+        CopyString(FileName, Partition->FileName);
+        Partition->Contents = Contents;
+        Partition->Header = AreaHeader;
+        Partition->Strings = GET_DATA_AT(Contents, AreaHeader->StringTableOffset, char);
+
+        // Same grid as the one the file was saved with
+        Partition->CellCount = GetWorldAreaChunkCount(AreaHeader->Bounds);
+
+        u32 CellCount = Partition->CellCount.x * Partition->CellCount.y;
+        Partition->Cells = PushArray(&Area->Arena, CellCount, world_cell);
+
+        for (u32 CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+        {
+            world_cell *Cell = Partition->Cells + CellIndex;
+            Cell->Bounds = GetWorldAreaChunkBounds(AreaHeader->Bounds, Partition->CellCount, CellIndex);
+        }
+
+        for (u32 ChunkIndex = 0; ChunkIndex < AreaHeader->ChunkCount; ++ChunkIndex)
+        {
+            world_area_file_chunk *Chunk = Chunks + ChunkIndex;
+            world_cell *Cell = Partition->Cells + GetWorldAreaChunkIndex(AreaHeader->Bounds, Partition->CellCount, Chunk->Bounds.Center);
+
+            Cell->Chunk = Chunk;
+            Cell->RecordEntityIds = PushArray(&Area->Arena, Chunk->EntityCount, u32);
         }
+
+        Out(&State->PermanentStream, "Loading: %s (Entity Count: %d, Chunk Count: %d, Cell Count: %d)", FileName, EntityCount, AreaHeader->ChunkCount, CellCount);
     }
 }
 
-struct process_particles_job
+dummy_internal void
+LoadWorldAreaFromFile(game_state *State, char *FileName, platform_api *Platform, render_commands *RenderCommands, audio_commands *AudioCommands, memory_arena *TempArena)
 {
-    particle_emitter *ParticleEmitter;
-    vec3 CameraPosition;
-    f32 Delta;
-};
+    read_file_result Result = Platform->ReadFile(FileName, TempArena, ReadBinary());
+    LoadWorldArea(State, FileName, Result, RenderCommands, AudioCommands);
+}
 
-JOB_ENTRY_POINT(ProcessParticlesJob)
+dummy_internal void
+LoadEntityFromFile(game_state *State,  game_entity *Entity, char *FileName, platform_api *Platform, render_commands *RenderCommands, audio_commands *AudioCommands, memory_arena *TempArena)
 {
-    process_particles_job *Data = (process_particles_job *) Parameters;
-
-    particle_emitter *ParticleEmitter = Data->ParticleEmitter;
+    read_file_result Result = Platform->ReadFile(FileName, TempArena, ReadBinary());
 
-    for (u32 ParticleIndex = 0; ParticleIndex < ParticleEmitter->ParticleCount; ++ParticleIndex)
-    {
-        particle *Particle = ParticleEmitter->Particles + ParticleIndex;
+    game_file_header *Header = GET_DATA_AT(Result.Contents, 0, game_file_header);
+    game_entity_spec *Spec = GET_DATA_AT(Result.Contents, sizeof(game_file_header), game_entity_spec);
 
-        f32 dt = Data->Delta;
+    Assert(Header->MagicValue == GAME_FILE_MAGIC_VALUE);
+    Assert(Header->Version == 1);
+    Assert(Header->Type == GameFile_Area);
 
-        Particle->Position += 0.5f * Particle->Acceleration * Square(dt) + Particle->Velocity * dt;
-        Particle->Velocity += Particle->Acceleration * dt;
-        Particle->Color += Particle->dColor * dt;
-        Particle->Size += Particle->dSize * dt;
+    u32 EntityCount = Header->EntityCount;
 
-        Particle->Color.a = Max(Particle->Color.a, 0.f);
-        Particle->Size.x = Max(Particle->Size.x, 0.f);
-        Particle->Size.y = Max(Particle->Size.y, 0.f);
+    Assert(EntityCount == 1);
 
-        Particle->CameraDistanceSquared = SquaredMagnitude(Particle->Position - Data->CameraPosition);
-    }
+    world_area *Area = &State->WorldArea;
 
-    SortParticles(ParticleEmitter->ParticleCount, ParticleEmitter->Particles);
+    Spec2Entity(Spec, Entity, State, RenderCommands, AudioCommands);
 }
 
 dummy_internal void
-InitGameMenu(game_state *State)
+SaveEntityToFile(game_entity *Entity, char *FileName, platform_api *Platform, memory_arena *Arena)
 {
-    State->MenuQuads[0].Corner = 0;
-    State->MenuQuads[0].Move = 0.f;
-    State->MenuQuads[0].Color = vec4(1.f, 0.f, 0.f, 1.f);
+    u32 HeaderSize = sizeof(game_file_header);
+    u32 BufferSize = HeaderSize + sizeof(game_entity_spec);
+    void *Buffer = PushSize(Arena, BufferSize);
 
-    State->MenuQuads[1].Corner = 1;
-    State->MenuQuads[1].Move = 0.f;
-    State->MenuQuads[1].Color = vec4(0.f, 1.f, 0.f, 1.f);
+    game_file_header *Header = GET_DATA_AT(Buffer, 0, game_file_header);
 
-    State->MenuQuads[2].Corner = 2;
-    State->MenuQuads[2].Move = 0.f;
-    State->MenuQuads[2].Color = vec4(0.f, 0.f, 1.f, 1.f);
+    Header->MagicValue = GAME_FILE_MAGIC_VALUE;
+    Header->Version = 1;
+    Header->EntityCount = 1;
+    // todo: different type?
+    Header->Type = GameFile_Area;
 
-    State->MenuQuads[3].Corner = 3;
-    State->MenuQuads[3].Move = 0.f;
-    State->MenuQuads[3].Color = vec4(1.f, 1.f, 0.f, 1.f);
+    game_entity_spec *Spec = GET_DATA_AT(Buffer, HeaderSize, game_entity_spec);
+
+    Entity2Spec(Entity, Spec);
+    Spec->Transform.Translation = vec3(0.f);
+
+    Platform->WriteFile(FileName, Buffer, BufferSize);
 }
 
-inline void
-LoadAnimators(animator *Animator)
+dummy_internal void
+ClearWorldArea(game_state *State)
 {
-    animator_controller *BotController = HashTableLookup(&Animator->Controllers, (char *) "Bot");
-    BotController->Func = BotAnimatorController;
+#if 0
+    for (u32 EntityIndex = 0; EntityIndex < State->WorldArea.EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = State->WorldArea.Entities + EntityIndex;
+        RemoveFromSpacialGrid(&State->WorldArea.SpatialGrid, Entity);
+    }
+#endif
 
-    animator_controller *PaladinController = HashTableLookup(&Animator->Controllers, (char *) "Paladin");
-    PaladinController->Func = PaladinAnimatorController;
+    ClearMemoryArena(&State->WorldArea.Arena);
 
-    animator_controller *MonstarController = HashTableLookup(&Animator->Controllers, (char *) "Monstar");
-    MonstarController->Func = MonstarAnimatorController;
+    InitSpatialHashGrid(&State->WorldArea.SpatialGrid, State->WorldArea.SpatialGrid.Bounds, State->WorldArea.SpatialGrid.CellSize, &State->WorldArea.Arena);
 
-    animator_controller *SimpleController = HashTableLookup(&Animator->Controllers, (char *) "Simple");
-    SimpleController->Func = SimpleAnimatorController;
+    InitWorldAreaEntities(&State->WorldArea, State->WorldArea.MaxEntityCount);
+
+    // Area file of the partition was in the cleared arena
+    State->WorldArea.Partition = {};
+
+    State->SelectedEntity = 0;
+    State->Player = 0;
+
+    ResetInstanceBuffers(State);
 }
 
-inline void
-Entity2Spec(game_entity *Entity, game_entity_spec *Spec)
+inline game_camera *
+GetActiveCamera(game_state *State)
 {
-    CopyString(Entity->Name, Spec->Name);
-    Spec->Transform = Entity->Transform;
-    Spec->DebugColor = Entity->DebugColor;
+    game_camera *Camera = 0;
 
-    if (Entity->Model)
+    switch (State->Mode)
     {
-        Model2Spec(Entity->Model, &Spec->ModelSpec);
+        case GameMode_World:
+        {
+            Camera = &State->PlayerCamera;
+            break;
+        }
+        case GameMode_Menu:
+        case GameMode_Editor:
+        {
+            Camera = &State->EditorCamera;
+            break;
+        }
     }
 
-    if (Entity->Collider)
-    {
-        Collider2Spec(Entity->Collider, &Spec->ColliderSpec);
-    }
+    return Camera;
+}
 
-    if (Entity->Body)
-    {
-        RigidBody2Spec(Entity->Body, &Spec->RigidBodySpec);
-    }
+// Distance on the xz plane, cells span the whole height of the area
+inline f32
+GetWorldCellDistance(world_cell *Cell, vec3 Position)
+{
+    vec3 Delta = Abs(Position - Cell->Bounds.Center) - Cell->Bounds.HalfExtent;
 
-    if (Entity->PointLight)
+    f32 Result = Sqrt(Square(Max(Delta.x, 0.f)) + Square(Max(Delta.z, 0.f)));
+    return Result;
+}
+
+inline world_cell *
+GetWorldCell(world_partition *Partition, vec3 Position)
+{
+    u32 CellIndex = GetWorldAreaChunkIndex(Partition->Header->Bounds, Partition->CellCount, Position);
+
+    world_cell *Result = Partition->Cells + CellIndex;
+    return Result;
+}
+
+// Changes of the entity are not kept, the cell is loaded from the file again
+dummy_internal void
+UnloadGameEntity(game_state *State, game_entity *Entity, audio_commands *AudioCommands)
+{
+    // Pending audio sources don't have a voice yet
+    if (Entity->AudioSource && !Entity->AudioSource->Pending)
     {
-        PointLight2Spec(Entity->PointLight, &Spec->PointLightSpec);
+        Stop(AudioCommands, Entity->AudioSource->Id);
     }
 
-    if (Entity->ParticleEmitter)
+    if (State->SelectedEntity == Entity)
     {
-        ParticleEmitter2Spec(Entity->ParticleEmitter, &Spec->ParticleEmitterSpec);
+        State->SelectedEntity = 0;
     }
 
-    if (Entity->AudioSource)
+    if (State->Player == Entity)
     {
-        AudioSource2Spec(Entity->AudioSource, &Spec->AudioSourceSpec);
+        State->Player = 0;
     }
+
+    RemoveGameEntity(State, Entity);
 }
 
-dummy_internal void
-Spec2Entity(game_entity_spec *Spec, game_entity *Entity, game_state *State, render_commands *RenderCommands, audio_commands *AudioCommands, memory_arena *Arena)
+// Stops at the entity budget, returns the number of the created entities
+dummy_internal u32
+LoadWorldCellEntities(game_state *State, world_cell *Cell, u32 MaxEntityCount, render_commands *RenderCommands, audio_commands *AudioCommands)
 {
-    CopyString(Spec->Name, Entity->Name);
-    Entity->Transform = Spec->Transform;
+    world_partition *Partition = &State->WorldArea.Partition;
 
-    if (Spec->DebugColor != vec3(0.f))
-    {
-        Entity->DebugColor = Spec->DebugColor;
-    }
+    u32 Result = 0;
 
-    if (Spec->ModelSpec.Has)
+    while (Cell->LoadedRecordCount < Cell->Chunk->EntityCount && Result < MaxEntityCount)
     {
-        model *Model = GetModelAsset(&State->Assets, Spec->ModelSpec.ModelRef);
-        AddModel(State, Entity, &State->Assets, Model->Key, RenderCommands, Arena);
-    }
+        // Record stays unread, so loading picks up from it once slots are free again (see UpdateWorldPartition)
+        if (!HasFreeEntitySlot(&State->WorldArea))
+        {
+            break;
+        }
 
-    if (Spec->ColliderSpec.Has)
-    {
-        collider_spec *ColliderSpec = &Spec->ColliderSpec;
+        game_entity_spec Spec;
+        ReadWorldEntityRecord(Cell->SectionAt, Partition->Strings, &Spec);
 
-        switch (ColliderSpec->Type)
+        u32 RecordIndex = Cell->LoadedRecordCount++;
+
+        // Entity of the record moved to another cell and outlived the unload of this one
+        if (Cell->RecordEntityIds[RecordIndex])
         {
-            case Collider_Box:
-            {
-                AddBoxCollider(Entity, ColliderSpec->Box.HalfSize, ColliderSpec->Box.Offset, Arena);
-                break;
-            }
-            default:
-            {
-                Assert(!"Not implemented");
-            }
+            continue;
         }
-    }
 
-    if (Spec->RigidBodySpec.Has)
-    {
-        rigid_body_spec RigidBodySpec = Spec->RigidBodySpec;
-        AddRigidBody(State, Entity, Arena);
-    }
+        game_entity *Entity = CreateGameEntity(State);
 
-    if (Spec->PointLightSpec.Has)
-    {
-        point_light_spec PointLightSpec = Spec->PointLightSpec;
-        AddPointLight(Entity, PointLightSpec.Color, PointLightSpec.Attenuation, Arena);
-    }
+        Entity->Cell = Cell;
+        Entity->HomeCell = Cell;
+        Entity->HomeRecordIndex = RecordIndex;
+        Cell->RecordEntityIds[RecordIndex] = Entity->Id;
 
-    if (Spec->ParticleEmitterSpec.Has)
-    {
-        particle_emitter_spec ParticleEmitterSpec = Spec->ParticleEmitterSpec;
-        AddParticleEmitter(Entity, ParticleEmitterSpec.ParticleCount, ParticleEmitterSpec.ParticlesSpawn, ParticleEmitterSpec.Color, ParticleEmitterSpec.Size, Arena);
-    }
+        ++Cell->EntityCount;
 
-    if (Spec->AudioSourceSpec.Has)
-    {
-        audio_source_spec AudioSourceSpec = Spec->AudioSourceSpec;
+        Spec2Entity(&Spec, Entity, State, RenderCommands, AudioCommands);
 
-        audio_clip *AudioClip = GetAudioClipAsset(&State->Assets, Spec->AudioSourceSpec.AudioClipRef);
-        AddAudioSource(State, Entity, AudioClip, Entity->Transform.Translation, AudioSourceSpec.Volume, AudioSourceSpec.MinDistance, AudioSourceSpec.MaxDistance, AudioCommands, Arena);
+        ++Result;
     }
+
+    return Result;
 }
 
-dummy_internal void
-SaveWorldAreaToFile(game_state *State, char *FileName,  platform_api *Platform, memory_arena *Arena)
+inline void
+CheckWorldPartitionCondition(u32 *ErrorCount, bool32 Condition)
 {
-    u32 HeaderSize = sizeof(game_file_header);
-    u32 BufferSize = HeaderSize + State->ActiveEntitiesCount * sizeof(game_entity_spec);
-    void *Buffer = PushSize(Arena, BufferSize);
+    if (!Condition)
+    {
+        ++*ErrorCount;
+    }
+}
 
-    game_file_header *Header = GET_DATA_AT(Buffer, 0, game_file_header);
+/*
+    Returns the number of the broken invariants: the entity counts of the cells, the cell states against the camera
+    and the records of the area file, each one must have at most one live entity (see world_cell::RecordEntityIds).
+    Asserted on every update, the fly-through benchmark also reports it in the release builds.
+*/
+dummy_internal u32
+CheckWorldPartition(game_state *State, bool32 Streaming, f32 LoadRadius, f32 UnloadRadius, vec3 CameraPosition)
+{
+    scoped_memory ScopedMemory(&State->FrameArena);
 
-    Header->MagicValue = 0x44332211;
-    Header->Version = 1;
-    Header->EntityCount = State->ActiveEntitiesCount;
-    Header->Type = GameFile_Area;
+    world_area *Area = &State->WorldArea;
+    world_partition *Partition = &Area->Partition;
 
-    game_entity_spec *Specs = GET_DATA_AT(Buffer, HeaderSize, game_entity_spec);
+    u32 Result = 0;
 
-    world_area *Area = &State->WorldArea;
+    u32 CellCount = Partition->CellCount.x * Partition->CellCount.y;
+    u32 *CellEntityCounts = PushArray(ScopedMemory.Arena, CellCount, u32);
+    u32 *CellRecordEntityCounts = PushArray(ScopedMemory.Arena, CellCount, u32);
 
-    u32 SpecIndex = 0;
     for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
     {
         game_entity *Entity = Area->Entities + EntityIndex;
 
-        if (!Entity->Destroyed)
+        if (!Entity->Destroyed && Entity->Cell)
         {
-            game_entity_spec *Spec = Specs + SpecIndex++;
-            Entity2Spec(Entity, Spec);
-        }
+            CheckWorldPartitionCondition(&Result, Entity->Cell->State == WorldCell_Loading || Entity->Cell->State == WorldCell_Resident);
+            CheckWorldPartitionCondition(&Result, Entity->Cell == GetWorldCell(Partition, Entity->Transform.Translation));
 
-        Assert(SpecIndex <= State->ActiveEntitiesCount);
-    }
+            ++CellEntityCounts[Entity->Cell - Partition->Cells];
+        }
 
-    Platform->WriteFile(FileName, Buffer, BufferSize);
-}
+        if (!Entity->Destroyed && Entity->HomeCell)
+        {
+            CheckWorldPartitionCondition(&Result, Entity->HomeCell->RecordEntityIds[Entity->HomeRecordIndex] == Entity->Id);
 
-dummy_internal void
-LoadWorldAreaFromFile(game_state *State, char *FileName, platform_api *Platform, render_commands *RenderCommands, audio_commands *AudioCommands, memory_arena *TempArena)
-{
-    read_file_result Result = Platform->ReadFile(FileName, TempArena, ReadBinary());
+            ++CellRecordEntityCounts[Entity->HomeCell - Partition->Cells];
+        }
+    }
 
-    world_area *Area = &State->WorldArea;
+    u32 ResidentCellCount = 0;
+    u32 LoadingCellCount = 0;
 
-    game_file_header *Header = GET_DATA_AT(Result.Contents, 0, game_file_header);
-    game_entity_spec *Specs = GET_DATA_AT(Result.Contents, sizeof(game_file_header), game_entity_spec);
+    for (u32 CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+    {
+        world_cell *Cell = Partition->Cells + CellIndex;
 
-    Assert(Header->MagicValue == 0x44332211);
-    Assert(Header->Version == 1);
-    Assert(Header->Type == GameFile_Area);
+        CheckWorldPartitionCondition(&Result, Cell->EntityCount == CellEntityCounts[CellIndex]);
+        CheckWorldPartitionCondition(&Result, Cell->State != WorldCell_Unloading);
 
-    u32 EntityCount = Header->EntityCount;
+        if (Cell->State == WorldCell_Resident) ++ResidentCellCount;
+        if (Cell->State == WorldCell_Loading) ++LoadingCellCount;
 
-    aabb WorldBounds = CreateAABBMinMax(vec3(-100.f, 0.f, -100.f), vec3(100.f, 20.f, 100.f));
-    vec3 CellSize = vec3(5.f);
-    InitSpatialHashGrid(&Area->SpatialGrid, WorldBounds, CellSize, &Area->Arena);
+        if (Cell->Chunk)
+        {
+            // Every live record entity is counted once, so no record was instantiated twice
+            u32 RecordEntityCount = 0;
 
-    // todo:
-    Area->MaxEntityCount = 10000;
-    Area->EntityCount = 0;
-    Area->Entities = PushArray(&Area->Arena, Area->MaxEntityCount, game_entity);
+            for (u32 RecordIndex = 0; RecordIndex < Cell->Chunk->EntityCount; ++RecordIndex)
+            {
+                if (Cell->RecordEntityIds[RecordIndex]) ++RecordEntityCount;
+            }
 
-    for (u32 EntityIndex = 0; EntityIndex < EntityCount; ++EntityIndex)
-    {
-        game_entity_spec *Spec = Specs + EntityIndex;
+            CheckWorldPartitionCondition(&Result, RecordEntityCount == CellRecordEntityCounts[CellIndex]);
+        }
 
-        game_entity *Entity = CreateGameEntity(State);
+        if (Streaming)
+        {
+            f32 Distance = GetWorldCellDistance(Cell, CameraPosition);
 
-        Spec2Entity(Spec, Entity, State, RenderCommands, AudioCommands, &Area->Arena);
+            CheckWorldPartitionCondition(&Result, Cell->State == WorldCell_Unloaded || Distance <= UnloadRadius);
+            CheckWorldPartitionCondition(&Result, Cell->State != WorldCell_Unloaded || Distance > LoadRadius);
+        }
     }
 
-    Out(&State->PermanentStream, "Loaded: %s (Entity Count: %d)", FileName, EntityCount);
+    CheckWorldPartitionCondition(&Result, ResidentCellCount == Partition->ResidentCellCount);
+    CheckWorldPartitionCondition(&Result, LoadingCellCount == Partition->LoadingCellCount);
+
+    return Result;
 }
 
+/*
+    Requests the cells within the load radius of the active camera and unloads the ones past the unload radius,
+    then hands off the entities that moved to another cell and instantiates up to WORLD_AREA_LOAD_ENTITIES_PER_FRAME entities, nearest cells first.
+*/
 dummy_internal void
-LoadEntityFromFile(game_state *State,  game_entity *Entity, char *FileName, platform_api *Platform, render_commands *RenderCommands, audio_commands *AudioCommands, memory_arena *TempArena)
+UpdateWorldPartition(game_state *State, render_commands *RenderCommands, audio_commands *AudioCommands)
 {
-    read_file_result Result = Platform->ReadFile(FileName, TempArena, ReadBinary());
+    world_area *Area = &State->WorldArea;
+    world_partition *Partition = &Area->Partition;
 
-    game_file_header *Header = GET_DATA_AT(Result.Contents, 0, game_file_header);
-    game_entity_spec *Spec = GET_DATA_AT(Result.Contents, sizeof(game_file_header), game_entity_spec);
+    vec3 CameraPosition = GetActiveCamera(State)->Position;
 
-    Assert(Header->MagicValue == 0x44332211);
-    Assert(Header->Version == 1);
-    Assert(Header->Type == GameFile_Area);
+    // Editor keeps the whole area resident, so it can be edited and saved
+    bool32 Streaming = State->Mode == GameMode_World;
 
-    u32 EntityCount = Header->EntityCount;
+    f32 LoadRadius = State->Options.CellLoadRadius;
+    f32 UnloadRadius = Max(State->Options.CellUnloadRadius, LoadRadius);
 
-    Assert(EntityCount == 1);
+    u32 CellCount = Partition->CellCount.x * Partition->CellCount.y;
+    bool32 Unloading = false;
 
-    world_area *Area = &State->WorldArea;
+    for (u32 CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+    {
+        world_cell *Cell = Partition->Cells + CellIndex;
+        f32 Distance = GetWorldCellDistance(Cell, CameraPosition);
 
-    Spec2Entity(Spec, Entity, State, RenderCommands, AudioCommands, &Area->Arena);
-}
+        if (Cell->State == WorldCell_Unloaded && (!Streaming || Distance <= LoadRadius))
+        {
+            Cell->LoadedRecordCount = 0;
+            Cell->LoadStalled = false;
 
-dummy_internal void
-SaveEntityToFile(game_entity *Entity, char *FileName, platform_api *Platform, memory_arena *Arena)
-{
-    u32 HeaderSize = sizeof(game_file_header);
-    u32 BufferSize = HeaderSize + sizeof(game_entity_spec);
-    void *Buffer = PushSize(Arena, BufferSize);
+            if (Cell->Chunk)
+            {
+                Cell->State = WorldCell_Loading;
+                ++Partition->LoadingCellCount;
 
-    game_file_header *Header = GET_DATA_AT(Buffer, 0, game_file_header);
+                for (u32 SectionIndex = 0; SectionIndex < WorldAreaSection_Count; ++SectionIndex)
+                {
+                    Cell->SectionAt[SectionIndex] = Partition->Contents + Cell->Chunk->SectionOffsets[SectionIndex];
+                }
+            }
+            else
+            {
+                // Nothing to load, the entities can still move in
+                Cell->State = WorldCell_Resident;
+                ++Partition->ResidentCellCount;
+            }
+        }
+        else if (Streaming && Distance > UnloadRadius && (Cell->State == WorldCell_Loading || Cell->State == WorldCell_Resident))
+        {
+            if (Cell->State == WorldCell_Loading)
+            {
+                --Partition->LoadingCellCount;
+            }
+            else
+            {
+                --Partition->ResidentCellCount;
+            }
 
-    Header->MagicValue = 0x44332211;
-    Header->Version = 1;
-    Header->EntityCount = 1;
-    // todo: different type?
-    Header->Type = GameFile_Area;
+            Cell->State = WorldCell_Unloading;
+            Unloading = true;
+        }
+    }
+
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
 
-    game_entity_spec *Spec = GET_DATA_AT(Buffer, HeaderSize, game_entity_spec);
+        if (!Entity->Destroyed && Entity->Cell)
+        {
+            world_cell *Cell = GetWorldCell(Partition, Entity->Transform.Translation);
 
-    Entity2Spec(Entity, Spec);
-    Spec->Transform.Translation = vec3(0.f);
+            if (Entity->Cell->State == WorldCell_Unloading)
+            {
+                UnloadGameEntity(State, Entity, AudioCommands);
+            }
+            else if (Cell != Entity->Cell)
+            {
+                // Moving into a cell that is not loaded is the same as leaving the resident part of the area
+                if (Cell->State == WorldCell_Unloaded || Cell->State == WorldCell_Unloading)
+                {
+                    UnloadGameEntity(State, Entity, AudioCommands);
+                }
+                else
+                {
+                    --Entity->Cell->EntityCount;
+                    ++Cell->EntityCount;
 
-    Platform->WriteFile(FileName, Buffer, BufferSize);
-}
+                    Entity->Cell = Cell;
+                }
+            }
+        }
+    }
 
-dummy_internal void
-ClearWorldArea(game_state *State)
-{
-#if 0
-    for (u32 EntityIndex = 0; EntityIndex < State->WorldArea.EntityCount; ++EntityIndex)
+    if (Unloading)
     {
-        game_entity *Entity = State->WorldArea.Entities + EntityIndex;
-        RemoveFromSpacialGrid(&State->WorldArea.SpatialGrid, Entity);
+        for (u32 CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+        {
+            world_cell *Cell = Partition->Cells + CellIndex;
+
+            if (Cell->State == WorldCell_Unloading)
+            {
+                Assert(Cell->EntityCount == 0);
+                Cell->State = WorldCell_Unloaded;
+            }
+        }
     }
-#endif
 
-    ClearMemoryArena(&State->WorldArea.Arena);
+    u32 EntityBudget = WORLD_AREA_LOAD_ENTITIES_PER_FRAME;
 
-    InitSpatialHashGrid(&State->WorldArea.SpatialGrid, State->WorldArea.SpatialGrid.Bounds, State->WorldArea.SpatialGrid.CellSize, &State->WorldArea.Arena);
+    while (Partition->LoadingCellCount > 0 && EntityBudget > 0)
+    {
+        world_cell *NearestCell = 0;
+        f32 MinDistance = F32_MAX;
 
-    State->WorldArea.EntityCount = 0;
-    State->WorldArea.Entities = PushArray(&State->WorldArea.Arena, State->WorldArea.MaxEntityCount, game_entity);
+        for (u32 CellIndex = 0; CellIndex < CellCount; ++CellIndex)
+        {
+            world_cell *Cell = Partition->Cells + CellIndex;
 
-    State->NextFreeEntityId = 1;
-    State->SelectedEntity = 0;
-    State->Player = 0;
-}
+            if (Cell->State == WorldCell_Loading)
+            {
+                f32 Distance = GetWorldCellDistance(Cell, CameraPosition);
 
-inline game_camera *
-GetActiveCamera(game_state *State)
-{
-    game_camera *Camera = 0;
+                if (Distance < MinDistance)
+                {
+                    NearestCell = Cell;
+                    MinDistance = Distance;
+                }
+            }
+        }
 
-    switch (State->Mode)
-    {
-        case GameMode_World:
+        u32 LoadedEntityCount = LoadWorldCellEntities(State, NearestCell, EntityBudget, RenderCommands, AudioCommands);
+        EntityBudget -= LoadedEntityCount;
+
+        if (NearestCell->LoadedRecordCount == NearestCell->Chunk->EntityCount)
         {
-            Camera = &State->PlayerCamera;
-            break;
+            NearestCell->State = WorldCell_Resident;
+
+            --Partition->LoadingCellCount;
+            ++Partition->ResidentCellCount;
         }
-        case GameMode_Menu:
-        case GameMode_Editor:
+        else if (LoadedEntityCount == 0)
         {
-            Camera = &State->EditorCamera;
+            // Area is full, the cell keeps loading once the slots are freed
+            if (!NearestCell->LoadStalled)
+            {
+                Out(
+                    &State->PermanentStream,
+                    "Can't load the cell %d: all %d entity slots are taken",
+                    (i32)(NearestCell - Partition->Cells),
+                    Area->MaxEntityCount
+                );
+                NearestCell->LoadStalled = true;
+            }
+
             break;
         }
+        else
+        {
+            NearestCell->LoadStalled = false;
+        }
     }
 
-    return Camera;
+#if ASSERT
+    Assert(CheckWorldPartition(State, Streaming, LoadRadius, UnloadRadius, CameraPosition) == 0);
+#endif
 }
 
 DLLExport GAME_INIT(GameInit)
 {
+#if MEMORY_TELEMETRY
+    MemoryTelemetry = Memory->Profiler->MemoryTelemetry;
+#endif
+
     PROFILE(Memory->Profiler, "GameInit");
 
     game_state *State = GetGameState(Memory);
@@ -1804,22 +4059,29 @@ DLLExport GAME_INIT(GameInit)
     State->PermanentStream = CreateStream(SubMemoryArena(&State->PermanentArena, Megabytes(4)));
     State->FrameStream = CreateStream(SubMemoryArena(&State->PermanentArena, Megabytes(2)));
 
+    RegisterGameCVars(State, Memory->CVars);
+
     State->WorldArea = {};
-    State->WorldArea.Arena = SubMemoryArena(&State->PermanentArena, Megabytes(128));
-    State->WorldArea.EntityCount = 0;
-    State->WorldArea.MaxEntityCount = 10000;
-    State->WorldArea.Entities = PushArray(&State->WorldArea.Arena, State->WorldArea.MaxEntityCount, game_entity);
+
+    void *WorldAreaMemory = Platform->ReserveMemory(WORLD_AREA_ARENA_RESERVED_SIZE);
+    InitGrowableMemoryArena(&State->WorldArea.Arena, WorldAreaMemory, WORLD_AREA_ARENA_RESERVED_SIZE, Platform->CommitMemory);
+
+    void *WorldAreaHeapMemory = PushSize(&State->PermanentArena, WORLD_AREA_HEAP_SIZE, AlignNoClear(16));
+    InitTLSFHeap(&State->WorldArea.Heap, WorldAreaHeapMemory, WORLD_AREA_HEAP_SIZE);
+
+    InitWorldAreaEntities(&State->WorldArea, WORLD_AREA_MIN_ENTITY_COUNT);
 
     aabb WorldBounds = CreateAABBMinMax(vec3(-100.f, 0.f, -100.f), vec3(100.f, 20.f, 100.f));
-    vec3 CellSize = vec3(5.f);
+    vec3 CellSize = vec3(GetCVarFloat(State->CVars.SpatialGridCellSize));
     InitSpatialHashGrid(&State->WorldArea.SpatialGrid, WorldBounds, CellSize, &State->WorldArea.Arena);
 
     State->JobQueue = Memory->JobQueue;
+    State->BackgroundJobQueue = Memory->BackgroundJobQueue;
 
-    State->NextFreeEntityId = 1;
     State->NextFreeMeshId = 1;
     State->NextFreeTextureId = 1;
     State->NextFreeSkinningId = 1;
+    State->NextFreeInstanceBufferId = 1;
     State->NextFreeProcessId = 1;
     State->NextFreeAudioSourceId = 1;
 
@@ -1840,6 +4102,9 @@ DLLExport GAME_INIT(GameInit)
     Sentinel->Next = Sentinel->Prev = Sentinel;
 
     InitHashTable(&State->Processes, 251, &State->PermanentArena);
+    InitHashTable(&State->InstanceBuffers, 1021, &State->PermanentArena);
+    InitTLSFHeap(&State->InstanceHeap, PushSize(&State->PermanentArena, INSTANCE_HEAP_SIZE, AlignNoClear(16)), INSTANCE_HEAP_SIZE);
+    InitOcclusionBuffer(&State->OcclusionBuffer, &State->PermanentArena);
 
     // Event System
     game_event_list *EventList = &State->EventList;
@@ -1888,94 +4153,460 @@ DLLExport GAME_INIT(GameInit)
     State->Options.ShowCamera = false;
     State->Options.ShowSpatialGrid = false;
     State->Options.WireframeMode = false;
+    State->Options.MaxLodScreenError = 1.f;
+    State->Options.AssetMemoryBudget = 512;
+    State->Options.CellLoadRadius = 96.f;
+    State->Options.CellUnloadRadius = 128.f;
+    State->Options.EnableOcclusionCulling = true;
+
+    InitGameMenu(State);
+
+    State->Assets = {};
+
+    umm AssetsArenaSize = Memory->AssetsStorageSize;
+    u8 *AssetsArenaBase = Memory->AssetsStorage;
+    InitMemoryArena(&State->Assets.Arena, AssetsArenaBase, AssetsArenaSize);
+
+    OpenAssetPack(&State->Assets, Platform, (char *)"assets\\assets.pack");
+
+    LoadFontAssets(&State->Assets, Platform);
+    InitGameFontAssets(State, &State->Assets, RenderCommands);
+
+    LoadGameAssets(&State->Assets, Platform, Memory->Profiler);
+
+    State->MasterVolume = 0.f;
+
+    {
+        game_process_params Params = {};
+        Params.InterpolationTime = 0.2f;
+        StartGameProcess(State, SmoothInputMoveProcess, Params);
+    }
+}
+
+DLLExport GAME_RELOAD(GameReload)
+{
+#if MEMORY_TELEMETRY
+    MemoryTelemetry = Memory->Profiler->MemoryTelemetry;
+#endif
+
+    game_state *State = GetGameState(Memory);
+    platform_api *Platform = Memory->Platform;
+
+    // Cvars added by the new code
+    RegisterGameCVars(State, Memory->CVars);
+
+    // Restarting game processes
+    game_process *GameProcess = State->ProcessSentinel.Next;
+
+    while (GameProcess->OnUpdatePerFrame)
+    {
+        GameProcess->OnUpdatePerFrame = (game_process_on_update *) Platform->LoadFunction(Platform->PlatformHandle, GameProcess->Name);
+        GameProcess = GameProcess->Next;
+    }
+
+    // Reloading animators
+    LoadAnimators(&State->Animator);
+}
+
+dummy_internal void
+SpawnBox(game_state *State, render_commands *RenderCommands)
+{
+    game_entity *Entity = CreateGameEntity(State);
+
+    if (!Entity)
+    {
+        return;
+    }
+
+#if 0
+    Entity->Transform = CreateTransform(vec3(RandomBetween(&State->GeneralEntropy, -5.f, 5.f), 5.f, RandomBetween(&State->GeneralEntropy, -5.f, 5.f)));
+#else
+    Entity->Transform = CreateTransform(vec3(0.f, 5.f, 0.f), vec3(1.f));
+#endif
+
+    AddModel(State, Entity, &State->Assets, "box", RenderCommands);
+    AddBoxCollider(&State->WorldArea, Entity);
+    AddRigidBody(&State->WorldArea, Entity);
+
+    //State->SelectedEntity = Entity;
+}
+
+dummy_internal void
+SpawnPlayer(game_state *State, render_commands *RenderCommands)
+{
+    game_entity *Entity = CreateGameEntity(State);
+
+    if (!Entity)
+    {
+        return;
+    }
+
+    f32 InverseMass = 0.f;
+    vec3 Size = vec3(0.3f, 1.8f, 0.3f);
+
+    Entity->Transform = CreateTransform(vec3(0.f, 0.f, 0.f));
+
+    AddModel(State, Entity, &State->Assets, "ybot", RenderCommands);
+    AddBoxCollider(&State->WorldArea, Entity, vec3(0.3f, 0.9f, 0.3f), Translate(vec3(0.f, 0.9f, 0.f)));
+    AddRigidBody(&State->WorldArea, Entity);
+
+    State->SelectedEntity = Entity;
+    State->Player = Entity;
+}
+
+//
+// Benchmark scenarios
+//
+
+// Area of the fly-through is 15x15 partition cells, the path stays within it
+#define BENCHMARK_FLY_THROUGH_HALF_SIZE 240.f
+#define BENCHMARK_FLY_THROUGH_PATH_RADIUS 160.f
+#define BENCHMARK_FLY_THROUGH_LAP_FRAME_COUNT 1200
+
+inline vec3
+RandomBenchmarkPosition(random_sequence *Entropy, f32 HalfSize, f32 MinHeight, f32 MaxHeight)
+{
+    vec3 Result = vec3(
+        RandomBetween(Entropy, -HalfSize, HalfSize),
+        RandomBetween(Entropy, MinHeight, MaxHeight),
+        RandomBetween(Entropy, -HalfSize, HalfSize)
+    );
+    return Result;
+}
+
+// Boxes dropped from above onto the ground plane, stresses the collision detection and the contact resolver
+dummy_internal void
+SpawnBenchmarkBoxRain(game_state *State, random_sequence *Entropy, render_commands *RenderCommands)
+{
+    for (u32 BoxIndex = 0; BoxIndex < 1024; ++BoxIndex)
+    {
+        game_entity *Entity = CreateGameEntity(State);
+
+        if (!Entity)
+        {
+            break;
+        }
+
+        quat Rotation = EulerToQuat(RandomBetween(Entropy, 0.f, 2.f * PI), RandomBetween(Entropy, 0.f, 2.f * PI), 0.f);
+        Entity->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, 16.f, 4.f, 64.f), vec3(1.f), Rotation);
+
+        AddModel(State, Entity, &State->Assets, "box", RenderCommands);
+        AddBoxCollider(&State->WorldArea, Entity);
+        AddRigidBody(&State->WorldArea, Entity);
+    }
+}
+
+// Animated and skinned bots on a grid, stresses the animation graphs and the skinning
+dummy_internal void
+SpawnBenchmarkBotCrowd(game_state *State, random_sequence *Entropy, render_commands *RenderCommands)
+{
+    u32 RowCount = 16;
+    f32 Spacing = 2.f;
+
+    for (u32 BotIndex = 0; BotIndex < RowCount * RowCount; ++BotIndex)
+    {
+        game_entity *Entity = CreateGameEntity(State);
+
+        if (!Entity)
+        {
+            break;
+        }
+
+        vec3 Position = vec3(
+            ((f32)(BotIndex % RowCount) - (f32)(RowCount / 2)) * Spacing,
+            0.f,
+            ((f32)(BotIndex / RowCount) - (f32)(RowCount / 2)) * Spacing
+        );
+        quat Rotation = EulerToQuat(RandomBetween(Entropy, 0.f, 2.f * PI), 0.f, 0.f);
+        Entity->Transform = CreateTransform(Position, vec3(1.f), Rotation);
+
+        AddModel(State, Entity, &State->Assets, "ybot", RenderCommands);
+        AddBoxCollider(&State->WorldArea, Entity, vec3(0.3f, 0.9f, 0.3f), Translate(vec3(0.f, 0.9f, 0.f)));
+    }
+}
+
+// Emitters with the large particle counts, stresses the particle simulation and sorting
+dummy_internal void
+SpawnBenchmarkParticleStorm(game_state *State, random_sequence *Entropy)
+{
+    for (u32 EmitterIndex = 0; EmitterIndex < 32; ++EmitterIndex)
+    {
+        game_entity *Entity = CreateGameEntity(State);
+
+        if (!Entity)
+        {
+            break;
+        }
+        Entity->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, 24.f, 0.f, 8.f));
+
+        vec4 Color = vec4(RandomColor(Entropy), 1.f);
+        AddParticleEmitter(&State->WorldArea, Entity, 4096, 32, Color, vec2(0.05f));
+    }
+}
+
+// Point lights scattered over the ground with a few boxes between them, stresses the light clustering and shading
+dummy_internal void
+SpawnBenchmarkLightForest(game_state *State, random_sequence *Entropy, render_commands *RenderCommands)
+{
+    light_attenuation Attenuation = {};
+    Attenuation.Constant = 1.f;
+    Attenuation.Linear = 0.7f;
+    Attenuation.Quadratic = 1.8f;
+
+    for (u32 LightIndex = 0; LightIndex < 1024; ++LightIndex)
+    {
+        game_entity *Entity = CreateGameEntity(State);
+
+        if (!Entity)
+        {
+            break;
+        }
+        Entity->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, 48.f, 0.5f, 4.f));
+
+        AddPointLight(&State->WorldArea, Entity, RandomColor(Entropy), Attenuation);
+
+        if (LightIndex % 4 == 0)
+        {
+            game_entity *Box = CreateGameEntity(State);
+
+            if (!Box)
+            {
+                break;
+            }
+
+            Box->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, 48.f, 0.5f, 0.5f));
+
+            AddModel(State, Box, &State->Assets, "box", RenderCommands);
+            AddBoxCollider(&State->WorldArea, Box);
+        }
+    }
+}
+
+// Same as copying a placed entity over and over in the editor, stresses the entity creation and the static scene
+dummy_internal void
+SpawnBenchmarkMassSpawn(game_state *State, random_sequence *Entropy, render_commands *RenderCommands, audio_commands *AudioCommands)
+{
+    game_entity *Source = CreateGameEntity(State);
+
+    if (!Source)
+    {
+        return;
+    }
+
+    AddModel(State, Source, &State->Assets, "box", RenderCommands);
+    AddBoxCollider(&State->WorldArea, Source);
+
+    for (u32 CopyIndex = 0; CopyIndex < 4096; ++CopyIndex)
+    {
+        // Source is moved before every copy, the same way the gizmo does it
+        f32 Scale = RandomBetween(Entropy, 0.5f, 2.f);
+        quat Rotation = EulerToQuat(RandomBetween(Entropy, 0.f, 2.f * PI), 0.f, 0.f);
+        Source->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, 64.f, 0.f, 0.f), vec3(Scale), Rotation);
+
+        game_entity *Dest = CreateGameEntity(State);
+
+        if (!Dest)
+        {
+            break;
+        }
+
+        CopyGameEntity(State, RenderCommands, AudioCommands, Source, Dest);
+    }
+}
+
+/*
+    Static boxes and the boxes that drift across the cell borders, saved as a chunked area and loaded back, so the area is streamed
+    in and out by the world partition as the camera laps around it (see UpdateBenchmarkFlyThrough)
+*/
+dummy_internal void
+LoadBenchmarkFlyThrough(game_state *State, random_sequence *Entropy, render_commands *RenderCommands, audio_commands *AudioCommands)
+{
+    for (u32 BoxIndex = 0; BoxIndex < 4096; ++BoxIndex)
+    {
+        game_entity *Entity = CreateGameEntity(State);
+
+        if (!Entity)
+        {
+            break;
+        }
+
+        Entity->Transform = CreateTransform(RandomBenchmarkPosition(Entropy, BENCHMARK_FLY_THROUGH_HALF_SIZE, 0.5f, 0.5f));
+
+        AddModel(State, Entity, &State->Assets, "box", RenderCommands);
+        AddBoxCollider(&State->WorldArea, Entity);
+
+        // Every 16th box moves, see UpdateBenchmarkFlyThrough
+        if (BoxIndex % 16 == 0)
+        {
+            AddRigidBody(&State->WorldArea, Entity);
+        }
+    }
+
+    scoped_memory ScopedMemory(&State->PermanentArena);
+
+    binary_writer Writer = BuildWorldAreaFile(State, ScopedMemory.Arena);
+
+    read_file_result File = {};
+    File.Size = (u32)Writer.Used;
+    File.Contents = Writer.Base;
+
+    LoadWorldArea(State, (char *)"fly_through", File, RenderCommands, AudioCommands);
 
-    InitGameMenu(State);
+    game_file_header *Header = GET_DATA_AT(Writer.Base, 0, game_file_header);
 
-    State->Assets = {};
+    // Partition streams the cells around the player camera in the game mode only
+    State->Mode = GameMode_World;
 
-    umm AssetsArenaSize = Memory->AssetsStorageSize;
-    u8 *AssetsArenaBase = Memory->AssetsStorage;
-    InitMemoryArena(&State->Assets.Arena, AssetsArenaBase, AssetsArenaSize);
+    State->FlyThrough.Active = true;
+    State->FlyThrough.FrameIndex = 0;
+    State->FlyThrough.AreaEntityCount = Header->EntityCount;
+}
 
-    LoadFontAssets(&State->Assets, Platform);
-    InitGameFontAssets(State, &State->Assets, RenderCommands);
+// Called before the world partition is updated, moves the camera along the path and keeps the moving boxes going
+dummy_internal void
+UpdateBenchmarkFlyThrough(game_state *State, f32 Delta)
+{
+    benchmark_fly_through *FlyThrough = &State->FlyThrough;
+    world_area *Area = &State->WorldArea;
 
-#if 0
-    LoadGameAssets(&State->Assets, Platform);
-#else
-    // todo: should not be a PermanentArena
-    load_game_assets_job *JobParams = PushType(&State->PermanentArena, load_game_assets_job);
-    JobParams->Assets = &State->Assets;
-    JobParams->Platform = Platform;
+    f32 Angle = 2.f * PI * (f32)(FlyThrough->FrameIndex % BENCHMARK_FLY_THROUGH_LAP_FRAME_COUNT) / (f32)BENCHMARK_FLY_THROUGH_LAP_FRAME_COUNT;
 
-    job Job = {};
-    Job.EntryPoint = LoadGameAssetsJob;
-    Job.Parameters = JobParams;
+    game_camera *Camera = &State->PlayerCamera;
+    Camera->Position = vec3(Cos(Angle) * BENCHMARK_FLY_THROUGH_PATH_RADIUS, 16.f, Sin(Angle) * BENCHMARK_FLY_THROUGH_PATH_RADIUS);
+    Camera->Direction = Normalize(vec3(-Sin(Angle), -0.2f, Cos(Angle)));
 
-    Platform->KickJob(State->JobQueue, Job);
-#endif
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+    {
+        game_entity *Entity = Area->Entities + EntityIndex;
 
-    State->MasterVolume = 0.f;
+        if (!Entity->Destroyed && Entity->Body)
+        {
+            Entity->Body->Velocity.x = 4.f;
+        }
+    }
 
+    // Camera stays at the start of the path while the platform holds the simulation (see BenchmarkRun_Streaming)
+    if (Delta > 0.f)
     {
-        game_process_params Params = {};
-        Params.InterpolationTime = 0.2f;
-        StartGameProcess(State, SmoothInputMoveProcess, Params);
+        ++FlyThrough->FrameIndex;
     }
 }
 
-DLLExport GAME_RELOAD(GameReload)
+// Called after the world partition is updated, counts the broken invariants of the partition and of the streamed entities
+dummy_internal void
+CheckBenchmarkFlyThrough(game_state *State)
 {
-    game_state *State = GetGameState(Memory);
-    platform_api *Platform = Memory->Platform;
+    world_area *Area = &State->WorldArea;
 
-    // Restarting game processes
-    game_process *GameProcess = State->ProcessSentinel.Next;
+    f32 LoadRadius = State->Options.CellLoadRadius;
+    f32 UnloadRadius = Max(State->Options.CellUnloadRadius, LoadRadius);
 
-    while (GameProcess->OnUpdatePerFrame)
+    u32 ErrorCount = CheckWorldPartition(State, true, LoadRadius, UnloadRadius, State->PlayerCamera.Position);
+
+    // Records are instantiated at most once, so the streamed entities never outnumber them
+    u32 StreamedEntityCount = 0;
+
+    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
     {
-        GameProcess->OnUpdatePerFrame = (game_process_on_update *) Platform->LoadFunction(Platform->PlatformHandle, GameProcess->Name);
-        GameProcess = GameProcess->Next;
+        game_entity *Entity = Area->Entities + EntityIndex;
+
+        if (!Entity->Destroyed && Entity->HomeCell)
+        {
+            ++StreamedEntityCount;
+        }
     }
 
-    // Reloading animators
-    LoadAnimators(&State->Animator);
-}
+    CheckWorldPartitionCondition(&ErrorCount, StreamedEntityCount <= State->FlyThrough.AreaEntityCount);
 
-dummy_internal void
-SpawnBox(game_state *State, render_commands *RenderCommands)
-{
-    game_entity *Entity = CreateGameEntity(State);
+    if (ErrorCount > 0 && State->BenchmarkCheckErrorCount == 0)
+    {
+        Out(&State->PermanentStream, "Fly-through check failed at frame %d (Entity Count: %d)", State->FlyThrough.FrameIndex, StreamedEntityCount);
+    }
 
-#if 0
-    Entity->Transform = CreateTransform(vec3(RandomBetween(&State->GeneralEntropy, -5.f, 5.f), 5.f, RandomBetween(&State->GeneralEntropy, -5.f, 5.f)));
-#else
-    Entity->Transform = CreateTransform(vec3(0.f, 5.f, 0.f), vec3(1.f));
-#endif
+    State->BenchmarkCheckErrorCount += ErrorCount;
+}
 
-    AddModel(State, Entity, &State->Assets, "box", RenderCommands, &State->WorldArea.Arena);
-    AddBoxCollider(Entity, &State->WorldArea.Arena);
-    AddRigidBody(State, Entity, &State->WorldArea.Arena);
+DLLExport GAME_RUN_MICRO_BENCHMARKS(GameRunMicroBenchmarks)
+{
+    game_state *State = GetGameState(Memory);
 
-    //State->SelectedEntity = Entity;
+    scoped_memory ScopedMemory(&State->PermanentArena);
+    RunMicroBenchmarks(Suite, ScopedMemory.Arena);
 }
 
-dummy_internal void
-SpawnPlayer(game_state *State, render_commands *RenderCommands)
+DLLExport GAME_LOAD_BENCHMARK(GameLoadBenchmark)
 {
-    game_entity *Entity = CreateGameEntity(State);
+    game_state *State = GetGameState(Memory);
 
-    f32 InverseMass = 0.f;
-    vec3 Size = vec3(0.3f, 1.8f, 0.3f);
+    bool32 Result = false;
 
-    Entity->Transform = CreateTransform(vec3(0.f, 0.f, 0.f));
+    if (State->Assets.State == GameAssetsState_Ready)
+    {
+        render_commands *RenderCommands = GetRenderCommands(Memory);
+        audio_commands *AudioCommands = GetAudioCommands(Memory);
 
-    AddModel(State, Entity, &State->Assets, "ybot", RenderCommands, &State->WorldArea.Arena);
-    AddBoxCollider(Entity, vec3(0.3f, 0.9f, 0.3f), Translate(vec3(0.f, 0.9f, 0.f)), &State->WorldArea.Arena);
-    AddRigidBody(State, Entity, &State->WorldArea.Arena);
+        ClearWorldArea(State);
 
-    State->SelectedEntity = Entity;
-    State->Player = Entity;
+        // Everything random in the frame depends on the seed only
+        State->GeneralEntropy = RandomSequence(Seed);
+        State->ParticleEntropy = RandomSequence(Seed + 1);
+
+        random_sequence Entropy = RandomSequence(Seed);
+
+        State->FlyThrough = {};
+        State->BenchmarkCheckErrorCount = 0;
+
+        switch (Scenario)
+        {
+            case BenchmarkScenario_BoxRain:
+            {
+                SpawnBenchmarkBoxRain(State, &Entropy, RenderCommands);
+                break;
+            }
+            case BenchmarkScenario_BotCrowd:
+            {
+                SpawnBenchmarkBotCrowd(State, &Entropy, RenderCommands);
+                break;
+            }
+            case BenchmarkScenario_ParticleStorm:
+            {
+                SpawnBenchmarkParticleStorm(State, &Entropy);
+                break;
+            }
+            case BenchmarkScenario_LightForest:
+            {
+                SpawnBenchmarkLightForest(State, &Entropy, RenderCommands);
+                break;
+            }
+            case BenchmarkScenario_MassSpawn:
+            {
+                SpawnBenchmarkMassSpawn(State, &Entropy, RenderCommands, AudioCommands);
+                break;
+            }
+            case BenchmarkScenario_FlyThrough:
+            {
+                LoadBenchmarkFlyThrough(State, &Entropy, RenderCommands, AudioCommands);
+                break;
+            }
+            default:
+            {
+                Assert(!"Invalid benchmark scenario");
+            }
+        }
+
+        Result = true;
+    }
+
+    return Result;
+}
+
+DLLExport GAME_GET_BENCHMARK_STATUS(GameGetBenchmarkStatus)
+{
+    game_state *State = GetGameState(Memory);
+
+    Status->CheckErrorCount = State->BenchmarkCheckErrorCount;
+    Status->Ready = IsAssetStreamingIdle(&State->Assets);
+    Status->FrameResidencyMissCount = State->ResidencyMissCount;
 }
 
 DLLExport GAME_FRAME_START(GameFrameStart)
@@ -1989,6 +4620,24 @@ DLLExport GAME_FRAME_END(GameFrameEnd)
 {
     game_state *State = GetGameState(Memory);
 
+    world_area *Area = &State->WorldArea;
+
+    PROFILE_MEMORY(Memory->Profiler, "Permanent Arena", &State->PermanentArena);
+    PROFILE_MEMORY(Memory->Profiler, "Frame Arena", &State->FrameArena);
+    PROFILE_MEMORY(Memory->Profiler, "Assets Arena", &State->Assets.Arena);
+    PROFILE_MEMORY(Memory->Profiler, "Event List Arena", &State->EventList.Arena);
+    PROFILE_MEMORY(Memory->Profiler, "Render Commands", GetRenderCommands(Memory));
+    PROFILE_MEMORY(Memory->Profiler, "Audio Commands", GetAudioCommands(Memory));
+    PROFILE_MEMORY(Memory->Profiler, "World Area Arena", &Area->Arena);
+    PROFILE_MEMORY(Memory->Profiler, "World Area Heap", &Area->Heap);
+    PROFILE_MEMORY(Memory->Profiler, "Colliders", &Area->Colliders);
+    PROFILE_MEMORY(Memory->Profiler, "Rigid Bodies", &Area->Bodies);
+    PROFILE_MEMORY(Memory->Profiler, "Point Lights", &Area->PointLights);
+    PROFILE_MEMORY(Memory->Profiler, "Particle Emitters", &Area->ParticleEmitters);
+    PROFILE_MEMORY(Memory->Profiler, "Audio Sources", &Area->AudioSources);
+    PROFILE_MEMORY(Memory->Profiler, "Streamed Assets", &State->Assets.AssetAllocator);
+    PROFILE_MEMORY(Memory->Profiler, "Instances", &State->InstanceHeap);
+
     ClearStream(&State->FrameStream);
     ClearMemoryArena(&State->FrameArena);
 }
@@ -2179,7 +4828,7 @@ DLLExport GAME_INPUT(GameInput)
 
 DLLExport GAME_UPDATE(GameUpdate)
 {
-    //PROFILE(Memory->Profiler, "GameUpdate");
+    PROFILE(Memory->Profiler, "GameUpdate");
 
     game_state *State = GetGameState(Memory);
     platform_api *Platform = Memory->Platform;
@@ -2212,38 +4861,24 @@ DLLExport GAME_UPDATE(GameUpdate)
 #endif
 
 #if 1
-    u32 EntityBatchCount = 100;
-    u32 UpdateEntityBatchJobCount = Ceil((f32) Area->EntityCount / (f32) EntityBatchCount);
-    job *UpdateEntityBatchJobs = PushArray(ScopedMemory.Arena, UpdateEntityBatchJobCount, job);
-    update_entity_batch_job *UpdateEntityBatchJobParams = PushArray(ScopedMemory.Arena, UpdateEntityBatchJobCount, update_entity_batch_job);
-
-    for (u32 EntityBatchIndex = 0; EntityBatchIndex < UpdateEntityBatchJobCount; ++EntityBatchIndex)
-    {
-        job *Job = UpdateEntityBatchJobs + EntityBatchIndex;
-        update_entity_batch_job *JobData = UpdateEntityBatchJobParams + EntityBatchIndex;
-
-        JobData->StartIndex = EntityBatchIndex * EntityBatchCount;
-        JobData->EndIndex = Min((i32) JobData->StartIndex + EntityBatchCount, (i32) Area->EntityCount);
-        JobData->UpdateRate = Params->UpdateRate;
-        if (State->Player)
-        {
-            JobData->PlayerId = State->Player->Id;
-        }
-        JobData->Entities = Area->Entities;
-        JobData->SpatialGrid = &Area->SpatialGrid;
-        JobData->Entropy = &State->ParticleEntropy;
-        JobData->Arena = SubMemoryArena(ScopedMemory.Arena, Megabytes(1), NoClear());
-        JobData->State = State;
-        JobData->Platform = Platform;
-
-        Job->EntryPoint = UpdateEntityBatchJob;
-        Job->Parameters = JobData;
-    }
-
-    if (UpdateEntityBatchJobCount > 0)
+    update_entity_range UpdateParams = {};
+    UpdateParams.UpdateRate = Params->UpdateRate;
+    if (State->Player)
     {
-        Platform->KickJobsAndWait(State->JobQueue, UpdateEntityBatchJobCount, UpdateEntityBatchJobs);
+        UpdateParams.PlayerId = State->Player->Id;
     }
+    UpdateParams.Entities = Area->Entities;
+    UpdateParams.SpatialGrid = &Area->SpatialGrid;
+    UpdateParams.MaxGroundProbeEntityCount = (u32) GetCVarInt(State->CVars.MaxGroundProbeEntityCount);
+    UpdateParams.MaxNearbyEntityCount = (u32) GetCVarInt(State->CVars.MaxNearbyEntityCount);
+    UpdateParams.Entropy = &State->ParticleEntropy;
+    UpdateParams.State = State;
+    UpdateParams.Platform = Platform;
+
+    // Both lists of the nearby entities of one entity at a time
+    umm UpdateArenaSize = (UpdateParams.MaxGroundProbeEntityCount + UpdateParams.MaxNearbyEntityCount) * sizeof(game_entity *) + Kilobytes(1);
+
+    ParallelFor(Platform, State->JobQueue, &State->UpdateEntitiesLoop, "UpdateEntityRange", Area->EntityCount, UpdateEntityRange, &UpdateParams, ScopedMemory.Arena, UpdateArenaSize);
 #else
     // Single thread
     f32 dt = Params->UpdateRate;
@@ -2388,6 +5023,8 @@ DLLExport GAME_UPDATE(GameUpdate)
 
 DLLExport GAME_RENDER(GameRender)
 {
+    PROFILE(Memory->Profiler, "GameRender");
+
     game_state *State = GetGameState(Memory);
     render_commands *RenderCommands = GetRenderCommands(Memory);
     audio_commands *AudioCommands = GetAudioCommands(Memory);
@@ -2420,21 +5057,38 @@ DLLExport GAME_RENDER(GameRender)
 #endif
     //
 
-    if (State->Assets.State == GameAssetsState_Loaded)
+    if (AtomicLoadAcquire((u32 volatile *) &State->Assets.State) == GameAssetsState_Loaded)
     {
 #if 1
         // todo: render commands buffer is not multithread-safe!
-        InitGameModelAssets(State, &State->Assets, RenderCommands);
-        InitGameTextureAssets(State, &State->Assets, RenderCommands);
+        InitGameModelAssets(State, &State->Assets, Platform);
+        InitGameTextureAssets(State, &State->Assets);
+        InitGameAudioClipAssets(&State->Assets);
+        InitAssetAllocator(State, &State->Assets);
+
+        // Skybox is converted from the texture right away and the music clips are played without waiting, so they are loaded up front
+        texture *Sky = GetTextureAsset(&State->Assets, "environment_sky");
+
+        if (LoadTextureNow(State, &State->Assets, Platform, Sky, RenderCommands))
+        {
+            AddSkybox(RenderCommands, 1, 1024, Sky);
+        }
 
-        AddSkybox(RenderCommands, 1, 1024, GetTextureAsset(&State->Assets, "environment_sky"));
         //AddSkybox(RenderCommands, 2, 1024, GetTextureAsset(&State->Assets, "environment_desert"));
         //AddSkybox(RenderCommands, 3, 1024, GetTextureAsset(&State->Assets, "environment_hill"));
 
+        audio_clip *Ambient = GetAudioClipAsset(&State->Assets, "Ambient 5");
+        audio_clip *Samba = GetAudioClipAsset(&State->Assets, "samba");
+
+        bool32 MusicLoaded = LoadAudioClipNow(State, &State->Assets, Platform, Ambient, RenderCommands, AudioCommands);
+        MusicLoaded = LoadAudioClipNow(State, &State->Assets, Platform, Samba, RenderCommands, AudioCommands) && MusicLoaded;
+
+        Assert(MusicLoaded);
+
         State->Assets.State = GameAssetsState_Ready;
 #endif
 
-        Play2D(AudioCommands, GetAudioClipAsset(&State->Assets, "Ambient 5"), SetAudioPlayOptions(0.1f, true), 2);
+        Play2D(AudioCommands, Ambient, SetAudioPlayOptions(0.1f, true), 2);
 
 #if 0
         {
@@ -2445,11 +5099,36 @@ DLLExport GAME_RENDER(GameRender)
 #endif
     }
 
+    if (State->Assets.State == GameAssetsState_Ready)
+    {
+        PROFILE(Memory->Profiler, "GameRender:UpdateAssetResidency");
+
+        UpdateAssetResidency(State, &State->Assets, Platform, RenderCommands, AudioCommands);
+    }
+
+    if (State->Assets.State == GameAssetsState_Ready && State->WorldArea.Partition.Active)
+    {
+        PROFILE(Memory->Profiler, "GameRender:UpdateWorldPartition");
+
+        if (State->FlyThrough.Active)
+        {
+            UpdateBenchmarkFlyThrough(State, Params->Delta);
+        }
+
+        UpdateWorldPartition(State, RenderCommands, AudioCommands);
+
+        if (State->FlyThrough.Active)
+        {
+            CheckBenchmarkFlyThrough(State);
+        }
+    }
+
     if (Changed(State->DanceMode))
     {
         if (State->DanceMode.Value)
         {
             Pause(AudioCommands, 2);
+            // Loaded up front with the ambient music and never evicted
             Play2D(AudioCommands, GetAudioClipAsset(&State->Assets, "samba"), SetAudioPlayOptions(0.75f, true), 3);
         }
         else
@@ -2568,7 +5247,7 @@ DLLExport GAME_RENDER(GameRender)
 
                     if (State->Assets.State == GameAssetsState_Ready)
                     {
-                        DrawBillboard(RenderCommands, Camera->Position, vec2(0.2f), GetTextureAsset(&State->Assets, "camera"));
+                        DrawBillboard(RenderCommands, Camera->Position, vec2(0.2f), UseTexture(&State->Assets, "camera"));
                     }
                 }
             }
@@ -2578,10 +5257,9 @@ DLLExport GAME_RENDER(GameRender)
 
                 scoped_memory ScopedMemory(&State->FrameArena);
 
-                u32 AnimationJobCount = 0;
-                u32 MaxAnimationJobCount = Area->EntityCount;
-                job *AnimationJobs = PushArray(ScopedMemory.Arena, MaxAnimationJobCount, job);
-                animate_entity_job *AnimationJobParams = PushArray(ScopedMemory.Arena, MaxAnimationJobCount, animate_entity_job);
+                u32 AnimatedEntityCount = 0;
+                game_entity **AnimatedEntities = PushArray(ScopedMemory.Arena, Area->EntityCount, game_entity *, NoClear());
+                f32 *AnimationDeltas = PushArray(ScopedMemory.Arena, Area->EntityCount, f32, NoClear());
 
                 for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
                 {
@@ -2589,26 +5267,33 @@ DLLExport GAME_RENDER(GameRender)
 
                     if (!Entity->Destroyed && Entity->Model && HasJoints(Entity->Model->Skeleton))
                     {
-                        job *Job = AnimationJobs + AnimationJobCount;
-                        animate_entity_job *JobData = AnimationJobParams + AnimationJobCount;
+                        f32 Delta = Entity->SkippedAnimationDelta + Params->Delta;
 
-                        ++AnimationJobCount;
+                        // Occlusion is from the previous frame
+                        if (Entity->Occluded && Entity != State->Player && Delta < OCCLUDED_ANIMATION_INTERVAL)
+                        {
+                            Entity->SkippedAnimationDelta = Delta;
+                            continue;
+                        }
 
-                        JobData->State = State;
-                        JobData->Input = Input;
-                        JobData->Entity = Entity;
-                        JobData->Arena = SubMemoryArena(ScopedMemory.Arena, Kilobytes(512), NoClear());
-                        JobData->Delta = Params->Delta;
+                        Entity->SkippedAnimationDelta = 0.f;
 
-                        Job->EntryPoint = AnimateEntityJob;
-                        Job->Parameters = JobData;
+                        AnimatedEntities[AnimatedEntityCount] = Entity;
+                        AnimationDeltas[AnimatedEntityCount] = Delta;
+
+                        ++AnimatedEntityCount;
                     }
                 }
 
-                if (AnimationJobCount > 0)
-                {
-                    Platform->KickJobsAndWait(State->JobQueue, AnimationJobCount, AnimationJobs);
-                }
+                animate_entity_range AnimateParams = {};
+                AnimateParams.State = State;
+                AnimateParams.Input = Input;
+                AnimateParams.Entities = AnimatedEntities;
+                AnimateParams.Deltas = AnimationDeltas;
+
+                umm AnimationArenaSize = Kilobytes(GetCVarInt(State->CVars.AnimationArenaSize));
+
+                ParallelFor(Platform, State->JobQueue, &State->AnimateEntitiesLoop, "AnimateEntityRange", AnimatedEntityCount, AnimateEntityRange, &AnimateParams, ScopedMemory.Arena, AnimationArenaSize);
             }
 
             {
@@ -2616,45 +5301,105 @@ DLLExport GAME_RENDER(GameRender)
 
                 scoped_memory ScopedMemory(&State->FrameArena);
 
-                u32 EntityBatchCount = 100;
-                u32 ProcessEntityBatchJobCount = Ceil((f32)Area->EntityCount / (f32)EntityBatchCount);
-                job *ProcessEntityBatchJobs = PushArray(&State->FrameArena, ProcessEntityBatchJobCount, job);
-                process_entity_batch_job *ProcessEntityBatchJobParams = PushArray(ScopedMemory.Arena, ProcessEntityBatchJobCount, process_entity_batch_job);
+                process_entity_range ProcessParams = {};
+                ProcessParams.Lag = Params->UpdateLag;
+                ProcessParams.Entities = Area->Entities;
+                ProcessParams.SpatialGrid = &Area->SpatialGrid;
+                ProcessParams.ShadowPlaneCount = ShadowPlaneCount;
+                ProcessParams.ShadowPlanes = ShadowPlanes;
+                ProcessParams.CameraPosition = Camera->Position;
+                ProcessParams.LodProjectionScale = 0.5f * (f32)Params->WindowHeight * Camera->FocalLength;
+                ProcessParams.MaxLodScreenError = State->Options.MaxLodScreenError;
+
+                ParallelFor(Platform, State->JobQueue, &State->ProcessEntitiesLoop, "ProcessEntityRange", Area->EntityCount, ProcessEntityRange, &ProcessParams, ScopedMemory.Arena);
+            }
+
+            {
+                PROFILE(Memory->Profiler, "GameRender:OcclusionCulling");
+
+                occlusion_buffer *OcclusionBuffer = &State->OcclusionBuffer;
+                bool32 EnableOcclusionCulling = EnableFrustrumCulling && State->Options.EnableOcclusionCulling;
 
-                for (u32 EntityBatchIndex = 0; EntityBatchIndex < ProcessEntityBatchJobCount; ++EntityBatchIndex)
+                for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
                 {
-                    job *Job = ProcessEntityBatchJobs + EntityBatchIndex;
-                    process_entity_batch_job *JobData = ProcessEntityBatchJobParams + EntityBatchIndex;
-
-                    JobData->StartIndex = EntityBatchIndex * EntityBatchCount;
-                    JobData->EndIndex = Min((i32)JobData->StartIndex + EntityBatchCount, (i32)Area->EntityCount);
-                    JobData->Lag = Params->UpdateLag;
-                    JobData->Entities = Area->Entities;
-                    JobData->SpatialGrid = &Area->SpatialGrid;
-                    JobData->ShadowPlaneCount = ShadowPlaneCount;
-                    JobData->ShadowPlanes = ShadowPlanes;
-
-                    Job->EntryPoint = ProcessEntityBatchJob;
-                    Job->Parameters = JobData;
+                    game_entity *Entity = Area->Entities + EntityIndex;
+                    Entity->Occluded = false;
                 }
 
-                if (ProcessEntityBatchJobCount > 0)
+                if (EnableOcclusionCulling)
                 {
-                    Platform->KickJobsAndWait(State->JobQueue, ProcessEntityBatchJobCount, ProcessEntityBatchJobs);
+                    u32 MaxTriangleCount = 0;
+
+                    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+                    {
+                        game_entity *Entity = Area->Entities + EntityIndex;
+
+                        if (IsOccluder(Entity))
+                        {
+                            MaxTriangleCount += GetOccluderTriangleCount(Entity->Model);
+                        }
+                    }
+
+                    BeginOcclusionFrame(OcclusionBuffer, &State->PlayerCamera, MaxTriangleCount, &State->FrameArena);
+
+                    for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
+                    {
+                        game_entity *Entity = Area->Entities + EntityIndex;
+
+                        if (IsOccluder(Entity))
+                        {
+                            AddOccluderModel(OcclusionBuffer, Entity->Model, Entity->Transform);
+                        }
+                    }
+
+                    scoped_memory ScopedMemory(&State->FrameArena);
+
+                    job *RasterizeJobs = PushArray(ScopedMemory.Arena, OCCLUSION_BUFFER_BAND_COUNT, job);
+                    rasterize_occlusion_band_job *RasterizeJobParams = PushArray(ScopedMemory.Arena, OCCLUSION_BUFFER_BAND_COUNT, rasterize_occlusion_band_job);
+
+                    for (u32 BandIndex = 0; BandIndex < OCCLUSION_BUFFER_BAND_COUNT; ++BandIndex)
+                    {
+                        job *Job = RasterizeJobs + BandIndex;
+                        rasterize_occlusion_band_job *JobData = RasterizeJobParams + BandIndex;
+
+                        JobData->Buffer = OcclusionBuffer;
+                        JobData->BandIndex = BandIndex;
+
+                        Job->EntryPoint = RasterizeOcclusionBandJob;
+                        Job->Parameters = JobData;
+                        Job->Name = "RasterizeOcclusionBandJob";
+                    }
+
+                    Platform->KickJobsAndWait(State->JobQueue, OCCLUSION_BUFFER_BAND_COUNT, RasterizeJobs);
+
+                    BuildOcclusionHierarchy(OcclusionBuffer);
+
+                    test_entity_occlusion_range TestParams = {};
+                    TestParams.Entities = Area->Entities;
+                    TestParams.Buffer = OcclusionBuffer;
+
+                    ParallelFor(Platform, State->JobQueue, &State->TestOcclusionLoop, "TestEntityOcclusionRange", Area->EntityCount, TestEntityOcclusionRange, &TestParams, ScopedMemory.Arena);
+
+                    if (State->DumpOcclusionBuffer)
+                    {
+                        DumpOcclusionBuffer(OcclusionBuffer, Platform, (char *)"occlusion_buffer.pgm", ScopedMemory.Arena);
+                        State->DumpOcclusionBuffer = false;
+                    }
                 }
             }
 
+            u32 MaxPointLightCount = Area->EntityCount;
+            u32 PointLightCount = 0;
+            point_light *PointLights = PushArray(&State->FrameArena, MaxPointLightCount, point_light, NoClear());
+
             {
                 PROFILE(Memory->Profiler, "GameRender:PrepareRenderBuffer");
 
-                u32 MaxPointLightCount = 32;
-                u32 PointLightCount = 0;
-                point_light *PointLights = PushArray(&State->FrameArena, MaxPointLightCount, point_light, NoClear());
-
                 InitHashTable(&State->EntityBatches, 521, &State->FrameArena);
 
                 State->RenderableEntityCount = 0;
                 State->ActiveEntitiesCount = 0;
+                State->ResidencyMissCount = 0;
 
                 for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
                 {
@@ -2668,17 +5413,41 @@ DLLExport GAME_RENDER(GameRender)
                         {
                             if (!EnableFrustrumCulling || Entity->Visible)
                             {
-                                // Grouping entities into render batches
-                                entity_render_batch *Batch = GetRenderBatch(State, Entity->Model->Key);
+                                model *Model = Entity->Model;
+                                // Occluded entities can still cast visible shadows, they go into separate batches drawn only into the shadow maps
+                                bool32 ShadowOnly = EnableFrustrumCulling && Entity->Occluded;
 
-                                if (IsSlotEmpty(Batch->Key))
+                                if (IsModelResident(Model))
                                 {
-                                    InitRenderBatch(Batch, Entity, Area->MaxEntityCount, &State->FrameArena);
-                                }
+                                    TouchModel(&State->Assets, Model);
+
+                                    // Grouping entities into render batches
+                                    char BatchKey[256];
+                                    FormatString(BatchKey, ShadowOnly ? "%s:shadow" : "%s", Model->Key);
 
-                                AddEntityToRenderBatch(Batch, Entity);
+                                    entity_render_batch *Batch = GetRenderBatch(State, BatchKey);
 
-                                ++State->RenderableEntityCount;
+                                    if (IsSlotEmpty(Batch->Key))
+                                    {
+                                        InitRenderBatch(State, Batch, BatchKey, Entity, ShadowOnly, Area->MaxEntityCount, &State->FrameArena);
+                                    }
+
+                                    AddEntityToRenderBatch(State, Batch, Entity, RenderCommands);
+
+                                    if (!ShadowOnly)
+                                    {
+                                        ++State->RenderableEntityCount;
+                                    }
+                                }
+                                else if (!ShadowOnly)
+                                {
+                                    RequestModel(Model);
+                                    ++State->ResidencyMissCount;
+
+                                    // Placeholder until the model is streamed in
+                                    aabb Bounds = GetEntityBounds(Entity);
+                                    DrawBox(RenderCommands, CreateTransform(Bounds.Center, Bounds.HalfExtent), vec4(0.5f, 0.5f, 0.5f, 1.f));
+                                }
                             }
                         }
 
@@ -2699,7 +5468,7 @@ DLLExport GAME_RENDER(GameRender)
 
                             if (State->Mode == GameMode_Editor)
                             {
-                                DrawBillboard(RenderCommands, PointLight->Position, vec2(0.2f), GetTextureAsset(&State->Assets, "point_light"));
+                                DrawBillboard(RenderCommands, PointLight->Position, vec2(0.2f), UseTexture(&State->Assets, "point_light"));
                             }
                         }
 
@@ -2711,7 +5480,7 @@ DLLExport GAME_RENDER(GameRender)
 
                             if (State->Mode == GameMode_Editor)
                             {
-                                DrawBillboard(RenderCommands, Entity->Transform.Translation, vec2(0.2f), GetTextureAsset(&State->Assets, "audio_source"));
+                                DrawBillboard(RenderCommands, Entity->Transform.Translation, vec2(0.2f), UseTexture(&State->Assets, "audio_source"));
                             }
                         }
                     }
@@ -2723,6 +5492,150 @@ DLLExport GAME_RENDER(GameRender)
                 }
             }
 
+            {
+                PROFILE(Memory->Profiler, "GameRender:BinPointLights");
+
+                light_cluster_grid *LightGrid = PushType(&State->FrameArena, light_cluster_grid);
+                InitLightClusterGrid(LightGrid, Camera, &State->FrameArena);
+
+                point_light_bounds *LightBounds = PushArray(&State->FrameArena, PointLightCount, point_light_bounds, NoClear());
+                CalculatePointLightBounds(PointLightCount, PointLights, WorldToCamera, LightBounds);
+
+                // One job per depth slice, each one owns its clusters
+                u32 BinJobCount = LIGHT_CLUSTER_COUNT_Z;
+                job *BinJobs = PushArray(&State->FrameArena, BinJobCount, job);
+                bin_point_lights_job *BinJobParams = PushArray(&State->FrameArena, BinJobCount, bin_point_lights_job);
+
+                for (u32 SliceIndex = 0; SliceIndex < BinJobCount; ++SliceIndex)
+                {
+                    job *Job = BinJobs + SliceIndex;
+                    bin_point_lights_job *JobData = BinJobParams + SliceIndex;
+
+                    JobData->Grid = LightGrid;
+                    JobData->SliceIndex = SliceIndex;
+                    JobData->LightCount = PointLightCount;
+                    JobData->LightBounds = LightBounds;
+                    JobData->WriteIndices = false;
+
+                    Job->EntryPoint = BinPointLightsJob;
+                    Job->Parameters = JobData;
+                    Job->Name = "BinPointLightsJob";
+                }
+
+                // Counting lights per cluster
+                Platform->KickJobsAndWait(State->JobQueue, BinJobCount, BinJobs);
+
+                AllocateLightIndices(LightGrid, &State->FrameArena);
+
+                for (u32 SliceIndex = 0; SliceIndex < BinJobCount; ++SliceIndex)
+                {
+                    bin_point_lights_job *JobData = BinJobParams + SliceIndex;
+                    JobData->WriteIndices = true;
+                }
+
+                // Writing light indices
+                Platform->KickJobsAndWait(State->JobQueue, BinJobCount, BinJobs);
+
+                SetLightClusters(RenderCommands, LightGrid->Near, LightGrid->Far, LightGrid->Clusters, LightGrid->LightIndexCount, LightGrid->LightIndices);
+            }
+
+            // Batches with more entities are drawn instanced
+            u32 BatchThreshold = (u32) GetCVarInt(State->CVars.ClusterCullingBatchThreshold);
+
+            {
+                PROFILE(Memory->Profiler, "GameRender:CullMeshClusters");
+
+                State->TotalClusterCount = 0;
+                State->VisibleClusterCount = 0;
+                State->TotalTriangleCount = 0;
+                State->SubmittedTriangleCount = 0;
+
+                // Clusters are culled against the player camera, same as the entities
+                if (EnableFrustrumCulling)
+                {
+                    u32 ItemCount = 0;
+
+                    for (u32 EntityBatchIndex = 0; EntityBatchIndex < State->EntityBatches.Count; ++EntityBatchIndex)
+                    {
+                        entity_render_batch *Batch = State->EntityBatches.Values + EntityBatchIndex;
+
+                        if (Batch->EntityCount <= BatchThreshold && !Batch->Skinning && !Batch->ShadowOnly)
+                        {
+                            for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+                            {
+                                ItemCount += GetClusterCulledMeshCount(Batch->Entities[EntityIndex]);
+                            }
+                        }
+                    }
+
+                    cull_mesh_clusters_item *Items = PushArray(&State->FrameArena, ItemCount, cull_mesh_clusters_item);
+                    u32 ItemIndex = 0;
+
+                    for (u32 EntityBatchIndex = 0; EntityBatchIndex < State->EntityBatches.Count; ++EntityBatchIndex)
+                    {
+                        entity_render_batch *Batch = State->EntityBatches.Values + EntityBatchIndex;
+
+                        if (Batch->EntityCount <= BatchThreshold && !Batch->Skinning && !Batch->ShadowOnly)
+                        {
+                            for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
+                            {
+                                game_entity *Entity = Batch->Entities[EntityIndex];
+                                model *Model = Entity->Model;
+
+                                if (GetClusterCulledMeshCount(Entity) > 0)
+                                {
+                                    Entity->ClusterRanges = PushArray(&State->FrameArena, Model->MeshCount, mesh_cluster_ranges);
+
+                                    for (u32 MeshIndex = 0; MeshIndex < Model->MeshCount; ++MeshIndex)
+                                    {
+                                        mesh *Mesh = Model->Meshes + MeshIndex;
+
+                                        if (ShouldCullMeshClusters(Entity, Mesh))
+                                        {
+                                            mesh_cluster_ranges *Ranges = Entity->ClusterRanges + MeshIndex;
+                                            Ranges->IndexOffsets = PushArray(&State->FrameArena, Mesh->ClusterCount, u32, NoClear());
+                                            Ranges->IndexCounts = PushArray(&State->FrameArena, Mesh->ClusterCount, u32, NoClear());
+
+                                            cull_mesh_clusters_item *Item = Items + ItemIndex;
+                                            ++ItemIndex;
+
+                                            Item->Mesh = Mesh;
+                                            Item->Transform = Entity->Transform;
+                                            Item->Ranges = Ranges;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    Assert(ItemIndex == ItemCount);
+
+                    cull_mesh_clusters_range CullParams = {};
+                    CullParams.Items = Items;
+                    CullParams.PlaneCount = State->Frustrum.FaceCount;
+                    CullParams.Planes = State->Frustrum.Planes;
+                    CullParams.CameraPosition = State->PlayerCamera.Position;
+
+                    ParallelFor(Platform, State->JobQueue, &State->CullMeshClustersLoop, "CullMeshClustersRange", ItemCount, CullMeshClustersRange, &CullParams, &State->FrameArena);
+
+                    for (ItemIndex = 0; ItemIndex < ItemCount; ++ItemIndex)
+                    {
+                        cull_mesh_clusters_item *Item = Items + ItemIndex;
+                        mesh_cluster_ranges *Ranges = Item->Ranges;
+
+                        State->TotalClusterCount += Item->Mesh->ClusterCount;
+                        State->VisibleClusterCount += Item->VisibleClusterCount;
+                        State->TotalTriangleCount += Item->Mesh->Lods[0].IndexCount / 3;
+
+                        for (u32 RangeIndex = 0; RangeIndex < Ranges->RangeCount; ++RangeIndex)
+                        {
+                            State->SubmittedTriangleCount += Ranges->IndexCounts[RangeIndex] / 3;
+                        }
+                    }
+                }
+            }
+
             {
                 PROFILE(Memory->Profiler, "GameRender:PushRenderBuffer");
 
@@ -2731,19 +5644,20 @@ DLLExport GAME_RENDER(GameRender)
                 {
                     entity_render_batch *Batch = State->EntityBatches.Values + EntityBatchIndex;
 
-                    u32 BatchThreshold = 1;
-
                     if (Batch->EntityCount > BatchThreshold)
                     {
                         RenderEntityBatch(RenderCommands, State, Batch);
                     }
                     else
                     {
+                        material_options Options = DefaultMaterialOptions();
+                        Options.ShadowOnly = Batch->ShadowOnly;
+
                         for (u32 EntityIndex = 0; EntityIndex < Batch->EntityCount; ++EntityIndex)
                         {
                             game_entity *Entity = Batch->Entities[EntityIndex];
 
-                            RenderEntity(RenderCommands, State, Entity);
+                            RenderEntity(RenderCommands, State, Entity, Options);
                         }
                     }
                 }
@@ -2754,10 +5668,8 @@ DLLExport GAME_RENDER(GameRender)
 
                 scoped_memory ScopedMemory(&State->FrameArena);
 
-                u32 ParticleJobCount = 0;
-                u32 MaxParticleJobCount = Area->EntityCount;
-                job *ParticleJobs = PushArray(ScopedMemory.Arena, MaxParticleJobCount, job);
-                process_particles_job *ParticleJobParams = PushArray(ScopedMemory.Arena, MaxParticleJobCount, process_particles_job);
+                u32 ParticleEmitterCount = 0;
+                particle_emitter **ParticleEmitters = PushArray(ScopedMemory.Arena, Area->EntityCount, particle_emitter *, NoClear());
 
                 for (u32 EntityIndex = 0; EntityIndex < Area->EntityCount; ++EntityIndex)
                 {
@@ -2765,24 +5677,16 @@ DLLExport GAME_RENDER(GameRender)
 
                     if (!Entity->Destroyed && Entity->ParticleEmitter)
                     {
-                        job *Job = ParticleJobs + ParticleJobCount;
-                        process_particles_job *JobData = ParticleJobParams + ParticleJobCount;
-
-                        ++ParticleJobCount;
-
-                        JobData->ParticleEmitter = Entity->ParticleEmitter;
-                        JobData->CameraPosition = Camera->Position;
-                        JobData->Delta = Params->Delta;
-
-                        Job->EntryPoint = ProcessParticlesJob;
-                        Job->Parameters = JobData;
+                        ParticleEmitters[ParticleEmitterCount++] = Entity->ParticleEmitter;
                     }
                 }
 
-                if (ParticleJobCount > 0)
-                {
-                    Platform->KickJobsAndWait(State->JobQueue, ParticleJobCount, ParticleJobs);
-                }
+                process_particles_range ParticleParams = {};
+                ParticleParams.ParticleEmitters = ParticleEmitters;
+                ParticleParams.CameraPosition = Camera->Position;
+                ParticleParams.Delta = Params->Delta;
+
+                ParallelFor(Platform, State->JobQueue, &State->ProcessParticlesLoop, "ProcessParticlesRange", ParticleEmitterCount, ProcessParticlesRange, &ParticleParams, ScopedMemory.Arena);
             }   
 
             {
@@ -2802,7 +5706,7 @@ DLLExport GAME_RENDER(GameRender)
 
                             if (State->Mode == GameMode_Editor)
                             {
-                                DrawBillboard(RenderCommands, Entity->Transform.Translation, vec2(0.2f), GetTextureAsset(&State->Assets, "particle_emitter"));
+                                DrawBillboard(RenderCommands, Entity->Transform.Translation, vec2(0.2f), UseTexture(&State->Assets, "particle_emitter"));
                             }
                         }
                     }
@@ -4,6 +4,13 @@
 #define PROFILER 1
 #define ASSERT 1
 
+// Arena pushes and scoped_memory regions tagged by the call site (see memory_call_site)
+#ifdef _DEBUG
+#define MEMORY_TELEMETRY 1
+#else
+#define MEMORY_TELEMETRY 0
+#endif
+
 #define SID(String) Hash(String)
 #define MAX_ENTITY_NAME 256
 
@@ -27,13 +34,20 @@
 #include "dummy_particles.h"
 #include "dummy_animation.h"
 #include "dummy_animator.h"
+#include "dummy_mesh_codec.h"
 #include "dummy_assets.h"
 #include "dummy_audio.h"
 #include "dummy_renderer.h"
+#include "dummy_lighting.h"
+#include "dummy_occlusion.h"
 #include "dummy_text.h"
 #include "dummy_save.h"
 #include "dummy_job.h"
 #include "dummy_profiler.h"
+#include "dummy_profiler_budget.h"
+#include "dummy_profiler_trace.h"
+#include "dummy_cvar.h"
+#include "dummy_benchmark.h"
 #include "dummy_platform.h"
 
 struct game_assets;
@@ -72,6 +86,20 @@ enum game_mode
     GameMode_Editor
 };
 
+struct mesh_instance_buffer;
+struct world_cell;
+
+// Meshes with fewer clusters are always drawn whole
+#define MIN_CULLED_MESH_CLUSTER_COUNT 16
+
+// Compacted index ranges of the visible clusters of a mesh
+struct mesh_cluster_ranges
+{
+    u32 RangeCount;
+    u32 *IndexOffsets;
+    u32 *IndexCounts;
+};
+
 struct game_entity
 {
     u32 Id;
@@ -99,12 +127,88 @@ struct game_entity
     u32 AudioSourceIndex;
 #endif
 
+    // Slot in the persistent instance buffer of the model
+    mesh_instance_buffer *InstanceBuffer;
+    u32 InstanceIndex;
+
+    // Mesh LOD selected for the current frame
+    u32 LodIndex;
+
+    // Per model mesh, set for the current frame when cluster culling is done
+    mesh_cluster_ranges *ClusterRanges;
+
+    // Hidden behind the occluders, animation updates are postponed meanwhile
+    bool32 Occluded;
+    f32 SkippedAnimationDelta;
+
     // ?
     vec3 DebugColor;
     bool32 Visible;
     bool32 Destroyed;
     bool32 IsGrounded;
     bool32 IsManipulated;
+
+    // Partition cell the entity is in, 0 for the entities that are not streamed (see world_partition)
+    world_cell *Cell;
+    // Cell and the record of the area file the entity was instantiated from, the entity can move out of it
+    world_cell *HomeCell;
+    u32 HomeRecordIndex;
+
+    // Heap block with the skinning and the animation graph (see InitEntityModel)
+    void *ModelMemory;
+};
+
+enum world_cell_state
+{
+    WorldCell_Unloaded,
+    WorldCell_Loading,
+    WorldCell_Resident,
+    WorldCell_Unloading
+};
+
+struct world_cell
+{
+    world_cell_state State;
+    aabb Bounds;
+
+    // 0 for the cells without entities in the file
+    world_area_file_chunk *Chunk;
+
+    // Records of the chunk instantiated so far and the read positions in its sections
+    u32 LoadedRecordCount;
+    u8 *SectionAt[WorldAreaSection_Count];
+    // Ran out of the entity slots, logged once until it loads again
+    bool32 LoadStalled;
+
+    // Id of the live entity instantiated from each record of the chunk, 0 when there is none.
+    // Records with a live entity (one that moved to another cell) are skipped when the cell is loaded again.
+    u32 *RecordEntityIds;
+
+    u32 EntityCount;
+};
+
+/*
+    Chunked area files are split into cells (one per chunk of the file grid), the cells around the active camera are resident.
+    Cells are loaded within the load radius and unloaded past the unload radius, so the cells at the border don't thrash.
+    Loading is spread over frames (see WORLD_AREA_LOAD_ENTITIES_PER_FRAME), models are streamed in by the model residency.
+    Entities moving across the cell borders are handed off to the cell they move into, their records are skipped
+    when the cell they came from is loaded again (see world_cell::RecordEntityIds).
+*/
+struct world_partition
+{
+    bool32 Active;
+    char FileName[256];
+
+    // Area file, kept in the world area arena
+    u8 *Contents;
+    world_area_file_header *Header;
+    char *Strings;
+
+    ivec2 CellCount;
+    world_cell *Cells;
+
+    u32 ResidentCellCount;
+    u32 LoadingCellCount;
 };
 
 struct world_area
@@ -115,21 +219,54 @@ struct world_area
     spatial_hash_grid SpatialGrid;
     memory_arena Arena;
 
-#if 0
-    model *Models[1024];
-    skinning_data Skins[256];
-    animation_graph AnimationGraphs[256];
-    collider Colliders[1024];
-    rigid_body Bodies[512];
-    point_light PointLight[64];
-    particle_emitter ParticleEmitters[64];
-    audio_source AudioSources[64];
-#endif
+    // Slots of the destroyed entities, reused by the new ones
+    u32 FreeEntityCount;
+    u32 *FreeEntityIndices;
+
+    world_partition Partition;
+
+    // Components are returned to the pools when the entities are removed, pools are in the area arena
+    memory_pool<collider> Colliders;
+    memory_pool<rigid_body> Bodies;
+    memory_pool<point_light> PointLights;
+    memory_pool<particle_emitter> ParticleEmitters;
+    memory_pool<audio_source> AudioSources;
+
+    // Variable-sized component data: particles, skinning and animation graphs
+    tlsf_heap Heap;
+};
+
+// Area arena is reserved up front and grows as needed
+#define WORLD_AREA_ARENA_RESERVED_SIZE Gigabytes(4)
+#define WORLD_AREA_HEAP_SIZE Megabytes(64)
+
+// Persistent (across frames) instance data of all entities sharing the same model,
+// only the modified range is uploaded to the renderer
+#define INSTANCE_HEAP_SIZE Megabytes(64)
+
+struct mesh_instance_buffer
+{
+    char Key[256];
+    u32 InstanceBufferId;
+
+    u32 InstanceCount;
+    u32 MaxInstanceCount;
+    mesh_instance *Instances;
+
+    // Slots of the destroyed entities
+    u32 FreeInstanceCount;
+    u32 *FreeInstanceIndices;
+
+    // [DirtyStartIndex, DirtyEndIndex)
+    u32 DirtyStartIndex;
+    u32 DirtyEndIndex;
 };
 
 struct entity_render_batch
 {
     char Key[256];
+    // Occluded from the player camera, drawn only into the shadow maps
+    bool32 ShadowOnly;
     u32 EntityCount;
     u32 MaxEntityCount;
     game_entity **Entities;
@@ -139,7 +276,12 @@ struct entity_render_batch
 
     union
     {
-        mesh_instance *MeshInstances;
+        // Visible instances of InstanceBuffer
+        struct
+        {
+            mesh_instance_buffer *InstanceBuffer;
+            u32 *InstanceIndices;
+        };
         skinned_mesh_instance *SkinnedMeshInstances;
     };
 };
@@ -148,12 +290,18 @@ struct game_asset
 {
     char Name[128];
     char Path[128];
+    // Size of the asset file
+    u64 Size;
+    // Set when the asset is resolved from the asset pack, Path is empty then
+    asset_pack_entry *PackEntry;
 };
 
+// Loaded model data is owned by the model record (see model_residency)
 struct game_asset_model
 {
     game_asset GameAsset;
-    model_asset *ModelAsset;
+    // Compressed meshes are decoded into the model block (see model_asset_header)
+    u64 DecodedMeshesSize;
 };
 
 struct game_asset_font
@@ -162,18 +310,23 @@ struct game_asset_font
     font_asset *FontAsset;
 };
 
+// Parsed into the block of the texture by its load job
 struct game_asset_texture
 {
     game_asset GameAsset;
     texture_asset *TextureAsset;
 };
 
+// Parsed into the block of the audio clip by its load job
 struct game_asset_audio_clip
 {
     game_asset GameAsset;
     audio_clip_asset *AudioAsset;
 };
 
+// Asset loads in flight at once (background job queue holds at most 1024 jobs)
+#define MAX_LOADING_ASSET_COUNT 16
+
 enum game_assets_state
 {
     GameAssetsState_Unloaded,
@@ -200,7 +353,29 @@ struct game_assets
     u32 AudioClipAssetCount;
     game_asset_audio_clip *AudioClipAssets;
 
-    game_assets_state State;
+    game_assets_state volatile State;
+
+    // Memory-mapped asset pack, assets are read from loose files if it is missing
+    map_file_result Pack;
+    u32 PackEntryCount;
+    asset_pack_entry *PackEntries;
+    // Loose files written after the pack take precedence over its entries (see GetGameAssets)
+    u64 PackFileDate;
+
+    // Time LoadGameAssets takes to list the assets (in milliseconds)
+    f32 LoadTime;
+
+    // Models, textures and audio clips are streamed in on first use and evicted in least recently used order when over the budget
+    free_list_allocator AssetAllocator;
+    // Budget the allocator was sized for (in megabytes), the budget option can only be lowered below it
+    i32 MaxMemoryBudget;
+    model ResidentModelSentinel;
+    texture ResidentTextureSentinel;
+    u32 ResidentModelCount;
+    u32 ResidentTextureCount;
+    u32 ResidentAudioClipCount;
+    u32 LoadingAssetCount;
+    u64 FrameIndex;
 
     memory_arena Arena;
 };
@@ -216,6 +391,36 @@ struct game_options
     bool32 ShowSkybox;
     bool32 ShowSpatialGrid;
     bool32 WireframeMode;
+    bool32 EnableOcclusionCulling;
+
+    // Coarsest mesh LOD with the projected error below this value (in pixels) is used
+    f32 MaxLodScreenError;
+
+    // Memory for the streamed models, textures and audio clips (in megabytes)
+    i32 AssetMemoryBudget;
+
+    // Distances from the active camera to the world partition cells (in game mode, the editor keeps the whole area resident)
+    f32 CellLoadRadius;
+    f32 CellUnloadRadius;
+};
+
+// Console variables of the game code, see RegisterGameCVars
+struct game_cvars
+{
+    cvar *ClusterCullingBatchThreshold;
+    cvar *MaxGroundProbeEntityCount;
+    cvar *MaxNearbyEntityCount;
+    cvar *SpatialGridCellSize;
+    cvar *AnimationArenaSize;
+};
+
+// Camera of the fly-through benchmark laps around a streamed area, the partition is checked every frame (see UpdateBenchmarkFlyThrough)
+struct benchmark_fly_through
+{
+    bool32 Active;
+    u32 FrameIndex;
+    // Records in the area file
+    u32 AreaEntityCount;
 };
 
 struct game_menu_quad
@@ -231,6 +436,8 @@ struct game_state
     memory_arena FrameArena;
 
     job_queue *JobQueue;
+    // Long-running jobs (asset streaming), the frame never waits for them
+    job_queue *BackgroundJobQueue;
 
     stream PermanentStream;
     stream FrameStream;
@@ -246,23 +453,37 @@ struct game_state
     polyhedron Frustrum;
     plane Ground;
 
+    occlusion_buffer OcclusionBuffer;
+    bool32 DumpOcclusionBuffer;
+
     game_assets Assets;
     animator Animator;
 
-    u32 NextFreeEntityId;
     u32 NextFreeMeshId;
     u32 NextFreeTextureId;
     u32 NextFreeSkinningId;
+    u32 NextFreeInstanceBufferId;
     u32 NextFreeProcessId;
     u32 NextFreeAudioSourceId;
 
     u32 RenderableEntityCount;
     u32 ActiveEntitiesCount;
+    // Visible entities drawn as placeholders, their models weren't resident yet
+    u32 ResidencyMissCount;
+
+    // Cluster culled meshes only
+    u32 TotalClusterCount;
+    u32 VisibleClusterCount;
+    u32 TotalTriangleCount;
+    u32 SubmittedTriangleCount;
 
     game_entity *Player;
     game_entity *SelectedEntity;
 
     hash_table<entity_render_batch> EntityBatches;
+    hash_table<mesh_instance_buffer> InstanceBuffers;
+    // Instance arrays are reallocated as the buffers grow
+    tlsf_heap InstanceHeap;
 
     directional_light DirectionalLight;
 
@@ -283,10 +504,23 @@ struct game_state
     vec2 CurrentMove;
 
     game_options Options;
+    game_cvars CVars;
     game_menu_quad MenuQuads[4];
 
+    // Parallel loops over the entities, see ParallelFor
+    parallel_for_site UpdateEntitiesLoop;
+    parallel_for_site AnimateEntitiesLoop;
+    parallel_for_site ProcessEntitiesLoop;
+    parallel_for_site TestOcclusionLoop;
+    parallel_for_site CullMeshClustersLoop;
+    parallel_for_site ProcessParticlesLoop;
+
     bool32_state DanceMode;
 
+    benchmark_fly_through FlyThrough;
+    // Failed checks of the benchmark scenario since it was loaded (see GameGetBenchmarkStatus)
+    u32 BenchmarkCheckErrorCount;
+
     // todo:
     contact_resolver ContactResolver;
 
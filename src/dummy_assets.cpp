@@ -78,19 +78,25 @@ ReadAnimationGraph(animation_graph_asset *GraphAsset, u64 Offset, u8 *Buffer, me
     return TotalPrevNodeSize;
 }
 
-dummy_internal model_asset *
-LoadModelAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
+inline model_asset_header *
+GetModelAssetHeader(u8 *Buffer)
 {
-    model_asset *Result = PushType(Arena, model_asset);
-
-    read_file_result AssetFile = Platform->ReadFile(FileName, Arena, ReadBinary());
-    u8 *Buffer = (u8 *)AssetFile.Contents;
-
     asset_header *Header = GET_DATA_AT(Buffer, 0, asset_header);
 
     Assert(Header->Type == AssetType_Model);
+    Assert(Header->Version == MODEL_ASSET_VERSION);
+
+    model_asset_header *Result = GET_DATA_AT(Buffer, Header->DataOffset, model_asset_header);
+    return Result;
+}
+
+// Pointers into the buffer are kept, so it has to outlive the asset (compressed meshes are decoded into the arena)
+dummy_internal model_asset *
+ParseModelAsset(u8 *Buffer, memory_arena *Arena)
+{
+    model_asset *Result = PushType(Arena, model_asset);
 
-    model_asset_header *ModelHeader = GET_DATA_AT(Buffer, Header->DataOffset, model_asset_header);
+    model_asset_header *ModelHeader = GetModelAssetHeader(Buffer);
 
     Result->Bounds = ModelHeader->Bounds;
     Result->BoundsOBB = ModelHeader->BoundsOBB;
@@ -143,53 +149,59 @@ LoadModelAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
         Mesh->VertexCount = MeshHeader->VertexCount;
         Mesh->IndexCount = MeshHeader->IndexCount;
 
-        u32 VerticesOffset = 0;
+        Assert(MeshHeader->LodCount > 0 && MeshHeader->LodCount <= MAX_MESH_LOD_COUNT);
 
-        if (MeshHeader->HasPositions)
-        {
-            Mesh->Positions = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec3);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+        Mesh->LodCount = MeshHeader->LodCount;
+        CopyMemory(MeshHeader->Lods, Mesh->Lods, Mesh->LodCount * sizeof(mesh_lod));
 
-        if (MeshHeader->HasNormals)
-        {
-            Mesh->Normals = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec3);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+        Mesh->VertexEncoding = MeshHeader->VertexEncoding;
 
-        if (MeshHeader->HasTangents)
+        if (Mesh->VertexEncoding == MeshVertexEncoding_Quantized)
         {
-            Mesh->Tangents = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec3);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
+            Mesh->Quantized.PositionOffset = MeshHeader->PositionOffset;
+            Mesh->Quantized.PositionScale = MeshHeader->PositionScale;
         }
 
-        if (MeshHeader->HasBitangets)
-        {
-            Mesh->Bitangents = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec3);
-            VerticesOffset += sizeof(vec3) * MeshHeader->VertexCount;
-        }
+        mesh_vertex_stream Streams[MAX_MESH_VERTEX_STREAM_COUNT];
+        u32 StreamCount = GetMeshVertexStreams(Mesh, MeshHeader, Streams);
 
-        if (MeshHeader->HasTextureCoords)
-        {
-            Mesh->TextureCoords = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec2);
-            VerticesOffset += sizeof(vec2) * MeshHeader->VertexCount;
-        }
+        u64 VerticesOffset = MeshHeader->VerticesOffset;
 
-        if (MeshHeader->HasWeights)
+        if (MeshHeader->StreamCodecVersion)
         {
-            Mesh->Weights = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, vec4);
-            VerticesOffset += sizeof(vec4) * MeshHeader->VertexCount;
-        }
+            Assert(MeshHeader->StreamCodecVersion == MESH_STREAM_CODEC_VERSION);
+
+            for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+            {
+                mesh_vertex_stream *Stream = Streams + StreamIndex;
 
-        if (MeshHeader->HasJointIndices)
+                *Stream->Data = PushSize(Arena, Mesh->VertexCount * Stream->Stride, AlignNoClear(16));
+                VerticesOffset += DecodeVertexStream(*Stream->Data, Mesh->VertexCount, Stream->Stride, Buffer + VerticesOffset);
+            }
+
+            Assert(VerticesOffset == MeshHeader->IndicesOffset);
+
+            Mesh->Indices = PushArray(Arena, Mesh->IndexCount, u32, AlignNoClear(16));
+            DecodeIndexBuffer(Mesh->Indices, Mesh->IndexCount, GET_DATA_AT(Buffer, MeshHeader->IndicesOffset, u8));
+        }
+        else
         {
-            Mesh->JointIndices = GET_DATA_AT(Buffer, MeshHeader->VerticesOffset + VerticesOffset, ivec4);
-            VerticesOffset += sizeof(ivec4) * MeshHeader->VertexCount;
+            for (u32 StreamIndex = 0; StreamIndex < StreamCount; ++StreamIndex)
+            {
+                mesh_vertex_stream *Stream = Streams + StreamIndex;
+
+                *Stream->Data = GET_DATA_AT(Buffer, VerticesOffset, void);
+                VerticesOffset += Mesh->VertexCount * Stream->Stride;
+            }
+
+            Mesh->Indices = GET_DATA_AT(Buffer, MeshHeader->IndicesOffset, u32);
         }
 
-        Mesh->Indices = GET_DATA_AT(Buffer, MeshHeader->IndicesOffset, u32);
+        Mesh->ClusterCount = MeshHeader->ClusterCount;
+        Mesh->Clusters = GET_DATA_AT(Buffer, MeshHeader->ClustersOffset, mesh_cluster);
 
-        NextMeshHeaderOffset += sizeof(model_asset_mesh_header) + VerticesOffset + MeshHeader->IndexCount * sizeof(u32);
+        // Clusters are the last part of the mesh
+        NextMeshHeaderOffset = MeshHeader->ClustersOffset + MeshHeader->ClusterCount * sizeof(mesh_cluster) - MeshesHeader->MeshesOffset;
     }
 
     // Materials
@@ -245,10 +257,27 @@ LoadModelAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
                 case MaterialProperty_Texture_Roughness:
                 case MaterialProperty_Texture_Normal:
                 {
-                    MaterialProperty->Bitmap = MaterialPropertyHeader->Bitmap;
-                    MaterialProperty->Bitmap.Pixels = GET_DATA_AT(Buffer, MaterialPropertyHeader->BitmapOffset, void);
+                    bitmap *Bitmap = &MaterialProperty->Bitmap;
 
-                    u32 BitmapSize = MaterialProperty->Bitmap.Width * MaterialProperty->Bitmap.Height * MaterialProperty->Bitmap.Channels;
+                    *Bitmap = MaterialPropertyHeader->Bitmap;
+                    Bitmap->Pixels = GET_DATA_AT(Buffer, MaterialPropertyHeader->BitmapOffset, void);
+                    Bitmap->Mips = 0;
+
+                    // Mip chain is stored level after level
+                    if (Bitmap->Format != BitmapFormat_Raw)
+                    {
+                        Bitmap->Mips = PushArray(Arena, Bitmap->MipCount, void *);
+
+                        u32 MipOffset = 0;
+
+                        for (u32 MipIndex = 0; MipIndex < Bitmap->MipCount; ++MipIndex)
+                        {
+                            Bitmap->Mips[MipIndex] = (u8 *)Bitmap->Pixels + MipOffset;
+                            MipOffset += GetBitmapMipSize(Bitmap->Format, Bitmap->Width, Bitmap->Height, MipIndex);
+                        }
+                    }
+
+                    u32 BitmapSize = GetBitmapDataSize(Bitmap);
 
                     NextMaterialPropertyHeaderOffset += sizeof(model_asset_material_property_header) + BitmapSize;
 
@@ -304,13 +333,10 @@ LoadModelAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
 }
 
 dummy_internal font_asset *
-LoadFontAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
+ParseFontAsset(u8 *Buffer, memory_arena *Arena)
 {
     font_asset *Result = PushType(Arena, font_asset);
 
-    read_file_result AssetFile = Platform->ReadFile(FileName, Arena, ReadBinary());
-    u8 *Buffer = (u8 *) AssetFile.Contents;
-
     asset_header *Header = GET_DATA_AT(Buffer, 0, asset_header);
 
     Assert(Header->Type == AssetType_Font);
@@ -339,13 +365,10 @@ LoadFontAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
 }
 
 dummy_internal audio_clip_asset *
-LoadAudioClipAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
+ParseAudioClipAsset(u8 *Buffer, memory_arena *Arena)
 {
     audio_clip_asset *Result = PushType(Arena, audio_clip_asset);
 
-    read_file_result AssetFile = Platform->ReadFile(FileName, Arena, ReadBinary());
-    u8 *Buffer = (u8 *) AssetFile.Contents;
-
     asset_header *Header = GET_DATA_AT(Buffer, 0, asset_header);
 
     Assert(Header->Type == AssetType_AudioClip);
@@ -363,16 +386,14 @@ LoadAudioClipAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
 }
 
 dummy_internal texture_asset *
-LoadTextureAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
+ParseTextureAsset(u8 *Buffer, memory_arena *Arena)
 {
     texture_asset *Result = PushType(Arena, texture_asset);
 
-    read_file_result AssetFile = Platform->ReadFile(FileName, Arena, ReadBinary());
-    u8 *Buffer = (u8 *)AssetFile.Contents;
-
     asset_header *Header = GET_DATA_AT(Buffer, 0, asset_header);
 
     Assert(Header->Type == AssetType_Texture);
+    Assert(Header->Version == TEXTURE_ASSET_VERSION);
 
     texture_asset_header *TextureHeader = GET_DATA_AT(Buffer, Header->DataOffset, texture_asset_header);
 
@@ -380,6 +401,7 @@ LoadTextureAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
     Result->Bitmap.Height = TextureHeader->Height;
     Result->Bitmap.Channels = TextureHeader->Channels;
     Result->Bitmap.IsHDR = TextureHeader->IsHDR;
+    Result->Bitmap.Format = TextureHeader->Format;
 
     if (Result->Bitmap.IsHDR)
     {
@@ -390,6 +412,140 @@ LoadTextureAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
         Result->Bitmap.Pixels = GET_DATA_AT(Buffer, TextureHeader->PixelsOffset, u8);
     }
 
+    if (Result->Bitmap.Format != BitmapFormat_Raw)
+    {
+        Result->Bitmap.MipCount = TextureHeader->MipCount;
+        Result->Bitmap.Mips = PushArray(Arena, TextureHeader->MipCount, void *);
+
+        for (u32 MipIndex = 0; MipIndex < TextureHeader->MipCount; ++MipIndex)
+        {
+            Result->Bitmap.Mips[MipIndex] = GET_DATA_AT(Buffer, TextureHeader->PixelsOffset + TextureHeader->MipOffsets[MipIndex], void);
+        }
+    }
+
+    return Result;
+}
+
+dummy_internal model_asset *
+LoadModelAsset(platform_api *Platform, char *FileName, memory_arena *Arena)
+{
+    read_file_result AssetFile = Platform->ReadFile(FileName, Arena, ReadBinary());
+    model_asset *Result = ParseModelAsset((u8 *)AssetFile.Contents, Arena);
+
+    return Result;
+}
+
+inline bool32
+AssetPackEntryLess(asset_type TypeA, u64 NameHashA, asset_type TypeB, u64 NameHashB)
+{
+    bool32 Result = TypeA < TypeB || (TypeA == TypeB && NameHashA < NameHashB);
+    return Result;
+}
+
+dummy_internal bool32
+OpenAssetPack(game_assets *Assets, platform_api *Platform, char *FileName)
+{
+    bool32 Result = false;
+
+    Assets->Pack = Platform->MapFile(FileName);
+
+    if (Assets->Pack.Contents)
+    {
+        asset_pack_header *Header = GET_DATA_AT(Assets->Pack.Contents, 0, asset_pack_header);
+
+        if (Header->MagicValue == ASSET_PACK_MAGIC_VALUE && Header->Version == ASSET_PACK_VERSION)
+        {
+            Assets->PackEntryCount = Header->EntryCount;
+            Assets->PackEntries = GET_DATA_AT(Assets->Pack.Contents, Header->EntriesOffset, asset_pack_entry);
+
+            wchar PackFileName[256];
+            ConvertToWideString(FileName, PackFileName);
+
+            get_files_result GetFilesResult = Platform->GetFiles(PackFileName, &Assets->Arena);
+            Assets->PackFileDate = GetFilesResult.Files[0].FileDate;
+
+            Result = true;
+        }
+        else
+        {
+            // Pack from an older builder
+            Platform->UnmapFile(&Assets->Pack);
+        }
+    }
+
+    return Result;
+}
+
+// Index of the first entry which is not less than (Type, NameHash)
+dummy_internal u32
+FindAssetPackEntryIndex(game_assets *Assets, asset_type Type, u64 NameHash)
+{
+    u32 Low = 0;
+    u32 High = Assets->PackEntryCount;
+
+    while (Low < High)
+    {
+        u32 Middle = Low + (High - Low) / 2;
+        asset_pack_entry *Entry = Assets->PackEntries + Middle;
+
+        if (AssetPackEntryLess(Entry->Type, Entry->NameHash, Type, NameHash))
+        {
+            Low = Middle + 1;
+        }
+        else
+        {
+            High = Middle;
+        }
+    }
+
+    return Low;
+}
+
+// Entries of the same type are stored next to each other
+dummy_internal asset_pack_entry *
+GetAssetPackEntries(game_assets *Assets, asset_type Type, u32 *EntryCount)
+{
+    u32 FirstIndex = FindAssetPackEntryIndex(Assets, Type, 0);
+    u32 LastIndex = FindAssetPackEntryIndex(Assets, (asset_type)(Type + 1), 0);
+
+    *EntryCount = LastIndex - FirstIndex;
+
+    asset_pack_entry *Result = Assets->PackEntries + FirstIndex;
+    return Result;
+}
+
+dummy_internal asset_pack_entry *
+FindAssetPackEntry(game_assets *Assets, asset_type Type, const char *Name)
+{
+    asset_pack_entry *Result = 0;
+
+    u64 NameHash = Hash(Name);
+
+    for (u32 EntryIndex = FindAssetPackEntryIndex(Assets, Type, NameHash); EntryIndex < Assets->PackEntryCount; ++EntryIndex)
+    {
+        asset_pack_entry *Entry = Assets->PackEntries + EntryIndex;
+
+        if (Entry->Type != Type || Entry->NameHash != NameHash)
+        {
+            break;
+        }
+
+        if (StringEquals(Entry->Name, Name))
+        {
+            Result = Entry;
+            break;
+        }
+    }
+
+    return Result;
+}
+
+inline u8 *
+GetAssetPackData(game_assets *Assets, asset_pack_entry *Entry)
+{
+    Assert(Entry->Offset + Entry->Size <= Assets->Pack.Size);
+
+    u8 *Result = GET_DATA_AT(Assets->Pack.Contents, Entry->Offset, u8);
     return Result;
 }
 
@@ -416,6 +572,22 @@ GetAudioClipAsset(game_assets *Assets, const char *Name)
     return Result;
 }
 
+inline bool32
+IsAudioClipResident(audio_clip *AudioClip)
+{
+    bool32 Result = AudioClip->Residency.State == AssetResidency_Resident;
+    return Result;
+}
+
+inline void
+RequestAudioClip(audio_clip *AudioClip)
+{
+    if (AudioClip->Residency.State == AssetResidency_Unloaded)
+    {
+        AudioClip->Residency.State = AssetResidency_Requested;
+    }
+}
+
 dummy_internal texture *
 GetTextureAsset(game_assets *Assets, const char *Name)
 {
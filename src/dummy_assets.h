@@ -24,6 +24,24 @@ enum material_property_type
     MaterialProperty_Texture_Normal
 };
 
+enum bitmap_format
+{
+    // Channels bytes (or floats if IsHDR) per pixel, mips are generated when the texture is uploaded
+    BitmapFormat_Raw,
+
+    // 4x4 blocks with the whole mip chain built offline
+    BitmapFormat_BC1,
+    BitmapFormat_BC3,
+    BitmapFormat_BC4,
+    BitmapFormat_BC5,
+
+    // Color textures, decoded to linear space when sampled
+    BitmapFormat_BC1_SRGB,
+    BitmapFormat_BC3_SRGB
+};
+
+#define MAX_BITMAP_MIP_COUNT 16
+
 struct bitmap
 {
     i32 Width;
@@ -31,6 +49,11 @@ struct bitmap
     i32 Channels;
     bool32 IsHDR;
     void *Pixels;
+
+    bitmap_format Format;
+    // Compressed formats only, Mips[0] is the same as Pixels
+    u32 MipCount;
+    void **Mips;
 };
 
 enum material_shading_mode
@@ -63,6 +86,65 @@ struct mesh_material
     material_property *Properties;
 };
 
+#define MAX_MESH_LOD_COUNT 5
+
+// Range of the mesh index buffer with simplified geometry, Error is the object-space deviation from the source mesh
+struct mesh_lod
+{
+    u32 IndexOffset;
+    u32 IndexCount;
+    f32 Error;
+};
+
+// Meshlet of the most detailed LOD, bounds are in object space
+struct mesh_cluster
+{
+    vec3 Center;
+    f32 Radius;
+
+    // Cluster is backfacing when viewed from inside of the cone
+    vec3 ConeApex;
+    vec3 ConeAxis;
+    f32 ConeCutoff;
+
+    u32 IndexOffset;
+    u32 IndexCount;
+};
+
+enum mesh_vertex_encoding
+{
+    MeshVertexEncoding_Float,
+    MeshVertexEncoding_Quantized
+};
+
+// Unorm16 position inside the mesh bounds, w keeps the 8-byte stride
+struct quantized_position
+{
+    u16 x;
+    u16 y;
+    u16 z;
+    u16 w;
+};
+
+/*
+    Vertex streams as the vertex shaders read them (see mesh.vert), about 28 bytes per skinned vertex instead of 100.
+    Normals are octahedral snorm16x2, tangents are octahedral snorm16x2 with the bitangent sign folded in (see PackTangent),
+    texture coordinates are half2, weights are unorm8x4 and joint indices are u8x4.
+*/
+struct quantized_mesh_vertices
+{
+    // Position = PositionOffset + PositionScale * unorm16 position
+    vec3 PositionOffset;
+    vec3 PositionScale;
+
+    quantized_position *Positions;
+    u32 *Normals;
+    u32 *Tangents;
+    u32 *TextureCoords;
+    u32 *Weights;
+    u32 *JointIndices;
+};
+
 struct mesh
 {
     u32 MeshId;
@@ -70,6 +152,11 @@ struct mesh
     bool32 Visible;
 
     u32 VertexCount;
+
+    // Float streams are only set for MeshVertexEncoding_Float (the assets builder keeps both)
+    mesh_vertex_encoding VertexEncoding;
+    quantized_mesh_vertices Quantized;
+
     vec3 *Positions;
     vec3 *Normals;
     vec3 *Tangents;
@@ -78,17 +165,80 @@ struct mesh
     vec4 *Weights;
     ivec4 *JointIndices;
 
+    // Indices of all LODs, from the most detailed one
     u32 IndexCount;
     u32 *Indices;
+
+    u32 LodCount;
+    mesh_lod Lods[MAX_MESH_LOD_COUNT];
+
+    u32 ClusterCount;
+    mesh_cluster *Clusters;
 };
 
 struct animation_graph_asset;
 
+enum asset_residency_state
+{
+    AssetResidency_Unloaded,
+    AssetResidency_Requested,
+    AssetResidency_Loading,
+    // Loaded by the job, not yet added to the renderer (or the mixer)
+    AssetResidency_Loaded,
+    AssetResidency_Resident
+};
+
+struct model_residency
+{
+    asset_residency_state volatile State;
+
+    // Skinned models are never evicted, entities keep pointers into their skeletons
+    bool32 Pinned;
+    u64 LastUsedFrame;
+
+    u32 AssetIndex;
+
+    // Block of the asset allocator, starts with the load job
+    void *Block;
+    // Block of the load job that was still running when the model got replaced in the editor
+    void *ReleasedBlock;
+
+    // Ids are kept after eviction, so a reloaded model is added to the renderer under the same ids
+    u32 FirstMeshId;
+    u32 FirstTextureId;
+    u32 TextureCount;
+};
+
+// Textures and audio clips go through the same states as the models, in the same allocator and budget
+struct asset_residency
+{
+    asset_residency_state volatile State;
+
+    // Audio clips are never evicted, the mixer reads their samples for as long as the voices play
+    bool32 Pinned;
+    u64 LastUsedFrame;
+
+    u32 AssetIndex;
+
+    // Block of the asset allocator, starts with the load job
+    void *Block;
+};
+
+/*
+    Model records stay in the hash table for the whole run and are referenced by the entities.
+    Everything after BoundsOBB is only valid while the model is resident.
+*/
 struct model
 {
     char Key[64];
     u32 SkinningBufferId;
 
+    // Least recently used order of the resident models
+    model *Prev;
+    model *Next;
+
+    model_residency Residency;
+
     aabb Bounds;
     obb BoundsOBB;
 
@@ -99,6 +249,10 @@ struct model
     u32 MeshCount;
     mesh *Meshes;
 
+    // Largest error among the meshes for each LOD
+    u32 LodCount;
+    f32 LodErrors[MAX_MESH_LOD_COUNT];
+
     u32 MaterialCount;
     mesh_material *Materials;
 
@@ -262,10 +416,13 @@ struct font
     glyph *Glyphs;
 };
 
+// Audio clip records stay in the hash table for the whole run, the samples are only valid while the clip is resident
 struct audio_clip
 {
     char Key[64];
 
+    asset_residency Residency;
+
     u32 Format;
     u32 Channels;
     u32 SamplesPerSecond;
@@ -288,11 +445,18 @@ struct audio_clip_asset
     u8 *AudioData;
 };
 
+// Texture records stay in the hash table for the whole run, the id is kept after eviction and the bitmap is only valid while the texture is resident
 struct texture
 {
     char Key[64];
     u32 TextureId;
 
+    // Least recently used order of the resident textures
+    texture *Prev;
+    texture *Next;
+
+    asset_residency Residency;
+
     bitmap Bitmap;
 };
 
@@ -301,6 +465,24 @@ struct texture_asset
     bitmap Bitmap;
 };
 
+// Version 2: mesh LODs
+// Version 3: mesh clusters
+// Version 4: bitmap format (material property header)
+// Version 5: quantized vertex streams
+// Version 6: compressed vertex streams and indices (see dummy_mesh_codec.h)
+// Version 7: block-compressed material textures with mips
+#define MODEL_ASSET_VERSION 7
+
+// Version 2: block compression and mips
+// Version 3: sRGB formats
+#define TEXTURE_ASSET_VERSION 3
+
+#define ASSET_PACK_MAGIC_VALUE 0x4B434150
+#define ASSET_PACK_VERSION 1
+// Asset files are placed at aligned offsets, so the data inside them keeps its alignment when used in place
+#define ASSET_PACK_ALIGNMENT 64
+#define MAX_ASSET_PACK_NAME_LENGTH 128
+
 #pragma pack(push, 1)
 
 enum asset_type
@@ -331,6 +513,9 @@ struct model_asset_header
     u64 MeshesHeaderOffset;
     u64 MaterialsHeaderOffset;
     u64 AnimationsHeaderOffset;
+
+    // Memory for the decoded vertex streams and indices of the compressed meshes
+    u64 DecodedMeshesSize;
 };
 
 struct model_asset_skeleton_header
@@ -406,6 +591,16 @@ struct model_asset_mesh_header
     u32 VertexCount;
     u32 IndexCount;
 
+    u32 LodCount;
+    mesh_lod Lods[MAX_MESH_LOD_COUNT];
+
+    u32 ClusterCount;
+
+    // Quantized meshes have no bitangents (sign is folded into the tangents)
+    mesh_vertex_encoding VertexEncoding;
+    vec3 PositionOffset;
+    vec3 PositionScale;
+
     bool32 HasPositions;
     bool32 HasNormals;
     bool32 HasTangents;
@@ -414,8 +609,12 @@ struct model_asset_mesh_header
     bool32 HasWeights;
     bool32 HasJointIndices;
 
+    // MESH_STREAM_CODEC_VERSION if the vertex streams and indices are compressed, 0 if they are stored as is
+    u32 StreamCodecVersion;
+
     u64 VerticesOffset;
     u64 IndicesOffset;
+    u64 ClustersOffset;
 };
 
 struct model_asset_materials_header
@@ -506,6 +705,351 @@ struct texture_asset_header
     i32 Channels;
     bool32 IsHDR;
     u64 PixelsOffset;
+
+    bitmap_format Format;
+    u32 MipCount;
+    // Relative to PixelsOffset, compressed formats only
+    u64 MipOffsets[MAX_BITMAP_MIP_COUNT];
+};
+
+inline u32
+GetBitmapBlockSize(bitmap_format Format)
+{
+    u32 Result = 0;
+
+    switch (Format)
+    {
+        case BitmapFormat_BC1:
+        case BitmapFormat_BC1_SRGB:
+        case BitmapFormat_BC4:
+        {
+            Result = 8;
+            break;
+        }
+        case BitmapFormat_BC3:
+        case BitmapFormat_BC3_SRGB:
+        case BitmapFormat_BC5:
+        {
+            Result = 16;
+            break;
+        }
+        default:
+        {
+            Assert(!"Not a block-compressed format");
+        }
+    }
+
+    return Result;
+}
+
+inline i32
+GetBitmapMipDimension(i32 Dimension, u32 MipIndex)
+{
+    i32 Result = Dimension >> MipIndex;
+
+    if (Result < 1)
+    {
+        Result = 1;
+    }
+
+    return Result;
+}
+
+// Size of a level of a block-compressed bitmap (partial blocks are padded)
+inline u32
+GetBitmapMipSize(bitmap_format Format, i32 Width, i32 Height, u32 MipIndex)
+{
+    u32 BlockCountX = (GetBitmapMipDimension(Width, MipIndex) + 3) / 4;
+    u32 BlockCountY = (GetBitmapMipDimension(Height, MipIndex) + 3) / 4;
+
+    u32 Result = BlockCountX * BlockCountY * GetBitmapBlockSize(Format);
+    return Result;
+}
+
+// Texels of a raw bitmap or the whole mip chain of a block-compressed one, the levels are stored one after another
+inline u32
+GetBitmapDataSize(bitmap *Bitmap)
+{
+    u32 Result = 0;
+
+    if (Bitmap->Format == BitmapFormat_Raw)
+    {
+        Result = Bitmap->Width * Bitmap->Height * Bitmap->Channels * (Bitmap->IsHDR ? sizeof(f32) : sizeof(u8));
+    }
+    else
+    {
+        for (u32 MipIndex = 0; MipIndex < Bitmap->MipCount; ++MipIndex)
+        {
+            Result += GetBitmapMipSize(Bitmap->Format, Bitmap->Width, Bitmap->Height, MipIndex);
+        }
+    }
+
+    return Result;
+}
+
+inline vec3
+GetMeshVertexPosition(mesh *Mesh, u32 VertexIndex)
+{
+    vec3 Result;
+
+    if (Mesh->VertexEncoding == MeshVertexEncoding_Quantized)
+    {
+        quantized_mesh_vertices *Quantized = &Mesh->Quantized;
+        quantized_position Position = Quantized->Positions[VertexIndex];
+
+        vec3 Normalized = vec3(UnpackUnorm16(Position.x), UnpackUnorm16(Position.y), UnpackUnorm16(Position.z));
+
+        Result = Quantized->PositionOffset + Quantized->PositionScale * Normalized;
+    }
+    else
+    {
+        Result = Mesh->Positions[VertexIndex];
+    }
+
+    return Result;
+}
+
+inline u32
+GetQuantizedMeshVerticesSize(u32 VertexCount, quantized_mesh_vertices *Vertices)
+{
+    u32 Size = 0;
+
+    if (Vertices->Positions)
+    {
+        Size += VertexCount * sizeof(quantized_position);
+    }
+
+    if (Vertices->Normals)
+    {
+        Size += VertexCount * sizeof(u32);
+    }
+
+    if (Vertices->Tangents)
+    {
+        Size += VertexCount * sizeof(u32);
+    }
+
+    if (Vertices->TextureCoords)
+    {
+        Size += VertexCount * sizeof(u32);
+    }
+
+    if (Vertices->Weights)
+    {
+        Size += VertexCount * sizeof(u32);
+    }
+
+    if (Vertices->JointIndices)
+    {
+        Size += VertexCount * sizeof(u32);
+    }
+
+    return Size;
+}
+
+/*
+    Caller allocates a quantized stream for every float stream that is present (VertexCount elements each).
+    Bitangents are only used for the bitangent sign of the tangents.
+*/
+inline void
+QuantizeMeshVertices(
+    u32 VertexCount,
+    vec3 *Positions,
+    vec3 *Normals,
+    vec3 *Tangents,
+    vec3 *Bitangents,
+    vec2 *TextureCoords,
+    vec4 *Weights,
+    ivec4 *JointIndices,
+    quantized_mesh_vertices *Result
+)
+{
+    if (Positions && VertexCount > 0)
+    {
+        Assert(Result->Positions);
+
+        vec3 vMin = Positions[0];
+        vec3 vMax = Positions[0];
+
+        for (u32 VertexIndex = 1; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            vMin = Min(vMin, Positions[VertexIndex]);
+            vMax = Max(vMax, Positions[VertexIndex]);
+        }
+
+        Result->PositionOffset = vMin;
+        Result->PositionScale = vMax - vMin;
+
+        // Flat meshes have zero extent along one of the axes
+        vec3 InvScale = vec3(
+            Result->PositionScale.x > 0.f ? 1.f / Result->PositionScale.x : 0.f,
+            Result->PositionScale.y > 0.f ? 1.f / Result->PositionScale.y : 0.f,
+            Result->PositionScale.z > 0.f ? 1.f / Result->PositionScale.z : 0.f
+        );
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            vec3 Normalized = (Positions[VertexIndex] - vMin) * InvScale;
+
+            quantized_position *Position = Result->Positions + VertexIndex;
+            Position->x = PackUnorm16(Normalized.x);
+            Position->y = PackUnorm16(Normalized.y);
+            Position->z = PackUnorm16(Normalized.z);
+            Position->w = 0;
+        }
+    }
+
+    if (Normals)
+    {
+        Assert(Result->Normals);
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            Result->Normals[VertexIndex] = PackOctahedral(Normals[VertexIndex]);
+        }
+    }
+
+    if (Tangents)
+    {
+        Assert(Result->Tangents);
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            f32 BitangentSign = 1.f;
+
+            if (Normals && Bitangents)
+            {
+                BitangentSign = SignNotZero(Dot(Cross(Normals[VertexIndex], Tangents[VertexIndex]), Bitangents[VertexIndex]));
+            }
+
+            Result->Tangents[VertexIndex] = PackTangent(Tangents[VertexIndex], BitangentSign);
+        }
+    }
+
+    if (TextureCoords)
+    {
+        Assert(Result->TextureCoords);
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            vec2 TextureCoord = TextureCoords[VertexIndex];
+            Result->TextureCoords[VertexIndex] = PackHalf(TextureCoord.x) | ((u32)PackHalf(TextureCoord.y) << 16);
+        }
+    }
+
+    if (Weights)
+    {
+        Assert(Result->Weights);
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            vec4 Weight = Weights[VertexIndex];
+
+            i32 QuantizedWeights[4];
+            i32 Sum = 0;
+            u32 LargestIndex = 0;
+
+            for (u32 WeightIndex = 0; WeightIndex < 4; ++WeightIndex)
+            {
+                QuantizedWeights[WeightIndex] = Round(Clamp(Weight.Elements[WeightIndex], 0.f, 1.f) * 255.f);
+                Sum += QuantizedWeights[WeightIndex];
+
+                if (Weight.Elements[WeightIndex] > Weight.Elements[LargestIndex])
+                {
+                    LargestIndex = WeightIndex;
+                }
+            }
+
+            // Rounding error goes to the largest weight, so the weights still add up to one
+            QuantizedWeights[LargestIndex] += 255 - Sum;
+
+            Result->Weights[VertexIndex] = (u32)QuantizedWeights[0] | ((u32)QuantizedWeights[1] << 8) | ((u32)QuantizedWeights[2] << 16) | ((u32)QuantizedWeights[3] << 24);
+        }
+    }
+
+    if (JointIndices)
+    {
+        Assert(Result->JointIndices);
+
+        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+        {
+            ivec4 Indices = JointIndices[VertexIndex];
+
+            u32 Packed = 0;
+
+            for (u32 Index = 0; Index < 4; ++Index)
+            {
+                Assert(Indices.Elements[Index] >= 0 && Indices.Elements[Index] < 256);
+                Packed |= (u32)Indices.Elements[Index] << (Index * 8);
+            }
+
+            Result->JointIndices[VertexIndex] = Packed;
+        }
+    }
+}
+
+#define MAX_MESH_VERTEX_STREAM_COUNT 7
+
+struct mesh_vertex_stream
+{
+    // Stream pointer of the mesh
+    void **Data;
+    u32 Stride;
+};
+
+// Vertex streams present in the mesh header, in the order they are stored in the asset file
+inline u32
+GetMeshVertexStreams(mesh *Mesh, model_asset_mesh_header *Header, mesh_vertex_stream *Streams)
+{
+    u32 Result = 0;
+
+    if (Header->VertexEncoding == MeshVertexEncoding_Quantized)
+    {
+        quantized_mesh_vertices *Quantized = &Mesh->Quantized;
+
+        if (Header->HasPositions) Streams[Result++] = { (void **)&Quantized->Positions, sizeof(quantized_position) };
+        if (Header->HasNormals) Streams[Result++] = { (void **)&Quantized->Normals, sizeof(u32) };
+        if (Header->HasTangents) Streams[Result++] = { (void **)&Quantized->Tangents, sizeof(u32) };
+        if (Header->HasTextureCoords) Streams[Result++] = { (void **)&Quantized->TextureCoords, sizeof(u32) };
+        if (Header->HasWeights) Streams[Result++] = { (void **)&Quantized->Weights, sizeof(u32) };
+        if (Header->HasJointIndices) Streams[Result++] = { (void **)&Quantized->JointIndices, sizeof(u32) };
+    }
+    else
+    {
+        if (Header->HasPositions) Streams[Result++] = { (void **)&Mesh->Positions, sizeof(vec3) };
+        if (Header->HasNormals) Streams[Result++] = { (void **)&Mesh->Normals, sizeof(vec3) };
+        if (Header->HasTangents) Streams[Result++] = { (void **)&Mesh->Tangents, sizeof(vec3) };
+        if (Header->HasBitangets) Streams[Result++] = { (void **)&Mesh->Bitangents, sizeof(vec3) };
+        if (Header->HasTextureCoords) Streams[Result++] = { (void **)&Mesh->TextureCoords, sizeof(vec2) };
+        if (Header->HasWeights) Streams[Result++] = { (void **)&Mesh->Weights, sizeof(vec4) };
+        if (Header->HasJointIndices) Streams[Result++] = { (void **)&Mesh->JointIndices, sizeof(ivec4) };
+    }
+
+    Assert(Result <= MAX_MESH_VERTEX_STREAM_COUNT);
+
+    return Result;
+}
+
+/*
+    All asset files concatenated into a single file, which is memory-mapped at startup.
+    Table of contents is sorted by type and name hash, asset data is the unchanged content of the asset file.
+*/
+struct asset_pack_header
+{
+    u32 MagicValue;
+    u32 Version;
+    u32 EntryCount;
+    u64 EntriesOffset;
+};
+
+struct asset_pack_entry
+{
+    asset_type Type;
+    u64 NameHash;
+    char Name[MAX_ASSET_PACK_NAME_LENGTH];
+
+    u64 Offset;
+    u64 Size;
 };
 
 #pragma pack(pop)
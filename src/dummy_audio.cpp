@@ -10,6 +10,7 @@ PushAudioCommand_(audio_commands *Commands, u32 Size, audio_command_type Type)
     Result->Size = Size;
 
     Commands->AudioCommandsBufferSize += Size;
+    ++Commands->AudioCommandCount;
 
     return Result;
 }
@@ -9,6 +9,9 @@ struct audio_source
 
     bool32 IsPlaying;
     u32 Id;
+
+    // Waiting for the clip to be streamed in, there is no voice yet
+    bool32 Pending;
 };
 
 struct audio_play_options
@@ -101,5 +104,26 @@ struct audio_commands
     u32 AudioCommandsBufferSize;
     void *AudioCommandsBuffer;
 
+    // Buffer usage of the last processed frame, kept by ClearAudioCommands
+    u32 AudioCommandCount;
+    u32 PrevAudioCommandCount;
+    u32 PrevAudioCommandsBufferSize;
+    u32 HighWaterAudioCommandsBufferSize;
+
     audio_commands_settings Settings;
 };
+
+inline memory_stats
+GetMemoryStats(audio_commands *Commands)
+{
+    memory_stats Result = {};
+
+    Result.Used = Commands->PrevAudioCommandsBufferSize;
+    Result.HighWater = Commands->HighWaterAudioCommandsBufferSize;
+    Result.Committed = Commands->MaxAudioCommandsBufferSize;
+    Result.Size = Commands->MaxAudioCommandsBufferSize;
+    Result.FrameAllocationCount = Commands->PrevAudioCommandCount;
+    Result.FrameAllocatedSize = Commands->PrevAudioCommandsBufferSize;
+
+    return Result;
+}
@@ -0,0 +1,1005 @@
+#pragma once
+
+#include <stdlib.h>
+
+/*
+    Deterministic benchmark runs: the game code spawns a scenario from a seed (see GameLoadBenchmark),
+    the platform runs it with a fixed delta and collects the time of every profiler scope per frame.
+    Results are written as JSON and compared against a stored baseline, the run fails on a regression above the threshold.
+*/
+
+#define BENCHMARK_MAX_STAGE_COUNT 128
+// Differences below are noise, whatever the threshold
+#define BENCHMARK_MIN_REGRESSION_MILLISECONDS 0.05f
+#define BENCHMARK_FRAME_STAGE_NAME "Frame"
+// Runs start anyway if the scenario models never become resident (e.g. they don't fit into the budget)
+#define BENCHMARK_MAX_STREAMING_FRAME_COUNT 600
+
+enum benchmark_scenario
+{
+    BenchmarkScenario_BoxRain,
+    BenchmarkScenario_BotCrowd,
+    BenchmarkScenario_ParticleStorm,
+    BenchmarkScenario_LightForest,
+    BenchmarkScenario_MassSpawn,
+    BenchmarkScenario_FlyThrough,
+
+    BenchmarkScenario_Count
+};
+
+dummy_global const char *BenchmarkScenarioNames[] =
+{
+    "box_rain",
+    "bot_crowd",
+    "particle_storm",
+    "light_forest",
+    "mass_spawn",
+    "fly_through"
+};
+
+// BenchmarkScenario_Count if there is no such scenario
+inline benchmark_scenario
+FindBenchmarkScenario(const char *Name)
+{
+    benchmark_scenario Result = BenchmarkScenario_Count;
+
+    for (u32 ScenarioIndex = 0; ScenarioIndex < BenchmarkScenario_Count; ++ScenarioIndex)
+    {
+        if (StringEquals(Name, BenchmarkScenarioNames[ScenarioIndex]))
+        {
+            Result = (benchmark_scenario) ScenarioIndex;
+        }
+    }
+
+    return Result;
+}
+
+// Inclusive time of all the scopes with the same name (on every thread) per measured frame
+struct benchmark_stage
+{
+    char Name[64];
+    u32 NameIndex;
+    f32 *FrameMilliseconds;
+
+    f32 MedianMilliseconds;
+    f32 P99Milliseconds;
+};
+
+// Filled by the game code after every frame of the run (see GameGetBenchmarkStatus)
+struct benchmark_status
+{
+    // Failed checks of the scenario since it was loaded (e.g. the world partition along the fly-through path)
+    u32 CheckErrorCount;
+
+    // Nothing is loading and every requested asset is resident (see IsAssetStreamingIdle)
+    bool32 Ready;
+    // Visible entities drawn as placeholders in the last frame
+    u32 FrameResidencyMissCount;
+};
+
+enum benchmark_run_state
+{
+    BenchmarkRun_Loading,
+    // Scenario is loaded, the simulation is held until its models are streamed in
+    BenchmarkRun_Streaming,
+    BenchmarkRun_Running,
+    BenchmarkRun_Finished
+};
+
+struct benchmark_run
+{
+    benchmark_run_state State;
+    benchmark_scenario Scenario;
+    u32 Seed;
+
+    u32 WarmupFrameCount;
+    u32 FrameCount;
+    // Frames since the scenario was loaded
+    u32 FrameIndex;
+    u32 MeasuredFrameCount;
+    u32 StreamingFrameCount;
+
+    // Relative, 0.1 is 10% slower than the baseline
+    f32 Threshold;
+    char BaselineFileName[256];
+
+    u32 StageCount;
+    benchmark_stage Stages[BENCHMARK_MAX_STAGE_COUNT];
+
+    // Totals of the main job queue over the measured frames, the maximums are the worst frame
+    u64 TicksPerSecond;
+    job_queue_frame Jobs;
+
+    // Latest status of the game code, the run fails on any check error
+    benchmark_status Status;
+    // Placeholders drawn over the measured frames
+    u32 ResidencyMissCount;
+};
+
+inline benchmark_stage *
+GetBenchmarkStage(benchmark_run *Run, const char *Name, u32 NameIndex, memory_arena *Arena)
+{
+    benchmark_stage *Result = 0;
+
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount && !Result; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        if (Stage->NameIndex == NameIndex && StringEquals(Stage->Name, Name))
+        {
+            Result = Stage;
+        }
+    }
+
+    if (!Result && Run->StageCount < BENCHMARK_MAX_STAGE_COUNT)
+    {
+        Result = Run->Stages + Run->StageCount++;
+
+        CopyString(Name, Result->Name);
+        Result->NameIndex = NameIndex;
+        // Frames before the stage showed up for the first time stay at 0
+        Result->FrameMilliseconds = PushArray(Arena, Run->FrameCount, f32);
+    }
+
+    return Result;
+}
+
+// Called once per frame with the call tree of the previous frame
+dummy_internal void
+RecordBenchmarkFrame(benchmark_run *Run, platform_profiler *Profiler, memory_arena *Arena)
+{
+    Assert(Run->MeasuredFrameCount < Run->FrameCount);
+
+    profiler_frame_samples *Frame = ProfilerGetPreviousFrameSamples(Profiler);
+    u32 FrameIndex = Run->MeasuredFrameCount++;
+
+    benchmark_stage *FrameStage = GetBenchmarkStage(Run, BENCHMARK_FRAME_STAGE_NAME, PROFILER_NO_NODE, Arena);
+    FrameStage->FrameMilliseconds[FrameIndex] = GetProfilerMilliseconds(Profiler, Frame->EndTimestamp - Frame->StartTimestamp);
+
+    for (u32 NodeIndex = 0; NodeIndex < Frame->NodeCount; ++NodeIndex)
+    {
+        profiler_node *Node = Frame->Nodes + NodeIndex;
+        benchmark_stage *Stage = GetBenchmarkStage(Run, GetProfilerName(Profiler, Node->NameIndex), Node->NameIndex, Arena);
+
+        if (Stage)
+        {
+            Stage->FrameMilliseconds[FrameIndex] += GetProfilerMilliseconds(Profiler, Node->ElapsedTicks);
+        }
+    }
+}
+
+// Called once per frame with the job queue stats of the previous frame
+dummy_internal void
+RecordBenchmarkJobs(benchmark_run *Run, platform_profiler *Profiler, job_queue_frame *Frame)
+{
+    job_queue_frame *Jobs = &Run->Jobs;
+
+    Run->TicksPerSecond = Profiler->TicksPerSecond;
+
+    Jobs->WorkerCount = Frame->WorkerCount;
+
+    for (u32 WorkerIndex = 0; WorkerIndex < Frame->WorkerCount; ++WorkerIndex)
+    {
+        job_worker_stats *Worker = Jobs->Workers + WorkerIndex;
+        job_worker_stats *FrameWorker = Frame->Workers + WorkerIndex;
+
+        Worker->JobCount += FrameWorker->JobCount;
+        Worker->BusyTicks += FrameWorker->BusyTicks;
+        Worker->IdleTicks += FrameWorker->IdleTicks;
+        Worker->DequeueTicks += FrameWorker->DequeueTicks;
+        Worker->LockWaitTicks += FrameWorker->LockWaitTicks;
+    }
+
+    Jobs->Lock.AcquireCount += Frame->Lock.AcquireCount;
+    Jobs->Lock.WaitTicks += Frame->Lock.WaitTicks;
+    Jobs->Lock.HoldTicks += Frame->Lock.HoldTicks;
+
+    if (Frame->Lock.MaxWaitTicks > Jobs->Lock.MaxWaitTicks)
+    {
+        Jobs->Lock.MaxWaitTicks = Frame->Lock.MaxWaitTicks;
+    }
+
+    if (Frame->Lock.MaxHoldTicks > Jobs->Lock.MaxHoldTicks)
+    {
+        Jobs->Lock.MaxHoldTicks = Frame->Lock.MaxHoldTicks;
+    }
+
+    if (Frame->MaxQueueDepth > Jobs->MaxQueueDepth)
+    {
+        Jobs->MaxQueueDepth = Frame->MaxQueueDepth;
+    }
+
+    for (u32 FrameStageIndex = 0; FrameStageIndex < Frame->StageCount; ++FrameStageIndex)
+    {
+        job_stage_stats *FrameStage = Frame->Stages + FrameStageIndex;
+        job_stage_stats *Stage = 0;
+
+        for (u32 StageIndex = 0; StageIndex < Jobs->StageCount && !Stage; ++StageIndex)
+        {
+            if (StringEquals(Jobs->Stages[StageIndex].Name, FrameStage->Name))
+            {
+                Stage = Jobs->Stages + StageIndex;
+            }
+        }
+
+        if (!Stage && Jobs->StageCount < JOB_MAX_STAGE_COUNT)
+        {
+            Stage = Jobs->Stages + Jobs->StageCount++;
+            CopyString(FrameStage->Name, Stage->Name);
+        }
+
+        if (Stage)
+        {
+            Stage->BatchCount += FrameStage->BatchCount;
+            Stage->JobCount += FrameStage->JobCount;
+            Stage->JobTicks += FrameStage->JobTicks;
+            Stage->SlowestJobTicks += FrameStage->SlowestJobTicks;
+            Stage->MeanJobTicks += FrameStage->MeanJobTicks;
+            Stage->WaitTicks += FrameStage->WaitTicks;
+        }
+    }
+}
+
+// Insertion sort into Dest, there are at most a few thousand values
+inline void
+SortBenchmarkValues(f32 *Values, f32 *Dest, u32 Count)
+{
+    for (u32 ValueIndex = 0; ValueIndex < Count; ++ValueIndex)
+    {
+        f32 Value = Values[ValueIndex];
+        u32 InsertIndex = ValueIndex;
+
+        while (InsertIndex > 0 && Dest[InsertIndex - 1] > Value)
+        {
+            Dest[InsertIndex] = Dest[InsertIndex - 1];
+            --InsertIndex;
+        }
+
+        Dest[InsertIndex] = Value;
+    }
+}
+
+// Nearest rank of the sorted values
+inline f32
+GetBenchmarkPercentile(f32 *SortedValues, u32 Count, f32 Percentile)
+{
+    u32 Rank = (u32) Ceil(Percentile * (f32) Count);
+    u32 Index = Rank > 0 ? Rank - 1 : 0;
+
+    if (Index >= Count)
+    {
+        Index = Count - 1;
+    }
+
+    f32 Result = SortedValues[Index];
+    return Result;
+}
+
+dummy_internal void
+FinishBenchmarkRun(benchmark_run *Run, memory_arena *Arena)
+{
+    scoped_memory ScopedMemory(Arena);
+
+    f32 *SortedValues = PushArray(ScopedMemory.Arena, Run->FrameCount, f32, NoClear());
+
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        SortBenchmarkValues(Stage->FrameMilliseconds, SortedValues, Run->MeasuredFrameCount);
+
+        Stage->MedianMilliseconds = GetBenchmarkPercentile(SortedValues, Run->MeasuredFrameCount, 0.5f);
+        Stage->P99Milliseconds = GetBenchmarkPercentile(SortedValues, Run->MeasuredFrameCount, 0.99f);
+    }
+
+    Run->State = BenchmarkRun_Finished;
+}
+
+inline f32
+GetBenchmarkMillisecondsPerFrame(benchmark_run *Run, u64 Ticks)
+{
+    f32 Result = 0.f;
+
+    if (Run->TicksPerSecond > 0 && Run->MeasuredFrameCount > 0)
+    {
+        Result = (f32) ((f64) Ticks * 1000.0 / (f64) Run->TicksPerSecond / (f64) Run->MeasuredFrameCount);
+    }
+
+    return Result;
+}
+
+inline f32
+GetBenchmarkMilliseconds(benchmark_run *Run, u64 Ticks)
+{
+    f32 Result = 0.f;
+
+    if (Run->TicksPerSecond > 0)
+    {
+        Result = (f32) ((f64) Ticks * 1000.0 / (f64) Run->TicksPerSecond);
+    }
+
+    return Result;
+}
+
+// Averages per measured frame, except for the maximums
+dummy_internal void
+WriteBenchmarkJobsJSON(benchmark_run *Run, memory_arena *Arena)
+{
+    job_queue_frame *Jobs = &Run->Jobs;
+    f32 FrameCount = Run->MeasuredFrameCount > 0 ? (f32) Run->MeasuredFrameCount : 1.f;
+
+    AppendTraceText(Arena, "\"jobs\":{\n\"max_queue_depth\":%u,\n", Jobs->MaxQueueDepth);
+
+    AppendTraceText(
+        Arena,
+        "\"lock\":{\"acquires\":%.1f,\"wait_ms\":%.4f,\"max_wait_ms\":%.4f,\"hold_ms\":%.4f,\"max_hold_ms\":%.4f},\n",
+        (f32) Jobs->Lock.AcquireCount / FrameCount,
+        GetBenchmarkMillisecondsPerFrame(Run, Jobs->Lock.WaitTicks),
+        GetBenchmarkMilliseconds(Run, Jobs->Lock.MaxWaitTicks),
+        GetBenchmarkMillisecondsPerFrame(Run, Jobs->Lock.HoldTicks),
+        GetBenchmarkMilliseconds(Run, Jobs->Lock.MaxHoldTicks)
+    );
+
+    AppendTraceText(Arena, "\"workers\":[\n");
+
+    for (u32 WorkerIndex = 0; WorkerIndex < Jobs->WorkerCount; ++WorkerIndex)
+    {
+        job_worker_stats *Worker = Jobs->Workers + WorkerIndex;
+
+        AppendTraceText(
+            Arena,
+            "{\"jobs\":%.1f,\"busy_ms\":%.4f,\"idle_ms\":%.4f,\"dequeue_ms\":%.4f,\"lock_wait_ms\":%.4f}%s\n",
+            (f32) Worker->JobCount / FrameCount,
+            GetBenchmarkMillisecondsPerFrame(Run, Worker->BusyTicks),
+            GetBenchmarkMillisecondsPerFrame(Run, Worker->IdleTicks),
+            GetBenchmarkMillisecondsPerFrame(Run, Worker->DequeueTicks),
+            GetBenchmarkMillisecondsPerFrame(Run, Worker->LockWaitTicks),
+            WorkerIndex + 1 < Jobs->WorkerCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "],\n\"stages\":{\n");
+
+    for (u32 StageIndex = 0; StageIndex < Jobs->StageCount; ++StageIndex)
+    {
+        job_stage_stats *Stage = Jobs->Stages + StageIndex;
+
+        AppendJSONString(Arena, Stage->Name);
+        AppendTraceText(
+            Arena,
+            ":{\"batches\":%.1f,\"jobs\":%.1f,\"job_ms\":%.4f,\"mean_job_ms\":%.4f,\"slowest_job_ms\":%.4f,\"imbalance\":%.3f,\"wait_ms\":%.4f}%s\n",
+            (f32) Stage->BatchCount / FrameCount,
+            (f32) Stage->JobCount / FrameCount,
+            GetBenchmarkMillisecondsPerFrame(Run, Stage->JobTicks),
+            GetBenchmarkMillisecondsPerFrame(Run, Stage->MeanJobTicks),
+            GetBenchmarkMillisecondsPerFrame(Run, Stage->SlowestJobTicks),
+            GetJobStageImbalance(Stage),
+            GetBenchmarkMillisecondsPerFrame(Run, Stage->WaitTicks),
+            StageIndex + 1 < Jobs->StageCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "}\n}\n");
+}
+
+dummy_internal void
+WriteBenchmarkJSON(benchmark_run *Run, memory_arena *Arena)
+{
+    AppendTraceText(
+        Arena,
+        "{\n\"scenario\":\"%s\",\n\"seed\":%u,\n\"streaming_frames\":%u,\n\"warmup_frames\":%u,\n\"frames\":%u,\n\"check_errors\":%u,\n\"residency_misses\":%u,\n\"stages\":{\n",
+        BenchmarkScenarioNames[Run->Scenario],
+        Run->Seed,
+        Run->StreamingFrameCount,
+        Run->WarmupFrameCount,
+        Run->MeasuredFrameCount,
+        Run->Status.CheckErrorCount,
+        Run->ResidencyMissCount
+    );
+
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        AppendJSONString(Arena, Stage->Name);
+        AppendTraceText(
+            Arena,
+            ":{\"median_ms\":%.4f,\"p99_ms\":%.4f}%s\n",
+            Stage->MedianMilliseconds,
+            Stage->P99Milliseconds,
+            StageIndex + 1 < Run->StageCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "},\n");
+
+    WriteBenchmarkJobsJSON(Run, Arena);
+
+    AppendTraceText(Arena, "}\n");
+}
+
+// Value of the key inside the object that starts at Object, false if the object doesn't have the key
+inline bool32
+FindBenchmarkBaselineValue(char *Object, const char *Key, f32 *Value)
+{
+    bool32 Result = false;
+
+    char QuotedKey[64];
+    FormatString(QuotedKey, "\"%s\":", Key);
+
+    char *ObjectEnd = strchr(Object, '}');
+    char *KeyAt = strstr(Object, QuotedKey);
+
+    if (KeyAt && ObjectEnd && KeyAt < ObjectEnd)
+    {
+        *Value = (f32) atof(KeyAt + StringLength(QuotedKey));
+        Result = true;
+    }
+
+    return Result;
+}
+
+// Looks for "Name":{..."MedianKey":x,"P99Key":y...} in a file written by WriteBenchmarkJSON or WriteMicroBenchmarkJSON
+dummy_internal bool32
+FindBenchmarkBaselineStage(char *Baseline, const char *Name, const char *MedianKey, const char *P99Key, f32 *Median, f32 *P99)
+{
+    bool32 Result = false;
+
+    char ObjectKey[80];
+    FormatString(ObjectKey, "\"%s\":{", Name);
+
+    char *Object = strstr(Baseline, ObjectKey);
+
+    if (Object)
+    {
+        Object += StringLength(ObjectKey);
+
+        Result = FindBenchmarkBaselineValue(Object, MedianKey, Median) && FindBenchmarkBaselineValue(Object, P99Key, P99);
+    }
+
+    return Result;
+}
+
+inline bool32
+IsBenchmarkRegression(f32 Current, f32 Baseline, f32 Threshold, f32 MinDifference)
+{
+    bool32 Result = Current > Baseline * (1.f + Threshold) && Current - Baseline > MinDifference;
+    return Result;
+}
+
+// New stages have nothing to regress from
+dummy_internal bool32
+CheckBenchmarkBaselineStage(
+    char *Baseline,
+    const char *Name,
+    const char *MedianKey,
+    const char *P99Key,
+    f32 Median,
+    f32 P99,
+    f32 Threshold,
+    f32 MinDifference,
+    stream *Stream
+)
+{
+    bool32 Result = false;
+
+    f32 BaselineMedian;
+    f32 BaselineP99;
+
+    if (FindBenchmarkBaselineStage(Baseline, Name, MedianKey, P99Key, &BaselineMedian, &BaselineP99))
+    {
+        bool32 MedianRegressed = IsBenchmarkRegression(Median, BaselineMedian, Threshold, MinDifference);
+        bool32 P99Regressed = IsBenchmarkRegression(P99, BaselineP99, Threshold, MinDifference);
+
+        if (MedianRegressed || P99Regressed)
+        {
+            Out(
+                Stream,
+                "Benchmark::Regression in %s: %s %.3f (baseline %.3f), %s %.3f (baseline %.3f)",
+                Name,
+                MedianKey,
+                Median,
+                BaselineMedian,
+                P99Key,
+                P99,
+                BaselineP99
+            );
+
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+// Baseline text has to be null-terminated, returns the number of the regressed stages
+dummy_internal u32
+CompareBenchmarkBaseline(benchmark_run *Run, char *Baseline, stream *Stream)
+{
+    u32 Result = 0;
+
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        if (CheckBenchmarkBaselineStage(
+            Baseline,
+            Stage->Name,
+            "median_ms",
+            "p99_ms",
+            Stage->MedianMilliseconds,
+            Stage->P99Milliseconds,
+            Run->Threshold,
+            BENCHMARK_MIN_REGRESSION_MILLISECONDS,
+            Stream
+        ))
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    Sweep of a cvar: the scenario is loaded and measured once per value, from From to To by Step.
+    The same seed makes the runs comparable, the frame time of every value is written as JSON and CSV.
+*/
+
+#define BENCHMARK_MAX_SWEEP_POINT_COUNT 64
+// Width of the longest bar of the chart
+#define BENCHMARK_SWEEP_CHART_WIDTH 50
+
+struct benchmark_sweep_point
+{
+    f32 Value;
+    f32 MedianMilliseconds;
+    f32 P99Milliseconds;
+};
+
+struct benchmark_sweep
+{
+    char CVarName[CVAR_MAX_NAME_LENGTH];
+
+    u32 PointCount;
+    // Point of the current run
+    u32 PointIndex;
+    benchmark_sweep_point Points[BENCHMARK_MAX_SWEEP_POINT_COUNT];
+};
+
+// A single point if the range is empty or the step is not positive
+dummy_internal void
+InitBenchmarkSweep(benchmark_sweep *Sweep, const char *CVarName, f32 From, f32 To, f32 Step)
+{
+    FormatString(Sweep->CVarName, "%s", CVarName);
+
+    u32 PointCount = 1;
+
+    if (Step > 0.f && To > From)
+    {
+        PointCount = (u32) Floor((To - From) / Step + 0.5f) + 1;
+    }
+
+    Sweep->PointCount = PointCount < BENCHMARK_MAX_SWEEP_POINT_COUNT ? PointCount : BENCHMARK_MAX_SWEEP_POINT_COUNT;
+    Sweep->PointIndex = 0;
+
+    for (u32 PointIndex = 0; PointIndex < Sweep->PointCount; ++PointIndex)
+    {
+        Sweep->Points[PointIndex].Value = From + Step * (f32) PointIndex;
+    }
+}
+
+// Stage arrays are kept for the next run, the stages that don't show up anymore stay at 0
+dummy_internal void
+ResetBenchmarkRun(benchmark_run *Run)
+{
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        for (u32 FrameIndex = 0; FrameIndex < Run->FrameCount; ++FrameIndex)
+        {
+            Stage->FrameMilliseconds[FrameIndex] = 0.f;
+        }
+
+        Stage->MedianMilliseconds = 0.f;
+        Stage->P99Milliseconds = 0.f;
+    }
+
+    Run->State = BenchmarkRun_Loading;
+    Run->FrameIndex = 0;
+    Run->MeasuredFrameCount = 0;
+    Run->StreamingFrameCount = 0;
+    Run->Jobs = {};
+    Run->Status = {};
+    Run->ResidencyMissCount = 0;
+}
+
+// Run has to be finished
+inline void
+RecordBenchmarkSweepPoint(benchmark_sweep *Sweep, benchmark_run *Run)
+{
+    benchmark_sweep_point *Point = Sweep->Points + Sweep->PointIndex;
+
+    for (u32 StageIndex = 0; StageIndex < Run->StageCount; ++StageIndex)
+    {
+        benchmark_stage *Stage = Run->Stages + StageIndex;
+
+        if (StringEquals(Stage->Name, BENCHMARK_FRAME_STAGE_NAME))
+        {
+            Point->MedianMilliseconds = Stage->MedianMilliseconds;
+            Point->P99Milliseconds = Stage->P99Milliseconds;
+        }
+    }
+}
+
+dummy_internal void
+WriteBenchmarkSweepJSON(benchmark_sweep *Sweep, benchmark_run *Run, memory_arena *Arena)
+{
+    AppendTraceText(
+        Arena,
+        "{\n\"scenario\":\"%s\",\n\"seed\":%u,\n\"frames\":%u,\n\"cvar\":",
+        BenchmarkScenarioNames[Run->Scenario],
+        Run->Seed,
+        Run->FrameCount
+    );
+
+    AppendJSONString(Arena, Sweep->CVarName);
+    AppendTraceText(Arena, ",\n\"points\":[\n");
+
+    for (u32 PointIndex = 0; PointIndex < Sweep->PointCount; ++PointIndex)
+    {
+        benchmark_sweep_point *Point = Sweep->Points + PointIndex;
+
+        AppendTraceText(
+            Arena,
+            "{\"value\":%g,\"median_ms\":%.4f,\"p99_ms\":%.4f}%s\n",
+            Point->Value,
+            Point->MedianMilliseconds,
+            Point->P99Milliseconds,
+            PointIndex + 1 < Sweep->PointCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "]\n}\n");
+}
+
+dummy_internal void
+WriteBenchmarkSweepCSV(benchmark_sweep *Sweep, memory_arena *Arena)
+{
+    AppendTraceText(Arena, "%s,median_ms,p99_ms\n", Sweep->CVarName);
+
+    for (u32 PointIndex = 0; PointIndex < Sweep->PointCount; ++PointIndex)
+    {
+        benchmark_sweep_point *Point = Sweep->Points + PointIndex;
+
+        AppendTraceText(Arena, "%g,%.4f,%.4f\n", Point->Value, Point->MedianMilliseconds, Point->P99Milliseconds);
+    }
+}
+
+// Median frame time of every value as a bar, scaled to the slowest one
+dummy_internal void
+OutBenchmarkSweepChart(benchmark_sweep *Sweep, stream *Stream)
+{
+    f32 MaxMilliseconds = 0.f;
+
+    for (u32 PointIndex = 0; PointIndex < Sweep->PointCount; ++PointIndex)
+    {
+        MaxMilliseconds = Max(MaxMilliseconds, Sweep->Points[PointIndex].MedianMilliseconds);
+    }
+
+    Out(Stream, "Benchmark::Sweep %s (median frame time)", Sweep->CVarName);
+
+    for (u32 PointIndex = 0; PointIndex < Sweep->PointCount; ++PointIndex)
+    {
+        benchmark_sweep_point *Point = Sweep->Points + PointIndex;
+
+        char Bar[BENCHMARK_SWEEP_CHART_WIDTH + 1];
+        u32 BarLength = MaxMilliseconds > 0.f ? (u32) Round(Point->MedianMilliseconds / MaxMilliseconds * (f32) BENCHMARK_SWEEP_CHART_WIDTH) : 0;
+
+        for (u32 Index = 0; Index < BarLength; ++Index)
+        {
+            Bar[Index] = '#';
+        }
+
+        Bar[BarLength] = 0;
+
+        Out(Stream, "Benchmark::%10g | %-*s %.3f ms (p99 %.3f ms)", Point->Value, BENCHMARK_SWEEP_CHART_WIDTH, Bar, Point->MedianMilliseconds, Point->P99Milliseconds);
+    }
+}
+
+/*
+    Micro-benchmarks of the engine primitives (see RunMicroBenchmarks).
+    Every benchmark runs a batch of elements per repetition: the warmup repetitions are thrown away,
+    then the batch is repeated until there are enough samples for the median and the 99th percentile.
+    Cycles are the time stamp counter, so they don't follow the frequency scaling of the core.
+*/
+
+#define MICRO_BENCHMARK_MAX_COUNT 64
+#define MICRO_BENCHMARK_WARMUP_REPETITION_COUNT 16
+#define MICRO_BENCHMARK_MIN_REPETITION_COUNT 64
+#define MICRO_BENCHMARK_MAX_REPETITION_COUNT 2048
+#define MICRO_BENCHMARK_MIN_SECONDS 0.05f
+// Differences below are noise, whatever the threshold
+#define MICRO_BENCHMARK_MIN_REGRESSION_CYCLES 0.5f
+#define MICRO_BENCHMARK_MAX_CHECK_COUNT 32
+
+struct micro_benchmark
+{
+    char Name[64];
+    // Elements processed by a single repetition
+    u32 ElementCount;
+
+    u32 WarmupRepetitionCount;
+    u32 RepetitionCount;
+    u64 StartCycles;
+    u64 StartTicks;
+    u64 ElapsedTicks;
+    f32 *CyclesPerElement;
+    f32 *NanosecondsPerElement;
+
+    f32 MinCyclesPerElement;
+    f32 MedianCyclesPerElement;
+    f32 P99CyclesPerElement;
+    f32 MedianNanosecondsPerElement;
+    // Median absolute deviation relative to the median
+    f32 RelativeDeviation;
+};
+
+// Largest error of an optimized path against its reference over the benchmark inputs, fails the run above the tolerance
+struct micro_benchmark_check
+{
+    char Name[64];
+    f32 MaxError;
+    f32 Tolerance;
+};
+
+struct micro_benchmark_suite
+{
+    platform_profiler *Profiler;
+    memory_arena *Arena;
+
+    // Only the benchmarks with the filter in the name run, all of them if it's empty
+    char Filter[64];
+    f32 Threshold;
+
+    u32 BenchmarkCount;
+    micro_benchmark Benchmarks[MICRO_BENCHMARK_MAX_COUNT];
+
+    u32 CheckCount;
+    micro_benchmark_check Checks[MICRO_BENCHMARK_MAX_CHECK_COUNT];
+};
+
+// Results have to outlive the call, so the benchmark is never optimized away
+dummy_global volatile u32 MicroBenchmarkSink;
+
+// Returns 0 for the benchmarks that are filtered out
+inline micro_benchmark *
+BeginMicroBenchmark(micro_benchmark_suite *Suite, const char *Name, u32 ElementCount)
+{
+    micro_benchmark *Result = 0;
+
+    if (!Suite->Filter[0] || StringIncludes((char *) Name, Suite->Filter))
+    {
+        Assert(Suite->BenchmarkCount < MICRO_BENCHMARK_MAX_COUNT);
+
+        Result = Suite->Benchmarks + Suite->BenchmarkCount++;
+
+        CopyString(Name, Result->Name);
+        Result->ElementCount = ElementCount;
+        Result->CyclesPerElement = PushArray(Suite->Arena, MICRO_BENCHMARK_MAX_REPETITION_COUNT, f32, NoClear());
+        Result->NanosecondsPerElement = PushArray(Suite->Arena, MICRO_BENCHMARK_MAX_REPETITION_COUNT, f32, NoClear());
+    }
+
+    return Result;
+}
+
+inline bool32
+KeepMicroBenchmarkRunning(micro_benchmark_suite *Suite, micro_benchmark *Benchmark)
+{
+    bool32 Result = false;
+
+    if (Benchmark)
+    {
+        f32 ElapsedSeconds = (f32) Benchmark->ElapsedTicks / (f32) Suite->Profiler->TicksPerSecond;
+
+        bool32 Warmup = Benchmark->WarmupRepetitionCount < MICRO_BENCHMARK_WARMUP_REPETITION_COUNT;
+        bool32 Enough = Benchmark->RepetitionCount >= MICRO_BENCHMARK_MIN_REPETITION_COUNT && ElapsedSeconds >= MICRO_BENCHMARK_MIN_SECONDS;
+        bool32 Full = Benchmark->RepetitionCount >= MICRO_BENCHMARK_MAX_REPETITION_COUNT;
+
+        Result = Warmup || (!Enough && !Full);
+    }
+
+    return Result;
+}
+
+// Returns 0 for the checks that are filtered out, the same way as the benchmarks
+inline micro_benchmark_check *
+BeginMicroBenchmarkCheck(micro_benchmark_suite *Suite, const char *Name, f32 Tolerance)
+{
+    micro_benchmark_check *Result = 0;
+
+    if (!Suite->Filter[0] || StringIncludes((char *) Name, Suite->Filter))
+    {
+        Assert(Suite->CheckCount < MICRO_BENCHMARK_MAX_CHECK_COUNT);
+
+        Result = Suite->Checks + Suite->CheckCount++;
+
+        CopyString(Name, Result->Name);
+        Result->MaxError = 0.f;
+        Result->Tolerance = Tolerance;
+    }
+
+    return Result;
+}
+
+inline void
+RecordMicroBenchmarkCheckError(micro_benchmark_check *Check, f32 Error)
+{
+    if (Check && Error > Check->MaxError)
+    {
+        Check->MaxError = Error;
+    }
+}
+
+// Setup of the input between the repetitions goes outside of Start/Stop
+inline void
+StartMicroBenchmarkRepetition(micro_benchmark_suite *Suite, micro_benchmark *Benchmark)
+{
+    Benchmark->StartTicks = Suite->Profiler->GetTimestamp();
+    Benchmark->StartCycles = __rdtsc();
+}
+
+inline void
+StopMicroBenchmarkRepetition(micro_benchmark_suite *Suite, micro_benchmark *Benchmark)
+{
+    u64 EndCycles = __rdtsc();
+    u64 EndTicks = Suite->Profiler->GetTimestamp();
+
+    if (Benchmark->WarmupRepetitionCount < MICRO_BENCHMARK_WARMUP_REPETITION_COUNT)
+    {
+        ++Benchmark->WarmupRepetitionCount;
+    }
+    else
+    {
+        u64 Ticks = EndTicks - Benchmark->StartTicks;
+        f32 ElementCount = (f32) Benchmark->ElementCount;
+
+        u32 RepetitionIndex = Benchmark->RepetitionCount++;
+        Benchmark->CyclesPerElement[RepetitionIndex] = (f32) (EndCycles - Benchmark->StartCycles) / ElementCount;
+        Benchmark->NanosecondsPerElement[RepetitionIndex] = ((f32) Ticks * 1e9f / (f32) Suite->Profiler->TicksPerSecond) / ElementCount;
+        Benchmark->ElapsedTicks += Ticks;
+    }
+}
+
+dummy_internal void
+FinishMicroBenchmarks(micro_benchmark_suite *Suite)
+{
+    scoped_memory ScopedMemory(Suite->Arena);
+
+    f32 *SortedValues = PushArray(ScopedMemory.Arena, MICRO_BENCHMARK_MAX_REPETITION_COUNT, f32, NoClear());
+    f32 *Deviations = PushArray(ScopedMemory.Arena, MICRO_BENCHMARK_MAX_REPETITION_COUNT, f32, NoClear());
+
+    for (u32 BenchmarkIndex = 0; BenchmarkIndex < Suite->BenchmarkCount; ++BenchmarkIndex)
+    {
+        micro_benchmark *Benchmark = Suite->Benchmarks + BenchmarkIndex;
+        u32 Count = Benchmark->RepetitionCount;
+
+        SortBenchmarkValues(Benchmark->CyclesPerElement, SortedValues, Count);
+
+        Benchmark->MinCyclesPerElement = SortedValues[0];
+        Benchmark->MedianCyclesPerElement = GetBenchmarkPercentile(SortedValues, Count, 0.5f);
+        Benchmark->P99CyclesPerElement = GetBenchmarkPercentile(SortedValues, Count, 0.99f);
+
+        for (u32 RepetitionIndex = 0; RepetitionIndex < Count; ++RepetitionIndex)
+        {
+            Deviations[RepetitionIndex] = Abs(Benchmark->CyclesPerElement[RepetitionIndex] - Benchmark->MedianCyclesPerElement);
+        }
+
+        SortBenchmarkValues(Deviations, SortedValues, Count);
+
+        f32 MedianDeviation = GetBenchmarkPercentile(SortedValues, Count, 0.5f);
+        Benchmark->RelativeDeviation = Benchmark->MedianCyclesPerElement > 0.f ? MedianDeviation / Benchmark->MedianCyclesPerElement : 0.f;
+
+        SortBenchmarkValues(Benchmark->NanosecondsPerElement, SortedValues, Count);
+
+        Benchmark->MedianNanosecondsPerElement = GetBenchmarkPercentile(SortedValues, Count, 0.5f);
+    }
+}
+
+dummy_internal void
+WriteMicroBenchmarkJSON(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    AppendTraceText(Arena, "{\n\"benchmarks\":{\n");
+
+    for (u32 BenchmarkIndex = 0; BenchmarkIndex < Suite->BenchmarkCount; ++BenchmarkIndex)
+    {
+        micro_benchmark *Benchmark = Suite->Benchmarks + BenchmarkIndex;
+
+        f32 ElementsPerSecond = Benchmark->MedianNanosecondsPerElement > 0.f ? 1e9f / Benchmark->MedianNanosecondsPerElement : 0.f;
+
+        AppendJSONString(Arena, Benchmark->Name);
+        AppendTraceText(
+            Arena,
+            ":{\"median_cycles\":%.3f,\"p99_cycles\":%.3f,\"min_cycles\":%.3f,\"median_ns\":%.3f,"
+            "\"elements_per_second\":%.0f,\"relative_deviation\":%.4f,\"elements\":%u,\"repetitions\":%u}%s\n",
+            Benchmark->MedianCyclesPerElement,
+            Benchmark->P99CyclesPerElement,
+            Benchmark->MinCyclesPerElement,
+            Benchmark->MedianNanosecondsPerElement,
+            ElementsPerSecond,
+            Benchmark->RelativeDeviation,
+            Benchmark->ElementCount,
+            Benchmark->RepetitionCount,
+            BenchmarkIndex + 1 < Suite->BenchmarkCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "},\n\"checks\":{\n");
+
+    for (u32 CheckIndex = 0; CheckIndex < Suite->CheckCount; ++CheckIndex)
+    {
+        micro_benchmark_check *Check = Suite->Checks + CheckIndex;
+
+        AppendJSONString(Arena, Check->Name);
+        AppendTraceText(
+            Arena,
+            ":{\"max_error\":%g,\"tolerance\":%g,\"passed\":%s}%s\n",
+            Check->MaxError,
+            Check->Tolerance,
+            Check->MaxError <= Check->Tolerance ? "true" : "false",
+            CheckIndex + 1 < Suite->CheckCount ? "," : ""
+        );
+    }
+
+    AppendTraceText(Arena, "}\n}\n");
+}
+
+// Checks over their tolerance, these fail the run with or without a baseline
+dummy_internal u32
+CountFailedMicroBenchmarkChecks(micro_benchmark_suite *Suite, stream *Stream)
+{
+    u32 Result = 0;
+
+    for (u32 CheckIndex = 0; CheckIndex < Suite->CheckCount; ++CheckIndex)
+    {
+        micro_benchmark_check *Check = Suite->Checks + CheckIndex;
+
+        if (Check->MaxError > Check->Tolerance)
+        {
+            Out(Stream, "Benchmark::Check failed in %s: max error %g (tolerance %g)", Check->Name, Check->MaxError, Check->Tolerance);
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+// Cycles per element are compared, the time stamp counter runs at the same rate on every run of the same machine
+dummy_internal u32
+CompareMicroBenchmarkBaseline(micro_benchmark_suite *Suite, char *Baseline, stream *Stream)
+{
+    u32 Result = 0;
+
+    for (u32 BenchmarkIndex = 0; BenchmarkIndex < Suite->BenchmarkCount; ++BenchmarkIndex)
+    {
+        micro_benchmark *Benchmark = Suite->Benchmarks + BenchmarkIndex;
+
+        if (CheckBenchmarkBaselineStage(
+            Baseline,
+            Benchmark->Name,
+            "median_cycles",
+            "p99_cycles",
+            Benchmark->MedianCyclesPerElement,
+            Benchmark->P99CyclesPerElement,
+            Suite->Threshold,
+            MICRO_BENCHMARK_MIN_REGRESSION_CYCLES,
+            Stream
+        ))
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+#include <stdlib.h>
+
+/*
+    Console variables: named, typed tuning values shared by the platform and the game code.
+    The registry lives in the platform memory, so the values survive the game code reload.
+    Values can be set before the owner registers the variable (config file, command line),
+    they are kept as text and parsed once the variable is registered.
+    Owners read the values every frame through the cvar pointer, there is nothing to recompile.
+*/
+
+#define CVAR_MAX_COUNT 128
+#define CVAR_MAX_NAME_LENGTH 64
+#define CVAR_MAX_DESCRIPTION_LENGTH 128
+#define CVAR_MAX_VALUE_LENGTH 32
+#define CVAR_CONFIG_FILE_NAME "dummy.cfg"
+
+enum cvar_type
+{
+    CVarType_None,
+    CVarType_Bool,
+    CVarType_Int,
+    CVarType_Float
+};
+
+union cvar_value
+{
+    bool32 Bool;
+    i32 Int;
+    f32 Float;
+};
+
+struct cvar
+{
+    char Name[CVAR_MAX_NAME_LENGTH];
+    char Description[CVAR_MAX_DESCRIPTION_LENGTH];
+
+    // CVarType_None until the owner registers it
+    cvar_type Type;
+
+    cvar_value Value;
+    cvar_value Default;
+    cvar_value Min;
+    cvar_value Max;
+
+    // Value set before the registration
+    char PendingValue[CVAR_MAX_VALUE_LENGTH];
+
+    // Incremented on every change, owners compare it to apply the values that need more than a read (e.g. reallocation)
+    u32 Version;
+};
+
+struct cvar_registry
+{
+    u32 CVarCount;
+    cvar CVars[CVAR_MAX_COUNT];
+};
+
+// 0 if there is no such cvar
+dummy_internal cvar *
+FindCVar(cvar_registry *Registry, const char *Name)
+{
+    cvar *Result = 0;
+
+    for (u32 CVarIndex = 0; CVarIndex < Registry->CVarCount && !Result; ++CVarIndex)
+    {
+        cvar *CVar = Registry->CVars + CVarIndex;
+
+        if (StringEquals(CVar->Name, Name))
+        {
+            Result = CVar;
+        }
+    }
+
+    return Result;
+}
+
+// 0 once the registry is full
+dummy_internal cvar *
+GetOrAddCVar(cvar_registry *Registry, const char *Name)
+{
+    cvar *Result = FindCVar(Registry, Name);
+
+    if (!Result && Registry->CVarCount < CVAR_MAX_COUNT)
+    {
+        Result = Registry->CVars + Registry->CVarCount++;
+
+        *Result = {};
+        FormatString(Result->Name, "%s", Name);
+    }
+
+    return Result;
+}
+
+inline bool32
+IsCVarRegistered(cvar *CVar)
+{
+    bool32 Result = CVar->Type != CVarType_None;
+    return Result;
+}
+
+// Clamps to the range of the cvar, the version changes only if the value does
+dummy_internal void
+SetCVarValue(cvar *CVar, cvar_value Value)
+{
+    switch (CVar->Type)
+    {
+        case CVarType_Bool:
+        {
+            Value.Bool = Value.Bool ? true : false;
+
+            if (Value.Bool != CVar->Value.Bool)
+            {
+                CVar->Value = Value;
+                ++CVar->Version;
+            }
+
+            break;
+        }
+        case CVarType_Int:
+        {
+            i32 Int = Value.Int < CVar->Min.Int ? CVar->Min.Int : (Value.Int > CVar->Max.Int ? CVar->Max.Int : Value.Int);
+
+            if (Int != CVar->Value.Int)
+            {
+                CVar->Value.Int = Int;
+                ++CVar->Version;
+            }
+
+            break;
+        }
+        case CVarType_Float:
+        {
+            f32 Float = Clamp(Value.Float, CVar->Min.Float, CVar->Max.Float);
+
+            if (Float != CVar->Value.Float)
+            {
+                CVar->Value.Float = Float;
+                ++CVar->Version;
+            }
+
+            break;
+        }
+        default:
+        {
+            Assert(!"Unregistered cvar");
+        }
+    }
+}
+
+// Accepts true/false/on/off and numbers, false if the text is not a value of the cvar type
+dummy_internal bool32
+ParseCVarValue(cvar *CVar, const char *Text, cvar_value *Value)
+{
+    bool32 Result = false;
+    char *End = 0;
+
+    switch (CVar->Type)
+    {
+        case CVarType_Bool:
+        {
+            if (StringEquals(Text, "true") || StringEquals(Text, "on"))
+            {
+                Value->Bool = true;
+                Result = true;
+            }
+            else if (StringEquals(Text, "false") || StringEquals(Text, "off"))
+            {
+                Value->Bool = false;
+                Result = true;
+            }
+            else
+            {
+                Value->Bool = strtol(Text, &End, 10) != 0;
+                Result = End != Text && *End == 0;
+            }
+
+            break;
+        }
+        case CVarType_Int:
+        {
+            Value->Int = (i32) strtol(Text, &End, 10);
+            Result = End != Text && *End == 0;
+
+            break;
+        }
+        case CVarType_Float:
+        {
+            Value->Float = strtof(Text, &End);
+            Result = End != Text && *End == 0;
+
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    return Result;
+}
+
+inline void
+FormatCVarValue(cvar_type Type, cvar_value Value, char *Buffer, u32 BufferSize)
+{
+    switch (Type)
+    {
+        case CVarType_Bool:
+        {
+            FormatString_(Buffer, BufferSize, "%s", Value.Bool ? "true" : "false");
+            break;
+        }
+        case CVarType_Int:
+        {
+            FormatString_(Buffer, BufferSize, "%d", Value.Int);
+            break;
+        }
+        case CVarType_Float:
+        {
+            FormatString_(Buffer, BufferSize, "%g", Value.Float);
+            break;
+        }
+        default:
+        {
+            FormatString_(Buffer, BufferSize, "?");
+        }
+    }
+}
+
+/*
+    Unregistered cvars keep the text until the registration.
+    False if the registry is full or the text is not a value of the registered cvar.
+*/
+dummy_internal bool32
+SetCVarFromString(cvar_registry *Registry, const char *Name, const char *Text)
+{
+    bool32 Result = false;
+    cvar *CVar = GetOrAddCVar(Registry, Name);
+
+    if (CVar)
+    {
+        if (IsCVarRegistered(CVar))
+        {
+            cvar_value Value;
+
+            if (ParseCVarValue(CVar, Text, &Value))
+            {
+                SetCVarValue(CVar, Value);
+                Result = true;
+            }
+        }
+        else
+        {
+            FormatString(CVar->PendingValue, "%s", Text);
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    Registering an already registered cvar (e.g. after the game code reload) keeps its value,
+    the description and the range are updated and the value is clamped to the new range.
+*/
+dummy_internal cvar *
+RegisterCVar(cvar_registry *Registry, const char *Name, cvar_type Type, cvar_value Default, cvar_value Min, cvar_value Max, const char *Description)
+{
+    cvar *Result = GetOrAddCVar(Registry, Name);
+    Assert(Result);
+
+    bool32 Registered = IsCVarRegistered(Result);
+
+    Assert(!Registered || Result->Type == Type);
+
+    Result->Type = Type;
+    Result->Default = Default;
+    Result->Min = Min;
+    Result->Max = Max;
+    FormatString(Result->Description, "%s", Description);
+
+    if (!Registered)
+    {
+        Result->Value = Default;
+
+        cvar_value Value;
+
+        if (Result->PendingValue[0] && ParseCVarValue(Result, Result->PendingValue, &Value))
+        {
+            SetCVarValue(Result, Value);
+        }
+
+        Result->PendingValue[0] = 0;
+    }
+    else
+    {
+        SetCVarValue(Result, Result->Value);
+    }
+
+    return Result;
+}
+
+inline cvar *
+RegisterCVarBool(cvar_registry *Registry, const char *Name, bool32 Default, const char *Description)
+{
+    cvar_value DefaultValue = {};
+    DefaultValue.Bool = Default;
+
+    cvar_value MinValue = {};
+    MinValue.Bool = false;
+
+    cvar_value MaxValue = {};
+    MaxValue.Bool = true;
+
+    cvar *Result = RegisterCVar(Registry, Name, CVarType_Bool, DefaultValue, MinValue, MaxValue, Description);
+    return Result;
+}
+
+inline cvar *
+RegisterCVarInt(cvar_registry *Registry, const char *Name, i32 Default, i32 Min, i32 Max, const char *Description)
+{
+    cvar_value DefaultValue = {};
+    DefaultValue.Int = Default;
+
+    cvar_value MinValue = {};
+    MinValue.Int = Min;
+
+    cvar_value MaxValue = {};
+    MaxValue.Int = Max;
+
+    cvar *Result = RegisterCVar(Registry, Name, CVarType_Int, DefaultValue, MinValue, MaxValue, Description);
+    return Result;
+}
+
+inline cvar *
+RegisterCVarFloat(cvar_registry *Registry, const char *Name, f32 Default, f32 Min, f32 Max, const char *Description)
+{
+    cvar_value DefaultValue = {};
+    DefaultValue.Float = Default;
+
+    cvar_value MinValue = {};
+    MinValue.Float = Min;
+
+    cvar_value MaxValue = {};
+    MaxValue.Float = Max;
+
+    cvar *Result = RegisterCVar(Registry, Name, CVarType_Float, DefaultValue, MinValue, MaxValue, Description);
+    return Result;
+}
+
+inline bool32
+GetCVarBool(cvar *CVar)
+{
+    Assert(CVar->Type == CVarType_Bool);
+
+    bool32 Result = CVar->Value.Bool;
+    return Result;
+}
+
+inline i32
+GetCVarInt(cvar *CVar)
+{
+    Assert(CVar->Type == CVarType_Int);
+
+    i32 Result = CVar->Value.Int;
+    return Result;
+}
+
+inline f32
+GetCVarFloat(cvar *CVar)
+{
+    Assert(CVar->Type == CVarType_Float);
+
+    f32 Result = CVar->Value.Float;
+    return Result;
+}
+
+// Numeric value, for the benchmark sweeps
+inline f32
+GetCVarNumber(cvar *CVar)
+{
+    f32 Result = 0.f;
+
+    switch (CVar->Type)
+    {
+        case CVarType_Bool: Result = CVar->Value.Bool ? 1.f : 0.f; break;
+        case CVarType_Int: Result = (f32) CVar->Value.Int; break;
+        case CVarType_Float: Result = CVar->Value.Float; break;
+        default: break;
+    }
+
+    return Result;
+}
+
+inline void
+SetCVarNumber(cvar *CVar, f32 Number)
+{
+    cvar_value Value = {};
+
+    switch (CVar->Type)
+    {
+        case CVarType_Bool: Value.Bool = Number != 0.f; break;
+        case CVarType_Int: Value.Int = Round(Number); break;
+        case CVarType_Float: Value.Float = Number; break;
+        default: break;
+    }
+
+    SetCVarValue(CVar, Value);
+}
+
+/*
+    One "name value" pair per line, '#' starts a comment.
+    Returns the number of lines that couldn't be applied.
+*/
+dummy_internal u32
+LoadCVarConfig(cvar_registry *Registry, char *Text, stream *Stream)
+{
+    u32 Result = 0;
+
+    char *Context = 0;
+    char *Line = SplitString(Text, "\r\n", &Context);
+
+    while (Line)
+    {
+        char *Comment = strchr(Line, '#');
+
+        if (Comment)
+        {
+            *Comment = 0;
+        }
+
+        char *LineContext = 0;
+        char *Name = SplitString(Line, " \t", &LineContext);
+
+        if (Name)
+        {
+            char *Value = SplitString(0, " \t", &LineContext);
+
+            if (!Value || !SetCVarFromString(Registry, Name, Value))
+            {
+                Out(Stream, "CVar::Invalid config line: %s", Name);
+                ++Result;
+            }
+        }
+
+        Line = SplitString(0, "\r\n", &Context);
+    }
+
+    return Result;
+}
+
+// Registered cvars that are not at their defaults, in the format of LoadCVarConfig
+dummy_internal void
+SaveCVarConfig(cvar_registry *Registry, memory_arena *Arena)
+{
+    for (u32 CVarIndex = 0; CVarIndex < Registry->CVarCount; ++CVarIndex)
+    {
+        cvar *CVar = Registry->CVars + CVarIndex;
+
+        // Same bits as the default, whatever the type
+        if (IsCVarRegistered(CVar) && CVar->Value.Int != CVar->Default.Int)
+        {
+            char Value[CVAR_MAX_VALUE_LENGTH];
+            FormatCVarValue(CVar->Type, CVar->Value, Value, ArrayCount(Value));
+
+            AppendText(Arena, "%s %s\n", CVar->Name, Value);
+        }
+    }
+}
@@ -3,6 +3,10 @@
 #include <stdint.h>
 #include <float.h>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define dummy_internal static
 #define dummy_global static
 #define dummy_persist static
@@ -47,4 +51,90 @@
 #define U8_MAX UINT8_MAX
 #define U32_MAX UINT32_MAX
 #define F32_MIN FLT_MIN
-#define F32_MAX FLT_MAX
\ No newline at end of file
+#define F32_MAX FLT_MAX
+
+// Keeps the compiler from moving the memory accesses across (x64 doesn't reorder stores with the other stores)
+#if defined(_MSC_VER)
+#define CompilerBarrier() _ReadWriteBarrier()
+#else
+#define CompilerBarrier() __asm__ __volatile__("" ::: "memory")
+#endif
+
+// Returns the incremented value
+inline u32
+AtomicIncrement(u32 volatile *Value)
+{
+#if defined(_MSC_VER)
+    u32 Result = (u32)_InterlockedIncrement((long volatile *)Value);
+#else
+    u32 Result = __atomic_add_fetch(Value, 1, __ATOMIC_SEQ_CST);
+#endif
+
+    return Result;
+}
+
+// Returns the decremented value
+inline u32
+AtomicDecrement(u32 volatile *Value)
+{
+#if defined(_MSC_VER)
+    u32 Result = (u32)_InterlockedDecrement((long volatile *)Value);
+#else
+    u32 Result = __atomic_sub_fetch(Value, 1, __ATOMIC_SEQ_CST);
+#endif
+
+    return Result;
+}
+
+// Stores the value after all the previous writes of the thread are visible
+inline void
+AtomicStoreRelease(u32 volatile *Value, u32 New)
+{
+#if defined(_MSC_VER)
+    CompilerBarrier();
+    *Value = New;
+#else
+    __atomic_store_n(Value, New, __ATOMIC_RELEASE);
+#endif
+}
+
+// Pairs with AtomicStoreRelease, the reads after it see everything written before the store
+inline u32
+AtomicLoadAcquire(u32 volatile *Value)
+{
+#if defined(_MSC_VER)
+    u32 Result = *Value;
+    CompilerBarrier();
+#else
+    u32 Result = __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+#endif
+
+    return Result;
+}
+
+// Returns the added value
+inline u64
+AtomicAdd(u64 volatile *Value, u64 Addend)
+{
+#if defined(_MSC_VER)
+    u64 Result = (u64)_InterlockedExchangeAdd64((long long volatile *)Value, (long long)Addend) + Addend;
+#else
+    u64 Result = __atomic_add_fetch(Value, Addend, __ATOMIC_SEQ_CST);
+#endif
+
+    return Result;
+}
+
+// Returns the initial value, the exchange happened if it's equal to Expected
+inline u32
+AtomicCompareExchange(u32 volatile *Value, u32 New, u32 Expected)
+{
+#if defined(_MSC_VER)
+    u32 Result = (u32)_InterlockedCompareExchange((long volatile *)Value, (long)New, (long)Expected);
+#else
+    u32 Result = Expected;
+    __atomic_compare_exchange_n(Value, &Result, New, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+
+    return Result;
+}
@@ -65,7 +65,13 @@ ProcessEvents(game_state *State, audio_commands *AudioCommands, render_commands
 
                 if (AudioClip)
                 {
-                    Play3D(AudioCommands, AudioClip, Position, 10.f, 20.f, SetVolume(Weight));
+                    RequestAudioClip(AudioClip);
+
+                    // Steps are skipped until the clip is streamed in
+                    if (IsAudioClipResident(AudioClip))
+                    {
+                        Play3D(AudioCommands, AudioClip, Position, 10.f, 20.f, SetVolume(Weight));
+                    }
                 }
             }
         }
@@ -1,14 +1,109 @@
 #pragma once
 
 struct job_queue;
+struct platform_profiler;
 
 #define JOB_ENTRY_POINT(name) void name(job_queue *Queue, void *Parameters)
 typedef JOB_ENTRY_POINT(job_entry_point);
 
+#define JOB_MAX_WORKER_COUNT 64
+#define JOB_MAX_STAGE_COUNT 32
+#define JOB_STATS_HISTORY_COUNT 256
+
+// Jobs of one KickJobsAndWait, filled by the workers before they finish the job
+struct job_batch
+{
+    u32 volatile JobCount;
+    u64 volatile JobTicks;
+    u32 volatile SlowestJobTicks;
+};
+
 struct job
 {
     job_entry_point *EntryPoint;
     void *Parameters;
+
+    // Static strings for the profiler: the name of the entry point and the scope that kicked the job
+    const char *Name;
+    const char *Stage;
+
+    // 0 unless somebody waits for the job
+    job_batch *Batch;
+};
+
+// Acquire latency and hold time of a lock, written while the lock is held
+struct job_lock_stats
+{
+    u32 AcquireCount;
+    u64 WaitTicks;
+    u64 MaxWaitTicks;
+    u64 HoldTicks;
+    u64 MaxHoldTicks;
+};
+
+/*
+    Written by the worker itself, the totals only grow.
+    There is one shared queue, so there is nothing to steal: DequeueTicks is the time spent taking the next job off the queue
+    (waiting for the lock and holding it), IdleTicks is the time asleep on the empty queue.
+*/
+struct job_worker_stats
+{
+    u32 JobCount;
+    u64 BusyTicks;
+    u64 IdleTicks;
+    u64 DequeueTicks;
+    u64 LockWaitTicks;
+};
+
+// Load imbalance of the jobs kicked by the same scope: the slowest job of each batch against the mean job of the batch
+struct job_stage_stats
+{
+    char Name[64];
+    u32 BatchCount;
+    u32 JobCount;
+    u64 JobTicks;
+    u64 SlowestJobTicks;
+    u64 MeanJobTicks;
+    // Kicking thread spinning in KickJobsAndWait
+    u64 WaitTicks;
+};
+
+// Everything that happened in the queue during one frame
+struct job_queue_frame
+{
+    u32 WorkerCount;
+    job_worker_stats Workers[JOB_MAX_WORKER_COUNT];
+
+    job_lock_stats Lock;
+    u32 MaxQueueDepth;
+
+    u32 StageCount;
+    job_stage_stats Stages[JOB_MAX_STAGE_COUNT];
+};
+
+/*
+    Workers update their own stats, the lock stats and the queue depth are updated under the queue lock,
+    the stages are updated by the thread that waits for the jobs (the main thread).
+    Platform finishes the frame once per frame (see FinishJobQueueFrame).
+*/
+struct job_queue_stats
+{
+    u32 WorkerCount;
+    job_worker_stats Workers[JOB_MAX_WORKER_COUNT];
+    job_worker_stats PrevWorkers[JOB_MAX_WORKER_COUNT];
+
+    job_lock_stats Lock;
+    u32 MaxQueueDepth;
+
+    // Stage is the scope name, only the pointer is compared
+    u32 StageCount;
+    const char *StageKeys[JOB_MAX_STAGE_COUNT];
+    job_stage_stats Stages[JOB_MAX_STAGE_COUNT];
+
+    job_queue_frame LastFrame;
+
+    u32 HistoryIndex;
+    f32 QueueDepthHistory[JOB_STATS_HISTORY_COUNT];
 };
 
 struct job_queue
@@ -17,12 +112,68 @@ struct job_queue
     void *CriticalSection;
     void *QueueNotEmpty;
 
+    platform_profiler *Profiler;
+    job_queue_stats *Stats;
+
+    u32 WorkerCount;
+    // 0 is PARALLEL_FOR_TARGET_CHUNK_MICROSECONDS
+    f32 ParallelForChunkMicroseconds;
+
     i32 volatile CurrentJobCount;
     i32 volatile CurrentJobIndex;
 
     job Jobs[1024];
 };
 
+/*
+    Parallel loop over a range of items (see ParallelFor).
+    Every job of the loop keeps claiming the next chunk of the range until the range is exhausted,
+    so the workers that got the cheap items take over the rest instead of waiting for the slow ones.
+    Chunk size comes from the cost per item measured by the previous runs of the same call site.
+*/
+#define PARALLEL_FOR_ENTRY_POINT(name) void name(void *Parameters, u32 StartIndex, u32 EndIndex, memory_arena *Arena)
+typedef PARALLEL_FOR_ENTRY_POINT(parallel_for_entry_point);
+
+// Long enough to hide the cost of claiming a chunk, short enough to even out the workers (see job_queue)
+#define PARALLEL_FOR_TARGET_CHUNK_MICROSECONDS 50.f
+// Workers that finish early need something left to claim
+#define PARALLEL_FOR_MIN_CHUNKS_PER_JOB 4
+// Weight of the last run in the moving average of the cost per item
+#define PARALLEL_FOR_COST_SMOOTHING 0.1f
+
+// Kept by the call site between the runs
+struct parallel_for_site
+{
+    // 0 until the first run
+    f32 TicksPerItem;
+
+    // Last run
+    u32 ItemCount;
+    u32 JobCount;
+    u32 ChunkSize;
+};
+
+// Shared by the jobs of one loop
+struct parallel_for
+{
+    parallel_for_entry_point *EntryPoint;
+    void *Parameters;
+
+    u32 ItemCount;
+    u32 ChunkSize;
+
+    u64 volatile NextIndex;
+    // Time spent in the chunks by all the jobs
+    u64 volatile Ticks;
+};
+
+struct parallel_for_job
+{
+    parallel_for *Loop;
+    // Reset after every chunk
+    memory_arena Arena;
+};
+
 inline job *
 GetNextJobFromQueue(job_queue *JobQueue)
 {
@@ -38,7 +189,7 @@ GetNextJobFromQueue(job_queue *JobQueue)
 }
 
 inline void
-PutJobIntoQueue(job_queue *JobQueue, job *Job)
+PutJobIntoQueue(job_queue *JobQueue, job *Job, const char *Stage, job_batch *Batch = 0)
 {
     JobQueue->CurrentJobIndex += 1;
     JobQueue->CurrentJobCount += 1;
@@ -50,14 +201,241 @@ PutJobIntoQueue(job_queue *JobQueue, job *Job)
 
     DestJob->EntryPoint = Job->EntryPoint;
     DestJob->Parameters = Job->Parameters;
+    DestJob->Name = Job->Name ? Job->Name : "Job";
+    DestJob->Stage = Stage;
+    DestJob->Batch = Batch;
+
+    if (JobQueue->Stats && (u32) JobQueue->CurrentJobCount > JobQueue->Stats->MaxQueueDepth)
+    {
+        JobQueue->Stats->MaxQueueDepth = (u32) JobQueue->CurrentJobCount;
+    }
 }
 
 inline void
-PutJobsIntoQueue(job_queue *JobQueue, u32 JobCount, job *Jobs)
+PutJobsIntoQueue(job_queue *JobQueue, u32 JobCount, job *Jobs, const char *Stage, job_batch *Batch = 0)
 {
     for (u32 JobIndex = 0; JobIndex < JobCount; ++JobIndex)
     {
         job *Job = Jobs + JobIndex;
-        PutJobIntoQueue(JobQueue, Job);
+        PutJobIntoQueue(JobQueue, Job, Stage, Batch);
     }
 }
+
+// Right after the lock is acquired
+inline void
+RecordJobLockAcquire(job_lock_stats *Lock, u64 WaitTicks)
+{
+    ++Lock->AcquireCount;
+    Lock->WaitTicks += WaitTicks;
+
+    if (WaitTicks > Lock->MaxWaitTicks)
+    {
+        Lock->MaxWaitTicks = WaitTicks;
+    }
+}
+
+// Right before the lock is released
+inline void
+RecordJobLockRelease(job_lock_stats *Lock, u64 HoldTicks)
+{
+    Lock->HoldTicks += HoldTicks;
+
+    if (HoldTicks > Lock->MaxHoldTicks)
+    {
+        Lock->MaxHoldTicks = HoldTicks;
+    }
+}
+
+// Before the job is counted as finished, the waiting thread reads the batch right after
+inline void
+RecordBatchJob(job_batch *Batch, u64 JobTicks)
+{
+    u32 Ticks = JobTicks < U32_MAX ? (u32) JobTicks : U32_MAX;
+
+    AtomicAdd(&Batch->JobTicks, JobTicks);
+
+    u32 SlowestJobTicks = Batch->SlowestJobTicks;
+
+    while (Ticks > SlowestJobTicks)
+    {
+        u32 InitialTicks = AtomicCompareExchange(&Batch->SlowestJobTicks, Ticks, SlowestJobTicks);
+
+        SlowestJobTicks = InitialTicks == SlowestJobTicks ? Ticks : InitialTicks;
+    }
+
+    AtomicIncrement(&Batch->JobCount);
+}
+
+// Thread that waited for the batch, WaitTicks is the time it spent spinning
+dummy_internal void
+RecordJobBatch(job_queue_stats *Stats, const char *Stage, job_batch *Batch, u64 WaitTicks)
+{
+    job_stage_stats *StageStats = 0;
+
+    for (u32 StageIndex = 0; StageIndex < Stats->StageCount && !StageStats; ++StageIndex)
+    {
+        if (Stats->StageKeys[StageIndex] == Stage)
+        {
+            StageStats = Stats->Stages + StageIndex;
+        }
+    }
+
+    if (!StageStats && Stats->StageCount < JOB_MAX_STAGE_COUNT)
+    {
+        u32 StageIndex = Stats->StageCount++;
+
+        Stats->StageKeys[StageIndex] = Stage;
+        StageStats = Stats->Stages + StageIndex;
+        *StageStats = {};
+    }
+
+    if (StageStats && Batch->JobCount > 0)
+    {
+        ++StageStats->BatchCount;
+        StageStats->JobCount += Batch->JobCount;
+        StageStats->JobTicks += Batch->JobTicks;
+        StageStats->SlowestJobTicks += Batch->SlowestJobTicks;
+        StageStats->MeanJobTicks += Batch->JobTicks / Batch->JobCount;
+        StageStats->WaitTicks += WaitTicks;
+    }
+}
+
+// 1 when all jobs took the same time
+inline f32
+GetJobStageImbalance(job_stage_stats *Stage)
+{
+    f32 Result = 0.f;
+
+    if (Stage->MeanJobTicks > 0)
+    {
+        Result = (f32) Stage->SlowestJobTicks / (f32) Stage->MeanJobTicks;
+    }
+
+    return Result;
+}
+
+// Call with the queue lock held, once per frame
+dummy_internal void
+FinishJobQueueFrame(job_queue_stats *Stats)
+{
+    job_queue_frame *Frame = &Stats->LastFrame;
+
+    Frame->WorkerCount = Stats->WorkerCount;
+
+    for (u32 WorkerIndex = 0; WorkerIndex < Stats->WorkerCount; ++WorkerIndex)
+    {
+        job_worker_stats Worker = Stats->Workers[WorkerIndex];
+        job_worker_stats *PrevWorker = Stats->PrevWorkers + WorkerIndex;
+        job_worker_stats *FrameWorker = Frame->Workers + WorkerIndex;
+
+        FrameWorker->JobCount = Worker.JobCount - PrevWorker->JobCount;
+        FrameWorker->BusyTicks = Worker.BusyTicks - PrevWorker->BusyTicks;
+        FrameWorker->IdleTicks = Worker.IdleTicks - PrevWorker->IdleTicks;
+        FrameWorker->DequeueTicks = Worker.DequeueTicks - PrevWorker->DequeueTicks;
+        FrameWorker->LockWaitTicks = Worker.LockWaitTicks - PrevWorker->LockWaitTicks;
+
+        *PrevWorker = Worker;
+    }
+
+    Frame->Lock = Stats->Lock;
+    Frame->MaxQueueDepth = Stats->MaxQueueDepth;
+
+    Stats->Lock = {};
+    Stats->MaxQueueDepth = 0;
+
+    Frame->StageCount = Stats->StageCount;
+
+    for (u32 StageIndex = 0; StageIndex < Stats->StageCount; ++StageIndex)
+    {
+        job_stage_stats *FrameStage = Frame->Stages + StageIndex;
+
+        *FrameStage = Stats->Stages[StageIndex];
+        CopyString(Stats->StageKeys[StageIndex] ? Stats->StageKeys[StageIndex] : "Jobs", FrameStage->Name);
+    }
+
+    // Stage names can point into the game code, which can be reloaded before the next frame
+    Stats->StageCount = 0;
+
+    Stats->QueueDepthHistory[Stats->HistoryIndex] = (f32) Frame->MaxQueueDepth;
+    Stats->HistoryIndex = (Stats->HistoryIndex + 1) % JOB_STATS_HISTORY_COUNT;
+}
+
+// Ticks of work in one chunk, the queue can override the default
+inline f32
+GetParallelForChunkTicks(job_queue *JobQueue, u64 TicksPerSecond)
+{
+    f32 ChunkMicroseconds = JobQueue->ParallelForChunkMicroseconds > 0.f ? JobQueue->ParallelForChunkMicroseconds : PARALLEL_FOR_TARGET_CHUNK_MICROSECONDS;
+
+    f32 Result = ChunkMicroseconds * 1e-6f * (f32) TicksPerSecond;
+    return Result;
+}
+
+// One job per worker, unless the whole loop is expected to take less than a few chunks
+dummy_internal u32
+GetParallelForJobCount(parallel_for_site *Site, u32 ItemCount, u32 WorkerCount, f32 ChunkTicks)
+{
+    u32 Result = WorkerCount > 0 ? WorkerCount : 1;
+
+    if (Site->TicksPerItem > 0.f)
+    {
+        f32 ChunkCount = Site->TicksPerItem * (f32) ItemCount / ChunkTicks;
+        u32 MaxJobCount = (u32) Ceil(ChunkCount / (f32) PARALLEL_FOR_MIN_CHUNKS_PER_JOB);
+
+        if (MaxJobCount < Result)
+        {
+            Result = MaxJobCount > 0 ? MaxJobCount : 1;
+        }
+    }
+
+    if (Result > ItemCount)
+    {
+        Result = ItemCount;
+    }
+
+    return Result;
+}
+
+// Chunks of ChunkTicks, but at least PARALLEL_FOR_MIN_CHUNKS_PER_JOB per job
+dummy_internal u32
+GetParallelForChunkSize(parallel_for_site *Site, u32 ItemCount, u32 JobCount, f32 ChunkTicks)
+{
+    u32 MaxChunkSize = ItemCount / (JobCount * PARALLEL_FOR_MIN_CHUNKS_PER_JOB);
+
+    if (MaxChunkSize == 0)
+    {
+        MaxChunkSize = 1;
+    }
+
+    u32 Result = MaxChunkSize;
+
+    if (Site->TicksPerItem > 0.f)
+    {
+        f32 ChunkSize = ChunkTicks / Site->TicksPerItem;
+
+        if (ChunkSize < (f32) MaxChunkSize)
+        {
+            Result = ChunkSize > 1.f ? (u32) ChunkSize : 1;
+        }
+    }
+
+    return Result;
+}
+
+inline void
+UpdateParallelForSite(parallel_for_site *Site, parallel_for *Loop, u32 JobCount)
+{
+    f32 TicksPerItem = (f32) Loop->Ticks / (f32) Loop->ItemCount;
+
+    if (Site->TicksPerItem > 0.f)
+    {
+        Site->TicksPerItem = Lerp(Site->TicksPerItem, PARALLEL_FOR_COST_SMOOTHING, TicksPerItem);
+    }
+    else
+    {
+        Site->TicksPerItem = TicksPerItem;
+    }
+
+    Site->ItemCount = Loop->ItemCount;
+    Site->JobCount = JobCount;
+    Site->ChunkSize = Loop->ChunkSize;
+}
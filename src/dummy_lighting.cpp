@@ -0,0 +1,295 @@
+#include "dummy.h"
+
+inline u32
+GetLightClusterIndex(u32 x, u32 y, u32 z)
+{
+    u32 Result = (z * LIGHT_CLUSTER_COUNT_Y + y) * LIGHT_CLUSTER_COUNT_X + x;
+    return Result;
+}
+
+// Distance at which the light's contribution drops below POINT_LIGHT_INTENSITY_CUTOFF
+dummy_internal f32
+GetPointLightRadius(point_light *Light)
+{
+    f32 MaxIntensity = Max(Light->Color.x, Max(Light->Color.y, Light->Color.z));
+    light_attenuation Attenuation = Light->Attenuation;
+
+    // Solving Quadratic * d^2 + Linear * d + Constant = MaxIntensity / Cutoff
+    f32 a = Attenuation.Quadratic;
+    f32 b = Attenuation.Linear;
+    f32 c = Attenuation.Constant - MaxIntensity / POINT_LIGHT_INTENSITY_CUTOFF;
+
+    f32 Result = F32_MAX;
+
+    if (c >= 0.f)
+    {
+        // Too dim to ever pass the cutoff
+        Result = 0.f;
+    }
+    else if (a > EPSILON)
+    {
+        Result = (-b + Sqrt(Square(b) - 4.f * a * c)) / (2.f * a);
+    }
+    else if (b > EPSILON)
+    {
+        Result = -c / b;
+    }
+
+    return Result;
+}
+
+dummy_internal void
+CalculatePointLightBounds(u32 PointLightCount, point_light *PointLights, mat4 WorldToCamera, point_light_bounds *Bounds)
+{
+    for (u32 PointLightIndex = 0; PointLightIndex < PointLightCount; ++PointLightIndex)
+    {
+        point_light *PointLight = PointLights + PointLightIndex;
+        point_light_bounds *LightBounds = Bounds + PointLightIndex;
+
+        LightBounds->Position = vec4(WorldToCamera * vec4(PointLight->Position, 1.f)).xyz;
+        LightBounds->Radius = GetPointLightRadius(PointLight);
+    }
+}
+
+dummy_internal void
+InitLightClusterGrid(light_cluster_grid *Grid, game_camera *Camera, memory_arena *Arena)
+{
+    Grid->Near = Camera->NearClipPlane;
+    Grid->Far = Camera->FarClipPlane;
+    Grid->FocalLength = Camera->FocalLength;
+    Grid->AspectRatio = Camera->AspectRatio;
+
+    Grid->Clusters = PushArray(Arena, LIGHT_CLUSTER_COUNT, light_cluster);
+
+    Grid->LightIndexCount = 0;
+    Grid->LightIndices = 0;
+}
+
+// Slices are distributed exponentially, so that the clusters stay roughly cubical
+inline f32
+GetLightClusterSliceDepth(light_cluster_grid *Grid, u32 SliceIndex)
+{
+    f32 Result = Grid->Near * Power(Grid->Far / Grid->Near, (f32)SliceIndex / (f32)LIGHT_CLUSTER_COUNT_Z);
+    return Result;
+}
+
+// View-space extent of the tile's column between the two depths
+inline void
+GetLightClusterTileBounds(u32 TileIndex, u32 TileCount, f32 Scale, f32 SliceNear, f32 SliceFar, f32 *TileMin, f32 *TileMax)
+{
+    f32 NdcMin = -1.f + 2.f * (f32)TileIndex / (f32)TileCount;
+    f32 NdcMax = -1.f + 2.f * (f32)(TileIndex + 1) / (f32)TileCount;
+
+    *TileMin = Scale * Min(NdcMin * SliceNear, NdcMin * SliceFar);
+    *TileMax = Scale * Max(NdcMax * SliceNear, NdcMax * SliceFar);
+}
+
+inline bool32
+SphereIntersectsBox(vec3 Center, f32 Radius, vec3 BoxMin, vec3 BoxMax)
+{
+    vec3 ClosestPoint = Min(Max(Center, BoxMin), BoxMax);
+    bool32 Result = SquaredMagnitude(Center - ClosestPoint) <= Square(Radius);
+
+    return Result;
+}
+
+inline bool32
+IntervalsOverlap(f32 MinA, f32 MaxA, f32 MinB, f32 MaxB)
+{
+    bool32 Result = MinA <= MaxB && MinB <= MaxA;
+    return Result;
+}
+
+inline void
+AddLightToCluster(light_cluster_grid *Grid, light_cluster *Cluster, u32 LightIndex, bool32 WriteIndices)
+{
+    if (WriteIndices)
+    {
+        Grid->LightIndices[Cluster->Offset + Cluster->Count] = LightIndex;
+    }
+
+    ++Cluster->Count;
+}
+
+/*
+    Bins the lights into the clusters of a single depth slice, so the slices can be processed in parallel.
+    Called twice: first pass counts lights per cluster, second pass (after AllocateLightIndices) writes the indices.
+    Lights are tested in order, so the result is the same as of BinPointLightsReference.
+*/
+dummy_internal void
+BinPointLightsInSlice(light_cluster_grid *Grid, u32 SliceIndex, u32 LightCount, point_light_bounds *LightBounds, bool32 WriteIndices)
+{
+    f32 SliceNear = GetLightClusterSliceDepth(Grid, SliceIndex);
+    f32 SliceFar = GetLightClusterSliceDepth(Grid, SliceIndex + 1);
+
+    f32 ScaleX = Grid->AspectRatio / Grid->FocalLength;
+    f32 ScaleY = 1.f / Grid->FocalLength;
+
+    f32 TileMinX[LIGHT_CLUSTER_COUNT_X];
+    f32 TileMaxX[LIGHT_CLUSTER_COUNT_X];
+    f32 TileMinY[LIGHT_CLUSTER_COUNT_Y];
+    f32 TileMaxY[LIGHT_CLUSTER_COUNT_Y];
+
+    for (u32 x = 0; x < LIGHT_CLUSTER_COUNT_X; ++x)
+    {
+        GetLightClusterTileBounds(x, LIGHT_CLUSTER_COUNT_X, ScaleX, SliceNear, SliceFar, TileMinX + x, TileMaxX + x);
+    }
+
+    for (u32 y = 0; y < LIGHT_CLUSTER_COUNT_Y; ++y)
+    {
+        GetLightClusterTileBounds(y, LIGHT_CLUSTER_COUNT_Y, ScaleY, SliceNear, SliceFar, TileMinY + y, TileMaxY + y);
+    }
+
+    light_cluster *SliceClusters = Grid->Clusters + GetLightClusterIndex(0, 0, SliceIndex);
+
+    for (u32 ClusterIndex = 0; ClusterIndex < LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y; ++ClusterIndex)
+    {
+        SliceClusters[ClusterIndex].Count = 0;
+    }
+
+    for (u32 LightIndex = 0; LightIndex < LightCount; ++LightIndex)
+    {
+        point_light_bounds *Light = LightBounds + LightIndex;
+
+        vec3 Center = Light->Position;
+        f32 Radius = Light->Radius;
+
+        // Camera is looking down -z
+        if (!IntervalsOverlap(-Center.z - Radius, -Center.z + Radius, SliceNear, SliceFar))
+        {
+            continue;
+        }
+
+        for (u32 y = 0; y < LIGHT_CLUSTER_COUNT_Y; ++y)
+        {
+            if (!IntervalsOverlap(Center.y - Radius, Center.y + Radius, TileMinY[y], TileMaxY[y]))
+            {
+                continue;
+            }
+
+            for (u32 x = 0; x < LIGHT_CLUSTER_COUNT_X; ++x)
+            {
+                if (!IntervalsOverlap(Center.x - Radius, Center.x + Radius, TileMinX[x], TileMaxX[x]))
+                {
+                    continue;
+                }
+
+                vec3 BoxMin = vec3(TileMinX[x], TileMinY[y], -SliceFar);
+                vec3 BoxMax = vec3(TileMaxX[x], TileMaxY[y], -SliceNear);
+
+                if (SphereIntersectsBox(Center, Radius, BoxMin, BoxMax))
+                {
+                    light_cluster *Cluster = Grid->Clusters + GetLightClusterIndex(x, y, SliceIndex);
+                    AddLightToCluster(Grid, Cluster, LightIndex, WriteIndices);
+                }
+            }
+        }
+    }
+}
+
+// Turns light counts into offsets in the compact light index list
+dummy_internal void
+AllocateLightIndices(light_cluster_grid *Grid, memory_arena *Arena)
+{
+    u32 LightIndexCount = 0;
+
+    for (u32 ClusterIndex = 0; ClusterIndex < LIGHT_CLUSTER_COUNT; ++ClusterIndex)
+    {
+        light_cluster *Cluster = Grid->Clusters + ClusterIndex;
+
+        Cluster->Offset = LightIndexCount;
+        LightIndexCount += Cluster->Count;
+    }
+
+    Grid->LightIndexCount = LightIndexCount;
+    Grid->LightIndices = PushArray(Arena, LightIndexCount, u32, NoClear());
+}
+
+// Both passes over all the slices on the calling thread, the same work as the binning jobs of a frame
+dummy_internal void
+BinPointLights(light_cluster_grid *Grid, u32 LightCount, point_light_bounds *LightBounds, memory_arena *Arena)
+{
+    for (u32 SliceIndex = 0; SliceIndex < LIGHT_CLUSTER_COUNT_Z; ++SliceIndex)
+    {
+        BinPointLightsInSlice(Grid, SliceIndex, LightCount, LightBounds, false);
+    }
+
+    AllocateLightIndices(Grid, Arena);
+
+    for (u32 SliceIndex = 0; SliceIndex < LIGHT_CLUSTER_COUNT_Z; ++SliceIndex)
+    {
+        BinPointLightsInSlice(Grid, SliceIndex, LightCount, LightBounds, true);
+    }
+}
+
+// Tests every light against every cluster
+dummy_internal void
+BinPointLightsReference(light_cluster_grid *Grid, u32 LightCount, point_light_bounds *LightBounds, memory_arena *Arena)
+{
+    f32 ScaleX = Grid->AspectRatio / Grid->FocalLength;
+    f32 ScaleY = 1.f / Grid->FocalLength;
+
+    for (u32 Pass = 0; Pass < 2; ++Pass)
+    {
+        bool32 WriteIndices = Pass == 1;
+
+        if (WriteIndices)
+        {
+            AllocateLightIndices(Grid, Arena);
+        }
+
+        for (u32 z = 0; z < LIGHT_CLUSTER_COUNT_Z; ++z)
+        {
+            f32 SliceNear = GetLightClusterSliceDepth(Grid, z);
+            f32 SliceFar = GetLightClusterSliceDepth(Grid, z + 1);
+
+            for (u32 y = 0; y < LIGHT_CLUSTER_COUNT_Y; ++y)
+            {
+                for (u32 x = 0; x < LIGHT_CLUSTER_COUNT_X; ++x)
+                {
+                    vec3 BoxMin;
+                    vec3 BoxMax;
+
+                    GetLightClusterTileBounds(x, LIGHT_CLUSTER_COUNT_X, ScaleX, SliceNear, SliceFar, &BoxMin.x, &BoxMax.x);
+                    GetLightClusterTileBounds(y, LIGHT_CLUSTER_COUNT_Y, ScaleY, SliceNear, SliceFar, &BoxMin.y, &BoxMax.y);
+                    BoxMin.z = -SliceFar;
+                    BoxMax.z = -SliceNear;
+
+                    light_cluster *Cluster = Grid->Clusters + GetLightClusterIndex(x, y, z);
+                    Cluster->Count = 0;
+
+                    for (u32 LightIndex = 0; LightIndex < LightCount; ++LightIndex)
+                    {
+                        point_light_bounds *Light = LightBounds + LightIndex;
+
+                        if (SphereIntersectsBox(Light->Position, Light->Radius, BoxMin, BoxMax))
+                        {
+                            AddLightToCluster(Grid, Cluster, LightIndex, WriteIndices);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+dummy_internal bool32
+LightClusterGridsEqual(light_cluster_grid *A, light_cluster_grid *B)
+{
+    bool32 Result = A->LightIndexCount == B->LightIndexCount;
+
+    for (u32 ClusterIndex = 0; Result && ClusterIndex < LIGHT_CLUSTER_COUNT; ++ClusterIndex)
+    {
+        light_cluster *ClusterA = A->Clusters + ClusterIndex;
+        light_cluster *ClusterB = B->Clusters + ClusterIndex;
+
+        Result = ClusterA->Offset == ClusterB->Offset && ClusterA->Count == ClusterB->Count;
+    }
+
+    for (u32 Index = 0; Result && Index < A->LightIndexCount; ++Index)
+    {
+        Result = A->LightIndices[Index] == B->LightIndices[Index];
+    }
+
+    return Result;
+}
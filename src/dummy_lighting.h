@@ -0,0 +1,25 @@
+#pragma once
+
+// Light is ignored once its contribution drops below this value
+#define POINT_LIGHT_INTENSITY_CUTOFF (1.f / 256.f)
+
+// View-space froxel grid (tiles in NDC x/y, exponential slices in depth) with compact per-cluster light index lists
+struct light_cluster_grid
+{
+    f32 Near;
+    f32 Far;
+    f32 FocalLength;
+    f32 AspectRatio;
+
+    light_cluster *Clusters;
+
+    u32 LightIndexCount;
+    u32 *LightIndices;
+};
+
+// View-space bounding sphere of the point light
+struct point_light_bounds
+{
+    vec3 Position;
+    f32 Radius;
+};
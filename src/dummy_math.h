@@ -86,6 +86,13 @@ Power(f32 Value, f32 Power)
     return Result;
 }
 
+inline f32
+Log(f32 Value)
+{
+    f32 Result = logf(Value);
+    return Result;
+}
+
 inline f32
 Sqrt(f32 Value)
 {
@@ -905,3 +912,223 @@ GetCuboidInertiaTensor(f32 Mass, vec3 Size)
 
     return Result;
 }
+
+inline i32
+Round(f32 Value)
+{
+    i32 Result = (i32)roundf(Value);
+    return Result;
+}
+
+// IEEE 754 half-precision float (denormals are flushed to zero)
+inline u16
+PackHalf(f32 Value)
+{
+    union
+    {
+        f32 f;
+        u32 u;
+    } Bits;
+
+    Bits.f = Value;
+
+    u32 Sign = (Bits.u >> 16) & 0x8000;
+    i32 Exponent = (i32)((Bits.u >> 23) & 0xFF) - 127 + 15;
+    u32 Mantissa = Bits.u & 0x7FFFFF;
+
+    u32 Result = Sign;
+
+    if (Exponent >= 31)
+    {
+        // Overflow (and NaN) becomes infinity
+        Result |= 0x7C00;
+    }
+    else if (Exponent > 0)
+    {
+        Result |= (Exponent << 10) | (Mantissa >> 13);
+
+        // Round to nearest, carry goes into exponent
+        if (Mantissa & 0x1000)
+        {
+            ++Result;
+        }
+    }
+
+    return (u16)Result;
+}
+
+inline f32
+UnpackHalf(u16 Value)
+{
+    union
+    {
+        f32 f;
+        u32 u;
+    } Bits;
+
+    u32 Sign = (u32)(Value & 0x8000) << 16;
+    u32 Exponent = (Value >> 10) & 0x1F;
+    u32 Mantissa = Value & 0x3FF;
+
+    if (Exponent == 0)
+    {
+        Bits.f = (f32)Mantissa / 16777216.f;
+        Bits.u |= Sign;
+    }
+    else if (Exponent == 31)
+    {
+        Bits.u = Sign | 0x7F800000 | (Mantissa << 13);
+    }
+    else
+    {
+        Bits.u = Sign | ((Exponent - 15 + 127) << 23) | (Mantissa << 13);
+    }
+
+    return Bits.f;
+}
+
+// Matches GLSL packSnorm2x16/unpackSnorm2x16
+inline i16
+PackSnorm16(f32 Value)
+{
+    i16 Result = (i16)Round(Clamp(Value, -1.f, 1.f) * 32767.f);
+    return Result;
+}
+
+inline f32
+UnpackSnorm16(i16 Value)
+{
+    f32 Result = Max((f32)Value / 32767.f, -1.f);
+    return Result;
+}
+
+// Matches GLSL packUnorm4x8/unpackUnorm4x8 (x is stored in the least significant byte)
+inline u32
+PackUnorm4x8(vec4 Value)
+{
+    u32 r = (u32)Round(Clamp(Value.x, 0.f, 1.f) * 255.f);
+    u32 g = (u32)Round(Clamp(Value.y, 0.f, 1.f) * 255.f);
+    u32 b = (u32)Round(Clamp(Value.z, 0.f, 1.f) * 255.f);
+    u32 a = (u32)Round(Clamp(Value.w, 0.f, 1.f) * 255.f);
+
+    u32 Result = r | (g << 8) | (b << 16) | (a << 24);
+
+    return Result;
+}
+
+inline vec4
+UnpackUnorm4x8(u32 Value)
+{
+    vec4 Result = vec4(
+        (f32)((Value >> 0) & 0xFF) / 255.f,
+        (f32)((Value >> 8) & 0xFF) / 255.f,
+        (f32)((Value >> 16) & 0xFF) / 255.f,
+        (f32)((Value >> 24) & 0xFF) / 255.f
+    );
+
+    return Result;
+}
+
+inline u16
+PackUnorm16(f32 Value)
+{
+    u16 Result = (u16)Round(Clamp(Value, 0.f, 1.f) * 65535.f);
+    return Result;
+}
+
+inline f32
+UnpackUnorm16(u16 Value)
+{
+    f32 Result = (f32)Value / 65535.f;
+    return Result;
+}
+
+inline f32
+SignNotZero(f32 Value)
+{
+    f32 Result = Value >= 0.f ? 1.f : -1.f;
+    return Result;
+}
+
+// Unit vector projected onto an octahedron, which is unfolded into [-1, 1]^2
+inline vec2
+EncodeOctahedral(vec3 Vector)
+{
+    f32 Length = Abs(Vector.x) + Abs(Vector.y) + Abs(Vector.z);
+
+    // Degenerate vectors end up pointing along +z
+    vec3 Projected = Length > 0.f ? Vector / Length : vec3(0.f, 0.f, 1.f);
+
+    vec2 Result = vec2(Projected.x, Projected.y);
+
+    if (Projected.z < 0.f)
+    {
+        Result.x = (1.f - Abs(Projected.y)) * SignNotZero(Projected.x);
+        Result.y = (1.f - Abs(Projected.x)) * SignNotZero(Projected.y);
+    }
+
+    return Result;
+}
+
+// Matches DecodeOctahedral in math.glsl
+inline vec3
+DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Result = vec3(Encoded.x, Encoded.y, 1.f - Abs(Encoded.x) - Abs(Encoded.y));
+
+    f32 t = Max(-Result.z, 0.f);
+    Result.x += Result.x >= 0.f ? -t : t;
+    Result.y += Result.y >= 0.f ? -t : t;
+
+    Result = Normalize(Result);
+
+    return Result;
+}
+
+// Octahedral snorm16x2 (x is stored in the low half, matches GLSL unpackSnorm2x16)
+inline u32
+PackOctahedral(vec3 Vector)
+{
+    vec2 Encoded = EncodeOctahedral(Vector);
+
+    u32 Result = (u16)PackSnorm16(Encoded.x) | ((u32)(u16)PackSnorm16(Encoded.y) << 16);
+    return Result;
+}
+
+inline vec3
+UnpackOctahedral(u32 Value)
+{
+    vec2 Encoded = vec2(UnpackSnorm16((i16)(Value & 0xFFFF)), UnpackSnorm16((i16)(Value >> 16)));
+
+    vec3 Result = DecodeOctahedral(Encoded);
+    return Result;
+}
+
+/*
+    Octahedral tangent with the bitangent sign folded into y: y is remapped to (0, 1] and multiplied by the sign.
+    Costs one bit of y precision, the bitangent is Sign * Cross(Normal, Tangent).
+*/
+inline u32
+PackTangent(vec3 Tangent, f32 BitangentSign)
+{
+    vec2 Encoded = EncodeOctahedral(Tangent);
+
+    // Smallest positive snorm16 value, so the sign survives when y is -1
+    f32 y = Max(Encoded.y * 0.5f + 0.5f, 1.f / 32767.f) * SignNotZero(BitangentSign);
+
+    u32 Result = (u16)PackSnorm16(Encoded.x) | ((u32)(u16)PackSnorm16(y) << 16);
+    return Result;
+}
+
+// Matches DecodeTangent in math.glsl
+inline vec3
+UnpackTangent(u32 Value, f32 *BitangentSign)
+{
+    f32 x = UnpackSnorm16((i16)(Value & 0xFFFF));
+    f32 y = UnpackSnorm16((i16)(Value >> 16));
+
+    *BitangentSign = SignNotZero(y);
+
+    vec3 Result = DecodeOctahedral(vec2(x, Abs(y) * 2.f - 1.f));
+    return Result;
+}
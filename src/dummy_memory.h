@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory.h>
+#include <string.h>
 
 #undef CopyMemory
 
@@ -42,27 +43,276 @@ AlignAddress(umm Address, umm Alignment)
     return Result;
 }
 
+// Commits the pages of the reserved memory (see PLATFORM_RESERVE_MEMORY)
+#define PLATFORM_COMMIT_MEMORY(name) void name(void *Memory, umm Size)
+typedef PLATFORM_COMMIT_MEMORY(platform_commit_memory);
+
+// Growable arenas commit at least this much at a time
+#define ARENA_COMMIT_SIZE Kilobytes(64)
+
 struct memory_arena
 {
     umm Size;
     umm Used;
     void *Base;
+
+    // Growable arenas reserve Size bytes up front and commit them on demand, CommitMemory is 0 for the others
+    umm CommittedSize;
+    platform_commit_memory *CommitMemory;
+
+    // Peak of Used over the lifetime of the arena and within the innermost scoped_memory
+    umm HighWater;
+    umm RegionHighWater;
+
+    // Pushes since the last sample (see ResetFrameMemoryStats)
+    u32 FrameAllocationCount;
+    umm FrameAllocatedSize;
+};
+
+// Reported to the profiler (see StoreProfileMemorySample)
+struct memory_stats
+{
+    umm Used;
+    umm HighWater;
+    // Part of Size that is backed by memory (committed pages of the growable arenas)
+    umm Committed;
+    umm Size;
+    u32 AllocationCount;
+
+    // Arenas only: pushes since the previous sample
+    u32 FrameAllocationCount;
+    umm FrameAllocatedSize;
+};
+
+#if MEMORY_TELEMETRY
+// Has to be a power of 2
+#define MEMORY_MAX_CALL_SITE_COUNT 2048
+
+enum memory_call_site_state
+{
+    MemoryCallSite_Empty,
+    MemoryCallSite_Writing,
+    MemoryCallSite_Ready
+};
+
+/*
+    Pushes of one PushSize/PushType/PushArray call site, or the regions of one scoped_memory.
+    Each region counts as one allocation and its size is the peak usage of the arena within the region.
+*/
+struct memory_call_site
+{
+    u32 volatile State;
+    u32 Line;
+    bool32 Region;
+
+    // __FILE__ of the module that pushed last, the copy of the file name outlives the game code reload
+    const char *Key;
+    char FileName[48];
+
+    // Written by any thread
+    u32 volatile FrameCount;
+    u64 volatile FrameSize;
+
+    // Updated once per frame (see ResetMemoryTelemetryFrame)
+    u32 LastFrameCount;
+    u64 LastFrameSize;
+    u32 PeakFrameCount;
+    u64 PeakFrameSize;
+    u64 TotalCount;
+    u64 TotalSize;
+};
+
+struct memory_telemetry
+{
+    memory_call_site CallSites[MEMORY_MAX_CALL_SITE_COUNT];
 };
 
+// Same table for the platform and the game code, each module sets its own pointer
+dummy_global memory_telemetry *MemoryTelemetry;
+
+inline const char *
+GetMemoryCallSiteFileName(const char *File)
+{
+    const char *Result = File;
+
+    for (const char *Char = File; *Char; ++Char)
+    {
+        if (*Char == '\\' || *Char == '/')
+        {
+            Result = Char + 1;
+        }
+    }
+
+    return Result;
+}
+
+// Finds or registers the call site, returns 0 once the table is full
+dummy_internal memory_call_site *
+GetMemoryCallSite(memory_telemetry *Telemetry, const char *File, u32 Line, bool32 Region)
+{
+    memory_call_site *Result = 0;
+
+    u32 Index = (Line * 2654435761u) & (MEMORY_MAX_CALL_SITE_COUNT - 1);
+    u32 ProbeCount = 0;
+
+    while (!Result && ProbeCount < MEMORY_MAX_CALL_SITE_COUNT)
+    {
+        memory_call_site *Site = Telemetry->CallSites + Index;
+
+        if (Site->State == MemoryCallSite_Empty)
+        {
+            // Slot is checked again if the other thread takes it first
+            if (AtomicCompareExchange(&Site->State, MemoryCallSite_Writing, MemoryCallSite_Empty) == MemoryCallSite_Empty)
+            {
+                Site->Line = Line;
+                Site->Region = Region;
+                Site->Key = File;
+                strncpy_s(Site->FileName, ArrayCount(Site->FileName), GetMemoryCallSiteFileName(File), _TRUNCATE);
+
+                CompilerBarrier();
+                Site->State = MemoryCallSite_Ready;
+
+                Result = Site;
+            }
+        }
+        else
+        {
+            while (Site->State == MemoryCallSite_Writing) {}
+
+            // Pointers of the different modules differ for the same file, the names are compared then
+            if (Site->Line == Line && Site->Region == Region &&
+                (Site->Key == File || strcmp(Site->FileName, GetMemoryCallSiteFileName(File)) == 0))
+            {
+                Site->Key = File;
+                Result = Site;
+            }
+            else
+            {
+                Index = (Index + 1) & (MEMORY_MAX_CALL_SITE_COUNT - 1);
+                ++ProbeCount;
+            }
+        }
+    }
+
+    return Result;
+}
+
+inline void
+RecordMemoryPush(const char *File, u32 Line, umm Size)
+{
+    if (MemoryTelemetry)
+    {
+        memory_call_site *Site = GetMemoryCallSite(MemoryTelemetry, File, Line, false);
+
+        if (Site)
+        {
+            AtomicIncrement(&Site->FrameCount);
+            AtomicAdd(&Site->FrameSize, Size);
+        }
+    }
+}
+
+inline void
+RecordMemoryRegion(const char *File, u32 Line, umm PeakSize)
+{
+    if (MemoryTelemetry)
+    {
+        memory_call_site *Site = GetMemoryCallSite(MemoryTelemetry, File, Line, true);
+
+        if (Site)
+        {
+            AtomicIncrement(&Site->FrameCount);
+
+            // Racy, the regions of the same call site rarely end at the same time on different threads
+            if (PeakSize > Site->FrameSize)
+            {
+                Site->FrameSize = PeakSize;
+            }
+        }
+    }
+}
+
+// Once per frame on the main thread (see ProfilerStartFrame)
+dummy_internal void
+ResetMemoryTelemetryFrame(memory_telemetry *Telemetry)
+{
+    for (u32 CallSiteIndex = 0; CallSiteIndex < MEMORY_MAX_CALL_SITE_COUNT; ++CallSiteIndex)
+    {
+        memory_call_site *Site = Telemetry->CallSites + CallSiteIndex;
+
+        if (Site->State == MemoryCallSite_Ready)
+        {
+            u32 FrameCount = Site->FrameCount;
+            u64 FrameSize = Site->FrameSize;
+
+            Site->FrameCount = 0;
+            Site->FrameSize = 0;
+
+            Site->LastFrameCount = FrameCount;
+            Site->LastFrameSize = FrameSize;
+
+            if (FrameCount > Site->PeakFrameCount)
+            {
+                Site->PeakFrameCount = FrameCount;
+            }
+
+            if (FrameSize > Site->PeakFrameSize)
+            {
+                Site->PeakFrameSize = FrameSize;
+            }
+
+            Site->TotalCount += FrameCount;
+
+            // Sizes of the regions are peaks, they don't add up
+            if (!Site->Region)
+            {
+                Site->TotalSize += FrameSize;
+            }
+        }
+    }
+}
+#endif
+
 struct memory_arena_push_options
 {
     umm Alignment;
     bool32 Clear;
 };
 
+// Region call site comes from the default arguments, so that the declarations stay the same
 struct scoped_memory
 {
     memory_arena *Arena;
     umm Used;
+    umm RegionHighWater;
+
+#if MEMORY_TELEMETRY
+    const char *File;
+    u32 Line;
+#endif
+
+    scoped_memory(memory_arena *Arena, const char *File = __builtin_FILE(), u32 Line = __builtin_LINE()) : Arena(Arena), Used(Arena->Used)
+    {
+        RegionHighWater = Arena->RegionHighWater;
+        Arena->RegionHighWater = Arena->Used;
+
+#if MEMORY_TELEMETRY
+        this->File = File;
+        this->Line = Line;
+#endif
+    }
 
-    scoped_memory(memory_arena *Arena) : Arena(Arena), Used(Arena->Used) {}
     ~scoped_memory()
     {
+#if MEMORY_TELEMETRY
+        RecordMemoryRegion(File, Line, Arena->RegionHighWater - Used);
+#endif
+
+        if (RegionHighWater > Arena->RegionHighWater)
+        {
+            Arena->RegionHighWater = RegionHighWater;
+        }
+
         Arena->Used = Used;
     }
 };
@@ -126,6 +376,18 @@ InitMemoryArena(memory_arena *Arena, void *Memory, umm Size)
     Arena->Base = Memory;
     Arena->Size = Size;
     Arena->Used = 0;
+    Arena->CommittedSize = Size;
+    Arena->CommitMemory = 0;
+}
+
+inline void
+InitGrowableMemoryArena(memory_arena *Arena, void *ReservedMemory, umm ReservedSize, platform_commit_memory *CommitMemory)
+{
+    Arena->Base = ReservedMemory;
+    Arena->Size = ReservedSize;
+    Arena->Used = 0;
+    Arena->CommittedSize = 0;
+    Arena->CommitMemory = CommitMemory;
 }
 
 inline void
@@ -134,8 +396,9 @@ ClearMemoryArena(memory_arena *Arena)
     Arena->Used = 0;
 }
 
+// Called through the PushSize macro, which passes the call site
 inline void *
-PushSize(memory_arena *Arena, umm Size, memory_arena_push_options Options = DefaultArenaPushOptions())
+PushSize_(memory_arena *Arena, umm Size, const char *File, u32 Line, memory_arena_push_options Options = DefaultArenaPushOptions())
 {
     umm Alignment = Options.Alignment;
     bool32 Clear = Options.Clear;
@@ -148,9 +411,42 @@ PushSize(memory_arena *Arena, umm Size, memory_arena_push_options Options = Defa
 
     Assert(Arena->Used + AlignedSize < Arena->Size);
 
+    // Committed pages are kept when the arena is cleared
+    if (Arena->Used + AlignedSize > Arena->CommittedSize)
+    {
+        Assert(Arena->CommitMemory);
+
+        umm CommitSize = AlignAddress(Arena->Used + AlignedSize - Arena->CommittedSize, ARENA_COMMIT_SIZE);
+
+        if (Arena->CommittedSize + CommitSize > Arena->Size)
+        {
+            CommitSize = Arena->Size - Arena->CommittedSize;
+        }
+
+        Arena->CommitMemory((u8 *)Arena->Base + Arena->CommittedSize, CommitSize);
+        Arena->CommittedSize += CommitSize;
+    }
+
     void *Result = (void *)AlignedAddress;
     Arena->Used += AlignedSize;
 
+    if (Arena->Used > Arena->HighWater)
+    {
+        Arena->HighWater = Arena->Used;
+    }
+
+    if (Arena->Used > Arena->RegionHighWater)
+    {
+        Arena->RegionHighWater = Arena->Used;
+    }
+
+    ++Arena->FrameAllocationCount;
+    Arena->FrameAllocatedSize += AlignedSize;
+
+#if MEMORY_TELEMETRY
+    RecordMemoryPush(File, Line, AlignedSize);
+#endif
+
     if (Clear)
     {
         ClearMemory(Result, AlignedSize);
@@ -159,17 +455,623 @@ PushSize(memory_arena *Arena, umm Size, memory_arena_push_options Options = Defa
     return Result;
 }
 
+#define PushSize(Arena, Size, ...) PushSize_(Arena, Size, __FILE__, __LINE__, __VA_ARGS__)
+
 inline memory_arena
-SubMemoryArena(memory_arena *Arena, umm Size, memory_arena_push_options Options = DefaultArenaPushOptions())
+SubMemoryArena_(memory_arena *Arena, umm Size, const char *File, u32 Line, memory_arena_push_options Options = DefaultArenaPushOptions())
 {
     memory_arena Result = {};
 
     Result.Size = Size;
-    Result.Base = PushSize(Arena, Size, Options);
+    Result.Base = PushSize_(Arena, Size, File, Line, Options);
+    Result.CommittedSize = Size;
 
     return Result;
 }
 
+inline memory_stats
+GetMemoryStats(memory_arena *Arena)
+{
+    memory_stats Result = {};
+
+    Result.Used = Arena->Used;
+    Result.HighWater = Arena->HighWater;
+    Result.Committed = Arena->CommittedSize;
+    Result.Size = Arena->Size;
+    Result.FrameAllocationCount = Arena->FrameAllocationCount;
+    Result.FrameAllocatedSize = Arena->FrameAllocatedSize;
+
+    return Result;
+}
+
+// Other allocators don't count the allocations per frame
+template <typename T>
+inline void
+ResetFrameMemoryStats(T *Allocator)
+{
+}
+
+inline void
+ResetFrameMemoryStats(memory_arena *Arena)
+{
+    Arena->FrameAllocationCount = 0;
+    Arena->FrameAllocatedSize = 0;
+}
+
+#define SubMemoryArena(Arena, Size, ...) SubMemoryArena_(Arena, Size, __FILE__, __LINE__, __VA_ARGS__)
 #define PushType(Arena, Type, ...) (Type *)PushSize(Arena, sizeof(Type), __VA_ARGS__)
 #define PushArray(Arena, Count, Type, ...) (Type *)PushSize(Arena, Count * sizeof(Type), __VA_ARGS__)
 #define PushString(Arena, Count, ...) (char *)PushArray(Arena, Count, char, __VA_ARGS__)
+
+// All blocks start at this alignment, the first bytes of a block keep its size
+#define FREE_LIST_BLOCK_ALIGNMENT 64
+
+struct free_list_block
+{
+    umm Size;
+    free_list_block *Next;
+};
+
+/*
+    First-fit allocator for blocks of different sizes, which are freed in any order.
+    Free blocks are kept sorted by address, so that neighbours are merged when a block is freed.
+*/
+struct free_list_allocator
+{
+    umm Size;
+    umm Used;
+    void *Base;
+
+    free_list_block *FirstFree;
+
+    umm HighWater;
+    u32 AllocationCount;
+};
+
+inline void
+InitFreeListAllocator(free_list_allocator *Allocator, void *Memory, umm Size)
+{
+    Assert(AlignAddress((umm)Memory, FREE_LIST_BLOCK_ALIGNMENT) == (umm)Memory);
+
+    Allocator->Base = Memory;
+    Allocator->Size = Size;
+    Allocator->Used = 0;
+    Allocator->HighWater = 0;
+    Allocator->AllocationCount = 0;
+
+    free_list_block *Block = (free_list_block *)Memory;
+    Block->Size = Size;
+    Block->Next = 0;
+
+    Allocator->FirstFree = Block;
+}
+
+// Returns 0 if there is no free block large enough
+dummy_internal void *
+AllocateBlock(free_list_allocator *Allocator, umm Size)
+{
+    void *Result = 0;
+
+    umm BlockSize = AlignAddress(Size + FREE_LIST_BLOCK_ALIGNMENT, FREE_LIST_BLOCK_ALIGNMENT);
+
+    free_list_block **Link = &Allocator->FirstFree;
+
+    while (*Link)
+    {
+        free_list_block *Block = *Link;
+
+        if (Block->Size >= BlockSize)
+        {
+            umm RemainingSize = Block->Size - BlockSize;
+
+            if (RemainingSize >= 2 * FREE_LIST_BLOCK_ALIGNMENT)
+            {
+                free_list_block *RemainingBlock = (free_list_block *)((u8 *)Block + BlockSize);
+                RemainingBlock->Size = RemainingSize;
+                RemainingBlock->Next = Block->Next;
+
+                *Link = RemainingBlock;
+                Block->Size = BlockSize;
+            }
+            else
+            {
+                *Link = Block->Next;
+            }
+
+            Allocator->Used += Block->Size;
+            ++Allocator->AllocationCount;
+
+            if (Allocator->Used > Allocator->HighWater)
+            {
+                Allocator->HighWater = Allocator->Used;
+            }
+
+            Result = (u8 *)Block + FREE_LIST_BLOCK_ALIGNMENT;
+            break;
+        }
+
+        Link = &Block->Next;
+    }
+
+    return Result;
+}
+
+dummy_internal void
+FreeBlock(free_list_allocator *Allocator, void *Memory)
+{
+    free_list_block *Block = (free_list_block *)((u8 *)Memory - FREE_LIST_BLOCK_ALIGNMENT);
+
+    Assert(Allocator->Used >= Block->Size);
+    Allocator->Used -= Block->Size;
+    --Allocator->AllocationCount;
+
+    free_list_block *Prev = 0;
+    free_list_block *Next = Allocator->FirstFree;
+
+    while (Next && Next < Block)
+    {
+        Prev = Next;
+        Next = Next->Next;
+    }
+
+    Block->Next = Next;
+
+    if (Prev)
+    {
+        Prev->Next = Block;
+    }
+    else
+    {
+        Allocator->FirstFree = Block;
+    }
+
+    if (Next && (u8 *)Block + Block->Size == (u8 *)Next)
+    {
+        Block->Size += Next->Size;
+        Block->Next = Next->Next;
+    }
+
+    if (Prev && (u8 *)Prev + Prev->Size == (u8 *)Block)
+    {
+        Prev->Size += Block->Size;
+        Prev->Next = Block->Next;
+    }
+}
+
+inline memory_stats
+GetMemoryStats(free_list_allocator *Allocator)
+{
+    memory_stats Result = {};
+
+    Result.Used = Allocator->Used;
+    Result.HighWater = Allocator->HighWater;
+    Result.Committed = Allocator->Size;
+    Result.Size = Allocator->Size;
+    Result.AllocationCount = Allocator->AllocationCount;
+
+    return Result;
+}
+
+/*
+    Fixed-size items (entity components), allocated and freed in O(1).
+    Free items keep the pointer to the next free item in their first bytes.
+    The items are pushed from the arena up front (and count as committed), but they are handed out in order until the first one is freed,
+    so the untouched part of the pool is never written and stays out of the working set.
+*/
+template <typename T>
+struct memory_pool
+{
+    u32 MaxItemCount;
+    u32 UsedItemCount;
+    // Items taken from the pool so far, the rest was never used
+    u32 TouchedItemCount;
+    u32 HighWaterItemCount;
+
+    T *Items;
+    void *FirstFree;
+};
+
+template <typename T>
+inline void
+InitMemoryPool(memory_pool<T> *Pool, u32 MaxItemCount, memory_arena *Arena)
+{
+    static_assert(sizeof(T) >= sizeof(void *), "Pool items keep the free list link");
+
+    Pool->MaxItemCount = MaxItemCount;
+    Pool->UsedItemCount = 0;
+    Pool->TouchedItemCount = 0;
+    Pool->HighWaterItemCount = 0;
+    Pool->Items = PushArray(Arena, MaxItemCount, T, AlignNoClear(16));
+    Pool->FirstFree = 0;
+}
+
+template <typename T>
+inline T *
+PoolAllocate(memory_pool<T> *Pool)
+{
+    T *Result = 0;
+
+    if (Pool->FirstFree)
+    {
+        Result = (T *)Pool->FirstFree;
+        Pool->FirstFree = *(void **)Pool->FirstFree;
+    }
+    else
+    {
+        Assert(Pool->TouchedItemCount < Pool->MaxItemCount);
+        Result = Pool->Items + Pool->TouchedItemCount++;
+    }
+
+    ClearMemory(Result, sizeof(T));
+
+    ++Pool->UsedItemCount;
+
+    if (Pool->UsedItemCount > Pool->HighWaterItemCount)
+    {
+        Pool->HighWaterItemCount = Pool->UsedItemCount;
+    }
+
+    return Result;
+}
+
+template <typename T>
+inline void
+PoolFree(memory_pool<T> *Pool, T *Item)
+{
+    Assert(Item >= Pool->Items && Item < Pool->Items + Pool->TouchedItemCount);
+    Assert(Pool->UsedItemCount > 0);
+
+    *(void **)Item = Pool->FirstFree;
+    Pool->FirstFree = Item;
+
+    --Pool->UsedItemCount;
+}
+
+template <typename T>
+inline memory_stats
+GetMemoryStats(memory_pool<T> *Pool)
+{
+    memory_stats Result = {};
+
+    Result.Used = Pool->UsedItemCount * sizeof(T);
+    Result.HighWater = Pool->HighWaterItemCount * sizeof(T);
+    Result.Committed = Pool->MaxItemCount * sizeof(T);
+    Result.Size = Pool->MaxItemCount * sizeof(T);
+    Result.AllocationCount = Pool->UsedItemCount;
+
+    return Result;
+}
+
+inline u32
+FindLeastSignificantSetBit(u32 Value)
+{
+    Assert(Value);
+
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanForward(&Result, Value);
+#else
+    u32 Result = __builtin_ctz(Value);
+#endif
+
+    return Result;
+}
+
+inline u32
+FindMostSignificantSetBit(u64 Value)
+{
+    Assert(Value);
+
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanReverse64(&Result, Value);
+#else
+    u32 Result = 63 - __builtin_clzll(Value);
+#endif
+
+    return Result;
+}
+
+// Every power of two size class is split into 16 linear second-level classes
+#define TLSF_SL_INDEX_COUNT_LOG2 4
+#define TLSF_SL_INDEX_COUNT (1 << TLSF_SL_INDEX_COUNT_LOG2)
+#define TLSF_ALIGNMENT 16
+// Blocks below 256 bytes are in the first class, split linearly in 16 byte steps
+#define TLSF_FL_INDEX_SHIFT (TLSF_SL_INDEX_COUNT_LOG2 + 4)
+#define TLSF_SMALL_BLOCK_SIZE (1 << TLSF_FL_INDEX_SHIFT)
+// Blocks are smaller than 4 GB
+#define TLSF_FL_INDEX_MAX 32
+#define TLSF_FL_INDEX_COUNT (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+#define TLSF_BLOCK_FREE 0x1
+#define TLSF_BLOCK_HEADER_SIZE 16
+
+struct tlsf_block
+{
+    // 0 for the first block
+    tlsf_block *PrevPhysical;
+    // Size includes the header, the lowest bit is set for the free blocks
+    umm SizeAndFlags;
+
+    // Free blocks only, overlap the data of the used ones
+    tlsf_block *NextFree;
+    tlsf_block *PrevFree;
+};
+
+/*
+    Two-level segregated fit heap: allocations and frees of any size in O(1).
+    Free blocks are kept in lists by size class, the bitmaps tell which lists are not empty,
+    so the smallest class that fits is found with two bit scans. Freed blocks are merged with the free neighbours.
+    The last block of the memory is a used sentinel of zero size, so merging never runs past the end.
+*/
+struct tlsf_heap
+{
+    umm Size;
+    umm Used;
+    void *Base;
+
+    u32 FLBitmap;
+    u32 SLBitmaps[TLSF_FL_INDEX_COUNT];
+    tlsf_block *FreeLists[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+
+    umm HighWater;
+    u32 AllocationCount;
+};
+
+inline umm
+GetTLSFBlockSize(tlsf_block *Block)
+{
+    umm Result = Block->SizeAndFlags & ~(umm)TLSF_BLOCK_FREE;
+    return Result;
+}
+
+inline bool32
+IsTLSFBlockFree(tlsf_block *Block)
+{
+    bool32 Result = (Block->SizeAndFlags & TLSF_BLOCK_FREE) != 0;
+    return Result;
+}
+
+inline tlsf_block *
+GetNextPhysicalTLSFBlock(tlsf_block *Block)
+{
+    tlsf_block *Result = (tlsf_block *)((u8 *)Block + GetTLSFBlockSize(Block));
+    return Result;
+}
+
+inline void
+MapTLSFBlockSize(umm Size, u32 *FirstLevelIndex, u32 *SecondLevelIndex)
+{
+    if (Size < TLSF_SMALL_BLOCK_SIZE)
+    {
+        *FirstLevelIndex = 0;
+        *SecondLevelIndex = (u32)(Size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT));
+    }
+    else
+    {
+        u32 MostSignificantBit = FindMostSignificantSetBit(Size);
+
+        *FirstLevelIndex = MostSignificantBit - (TLSF_FL_INDEX_SHIFT - 1);
+        *SecondLevelIndex = (u32)(Size >> (MostSignificantBit - TLSF_SL_INDEX_COUNT_LOG2)) ^ TLSF_SL_INDEX_COUNT;
+    }
+}
+
+dummy_internal void
+InsertFreeTLSFBlock(tlsf_heap *Heap, tlsf_block *Block)
+{
+    u32 FirstLevelIndex;
+    u32 SecondLevelIndex;
+    MapTLSFBlockSize(GetTLSFBlockSize(Block), &FirstLevelIndex, &SecondLevelIndex);
+
+    tlsf_block *Head = Heap->FreeLists[FirstLevelIndex][SecondLevelIndex];
+
+    Block->SizeAndFlags |= TLSF_BLOCK_FREE;
+    Block->NextFree = Head;
+    Block->PrevFree = 0;
+
+    if (Head)
+    {
+        Head->PrevFree = Block;
+    }
+
+    Heap->FreeLists[FirstLevelIndex][SecondLevelIndex] = Block;
+    Heap->FLBitmap |= (1u << FirstLevelIndex);
+    Heap->SLBitmaps[FirstLevelIndex] |= (1u << SecondLevelIndex);
+}
+
+dummy_internal void
+RemoveFreeTLSFBlock(tlsf_heap *Heap, tlsf_block *Block)
+{
+    Assert(IsTLSFBlockFree(Block));
+
+    u32 FirstLevelIndex;
+    u32 SecondLevelIndex;
+    MapTLSFBlockSize(GetTLSFBlockSize(Block), &FirstLevelIndex, &SecondLevelIndex);
+
+    if (Block->NextFree)
+    {
+        Block->NextFree->PrevFree = Block->PrevFree;
+    }
+
+    if (Block->PrevFree)
+    {
+        Block->PrevFree->NextFree = Block->NextFree;
+    }
+    else
+    {
+        Heap->FreeLists[FirstLevelIndex][SecondLevelIndex] = Block->NextFree;
+
+        if (!Block->NextFree)
+        {
+            Heap->SLBitmaps[FirstLevelIndex] &= ~(1u << SecondLevelIndex);
+
+            if (!Heap->SLBitmaps[FirstLevelIndex])
+            {
+                Heap->FLBitmap &= ~(1u << FirstLevelIndex);
+            }
+        }
+    }
+
+    Block->SizeAndFlags &= ~(umm)TLSF_BLOCK_FREE;
+}
+
+// All allocations are gone
+inline void
+InitTLSFHeap(tlsf_heap *Heap, void *Memory, umm Size)
+{
+    Assert(AlignAddress((umm)Memory, TLSF_ALIGNMENT) == (umm)Memory);
+
+    *Heap = {};
+
+    Heap->Base = Memory;
+    Heap->Size = Size;
+
+    umm BlockSize = (Size - TLSF_BLOCK_HEADER_SIZE) & ~(umm)(TLSF_ALIGNMENT - 1);
+
+    Assert(BlockSize >= sizeof(tlsf_block));
+    Assert(FindMostSignificantSetBit(BlockSize) < TLSF_FL_INDEX_MAX);
+
+    tlsf_block *Block = (tlsf_block *)Memory;
+    Block->PrevPhysical = 0;
+    Block->SizeAndFlags = BlockSize;
+
+    tlsf_block *Sentinel = GetNextPhysicalTLSFBlock(Block);
+    Sentinel->PrevPhysical = Block;
+    Sentinel->SizeAndFlags = 0;
+
+    InsertFreeTLSFBlock(Heap, Block);
+}
+
+// Memory is aligned to 16 bytes and not cleared, returns 0 if there is no free block large enough
+dummy_internal void *
+HeapAllocate(tlsf_heap *Heap, umm Size)
+{
+    void *Result = 0;
+
+    umm BlockSize = AlignAddress(Size + TLSF_BLOCK_HEADER_SIZE, TLSF_ALIGNMENT);
+
+    if (BlockSize < sizeof(tlsf_block))
+    {
+        BlockSize = sizeof(tlsf_block);
+    }
+
+    // Rounded up to the next size class, so that any block of the class fits
+    umm SearchSize = BlockSize;
+
+    if (BlockSize >= TLSF_SMALL_BLOCK_SIZE)
+    {
+        SearchSize += ((umm)1 << (FindMostSignificantSetBit(BlockSize) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+
+    u32 FirstLevelIndex;
+    u32 SecondLevelIndex;
+    MapTLSFBlockSize(SearchSize, &FirstLevelIndex, &SecondLevelIndex);
+
+    tlsf_block *Block = 0;
+
+    if (FirstLevelIndex < TLSF_FL_INDEX_COUNT)
+    {
+        u32 SecondLevelBitmap = Heap->SLBitmaps[FirstLevelIndex] & (~0u << SecondLevelIndex);
+
+        if (!SecondLevelBitmap)
+        {
+            // Smallest non-empty class of the larger sizes
+            u32 FirstLevelBitmap = Heap->FLBitmap & (~0u << (FirstLevelIndex + 1));
+
+            if (FirstLevelBitmap)
+            {
+                FirstLevelIndex = FindLeastSignificantSetBit(FirstLevelBitmap);
+                SecondLevelBitmap = Heap->SLBitmaps[FirstLevelIndex];
+            }
+        }
+
+        if (SecondLevelBitmap)
+        {
+            SecondLevelIndex = FindLeastSignificantSetBit(SecondLevelBitmap);
+            Block = Heap->FreeLists[FirstLevelIndex][SecondLevelIndex];
+        }
+    }
+
+    if (Block)
+    {
+        RemoveFreeTLSFBlock(Heap, Block);
+
+        umm RemainingSize = GetTLSFBlockSize(Block) - BlockSize;
+
+        if (RemainingSize >= sizeof(tlsf_block))
+        {
+            tlsf_block *RemainingBlock = (tlsf_block *)((u8 *)Block + BlockSize);
+            RemainingBlock->PrevPhysical = Block;
+            RemainingBlock->SizeAndFlags = RemainingSize;
+
+            GetNextPhysicalTLSFBlock(RemainingBlock)->PrevPhysical = RemainingBlock;
+
+            Block->SizeAndFlags = BlockSize;
+
+            InsertFreeTLSFBlock(Heap, RemainingBlock);
+        }
+
+        Heap->Used += GetTLSFBlockSize(Block);
+        ++Heap->AllocationCount;
+
+        if (Heap->Used > Heap->HighWater)
+        {
+            Heap->HighWater = Heap->Used;
+        }
+
+        Result = (u8 *)Block + TLSF_BLOCK_HEADER_SIZE;
+    }
+
+    return Result;
+}
+
+dummy_internal void
+HeapFree(tlsf_heap *Heap, void *Memory)
+{
+    tlsf_block *Block = (tlsf_block *)((u8 *)Memory - TLSF_BLOCK_HEADER_SIZE);
+
+    Assert(!IsTLSFBlockFree(Block));
+    Assert(Heap->Used >= GetTLSFBlockSize(Block));
+
+    Heap->Used -= GetTLSFBlockSize(Block);
+    --Heap->AllocationCount;
+
+    tlsf_block *Prev = Block->PrevPhysical;
+
+    if (Prev && IsTLSFBlockFree(Prev))
+    {
+        RemoveFreeTLSFBlock(Heap, Prev);
+
+        Prev->SizeAndFlags += GetTLSFBlockSize(Block);
+        Block = Prev;
+
+        GetNextPhysicalTLSFBlock(Block)->PrevPhysical = Block;
+    }
+
+    tlsf_block *Next = GetNextPhysicalTLSFBlock(Block);
+
+    if (IsTLSFBlockFree(Next))
+    {
+        RemoveFreeTLSFBlock(Heap, Next);
+
+        Block->SizeAndFlags += GetTLSFBlockSize(Next);
+
+        GetNextPhysicalTLSFBlock(Block)->PrevPhysical = Block;
+    }
+
+    InsertFreeTLSFBlock(Heap, Block);
+}
+
+inline memory_stats
+GetMemoryStats(tlsf_heap *Heap)
+{
+    memory_stats Result = {};
+
+    Result.Used = Heap->Used;
+    Result.HighWater = Heap->HighWater;
+    Result.Committed = Heap->Size;
+    Result.Size = Heap->Size;
+    Result.AllocationCount = Heap->AllocationCount;
+
+    return Result;
+}
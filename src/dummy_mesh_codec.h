@@ -0,0 +1,380 @@
+#pragma once
+
+#include <emmintrin.h>
+
+// Bump when the encoded layout changes, assets with another version have to be rebuilt
+#define MESH_STREAM_CODEC_VERSION 1
+
+#define MESH_STREAM_GROUP_SIZE 16
+#define MAX_MESH_STREAM_STRIDE 16
+
+/*
+    Vertex streams are encoded in groups of 16 vertices, every byte of the vertex (lane) separately:
+    the byte is stored as a zigzagged delta from the same byte of the previous vertex,
+    so the streams reordered for vertex fetch turn into runs of small values.
+
+    Group layout:
+    [mode of every lane, 2 bits each, Stride / 4 bytes]
+    [16 deltas of every lane, packed with 0, 2, 4 or 8 bits per delta depending on the mode]
+
+    2 bits: byte j holds the deltas j, j + 4, j + 8 and j + 12 (from the low bits)
+    4 bits: byte j holds the deltas j (low nibble) and j + 8 (high nibble)
+*/
+enum mesh_stream_lane_mode
+{
+    MeshStreamLaneMode_Zero,
+    MeshStreamLaneMode_2Bits,
+    MeshStreamLaneMode_4Bits,
+    MeshStreamLaneMode_8Bits
+};
+
+inline u32
+GetMeshStreamGroupCount(u32 VertexCount)
+{
+    u32 Result = (VertexCount + MESH_STREAM_GROUP_SIZE - 1) / MESH_STREAM_GROUP_SIZE;
+    return Result;
+}
+
+inline umm
+GetVertexStreamEncodeBound(u32 VertexCount, u32 Stride)
+{
+    umm Result = (umm)GetMeshStreamGroupCount(VertexCount) * (Stride / 4 + Stride * MESH_STREAM_GROUP_SIZE);
+    return Result;
+}
+
+inline umm
+GetIndexBufferEncodeBound(u32 IndexCount)
+{
+    // Varint of a 32-bit value takes at most 5 bytes
+    umm Result = (umm)IndexCount * 5;
+    return Result;
+}
+
+inline u8
+ZigZagEncode(u8 Value)
+{
+    u8 Result = (u8)((Value << 1) ^ (u8)((i8)Value >> 7));
+    return Result;
+}
+
+inline u32
+ZigZagEncode(i32 Value)
+{
+    u32 Result = ((u32)Value << 1) ^ (u32)(Value >> 31);
+    return Result;
+}
+
+inline i32
+ZigZagDecode(u32 Value)
+{
+    i32 Result = (i32)(Value >> 1) ^ -(i32)(Value & 1);
+    return Result;
+}
+
+// Returns the encoded size, Dest has to hold GetVertexStreamEncodeBound bytes
+dummy_internal umm
+EncodeVertexStream(u8 *Dest, void *Vertices, u32 VertexCount, u32 Stride)
+{
+    Assert(Stride % 4 == 0 && Stride <= MAX_MESH_STREAM_STRIDE);
+
+    u8 *Bytes = (u8 *)Vertices;
+    u8 *At = Dest;
+
+    u8 Previous[MAX_MESH_STREAM_STRIDE] = {};
+
+    for (u32 GroupIndex = 0; GroupIndex < GetMeshStreamGroupCount(VertexCount); ++GroupIndex)
+    {
+        u32 BaseIndex = GroupIndex * MESH_STREAM_GROUP_SIZE;
+
+        u8 *Modes = At;
+        ClearMemory(Modes, Stride / 4);
+        At += Stride / 4;
+
+        for (u32 Lane = 0; Lane < Stride; ++Lane)
+        {
+            u8 Deltas[MESH_STREAM_GROUP_SIZE];
+            u8 MaxDelta = 0;
+
+            for (u32 Index = 0; Index < MESH_STREAM_GROUP_SIZE; ++Index)
+            {
+                u32 VertexIndex = BaseIndex + Index;
+
+                // Last group is padded with the last vertex, so the padding costs nothing
+                u8 Value = VertexIndex < VertexCount ? Bytes[VertexIndex * Stride + Lane] : Previous[Lane];
+
+                Deltas[Index] = ZigZagEncode((u8)(Value - Previous[Lane]));
+                MaxDelta = Deltas[Index] > MaxDelta ? Deltas[Index] : MaxDelta;
+
+                Previous[Lane] = Value;
+            }
+
+            mesh_stream_lane_mode Mode = MeshStreamLaneMode_8Bits;
+
+            if (MaxDelta == 0)
+            {
+                Mode = MeshStreamLaneMode_Zero;
+            }
+            else if (MaxDelta < 4)
+            {
+                Mode = MeshStreamLaneMode_2Bits;
+            }
+            else if (MaxDelta < 16)
+            {
+                Mode = MeshStreamLaneMode_4Bits;
+            }
+
+            Modes[Lane / 4] |= (u8)(Mode << ((Lane % 4) * 2));
+
+            switch (Mode)
+            {
+                case MeshStreamLaneMode_Zero:
+                {
+                    // Nothing is stored
+                    break;
+                }
+                case MeshStreamLaneMode_2Bits:
+                {
+                    for (u32 Index = 0; Index < 4; ++Index)
+                    {
+                        At[Index] = (u8)(Deltas[Index] | (Deltas[Index + 4] << 2) | (Deltas[Index + 8] << 4) | (Deltas[Index + 12] << 6));
+                    }
+
+                    At += 4;
+                    break;
+                }
+                case MeshStreamLaneMode_4Bits:
+                {
+                    for (u32 Index = 0; Index < 8; ++Index)
+                    {
+                        At[Index] = (u8)(Deltas[Index] | (Deltas[Index + 8] << 4));
+                    }
+
+                    At += 8;
+                    break;
+                }
+                case MeshStreamLaneMode_8Bits:
+                {
+                    CopyMemory(Deltas, At, MESH_STREAM_GROUP_SIZE);
+
+                    At += MESH_STREAM_GROUP_SIZE;
+                    break;
+                }
+            }
+        }
+    }
+
+    umm Result = At - Dest;
+
+    return Result;
+}
+
+// Indices are stored as zigzagged varints of the delta from the previous index
+dummy_internal umm
+EncodeIndexBuffer(u8 *Dest, u32 *Indices, u32 IndexCount)
+{
+    u8 *At = Dest;
+    u32 Previous = 0;
+
+    for (u32 Index = 0; Index < IndexCount; ++Index)
+    {
+        u32 Value = ZigZagEncode((i32)(Indices[Index] - Previous));
+        Previous = Indices[Index];
+
+        while (Value >= 0x80)
+        {
+            *At++ = (u8)(Value | 0x80);
+            Value >>= 7;
+        }
+
+        *At++ = (u8)Value;
+    }
+
+    umm Result = At - Dest;
+
+    return Result;
+}
+
+// Unpacks the 16 deltas of a lane, returns the number of bytes read
+inline umm
+DecodeMeshStreamLane(u8 *Source, mesh_stream_lane_mode Mode, __m128i *Deltas)
+{
+    umm Result = 0;
+
+    switch (Mode)
+    {
+        case MeshStreamLaneMode_Zero:
+        {
+            *Deltas = _mm_setzero_si128();
+            break;
+        }
+        case MeshStreamLaneMode_2Bits:
+        {
+            // Source is not aligned
+            i32 PackedBits;
+            CopyMemory(Source, &PackedBits, sizeof(PackedBits));
+
+            __m128i Packed = _mm_cvtsi32_si128(PackedBits);
+
+            __m128i Low = _mm_unpacklo_epi32(Packed, _mm_srli_epi16(Packed, 2));
+            __m128i High = _mm_unpacklo_epi32(_mm_srli_epi16(Packed, 4), _mm_srli_epi16(Packed, 6));
+
+            *Deltas = _mm_and_si128(_mm_unpacklo_epi64(Low, High), _mm_set1_epi8(0x03));
+            Result = 4;
+            break;
+        }
+        case MeshStreamLaneMode_4Bits:
+        {
+            __m128i Packed = _mm_loadl_epi64((__m128i *)Source);
+
+            *Deltas = _mm_and_si128(_mm_unpacklo_epi64(Packed, _mm_srli_epi16(Packed, 4)), _mm_set1_epi8(0x0F));
+            Result = 8;
+            break;
+        }
+        case MeshStreamLaneMode_8Bits:
+        {
+            *Deltas = _mm_loadu_si128((__m128i *)Source);
+            Result = MESH_STREAM_GROUP_SIZE;
+            break;
+        }
+    }
+
+    return Result;
+}
+
+/*
+    Decodes VertexCount vertices into Dest (VertexCount * Stride bytes), returns the number of bytes read.
+    Deltas of a lane are unzigzagged and prefix summed 16 at a time, lanes are interleaved back 4 at a time.
+*/
+dummy_internal umm
+DecodeVertexStream(void *Dest, u32 VertexCount, u32 Stride, u8 *Source)
+{
+    Assert(Stride % 4 == 0 && Stride <= MAX_MESH_STREAM_STRIDE);
+
+    u8 *Bytes = (u8 *)Dest;
+    u8 *At = Source;
+
+    __m128i Zero = _mm_setzero_si128();
+    __m128i LowBit = _mm_set1_epi8(0x01);
+    __m128i LowBits = _mm_set1_epi8(0x7F);
+
+    // Every byte holds the last decoded value of the lane
+    __m128i Previous[MAX_MESH_STREAM_STRIDE];
+
+    for (u32 Lane = 0; Lane < Stride; ++Lane)
+    {
+        Previous[Lane] = Zero;
+    }
+
+    for (u32 GroupIndex = 0; GroupIndex < GetMeshStreamGroupCount(VertexCount); ++GroupIndex)
+    {
+        u32 BaseIndex = GroupIndex * MESH_STREAM_GROUP_SIZE;
+        u32 GroupVertexCount = VertexCount - BaseIndex < MESH_STREAM_GROUP_SIZE ? VertexCount - BaseIndex : MESH_STREAM_GROUP_SIZE;
+
+        u8 *Modes = At;
+        At += Stride / 4;
+
+        __m128i Lanes[MAX_MESH_STREAM_STRIDE];
+
+        for (u32 Lane = 0; Lane < Stride; ++Lane)
+        {
+            mesh_stream_lane_mode Mode = (mesh_stream_lane_mode)((Modes[Lane / 4] >> ((Lane % 4) * 2)) & 0x3);
+
+            __m128i Deltas;
+            At += DecodeMeshStreamLane(At, Mode, &Deltas);
+
+            // (Delta >> 1) ^ -(Delta & 1)
+            Deltas = _mm_xor_si128(
+                _mm_and_si128(_mm_srli_epi16(Deltas, 1), LowBits),
+                _mm_sub_epi8(Zero, _mm_and_si128(Deltas, LowBit))
+            );
+
+            // Prefix sum
+            Deltas = _mm_add_epi8(Deltas, _mm_slli_si128(Deltas, 1));
+            Deltas = _mm_add_epi8(Deltas, _mm_slli_si128(Deltas, 2));
+            Deltas = _mm_add_epi8(Deltas, _mm_slli_si128(Deltas, 4));
+            Deltas = _mm_add_epi8(Deltas, _mm_slli_si128(Deltas, 8));
+
+            __m128i Values = _mm_add_epi8(Deltas, Previous[Lane]);
+
+            // Broadcast the last byte
+            __m128i Last = _mm_unpackhi_epi8(Values, Values);
+            Last = _mm_unpackhi_epi16(Last, Last);
+            Previous[Lane] = _mm_shuffle_epi32(Last, 0xFF);
+
+            Lanes[Lane] = Values;
+        }
+
+        for (u32 Word = 0; Word < Stride / 4; ++Word)
+        {
+            __m128i *WordLanes = Lanes + Word * 4;
+
+            __m128i Lanes01Low = _mm_unpacklo_epi8(WordLanes[0], WordLanes[1]);
+            __m128i Lanes01High = _mm_unpackhi_epi8(WordLanes[0], WordLanes[1]);
+            __m128i Lanes23Low = _mm_unpacklo_epi8(WordLanes[2], WordLanes[3]);
+            __m128i Lanes23High = _mm_unpackhi_epi8(WordLanes[2], WordLanes[3]);
+
+            // 4 vertices per register
+            __m128i Words[4];
+            Words[0] = _mm_unpacklo_epi16(Lanes01Low, Lanes23Low);
+            Words[1] = _mm_unpackhi_epi16(Lanes01Low, Lanes23Low);
+            Words[2] = _mm_unpacklo_epi16(Lanes01High, Lanes23High);
+            Words[3] = _mm_unpackhi_epi16(Lanes01High, Lanes23High);
+
+            if (Stride == 4 && GroupVertexCount == MESH_STREAM_GROUP_SIZE)
+            {
+                __m128i *Out = (__m128i *)(Bytes + BaseIndex * Stride);
+
+                _mm_storeu_si128(Out + 0, Words[0]);
+                _mm_storeu_si128(Out + 1, Words[1]);
+                _mm_storeu_si128(Out + 2, Words[2]);
+                _mm_storeu_si128(Out + 3, Words[3]);
+            }
+            else
+            {
+                u32 Values[MESH_STREAM_GROUP_SIZE];
+                _mm_storeu_si128((__m128i *)Values + 0, Words[0]);
+                _mm_storeu_si128((__m128i *)Values + 1, Words[1]);
+                _mm_storeu_si128((__m128i *)Values + 2, Words[2]);
+                _mm_storeu_si128((__m128i *)Values + 3, Words[3]);
+
+                for (u32 Index = 0; Index < GroupVertexCount; ++Index)
+                {
+                    *(u32 *)(Bytes + (BaseIndex + Index) * Stride + Word * 4) = Values[Index];
+                }
+            }
+        }
+    }
+
+    umm Result = At - Source;
+
+    return Result;
+}
+
+// Returns the number of bytes read
+dummy_internal umm
+DecodeIndexBuffer(u32 *Indices, u32 IndexCount, u8 *Source)
+{
+    u8 *At = Source;
+    u32 Previous = 0;
+
+    for (u32 Index = 0; Index < IndexCount; ++Index)
+    {
+        u32 Value = 0;
+        u32 Shift = 0;
+
+        while (*At & 0x80)
+        {
+            Value |= (u32)(*At++ & 0x7F) << Shift;
+            Shift += 7;
+        }
+
+        Value |= (u32)(*At++) << Shift;
+
+        Previous += (u32)ZigZagDecode(Value);
+        Indices[Index] = Previous;
+    }
+
+    umm Result = At - Source;
+
+    return Result;
+}
@@ -0,0 +1,529 @@
+#include "dummy.h"
+
+/*
+    Inputs are generated from a fixed seed, so the numbers are comparable across the commits.
+    Distributions follow what the engine sees in a frame: most of the pairs from the broad phase don't touch,
+    rays start around the camera height and the boxes come in all orientations.
+*/
+
+#define MICRO_BENCHMARK_SEED 1234
+
+inline vec3
+RandomMicroBenchmarkVector(random_sequence *Entropy, f32 Min, f32 Max)
+{
+    vec3 Result = vec3(RandomBetween(Entropy, Min, Max), RandomBetween(Entropy, Min, Max), RandomBetween(Entropy, Min, Max));
+    return Result;
+}
+
+inline quat
+RandomMicroBenchmarkRotation(random_sequence *Entropy)
+{
+    quat Result = EulerToQuat(RandomBetween(Entropy, 0.f, 2.f * PI), RandomBetween(Entropy, 0.f, 2.f * PI), RandomBetween(Entropy, 0.f, 2.f * PI));
+    return Result;
+}
+
+inline transform
+RandomMicroBenchmarkTransform(random_sequence *Entropy, f32 PositionRange)
+{
+    transform Result = CreateTransform(
+        RandomMicroBenchmarkVector(Entropy, -PositionRange, PositionRange),
+        RandomMicroBenchmarkVector(Entropy, 0.5f, 2.f),
+        RandomMicroBenchmarkRotation(Entropy)
+    );
+    return Result;
+}
+
+// Boxes close enough to each other for about half of the pairs to overlap
+dummy_internal collider_box *
+GenerateMicroBenchmarkBoxes(random_sequence *Entropy, u32 Count, memory_arena *Arena)
+{
+    collider_box *Result = PushArray(Arena, Count, collider_box);
+
+    for (u32 BoxIndex = 0; BoxIndex < Count; ++BoxIndex)
+    {
+        collider_box *Box = Result + BoxIndex;
+
+        transform BoxTransform = CreateTransform(RandomMicroBenchmarkVector(Entropy, -1.5f, 1.5f), vec3(1.f), RandomMicroBenchmarkRotation(Entropy));
+
+        Box->HalfSize = RandomMicroBenchmarkVector(Entropy, 0.25f, 1.f);
+        Box->Offset = mat4(1.f);
+        Box->Transform = Transform(BoxTransform);
+        Box->Body = 0;
+    }
+
+    return Result;
+}
+
+// Broad phase candidates: a few overlap, most are close but apart
+dummy_internal aabb *
+GenerateMicroBenchmarkAABBs(random_sequence *Entropy, u32 Count, memory_arena *Arena)
+{
+    aabb *Result = PushArray(Arena, Count, aabb);
+
+    for (u32 BoxIndex = 0; BoxIndex < Count; ++BoxIndex)
+    {
+        Result[BoxIndex] = CreateAABBCenterHalfExtent(RandomMicroBenchmarkVector(Entropy, -8.f, 8.f), RandomMicroBenchmarkVector(Entropy, 0.25f, 2.f));
+    }
+
+    return Result;
+}
+
+struct micro_benchmark_entry
+{
+    char Key[32];
+    u32 Value;
+};
+
+dummy_internal void
+RunCollisionMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED);
+
+    u32 PairCount = 4096;
+
+    aabb *AABBs = GenerateMicroBenchmarkAABBs(&Entropy, PairCount + 1, Arena);
+    collider_box *Boxes = GenerateMicroBenchmarkBoxes(&Entropy, PairCount + 1, Arena);
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "TestAABBAABB", PairCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 HitCount = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+        {
+            HitCount += TestAABBAABB(AABBs[PairIndex], AABBs[PairIndex + 1]) ? 1 : 0;
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = HitCount;
+    }
+
+    ray *Rays = PushArray(Arena, PairCount, ray);
+
+    for (u32 RayIndex = 0; RayIndex < PairCount; ++RayIndex)
+    {
+        Rays[RayIndex].Origin = vec3(RandomBetween(&Entropy, -16.f, 16.f), RandomBetween(&Entropy, 1.f, 4.f), RandomBetween(&Entropy, -16.f, 16.f));
+        Rays[RayIndex].Direction = Normalize(RandomMicroBenchmarkVector(&Entropy, -1.f, 1.f) + vec3(0.f, 0.f, 0.001f));
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "IntersectRayAABB", PairCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 HitCount = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 RayIndex = 0; RayIndex < PairCount; ++RayIndex)
+        {
+            vec3 IntersectionPoint;
+            HitCount += IntersectRayAABB(Rays[RayIndex], AABBs[RayIndex], IntersectionPoint) ? 1 : 0;
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = HitCount;
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "TestBoxBox", PairCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 HitCount = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+        {
+            HitCount += TestBoxBox(Boxes + PairIndex, Boxes + PairIndex + 1) ? 1 : 0;
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = HitCount;
+    }
+
+    contact_params ContactParams = {};
+    ContactParams.Friction = 0.6f;
+    ContactParams.Restitution = 0.1f;
+
+    contact Contacts[16];
+
+    Benchmark = BeginMicroBenchmark(Suite, "CalculateBoxBoxContacts", PairCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 ContactCount = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+        {
+            ContactCount += CalculateBoxBoxContacts(Boxes + PairIndex, Boxes + PairIndex + 1, Contacts, ContactParams);
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = ContactCount;
+    }
+}
+
+dummy_internal void
+RunGeometryMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED + 1);
+
+    // Frustums of the cameras looking around, clipped by the ground the same way the shadow region is
+    u32 FrustumCount = 256;
+    polyhedron *Frustums = PushArray(Arena, FrustumCount, polyhedron);
+
+    for (u32 FrustumIndex = 0; FrustumIndex < FrustumCount; ++FrustumIndex)
+    {
+        game_camera Camera = {};
+        vec3 Position = vec3(RandomBetween(&Entropy, -32.f, 32.f), RandomBetween(&Entropy, 1.f, 16.f), RandomBetween(&Entropy, -32.f, 32.f));
+        vec3 SphericalCoords = vec3(1.f, RandomBetween(&Entropy, 0.f, 2.f * PI), RADIANS(RandomBetween(&Entropy, -60.f, 30.f)));
+
+        InitCamera(&Camera, RADIANS(45.f), 16.f / 9.f, 0.1f, 320.f, Position, SphericalCoords);
+        BuildFrustrumPolyhedron(&Camera, Frustums + FrustumIndex);
+    }
+
+    plane Ground = ComputePlane(vec3(-1.f, 0.f, 0.f), vec3(0.f, 0.f, 1.f), vec3(1.f, 0.f, 0.f));
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "ClipPolyhedron", FrustumCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 VertexCount = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 FrustumIndex = 0; FrustumIndex < FrustumCount; ++FrustumIndex)
+        {
+            polyhedron Clipped;
+
+            if (ClipPolyhedron(Frustums + FrustumIndex, Ground, &Clipped))
+            {
+                VertexCount += Clipped.VertexCount;
+            }
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = VertexCount;
+    }
+
+    // Vertices of a rotated and stretched box, about the size of a mesh LOD
+    u32 VertexCount = 2048;
+    vec3 *Vertices = PushArray(Arena, VertexCount, vec3);
+
+    mat4 MeshTransform = Transform(RandomMicroBenchmarkTransform(&Entropy, 4.f));
+
+    for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+    {
+        vec3 Vertex = RandomMicroBenchmarkVector(&Entropy, -1.f, 1.f) * vec3(2.f, 0.5f, 1.f);
+        Vertices[VertexIndex] = vec4(MeshTransform * vec4(Vertex, 1.f)).xyz;
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "CalculateOrientedBoundingBox", VertexCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        obb Bounds = CalculateOrientedBoundingBox(VertexCount, Vertices);
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Bounds.HalfExtent.x;
+    }
+}
+
+dummy_internal void
+RunContainerMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED + 2);
+
+    // Same load as the asset tables, names look like the asset names
+    u32 KeyCount = 128;
+    char (*Keys)[32] = (char (*)[32]) PushSize(Arena, KeyCount * 32);
+
+    for (u32 KeyIndex = 0; KeyIndex < KeyCount; ++KeyIndex)
+    {
+        FormatString_(Keys[KeyIndex], 32, "asset_%u_%u", KeyIndex, RandomNextU32(&Entropy) % 10000);
+    }
+
+    hash_table<micro_benchmark_entry> Table = {};
+    InitHashTable(&Table, 1031, Arena);
+
+    for (u32 KeyIndex = 0; KeyIndex < KeyCount; ++KeyIndex)
+    {
+        micro_benchmark_entry *Entry = HashTableLookup(&Table, Keys[KeyIndex]);
+        CopyString(Keys[KeyIndex], Entry->Key);
+        Entry->Value = KeyIndex;
+    }
+
+    u32 LookupCount = 4096;
+    u32 *LookupKeys = PushArray(Arena, LookupCount, u32);
+
+    for (u32 LookupIndex = 0; LookupIndex < LookupCount; ++LookupIndex)
+    {
+        LookupKeys[LookupIndex] = RandomChoice(&Entropy, KeyCount);
+    }
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "HashTableLookup", LookupCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u32 Sum = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 LookupIndex = 0; LookupIndex < LookupCount; ++LookupIndex)
+        {
+            Sum += HashTableLookup(&Table, Keys[LookupKeys[LookupIndex]])->Value;
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = Sum;
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "Hash(const char *)", LookupCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        u64 Sum = 0;
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 LookupIndex = 0; LookupIndex < LookupCount; ++LookupIndex)
+        {
+            Sum += Hash((const char *) Keys[LookupKeys[LookupIndex]]);
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Sum;
+    }
+
+    // Particles of a single emitter, they come in the spawn order
+    u32 ParticleCount = 4096;
+    particle *SourceParticles = PushArray(Arena, ParticleCount, particle);
+    particle *Particles = PushArray(Arena, ParticleCount, particle);
+
+    for (u32 ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
+    {
+        particle *Particle = SourceParticles + ParticleIndex;
+        Particle->Position = RandomMicroBenchmarkVector(&Entropy, -4.f, 4.f);
+        Particle->CameraDistanceSquared = RandomBetween(&Entropy, 1.f, 2500.f);
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "SortParticles", ParticleCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        CopyMemory(SourceParticles, Particles, ParticleCount * sizeof(particle));
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        SortParticles(ParticleCount, Particles);
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Particles[0].CameraDistanceSquared;
+    }
+}
+
+dummy_internal void
+RunMathMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED + 3);
+
+    // Joint count of a few skeletons, the same as the pose blending
+    u32 TransformCount = 1024;
+    transform *From = PushArray(Arena, TransformCount, transform);
+    transform *To = PushArray(Arena, TransformCount, transform);
+    transform *Blended = PushArray(Arena, TransformCount, transform);
+    mat4 *Matrices = PushArray(Arena, TransformCount, mat4);
+    mat4 *Products = PushArray(Arena, TransformCount, mat4);
+
+    for (u32 TransformIndex = 0; TransformIndex < TransformCount; ++TransformIndex)
+    {
+        From[TransformIndex] = RandomMicroBenchmarkTransform(&Entropy, 1.f);
+        To[TransformIndex] = RandomMicroBenchmarkTransform(&Entropy, 1.f);
+        Matrices[TransformIndex] = Transform(From[TransformIndex]);
+    }
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "Lerp(transform)", TransformCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 TransformIndex = 0; TransformIndex < TransformCount; ++TransformIndex)
+        {
+            Blended[TransformIndex] = Lerp(From[TransformIndex], 0.35f, To[TransformIndex]);
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Blended[TransformCount - 1].Translation.x;
+    }
+
+    // Parent to child chain, like the skinning matrices
+    Benchmark = BeginMicroBenchmark(Suite, "mat4 * mat4", TransformCount - 1);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 MatrixIndex = 1; MatrixIndex < TransformCount; ++MatrixIndex)
+        {
+            Products[MatrixIndex] = Matrices[MatrixIndex - 1] * Matrices[MatrixIndex];
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Products[TransformCount - 1][0][0];
+    }
+}
+
+// Instances in the range of the world areas, scales from tiny props to large buildings
+dummy_internal void
+RunMeshInstanceMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED + 4);
+
+    u32 InstanceCount = 4096;
+    transform *Transforms = PushArray(Arena, InstanceCount, transform);
+    vec3 *Colors = PushArray(Arena, InstanceCount, vec3);
+    mesh_instance *Instances = PushArray(Arena, InstanceCount, mesh_instance);
+    transform *Decoded = PushArray(Arena, InstanceCount, transform);
+
+    for (u32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+    {
+        transform *Transform = Transforms + InstanceIndex;
+
+        Transform->Translation = vec3(RandomBetween(&Entropy, -100.f, 100.f), RandomBetween(&Entropy, 0.f, 20.f), RandomBetween(&Entropy, -100.f, 100.f));
+        Transform->Rotation = RandomMicroBenchmarkRotation(&Entropy);
+        Transform->Scale = RandomMicroBenchmarkVector(&Entropy, 0.01f, 10.f);
+
+        Colors[InstanceIndex] = vec3(Random01(&Entropy), Random01(&Entropy), Random01(&Entropy));
+    }
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "EncodeMeshInstance", InstanceCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+        {
+            Instances[InstanceIndex] = EncodeMeshInstance(Transforms[InstanceIndex], Colors[InstanceIndex]);
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = Instances[InstanceCount - 1].Color;
+    }
+
+    // Checks need the encoded instances whether or not the benchmark ran
+    for (u32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+    {
+        Instances[InstanceIndex] = EncodeMeshInstance(Transforms[InstanceIndex], Colors[InstanceIndex]);
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "DecodeMeshInstance", InstanceCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        for (u32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+        {
+            Decoded[InstanceIndex] = DecodeMeshInstance(Instances + InstanceIndex);
+        }
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = (u32) Decoded[InstanceCount - 1].Translation.x;
+    }
+
+    // Positions are stored as is, rotations are snorm16 and scales are half-precision (11 significant bits)
+    micro_benchmark_check *PositionCheck = BeginMicroBenchmarkCheck(Suite, "MeshInstance:Position", 0.f);
+    micro_benchmark_check *RotationCheck = BeginMicroBenchmarkCheck(Suite, "MeshInstance:Rotation", 1e-5f);
+    micro_benchmark_check *ScaleCheck = BeginMicroBenchmarkCheck(Suite, "MeshInstance:RelativeScale", 1e-3f);
+    micro_benchmark_check *ColorCheck = BeginMicroBenchmarkCheck(Suite, "MeshInstance:Color", 1.f / 255.f);
+    // Error of a point on the unit sphere of the model, relative to the largest scale
+    micro_benchmark_check *VertexCheck = BeginMicroBenchmarkCheck(Suite, "MeshInstance:RelativeVertex", 2e-3f);
+
+    for (u32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+    {
+        transform Transform = Transforms[InstanceIndex];
+        vec3 Color = Colors[InstanceIndex];
+
+        vec3 DecodedColor;
+        transform DecodedTransform = DecodeMeshInstance(Instances + InstanceIndex, &DecodedColor);
+
+        RecordMicroBenchmarkCheckError(PositionCheck, Magnitude(DecodedTransform.Translation - Transform.Translation));
+
+        // Same rotation up to a sign
+        RecordMicroBenchmarkCheckError(RotationCheck, 1.f - Abs(Dot(DecodedTransform.Rotation, Normalize(Transform.Rotation))));
+
+        vec3 ScaleError = Abs(DecodedTransform.Scale - Transform.Scale) / Transform.Scale;
+        RecordMicroBenchmarkCheckError(ScaleCheck, Max(ScaleError.x, Max(ScaleError.y, ScaleError.z)));
+
+        RecordMicroBenchmarkCheckError(ColorCheck, Magnitude(DecodedColor - Color));
+
+        vec3 Point = vec3(0.577f);
+        vec3 Expected = Transform.Translation + Rotate(Transform.Scale * Point, Transform.Rotation);
+        vec3 Actual = DecodedTransform.Translation + Rotate(DecodedTransform.Scale * Point, DecodedTransform.Rotation);
+        f32 MaxScale = Max(Transform.Scale.x, Max(Transform.Scale.y, Transform.Scale.z));
+
+        RecordMicroBenchmarkCheckError(VertexCheck, Magnitude(Actual - Expected) / MaxScale);
+    }
+}
+
+// Lights in front of a camera at the origin looking down -z, about as dense as the light forest scenario
+dummy_internal void
+RunLightingMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    random_sequence Entropy = RandomSequence(MICRO_BENCHMARK_SEED + 5);
+
+    u32 LightCount = 512;
+    point_light_bounds *LightBounds = PushArray(Arena, LightCount, point_light_bounds);
+
+    for (u32 LightIndex = 0; LightIndex < LightCount; ++LightIndex)
+    {
+        point_light_bounds *Light = LightBounds + LightIndex;
+
+        Light->Position = vec3(RandomBetween(&Entropy, -40.f, 40.f), RandomBetween(&Entropy, -10.f, 10.f), RandomBetween(&Entropy, -100.f, -0.5f));
+        Light->Radius = RandomBetween(&Entropy, 1.f, 8.f);
+    }
+
+    // Same projection as the player camera
+    light_cluster_grid Grid = {};
+    Grid.Near = 0.1f;
+    Grid.Far = 320.f;
+    Grid.FocalLength = 1.f / Tan(RADIANS(45.f) * 0.5f);
+    Grid.AspectRatio = 16.f / 9.f;
+    Grid.Clusters = PushArray(Arena, LIGHT_CLUSTER_COUNT, light_cluster);
+
+    light_cluster_grid ReferenceGrid = Grid;
+    ReferenceGrid.Clusters = PushArray(Arena, LIGHT_CLUSTER_COUNT, light_cluster);
+
+    micro_benchmark *Benchmark = BeginMicroBenchmark(Suite, "BinPointLights", LightCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        scoped_memory ScopedMemory(Arena);
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        BinPointLights(&Grid, LightCount, LightBounds, ScopedMemory.Arena);
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = Grid.LightIndexCount;
+    }
+
+    Benchmark = BeginMicroBenchmark(Suite, "BinPointLightsReference", LightCount);
+    while (KeepMicroBenchmarkRunning(Suite, Benchmark))
+    {
+        scoped_memory ScopedMemory(Arena);
+
+        StartMicroBenchmarkRepetition(Suite, Benchmark);
+        BinPointLightsReference(&ReferenceGrid, LightCount, LightBounds, ScopedMemory.Arena);
+        StopMicroBenchmarkRepetition(Suite, Benchmark);
+
+        MicroBenchmarkSink = ReferenceGrid.LightIndexCount;
+    }
+
+    micro_benchmark_check *Check = BeginMicroBenchmarkCheck(Suite, "LightClusters:Mismatch", 0.f);
+
+    if (Check)
+    {
+        scoped_memory ScopedMemory(Arena);
+
+        BinPointLights(&Grid, LightCount, LightBounds, ScopedMemory.Arena);
+        BinPointLightsReference(&ReferenceGrid, LightCount, LightBounds, ScopedMemory.Arena);
+
+        RecordMicroBenchmarkCheckError(Check, LightClusterGridsEqual(&Grid, &ReferenceGrid) ? 0.f : 1.f);
+    }
+}
+
+// Inputs are pushed to the arena, so it has to be cleared by the caller
+dummy_internal void
+RunMicroBenchmarks(micro_benchmark_suite *Suite, memory_arena *Arena)
+{
+    RunCollisionMicroBenchmarks(Suite, Arena);
+    RunGeometryMicroBenchmarks(Suite, Arena);
+    RunContainerMicroBenchmarks(Suite, Arena);
+    RunMathMicroBenchmarks(Suite, Arena);
+    RunMeshInstanceMicroBenchmarks(Suite, Arena);
+    RunLightingMicroBenchmarks(Suite, Arena);
+
+    FinishMicroBenchmarks(Suite);
+}
@@ -0,0 +1,328 @@
+#include "dummy.h"
+
+dummy_internal void
+InitOcclusionBuffer(occlusion_buffer *Buffer, memory_arena *Arena)
+{
+    *Buffer = {};
+
+    for (u32 MipIndex = 0; MipIndex < OCCLUSION_BUFFER_MIP_COUNT; ++MipIndex)
+    {
+        u32 Width = OCCLUSION_BUFFER_WIDTH >> MipIndex;
+        u32 Height = OCCLUSION_BUFFER_HEIGHT >> MipIndex;
+
+        Buffer->Mips[MipIndex] = PushArray(Arena, Width * Height, f32, Align(16));
+    }
+}
+
+dummy_internal void
+BeginOcclusionFrame(occlusion_buffer *Buffer, game_camera *Camera, u32 MaxTriangleCount, memory_arena *Arena)
+{
+    Buffer->WorldToCamera = GetCameraTransform(Camera);
+    Buffer->FocalLength = Camera->FocalLength;
+    Buffer->AspectRatio = Camera->AspectRatio;
+    Buffer->NearClipPlane = Camera->NearClipPlane;
+
+    Buffer->TriangleCount = 0;
+    Buffer->MaxTriangleCount = MaxTriangleCount;
+    Buffer->Triangles = PushArray(Arena, MaxTriangleCount, occluder_triangle, NoClear());
+}
+
+// Returns screen-space position with reciprocal view depth, w is the view depth
+inline vec4
+ProjectToOcclusionBuffer(occlusion_buffer *Buffer, vec4 CameraSpacePosition)
+{
+    // Camera is looking down -z
+    f32 w = -CameraSpacePosition.z;
+    f32 InvW = 1.f / w;
+
+    f32 NdcX = CameraSpacePosition.x * Buffer->FocalLength / Buffer->AspectRatio * InvW;
+    f32 NdcY = CameraSpacePosition.y * Buffer->FocalLength * InvW;
+
+    // First row is at the top of the screen
+    vec4 Result;
+    Result.x = (NdcX * 0.5f + 0.5f) * OCCLUSION_BUFFER_WIDTH;
+    Result.y = (0.5f - NdcY * 0.5f) * OCCLUSION_BUFFER_HEIGHT;
+    Result.z = InvW;
+    Result.w = w;
+
+    return Result;
+}
+
+// Triangles crossing the near plane are dropped, which only makes the occluder smaller
+dummy_internal void
+AddOccluderMesh(occlusion_buffer *Buffer, mesh *Mesh, mesh_lod Lod, mat4 ModelToCamera)
+{
+    for (u32 Index = 0; Index < Lod.IndexCount; Index += 3)
+    {
+        u32 *Indices = Mesh->Indices + Lod.IndexOffset + Index;
+
+        vec4 Vertices[3];
+        bool32 InFrontOfNearPlane = true;
+
+        for (u32 VertexIndex = 0; VertexIndex < 3; ++VertexIndex)
+        {
+            vec4 CameraSpacePosition = ModelToCamera * vec4(GetMeshVertexPosition(Mesh, Indices[VertexIndex]), 1.f);
+
+            if (-CameraSpacePosition.z < Buffer->NearClipPlane)
+            {
+                InFrontOfNearPlane = false;
+                break;
+            }
+
+            Vertices[VertexIndex] = ProjectToOcclusionBuffer(Buffer, CameraSpacePosition);
+        }
+
+        if (InFrontOfNearPlane)
+        {
+            Assert(Buffer->TriangleCount < Buffer->MaxTriangleCount);
+
+            occluder_triangle *Triangle = Buffer->Triangles + Buffer->TriangleCount++;
+            Triangle->Vertices[0] = Vertices[0].xyz;
+            Triangle->Vertices[1] = Vertices[1].xyz;
+            Triangle->Vertices[2] = Vertices[2].xyz;
+        }
+    }
+}
+
+/*
+    Rasterizes all triangles into a single band of the buffer, 4 pixels at a time.
+    Triangles are two-sided, pixel centers exactly on the edge are not covered.
+*/
+dummy_internal void
+RasterizeOcclusionBand(occlusion_buffer *Buffer, u32 BandIndex)
+{
+    f32 *Depth = Buffer->Mips[0];
+
+    i32 BandMinY = BandIndex * OCCLUSION_BUFFER_BAND_HEIGHT;
+    i32 BandMaxY = BandMinY + OCCLUSION_BUFFER_BAND_HEIGHT - 1;
+
+    __m128 Zero = _mm_setzero_ps();
+
+    for (i32 y = BandMinY; y <= BandMaxY; ++y)
+    {
+        f32 *Row = Depth + y * OCCLUSION_BUFFER_WIDTH;
+
+        for (i32 x = 0; x < OCCLUSION_BUFFER_WIDTH; x += 4)
+        {
+            _mm_store_ps(Row + x, Zero);
+        }
+    }
+
+    __m128 PixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+    for (u32 TriangleIndex = 0; TriangleIndex < Buffer->TriangleCount; ++TriangleIndex)
+    {
+        occluder_triangle *Triangle = Buffer->Triangles + TriangleIndex;
+
+        vec3 v0 = Triangle->Vertices[0];
+        vec3 v1 = Triangle->Vertices[1];
+        vec3 v2 = Triangle->Vertices[2];
+
+        f32 Area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+        if (Abs(Area) < EPSILON)
+        {
+            continue;
+        }
+
+        if (Area < 0.f)
+        {
+            vec3 Temp = v1;
+            v1 = v2;
+            v2 = Temp;
+            Area = -Area;
+        }
+
+        i32 MinX = Max(Floor(Min(v0.x, Min(v1.x, v2.x))), 0);
+        i32 MaxX = Min(Ceil(Max(v0.x, Max(v1.x, v2.x))), OCCLUSION_BUFFER_WIDTH - 1);
+        i32 MinY = Max(Floor(Min(v0.y, Min(v1.y, v2.y))), BandMinY);
+        i32 MaxY = Min(Ceil(Max(v0.y, Max(v1.y, v2.y))), BandMaxY);
+
+        if (MinX > MaxX || MinY > MaxY)
+        {
+            continue;
+        }
+
+        // Edge functions: E(x, y) = A * x + B * y + C, positive inside of the triangle
+        f32 A0 = v1.y - v2.y, B0 = v2.x - v1.x, C0 = v1.x * v2.y - v1.y * v2.x;
+        f32 A1 = v2.y - v0.y, B1 = v0.x - v2.x, C1 = v2.x * v0.y - v2.y * v0.x;
+        f32 A2 = v0.y - v1.y, B2 = v1.x - v0.x, C2 = v0.x * v1.y - v0.y * v1.x;
+
+        // Depth plane: z = ZA * x + ZB * y + ZC
+        f32 InvArea = 1.f / Area;
+        f32 ZA = (A0 * v0.z + A1 * v1.z + A2 * v2.z) * InvArea;
+        f32 ZB = (B0 * v0.z + B1 * v1.z + B2 * v2.z) * InvArea;
+        f32 ZC = (C0 * v0.z + C1 * v1.z + C2 * v2.z) * InvArea;
+
+        __m128 EdgeA0 = _mm_set1_ps(A0);
+        __m128 EdgeA1 = _mm_set1_ps(A1);
+        __m128 EdgeA2 = _mm_set1_ps(A2);
+        __m128 DepthA = _mm_set1_ps(ZA);
+
+        // Rows are 16 byte aligned
+        i32 StartX = MinX & ~3;
+
+        for (i32 y = MinY; y <= MaxY; ++y)
+        {
+            f32 PixelY = (f32)y + 0.5f;
+            f32 *Row = Depth + y * OCCLUSION_BUFFER_WIDTH;
+
+            __m128 RowE0 = _mm_set1_ps(B0 * PixelY + C0);
+            __m128 RowE1 = _mm_set1_ps(B1 * PixelY + C1);
+            __m128 RowE2 = _mm_set1_ps(B2 * PixelY + C2);
+            __m128 RowDepth = _mm_set1_ps(ZB * PixelY + ZC);
+
+            for (i32 x = StartX; x <= MaxX; x += 4)
+            {
+                __m128 PixelX = _mm_add_ps(_mm_set1_ps((f32)x), PixelOffsets);
+
+                __m128 E0 = _mm_add_ps(_mm_mul_ps(EdgeA0, PixelX), RowE0);
+                __m128 E1 = _mm_add_ps(_mm_mul_ps(EdgeA1, PixelX), RowE1);
+                __m128 E2 = _mm_add_ps(_mm_mul_ps(EdgeA2, PixelX), RowE2);
+
+                __m128 Inside = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(E0, Zero), _mm_cmpgt_ps(E1, Zero)), _mm_cmpgt_ps(E2, Zero));
+
+                __m128 PixelDepth = _mm_add_ps(_mm_mul_ps(DepthA, PixelX), RowDepth);
+                __m128 PrevDepth = _mm_load_ps(Row + x);
+                __m128 ClosestDepth = _mm_max_ps(PrevDepth, PixelDepth);
+
+                _mm_store_ps(Row + x, _mm_or_ps(_mm_and_ps(Inside, ClosestDepth), _mm_andnot_ps(Inside, PrevDepth)));
+            }
+        }
+    }
+}
+
+dummy_internal void
+BuildOcclusionHierarchy(occlusion_buffer *Buffer)
+{
+    for (u32 MipIndex = 1; MipIndex < OCCLUSION_BUFFER_MIP_COUNT; ++MipIndex)
+    {
+        f32 *Source = Buffer->Mips[MipIndex - 1];
+        f32 *Dest = Buffer->Mips[MipIndex];
+
+        u32 SourceWidth = OCCLUSION_BUFFER_WIDTH >> (MipIndex - 1);
+        u32 Width = OCCLUSION_BUFFER_WIDTH >> MipIndex;
+        u32 Height = OCCLUSION_BUFFER_HEIGHT >> MipIndex;
+
+        for (u32 y = 0; y < Height; ++y)
+        {
+            f32 *Row0 = Source + (2 * y) * SourceWidth;
+            f32 *Row1 = Row0 + SourceWidth;
+
+            for (u32 x = 0; x < Width; ++x)
+            {
+                f32 Farthest = Min(Min(Row0[2 * x], Row0[2 * x + 1]), Min(Row1[2 * x], Row1[2 * x + 1]));
+                Dest[y * Width + x] = Farthest;
+            }
+        }
+    }
+}
+
+/*
+    Box is occluded when its closest point is farther than everything rasterized under its screen-space rectangle.
+    Mip is picked so that the rectangle covers at most 4x4 texels.
+*/
+dummy_internal bool32
+AxisAlignedBoxOccluded(occlusion_buffer *Buffer, aabb Box)
+{
+    f32 MinX = F32_MAX;
+    f32 MinY = F32_MAX;
+    f32 MaxX = -F32_MAX;
+    f32 MaxY = -F32_MAX;
+    f32 ClosestDepth = 0.f;
+
+    for (u32 CornerIndex = 0; CornerIndex < 8; ++CornerIndex)
+    {
+        vec3 Sign = vec3(
+            (CornerIndex & 1) ? 1.f : -1.f,
+            (CornerIndex & 2) ? 1.f : -1.f,
+            (CornerIndex & 4) ? 1.f : -1.f
+        );
+
+        vec3 Corner = Box.Center + Box.HalfExtent * Sign;
+        vec4 CameraSpacePosition = Buffer->WorldToCamera * vec4(Corner, 1.f);
+
+        // Box is crossing the near plane
+        if (-CameraSpacePosition.z < Buffer->NearClipPlane)
+        {
+            return false;
+        }
+
+        vec4 ScreenPosition = ProjectToOcclusionBuffer(Buffer, CameraSpacePosition);
+
+        MinX = Min(MinX, ScreenPosition.x);
+        MinY = Min(MinY, ScreenPosition.y);
+        MaxX = Max(MaxX, ScreenPosition.x);
+        MaxY = Max(MaxY, ScreenPosition.y);
+        ClosestDepth = Max(ClosestDepth, ScreenPosition.z);
+    }
+
+    i32 x0 = Max(Floor(MinX), 0);
+    i32 y0 = Max(Floor(MinY), 0);
+    i32 x1 = Min(Floor(MaxX), OCCLUSION_BUFFER_WIDTH - 1);
+    i32 y1 = Min(Floor(MaxY), OCCLUSION_BUFFER_HEIGHT - 1);
+
+    // Off-screen boxes are left to frustrum culling
+    if (x0 > x1 || y0 > y1)
+    {
+        return false;
+    }
+
+    u32 MipIndex = 0;
+
+    while (MipIndex < OCCLUSION_BUFFER_MIP_COUNT - 1 && Max((x1 >> MipIndex) - (x0 >> MipIndex), (y1 >> MipIndex) - (y0 >> MipIndex)) >= 4)
+    {
+        ++MipIndex;
+    }
+
+    f32 *Mip = Buffer->Mips[MipIndex];
+    u32 MipWidth = OCCLUSION_BUFFER_WIDTH >> MipIndex;
+
+    for (i32 y = y0 >> MipIndex; y <= (y1 >> MipIndex); ++y)
+    {
+        for (i32 x = x0 >> MipIndex; x <= (x1 >> MipIndex); ++x)
+        {
+            if (Mip[y * MipWidth + x] <= ClosestDepth)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Writes the most detailed mip as binary PGM, closer is brighter
+dummy_internal void
+DumpOcclusionBuffer(occlusion_buffer *Buffer, platform_api *Platform, char *FileName, memory_arena *Arena)
+{
+    scoped_memory ScopedMemory(Arena);
+
+    char Header[64];
+    FormatString(Header, "P5\n%d %d\n255\n", OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+
+    u32 HeaderSize = StringLength(Header);
+    u32 PixelCount = OCCLUSION_BUFFER_WIDTH * OCCLUSION_BUFFER_HEIGHT;
+    u32 BufferSize = HeaderSize + PixelCount;
+
+    u8 *Image = PushArray(ScopedMemory.Arena, BufferSize, u8, NoClear());
+    CopyMemory(Header, Image, HeaderSize);
+
+    f32 *Depth = Buffer->Mips[0];
+    f32 MaxDepth = 0.f;
+
+    for (u32 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
+    {
+        MaxDepth = Max(MaxDepth, Depth[PixelIndex]);
+    }
+
+    u8 *Pixels = Image + HeaderSize;
+
+    for (u32 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
+    {
+        f32 Value = MaxDepth > 0.f ? Depth[PixelIndex] / MaxDepth : 0.f;
+        Pixels[PixelIndex] = (u8)(Value * 255.f);
+    }
+
+    Platform->WriteFile(FileName, Image, BufferSize);
+}
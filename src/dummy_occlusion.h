@@ -0,0 +1,43 @@
+#pragma once
+
+#include <xmmintrin.h>
+
+#define OCCLUSION_BUFFER_WIDTH 256
+#define OCCLUSION_BUFFER_HEIGHT 128
+// 256x128 down to 2x1
+#define OCCLUSION_BUFFER_MIP_COUNT 8
+
+// Horizontal bands of the buffer are rasterized in parallel
+#define OCCLUSION_BUFFER_BAND_COUNT 8
+#define OCCLUSION_BUFFER_BAND_HEIGHT (OCCLUSION_BUFFER_HEIGHT / OCCLUSION_BUFFER_BAND_COUNT)
+
+// Smaller models are not worth rasterizing (area of the largest face of the bounding box)
+#define MIN_OCCLUDER_AREA 4.f
+
+// Occluded entities are animated with this interval (in seconds)
+#define OCCLUDED_ANIMATION_INTERVAL 0.2f
+
+struct occluder_triangle
+{
+    // Screen-space position and reciprocal view depth
+    vec3 Vertices[3];
+};
+
+/*
+    Low-resolution depth buffer of the player camera, rendered from the occluders on the CPU.
+    Stores reciprocal view depth (1/w), which can be interpolated linearly in screen space: bigger values are closer, zero is empty.
+    Every mip keeps the farthest (smallest) depth of the 2x2 texels below it.
+*/
+struct occlusion_buffer
+{
+    mat4 WorldToCamera;
+    f32 FocalLength;
+    f32 AspectRatio;
+    f32 NearClipPlane;
+
+    u32 TriangleCount;
+    u32 MaxTriangleCount;
+    occluder_triangle *Triangles;
+
+    f32 *Mips[OCCLUSION_BUFFER_MIP_COUNT];
+};
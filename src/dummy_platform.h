@@ -12,6 +12,13 @@ struct read_file_result
     void *Contents;
 };
 
+// Copy-on-write view of the whole file
+struct map_file_result
+{
+    u64 Size;
+    void *Contents;
+};
+
 struct read_file_options
 {
     bool32 ReadAsText;
@@ -53,6 +60,16 @@ typedef PLATFORM_READ_FILE(platform_read_file);
 #define PLATFORM_WRITE_FILE(name) bool32 name(char *FileName, void *Buffer, u32 BufferSize)
 typedef PLATFORM_WRITE_FILE(platform_write_file);
 
+#define PLATFORM_MAP_FILE(name) map_file_result name(char *FileName)
+typedef PLATFORM_MAP_FILE(platform_map_file);
+
+#define PLATFORM_UNMAP_FILE(name) void name(map_file_result *File)
+typedef PLATFORM_UNMAP_FILE(platform_unmap_file);
+
+// Address space only, the pages are committed with CommitMemory (see InitGrowableMemoryArena)
+#define PLATFORM_RESERVE_MEMORY(name) void * name(umm Size)
+typedef PLATFORM_RESERVE_MEMORY(platform_reserve_memory);
+
 #define PLATFORM_GET_FILES(name) get_files_result name(wchar *Directory, memory_arena *Arena)
 typedef PLATFORM_GET_FILES(platform_get_files);
 
@@ -92,8 +109,13 @@ struct platform_api
 
     platform_read_file *ReadFile;
     platform_write_file *WriteFile;
+    platform_map_file *MapFile;
+    platform_unmap_file *UnmapFile;
     platform_get_files *GetFiles;
 
+    platform_reserve_memory *ReserveMemory;
+    platform_commit_memory *CommitMemory;
+
     platform_set_mouse_mode *SetMouseMode;
     platform_load_function *LoadFunction;
     platform_open_file_dialog *OpenFileDialog;
@@ -128,6 +150,8 @@ struct game_memory
     platform_api *Platform;
     platform_profiler *Profiler;
     job_queue *JobQueue;
+    job_queue *BackgroundJobQueue;
+    cvar_registry *CVars;
 };
 
 inline game_state *
@@ -149,7 +173,17 @@ ClearRenderCommands(game_memory *Memory)
 {
     render_commands *RenderCommands = (render_commands *) Memory->RenderCommandsStorage;
     RenderCommands->MaxRenderCommandsBufferSize = (u32) (Memory->RenderCommandsStorageSize - sizeof(render_commands));
+
+    if (RenderCommands->RenderCommandsBufferSize > RenderCommands->HighWaterRenderCommandsBufferSize)
+    {
+        RenderCommands->HighWaterRenderCommandsBufferSize = RenderCommands->RenderCommandsBufferSize;
+    }
+
+    RenderCommands->PrevRenderCommandsBufferSize = RenderCommands->RenderCommandsBufferSize;
+    RenderCommands->PrevRenderCommandCount = RenderCommands->RenderCommandCount;
+
     RenderCommands->RenderCommandsBufferSize = 0;
+    RenderCommands->RenderCommandCount = 0;
     RenderCommands->RenderCommandsBuffer = (u8 *) Memory->RenderCommandsStorage + sizeof(render_commands);
 }
 
@@ -165,7 +199,17 @@ ClearAudioCommands(game_memory *Memory)
 {
     audio_commands *AudioCommands = (audio_commands *) Memory->AudioCommandsStorage;
     AudioCommands->MaxAudioCommandsBufferSize = (u32) (Memory->AudioCommandsStorageSize - sizeof(audio_commands));
+
+    if (AudioCommands->AudioCommandsBufferSize > AudioCommands->HighWaterAudioCommandsBufferSize)
+    {
+        AudioCommands->HighWaterAudioCommandsBufferSize = AudioCommands->AudioCommandsBufferSize;
+    }
+
+    AudioCommands->PrevAudioCommandsBufferSize = AudioCommands->AudioCommandsBufferSize;
+    AudioCommands->PrevAudioCommandCount = AudioCommands->AudioCommandCount;
+
     AudioCommands->AudioCommandsBufferSize = 0;
+    AudioCommands->AudioCommandCount = 0;
     AudioCommands->AudioCommandsBuffer = (u8 *) Memory->AudioCommandsStorage + sizeof(audio_commands);
 }
 
@@ -234,3 +278,15 @@ typedef GAME_FRAME_START(game_frame_start_func);
 
 #define GAME_FRAME_END(name) void name(game_memory *Memory)
 typedef GAME_FRAME_END(game_frame_end_func);
+
+// Returns false until the game assets are ready, the platform calls it every frame until the scenario is spawned
+#define GAME_LOAD_BENCHMARK(name) bool32 name(game_memory *Memory, benchmark_scenario Scenario, u32 Seed)
+typedef GAME_LOAD_BENCHMARK(game_load_benchmark_func);
+
+// Called every frame of a running scenario, after the frame is rendered
+#define GAME_GET_BENCHMARK_STATUS(name) void name(game_memory *Memory, benchmark_status *Status)
+typedef GAME_GET_BENCHMARK_STATUS(game_get_benchmark_status_func);
+
+// Runs on the calling thread, the results are in the suite
+#define GAME_RUN_MICRO_BENCHMARKS(name) void name(game_memory *Memory, micro_benchmark_suite *Suite)
+typedef GAME_RUN_MICRO_BENCHMARKS(game_run_micro_benchmarks_func);
@@ -3,17 +3,179 @@
 #define PLATFORM_GET_TIMESTAMP(name) u64 name(void)
 typedef PLATFORM_GET_TIMESTAMP(platform_get_timestamp);
 
-struct profiler_sample
+#define PLATFORM_GET_THREAD_ID(name) u32 name(void)
+typedef PLATFORM_GET_THREAD_ID(platform_get_thread_id);
+
+// Hardware counters of the calling thread, the counters that are not available (see platform_profiler::AvailableCounters) stay 0
+#define PLATFORM_READ_PERFORMANCE_COUNTERS(name) void name(u64 *Counters)
+typedef PLATFORM_READ_PERFORMANCE_COUNTERS(platform_read_performance_counters);
+
+#define PROFILER_MAX_THREAD_COUNT 64
+// Has to be a power of 2
+#define PROFILER_THREAD_EVENT_COUNT 4096
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_NODE_COUNT 512
+// Has to be a power of 2
+#define PROFILER_MAX_NAME_COUNT 1024
+#define PROFILER_NO_NODE U32_MAX
+#define PROFILER_TRACE_MAX_EVENT_COUNT (1 << 21)
+#define PROFILER_TRACE_MAX_FRAME_COUNT 4096
+
+enum profiler_counter
+{
+    ProfilerCounter_Cycles,
+    ProfilerCounter_Instructions,
+    ProfilerCounter_L1DataMisses,
+    ProfilerCounter_LastLevelCacheMisses,
+    ProfilerCounter_BranchMisses,
+
+    ProfilerCounter_Count
+};
+
+struct profiler_frame_budget;
+
+struct profiler_event
+{
+    // Static string, the pointer is enough to tell the scopes apart (see InternProfilerName)
+    const char *Name;
+    // Scope that kicked the job, 0 for the other scopes
+    const char *Stage;
+    u64 Timestamp;
+    u32 Depth;
+    bool32 Begin;
+    // Only when the platform reads the hardware counters
+    u64 Counters[ProfilerCounter_Count];
+};
+
+// Scope that has begun but not ended yet, on the reading side
+struct profiler_open_scope
+{
+    u32 Depth;
+    u32 NodeIndex;
+    u32 NameIndex;
+    u32 StageNameIndex;
+    u64 StartTimestamp;
+    u64 StartCounters[ProfilerCounter_Count];
+    // Begin event is in the trace, so the end event has to be there as well
+    bool32 Traced;
+};
+
+/*
+    Events of one thread in a single-producer single-consumer ring.
+    The owning thread writes the events and never waits, the events are dropped while the ring is full.
+    The main thread reads them once per frame (see ProfilerStartFrame).
+*/
+struct profiler_thread
+{
+    u32 volatile ThreadId;
+    char Name[32];
+
+    // Writing side
+    u32 Depth;
+    const char *ScopeNames[PROFILER_MAX_DEPTH];
+    u64 volatile WriteIndex;
+    u32 volatile DroppedEventCount;
+
+    // Reading side
+    u64 volatile ReadIndex;
+    u32 ReadDroppedEventCount;
+    u32 OpenScopeCount;
+    profiler_open_scope OpenScopes[PROFILER_MAX_DEPTH];
+
+    profiler_event Events[PROFILER_THREAD_EVENT_COUNT];
+};
+
+// Copy of the scope name, so that the frames recorded before the game code reload don't point into the unloaded code
+struct profiler_name
 {
+    const char *Key;
     char Name[64];
+};
+
+// Scopes with the same name and the same parent are merged into one node
+struct profiler_node
+{
+    u32 NameIndex;
+    u32 ThreadIndex;
+    u32 Depth;
+
+    u32 ParentIndex;
+    u32 FirstChildIndex;
+    u32 NextSiblingIndex;
+
+    u32 CallCount;
     u64 ElapsedTicks;
-    f32 ElapsedMilliseconds;
+    // Including the children, same as ElapsedTicks
+    u64 Counters[ProfilerCounter_Count];
+};
+
+// Usage of an allocator at the end of the frame
+struct profiler_memory_sample
+{
+    char Name[64];
+    memory_stats Stats;
 };
 
 struct profiler_frame_samples
 {
-    u32 SampleCount;
-    profiler_sample Samples[64];
+    u64 StartTimestamp;
+    u64 EndTimestamp;
+
+    // Call tree of all threads, roots are linked with NextSiblingIndex
+    u32 NodeCount;
+    u32 FirstRootIndex;
+    profiler_node Nodes[PROFILER_MAX_NODE_COUNT];
+
+    // Events that didn't fit into the thread rings and the scopes that didn't fit into the tree
+    u32 DroppedEventCount;
+
+    u32 MemorySampleCount;
+    profiler_memory_sample MemorySamples[32];
+};
+
+enum profiler_trace_state
+{
+    ProfilerTrace_Idle,
+    ProfilerTrace_Requested,
+    ProfilerTrace_Capturing,
+    ProfilerTrace_Finished
+};
+
+struct profiler_trace_event
+{
+    u64 Timestamp;
+    u32 NameIndex;
+    u32 StageNameIndex;
+    u32 ThreadIndex;
+    bool32 Begin;
+};
+
+/*
+    Timeline of every scope and job over a window of frames, for the external trace viewers (see dummy_profiler_trace.h).
+    Events of each thread are in order and balanced: the scopes that are open when the capture starts or ends are cut at the frame boundary.
+
+    While watching for the spikes the trace keeps a single frame and starts over on each frame boundary,
+    unless that frame took longer than SpikeTicks. Call tree of the spike is kept in SpikeFrame.
+*/
+struct profiler_trace
+{
+    profiler_trace_state State;
+    u32 RequestedFrameCount;
+
+    bool32 WatchingSpikes;
+    bool32 SpikeCaptured;
+    u64 SpikeTicks;
+    u32 SpikeCount;
+    profiler_frame_samples *SpikeFrame;
+
+    u32 FrameCount;
+    // FrameCount + 1 frame boundaries
+    u64 *FrameTimestamps;
+
+    u32 EventCount;
+    profiler_trace_event *Events;
+
+    u32 DroppedEventCount;
 };
 
 struct platform_profiler
@@ -23,9 +185,34 @@ struct platform_profiler
     u32 MaxFrameSampleCount;
     profiler_frame_samples *FrameSamples;
 
+    // First thread is the main one
+    u32 volatile ThreadCount;
+    profiler_thread *Threads;
+
+    // Open addressing by the name pointer, read by the main thread only
+    u32 NameCount;
+    profiler_name *Names;
+
+    profiler_trace Trace;
+
+    // Frame time histograms (see dummy_profiler_budget.h)
+    profiler_frame_budget *FrameBudget;
+
+#if MEMORY_TELEMETRY
+    memory_telemetry *MemoryTelemetry;
+#endif
+
     platform_get_timestamp *GetTimestamp;
+    platform_get_thread_id *GetThreadId;
+    // Optional, 0 when the platform has no access to the hardware counters (or they are switched off)
+    platform_read_performance_counters *ReadPerformanceCounters;
+    // Bit per profiler_counter that the platform can read
+    u32 AvailableCounters;
 };
 
+// Each module (game code, platform) looks the thread up once
+dummy_global thread_local profiler_thread *CurrentProfilerThread;
+
 inline profiler_frame_samples *
 ProfilerGetCurrentFrameSamples(platform_profiler *Profiler)
 {
@@ -46,52 +233,727 @@ ProfilerGetPreviousFrameSamples(platform_profiler *Profiler)
     return Result;
 }
 
+inline f32
+GetProfilerMilliseconds(platform_profiler *Profiler, u64 Ticks)
+{
+    f32 Result = ((f32)Ticks / (f32)Profiler->TicksPerSecond) * 1000.f;
+    return Result;
+}
+
+inline bool32
+IsProfilerCounterAvailable(platform_profiler *Profiler, profiler_counter Counter)
+{
+    bool32 Result = Profiler->ReadPerformanceCounters && (Profiler->AvailableCounters & (1 << Counter));
+    return Result;
+}
+
+// Instructions per cycle
+inline f32
+GetProfilerIPC(u64 *Counters)
+{
+    f32 Result = 0.f;
+
+    if (Counters[ProfilerCounter_Cycles] > 0)
+    {
+        Result = (f32)Counters[ProfilerCounter_Instructions] / (f32)Counters[ProfilerCounter_Cycles];
+    }
+
+    return Result;
+}
+
+// Misses per thousand instructions
+inline f32
+GetProfilerMPKI(u64 *Counters, profiler_counter Counter)
+{
+    f32 Result = 0.f;
+
+    if (Counters[ProfilerCounter_Instructions] > 0)
+    {
+        Result = (f32)Counters[Counter] * 1000.f / (f32)Counters[ProfilerCounter_Instructions];
+    }
+
+    return Result;
+}
+
+inline u32
+GetProfilerThreadCount(platform_profiler *Profiler)
+{
+    u32 Result = Profiler->ThreadCount;
+
+    if (Result > PROFILER_MAX_THREAD_COUNT)
+    {
+        Result = PROFILER_MAX_THREAD_COUNT;
+    }
+
+    return Result;
+}
+
+// Registers the thread on first use, returns 0 once all thread slots are taken
+inline profiler_thread *
+GetProfilerThread(platform_profiler *Profiler)
+{
+    if (!CurrentProfilerThread)
+    {
+        u32 ThreadId = Profiler->GetThreadId();
+        u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+        // Thread could be registered by the other module already
+        for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount && !CurrentProfilerThread; ++ThreadIndex)
+        {
+            profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+            if (Thread->ThreadId == ThreadId)
+            {
+                CurrentProfilerThread = Thread;
+            }
+        }
+
+        if (!CurrentProfilerThread)
+        {
+            u32 ThreadIndex = AtomicIncrement(&Profiler->ThreadCount) - 1;
+
+            if (ThreadIndex < PROFILER_MAX_THREAD_COUNT)
+            {
+                CurrentProfilerThread = Profiler->Threads + ThreadIndex;
+
+                if (ThreadIndex == 0)
+                {
+                    CopyString("Main Thread", CurrentProfilerThread->Name);
+                }
+                else
+                {
+                    FormatString(CurrentProfilerThread->Name, "Thread 0x%x", ThreadId);
+                }
+
+                CurrentProfilerThread->ThreadId = ThreadId;
+            }
+        }
+    }
+
+    profiler_thread *Result = CurrentProfilerThread;
+    return Result;
+}
+
+// Name shown for the thread in the editor and in the traces
 inline void
-StoreProfileSample(platform_profiler *Profiler, char *Name, u64 ElapsedTicks)
+SetProfilerThreadName(platform_profiler *Profiler, const char *Name)
+{
+    profiler_thread *Thread = GetProfilerThread(Profiler);
+
+    if (Thread)
+    {
+        CopyString(Name, Thread->Name);
+    }
+}
+
+// Innermost open scope of the calling thread, 0 if there is none
+inline const char *
+GetProfilerScopeName(platform_profiler *Profiler)
 {
-    profiler_sample Sample = {};
+    const char *Result = 0;
+
+    profiler_thread *Thread = GetProfilerThread(Profiler);
+
+    if (Thread && Thread->Depth > 0 && Thread->Depth <= PROFILER_MAX_DEPTH)
+    {
+        Result = Thread->ScopeNames[Thread->Depth - 1];
+    }
+
+    return Result;
+}
+
+inline void
+WriteProfilerEvent(platform_profiler *Profiler, const char *Name, const char *Stage, u64 Timestamp, bool32 Begin)
+{
+    profiler_thread *Thread = GetProfilerThread(Profiler);
+
+    if (Thread)
+    {
+        u32 Depth = Begin ? Thread->Depth++ : --Thread->Depth;
+
+        if (Begin && Depth < PROFILER_MAX_DEPTH)
+        {
+            Thread->ScopeNames[Depth] = Name;
+        }
+
+        if (Thread->WriteIndex - Thread->ReadIndex < PROFILER_THREAD_EVENT_COUNT)
+        {
+            profiler_event *Event = Thread->Events + (Thread->WriteIndex & (PROFILER_THREAD_EVENT_COUNT - 1));
+
+            Event->Name = Name;
+            Event->Stage = Stage;
+            Event->Timestamp = Timestamp;
+            Event->Depth = Depth;
+            Event->Begin = Begin;
+
+            // Hook can be switched at runtime, the slot may still hold counters of an older event
+            platform_read_performance_counters *ReadPerformanceCounters = Profiler->ReadPerformanceCounters;
+
+            if (ReadPerformanceCounters)
+            {
+                ReadPerformanceCounters(Event->Counters);
+            }
+            else
+            {
+                ClearMemory(Event->Counters, sizeof(Event->Counters));
+            }
+
+            // Event is written before it's published
+            CompilerBarrier();
+
+            Thread->WriteIndex = Thread->WriteIndex + 1;
+        }
+        else
+        {
+            Thread->DroppedEventCount = Thread->DroppedEventCount + 1;
+        }
+    }
+}
+
+inline void
+ProfilerBeginScope(platform_profiler *Profiler, const char *Name, const char *Stage = 0)
+{
+    WriteProfilerEvent(Profiler, Name, Stage, Profiler->GetTimestamp(), true);
+}
+
+inline void
+ProfilerEndScope(platform_profiler *Profiler, const char *Name)
+{
+    WriteProfilerEvent(Profiler, Name, 0, Profiler->GetTimestamp(), false);
+}
+
+inline char *
+GetProfilerName(platform_profiler *Profiler, u32 NameIndex)
+{
+    char *Result = Profiler->Names[NameIndex].Name;
+    return Result;
+}
+
+// Same pointer with a different string means the game code was reloaded, the name gets a new entry then
+dummy_internal u32
+InternProfilerName(platform_profiler *Profiler, const char *Key)
+{
+    u32 Result = PROFILER_NO_NODE;
+
+    u32 NameIndex = (u32)(((umm)Key >> 3) * 2654435761u) & (PROFILER_MAX_NAME_COUNT - 1);
+
+    while (Result == PROFILER_NO_NODE)
+    {
+        profiler_name *Name = Profiler->Names + NameIndex;
+
+        if (!Name->Key)
+        {
+            Assert(Profiler->NameCount < PROFILER_MAX_NAME_COUNT - 1);
+
+            Name->Key = Key;
+            CopyString(Key, Name->Name);
+            ++Profiler->NameCount;
+
+            Result = NameIndex;
+        }
+        else if (Name->Key == Key && StringEquals(Name->Name, Key))
+        {
+            Result = NameIndex;
+        }
+        else
+        {
+            NameIndex = (NameIndex + 1) & (PROFILER_MAX_NAME_COUNT - 1);
+        }
+    }
+
+    return Result;
+}
+
+// Finds the child of the parent node (or the root of the thread) with the name, adds one if there is none
+dummy_internal u32
+GetProfilerNode(profiler_frame_samples *Frame, u32 ThreadIndex, u32 ParentIndex, u32 NameIndex, u32 Depth)
+{
+    u32 Result = PROFILER_NO_NODE;
+
+    u32 *Link = (ParentIndex == PROFILER_NO_NODE) ? &Frame->FirstRootIndex : &Frame->Nodes[ParentIndex].FirstChildIndex;
+
+    while (*Link != PROFILER_NO_NODE && Result == PROFILER_NO_NODE)
+    {
+        profiler_node *Node = Frame->Nodes + *Link;
+
+        if (Node->NameIndex == NameIndex && Node->ThreadIndex == ThreadIndex)
+        {
+            Result = *Link;
+        }
+        else
+        {
+            Link = &Node->NextSiblingIndex;
+        }
+    }
+
+    if (Result == PROFILER_NO_NODE && Frame->NodeCount < PROFILER_MAX_NODE_COUNT)
+    {
+        Result = Frame->NodeCount++;
+
+        profiler_node *Node = Frame->Nodes + Result;
+        Node->NameIndex = NameIndex;
+        Node->ThreadIndex = ThreadIndex;
+        Node->Depth = Depth;
+        Node->ParentIndex = ParentIndex;
+        Node->FirstChildIndex = PROFILER_NO_NODE;
+        Node->NextSiblingIndex = PROFILER_NO_NODE;
+        Node->CallCount = 0;
+        Node->ElapsedTicks = 0;
+
+        for (u32 CounterIndex = 0; CounterIndex < ProfilerCounter_Count; ++CounterIndex)
+        {
+            Node->Counters[CounterIndex] = 0;
+        }
+
+        *Link = Result;
+    }
+
+    return Result;
+}
+
+// Room for the end events of all the scopes that are traced already
+#define PROFILER_TRACE_RESERVED_EVENT_COUNT (PROFILER_MAX_THREAD_COUNT * PROFILER_MAX_DEPTH)
+
+inline void
+AppendProfilerTraceEvent(profiler_trace *Trace, u32 ThreadIndex, profiler_open_scope *Scope, u64 Timestamp, bool32 Begin)
+{
+    Assert(Trace->EventCount < PROFILER_TRACE_MAX_EVENT_COUNT);
+
+    profiler_trace_event *Event = Trace->Events + Trace->EventCount++;
+    Event->Timestamp = Timestamp;
+    Event->NameIndex = Scope->NameIndex;
+    Event->StageNameIndex = Scope->StageNameIndex;
+    Event->ThreadIndex = ThreadIndex;
+    Event->Begin = Begin;
+}
+
+inline void
+BeginProfilerTraceScope(profiler_trace *Trace, u32 ThreadIndex, profiler_open_scope *Scope, u64 Timestamp)
+{
+    Scope->Traced = false;
+
+    if (Trace->State == ProfilerTrace_Capturing)
+    {
+        if (Trace->EventCount < PROFILER_TRACE_MAX_EVENT_COUNT - PROFILER_TRACE_RESERVED_EVENT_COUNT)
+        {
+            AppendProfilerTraceEvent(Trace, ThreadIndex, Scope, Timestamp, true);
+            Scope->Traced = true;
+        }
+        else
+        {
+            ++Trace->DroppedEventCount;
+        }
+    }
+}
+
+inline void
+EndProfilerTraceScope(profiler_trace *Trace, u32 ThreadIndex, profiler_open_scope *Scope, u64 Timestamp)
+{
+    if (Scope->Traced)
+    {
+        AppendProfilerTraceEvent(Trace, ThreadIndex, Scope, Timestamp, false);
+        Scope->Traced = false;
+    }
+}
+
+/*
+    Merges the events written since the last read into the call tree of the frame.
+    Depth is written with every event, so the scopes that lost their begin or end event are skipped.
+*/
+dummy_internal void
+ReadProfilerThreadEvents(platform_profiler *Profiler, profiler_frame_samples *Frame, u32 ThreadIndex)
+{
+    profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+    u64 WriteIndex = Thread->WriteIndex;
+    CompilerBarrier();
+
+    for (u64 EventIndex = Thread->ReadIndex; EventIndex < WriteIndex; ++EventIndex)
+    {
+        profiler_event *Event = Thread->Events + (EventIndex & (PROFILER_THREAD_EVENT_COUNT - 1));
+
+        if (Event->Begin)
+        {
+            while (Thread->OpenScopeCount > 0 && Thread->OpenScopes[Thread->OpenScopeCount - 1].Depth >= Event->Depth)
+            {
+                EndProfilerTraceScope(&Profiler->Trace, ThreadIndex, Thread->OpenScopes + --Thread->OpenScopeCount, Event->Timestamp);
+            }
+
+            if (Thread->OpenScopeCount < PROFILER_MAX_DEPTH)
+            {
+                u32 ParentIndex = PROFILER_NO_NODE;
+                u32 NodeIndex = PROFILER_NO_NODE;
+                u32 NameIndex = InternProfilerName(Profiler, Event->Name);
+
+                if (Thread->OpenScopeCount > 0)
+                {
+                    ParentIndex = Thread->OpenScopes[Thread->OpenScopeCount - 1].NodeIndex;
+                }
+
+                // Children of the scopes that didn't fit into the tree are dropped as well
+                if (Thread->OpenScopeCount == 0 || ParentIndex != PROFILER_NO_NODE)
+                {
+                    NodeIndex = GetProfilerNode(Frame, ThreadIndex, ParentIndex, NameIndex, Event->Depth);
+                }
+
+                if (NodeIndex == PROFILER_NO_NODE)
+                {
+                    ++Frame->DroppedEventCount;
+                }
+
+                profiler_open_scope *Scope = Thread->OpenScopes + Thread->OpenScopeCount++;
+                Scope->Depth = Event->Depth;
+                Scope->NodeIndex = NodeIndex;
+                Scope->NameIndex = NameIndex;
+                Scope->StageNameIndex = Event->Stage ? InternProfilerName(Profiler, Event->Stage) : PROFILER_NO_NODE;
+                Scope->StartTimestamp = Event->Timestamp;
+
+                for (u32 CounterIndex = 0; CounterIndex < ProfilerCounter_Count; ++CounterIndex)
+                {
+                    Scope->StartCounters[CounterIndex] = Event->Counters[CounterIndex];
+                }
+
+                BeginProfilerTraceScope(&Profiler->Trace, ThreadIndex, Scope, Event->Timestamp);
+            }
+        }
+        else
+        {
+            while (Thread->OpenScopeCount > 0 && Thread->OpenScopes[Thread->OpenScopeCount - 1].Depth > Event->Depth)
+            {
+                EndProfilerTraceScope(&Profiler->Trace, ThreadIndex, Thread->OpenScopes + --Thread->OpenScopeCount, Event->Timestamp);
+            }
+
+            if (Thread->OpenScopeCount > 0 && Thread->OpenScopes[Thread->OpenScopeCount - 1].Depth == Event->Depth)
+            {
+                profiler_open_scope *Scope = Thread->OpenScopes + --Thread->OpenScopeCount;
+
+                EndProfilerTraceScope(&Profiler->Trace, ThreadIndex, Scope, Event->Timestamp);
+
+                if (Scope->NodeIndex != PROFILER_NO_NODE)
+                {
+                    profiler_node *Node = Frame->Nodes + Scope->NodeIndex;
+
+                    if (Event->Timestamp > Scope->StartTimestamp)
+                    {
+                        Node->ElapsedTicks += Event->Timestamp - Scope->StartTimestamp;
+                    }
+
+                    for (u32 CounterIndex = 0; CounterIndex < ProfilerCounter_Count; ++CounterIndex)
+                    {
+                        if (Event->Counters[CounterIndex] > Scope->StartCounters[CounterIndex])
+                        {
+                            Node->Counters[CounterIndex] += Event->Counters[CounterIndex] - Scope->StartCounters[CounterIndex];
+                        }
+                    }
+
+                    ++Node->CallCount;
+                }
+            }
+        }
+    }
+
+    // Events are read before the slots are handed back to the writer
+    CompilerBarrier();
+    Thread->ReadIndex = WriteIndex;
+
+    u32 DroppedEventCount = Thread->DroppedEventCount;
+    Frame->DroppedEventCount += DroppedEventCount - Thread->ReadDroppedEventCount;
+    Thread->ReadDroppedEventCount = DroppedEventCount;
+}
+
+inline void
+ResetProfilerFrame(profiler_frame_samples *Frame, u64 Timestamp)
+{
+    Frame->StartTimestamp = Timestamp;
+    Frame->EndTimestamp = Timestamp;
+    Frame->NodeCount = 0;
+    Frame->FirstRootIndex = PROFILER_NO_NODE;
+    Frame->DroppedEventCount = 0;
+    Frame->MemorySampleCount = 0;
+}
+
+// Main thread only
+inline void
+StoreProfileMemorySample(platform_profiler *Profiler, const char *Name, memory_stats Stats)
+{
+    profiler_memory_sample Sample = {};
     CopyString(Name, Sample.Name);
-    Sample.ElapsedTicks = ElapsedTicks;
-    Sample.ElapsedMilliseconds = ((f32)ElapsedTicks / (f32)Profiler->TicksPerSecond) * 1000.f;
+    Sample.Stats = Stats;
 
     profiler_frame_samples *FrameSamples = ProfilerGetCurrentFrameSamples(Profiler);
 
-    FrameSamples->Samples[FrameSamples->SampleCount++] = Sample;
-    Assert(FrameSamples->SampleCount < ArrayCount(FrameSamples->Samples));
+    FrameSamples->MemorySamples[FrameSamples->MemorySampleCount++] = Sample;
+    Assert(FrameSamples->MemorySampleCount < ArrayCount(FrameSamples->MemorySamples));
+}
+
+// Per-frame counters of the allocator start over after each sample
+template <typename T>
+inline void
+StoreProfileMemorySample(platform_profiler *Profiler, const char *Name, T *Allocator)
+{
+    StoreProfileMemorySample(Profiler, Name, GetMemoryStats(Allocator));
+    ResetFrameMemoryStats(Allocator);
 }
 
+/*
+    Capture starts with the next frame, the trace is Finished once the frames are recorded or the event buffer is full.
+    Takes over the spike watch, the frame that is being watched becomes the first frame of the trace.
+*/
+inline void
+RequestProfilerTrace(platform_profiler *Profiler, u32 FrameCount)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    bool32 CanTakeOver = Trace->WatchingSpikes && Trace->State != ProfilerTrace_Finished;
+
+    if ((Trace->State == ProfilerTrace_Idle || CanTakeOver) && FrameCount > 0)
+    {
+        if (FrameCount > PROFILER_TRACE_MAX_FRAME_COUNT)
+        {
+            FrameCount = PROFILER_TRACE_MAX_FRAME_COUNT;
+        }
+
+        Trace->RequestedFrameCount = FrameCount;
+        Trace->WatchingSpikes = false;
+
+        if (Trace->State == ProfilerTrace_Idle)
+        {
+            Trace->State = ProfilerTrace_Requested;
+        }
+    }
+}
+
+// Records each frame until one of them takes longer than the budget, SpikeFrame has to be allocated by the platform
+inline void
+WatchProfilerSpikes(platform_profiler *Profiler, f32 BudgetMilliseconds)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    Assert(Trace->SpikeFrame);
+
+    if (Trace->State == ProfilerTrace_Idle)
+    {
+        Trace->RequestedFrameCount = 1;
+        Trace->WatchingSpikes = true;
+        Trace->SpikeCaptured = false;
+        Trace->State = ProfilerTrace_Requested;
+    }
+
+    if (Trace->WatchingSpikes)
+    {
+        Trace->SpikeTicks = (u64) ((f64) BudgetMilliseconds / 1000.0 * (f64) Profiler->TicksPerSecond);
+    }
+}
+
+// Watched frame is thrown away, the trace is Idle from the next frame
+inline void
+StopWatchingProfilerSpikes(platform_profiler *Profiler)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    if (Trace->WatchingSpikes && Trace->State != ProfilerTrace_Finished)
+    {
+        Trace->RequestedFrameCount = 0;
+    }
+}
+
+// Called once the trace is written out
+inline void
+ReleaseProfilerTrace(platform_profiler *Profiler)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    Assert(Trace->State == ProfilerTrace_Finished);
+
+    Trace->State = ProfilerTrace_Idle;
+    Trace->FrameCount = 0;
+    Trace->EventCount = 0;
+    Trace->DroppedEventCount = 0;
+    Trace->WatchingSpikes = false;
+    Trace->SpikeCaptured = false;
+}
+
+// Opens or closes the trace scopes of all the scopes that are open on the frame boundary
+dummy_internal void
+CutProfilerTraceScopes(platform_profiler *Profiler, u64 Timestamp, bool32 Begin)
+{
+    u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+        for (u32 OpenScopeIndex = 0; OpenScopeIndex < Thread->OpenScopeCount; ++OpenScopeIndex)
+        {
+            if (Begin)
+            {
+                BeginProfilerTraceScope(&Profiler->Trace, ThreadIndex, Thread->OpenScopes + OpenScopeIndex, Timestamp);
+            }
+            else
+            {
+                // Innermost scope ends first
+                u32 ScopeIndex = Thread->OpenScopeCount - 1 - OpenScopeIndex;
+                EndProfilerTraceScope(&Profiler->Trace, ThreadIndex, Thread->OpenScopes + ScopeIndex, Timestamp);
+            }
+        }
+    }
+}
+
+// Empties the trace on the frame boundary, the scopes that are open continue in the new frame
+inline void
+RestartProfilerTrace(platform_profiler *Profiler, u64 Timestamp)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    CutProfilerTraceScopes(Profiler, Timestamp, false);
+
+    Trace->FrameCount = 0;
+    Trace->FrameTimestamps[0] = Timestamp;
+    Trace->EventCount = 0;
+    Trace->DroppedEventCount = 0;
+
+    CutProfilerTraceScopes(Profiler, Timestamp, true);
+}
+
+/*
+    Main thread only, outside of any scope.
+    Finishes the call tree of the previous frame, the scopes that are still open (long-running jobs)
+    are split at the frame boundary and continue in the tree of the new frame.
+*/
 inline void
 ProfilerStartFrame(platform_profiler *Profiler)
 {
+    profiler_frame_samples *PrevFrame = ProfilerGetCurrentFrameSamples(Profiler);
+    u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        ReadProfilerThreadEvents(Profiler, PrevFrame, ThreadIndex);
+    }
+
+    u64 Timestamp = Profiler->GetTimestamp();
+    PrevFrame->EndTimestamp = Timestamp;
+
+#if MEMORY_TELEMETRY
+    if (Profiler->MemoryTelemetry)
+    {
+        ResetMemoryTelemetryFrame(Profiler->MemoryTelemetry);
+    }
+#endif
+
+    profiler_trace *Trace = &Profiler->Trace;
+
+    if (Trace->State == ProfilerTrace_Capturing)
+    {
+        Trace->FrameTimestamps[++Trace->FrameCount] = Timestamp;
+
+        bool32 OutOfEvents = Trace->EventCount >= PROFILER_TRACE_MAX_EVENT_COUNT - PROFILER_TRACE_RESERVED_EVENT_COUNT;
+
+        if (Trace->WatchingSpikes)
+        {
+            if (Trace->RequestedFrameCount == 0)
+            {
+                CutProfilerTraceScopes(Profiler, Timestamp, false);
+
+                Trace->State = ProfilerTrace_Finished;
+                ReleaseProfilerTrace(Profiler);
+            }
+            else if (PrevFrame->EndTimestamp - PrevFrame->StartTimestamp > Trace->SpikeTicks)
+            {
+                CutProfilerTraceScopes(Profiler, Timestamp, false);
+
+                *Trace->SpikeFrame = *PrevFrame;
+                Trace->SpikeCaptured = true;
+                ++Trace->SpikeCount;
+                Trace->State = ProfilerTrace_Finished;
+            }
+            else
+            {
+                RestartProfilerTrace(Profiler, Timestamp);
+            }
+        }
+        else if (Trace->FrameCount >= Trace->RequestedFrameCount || OutOfEvents)
+        {
+            CutProfilerTraceScopes(Profiler, Timestamp, false);
+            Trace->State = ProfilerTrace_Finished;
+        }
+    }
+    else if (Trace->State == ProfilerTrace_Requested)
+    {
+        Trace->State = ProfilerTrace_Capturing;
+        Trace->FrameCount = 0;
+        Trace->FrameTimestamps[0] = Timestamp;
+        Trace->EventCount = 0;
+        Trace->DroppedEventCount = 0;
+
+        CutProfilerTraceScopes(Profiler, Timestamp, true);
+    }
+
     Profiler->CurrentFrameSampleIndex = (Profiler->CurrentFrameSampleIndex + 1) % Profiler->MaxFrameSampleCount;
-    profiler_frame_samples *FrameSamples = ProfilerGetCurrentFrameSamples(Profiler);
-    FrameSamples->SampleCount = 0;
+
+    profiler_frame_samples *Frame = ProfilerGetCurrentFrameSamples(Profiler);
+    ResetProfilerFrame(Frame, Timestamp);
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+        u32 ParentIndex = PROFILER_NO_NODE;
+
+        for (u32 ScopeIndex = 0; ScopeIndex < Thread->OpenScopeCount; ++ScopeIndex)
+        {
+            profiler_open_scope *Scope = Thread->OpenScopes + ScopeIndex;
+
+            if (Scope->NodeIndex != PROFILER_NO_NODE)
+            {
+                profiler_node *PrevNode = PrevFrame->Nodes + Scope->NodeIndex;
+
+                if (Timestamp > Scope->StartTimestamp)
+                {
+                    PrevNode->ElapsedTicks += Timestamp - Scope->StartTimestamp;
+                }
+
+                Scope->NodeIndex = PROFILER_NO_NODE;
+
+                if (ScopeIndex == 0 || ParentIndex != PROFILER_NO_NODE)
+                {
+                    Scope->NodeIndex = GetProfilerNode(Frame, ThreadIndex, ParentIndex, PrevNode->NameIndex, PrevNode->Depth);
+                }
+            }
+
+            Scope->StartTimestamp = Timestamp;
+            ParentIndex = Scope->NodeIndex;
+        }
+    }
 }
 
 struct auto_profiler
 {
     platform_profiler *Profiler;
-    char *Name;
-    u64 StartTime;
+    const char *Name;
 
-    auto_profiler(platform_profiler *Profiler, char *Name) : Profiler(Profiler), Name(Name)
+    auto_profiler(platform_profiler *Profiler, const char *Name, const char *Stage = 0) : Profiler(Profiler), Name(Name)
     {
-        StartTime = Profiler->GetTimestamp();
+        ProfilerBeginScope(Profiler, Name, Stage);
     }
 
     ~auto_profiler()
     {
-        u64 EndTime = Profiler->GetTimestamp();
-        u64 ElapsedTicks = EndTime - StartTime;
-
-        StoreProfileSample(Profiler, Name, ElapsedTicks);
+        ProfilerEndScope(Profiler, Name);
     }
 };
 
+// Names have to be string literals
 #if PROFILER
-#define PROFILE(Profiler, Name) auto_profiler Profile(Profiler, (char *) Name)
+#define PROFILE(Profiler, Name) auto_profiler Profile(Profiler, Name)
+#define PROFILE_JOB(Profiler, Job) auto_profiler ProfileJob(Profiler, (Job)->Name, (Job)->Stage)
+#define PROFILER_SCOPE_NAME(Profiler) GetProfilerScopeName(Profiler)
 #define PROFILER_START_FRAME(Profiler) ProfilerStartFrame(Profiler)
+#define PROFILE_MEMORY(Profiler, Name, Allocator) StoreProfileMemorySample(Profiler, Name, Allocator)
 #else
-#define PROFILE(...) 
-#define PROFILER_START_FRAME(...) 
+#define PROFILE(...)
+#define PROFILE_JOB(...)
+#define PROFILER_SCOPE_NAME(...) 0
+#define PROFILER_START_FRAME(...)
+#define PROFILE_MEMORY(...)
 #endif
@@ -0,0 +1,247 @@
+#pragma once
+
+/*
+    Rolling histograms of the frame time and of the main stages over the last few seconds.
+    Buckets are logarithmic (a few per octave), so the percentiles are within ~10% from a few microseconds up to a second.
+    Platform records the previous frame once the profiler has started the next one (see RecordProfilerFrameBudget).
+*/
+
+#define FRAME_BUDGET_HISTORY_COUNT 600
+#define FRAME_BUDGET_BUCKET_COUNT 128
+#define FRAME_BUDGET_BUCKETS_PER_OCTAVE 8
+// Upper bound of the first bucket
+#define FRAME_BUDGET_MIN_MILLISECONDS 0.005f
+#define FRAME_BUDGET_MAX_TRACK_COUNT 32
+// Fixed steps per frame, the last bucket takes everything above
+#define FRAME_BUDGET_MAX_UPDATE_STEP_COUNT 8
+#define FRAME_BUDGET_FRAME_TRACK_NAME "Frame"
+// Stages of the game render (see GameRender) get their own tracks
+#define FRAME_BUDGET_STAGE_PREFIX "GameRender:"
+
+// Main thread scopes that get their own tracks besides the whole frame and the stages
+dummy_global const char *FrameBudgetScopeNames[] =
+{
+    "FixedUpdate",
+    "Render",
+    "GameRender",
+    "ProcessRenderCommands",
+    "Win32PresentFrame"
+};
+
+struct profiler_budget_track
+{
+    char Name[64];
+    // Cached lookup, the scope gets a new name index when the game code is reloaded
+    u32 NameIndex;
+
+    u32 SampleCount;
+    u32 Buckets[FRAME_BUDGET_BUCKET_COUNT];
+    u8 History[FRAME_BUDGET_HISTORY_COUNT];
+
+    // Gathered during the frame
+    f32 FrameMilliseconds;
+};
+
+struct profiler_frame_budget
+{
+    f32 BudgetMilliseconds;
+
+    // Spikes are saved to disk until MaxSpikeCaptureCount
+    bool32 CaptureSpikes;
+    u32 MaxSpikeCaptureCount;
+
+    u32 FrameCount;
+    u32 HistoryIndex;
+    u32 OverBudgetFrameCount;
+
+    u32 TrackCount;
+    profiler_budget_track Tracks[FRAME_BUDGET_MAX_TRACK_COUNT];
+
+    // How many fixed updates ran per frame, more than one means the update accumulator fell behind
+    u32 UpdateStepBuckets[FRAME_BUDGET_MAX_UPDATE_STEP_COUNT + 1];
+    u8 UpdateStepHistory[FRAME_BUDGET_HISTORY_COUNT];
+};
+
+inline u32
+GetFrameBudgetBucket(f32 Milliseconds)
+{
+    u32 Result = 0;
+
+    if (Milliseconds > FRAME_BUDGET_MIN_MILLISECONDS)
+    {
+        f32 Octaves = Log(Milliseconds / FRAME_BUDGET_MIN_MILLISECONDS) / Log(2.f);
+        i32 Bucket = Ceil(Octaves * (f32) FRAME_BUDGET_BUCKETS_PER_OCTAVE);
+
+        Result = Bucket < FRAME_BUDGET_BUCKET_COUNT ? (u32) Bucket : FRAME_BUDGET_BUCKET_COUNT - 1;
+    }
+
+    return Result;
+}
+
+// Upper bound of the bucket
+inline f32
+GetFrameBudgetBucketMilliseconds(u32 Bucket)
+{
+    f32 Result = FRAME_BUDGET_MIN_MILLISECONDS * Power(2.f, (f32) Bucket / (f32) FRAME_BUDGET_BUCKETS_PER_OCTAVE);
+    return Result;
+}
+
+inline void
+InitProfilerFrameBudget(profiler_frame_budget *Budget, f32 BudgetMilliseconds)
+{
+    Budget->BudgetMilliseconds = BudgetMilliseconds;
+    Budget->CaptureSpikes = true;
+    Budget->MaxSpikeCaptureCount = 8;
+}
+
+// 0 once all the tracks are taken
+dummy_internal profiler_budget_track *
+GetProfilerBudgetTrack(profiler_frame_budget *Budget, const char *Name, u32 NameIndex)
+{
+    profiler_budget_track *Result = 0;
+
+    for (u32 TrackIndex = 0; TrackIndex < Budget->TrackCount && !Result; ++TrackIndex)
+    {
+        profiler_budget_track *Track = Budget->Tracks + TrackIndex;
+
+        if (Track->NameIndex == NameIndex || StringEquals(Track->Name, Name))
+        {
+            Track->NameIndex = NameIndex;
+            Result = Track;
+        }
+    }
+
+    if (!Result && Budget->TrackCount < FRAME_BUDGET_MAX_TRACK_COUNT)
+    {
+        Result = Budget->Tracks + Budget->TrackCount++;
+
+        CopyString(Name, Result->Name);
+        Result->NameIndex = NameIndex;
+    }
+
+    return Result;
+}
+
+inline bool32
+IsProfilerBudgetScope(const char *Name)
+{
+    bool32 Result = StringStartsWith(Name, FRAME_BUDGET_STAGE_PREFIX);
+
+    for (u32 ScopeIndex = 0; ScopeIndex < ArrayCount(FrameBudgetScopeNames) && !Result; ++ScopeIndex)
+    {
+        Result = StringEquals(Name, FrameBudgetScopeNames[ScopeIndex]);
+    }
+
+    return Result;
+}
+
+// Oldest sample of the window is replaced once the window is full
+inline void
+AddProfilerBudgetSample(profiler_budget_track *Track, u32 HistoryIndex, f32 Milliseconds)
+{
+    if (Track->SampleCount == FRAME_BUDGET_HISTORY_COUNT)
+    {
+        --Track->Buckets[Track->History[HistoryIndex]];
+    }
+    else
+    {
+        ++Track->SampleCount;
+    }
+
+    u32 Bucket = GetFrameBudgetBucket(Milliseconds);
+
+    Track->History[HistoryIndex] = (u8) Bucket;
+    ++Track->Buckets[Bucket];
+}
+
+// Upper bound of the bucket with the nearest rank
+dummy_internal f32
+GetProfilerBudgetPercentile(profiler_budget_track *Track, f32 Percentile)
+{
+    f32 Result = 0.f;
+
+    if (Track->SampleCount > 0)
+    {
+        u32 Rank = (u32) Ceil(Percentile * (f32) Track->SampleCount);
+        u32 Count = 0;
+        u32 Bucket = 0;
+
+        while (Bucket < FRAME_BUDGET_BUCKET_COUNT - 1 && Count + Track->Buckets[Bucket] < Rank)
+        {
+            Count += Track->Buckets[Bucket++];
+        }
+
+        Result = GetFrameBudgetBucketMilliseconds(Bucket);
+    }
+
+    return Result;
+}
+
+// Called once per frame with the call tree of the previous frame, the tracks that didn't run this frame get 0
+dummy_internal void
+RecordProfilerFrameBudget(profiler_frame_budget *Budget, platform_profiler *Profiler)
+{
+    profiler_frame_samples *Frame = ProfilerGetPreviousFrameSamples(Profiler);
+
+    u32 HistoryIndex = Budget->HistoryIndex;
+    u32 UpdateStepCount = 0;
+    f32 FrameMilliseconds = GetProfilerMilliseconds(Profiler, Frame->EndTimestamp - Frame->StartTimestamp);
+
+    // Frame is always the first track
+    profiler_budget_track *FrameTrack = GetProfilerBudgetTrack(Budget, FRAME_BUDGET_FRAME_TRACK_NAME, PROFILER_NO_NODE);
+    FrameTrack->FrameMilliseconds = FrameMilliseconds;
+
+    for (u32 NodeIndex = 0; NodeIndex < Frame->NodeCount; ++NodeIndex)
+    {
+        profiler_node *Node = Frame->Nodes + NodeIndex;
+
+        // Main thread only, the jobs overlap with it
+        if (Node->ThreadIndex == 0)
+        {
+            char *Name = GetProfilerName(Profiler, Node->NameIndex);
+
+            if (StringEquals(Name, "FixedStep"))
+            {
+                UpdateStepCount += Node->CallCount;
+            }
+            else if (IsProfilerBudgetScope(Name))
+            {
+                profiler_budget_track *Track = GetProfilerBudgetTrack(Budget, Name, Node->NameIndex);
+
+                if (Track)
+                {
+                    Track->FrameMilliseconds += GetProfilerMilliseconds(Profiler, Node->ElapsedTicks);
+                }
+            }
+        }
+    }
+
+    for (u32 TrackIndex = 0; TrackIndex < Budget->TrackCount; ++TrackIndex)
+    {
+        profiler_budget_track *Track = Budget->Tracks + TrackIndex;
+
+        AddProfilerBudgetSample(Track, HistoryIndex, Track->FrameMilliseconds);
+        Track->FrameMilliseconds = 0.f;
+    }
+
+    if (UpdateStepCount > FRAME_BUDGET_MAX_UPDATE_STEP_COUNT)
+    {
+        UpdateStepCount = FRAME_BUDGET_MAX_UPDATE_STEP_COUNT;
+    }
+
+    if (Budget->FrameCount >= FRAME_BUDGET_HISTORY_COUNT)
+    {
+        --Budget->UpdateStepBuckets[Budget->UpdateStepHistory[HistoryIndex]];
+    }
+
+    Budget->UpdateStepHistory[HistoryIndex] = (u8) UpdateStepCount;
+    ++Budget->UpdateStepBuckets[UpdateStepCount];
+
+    if (FrameMilliseconds > Budget->BudgetMilliseconds)
+    {
+        ++Budget->OverBudgetFrameCount;
+    }
+
+    ++Budget->FrameCount;
+    Budget->HistoryIndex = (HistoryIndex + 1) % FRAME_BUDGET_HISTORY_COUNT;
+}
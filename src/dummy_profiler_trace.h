@@ -0,0 +1,538 @@
+#pragma once
+
+/*
+    Export of the profiler trace (see profiler_trace) to the formats of the external trace viewers:
+    Chrome trace event JSON (chrome://tracing, ui.perfetto.dev) and Perfetto protobuf (ui.perfetto.dev).
+    Timestamps are relative to the start of the capture, each thread gets its own track and the frames get one more.
+    Call tree (with the hardware counters) and memory telemetry of the previous frame are exported as CSV.
+*/
+
+#define PROFILER_TRACE_PROCESS_ID 1
+#define PROFILER_TRACE_PROCESS_NAME "dummy"
+
+inline void
+AppendTraceBytes(memory_arena *Arena, const void *Bytes, umm Size)
+{
+    u8 *Dest = (u8 *) PushSize(Arena, Size, AlignNoClear(1));
+    CopyMemory((void *) Bytes, Dest, Size);
+}
+
+dummy_internal void
+AppendTraceText(memory_arena *Arena, const char *Format, ...)
+{
+    va_list Args;
+
+    va_start(Args, Format);
+    AppendTextArgs(Arena, Format, Args);
+    va_end(Args);
+}
+
+inline f64
+GetTraceMicroseconds(platform_profiler *Profiler, u64 Timestamp)
+{
+    u64 Ticks = Timestamp - Profiler->Trace.FrameTimestamps[0];
+    f64 Result = (f64) Ticks * 1000000.0 / (f64) Profiler->TicksPerSecond;
+    return Result;
+}
+
+inline u64
+GetTraceNanoseconds(platform_profiler *Profiler, u64 Timestamp)
+{
+    u64 Ticks = Timestamp - Profiler->Trace.FrameTimestamps[0];
+    u64 Result = (u64) ((f64) Ticks * 1000000000.0 / (f64) Profiler->TicksPerSecond);
+    return Result;
+}
+
+//
+// Chrome trace event JSON
+//
+
+// Scope names are code identifiers, but the quotes and the backslashes are escaped anyway
+dummy_internal void
+AppendJSONString(memory_arena *Arena, const char *String)
+{
+    AppendTraceBytes(Arena, "\"", 1);
+
+    for (const char *Char = String; *Char; ++Char)
+    {
+        if (*Char == '"' || *Char == '\\')
+        {
+            AppendTraceBytes(Arena, "\\", 1);
+        }
+
+        AppendTraceBytes(Arena, Char, 1);
+    }
+
+    AppendTraceBytes(Arena, "\"", 1);
+}
+
+// Thread tracks use the thread ids, the frame track is the thread 0
+dummy_internal void
+WriteChromeTrace(platform_profiler *Profiler, memory_arena *Arena)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+    u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+    AppendTraceText(Arena, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    AppendTraceText(Arena, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}},\n", PROFILER_TRACE_PROCESS_ID, PROFILER_TRACE_PROCESS_NAME);
+    AppendTraceText(Arena, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"Frames\"}},\n", PROFILER_TRACE_PROCESS_ID);
+    AppendTraceText(Arena, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"sort_index\":-1}},\n", PROFILER_TRACE_PROCESS_ID);
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+        AppendTraceText(Arena, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", PROFILER_TRACE_PROCESS_ID, Thread->ThreadId);
+        AppendJSONString(Arena, Thread->Name);
+        AppendTraceText(Arena, "}},\n");
+
+        AppendTraceText(Arena, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"sort_index\":%u}},\n", PROFILER_TRACE_PROCESS_ID, Thread->ThreadId, ThreadIndex);
+    }
+
+    for (u32 FrameIndex = 0; FrameIndex < Trace->FrameCount; ++FrameIndex)
+    {
+        f64 Start = GetTraceMicroseconds(Profiler, Trace->FrameTimestamps[FrameIndex]);
+        f64 End = GetTraceMicroseconds(Profiler, Trace->FrameTimestamps[FrameIndex + 1]);
+
+        AppendTraceText(
+            Arena,
+            "{\"name\":\"Frame %u\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":0},\n",
+            FrameIndex, Start, End - Start, PROFILER_TRACE_PROCESS_ID
+        );
+    }
+
+    for (u32 EventIndex = 0; EventIndex < Trace->EventCount; ++EventIndex)
+    {
+        profiler_trace_event *Event = Trace->Events + EventIndex;
+        profiler_thread *Thread = Profiler->Threads + Event->ThreadIndex;
+
+        bool32 Job = Event->StageNameIndex != PROFILER_NO_NODE;
+
+        AppendTraceText(Arena, "{\"name\":");
+        AppendJSONString(Arena, GetProfilerName(Profiler, Event->NameIndex));
+        AppendTraceText(
+            Arena,
+            ",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u",
+            Job ? "job" : "scope", Event->Begin ? "B" : "E", GetTraceMicroseconds(Profiler, Event->Timestamp), PROFILER_TRACE_PROCESS_ID, Thread->ThreadId
+        );
+
+        if (Job && Event->Begin)
+        {
+            AppendTraceText(Arena, ",\"args\":{\"stage\":");
+            AppendJSONString(Arena, GetProfilerName(Profiler, Event->StageNameIndex));
+            AppendTraceText(Arena, ",\"worker\":");
+            AppendJSONString(Arena, Thread->Name);
+            AppendTraceText(Arena, "}");
+        }
+
+        AppendTraceText(Arena, "},\n");
+    }
+
+    // Trailing comma is not allowed, the metadata event closes the list
+    AppendTraceText(Arena, "{\"name\":\"trace_stats\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"frames\":%u,\"dropped_events\":%u}}\n", PROFILER_TRACE_PROCESS_ID, Trace->FrameCount, Trace->DroppedEventCount);
+    AppendTraceText(Arena, "]}\n");
+}
+
+//
+// Perfetto protobuf
+//
+
+// Field numbers of perfetto/trace/trace_packet.proto and perfetto/trace/track_event/*.proto
+#define PERFETTO_TRACE_PACKET 1
+
+#define PERFETTO_PACKET_TIMESTAMP 8
+#define PERFETTO_PACKET_SEQUENCE_ID 10
+#define PERFETTO_PACKET_TRACK_EVENT 11
+#define PERFETTO_PACKET_SEQUENCE_FLAGS 13
+#define PERFETTO_PACKET_TRACK_DESCRIPTOR 60
+
+#define PERFETTO_TRACK_UUID 1
+#define PERFETTO_TRACK_NAME 2
+#define PERFETTO_TRACK_PROCESS 3
+#define PERFETTO_TRACK_THREAD 4
+#define PERFETTO_TRACK_PARENT_UUID 5
+
+#define PERFETTO_PROCESS_PID 1
+#define PERFETTO_PROCESS_NAME 6
+
+#define PERFETTO_THREAD_PID 1
+#define PERFETTO_THREAD_TID 2
+#define PERFETTO_THREAD_NAME 5
+
+#define PERFETTO_EVENT_DEBUG_ANNOTATIONS 4
+#define PERFETTO_EVENT_TYPE 9
+#define PERFETTO_EVENT_TRACK_UUID 11
+#define PERFETTO_EVENT_CATEGORIES 22
+#define PERFETTO_EVENT_NAME 23
+
+#define PERFETTO_ANNOTATION_STRING_VALUE 6
+#define PERFETTO_ANNOTATION_NAME 10
+
+#define PERFETTO_EVENT_TYPE_SLICE_BEGIN 1
+#define PERFETTO_EVENT_TYPE_SLICE_END 2
+
+#define PERFETTO_SEQUENCE_ID 1
+#define PERFETTO_SEQUENCE_INCREMENTAL_STATE_CLEARED 1
+
+#define PERFETTO_PROCESS_TRACK_UUID 1
+#define PERFETTO_FRAME_TRACK_UUID 2
+#define PERFETTO_THREAD_TRACK_UUID(ThreadIndex) (16 + (ThreadIndex))
+
+#define PROTO_WIRE_TYPE_VARINT 0
+#define PROTO_WIRE_TYPE_LENGTH_DELIMITED 2
+
+// Nested message sizes are written as padded 4-byte varints, so the size can be patched once the message is written
+#define PROTO_MESSAGE_SIZE_BYTES 4
+
+inline void
+WriteProtoVarint(memory_arena *Arena, u64 Value)
+{
+    u8 Bytes[10];
+    u32 ByteCount = 0;
+
+    do
+    {
+        u8 Byte = (u8) (Value & 0x7F);
+        Value >>= 7;
+
+        if (Value)
+        {
+            Byte |= 0x80;
+        }
+
+        Bytes[ByteCount++] = Byte;
+    }
+    while (Value);
+
+    AppendTraceBytes(Arena, Bytes, ByteCount);
+}
+
+inline void
+WriteProtoTag(memory_arena *Arena, u32 Field, u32 WireType)
+{
+    WriteProtoVarint(Arena, (Field << 3) | WireType);
+}
+
+inline void
+WriteProtoUInt(memory_arena *Arena, u32 Field, u64 Value)
+{
+    WriteProtoTag(Arena, Field, PROTO_WIRE_TYPE_VARINT);
+    WriteProtoVarint(Arena, Value);
+}
+
+inline void
+WriteProtoString(memory_arena *Arena, u32 Field, const char *String)
+{
+    u32 Length = StringLength(String);
+
+    WriteProtoTag(Arena, Field, PROTO_WIRE_TYPE_LENGTH_DELIMITED);
+    WriteProtoVarint(Arena, Length);
+    AppendTraceBytes(Arena, String, Length);
+}
+
+inline u8 *
+BeginProtoMessage(memory_arena *Arena, u32 Field)
+{
+    WriteProtoTag(Arena, Field, PROTO_WIRE_TYPE_LENGTH_DELIMITED);
+
+    u8 *Result = (u8 *) PushSize(Arena, PROTO_MESSAGE_SIZE_BYTES, AlignNoClear(1));
+    return Result;
+}
+
+inline void
+EndProtoMessage(memory_arena *Arena, u8 *MessageSize)
+{
+    umm Size = ((u8 *) Arena->Base + Arena->Used) - (MessageSize + PROTO_MESSAGE_SIZE_BYTES);
+
+    Assert(Size < (1 << (7 * PROTO_MESSAGE_SIZE_BYTES)));
+
+    for (u32 ByteIndex = 0; ByteIndex < PROTO_MESSAGE_SIZE_BYTES; ++ByteIndex)
+    {
+        u8 Byte = (u8) ((Size >> (7 * ByteIndex)) & 0x7F);
+
+        if (ByteIndex < PROTO_MESSAGE_SIZE_BYTES - 1)
+        {
+            Byte |= 0x80;
+        }
+
+        MessageSize[ByteIndex] = Byte;
+    }
+}
+
+inline u8 *
+BeginPerfettoPacket(memory_arena *Arena)
+{
+    u8 *Result = BeginProtoMessage(Arena, PERFETTO_TRACE_PACKET);
+    WriteProtoUInt(Arena, PERFETTO_PACKET_SEQUENCE_ID, PERFETTO_SEQUENCE_ID);
+    return Result;
+}
+
+dummy_internal void
+WritePerfettoSlice(memory_arena *Arena, u64 Timestamp, u64 TrackUuid, bool32 Begin, const char *Name, const char *Category, const char *Stage, const char *Worker)
+{
+    u8 *Packet = BeginPerfettoPacket(Arena);
+    WriteProtoUInt(Arena, PERFETTO_PACKET_TIMESTAMP, Timestamp);
+
+    u8 *TrackEvent = BeginProtoMessage(Arena, PERFETTO_PACKET_TRACK_EVENT);
+    WriteProtoUInt(Arena, PERFETTO_EVENT_TYPE, Begin ? PERFETTO_EVENT_TYPE_SLICE_BEGIN : PERFETTO_EVENT_TYPE_SLICE_END);
+    WriteProtoUInt(Arena, PERFETTO_EVENT_TRACK_UUID, TrackUuid);
+
+    if (Begin)
+    {
+        WriteProtoString(Arena, PERFETTO_EVENT_CATEGORIES, Category);
+        WriteProtoString(Arena, PERFETTO_EVENT_NAME, Name);
+
+        if (Stage)
+        {
+            u8 *StageAnnotation = BeginProtoMessage(Arena, PERFETTO_EVENT_DEBUG_ANNOTATIONS);
+            WriteProtoString(Arena, PERFETTO_ANNOTATION_NAME, "stage");
+            WriteProtoString(Arena, PERFETTO_ANNOTATION_STRING_VALUE, Stage);
+            EndProtoMessage(Arena, StageAnnotation);
+
+            u8 *WorkerAnnotation = BeginProtoMessage(Arena, PERFETTO_EVENT_DEBUG_ANNOTATIONS);
+            WriteProtoString(Arena, PERFETTO_ANNOTATION_NAME, "worker");
+            WriteProtoString(Arena, PERFETTO_ANNOTATION_STRING_VALUE, Worker);
+            EndProtoMessage(Arena, WorkerAnnotation);
+        }
+    }
+
+    EndProtoMessage(Arena, TrackEvent);
+    EndProtoMessage(Arena, Packet);
+}
+
+// Track descriptors first, then the slices; the viewer sorts the packets by the timestamp
+dummy_internal void
+WritePerfettoTrace(platform_profiler *Profiler, memory_arena *Arena)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+    u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+    {
+        u8 *Packet = BeginPerfettoPacket(Arena);
+        WriteProtoUInt(Arena, PERFETTO_PACKET_SEQUENCE_FLAGS, PERFETTO_SEQUENCE_INCREMENTAL_STATE_CLEARED);
+
+        u8 *Track = BeginProtoMessage(Arena, PERFETTO_PACKET_TRACK_DESCRIPTOR);
+        WriteProtoUInt(Arena, PERFETTO_TRACK_UUID, PERFETTO_PROCESS_TRACK_UUID);
+
+        u8 *Process = BeginProtoMessage(Arena, PERFETTO_TRACK_PROCESS);
+        WriteProtoUInt(Arena, PERFETTO_PROCESS_PID, PROFILER_TRACE_PROCESS_ID);
+        WriteProtoString(Arena, PERFETTO_PROCESS_NAME, PROFILER_TRACE_PROCESS_NAME);
+        EndProtoMessage(Arena, Process);
+
+        EndProtoMessage(Arena, Track);
+        EndProtoMessage(Arena, Packet);
+    }
+
+    {
+        u8 *Packet = BeginPerfettoPacket(Arena);
+
+        u8 *Track = BeginProtoMessage(Arena, PERFETTO_PACKET_TRACK_DESCRIPTOR);
+        WriteProtoUInt(Arena, PERFETTO_TRACK_UUID, PERFETTO_FRAME_TRACK_UUID);
+        WriteProtoUInt(Arena, PERFETTO_TRACK_PARENT_UUID, PERFETTO_PROCESS_TRACK_UUID);
+        WriteProtoString(Arena, PERFETTO_TRACK_NAME, "Frames");
+        EndProtoMessage(Arena, Track);
+
+        EndProtoMessage(Arena, Packet);
+    }
+
+    for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+        u8 *Packet = BeginPerfettoPacket(Arena);
+
+        u8 *Track = BeginProtoMessage(Arena, PERFETTO_PACKET_TRACK_DESCRIPTOR);
+        WriteProtoUInt(Arena, PERFETTO_TRACK_UUID, PERFETTO_THREAD_TRACK_UUID(ThreadIndex));
+
+        u8 *ThreadDescriptor = BeginProtoMessage(Arena, PERFETTO_TRACK_THREAD);
+        WriteProtoUInt(Arena, PERFETTO_THREAD_PID, PROFILER_TRACE_PROCESS_ID);
+        WriteProtoUInt(Arena, PERFETTO_THREAD_TID, Thread->ThreadId);
+        WriteProtoString(Arena, PERFETTO_THREAD_NAME, Thread->Name);
+        EndProtoMessage(Arena, ThreadDescriptor);
+
+        EndProtoMessage(Arena, Track);
+        EndProtoMessage(Arena, Packet);
+    }
+
+    for (u32 FrameIndex = 0; FrameIndex < Trace->FrameCount; ++FrameIndex)
+    {
+        char FrameName[32];
+        FormatString(FrameName, "Frame %u", FrameIndex);
+
+        u64 Start = GetTraceNanoseconds(Profiler, Trace->FrameTimestamps[FrameIndex]);
+        u64 End = GetTraceNanoseconds(Profiler, Trace->FrameTimestamps[FrameIndex + 1]);
+
+        WritePerfettoSlice(Arena, Start, PERFETTO_FRAME_TRACK_UUID, true, FrameName, "frame", 0, 0);
+        WritePerfettoSlice(Arena, End, PERFETTO_FRAME_TRACK_UUID, false, FrameName, "frame", 0, 0);
+    }
+
+    for (u32 EventIndex = 0; EventIndex < Trace->EventCount; ++EventIndex)
+    {
+        profiler_trace_event *Event = Trace->Events + EventIndex;
+        profiler_thread *Thread = Profiler->Threads + Event->ThreadIndex;
+
+        bool32 Job = Event->StageNameIndex != PROFILER_NO_NODE;
+        const char *Stage = Job ? GetProfilerName(Profiler, Event->StageNameIndex) : 0;
+
+        WritePerfettoSlice(
+            Arena,
+            GetTraceNanoseconds(Profiler, Event->Timestamp),
+            PERFETTO_THREAD_TRACK_UUID(Event->ThreadIndex),
+            Event->Begin,
+            GetProfilerName(Profiler, Event->NameIndex),
+            Job ? "job" : "scope",
+            Stage,
+            Thread->Name
+        );
+    }
+}
+
+//
+// Call tree CSV
+//
+
+dummy_internal void
+WriteProfilerNodeCSV(platform_profiler *Profiler, profiler_frame_samples *Frame, u32 NodeIndex, char *ParentPath, memory_arena *Arena)
+{
+    profiler_node *Node = Frame->Nodes + NodeIndex;
+    profiler_thread *Thread = Profiler->Threads + Node->ThreadIndex;
+
+    char Path[256];
+    FormatString(Path, "%s/%s", ParentPath, GetProfilerName(Profiler, Node->NameIndex));
+
+    u64 *Counters = Node->Counters;
+
+    AppendTraceText(
+        Arena,
+        "%s,%s,%u,%u,%.4f",
+        Thread->Name,
+        Path,
+        Node->Depth,
+        Node->CallCount,
+        GetProfilerMilliseconds(Profiler, Node->ElapsedTicks)
+    );
+
+    // Counters the platform can't read are left empty, so they don't read as 0
+    for (u32 CounterIndex = 0; CounterIndex < ProfilerCounter_Count; ++CounterIndex)
+    {
+        if (IsProfilerCounterAvailable(Profiler, (profiler_counter) CounterIndex))
+        {
+            AppendTraceText(Arena, ",%llu", Counters[CounterIndex]);
+        }
+        else
+        {
+            AppendTraceText(Arena, ",");
+        }
+    }
+
+    bool32 HasInstructions = IsProfilerCounterAvailable(Profiler, ProfilerCounter_Instructions);
+
+    if (HasInstructions && IsProfilerCounterAvailable(Profiler, ProfilerCounter_Cycles))
+    {
+        AppendTraceText(Arena, ",%.3f", GetProfilerIPC(Counters));
+    }
+    else
+    {
+        AppendTraceText(Arena, ",");
+    }
+
+    profiler_counter MissCounters[] = { ProfilerCounter_L1DataMisses, ProfilerCounter_LastLevelCacheMisses, ProfilerCounter_BranchMisses };
+
+    for (u32 MissIndex = 0; MissIndex < ArrayCount(MissCounters); ++MissIndex)
+    {
+        if (HasInstructions && IsProfilerCounterAvailable(Profiler, MissCounters[MissIndex]))
+        {
+            AppendTraceText(Arena, ",%.3f", GetProfilerMPKI(Counters, MissCounters[MissIndex]));
+        }
+        else
+        {
+            AppendTraceText(Arena, ",");
+        }
+    }
+
+    AppendTraceText(Arena, "\n");
+
+    for (u32 ChildIndex = Node->FirstChildIndex; ChildIndex != PROFILER_NO_NODE; ChildIndex = Frame->Nodes[ChildIndex].NextSiblingIndex)
+    {
+        WriteProfilerNodeCSV(Profiler, Frame, ChildIndex, Path, Arena);
+    }
+}
+
+// Counter columns are empty when the platform doesn't read them (see platform_profiler::AvailableCounters)
+dummy_internal void
+WriteProfilerFrameCSV(platform_profiler *Profiler, profiler_frame_samples *Frame, memory_arena *Arena)
+{
+    AppendTraceText(
+        Arena,
+        "thread,scope,depth,calls,total_ms,cycles,instructions,l1d_misses,llc_misses,branch_misses,ipc,l1d_mpki,llc_mpki,branch_mpki\n"
+    );
+
+    for (u32 NodeIndex = Frame->FirstRootIndex; NodeIndex != PROFILER_NO_NODE; NodeIndex = Frame->Nodes[NodeIndex].NextSiblingIndex)
+    {
+        WriteProfilerNodeCSV(Profiler, Frame, NodeIndex, (char *) "", Arena);
+    }
+}
+
+//
+// Memory telemetry CSV
+//
+
+dummy_internal void
+WriteMemoryTelemetryCSV(platform_profiler *Profiler, memory_arena *Arena)
+{
+    AppendTraceText(
+        Arena,
+        "kind,name,line,used,high_water,committed,size,frame_count,frame_bytes,peak_frame_count,peak_frame_bytes,total_count,total_bytes\n"
+    );
+
+    profiler_frame_samples *FrameSamples = ProfilerGetPreviousFrameSamples(Profiler);
+
+    for (u32 SampleIndex = 0; SampleIndex < FrameSamples->MemorySampleCount; ++SampleIndex)
+    {
+        profiler_memory_sample *Sample = FrameSamples->MemorySamples + SampleIndex;
+        memory_stats *Stats = &Sample->Stats;
+
+        AppendTraceText(
+            Arena,
+            "allocator,%s,,%llu,%llu,%llu,%llu,%u,%llu,,,%u,\n",
+            Sample->Name,
+            (u64) Stats->Used,
+            (u64) Stats->HighWater,
+            (u64) Stats->Committed,
+            (u64) Stats->Size,
+            Stats->FrameAllocationCount,
+            (u64) Stats->FrameAllocatedSize,
+            Stats->AllocationCount
+        );
+    }
+
+#if MEMORY_TELEMETRY
+    memory_telemetry *Telemetry = Profiler->MemoryTelemetry;
+
+    if (Telemetry)
+    {
+        for (u32 CallSiteIndex = 0; CallSiteIndex < ArrayCount(Telemetry->CallSites); ++CallSiteIndex)
+        {
+            memory_call_site *CallSite = Telemetry->CallSites + CallSiteIndex;
+
+            if (CallSite->State == MemoryCallSite_Ready)
+            {
+                AppendTraceText(
+                    Arena,
+                    "%s,%s,%u,,,,,%u,%llu,%u,%llu,%llu,%llu\n",
+                    CallSite->Region ? "region" : "push",
+                    CallSite->FileName,
+                    CallSite->Line,
+                    CallSite->LastFrameCount,
+                    CallSite->LastFrameSize,
+                    CallSite->PeakFrameCount,
+                    CallSite->PeakFrameSize,
+                    CallSite->TotalCount,
+                    CallSite->TotalSize
+                );
+            }
+        }
+    }
+#endif
+}
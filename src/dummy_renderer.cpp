@@ -10,6 +10,7 @@ PushRenderCommand_(render_commands *Commands, u32 Size, render_command_type Type
     Result->Size = Size;
 
     Commands->RenderCommandsBufferSize += Size;
+    ++Commands->RenderCommandCount;
 
     return Result;
 }
@@ -28,6 +29,7 @@ AddMesh(
     vec2 *TextureCoords,
     vec4 *Weights,
     ivec4 *JointIndices,
+    quantized_mesh_vertices *QuantizedVertices,
     u32 IndexCount,
     u32 *Indices
 )
@@ -37,11 +39,12 @@ AddMesh(
     Command->VertexCount = VertexCount;
     Command->Positions = Positions;
     Command->Normals = Normals;
-    Command->Tangents = Bitangents;
+    Command->Tangents = Tangents;
     Command->Bitangents = Bitangents;
     Command->TextureCoords = TextureCoords;
     Command->Weights = Weights;
     Command->JointIndices = JointIndices;
+    Command->QuantizedVertices = QuantizedVertices;
     Command->IndexCount = IndexCount;
     Command->Indices = Indices;
 }
@@ -56,6 +59,20 @@ AddTexture(render_commands *Commands, u32 Id, bitmap *Bitmap)
     Command->Bitmap = Bitmap;
 }
 
+inline void
+RemoveMesh(render_commands *Commands, u32 MeshId)
+{
+    render_command_remove_mesh *Command = PushRenderCommand(Commands, render_command_remove_mesh, RenderCommand_RemoveMesh);
+    Command->MeshId = MeshId;
+}
+
+inline void
+RemoveTexture(render_commands *Commands, u32 Id)
+{
+    render_command_remove_texture *Command = PushRenderCommand(Commands, render_command_remove_texture, RenderCommand_RemoveTexture);
+    Command->Id = Id;
+}
+
 inline void
 AddSkinningBuffer(render_commands *Commands, u32 SkinningBufferId, u32 SkinningMatrixCount)
 {
@@ -65,6 +82,80 @@ AddSkinningBuffer(render_commands *Commands, u32 SkinningBufferId, u32 SkinningM
     Command->SkinningMatrixCount = SkinningMatrixCount;
 }
 
+inline void
+AddInstanceBuffer(render_commands *Commands, u32 InstanceBufferId, u32 MaxInstanceCount)
+{
+    render_command_add_instance_buffer *Command = PushRenderCommand(Commands, render_command_add_instance_buffer, RenderCommand_AddInstanceBuffer);
+
+    Command->InstanceBufferId = InstanceBufferId;
+    Command->MaxInstanceCount = MaxInstanceCount;
+}
+
+inline void
+UpdateInstanceBuffer(render_commands *Commands, u32 InstanceBufferId, u32 StartInstance, u32 InstanceCount, mesh_instance *Instances)
+{
+    render_command_update_instance_buffer *Command = PushRenderCommand(Commands, render_command_update_instance_buffer, RenderCommand_UpdateInstanceBuffer);
+
+    Command->InstanceBufferId = InstanceBufferId;
+    Command->StartInstance = StartInstance;
+    Command->InstanceCount = InstanceCount;
+    Command->Instances = Instances;
+}
+
+inline mesh_instance
+EncodeMeshInstance(transform Transform, vec3 Color)
+{
+    mesh_instance Result = {};
+
+    quat Rotation = Normalize(Transform.Rotation);
+
+    // q and -q are the same rotation, keeping w positive
+    if (Rotation.w < 0.f)
+    {
+        Rotation = -Rotation;
+    }
+
+    Result.Position = Transform.Translation;
+    Result.Color = PackUnorm4x8(vec4(Color, 1.f));
+
+    Result.Rotation[0] = PackSnorm16(Rotation.x);
+    Result.Rotation[1] = PackSnorm16(Rotation.y);
+    Result.Rotation[2] = PackSnorm16(Rotation.z);
+    Result.Rotation[3] = PackSnorm16(Rotation.w);
+
+    Result.Scale[0] = PackHalf(Transform.Scale.x);
+    Result.Scale[1] = PackHalf(Transform.Scale.y);
+    Result.Scale[2] = PackHalf(Transform.Scale.z);
+    Result.Scale[3] = 0;
+
+    return Result;
+}
+
+// Has to match decoding in mesh_instanced.vert
+inline transform
+DecodeMeshInstance(mesh_instance *Instance, vec3 *Color = 0)
+{
+    transform Result = {};
+
+    quat Rotation = quat(
+        UnpackSnorm16(Instance->Rotation[0]),
+        UnpackSnorm16(Instance->Rotation[1]),
+        UnpackSnorm16(Instance->Rotation[2]),
+        UnpackSnorm16(Instance->Rotation[3])
+    );
+
+    Result.Translation = Instance->Position;
+    Result.Rotation = Normalize(Rotation);
+    Result.Scale = vec3(UnpackHalf(Instance->Scale[0]), UnpackHalf(Instance->Scale[1]), UnpackHalf(Instance->Scale[2]));
+
+    if (Color)
+    {
+        *Color = UnpackUnorm4x8(Instance->Color).rgb;
+    }
+
+    return Result;
+}
+
 inline void
 SetViewport(render_commands *Commands, u32 x, u32 y, u32 Width, u32 Height)
 {
@@ -197,30 +288,67 @@ inline void
 DrawMesh(
     render_commands *Commands, 
     u32 MeshId,
+    u32 IndexOffset,
+    u32 IndexCount,
     transform Transform,
     material Material
 )
 {
     render_command_draw_mesh *Command = PushRenderCommand(Commands, render_command_draw_mesh, RenderCommand_DrawMesh);
     Command->MeshId = MeshId;
+    Command->IndexOffset = IndexOffset;
+    Command->IndexCount = IndexCount;
     Command->Transform = Transform;
     Command->Material = Material;
+    Command->IndexRangeCount = 0;
+    Command->IndexRangeOffsets = 0;
+    Command->IndexRangeCounts = 0;
+}
+
+inline void
+DrawMeshClusters(
+    render_commands *Commands,
+    u32 MeshId,
+    u32 IndexOffset,
+    u32 IndexCount,
+    u32 IndexRangeCount,
+    u32 *IndexRangeOffsets,
+    u32 *IndexRangeCounts,
+    transform Transform,
+    material Material
+)
+{
+    render_command_draw_mesh *Command = PushRenderCommand(Commands, render_command_draw_mesh, RenderCommand_DrawMesh);
+    Command->MeshId = MeshId;
+    Command->IndexOffset = IndexOffset;
+    Command->IndexCount = IndexCount;
+    Command->Transform = Transform;
+    Command->Material = Material;
+    Command->IndexRangeCount = IndexRangeCount;
+    Command->IndexRangeOffsets = IndexRangeOffsets;
+    Command->IndexRangeCounts = IndexRangeCounts;
 }
 
 inline void
 DrawMeshInstanced(
     render_commands *Commands,
     u32 MeshId,
+    u32 IndexOffset,
+    u32 IndexCount,
+    u32 InstanceBufferId,
     u32 InstanceCount,
-    mesh_instance *Instances,
+    u32 *InstanceIndices,
     material Material
 )
 {
     render_command_draw_mesh_instanced *Command =
         PushRenderCommand(Commands, render_command_draw_mesh_instanced, RenderCommand_DrawMeshInstanced);
     Command->MeshId = MeshId;
+    Command->IndexOffset = IndexOffset;
+    Command->IndexCount = IndexCount;
+    Command->InstanceBufferId = InstanceBufferId;
     Command->InstanceCount = InstanceCount;
-    Command->Instances = Instances;
+    Command->InstanceIndices = InstanceIndices;
     Command->Material = Material;
 }
 
@@ -228,6 +356,8 @@ inline void
 DrawSkinnedMesh(
     render_commands *Commands,
     u32 MeshId,
+    u32 IndexOffset,
+    u32 IndexCount,
     material Material,
     u32 SkinningBufferId,
     u32 SkinningMatrixCount,
@@ -237,6 +367,8 @@ DrawSkinnedMesh(
     render_command_draw_skinned_mesh *Command = 
         PushRenderCommand(Commands, render_command_draw_skinned_mesh, RenderCommand_DrawSkinnedMesh);
     Command->MeshId = MeshId;
+    Command->IndexOffset = IndexOffset;
+    Command->IndexCount = IndexCount;
     Command->Material = Material;
     Command->SkinningBufferId = SkinningBufferId;
     Command->SkinningMatrixCount = SkinningMatrixCount;
@@ -247,6 +379,8 @@ inline void
 DrawSkinnedMeshInstanced(
     render_commands *Commands,
     u32 MeshId,
+    u32 IndexOffset,
+    u32 IndexCount,
     material Material,
     u32 SkinningBufferId,
     u32 InstanceCount,
@@ -256,6 +390,8 @@ DrawSkinnedMeshInstanced(
     render_command_draw_skinned_mesh_instanced *Command =
         PushRenderCommand(Commands, render_command_draw_skinned_mesh_instanced, RenderCommand_DrawSkinnedMeshInstanced);
     Command->MeshId = MeshId;
+    Command->IndexOffset = IndexOffset;
+    Command->IndexCount = IndexCount;
     Command->Material = Material;
     Command->SkinningBufferId = SkinningBufferId;
     Command->InstanceCount = InstanceCount;
@@ -328,6 +464,18 @@ SetPointLights(render_commands *Commands, u32 PointLightCount, point_light *Poin
     Command->PointLights = PointLights;
 }
 
+inline void
+SetLightClusters(render_commands *Commands, f32 Near, f32 Far, light_cluster *Clusters, u32 LightIndexCount, u32 *LightIndices)
+{
+    render_command_set_light_clusters *Command =
+        PushRenderCommand(Commands, render_command_set_light_clusters, RenderCommand_SetLightClusters);
+    Command->Near = Near;
+    Command->Far = Far;
+    Command->Clusters = Clusters;
+    Command->LightIndexCount = LightIndexCount;
+    Command->LightIndices = LightIndices;
+}
+
 inline void
 AddSkybox(render_commands *Commands, u32 SkyboxId, u32 EnvMapSize, texture *EquirectEnvMap)
 {
@@ -14,6 +14,8 @@ struct material_options
 {
     bool32 Wireframe;
     bool32 CastShadow;
+    // Only drawn into the shadow maps (e.g. occluded shadow casters)
+    bool32 ShadowOnly;
 };
 
 struct material
@@ -45,6 +47,18 @@ struct point_light
     light_attenuation Attenuation;
 };
 
+#define LIGHT_CLUSTER_COUNT_X 16
+#define LIGHT_CLUSTER_COUNT_Y 9
+#define LIGHT_CLUSTER_COUNT_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y * LIGHT_CLUSTER_COUNT_Z)
+
+// Range of the cluster's point lights in the light index list
+struct light_cluster
+{
+    u32 Offset;
+    u32 Count;
+};
+
 struct spot_light
 {
     vec3 Position;
@@ -57,6 +71,20 @@ struct spot_light
     light_attenuation Attenuation;
 };
 
+// Compact per-instance data (see EncodeMeshInstance), decoded in mesh_instanced.vert
+struct mesh_instance
+{
+    vec3 Position;
+    // RGBA8
+    u32 Color;
+    // snorm16 quaternion
+    i16 Rotation[4];
+    // half-precision scale, w is unused
+    u16 Scale[4];
+};
+
+CTAssert(sizeof(mesh_instance) == 32);
+
 struct skinning_data
 {
     skeleton_pose *BindPose;
@@ -76,14 +104,21 @@ enum render_command_type
     RenderCommand_AddMesh,
     RenderCommand_AddTexture,
     RenderCommand_AddSkinningBuffer,
+    RenderCommand_AddInstanceBuffer,
     RenderCommand_AddSkybox,
 
+    RenderCommand_RemoveMesh,
+    RenderCommand_RemoveTexture,
+
+    RenderCommand_UpdateInstanceBuffer,
+
     RenderCommand_SetViewport,
     RenderCommand_SetScreenProjection,
     RenderCommand_SetViewProjection,
     RenderCommand_SetTime,
     RenderCommand_SetDirectionalLight,
     RenderCommand_SetPointLights,
+    RenderCommand_SetLightClusters,
     RenderCommand_SetSkybox,
 
     RenderCommand_Clear,
@@ -110,14 +145,21 @@ const char *RenderCommandNames[] =
     "AddMesh",
     "AddTexture",
     "AddSkinningBuffer",
+    "AddInstanceBuffer",
     "AddSkybox",
 
+    "RemoveMesh",
+    "RemoveTexture",
+
+    "UpdateInstanceBuffer",
+
     "SetViewport",
     "SetScreenProjection",
     "SetViewProjection",
     "SetTime",
     "SetDirectionalLight",
     "SetPointLights",
+    "SetLightClusters",
     "SetSkybox",
 
     "Clear",
@@ -161,6 +203,9 @@ struct render_command_add_mesh
     vec4 *Weights;
     ivec4 *JointIndices;
 
+    // Set for quantized meshes instead of the float streams, which are quantized on upload otherwise
+    quantized_mesh_vertices *QuantizedVertices;
+
     u32 IndexCount;
     u32 *Indices;
 };
@@ -174,6 +219,21 @@ struct render_command_add_texture
     // todo: filtering, wrapping, mipmapping...
 };
 
+// Id can be added again later (evicted assets keep their ids)
+struct render_command_remove_mesh
+{
+    render_command_header Header;
+
+    u32 MeshId;
+};
+
+struct render_command_remove_texture
+{
+    render_command_header Header;
+
+    u32 Id;
+};
+
 struct render_command_add_skinning_buffer
 {
     render_command_header Header;
@@ -182,6 +242,24 @@ struct render_command_add_skinning_buffer
     u32 SkinningMatrixCount;
 };
 
+struct render_command_add_instance_buffer
+{
+    render_command_header Header;
+
+    u32 InstanceBufferId;
+    u32 MaxInstanceCount;
+};
+
+struct render_command_update_instance_buffer
+{
+    render_command_header Header;
+
+    u32 InstanceBufferId;
+    u32 StartInstance;
+    u32 InstanceCount;
+    mesh_instance *Instances;
+};
+
 struct render_command_set_viewport
 {
     render_command_header Header;
@@ -223,6 +301,21 @@ struct render_command_set_point_lights
     point_light *PointLights;
 };
 
+struct render_command_set_light_clusters
+{
+    render_command_header Header;
+
+    // View-space depth range of the cluster grid
+    f32 Near;
+    f32 Far;
+
+    // LIGHT_CLUSTER_COUNT clusters, x changes fastest
+    light_cluster *Clusters;
+
+    u32 LightIndexCount;
+    u32 *LightIndices;
+};
+
 struct render_command_set_time
 {
     render_command_header Header;
@@ -299,14 +392,17 @@ struct render_command_draw_mesh
 
     u32 MeshId;
 
+    // Range of the index buffer to draw (mesh LOD)
+    u32 IndexOffset;
+    u32 IndexCount;
+
     transform Transform;
     material Material;
-};
 
-struct mesh_instance
-{
-    mat4 Model;
-    vec3 Color;
+    // Visible clusters of the mesh, the whole range above is used in shadow passes or when there are none
+    u32 IndexRangeCount;
+    u32 *IndexRangeOffsets;
+    u32 *IndexRangeCounts;
 };
 
 struct render_command_draw_mesh_instanced
@@ -314,10 +410,16 @@ struct render_command_draw_mesh_instanced
     render_command_header Header;
 
     u32 MeshId;
+
+    // Range of the index buffer to draw (mesh LOD)
+    u32 IndexOffset;
+    u32 IndexCount;
     material Material;
 
+    // Indices of the visible instances in the instance buffer
+    u32 InstanceBufferId;
     u32 InstanceCount;
-    mesh_instance *Instances;
+    u32 *InstanceIndices;
 };
 
 struct render_command_draw_skinned_mesh
@@ -325,6 +427,10 @@ struct render_command_draw_skinned_mesh
     render_command_header Header;
 
     u32 MeshId;
+
+    // Range of the index buffer to draw (mesh LOD)
+    u32 IndexOffset;
+    u32 IndexCount;
     material Material;
 
     u32 SkinningBufferId;
@@ -343,6 +449,10 @@ struct render_command_draw_skinned_mesh_instanced
     render_command_header Header;
 
     u32 MeshId;
+
+    // Range of the index buffer to draw (mesh LOD)
+    u32 IndexOffset;
+    u32 IndexCount;
     material Material;
     u32 SkinningBufferId;
     u32 InstanceCount;
@@ -431,5 +541,26 @@ struct render_commands
     u32 RenderCommandsBufferSize;
     void *RenderCommandsBuffer;
 
+    // Buffer usage of the last processed frame, kept by ClearRenderCommands
+    u32 RenderCommandCount;
+    u32 PrevRenderCommandCount;
+    u32 PrevRenderCommandsBufferSize;
+    u32 HighWaterRenderCommandsBufferSize;
+
     render_commands_settings Settings;
 };
+
+inline memory_stats
+GetMemoryStats(render_commands *Commands)
+{
+    memory_stats Result = {};
+
+    Result.Used = Commands->PrevRenderCommandsBufferSize;
+    Result.HighWater = Commands->HighWaterRenderCommandsBufferSize;
+    Result.Committed = Commands->MaxRenderCommandsBufferSize;
+    Result.Size = Commands->MaxRenderCommandsBufferSize;
+    Result.FrameAllocationCount = Commands->PrevRenderCommandCount;
+    Result.FrameAllocatedSize = Commands->PrevRenderCommandsBufferSize;
+
+    return Result;
+}
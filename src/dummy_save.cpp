@@ -61,3 +61,278 @@ AudioSource2Spec(audio_source *AudioSource, audio_source_spec *Spec)
     Spec->MinDistance = AudioSource->MinDistance;
     Spec->MaxDistance = AudioSource->MaxDistance;
 }
+
+// Sequential writes into a buffer that is allocated up front
+struct binary_writer
+{
+    u8 *Base;
+    umm Size;
+    umm Used;
+};
+
+inline binary_writer
+CreateBinaryWriter(memory_arena *Arena, umm Size)
+{
+    binary_writer Result = {};
+
+    Result.Base = (u8 *)PushSize(Arena, Size, NoClear());
+    Result.Size = Size;
+
+    return Result;
+}
+
+inline void
+WriteBytes(binary_writer *Writer, void *Data, umm Size)
+{
+    Assert(Writer->Used + Size <= Writer->Size);
+
+    CopyMemory(Data, Writer->Base + Writer->Used, Size);
+    Writer->Used += Size;
+}
+
+#define WriteValue(Writer, Value) WriteBytes(Writer, &(Value), sizeof(Value))
+
+inline void *
+ReadBytes(u8 **At, umm Size)
+{
+    void *Result = *At;
+    *At += Size;
+
+    return Result;
+}
+
+#define ReadValue(At, Type) (*(Type *)ReadBytes(At, sizeof(Type)))
+
+struct string_table_slot
+{
+    u32 Key;
+    u32 Offset;
+};
+
+// Identical names and asset references are stored once
+struct string_table_builder
+{
+    binary_writer Strings;
+    hash_table<string_table_slot> Slots;
+};
+
+inline void
+InitStringTableBuilder(string_table_builder *Builder, u32 MaxStringCount, umm MaxSize, memory_arena *Arena)
+{
+    Builder->Strings = CreateBinaryWriter(Arena, MaxSize);
+
+    // Keeps the load factor low, so the probe sequences stay short
+    u32 SlotCount = MaxStringCount * 8 + 1;
+
+    while (!IsPrime(SlotCount))
+    {
+        ++SlotCount;
+    }
+
+    InitHashTable(&Builder->Slots, SlotCount, Arena);
+}
+
+dummy_internal u32
+AddString(string_table_builder *Builder, char *String)
+{
+    u32 Key = (u32)Hash(String);
+
+    if (Key == EMPTY_SLOT_KEY_U32)
+    {
+        Key = 1;
+    }
+
+    string_table_slot *Slot = HashTableLookup(&Builder->Slots, Key);
+
+    u32 Result;
+
+    // Strings with colliding hashes are just stored again
+    if (!IsSlotEmpty(Slot->Key) && StringEquals((char *)Builder->Strings.Base + Slot->Offset, String))
+    {
+        Result = Slot->Offset;
+    }
+    else
+    {
+        Result = (u32)Builder->Strings.Used;
+        WriteBytes(&Builder->Strings, String, StringLength(String) + 1);
+
+        if (IsSlotEmpty(Slot->Key))
+        {
+            Slot->Key = Key;
+            Slot->Offset = Result;
+        }
+    }
+
+    return Result;
+}
+
+// Appends the entity to the sections of its chunk
+dummy_internal void
+WriteWorldEntityRecord(game_entity_spec *Spec, string_table_builder *StringTable, binary_writer *Sections)
+{
+    world_entity_record Record = {};
+    Record.Name = AddString(StringTable, Spec->Name);
+    Record.Translation = Spec->Transform.Translation;
+
+    if (Spec->Transform.Rotation != quat::identity()) Record.Flags |= WorldEntity_Rotation;
+    if (Spec->Transform.Scale != vec3(1.f)) Record.Flags |= WorldEntity_Scale;
+    if (Spec->DebugColor != vec3(1.f)) Record.Flags |= WorldEntity_DebugColor;
+    if (Spec->ModelSpec.Has) Record.Flags |= WorldEntity_Model;
+    if (Spec->ColliderSpec.Has) Record.Flags |= WorldEntity_Collider;
+    if (Spec->RigidBodySpec.Has) Record.Flags |= WorldEntity_RigidBody;
+    if (Spec->PointLightSpec.Has) Record.Flags |= WorldEntity_PointLight;
+    if (Spec->ParticleEmitterSpec.Has) Record.Flags |= WorldEntity_ParticleEmitter;
+    if (Spec->AudioSourceSpec.Has) Record.Flags |= WorldEntity_AudioSource;
+
+    binary_writer *Entities = Sections + WorldAreaSection_Entities;
+
+    WriteValue(Entities, Record);
+
+    if (Record.Flags & WorldEntity_Rotation)
+    {
+        WriteValue(Entities, Spec->Transform.Rotation);
+    }
+
+    if (Record.Flags & WorldEntity_Scale)
+    {
+        WriteValue(Entities, Spec->Transform.Scale);
+    }
+
+    if (Record.Flags & WorldEntity_DebugColor)
+    {
+        WriteValue(Entities, Spec->DebugColor);
+    }
+
+    if (Record.Flags & WorldEntity_Model)
+    {
+        world_model_record Model = {};
+        Model.ModelRef = AddString(StringTable, Spec->ModelSpec.ModelRef);
+
+        WriteValue(Sections + WorldAreaSection_Models, Model);
+    }
+
+    if (Record.Flags & WorldEntity_Collider)
+    {
+        world_collider_record Collider = {};
+        Collider.Type = Spec->ColliderSpec.Type;
+        Collider.HalfSize = Spec->ColliderSpec.Box.HalfSize;
+        Collider.Offset = Spec->ColliderSpec.Box.Offset;
+
+        WriteValue(Sections + WorldAreaSection_Colliders, Collider);
+    }
+
+    if (Record.Flags & WorldEntity_PointLight)
+    {
+        world_point_light_record PointLight = {};
+        PointLight.Color = Spec->PointLightSpec.Color;
+        PointLight.Attenuation = Spec->PointLightSpec.Attenuation;
+
+        WriteValue(Sections + WorldAreaSection_PointLights, PointLight);
+    }
+
+    if (Record.Flags & WorldEntity_ParticleEmitter)
+    {
+        world_particle_emitter_record ParticleEmitter = {};
+        ParticleEmitter.ParticleCount = Spec->ParticleEmitterSpec.ParticleCount;
+        ParticleEmitter.ParticlesSpawn = Spec->ParticleEmitterSpec.ParticlesSpawn;
+        ParticleEmitter.Color = Spec->ParticleEmitterSpec.Color;
+        ParticleEmitter.Size = Spec->ParticleEmitterSpec.Size;
+
+        WriteValue(Sections + WorldAreaSection_ParticleEmitters, ParticleEmitter);
+    }
+
+    if (Record.Flags & WorldEntity_AudioSource)
+    {
+        world_audio_source_record AudioSource = {};
+        AudioSource.AudioClipRef = AddString(StringTable, Spec->AudioSourceSpec.AudioClipRef);
+        AudioSource.Volume = Spec->AudioSourceSpec.Volume;
+        AudioSource.MinDistance = Spec->AudioSourceSpec.MinDistance;
+        AudioSource.MaxDistance = Spec->AudioSourceSpec.MaxDistance;
+
+        WriteValue(Sections + WorldAreaSection_AudioSources, AudioSource);
+    }
+}
+
+// Reads the next entity of the chunk, advancing the sections it has records in
+dummy_internal void
+ReadWorldEntityRecord(u8 **SectionAt, char *Strings, game_entity_spec *Spec)
+{
+    *Spec = {};
+
+    world_entity_record Record = ReadValue(SectionAt + WorldAreaSection_Entities, world_entity_record);
+
+    CopyString(Strings + Record.Name, Spec->Name);
+
+    Spec->Transform = CreateTransform(Record.Translation);
+    // Zero keeps the default debug color of the entity
+    Spec->DebugColor = vec3(0.f);
+
+    if (Record.Flags & WorldEntity_Rotation)
+    {
+        Spec->Transform.Rotation = ReadValue(SectionAt + WorldAreaSection_Entities, quat);
+    }
+
+    if (Record.Flags & WorldEntity_Scale)
+    {
+        Spec->Transform.Scale = ReadValue(SectionAt + WorldAreaSection_Entities, vec3);
+    }
+
+    if (Record.Flags & WorldEntity_DebugColor)
+    {
+        Spec->DebugColor = ReadValue(SectionAt + WorldAreaSection_Entities, vec3);
+    }
+
+    if (Record.Flags & WorldEntity_Model)
+    {
+        world_model_record Model = ReadValue(SectionAt + WorldAreaSection_Models, world_model_record);
+
+        Spec->ModelSpec.Has = true;
+        CopyString(Strings + Model.ModelRef, Spec->ModelSpec.ModelRef);
+    }
+
+    if (Record.Flags & WorldEntity_Collider)
+    {
+        world_collider_record Collider = ReadValue(SectionAt + WorldAreaSection_Colliders, world_collider_record);
+
+        Spec->ColliderSpec.Has = true;
+        Spec->ColliderSpec.Type = Collider.Type;
+        Spec->ColliderSpec.Box.HalfSize = Collider.HalfSize;
+        Spec->ColliderSpec.Box.Offset = Collider.Offset;
+    }
+
+    if (Record.Flags & WorldEntity_RigidBody)
+    {
+        Spec->RigidBodySpec.Has = true;
+    }
+
+    if (Record.Flags & WorldEntity_PointLight)
+    {
+        world_point_light_record PointLight = ReadValue(SectionAt + WorldAreaSection_PointLights, world_point_light_record);
+
+        Spec->PointLightSpec.Has = true;
+        Spec->PointLightSpec.Color = PointLight.Color;
+        Spec->PointLightSpec.Attenuation = PointLight.Attenuation;
+    }
+
+    if (Record.Flags & WorldEntity_ParticleEmitter)
+    {
+        world_particle_emitter_record ParticleEmitter = ReadValue(SectionAt + WorldAreaSection_ParticleEmitters, world_particle_emitter_record);
+
+        Spec->ParticleEmitterSpec.Has = true;
+        Spec->ParticleEmitterSpec.ParticleCount = ParticleEmitter.ParticleCount;
+        Spec->ParticleEmitterSpec.ParticlesSpawn = ParticleEmitter.ParticlesSpawn;
+        Spec->ParticleEmitterSpec.Color = ParticleEmitter.Color;
+        Spec->ParticleEmitterSpec.Size = ParticleEmitter.Size;
+    }
+
+    if (Record.Flags & WorldEntity_AudioSource)
+    {
+        world_audio_source_record AudioSource = ReadValue(SectionAt + WorldAreaSection_AudioSources, world_audio_source_record);
+
+        Spec->AudioSourceSpec.Has = true;
+        CopyString(Strings + AudioSource.AudioClipRef, Spec->AudioSourceSpec.AudioClipRef);
+        Spec->AudioSourceSpec.Volume = AudioSource.Volume;
+        Spec->AudioSourceSpec.MinDistance = AudioSource.MinDistance;
+        Spec->AudioSourceSpec.MaxDistance = AudioSource.MaxDistance;
+    }
+}
@@ -66,6 +66,24 @@ struct game_entity_spec
     vec3 DebugColor;
 };
 
+#define GAME_FILE_MAGIC_VALUE 0x44332211
+
+// Version 1: array of game_entity_spec (entity files still use it)
+// Version 2: string table, component sections and spatial chunks (see world_area_file_header)
+#define WORLD_AREA_FILE_VERSION 2
+
+// Entities are grouped by the chunk of their position (on the xz plane), so an area can be loaded by region
+#define WORLD_AREA_CHUNK_SIZE 32.f
+
+// Entities instantiated per frame while the cells are loading (see UpdateWorldPartition)
+#define WORLD_AREA_LOAD_ENTITIES_PER_FRAME 1024
+// Free entity slots kept after loading an area (for the editor and the spawned entities)
+#define WORLD_AREA_FREE_ENTITY_COUNT 1024
+// Entity slots of an area never go below the ones of the default area, small areas are still used for the benchmarks
+#define WORLD_AREA_MIN_ENTITY_COUNT 10000
+// Spatial grid of a loaded area doesn't grow past this, its cells get larger instead
+#define MAX_WORLD_AREA_GRID_CELL_COUNT 16384
+
 #pragma pack(push, 1)
 enum game_file_type
 {
@@ -80,4 +98,99 @@ struct game_file_header
     u32 EntityCount;
     game_file_type Type;
 };
+
+/*
+    Every entity is a record in the entities section of its chunk: flags, name, translation and the transform parts
+    that differ from the defaults (rotation, scale and debug color are omitted when they are identity, one and white).
+    Components are stored in their own sections, only for the entities that have them (in the entity order of the chunk).
+    Names and asset references are offsets into the string table.
+*/
+enum world_entity_flags
+{
+    WorldEntity_Rotation = 0x1,
+    WorldEntity_Scale = 0x2,
+    WorldEntity_DebugColor = 0x4,
+    WorldEntity_Model = 0x8,
+    WorldEntity_Collider = 0x10,
+    WorldEntity_RigidBody = 0x20,
+    WorldEntity_PointLight = 0x40,
+    WorldEntity_ParticleEmitter = 0x80,
+    WorldEntity_AudioSource = 0x100
+};
+
+enum world_area_section
+{
+    WorldAreaSection_Entities,
+    WorldAreaSection_Models,
+    WorldAreaSection_Colliders,
+    WorldAreaSection_PointLights,
+    WorldAreaSection_ParticleEmitters,
+    WorldAreaSection_AudioSources,
+
+    WorldAreaSection_Count
+};
+
+struct world_area_file_header
+{
+    // Entity positions
+    aabb Bounds;
+
+    u32 ChunkCount;
+    u64 ChunksOffset;
+
+    u32 StringTableSize;
+    u64 StringTableOffset;
+};
+
+struct world_area_file_chunk
+{
+    aabb Bounds;
+    u32 EntityCount;
+
+    u64 SectionOffsets[WorldAreaSection_Count];
+};
+
+struct world_entity_record
+{
+    u16 Flags;
+    u32 Name;
+    vec3 Translation;
+};
+
+struct world_model_record
+{
+    u32 ModelRef;
+};
+
+struct world_collider_record
+{
+    collider_type Type;
+    vec3 HalfSize;
+    mat4 Offset;
+};
+
+struct world_point_light_record
+{
+    vec3 Color;
+    light_attenuation Attenuation;
+};
+
+struct world_particle_emitter_record
+{
+    u32 ParticleCount;
+    u32 ParticlesSpawn;
+    vec4 Color;
+    vec2 Size;
+};
+
+struct world_audio_source_record
+{
+    u32 AudioClipRef;
+    f32 Volume;
+    f32 MinDistance;
+    f32 MaxDistance;
+};
 #pragma pack(pop)
+
+// Largest entity record with all the optional parts
+#define MAX_WORLD_ENTITY_RECORD_SIZE (sizeof(world_entity_record) + sizeof(quat) + sizeof(vec3) + sizeof(vec3))
@@ -74,3 +74,24 @@ Out(stream *Dest, const char *Format, ...)
 
     AppendChunk(Dest, Size, Contents);
 }
+
+// Text goes right after the previous pushes, so the arena holds one contiguous buffer (e.g. the contents of a file)
+dummy_internal void
+AppendTextArgs(memory_arena *Arena, const char *Format, va_list Args)
+{
+    char String[512];
+    u32 Size = FormatStringArgs(String, ArrayCount(String), Format, Args);
+
+    u8 *Contents = (u8 *) PushSize(Arena, Size, AlignNoClear(1));
+    CopyMemory(String, Contents, Size);
+}
+
+dummy_internal void
+AppendText(memory_arena *Arena, const char *Format, ...)
+{
+    va_list Args;
+
+    va_start(Args, Format);
+    AppendTextArgs(Arena, Format, Args);
+    va_end(Args);
+}
@@ -208,6 +208,13 @@ StringIncludes(char *Str1, char *Str2)
     return false;
 }
 
+inline bool32
+StringStartsWith(const char *String, const char *Prefix)
+{
+    bool32 Result = strncmp(String, Prefix, StringLength(Prefix)) == 0;
+    return Result;
+}
+
 inline char *
 SplitString(char *String, const char *Delimiter, char **Context)
 {
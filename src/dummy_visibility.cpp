@@ -399,6 +399,22 @@ AxisAlignedBoxVisible(u32 PlaneCount, plane *Planes, aabb Box)
     return true;
 }
 
+dummy_internal bool32
+SphereVisible(u32 PlaneCount, plane *Planes, vec3 Center, f32 Radius)
+{
+    for (u32 PlaneIndex = 0; PlaneIndex < PlaneCount; ++PlaneIndex)
+    {
+        plane Plane = Planes[PlaneIndex];
+
+        if (DotPoint(Plane, Center) <= -Radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 dummy_internal bool32
 OrientedBoxVisible(u32 PlaneCount, plane *Planes, obb Box)
 {
@@ -419,3 +435,68 @@ OrientedBoxVisible(u32 PlaneCount, plane *Planes, obb Box)
 
     return true;
 }
+
+// All triangles of the cluster are facing away from the camera
+inline bool32
+ClusterBackfacing(vec3 ConeApex, vec3 ConeAxis, f32 ConeCutoff, vec3 CameraPosition)
+{
+    bool32 Result = Dot(Normalize(ConeApex - CameraPosition), ConeAxis) >= ConeCutoff;
+    return Result;
+}
+
+/*
+    Frustrum and backface cone culling of the mesh clusters.
+    Adjacent visible clusters are merged, Ranges must have room for Mesh->ClusterCount ranges.
+*/
+dummy_internal u32
+CullMeshClusters(mesh *Mesh, transform Transform, u32 PlaneCount, plane *Planes, vec3 CameraPosition, mesh_cluster_ranges *Ranges)
+{
+    u32 VisibleClusterCount = 0;
+
+    vec3 Scale = Transform.Scale;
+    f32 MaxScale = Max(Scale.x, Max(Scale.y, Scale.z));
+    f32 MinScale = Min(Scale.x, Min(Scale.y, Scale.z));
+
+    // Normal cones are not preserved under non-uniform scale
+    bool32 TestCones = (MaxScale - MinScale) <= EPSILON * MaxScale;
+
+    Ranges->RangeCount = 0;
+
+    for (u32 ClusterIndex = 0; ClusterIndex < Mesh->ClusterCount; ++ClusterIndex)
+    {
+        mesh_cluster *Cluster = Mesh->Clusters + ClusterIndex;
+
+        vec3 Center = Transform.Translation + Rotate(Cluster->Center * Scale, Transform.Rotation);
+        f32 Radius = Cluster->Radius * MaxScale;
+
+        bool32 Visible = SphereVisible(PlaneCount, Planes, Center, Radius);
+
+        if (Visible && TestCones)
+        {
+            vec3 ConeApex = Transform.Translation + Rotate(Cluster->ConeApex * Scale, Transform.Rotation);
+            vec3 ConeAxis = Rotate(Cluster->ConeAxis, Transform.Rotation);
+
+            Visible = !ClusterBackfacing(ConeApex, ConeAxis, Cluster->ConeCutoff, CameraPosition);
+        }
+
+        if (Visible)
+        {
+            ++VisibleClusterCount;
+
+            u32 LastRangeIndex = Ranges->RangeCount - 1;
+
+            if (Ranges->RangeCount > 0 && Ranges->IndexOffsets[LastRangeIndex] + Ranges->IndexCounts[LastRangeIndex] == Cluster->IndexOffset)
+            {
+                Ranges->IndexCounts[LastRangeIndex] += Cluster->IndexCount;
+            }
+            else
+            {
+                Ranges->IndexOffsets[Ranges->RangeCount] = Cluster->IndexOffset;
+                Ranges->IndexCounts[Ranges->RangeCount] = Cluster->IndexCount;
+                ++Ranges->RangeCount;
+            }
+        }
+    }
+
+    return VisibleClusterCount;
+}
@@ -1,8 +1,16 @@
 // Order is important!
 
-#define MAX_POINT_LIGHT_COUNT %d
-//! #undef MAX_POINT_LIGHT_COUNT
-//! #define MAX_POINT_LIGHT_COUNT 32
+#define LIGHT_CLUSTER_COUNT_X %d
+//! #undef LIGHT_CLUSTER_COUNT_X
+//! #define LIGHT_CLUSTER_COUNT_X 16
+
+#define LIGHT_CLUSTER_COUNT_Y %d
+//! #undef LIGHT_CLUSTER_COUNT_Y
+//! #define LIGHT_CLUSTER_COUNT_Y 9
+
+#define LIGHT_CLUSTER_COUNT_Z %d
+//! #undef LIGHT_CLUSTER_COUNT_Z
+//! #define LIGHT_CLUSTER_COUNT_Z 24
 
 #define WORLD_SPACE_MODE %d
 //! #undef WORLD_SPACE_MODE
@@ -22,6 +22,46 @@ vec3 Saturate(vec3 Value)
     return clamp(Value, 0.f, 1.f);
 }
 
+// Rotation matrix of unit quaternion (x, y, z, w)
+mat3 QuatToMat3(vec4 q)
+{
+    float xx = q.x * q.x;
+    float yy = q.y * q.y;
+    float zz = q.z * q.z;
+    float xy = q.x * q.y;
+    float xz = q.x * q.z;
+    float yz = q.y * q.z;
+    float wx = q.w * q.x;
+    float wy = q.w * q.y;
+    float wz = q.w * q.z;
+
+    return mat3(
+        vec3(1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy)),
+        vec3(2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx)),
+        vec3(2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy))
+    );
+}
+
+// Unit vector from a point on the unfolded octahedron (see DecodeOctahedral in dummy_math.h)
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 v = vec3(e, 1.f - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.f);
+    v.x += v.x >= 0.f ? -t : t;
+    v.y += v.y >= 0.f ? -t : t;
+
+    return normalize(v);
+}
+
+// Octahedral tangent with the bitangent sign folded into y (see PackTangent in dummy_math.h), w is the bitangent sign
+vec4 DecodeTangent(vec2 e)
+{
+    float BitangentSign = e.y >= 0.f ? 1.f : -1.f;
+    vec3 Tangent = DecodeOctahedral(vec2(e.x, abs(e.y) * 2.f - 1.f));
+
+    return vec4(Tangent, BitangentSign);
+}
+
 vec3 UnprojectPoint(vec3 p, mat4 ViewProjection)
 {
     mat4 ViewProjectionInv = inverse(ViewProjection);
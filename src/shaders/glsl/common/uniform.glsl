@@ -21,9 +21,48 @@ layout(std140, binding = 1) uniform Shading
     directional_light u_DirectionalLight;
 
     int u_PointLightCount;
-    point_light u_PointLights[MAX_POINT_LIGHT_COUNT];
+
+    // View-space depth range of the light cluster grid
+    float u_LightClusterNear;
+    float u_LightClusterFar;
 };
 
+layout(std140, binding = 4) readonly buffer PointLights
+{
+    point_light u_PointLights[];
+};
+
+// Range of the cluster's lights in u_LightIndices (offset, count)
+layout(std430, binding = 5) readonly buffer LightClusters
+{
+    uvec2 u_LightClusters[];
+};
+
+layout(std430, binding = 6) readonly buffer LightIndices
+{
+    uint u_LightIndices[];
+};
+
+// Has to match light cluster grid in dummy_lighting.cpp
+uvec2 GetLightCluster(vec3 WorldPosition)
+{
+    vec4 ClipPosition = u_ViewProjection * vec4(WorldPosition, 1.f);
+    vec2 NdcPosition = ClipPosition.xy / ClipPosition.w;
+
+    // u_CameraDirection is pointing backwards
+    float Depth = max(dot(WorldPosition - u_CameraPosition, -u_CameraDirection), u_LightClusterNear);
+
+    int x = int(floor((NdcPosition.x * 0.5f + 0.5f) * LIGHT_CLUSTER_COUNT_X));
+    int y = int(floor((NdcPosition.y * 0.5f + 0.5f) * LIGHT_CLUSTER_COUNT_Y));
+    int z = int(floor(log(Depth / u_LightClusterNear) / log(u_LightClusterFar / u_LightClusterNear) * LIGHT_CLUSTER_COUNT_Z));
+
+    x = clamp(x, 0, LIGHT_CLUSTER_COUNT_X - 1);
+    y = clamp(y, 0, LIGHT_CLUSTER_COUNT_Y - 1);
+    z = clamp(z, 0, LIGHT_CLUSTER_COUNT_Z - 1);
+
+    return u_LightClusters[(z * LIGHT_CLUSTER_COUNT_Y + y) * LIGHT_CLUSTER_COUNT_X + x];
+}
+
 // todo: ?
 mat4 GetViewProjection(int Mode)
 {
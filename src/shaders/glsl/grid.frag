@@ -104,9 +104,11 @@ void main()
 
     Result = Ambient + Result * Shadow;
 
-    for (int PointLightIndex = 0; PointLightIndex < u_PointLightCount; ++PointLightIndex)
+    uvec2 LightCluster = GetLightCluster(GroundPoint);
+
+    for (uint ClusterLightIndex = 0; ClusterLightIndex < LightCluster.y; ++ClusterLightIndex)
     {
-        point_light PointLight = u_PointLights[PointLightIndex];
+        point_light PointLight = u_PointLights[u_LightIndices[LightCluster.x + ClusterLightIndex]];
         Result += CalculatePointLight(PointLight, AmbientColor, DiffuseColor, SpecularColor, SpecularShininess, Normal, EyeDirection, GroundPoint);
     }
 
@@ -5,10 +5,10 @@
 //! #include "common/uniform.glsl"
 //! #include "common/shadows.glsl"
 
+// Quantized vertex streams (see quantized_mesh_vertices)
 layout(location = 0) in vec3 in_Position;
-layout(location = 1) in vec3 in_Normal;
-layout(location = 2) in vec3 in_Tangent;
-layout(location = 3) in vec3 in_Bitangent;
+layout(location = 1) in vec2 in_Normal;
+layout(location = 2) in vec2 in_Tangent;
 layout(location = 4) in vec2 in_TextureCoords;
 
 out VS_OUT 
@@ -21,17 +21,25 @@ out VS_OUT
     vec3 Color;
 } vs_out;
 
+uniform vec3 u_PositionOffset;
+uniform vec3 u_PositionScale;
+
 uniform vec3 u_Color;
 uniform mat4 u_Model;
 
 void main()
 {
-    vec4 WorldPosition = u_Model * vec4(in_Position, 1.f);
+    vec3 Position = u_PositionOffset + u_PositionScale * in_Position;
+    vec3 Normal = DecodeOctahedral(in_Normal);
+    vec4 Tangent = DecodeTangent(in_Tangent);
+    vec3 Bitangent = Tangent.w * cross(Normal, Tangent.xyz);
+
+    vec4 WorldPosition = u_Model * vec4(Position, 1.f);
 
     vs_out.WorldPosition = WorldPosition.xyz;
-    vs_out.Normal = mat3(transpose(inverse(u_Model))) * in_Normal;
+    vs_out.Normal = mat3(transpose(inverse(u_Model))) * Normal;
     vs_out.TextureCoords = in_TextureCoords;
-    vs_out.TangentBasis = mat3(u_Model) * mat3(in_Tangent, in_Bitangent, in_Normal);
+    vs_out.TangentBasis = mat3(u_Model) * mat3(Tangent.xyz, Bitangent, Normal);
     vs_out.CascadeBlend = CalculateCascadeBlend(WorldPosition.xyz, u_CameraDirection, u_CameraPosition);
     vs_out.Color = u_Color;
 
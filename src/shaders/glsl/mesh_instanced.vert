@@ -5,17 +5,33 @@
 //! #include "common/uniform.glsl"
 //! #include "common/shadows.glsl"
 
+// Quantized vertex streams (see quantized_mesh_vertices)
 layout(location = 0) in vec3 in_Position;
-layout(location = 1) in vec3 in_Normal;
-layout(location = 2) in vec3 in_Tangent;
-layout(location = 3) in vec3 in_Bitangent;
+layout(location = 1) in vec2 in_Normal;
+layout(location = 2) in vec2 in_Tangent;
 layout(location = 4) in vec2 in_TextureCoords;
-// -- ?
-layout(location = 5) in ivec4 in_JointIndices;
-layout(location = 6) in vec4 in_Weights;
-// --
-layout(location = 7) in mat4 in_InstanceModel;
-layout(location = 11) in vec3 in_InstanceColor;
+// Index into Instances buffer
+layout(location = 7) in uint in_InstanceIndex;
+
+// Has to match mesh_instance
+struct mesh_instance
+{
+    vec3 Position;
+    // RGBA8
+    uint Color;
+    // snorm16 quaternion
+    uint Rotation[2];
+    // half-precision scale, w is unused
+    uint Scale[2];
+};
+
+layout(std430, binding = 0) readonly buffer Instances
+{
+    mesh_instance in_Instances[];
+};
+
+uniform vec3 u_PositionOffset;
+uniform vec3 u_PositionScale;
 
 out VS_OUT 
 {
@@ -29,16 +45,28 @@ out VS_OUT
 
 void main()
 {
-    mat4 InstanceModel = transpose(in_InstanceModel);
+    vec3 Position = u_PositionOffset + u_PositionScale * in_Position;
+    vec3 Normal = DecodeOctahedral(in_Normal);
+    vec4 Tangent = DecodeTangent(in_Tangent);
+    vec3 Bitangent = Tangent.w * cross(Normal, Tangent.xyz);
+
+    mesh_instance Instance = in_Instances[in_InstanceIndex];
+
+    vec4 Rotation = normalize(vec4(unpackSnorm2x16(Instance.Rotation[0]), unpackSnorm2x16(Instance.Rotation[1])));
+    vec3 Scale = vec3(unpackHalf2x16(Instance.Scale[0]), unpackHalf2x16(Instance.Scale[1]).x);
+
+    mat3 R = QuatToMat3(Rotation);
+    mat3 RS = mat3(R[0] * Scale.x, R[1] * Scale.y, R[2] * Scale.z);
 
-    vec4 WorldPosition = InstanceModel * vec4(in_Position, 1.f);
+    vec4 WorldPosition = vec4(Instance.Position + RS * Position, 1.f);
     
-    vs_out.WorldPosition = (InstanceModel * vec4(in_Position, 1.f)).xyz;
-    vs_out.Normal = mat3(transpose(inverse(InstanceModel))) * in_Normal;
+    vs_out.WorldPosition = WorldPosition.xyz;
+    // Inverse transpose of R * S is R * S^-1
+    vs_out.Normal = R * (Normal / Scale);
     vs_out.TextureCoords = in_TextureCoords;
-    vs_out.TangentBasis = mat3(InstanceModel) * mat3(in_Tangent, in_Bitangent, in_Normal);
+    vs_out.TangentBasis = RS * mat3(Tangent.xyz, Bitangent, Normal);
     vs_out.CascadeBlend = CalculateCascadeBlend(WorldPosition.xyz, u_CameraDirection, u_CameraPosition);
-    vs_out.Color = in_InstanceColor;
+    vs_out.Color = unpackUnorm4x8(Instance.Color).rgb;
 
     gl_Position = u_ViewProjection * WorldPosition;
 }
\ No newline at end of file
@@ -88,7 +88,9 @@ void main()
     // Get current fragment's normal and transform to world space
     if (u_Material.HasNormalMap)
     {
-        Normal = Normal * 2.f - 1.f; 
+        // Normal maps are BC5, only x and y are stored
+        Normal.xy = Normal.xy * 2.f - 1.f;
+        Normal.z = sqrt(max(0.f, 1.f - dot(Normal.xy, Normal.xy)));
         Normal = fs_in.TangentBasis * Normal;
     }
     
@@ -218,9 +220,11 @@ void main()
     vec3 Result = AmbientLighting + DirectLighting * Shadow;
 
     // Point Lights
-    for(uint LightIndex = 0; LightIndex < u_PointLightCount; ++LightIndex)
+    uvec2 LightCluster = GetLightCluster(fs_in.WorldPosition);
+
+    for (uint ClusterLightIndex = 0; ClusterLightIndex < LightCluster.y; ++ClusterLightIndex)
     {
-        point_light Light = u_PointLights[LightIndex];
+        point_light Light = u_PointLights[u_LightIndices[LightCluster.x + ClusterLightIndex]];
 
         float Attenuation = CalculateInverseSquareAttenuation(Light.Position, fs_in.WorldPosition, Light.Attenuation);
 
@@ -74,7 +74,9 @@ void main()
 
     if (u_Material.HasNormalMap)
     {
-        Normal = Normal * 2.f - 1.f; 
+        // Normal maps are BC5, only x and y are stored
+        Normal.xy = Normal.xy * 2.f - 1.f;
+        Normal.z = sqrt(max(0.f, 1.f - dot(Normal.xy, Normal.xy)));
         Normal = fs_in.TangentBasis * Normal;
     }
     
@@ -127,9 +129,11 @@ void main()
 
     Result = Ambient + Result * Shadow;
 
-    for (int PointLightIndex = 0; PointLightIndex < u_PointLightCount; ++PointLightIndex)
+    uvec2 LightCluster = GetLightCluster(fs_in.WorldPosition);
+
+    for (uint ClusterLightIndex = 0; ClusterLightIndex < LightCluster.y; ++ClusterLightIndex)
     {
-        point_light PointLight = u_PointLights[PointLightIndex];
+        point_light PointLight = u_PointLights[u_LightIndices[LightCluster.x + ClusterLightIndex]];
         Result += CalculatePointLight(PointLight, AmbientColor, DiffuseColor, SpecularColor, SpecularShininess, Normal, EyeDirection, fs_in.WorldPosition);
     }
 
@@ -5,10 +5,10 @@
 //! #include "common/uniform.glsl"
 //! #include "common/shadows.glsl"
 
+// Quantized vertex streams (see quantized_mesh_vertices)
 layout(location = 0) in vec3 in_Position;
-layout(location = 1) in vec3 in_Normal;
-layout(location = 2) in vec3 in_Tangent;
-layout(location = 3) in vec3 in_Bitangent;
+layout(location = 1) in vec2 in_Normal;
+layout(location = 2) in vec2 in_Tangent;
 layout(location = 4) in vec2 in_TextureCoords;
 
 layout(std140, binding = 0) buffer SkinningMatrices
@@ -16,6 +16,9 @@ layout(std140, binding = 0) buffer SkinningMatrices
     mat4 in_SkinningMatrices[];
 };
 
+uniform vec3 u_PositionOffset;
+uniform vec3 u_PositionScale;
+
 uniform int u_VertexCount;
 
 out VS_OUT 
@@ -30,14 +33,19 @@ out VS_OUT
 
 void main()
 {
+    vec3 Position = u_PositionOffset + u_PositionScale * in_Position;
+    vec3 Normal = DecodeOctahedral(in_Normal);
+    vec4 Tangent = DecodeTangent(in_Tangent);
+    vec3 Bitangent = Tangent.w * cross(Normal, Tangent.xyz);
+
     mat4 SkinningMatrix = in_SkinningMatrices[gl_InstanceID * u_VertexCount + gl_VertexID];
 
-    vec4 WorldPosition = SkinningMatrix * vec4(in_Position, 1.f);
+    vec4 WorldPosition = SkinningMatrix * vec4(Position, 1.f);
 
     vs_out.WorldPosition = WorldPosition.xyz;
-    vs_out.Normal = mat3(transpose(inverse(SkinningMatrix))) * in_Normal;
+    vs_out.Normal = mat3(transpose(inverse(SkinningMatrix))) * Normal;
     vs_out.TextureCoords = in_TextureCoords;
-    vs_out.TangentBasis = mat3(SkinningMatrix) * mat3(in_Tangent, in_Bitangent, in_Normal);
+    vs_out.TangentBasis = mat3(SkinningMatrix) * mat3(Tangent.xyz, Bitangent, Normal);
     vs_out.CascadeBlend = CalculateCascadeBlend(WorldPosition.xyz, u_CameraDirection, u_CameraPosition);
     vs_out.Color = vec3(1.f);
 
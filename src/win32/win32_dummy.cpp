@@ -414,8 +414,11 @@ Win32LoadGameCode(wchar *SourceDLLName, wchar *TempDLLName, wchar *LockFileName)
             Result.Render = (game_render_func *)GetProcAddress(Result.GameDLL, "GameRender");
             Result.FrameStart = (game_frame_start_func *)GetProcAddress(Result.GameDLL, "GameFrameStart");
             Result.FrameEnd = (game_frame_end_func *)GetProcAddress(Result.GameDLL, "GameFrameEnd");
+            Result.LoadBenchmark = (game_load_benchmark_func *)GetProcAddress(Result.GameDLL, "GameLoadBenchmark");
+            Result.GetBenchmarkStatus = (game_get_benchmark_status_func *)GetProcAddress(Result.GameDLL, "GameGetBenchmarkStatus");
+            Result.RunMicroBenchmarks = (game_run_micro_benchmarks_func *)GetProcAddress(Result.GameDLL, "GameRunMicroBenchmarks");
 
-            if (Result.Init && Result.Reload && Result.Input && Result.Update && Result.Render && Result.FrameStart && Result.FrameEnd)
+            if (Result.Init && Result.Reload && Result.Input && Result.Update && Result.Render && Result.FrameStart && Result.FrameEnd && Result.LoadBenchmark && Result.GetBenchmarkStatus && Result.RunMicroBenchmarks)
             {
                 Result.IsValid = true;
             }
@@ -442,6 +445,9 @@ Win32UnloadGameCode(win32_game_code *GameCode)
     GameCode->Render = 0;
     GameCode->FrameStart = 0;
     GameCode->FrameEnd = 0;
+    GameCode->LoadBenchmark = 0;
+    GameCode->GetBenchmarkStatus = 0;
+    GameCode->RunMicroBenchmarks = 0;
 }
 
 inline RECT
@@ -798,6 +804,14 @@ Win32ProcessKeyboardInput(platform_input_keyboard *KeyboardInput, win32_platform
                 PlatformState->IsGameRunning = false;
                 break;
             }
+            case VK_F11:
+            {
+                if (IsKeyPressed)
+                {
+                    PlatformState->TraceRequested = true;
+                }
+                break;
+            }
         }
     }
 }
@@ -987,7 +1001,8 @@ PLATFORM_READ_FILE(Win32ReadFile)
             // Save room for the terminating NULL character. 
             u32 BufferSize = Options.ReadAsText ? FileSize32 + 1 : FileSize32;
 
-            Result.Contents = PushSize(Arena, BufferSize);
+            // Contents are overwritten by the read
+            Result.Contents = PushSize(Arena, BufferSize, NoClear());
 
             DWORD BytesRead;
             if (ReadFile(FileHandle, Result.Contents, FileSize32, &BytesRead, 0) && BytesRead == FileSize32)
@@ -1028,7 +1043,7 @@ PLATFORM_WRITE_FILE(Win32WriteFile)
 {
     bool32 Result = false;
 
-    HANDLE FileHandle = CreateFileA(FileName, GENERIC_WRITE, 0, 0, OPEN_ALWAYS, 0, 0);
+    HANDLE FileHandle = CreateFileA(FileName, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
     if (FileHandle != INVALID_HANDLE_VALUE)
     {
         DWORD BytesWritten;
@@ -1054,6 +1069,86 @@ PLATFORM_WRITE_FILE(Win32WriteFile)
     return Result;
 }
 
+// Missing file is not an error: the caller falls back to reading files one by one
+dummy_internal
+PLATFORM_MAP_FILE(Win32MapFile)
+{
+    map_file_result Result = {};
+
+    HANDLE FileHandle = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (FileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER FileSize;
+        if (GetFileSizeEx(FileHandle, &FileSize) && FileSize.QuadPart > 0)
+        {
+            HANDLE MappingHandle = CreateFileMappingA(FileHandle, 0, PAGE_WRITECOPY, 0, 0, 0);
+            if (MappingHandle)
+            {
+                // The view keeps the mapping alive, so both handles can be closed right away
+                Result.Contents = MapViewOfFile(MappingHandle, FILE_MAP_COPY, 0, 0, 0);
+
+                if (Result.Contents)
+                {
+                    Result.Size = FileSize.QuadPart;
+                }
+                else
+                {
+                    DWORD Error = GetLastError();
+                    Assert(!"MapViewOfFile failed");
+                }
+
+                CloseHandle(MappingHandle);
+            }
+            else
+            {
+                DWORD Error = GetLastError();
+                Assert(!"CreateFileMappingA failed");
+            }
+        }
+
+        CloseHandle(FileHandle);
+    }
+
+    return Result;
+}
+
+dummy_internal
+PLATFORM_UNMAP_FILE(Win32UnmapFile)
+{
+    if (File->Contents)
+    {
+        UnmapViewOfFile(File->Contents);
+    }
+
+    *File = {};
+}
+
+dummy_internal
+PLATFORM_RESERVE_MEMORY(Win32ReserveMemory)
+{
+    void *Result = VirtualAlloc(0, Size, MEM_RESERVE, PAGE_NOACCESS);
+
+    if (!Result)
+    {
+        DWORD Error = GetLastError();
+        Assert(!"VirtualAlloc failed");
+    }
+
+    return Result;
+}
+
+dummy_internal
+PLATFORM_COMMIT_MEMORY(Win32CommitMemory)
+{
+    void *Result = VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE);
+
+    if (!Result)
+    {
+        DWORD Error = GetLastError();
+        Assert(!"VirtualAlloc failed");
+    }
+}
+
 dummy_internal
 PLATFORM_GET_FILES(Win32GetFiles)
 {
@@ -1098,70 +1193,136 @@ PLATFORM_GET_FILES(Win32GetFiles)
     return Result;
 }
 
+dummy_internal
+PLATFORM_GET_TIMESTAMP(Win32GetTimeStamp)
+{
+    LARGE_INTEGER PerformanceCounter;
+    QueryPerformanceCounter(&PerformanceCounter);
+
+    u64 Result = PerformanceCounter.QuadPart;
+
+    return Result;
+}
+
+// Returns the time the lock was acquired at
+inline u64
+Win32AcquireLock(CRITICAL_SECTION *CriticalSection, job_lock_stats *Lock)
+{
+    u64 EnterTimestamp = Win32GetTimeStamp();
+    EnterCriticalSection(CriticalSection);
+    u64 Result = Win32GetTimeStamp();
+
+    RecordJobLockAcquire(Lock, Result - EnterTimestamp);
+
+    return Result;
+}
+
+inline void
+Win32ReleaseLock(CRITICAL_SECTION *CriticalSection, job_lock_stats *Lock, u64 AcquireTimestamp)
+{
+    RecordJobLockRelease(Lock, Win32GetTimeStamp() - AcquireTimestamp);
+    LeaveCriticalSection(CriticalSection);
+}
+
 dummy_internal 
 PLATFORM_ENTER_CRITICAL_SECTION(Win32EnterCriticalSection)
 {
     win32_platform_state *PlatformState = (win32_platform_state *) PlatformHandle;
-    EnterCriticalSection(&PlatformState->CriticalSection);
+    PlatformState->CriticalSectionAcquireTimestamp = Win32AcquireLock(&PlatformState->CriticalSection, &PlatformState->CriticalSectionStats);
 }
 
 dummy_internal 
 PLATFORM_LEAVE_CRITICAL_SECTION(Win32LeaveCriticalSection)
 {
     win32_platform_state *PlatformState = (win32_platform_state *) PlatformHandle;
-    LeaveCriticalSection(&PlatformState->CriticalSection);
+    Win32ReleaseLock(&PlatformState->CriticalSection, &PlatformState->CriticalSectionStats, PlatformState->CriticalSectionAcquireTimestamp);
 }
 
-dummy_internal 
-PLATFORM_KICK_JOB(Win32KickJob)
+dummy_internal void
+Win32KickJobBatch(job_queue *JobQueue, u32 JobCount, job *Jobs, const char *Stage, job_batch *Batch)
 {
     CRITICAL_SECTION *CriticalSection = (CRITICAL_SECTION *) JobQueue->CriticalSection;
 
-    EnterCriticalSection(CriticalSection);
+    u64 AcquireTimestamp = Win32AcquireLock(CriticalSection, &JobQueue->Stats->Lock);
 
-    PutJobIntoQueue(JobQueue, &Job);
+    PutJobsIntoQueue(JobQueue, JobCount, Jobs, Stage, Batch);
 
     // dear compiler: please don't reorder instructions across this barrier!
     _ReadWriteBarrier();
 
     CONDITION_VARIABLE *QueueNotEmpty = (CONDITION_VARIABLE *) JobQueue->QueueNotEmpty;
-    WakeConditionVariable(QueueNotEmpty);
 
-    LeaveCriticalSection(CriticalSection);
+    if (JobCount == 1)
+    {
+        WakeConditionVariable(QueueNotEmpty);
+    }
+    else
+    {
+        WakeAllConditionVariable(QueueNotEmpty);
+    }
+
+    Win32ReleaseLock(CriticalSection, &JobQueue->Stats->Lock, AcquireTimestamp);
 }
 
-dummy_internal 
-PLATFORM_KICK_JOBS(Win32KickJobs)
+// Spins until the queue is empty, the batch tells how the jobs were spread across the workers
+dummy_internal void
+Win32WaitForJobBatch(job_queue *JobQueue, const char *Stage, job_batch *Batch)
 {
-    CRITICAL_SECTION *CriticalSection = (CRITICAL_SECTION *) JobQueue->CriticalSection;
+    u64 WaitTimestamp = Win32GetTimeStamp();
 
-    EnterCriticalSection(CriticalSection);
+    {
+        PROFILE(JobQueue->Profiler, "WaitForJobs");
+        while (JobQueue->CurrentJobCount > 0) {}
+    }
 
-    PutJobsIntoQueue(JobQueue, JobCount, Jobs);
+    RecordJobBatch(JobQueue->Stats, Stage, Batch, Win32GetTimeStamp() - WaitTimestamp);
+}
 
-    // dear compiler: please don't reorder instructions across this barrier!
-    _ReadWriteBarrier();
+dummy_internal 
+PLATFORM_KICK_JOB(Win32KickJob)
+{
+    const char *Stage = PROFILER_SCOPE_NAME(JobQueue->Profiler);
 
-    CONDITION_VARIABLE *QueueNotEmpty = (CONDITION_VARIABLE *) JobQueue->QueueNotEmpty;
-    WakeAllConditionVariable(QueueNotEmpty);
+    Win32KickJobBatch(JobQueue, 1, &Job, Stage, 0);
+}
 
-    LeaveCriticalSection(CriticalSection);
+dummy_internal 
+PLATFORM_KICK_JOBS(Win32KickJobs)
+{
+    const char *Stage = PROFILER_SCOPE_NAME(JobQueue->Profiler);
+
+    Win32KickJobBatch(JobQueue, JobCount, Jobs, Stage, 0);
 }
 
 dummy_internal 
 PLATFORM_KICK_JOB_AND_WAIT(Win32KickJobAndWait)
 {
-    Win32KickJob(JobQueue, Job);
+    const char *Stage = PROFILER_SCOPE_NAME(JobQueue->Profiler);
 
-    while (JobQueue->CurrentJobCount > 0) {}
+    job_batch Batch = {};
+    Win32KickJobBatch(JobQueue, 1, &Job, Stage, &Batch);
+    Win32WaitForJobBatch(JobQueue, Stage, &Batch);
 }
 
 dummy_internal 
 PLATFORM_KICK_JOBS_AND_WAIT(Win32KickJobsAndWait)
 {
-    Win32KickJobs(JobQueue, JobCount, Jobs);
+    const char *Stage = PROFILER_SCOPE_NAME(JobQueue->Profiler);
 
-    while (JobQueue->CurrentJobCount > 0) {}
+    job_batch Batch = {};
+    Win32KickJobBatch(JobQueue, JobCount, Jobs, Stage, &Batch);
+    Win32WaitForJobBatch(JobQueue, Stage, &Batch);
+}
+
+// Once per frame on the main thread
+inline void
+Win32FinishJobQueueFrame(job_queue *JobQueue)
+{
+    CRITICAL_SECTION *CriticalSection = (CRITICAL_SECTION *) JobQueue->CriticalSection;
+
+    EnterCriticalSection(CriticalSection);
+    FinishJobQueueFrame(JobQueue->Stats);
+    LeaveCriticalSection(CriticalSection);
 }
 
 DWORD WINAPI WorkerThreadProc(LPVOID lpParam)
@@ -1171,24 +1332,56 @@ DWORD WINAPI WorkerThreadProc(LPVOID lpParam)
     win32_worker_thread *Thread = (win32_worker_thread *) lpParam;
 
     job_queue *JobQueue = Thread->JobQueue;
+    job_lock_stats *Lock = &JobQueue->Stats->Lock;
+    job_worker_stats *Worker = JobQueue->Stats->Workers + Thread->WorkerIndex;
+
+#if PROFILER
+    SetProfilerThreadName(JobQueue->Profiler, Thread->Name);
+#endif
 
     CRITICAL_SECTION *CriticalSection = (CRITICAL_SECTION *) JobQueue->CriticalSection;
     CONDITION_VARIABLE *QueueNotEmpty = (CONDITION_VARIABLE *) JobQueue->QueueNotEmpty;
 
     while (true)
     {
-        EnterCriticalSection(CriticalSection);
+        u64 EnterTimestamp = Win32GetTimeStamp();
+        u64 AcquireTimestamp = Win32AcquireLock(CriticalSection, Lock);
+
+        Worker->LockWaitTicks += AcquireTimestamp - EnterTimestamp;
+        Worker->DequeueTicks += AcquireTimestamp - EnterTimestamp;
 
         while (JobQueue->CurrentJobIndex == -1)
         {
             SleepConditionVariableCS(QueueNotEmpty, CriticalSection, INFINITE);
+
+            // Lock is held again once the worker wakes up
+            u64 WakeTimestamp = Win32GetTimeStamp();
+            Worker->IdleTicks += WakeTimestamp - AcquireTimestamp;
+            AcquireTimestamp = WakeTimestamp;
         }
 
         job *Job = GetNextJobFromQueue(JobQueue);
+        job_batch *Batch = Job->Batch;
+
+        u64 ReleaseTimestamp = Win32GetTimeStamp();
+        Worker->DequeueTicks += ReleaseTimestamp - AcquireTimestamp;
 
-        LeaveCriticalSection(CriticalSection);
+        Win32ReleaseLock(CriticalSection, Lock, AcquireTimestamp);
 
-        Job->EntryPoint(JobQueue, Job->Parameters);
+        {
+            PROFILE_JOB(JobQueue->Profiler, Job);
+            Job->EntryPoint(JobQueue, Job->Parameters);
+        }
+
+        u64 JobTicks = Win32GetTimeStamp() - ReleaseTimestamp;
+
+        Worker->BusyTicks += JobTicks;
+        ++Worker->JobCount;
+
+        if (Batch)
+        {
+            RecordBatchJob(Batch, JobTicks);
+        }
 
         InterlockedDecrement((LONG *) &JobQueue->CurrentJobCount);
 
@@ -1199,7 +1392,7 @@ DWORD WINAPI WorkerThreadProc(LPVOID lpParam)
 }
 
 dummy_internal void
-Win32MakeJobQueue(job_queue *JobQueue, u32 WorkerThreadCount, win32_job_queue_sync *JobQueueSync)
+Win32MakeJobQueue(job_queue *JobQueue, u32 WorkerThreadCount, win32_job_queue_sync *JobQueueSync, platform_profiler *Profiler, const char *Name)
 {
     win32_worker_thread *WorkerThreads = Win32AllocateMemory<win32_worker_thread>(WorkerThreadCount);
 
@@ -1210,12 +1403,20 @@ Win32MakeJobQueue(job_queue *JobQueue, u32 WorkerThreadCount, win32_job_queue_sy
     JobQueue->CurrentJobCount = 0;
     JobQueue->CriticalSection = &JobQueueSync->CriticalSection;
     JobQueue->QueueNotEmpty = &JobQueueSync->QueueNotEmpty;
+    JobQueue->Profiler = Profiler;
+    JobQueue->WorkerCount = WorkerThreadCount;
+    JobQueue->Stats = Win32AllocateMemory<job_queue_stats>();
+    JobQueue->Stats->WorkerCount = WorkerThreadCount;
+
+    Assert(WorkerThreadCount <= JOB_MAX_WORKER_COUNT);
 
     for (u32 WorkerThreadIndex = 0; WorkerThreadIndex < WorkerThreadCount; ++WorkerThreadIndex)
     {
         win32_worker_thread *WorkerThread = WorkerThreads + WorkerThreadIndex;
 
         WorkerThread->JobQueue = JobQueue;
+        WorkerThread->WorkerIndex = WorkerThreadIndex;
+        FormatString(WorkerThread->Name, "%s %d", Name, WorkerThreadIndex);
 
         HANDLE ThreadHandle = CreateThread(0, 0, WorkerThreadProc, WorkerThread, 0, 0);
         CloseHandle(ThreadHandle);
@@ -1223,16 +1424,27 @@ Win32MakeJobQueue(job_queue *JobQueue, u32 WorkerThreadCount, win32_job_queue_sy
 }
 
 dummy_internal
-PLATFORM_GET_TIMESTAMP(Win32GetTimeStamp)
+PLATFORM_GET_THREAD_ID(Win32GetThreadId)
 {
-    LARGE_INTEGER PerformanceCounter;
-    QueryPerformanceCounter(&PerformanceCounter);
-
-    u64 Result = PerformanceCounter.QuadPart;
-
+    u32 Result = GetCurrentThreadId();
     return Result;
 }
 
+// Windows has no user-mode access to the other hardware counters without a kernel driver, only cycles are read
+dummy_internal
+PLATFORM_READ_PERFORMANCE_COUNTERS(Win32ReadPerformanceCounters)
+{
+    ULONG64 Cycles = 0;
+    QueryThreadCycleTime(GetCurrentThread(), &Cycles);
+
+    Counters[ProfilerCounter_Cycles] = Cycles;
+    Counters[ProfilerCounter_Instructions] = 0;
+    Counters[ProfilerCounter_L1DataMisses] = 0;
+    Counters[ProfilerCounter_LastLevelCacheMisses] = 0;
+    Counters[ProfilerCounter_BranchMisses] = 0;
+}
+
+// Called on the main thread, so it takes the first thread slot
 inline void
 Win32InitProfiler(platform_profiler *Profiler)
 {
@@ -1243,7 +1455,518 @@ Win32InitProfiler(platform_profiler *Profiler)
     Profiler->CurrentFrameSampleIndex = 0;
     Profiler->MaxFrameSampleCount = 256;
     Profiler->FrameSamples = Win32AllocateMemory<profiler_frame_samples>(Profiler->MaxFrameSampleCount);
+    Profiler->ThreadCount = 0;
+    Profiler->Threads = Win32AllocateMemory<profiler_thread>(PROFILER_MAX_THREAD_COUNT);
+    Profiler->NameCount = 0;
+    Profiler->Names = Win32AllocateMemory<profiler_name>(PROFILER_MAX_NAME_COUNT);
+    Profiler->Trace.FrameTimestamps = Win32AllocateMemory<u64>(PROFILER_TRACE_MAX_FRAME_COUNT + 1);
+    Profiler->Trace.Events = Win32AllocateMemory<profiler_trace_event>(PROFILER_TRACE_MAX_EVENT_COUNT);
+    Profiler->Trace.SpikeFrame = Win32AllocateMemory<profiler_frame_samples>();
+    Profiler->FrameBudget = Win32AllocateMemory<profiler_frame_budget>();
+    InitProfilerFrameBudget(Profiler->FrameBudget, 1000.f / 60.f);
+#if MEMORY_TELEMETRY
+    Profiler->MemoryTelemetry = Win32AllocateMemory<memory_telemetry>();
+    MemoryTelemetry = Profiler->MemoryTelemetry;
+#endif
     Profiler->GetTimestamp = Win32GetTimeStamp;
+    Profiler->GetThreadId = Win32GetThreadId;
+    // Switched on with the profiler.read_counters cvar
+    Profiler->ReadPerformanceCounters = 0;
+    Profiler->AvailableCounters = 1 << ProfilerCounter_Cycles;
+
+    ResetProfilerFrame(ProfilerGetCurrentFrameSamples(Profiler), Profiler->GetTimestamp());
+    GetProfilerThread(Profiler);
+}
+
+/*
+    Writes the finished trace into the working directory in both formats.
+    Spikes go to profiler_spike_<n>.*, together with the call tree of the frame.
+*/
+dummy_internal void
+Win32WriteProfilerTrace(win32_platform_state *PlatformState, platform_profiler *Profiler)
+{
+    profiler_trace *Trace = &Profiler->Trace;
+
+    char BaseName[64];
+    CopyString("profiler_trace", BaseName);
+
+    if (Trace->SpikeCaptured)
+    {
+        FormatString(BaseName, "profiler_spike_%d", Trace->SpikeCount);
+    }
+
+    char FileName[128];
+
+    umm ReservedSize = Gigabytes(4);
+
+    memory_arena Arena = {};
+    InitGrowableMemoryArena(&Arena, Win32ReserveMemory(ReservedSize), ReservedSize, Win32CommitMemory);
+
+    WriteChromeTrace(Profiler, &Arena);
+    FormatString(FileName, "%s.json", BaseName);
+    Win32WriteFile(FileName, Arena.Base, (u32) Arena.Used);
+
+    ClearMemoryArena(&Arena);
+
+    WritePerfettoTrace(Profiler, &Arena);
+    FormatString(FileName, "%s.pftrace", BaseName);
+    Win32WriteFile(FileName, Arena.Base, (u32) Arena.Used);
+
+    if (Trace->SpikeCaptured)
+    {
+        ClearMemoryArena(&Arena);
+
+        WriteProfilerFrameCSV(Profiler, Trace->SpikeFrame, &Arena);
+        FormatString(FileName, "%s.csv", BaseName);
+        Win32WriteFile(FileName, Arena.Base, (u32) Arena.Used);
+
+        profiler_frame_samples *SpikeFrame = Trace->SpikeFrame;
+        f32 SpikeMilliseconds = GetProfilerMilliseconds(Profiler, SpikeFrame->EndTimestamp - SpikeFrame->StartTimestamp);
+
+        Out(&PlatformState->Stream, "Platform::Frame spike: %.3f ms, %d events written to %s.*", SpikeMilliseconds, Trace->EventCount, BaseName);
+    }
+    else
+    {
+        Out(&PlatformState->Stream, "Platform::Profiler trace: %d frames, %d events, %d dropped", Trace->FrameCount, Trace->EventCount, Trace->DroppedEventCount);
+    }
+
+    Win32DeallocateMemory(Arena.Base);
+
+    ReleaseProfilerTrace(Profiler);
+}
+
+// Value that follows the option on the command line, 0 if there is no such option
+dummy_internal wchar *
+Win32FindCommandLineOption(wchar *CommandLine, const wchar *Option)
+{
+    wchar *Result = wcsstr(CommandLine, Option);
+
+    if (Result)
+    {
+        Result += StringLength(Option);
+
+        while (*Result == L' ')
+        {
+            ++Result;
+        }
+    }
+
+    return Result;
+}
+
+// Copies the value up to the next space
+inline void
+Win32CopyCommandLineValue(wchar *Value, char *Dest, u32 DestSize)
+{
+    u32 Length = 0;
+
+    while (Value[Length] && Value[Length] != L' ' && Length < DestSize - 1)
+    {
+        Dest[Length] = (char) Value[Length];
+        ++Length;
+    }
+
+    Dest[Length] = 0;
+}
+
+// Start of the value after the current one, points to the terminator if there is none
+inline wchar *
+Win32NextCommandLineValue(wchar *Value)
+{
+    wchar *Result = Value;
+
+    while (*Result && *Result != L' ')
+    {
+        ++Result;
+    }
+
+    while (*Result == L' ')
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+/*
+    dummy.cfg from the working directory first, then every --cvar <name>=<value>, so the command line wins.
+    Game code registers its cvars later, the values are kept until then.
+*/
+dummy_internal void
+Win32InitCVars(win32_platform_state *PlatformState, wchar *CommandLine)
+{
+    cvar_registry *Registry = PlatformState->CVars;
+
+    // Config is optional, reading a missing file asserts
+    if (Win32FileExists((wchar *) L"" CVAR_CONFIG_FILE_NAME))
+    {
+        scoped_memory ScopedMemory(&PlatformState->Arena);
+
+        read_file_result Config = Win32ReadFile((char *) CVAR_CONFIG_FILE_NAME, ScopedMemory.Arena, ReadText());
+
+        if (Config.Contents)
+        {
+            u32 InvalidLineCount = LoadCVarConfig(Registry, (char *) Config.Contents, &PlatformState->Stream);
+
+            Out(&PlatformState->Stream, "Platform::Loaded %s (%d invalid lines)", CVAR_CONFIG_FILE_NAME, InvalidLineCount);
+        }
+    }
+
+    wchar *CVarArgument = Win32FindCommandLineOption(CommandLine, L"--cvar");
+
+    while (CVarArgument)
+    {
+        char Assignment[CVAR_MAX_NAME_LENGTH + CVAR_MAX_VALUE_LENGTH];
+        Win32CopyCommandLineValue(CVarArgument, Assignment, ArrayCount(Assignment));
+
+        char *Value = strchr(Assignment, '=');
+
+        if (Value)
+        {
+            *Value++ = 0;
+        }
+
+        if (!Value || !SetCVarFromString(Registry, Assignment, Value))
+        {
+            Out(&PlatformState->Stream, "Platform::Invalid cvar: %s", Assignment);
+        }
+
+        CVarArgument = Win32FindCommandLineOption(CVarArgument, L"--cvar");
+    }
+
+    PlatformState->UpdateRateCVar = RegisterCVarInt(Registry, "game.update_rate", 50, 10, 240, "Fixed updates per second");
+    PlatformState->ParallelForChunkCVar = RegisterCVarFloat(
+        Registry,
+        "job.parallel_for_chunk_us",
+        PARALLEL_FOR_TARGET_CHUNK_MICROSECONDS,
+        5.f,
+        1000.f,
+        "Work per chunk of the parallel loops, in microseconds"
+    );
+    PlatformState->ReadCountersCVar = RegisterCVarBool(Registry, "profiler.read_counters", false, "Read the thread cycle counter in every profiler scope");
+}
+
+/*
+    Value of the current sweep point goes through the registry, the cvar may not be registered yet.
+    Registered cvars get the value rounded and clamped to their type, the point keeps the value that was applied.
+*/
+inline void
+Win32SetBenchmarkSweepValue(win32_platform_state *PlatformState)
+{
+    benchmark_sweep *Sweep = &PlatformState->Sweep;
+    benchmark_sweep_point *Point = Sweep->Points + Sweep->PointIndex;
+
+    cvar *CVar = FindCVar(PlatformState->CVars, Sweep->CVarName);
+
+    if (CVar && IsCVarRegistered(CVar))
+    {
+        SetCVarNumber(CVar, Point->Value);
+        Point->Value = GetCVarNumber(CVar);
+    }
+    else
+    {
+        char Value[CVAR_MAX_VALUE_LENGTH];
+        FormatString(Value, "%g", Point->Value);
+
+        SetCVarFromString(PlatformState->CVars, Sweep->CVarName, Value);
+    }
+}
+
+/*
+    --benchmark <scenario> [--frames N] [--warmup N] [--seed N] [--baseline file] [--threshold percent] [--sweep cvar from to step]
+    --microbench [filter] [--baseline file] [--threshold percent]
+    Warmup frames include the one that spawns the scenario, so that it's never measured.
+    Sweep runs the scenario once per value of the cvar and charts the frame time, there is no baseline check.
+*/
+dummy_internal void
+Win32InitBenchmark(win32_platform_state *PlatformState, wchar *CommandLine)
+{
+    benchmark_run *Benchmark = &PlatformState->Benchmark;
+
+    Benchmark->Threshold = 0.1f;
+
+    wchar *BaselineArgument = Win32FindCommandLineOption(CommandLine, L"--baseline");
+    if (BaselineArgument)
+    {
+        Win32CopyCommandLineValue(BaselineArgument, Benchmark->BaselineFileName, ArrayCount(Benchmark->BaselineFileName));
+    }
+
+    wchar *ThresholdArgument = Win32FindCommandLineOption(CommandLine, L"--threshold");
+    if (ThresholdArgument && _wtof(ThresholdArgument) > 0.0)
+    {
+        Benchmark->Threshold = (f32) _wtof(ThresholdArgument) / 100.f;
+    }
+
+    wchar *MicroBenchmarkArgument = Win32FindCommandLineOption(CommandLine, L"--microbench");
+    if (MicroBenchmarkArgument)
+    {
+        // Next option is not a filter
+        if (*MicroBenchmarkArgument != L'-')
+        {
+            Win32CopyCommandLineValue(MicroBenchmarkArgument, PlatformState->MicroBenchmarkFilter, ArrayCount(PlatformState->MicroBenchmarkFilter));
+        }
+
+        PlatformState->MicroBenchmarkMode = true;
+    }
+
+    wchar *ScenarioArgument = Win32FindCommandLineOption(CommandLine, L"--benchmark");
+
+    if (ScenarioArgument)
+    {
+        char ScenarioName[64];
+        Win32CopyCommandLineValue(ScenarioArgument, ScenarioName, ArrayCount(ScenarioName));
+
+        Benchmark->Scenario = FindBenchmarkScenario(ScenarioName);
+
+        if (Benchmark->Scenario != BenchmarkScenario_Count)
+        {
+            Benchmark->State = BenchmarkRun_Loading;
+            Benchmark->Seed = 1;
+            Benchmark->WarmupFrameCount = 120;
+            Benchmark->FrameCount = 600;
+
+            wchar *FramesArgument = Win32FindCommandLineOption(CommandLine, L"--frames");
+            if (FramesArgument && _wtoi(FramesArgument) > 0)
+            {
+                Benchmark->FrameCount = (u32) _wtoi(FramesArgument);
+            }
+
+            wchar *WarmupArgument = Win32FindCommandLineOption(CommandLine, L"--warmup");
+            if (WarmupArgument && _wtoi(WarmupArgument) > 0)
+            {
+                Benchmark->WarmupFrameCount = (u32) _wtoi(WarmupArgument);
+            }
+
+            wchar *SeedArgument = Win32FindCommandLineOption(CommandLine, L"--seed");
+            if (SeedArgument)
+            {
+                Benchmark->Seed = (u32) _wtoi(SeedArgument);
+            }
+
+            wchar *SweepArgument = Win32FindCommandLineOption(CommandLine, L"--sweep");
+            if (SweepArgument)
+            {
+                char CVarName[CVAR_MAX_NAME_LENGTH];
+                Win32CopyCommandLineValue(SweepArgument, CVarName, ArrayCount(CVarName));
+
+                wchar *FromArgument = Win32NextCommandLineValue(SweepArgument);
+                wchar *ToArgument = Win32NextCommandLineValue(FromArgument);
+                wchar *StepArgument = Win32NextCommandLineValue(ToArgument);
+
+                InitBenchmarkSweep(&PlatformState->Sweep, CVarName, (f32) _wtof(FromArgument), (f32) _wtof(ToArgument), (f32) _wtof(StepArgument));
+                Win32SetBenchmarkSweepValue(PlatformState);
+
+                PlatformState->SweepMode = true;
+            }
+
+            PlatformState->BenchmarkMode = true;
+            // Frames are not capped by the display
+            PlatformState->VSync = false;
+        }
+        else
+        {
+            Out(&PlatformState->Stream, "Platform::Unknown benchmark scenario: %s", ScenarioName);
+            PlatformState->ExitCode = 1;
+        }
+    }
+}
+
+// Game code registers its cvars on init, so the sweep can't check its cvar any earlier
+inline bool32
+Win32IsBenchmarkSweepCVarRegistered(win32_platform_state *PlatformState)
+{
+    cvar *CVar = FindCVar(PlatformState->CVars, PlatformState->Sweep.CVarName);
+
+    bool32 Result = CVar && IsCVarRegistered(CVar);
+    return Result;
+}
+
+/*
+    Writes sweep_<scenario>_<cvar>.json and .csv and charts the frame time.
+    False while there are values left, the next run starts with the next value.
+*/
+dummy_internal bool32
+Win32FinishBenchmarkSweepPoint(win32_platform_state *PlatformState)
+{
+    benchmark_run *Benchmark = &PlatformState->Benchmark;
+    benchmark_sweep *Sweep = &PlatformState->Sweep;
+
+    RecordBenchmarkSweepPoint(Sweep, Benchmark);
+
+    bool32 Result = ++Sweep->PointIndex == Sweep->PointCount;
+
+    if (Result)
+    {
+        scoped_memory ScopedMemory(&PlatformState->Arena);
+
+        memory_arena *Arena = ScopedMemory.Arena;
+        char FileName[128];
+
+        umm StartUsed = Arena->Used;
+        WriteBenchmarkSweepJSON(Sweep, Benchmark, Arena);
+
+        FormatString(FileName, "sweep_%s_%s.json", BenchmarkScenarioNames[Benchmark->Scenario], Sweep->CVarName);
+        Win32WriteFile(FileName, (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+
+        StartUsed = Arena->Used;
+        WriteBenchmarkSweepCSV(Sweep, Arena);
+
+        FormatString(FileName, "sweep_%s_%s.csv", BenchmarkScenarioNames[Benchmark->Scenario], Sweep->CVarName);
+        Win32WriteFile(FileName, (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+
+        OutBenchmarkSweepChart(Sweep, &PlatformState->Stream);
+    }
+    else
+    {
+        // Cvar is registered by now, the value applies right away
+        Win32SetBenchmarkSweepValue(PlatformState);
+        ResetBenchmarkRun(Benchmark);
+    }
+
+    return Result;
+}
+
+/*
+    Writes benchmark_<scenario>.json (benchmark_<scenario>_<cvar>_<value>.json for the sweeps) into the working directory
+    and checks it against the baseline
+*/
+dummy_internal void
+Win32FinishBenchmark(win32_platform_state *PlatformState)
+{
+    benchmark_run *Benchmark = &PlatformState->Benchmark;
+
+    FinishBenchmarkRun(Benchmark, &PlatformState->Arena);
+
+    {
+        scoped_memory ScopedMemory(&PlatformState->Arena);
+
+        memory_arena *Arena = ScopedMemory.Arena;
+        umm StartUsed = Arena->Used;
+
+        WriteBenchmarkJSON(Benchmark, Arena);
+
+        char FileName[128];
+
+        if (PlatformState->SweepMode)
+        {
+            benchmark_sweep *Sweep = &PlatformState->Sweep;
+            FormatString(FileName, "benchmark_%s_%s_%g.json", BenchmarkScenarioNames[Benchmark->Scenario], Sweep->CVarName, Sweep->Points[Sweep->PointIndex].Value);
+        }
+        else
+        {
+            FormatString(FileName, "benchmark_%s.json", BenchmarkScenarioNames[Benchmark->Scenario]);
+        }
+
+        Win32WriteFile(FileName, (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+
+        Out(&PlatformState->Stream, "Platform::Benchmark %s: %d frames written to %s", BenchmarkScenarioNames[Benchmark->Scenario], Benchmark->MeasuredFrameCount, FileName);
+    }
+
+    // Streaming during the measured frames skews the timings, but doesn't fail the run
+    if (Benchmark->ResidencyMissCount > 0)
+    {
+        Out(&PlatformState->Stream, "Platform::Benchmark %s: %d placeholders drawn while models were streaming", BenchmarkScenarioNames[Benchmark->Scenario], Benchmark->ResidencyMissCount);
+    }
+
+    if (Benchmark->Status.CheckErrorCount > 0)
+    {
+        Out(&PlatformState->Stream, "Platform::Benchmark %s: %d failed checks", BenchmarkScenarioNames[Benchmark->Scenario], Benchmark->Status.CheckErrorCount);
+        PlatformState->ExitCode = 1;
+    }
+
+    if (PlatformState->SweepMode)
+    {
+        PlatformState->IsGameRunning = !Win32FinishBenchmarkSweepPoint(PlatformState);
+    }
+    else
+    {
+        if (Benchmark->BaselineFileName[0])
+        {
+            scoped_memory ScopedMemory(&PlatformState->Arena);
+
+            read_file_result Baseline = Win32ReadFile(Benchmark->BaselineFileName, ScopedMemory.Arena, ReadText());
+
+            if (Baseline.Contents)
+            {
+                u32 RegressionCount = CompareBenchmarkBaseline(Benchmark, (char *) Baseline.Contents, &PlatformState->Stream);
+
+                if (RegressionCount > 0)
+                {
+                    PlatformState->ExitCode = 1;
+                }
+
+                Out(&PlatformState->Stream, "Platform::Benchmark regressions: %d (threshold %.0f%%)", RegressionCount, Benchmark->Threshold * 100.f);
+            }
+            else
+            {
+                Out(&PlatformState->Stream, "Platform::Benchmark baseline is missing: %s", Benchmark->BaselineFileName);
+                PlatformState->ExitCode = 1;
+            }
+        }
+
+        PlatformState->IsGameRunning = false;
+    }
+}
+
+// Runs on the main thread, which is pinned to a single core. Writes microbench.json and checks it against the baseline
+dummy_internal void
+Win32RunMicroBenchmarks(win32_platform_state *PlatformState, win32_game_code *GameCode, game_memory *GameMemory, platform_profiler *Profiler)
+{
+    benchmark_run *Benchmark = &PlatformState->Benchmark;
+
+    umm ReservedSize = Gigabytes(1);
+
+    memory_arena Arena = {};
+    InitGrowableMemoryArena(&Arena, Win32ReserveMemory(ReservedSize), ReservedSize, Win32CommitMemory);
+
+    micro_benchmark_suite *Suite = PushType(&Arena, micro_benchmark_suite);
+    Suite->Profiler = Profiler;
+    Suite->Arena = &Arena;
+    Suite->Threshold = Benchmark->Threshold;
+    CopyString(PlatformState->MicroBenchmarkFilter, Suite->Filter);
+
+    GameCode->RunMicroBenchmarks(GameMemory, Suite);
+
+    {
+        scoped_memory ScopedMemory(&Arena);
+
+        umm StartUsed = Arena.Used;
+        WriteMicroBenchmarkJSON(Suite, &Arena);
+        Win32WriteFile((char *) "microbench.json", (u8 *) Arena.Base + StartUsed, (u32) (Arena.Used - StartUsed));
+    }
+
+    Out(&PlatformState->Stream, "Platform::Micro-benchmarks: %d benchmarks and %d checks written to microbench.json", Suite->BenchmarkCount, Suite->CheckCount);
+
+    if (CountFailedMicroBenchmarkChecks(Suite, &PlatformState->Stream) > 0)
+    {
+        PlatformState->ExitCode = 1;
+    }
+
+    if (Benchmark->BaselineFileName[0])
+    {
+        read_file_result Baseline = Win32ReadFile(Benchmark->BaselineFileName, &Arena, ReadText());
+
+        if (Baseline.Contents)
+        {
+            u32 RegressionCount = CompareMicroBenchmarkBaseline(Suite, (char *) Baseline.Contents, &PlatformState->Stream);
+
+            if (RegressionCount > 0)
+            {
+                PlatformState->ExitCode = 1;
+            }
+
+            Out(&PlatformState->Stream, "Platform::Micro-benchmark regressions: %d (threshold %.0f%%)", RegressionCount, Suite->Threshold * 100.f);
+        }
+        else
+        {
+            Out(&PlatformState->Stream, "Platform::Benchmark baseline is missing: %s", Benchmark->BaselineFileName);
+            PlatformState->ExitCode = 1;
+        }
+    }
+
+    Win32DeallocateMemory(Arena.Base);
+
+    PlatformState->IsGameRunning = false;
 }
 
 COMDLG_FILTERSPEC DialogFileTypes[] =
@@ -1340,8 +2063,16 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     u32 MaxWorkerThreadCount = 1;
 #endif
 
+    // Before the worker threads, so that the main thread is the first one
+    platform_profiler PlatformProfiler = {};
+    Win32InitProfiler(&PlatformProfiler);
+
     job_queue JobQueue = {};
-    Win32MakeJobQueue(&JobQueue, MaxWorkerThreadCount, &PlatformState.JobQueueSync);
+    Win32MakeJobQueue(&JobQueue, MaxWorkerThreadCount, &PlatformState.JobQueueSync, &PlatformProfiler, "Worker");
+
+    // KickJobsAndWait waits for every job in the queue, so streaming gets its own
+    job_queue BackgroundJobQueue = {};
+    Win32MakeJobQueue(&BackgroundJobQueue, 2, &PlatformState.BackgroundJobQueueSync, &PlatformProfiler, "Background Worker");
 
     HANDLE CurrentThread = GetCurrentThread();
     u32 CurrentProcessorNumber = GetCurrentProcessorNumber();
@@ -1362,6 +2093,45 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     PlatformState.WindowPlacement = {sizeof(WINDOWPLACEMENT)};
     PlatformState.hInstance = hInstance;
     PlatformState.VSync = true;
+    PlatformState.TraceFrameCount = 300;
+
+    // --trace [frame count] captures the profiler trace from the first frame
+    wchar *TraceArgument = wcsstr(lpCmdLine, L"--trace");
+    if (TraceArgument)
+    {
+        i32 TraceFrameCount = _wtoi(TraceArgument + StringLength(L"--trace"));
+
+        if (TraceFrameCount > 0)
+        {
+            PlatformState.TraceFrameCount = (u32) TraceFrameCount;
+        }
+
+        PlatformState.TraceRequested = true;
+    }
+
+    // Before the benchmark, a sweep sets its first value through the registry
+    PlatformState.CVars = Win32AllocateMemory<cvar_registry>();
+    Win32InitCVars(&PlatformState, lpCmdLine);
+
+    Win32InitBenchmark(&PlatformState, lpCmdLine);
+
+    // --frame-budget <ms> for the spike capture, --no-spike-capture turns it off
+    {
+        profiler_frame_budget *FrameBudget = PlatformProfiler.FrameBudget;
+
+        wchar *FrameBudgetArgument = Win32FindCommandLineOption(lpCmdLine, L"--frame-budget");
+        if (FrameBudgetArgument && _wtof(FrameBudgetArgument) > 0.0)
+        {
+            FrameBudget->BudgetMilliseconds = (f32) _wtof(FrameBudgetArgument);
+        }
+
+        // Benchmark timings shouldn't include the capture
+        if (Win32FindCommandLineOption(lpCmdLine, L"--no-spike-capture") || PlatformState.BenchmarkMode || PlatformState.MicroBenchmarkMode)
+        {
+            FrameBudget->CaptureSpikes = false;
+        }
+    }
+
     InitBool32State(&PlatformState.IsFullScreen, true);
 
     Out(&PlatformState.Stream, "Platform::Worker Thread Count: %d", MaxWorkerThreadCount);
@@ -1379,7 +2149,11 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     PlatformApi.SetMouseMode = Win32SetMouseMode;
     PlatformApi.ReadFile = Win32ReadFile;
     PlatformApi.WriteFile = Win32WriteFile;
+    PlatformApi.MapFile = Win32MapFile;
+    PlatformApi.UnmapFile = Win32UnmapFile;
     PlatformApi.GetFiles = Win32GetFiles;
+    PlatformApi.ReserveMemory = Win32ReserveMemory;
+    PlatformApi.CommitMemory = Win32CommitMemory;
     PlatformApi.OpenFileDialog = Win32OpenFileDialog;
     PlatformApi.SaveFileDialog = Win32SaveFileDialog;
     PlatformApi.LoadFunction = Win32LoadFunction;
@@ -1390,9 +2164,6 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     PlatformApi.KickJobAndWait = Win32KickJobAndWait;
     PlatformApi.KickJobsAndWait = Win32KickJobsAndWait;
 
-    platform_profiler PlatformProfiler = {};
-    Win32InitProfiler(&PlatformProfiler);
-
     game_memory GameMemory = {};
     GameMemory.PermanentStorageSize = Megabytes(256);
     GameMemory.FrameStorageSize = Megabytes(256);
@@ -1402,6 +2173,8 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     GameMemory.Platform = &PlatformApi;
     GameMemory.Profiler = &PlatformProfiler;
     GameMemory.JobQueue = &JobQueue;
+    GameMemory.BackgroundJobQueue = &BackgroundJobQueue;
+    GameMemory.CVars = PlatformState.CVars;
 
 #if RELEASE
     void *BaseAddress = 0;
@@ -1515,18 +2288,79 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         GameParameters.WindowWidth = PlatformState.WindowWidth;
         GameParameters.WindowHeight = PlatformState.WindowHeight;
         GameParameters.Samples = PlatformState.Samples;
-        GameParameters.UpdateRate = 1.f / 50.f;
+        GameParameters.UpdateRate = 1.f / (f32) GetCVarInt(PlatformState.UpdateRateCVar);
         GameParameters.TimeScale = 1.f;
 
-        PlatformState.IsGameRunning = true;
+        // Unknown benchmark scenario quits right away
+        PlatformState.IsGameRunning = PlatformState.ExitCode == 0;
 
         GameCode.Init(&GameMemory, &GameParameters);
 
+        if (PlatformState.MicroBenchmarkMode && PlatformState.IsGameRunning)
+        {
+            Win32RunMicroBenchmarks(&PlatformState, &GameCode, &GameMemory, &PlatformProfiler);
+        }
+
         // Game Loop
         while (PlatformState.IsGameRunning)
         {
             PROFILER_START_FRAME(&PlatformProfiler);
 
+            // Job and lock stats of the previous frame
+            {
+                Win32FinishJobQueueFrame(&JobQueue);
+                Win32FinishJobQueueFrame(&BackgroundJobQueue);
+
+                EnterCriticalSection(&PlatformState.CriticalSection);
+                PlatformState.CriticalSectionFrameStats = PlatformState.CriticalSectionStats;
+                PlatformState.CriticalSectionStats = {};
+                LeaveCriticalSection(&PlatformState.CriticalSection);
+            }
+
+            if (PlatformState.TraceRequested)
+            {
+                RequestProfilerTrace(&PlatformProfiler, PlatformState.TraceFrameCount);
+                PlatformState.TraceRequested = false;
+            }
+
+            if (PlatformProfiler.Trace.State == ProfilerTrace_Finished)
+            {
+                Win32WriteProfilerTrace(&PlatformState, &PlatformProfiler);
+            }
+
+            // Spike watch is armed again once the previous spike is written
+            {
+                profiler_frame_budget *FrameBudget = PlatformProfiler.FrameBudget;
+
+                RecordProfilerFrameBudget(FrameBudget, &PlatformProfiler);
+
+                if (FrameBudget->CaptureSpikes && PlatformProfiler.Trace.SpikeCount < FrameBudget->MaxSpikeCaptureCount)
+                {
+                    WatchProfilerSpikes(&PlatformProfiler, FrameBudget->BudgetMilliseconds);
+                }
+                else
+                {
+                    StopWatchingProfilerSpikes(&PlatformProfiler);
+                }
+            }
+
+            // Previous frame is complete once the profiler has started the next one
+            if (PlatformState.BenchmarkMode && PlatformState.Benchmark.State == BenchmarkRun_Running)
+            {
+                benchmark_run *Benchmark = &PlatformState.Benchmark;
+
+                if (Benchmark->FrameIndex > Benchmark->WarmupFrameCount)
+                {
+                    RecordBenchmarkFrame(Benchmark, &PlatformProfiler, &PlatformState.Arena);
+                    RecordBenchmarkJobs(Benchmark, &PlatformProfiler, &JobQueue.Stats->LastFrame);
+
+                    if (Benchmark->MeasuredFrameCount == Benchmark->FrameCount)
+                    {
+                        Win32FinishBenchmark(&PlatformState);
+                    }
+                }
+            }
+
             if (Changed(PlatformState.IsFullScreen))
             {
                 Win32ToggleFullScreen(&PlatformState);
@@ -1571,6 +2405,32 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
                 GameParameters.WindowWidth = PlatformState.GameWindowWidth;
                 GameParameters.WindowHeight = PlatformState.GameWindowHeight;
 
+                if (PlatformState.BenchmarkMode && PlatformState.Benchmark.State == BenchmarkRun_Loading)
+                {
+                    if (PlatformState.SweepMode && !Win32IsBenchmarkSweepCVarRegistered(&PlatformState))
+                    {
+                        Out(&PlatformState.Stream, "Platform::Unknown sweep cvar: %s", PlatformState.Sweep.CVarName);
+                        PlatformState.ExitCode = 1;
+                        PlatformState.IsGameRunning = false;
+                    }
+                    else
+                    {
+                        if (PlatformState.SweepMode)
+                        {
+                            // First value was set as text before the registration, it's applied again with the type of the cvar (e.g. 2.5 for an int)
+                            Win32SetBenchmarkSweepValue(&PlatformState);
+                        }
+
+                        if (GameCode.LoadBenchmark(&GameMemory, PlatformState.Benchmark.Scenario, PlatformState.Benchmark.Seed))
+                        {
+                            PlatformState.Benchmark.State = BenchmarkRun_Streaming;
+                        }
+                    }
+                }
+
+                JobQueue.ParallelForChunkMicroseconds = GetCVarFloat(PlatformState.ParallelForChunkCVar);
+                PlatformProfiler.ReadPerformanceCounters = GetCVarBool(PlatformState.ReadCountersCVar) ? Win32ReadPerformanceCounters : 0;
+
                 {
                     PROFILE(&PlatformProfiler, "FrameStart");
                     GameCode.FrameStart(&GameMemory);
@@ -1580,14 +2440,18 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
                 {
                     PROFILE(&PlatformProfiler, "ProcessInput");
 
-                    XboxControllerInput2GameInput(&XboxControllerInput, &GameInput, GameParameters.Delta);
+                    if (!PlatformState.BenchmarkMode)
+                    {
+                        XboxControllerInput2GameInput(&XboxControllerInput, &GameInput, GameParameters.Delta);
+                    }
 
-                    if (!EDITOR_CAPTURE_KEYBOARD_INPUT(&EditorState))
+                    // Benchmark runs don't take any input, so they stay deterministic
+                    if (!EDITOR_CAPTURE_KEYBOARD_INPUT(&EditorState) && !PlatformState.BenchmarkMode)
                     {
                         KeyboardInput2GameInput(&KeyboardInput, &GameInput);
                     }
 
-                    if (!EDITOR_CAPTURE_MOUSE_INPUT(&EditorState))
+                    if (!EDITOR_CAPTURE_MOUSE_INPUT(&EditorState) && !PlatformState.BenchmarkMode)
                     {
                         MouseInput2GameInput(&MouseInput, &GameInput);
                     }
@@ -1599,10 +2463,13 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
                 {
                     PROFILE(&PlatformProfiler, "FixedUpdate");
 
+                    GameParameters.UpdateRate = 1.f / (f32) GetCVarInt(PlatformState.UpdateRateCVar);
                     GameParameters.UpdateAccumulator += GameParameters.Delta;
 
                     while (GameParameters.UpdateAccumulator >= GameParameters.UpdateRate)
                     {
+                        PROFILE(&PlatformProfiler, "FixedStep");
+
                         GameCode.Update(&GameMemory, &GameParameters, &GameInput);
                         GameParameters.UpdateAccumulator -= GameParameters.UpdateRate;
                     }
@@ -1613,15 +2480,51 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
                 }
 
                 // Render
-                GameCode.Render(&GameMemory, &GameParameters, &GameInput);
+                {
+                    PROFILE(&PlatformProfiler, "Render");
+
+                    GameCode.Render(&GameMemory, &GameParameters, &GameInput);
 
-                audio_commands *AudioCommands = GetAudioCommands(&GameMemory);
-                ProcessAudioCommands(&AudioState, AudioCommands);
-                ClearAudioCommands(&GameMemory);
+                    audio_commands *AudioCommands = GetAudioCommands(&GameMemory);
+                    ProcessAudioCommands(&AudioState, AudioCommands);
+                    ClearAudioCommands(&GameMemory);
+
+                    {
+                        PROFILE(&PlatformProfiler, "ProcessRenderCommands");
 
-                render_commands *RenderCommands = GetRenderCommands(&GameMemory);
-                ProcessRenderCommands(&RendererState, RenderCommands);
-                ClearRenderCommands(&GameMemory);
+                        render_commands *RenderCommands = GetRenderCommands(&GameMemory);
+                        ProcessRenderCommands(&RendererState, RenderCommands);
+                        ClearRenderCommands(&GameMemory);
+                    }
+                }
+
+                if (PlatformState.BenchmarkMode && (PlatformState.Benchmark.State == BenchmarkRun_Streaming || PlatformState.Benchmark.State == BenchmarkRun_Running))
+                {
+                    benchmark_run *Benchmark = &PlatformState.Benchmark;
+
+                    GameCode.GetBenchmarkStatus(&GameMemory, &Benchmark->Status);
+
+                    if (Benchmark->State == BenchmarkRun_Streaming)
+                    {
+                        ++Benchmark->StreamingFrameCount;
+
+                        // Warmup starts once the models in view are resident, so the measured frames don't include the streaming
+                        if (Benchmark->Status.Ready || Benchmark->StreamingFrameCount == BENCHMARK_MAX_STREAMING_FRAME_COUNT)
+                        {
+                            if (!Benchmark->Status.Ready)
+                            {
+                                Out(&PlatformState.Stream, "Platform::Benchmark %s: models are still streaming after %d frames", BenchmarkScenarioNames[Benchmark->Scenario], Benchmark->StreamingFrameCount);
+                            }
+
+                            Benchmark->State = BenchmarkRun_Running;
+                        }
+                    }
+                    else if (Benchmark->FrameIndex >= Benchmark->WarmupFrameCount)
+                    {
+                        // This frame is recorded once the profiler starts the next one
+                        Benchmark->ResidencyMissCount += Benchmark->Status.FrameResidencyMissCount;
+                    }
+                }
             }
 
             {
@@ -1653,12 +2556,29 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
                 Delta = 1.f / 60.f;
             }
 
+            // Every benchmark run simulates the same steps, whatever the frame time
+            if (PlatformState.BenchmarkMode)
+            {
+                Delta = 1.f / 60.f;
+
+                if (PlatformState.Benchmark.State == BenchmarkRun_Running)
+                {
+                    ++PlatformState.Benchmark.FrameIndex;
+                }
+            }
+
             GameParameters.UnscaledDelta = Delta;
             GameParameters.UnscaledTime += GameParameters.UnscaledDelta;
 
             GameParameters.Time = GameParameters.UnscaledTime * GameParameters.TimeScale;
             GameParameters.Delta = GameParameters.UnscaledDelta * GameParameters.TimeScale;
 
+            // Frames spent streaming depend on the disk, the simulation doesn't advance so the runs stay deterministic
+            if (PlatformState.BenchmarkMode && PlatformState.Benchmark.State == BenchmarkRun_Streaming)
+            {
+                GameParameters.Delta = 0.f;
+            }
+
             LastPerformanceCounter = CurrentPerformanceCounter;
         }
 
@@ -1674,5 +2594,5 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         CoUninitialize();
     }
 
-    return 0;
+    return PlatformState.ExitCode;
 }
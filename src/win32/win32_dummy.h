@@ -18,6 +18,10 @@ struct win32_platform_state
     WINDOWPLACEMENT WindowPlacement;
     DWORD WindowStyles;
     CRITICAL_SECTION CriticalSection;
+    // Lock of the game events (see PublishEvent)
+    job_lock_stats CriticalSectionStats;
+    job_lock_stats CriticalSectionFrameStats;
+    u64 CriticalSectionAcquireTimestamp;
     
     u64 PerformanceFrequency;
 
@@ -50,9 +54,31 @@ struct win32_platform_state
 
     bool32 IsGameRunning;
 
+    // Frames of the profiler trace captured with the hotkey
+    u32 TraceFrameCount;
+    bool32 TraceRequested;
+
+    // --benchmark runs the scenario with a fixed delta and quits with a non-zero exit code on a regression
+    bool32 BenchmarkMode;
+    benchmark_run Benchmark;
+    // --microbench runs the micro-benchmarks right after the game init and quits
+    bool32 MicroBenchmarkMode;
+    char MicroBenchmarkFilter[64];
+    // --sweep repeats the benchmark for every value of a cvar
+    bool32 SweepMode;
+    benchmark_sweep Sweep;
+    i32 ExitCode;
+
+    // Shared with the game code, see Win32InitCVars
+    cvar_registry *CVars;
+    cvar *UpdateRateCVar;
+    cvar *ParallelForChunkCVar;
+    cvar *ReadCountersCVar;
+
     mouse_mode MouseMode;
 
     win32_job_queue_sync JobQueueSync;
+    win32_job_queue_sync BackgroundJobQueueSync;
 
     memory_arena Arena;
     stream Stream;
@@ -70,6 +96,9 @@ struct win32_game_code
     game_render_func *Render;
     game_frame_start_func *FrameStart;
     game_frame_end_func *FrameEnd;
+    game_load_benchmark_func *LoadBenchmark;
+    game_get_benchmark_status_func *GetBenchmarkStatus;
+    game_run_micro_benchmarks_func *RunMicroBenchmarks;
 
     bool32 IsValid;
 };
@@ -82,6 +111,8 @@ struct win32_file_attributes
 struct win32_worker_thread
 {
     job_queue *JobQueue;
+    u32 WorkerIndex;
+    char Name[32];
 };
 
 enum win32_renderer_backend
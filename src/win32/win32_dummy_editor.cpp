@@ -463,12 +463,18 @@ EditorRenderModelInfo(model *Model)
             ImGui::Checkbox(CheckboxLabel, (bool *)&Mesh->Visible);
 
             ImGui::Text("Vertices: %d", Mesh->VertexCount);
-            ImGui::Text("Indices: %d", Mesh->IndexCount);
+            ImGui::Text("Indices: %d", Mesh->Lods[0].IndexCount);
+
+            for (u32 LodIndex = 1; LodIndex < Mesh->LodCount; ++LodIndex)
+            {
+                mesh_lod *Lod = Mesh->Lods + LodIndex;
+                ImGui::Text("LOD %d Indices: %d (Error: %.4f)", LodIndex, Lod->IndexCount, Lod->Error);
+            }
 
             ImGui::NewLine();
 
             TotalVertexCount += Mesh->VertexCount;
-            TotalIndexCount += Mesh->IndexCount;
+            TotalIndexCount += Mesh->Lods[0].IndexCount;
         }
 
         ImGui::Text("Total Vertices: %d", TotalVertexCount);
@@ -903,7 +909,11 @@ EditorRenderAudioSourceInfo(audio_source *AudioSource, audio_commands *AudioComm
         ImGui::InputFloat("MinDistance##AudioSource", &AudioSource->MinDistance);
         ImGui::InputFloat("MaxDistance##AudioSource", &AudioSource->MaxDistance);
 
-        if (AudioSource->IsPlaying)
+        if (AudioSource->Pending)
+        {
+            ImGui::Text("Waiting for the audio clip to be streamed in");
+        }
+        else if (AudioSource->IsPlaying)
         {
             if (ImGui::Button("Pause##AudioSource"))
             {
@@ -998,7 +1008,7 @@ EditorRenderEntityInfo(
                         {
                             if (ImGui::Selectable(Model->Key))
                             {
-                                AddModel(GameState, Entity, Assets, Model->Key, RenderCommands, &GameState->WorldArea.Arena);
+                                AddModel(GameState, Entity, Assets, Model->Key, RenderCommands);
                                 EditorState->ModelFilter.Clear();
                             }
                         }
@@ -1024,7 +1034,7 @@ EditorRenderEntityInfo(
             {
                 if (ImGui::Button("Add##Collider"))
                 {
-                    AddBoxCollider(Entity, &GameState->WorldArea.Arena);
+                    AddBoxCollider(&GameState->WorldArea, Entity);
                     EditorState->AddEntity.Collider = {};
                 }
             }
@@ -1038,7 +1048,7 @@ EditorRenderEntityInfo(
                 {
                     Collider->Box.Offset = TranslateRotate(Collider->Translation, Collider->Rotation);
 
-                    AddBoxCollider(Entity, Collider->Box.HalfSize, Collider->Box.Offset, &GameState->WorldArea.Arena);
+                    AddBoxCollider(&GameState->WorldArea, Entity, Collider->Box.HalfSize, Collider->Box.Offset);
                     EditorState->AddEntity.Collider = {};
                 }
             }
@@ -1057,7 +1067,7 @@ EditorRenderEntityInfo(
 
             if (ImGui::Button("Add##RigidBody"))
             {
-                AddRigidBody(GameState, Entity, &GameState->WorldArea.Arena);
+                AddRigidBody(&GameState->WorldArea, Entity);
                 EditorState->AddEntity.RigidBody = {};
             }
         }
@@ -1109,7 +1119,7 @@ EditorRenderEntityInfo(
 
             if (ImGui::Button("Add##PointLight"))
             {
-                AddPointLight(Entity, PointLight->Color, PointLight->Attenuation, &GameState->WorldArea.Arena);
+                AddPointLight(&GameState->WorldArea, Entity, PointLight->Color, PointLight->Attenuation);
                 EditorState->AddEntity.PointLight = {};
             }
         }
@@ -1132,7 +1142,7 @@ EditorRenderEntityInfo(
 
             if (ImGui::Button("Add##ParticleEmitter"))
             {
-                AddParticleEmitter(Entity, ParticleEmitter->ParticleCount, ParticleEmitter->ParticlesSpawn, ParticleEmitter->Color, ParticleEmitter->Size, &GameState->WorldArea.Arena);
+                AddParticleEmitter(&GameState->WorldArea, Entity, ParticleEmitter->ParticleCount, ParticleEmitter->ParticlesSpawn, ParticleEmitter->Color, ParticleEmitter->Size);
                 EditorState->AddEntity.ParticleEmitter = {};
             }
         }
@@ -1179,7 +1189,7 @@ EditorRenderEntityInfo(
 
             if (ImGui::Button("Add##AudioSource"))
             {
-                AddAudioSource(GameState, Entity, GetAudioClipAsset(Assets, AudioSource->AudioClipRef), Entity->Transform.Translation, AudioSource->Volume, AudioSource->MinDistance, AudioSource->MaxDistance, AudioCommands, &GameState->WorldArea.Arena);
+                AddAudioSource(GameState, Entity, GetAudioClipAsset(Assets, AudioSource->AudioClipRef), Entity->Transform.Translation, AudioSource->Volume, AudioSource->MinDistance, AudioSource->MaxDistance, AudioCommands);
                 EditorState->AudioFilter.Clear();
             }
         }
@@ -1232,11 +1242,15 @@ dummy_internal void
 EditorAddEntity(editor_state *EditorState, game_state *GameState)
 {
     game_entity *Entity = CreateGameEntity(GameState);
-    Entity->Transform = CreateTransform();
 
-    GameState->SelectedEntity = Entity;
+    if (Entity)
+    {
+        Entity->Transform = CreateTransform();
 
-    EditorState->CurrentGizmoOperation = ImGuizmo::TRANSLATE;
+        GameState->SelectedEntity = Entity;
+
+        EditorState->CurrentGizmoOperation = ImGuizmo::TRANSLATE;
+    }
 }
 
 dummy_internal void
@@ -1244,11 +1258,610 @@ EditorCopyEntity(editor_state *EditorState, game_state *GameState, render_comman
 {
     game_entity *DestEntity = CreateGameEntity(GameState);
 
-    CopyGameEntity(GameState, RenderCommands, AudioCommands, SourceEntity, DestEntity);
+    if (DestEntity)
+    {
+        CopyGameEntity(GameState, RenderCommands, AudioCommands, SourceEntity, DestEntity);
 
-    GameState->SelectedEntity = DestEntity;
+        GameState->SelectedEntity = DestEntity;
 
-    EditorState->CurrentGizmoOperation = ImGuizmo::TRANSLATE;
+        EditorState->CurrentGizmoOperation = ImGuizmo::TRANSLATE;
+    }
+}
+
+dummy_internal ImVec4
+GetProfilerScopeColor(f32 Milliseconds)
+{
+    ImVec4 Result = ImVec4(0.f, 1.f, 0.f, 1.f);
+
+    if (Milliseconds >= 1.0f)
+    {
+        Result = ImVec4(1.f, 0.f, 0.f, 1.f);
+    }
+    else if (0.1f <= Milliseconds && Milliseconds < 1.f)
+    {
+        Result = ImVec4(1.f, 1.f, 0.f, 1.f);
+    }
+
+    return Result;
+}
+
+dummy_internal profiler_counter EditorProfilerMissCounters[] =
+{
+    ProfilerCounter_L1DataMisses,
+    ProfilerCounter_LastLevelCacheMisses,
+    ProfilerCounter_BranchMisses
+};
+
+// Columns are shown only for the counters the platform actually reads
+struct editor_profiler_counter_columns
+{
+    bool32 Cycles;
+    bool32 IPC;
+    bool32 Misses[ArrayCount(EditorProfilerMissCounters)];
+    u32 Count;
+};
+
+dummy_internal editor_profiler_counter_columns
+GetEditorProfilerCounterColumns(platform_profiler *Profiler)
+{
+    editor_profiler_counter_columns Result = {};
+
+    bool32 HasInstructions = IsProfilerCounterAvailable(Profiler, ProfilerCounter_Instructions);
+
+    Result.Cycles = IsProfilerCounterAvailable(Profiler, ProfilerCounter_Cycles);
+    Result.IPC = Result.Cycles && HasInstructions;
+    Result.Count = (Result.Cycles ? 1 : 0) + (Result.IPC ? 1 : 0);
+
+    for (u32 MissIndex = 0; MissIndex < ArrayCount(EditorProfilerMissCounters); ++MissIndex)
+    {
+        Result.Misses[MissIndex] = HasInstructions && IsProfilerCounterAvailable(Profiler, EditorProfilerMissCounters[MissIndex]);
+
+        if (Result.Misses[MissIndex])
+        {
+            Result.Count++;
+        }
+    }
+
+    return Result;
+}
+
+dummy_internal void
+EditorRenderProfilerNode(platform_profiler *Profiler, profiler_frame_samples *Frame, u32 NodeIndex)
+{
+    profiler_node *Node = Frame->Nodes + NodeIndex;
+
+    u64 ChildrenTicks = 0;
+    u32 ChildIndex = Node->FirstChildIndex;
+
+    while (ChildIndex != PROFILER_NO_NODE)
+    {
+        profiler_node *Child = Frame->Nodes + ChildIndex;
+        ChildrenTicks += Child->ElapsedTicks;
+        ChildIndex = Child->NextSiblingIndex;
+    }
+
+    u64 SelfTicks = Node->ElapsedTicks > ChildrenTicks ? Node->ElapsedTicks - ChildrenTicks : 0;
+
+    f32 TotalMilliseconds = GetProfilerMilliseconds(Profiler, Node->ElapsedTicks);
+    f32 SelfMilliseconds = GetProfilerMilliseconds(Profiler, SelfTicks);
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+
+    ImGuiTreeNodeFlags Flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+
+    if (Node->FirstChildIndex == PROFILER_NO_NODE)
+    {
+        Flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    }
+
+    ImGui::PushStyleColor(ImGuiCol_Text, GetProfilerScopeColor(TotalMilliseconds));
+    bool32 Open = ImGui::TreeNodeEx((void *) (umm) NodeIndex, Flags, "%s", GetProfilerName(Profiler, Node->NameIndex));
+    ImGui::PopStyleColor();
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%d", Node->CallCount);
+
+    ImGui::TableNextColumn();
+    ImGui::TextColored(GetProfilerScopeColor(TotalMilliseconds), "%.3f ms", TotalMilliseconds);
+
+    ImGui::TableNextColumn();
+    ImGui::TextColored(GetProfilerScopeColor(SelfMilliseconds), "%.3f ms", SelfMilliseconds);
+
+    editor_profiler_counter_columns Columns = GetEditorProfilerCounterColumns(Profiler);
+
+    if (Columns.Cycles)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f M", (f32) Node->Counters[ProfilerCounter_Cycles] / 1000000.f);
+    }
+
+    if (Columns.IPC)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", GetProfilerIPC(Node->Counters));
+    }
+
+    for (u32 MissIndex = 0; MissIndex < ArrayCount(Columns.Misses); ++MissIndex)
+    {
+        if (Columns.Misses[MissIndex])
+        {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", GetProfilerMPKI(Node->Counters, EditorProfilerMissCounters[MissIndex]));
+        }
+    }
+
+    if (Open && Node->FirstChildIndex != PROFILER_NO_NODE)
+    {
+        ChildIndex = Node->FirstChildIndex;
+
+        while (ChildIndex != PROFILER_NO_NODE)
+        {
+            EditorRenderProfilerNode(Profiler, Frame, ChildIndex);
+            ChildIndex = Frame->Nodes[ChildIndex].NextSiblingIndex;
+        }
+
+        ImGui::TreePop();
+    }
+}
+
+dummy_internal void
+EditorRenderProfilerThread(platform_profiler *Profiler, profiler_frame_samples *Frame, u32 ThreadIndex)
+{
+    bool32 HasNodes = false;
+
+    for (u32 NodeIndex = Frame->FirstRootIndex; NodeIndex != PROFILER_NO_NODE; NodeIndex = Frame->Nodes[NodeIndex].NextSiblingIndex)
+    {
+        if (Frame->Nodes[NodeIndex].ThreadIndex == ThreadIndex)
+        {
+            HasNodes = true;
+            break;
+        }
+    }
+
+    if (HasNodes)
+    {
+        profiler_thread *Thread = Profiler->Threads + ThreadIndex;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+
+        ImGui::PushID(ThreadIndex);
+        bool32 Open = ImGui::TreeNodeEx(Thread->Name, ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen);
+
+        if (Open)
+        {
+            for (u32 NodeIndex = Frame->FirstRootIndex; NodeIndex != PROFILER_NO_NODE; NodeIndex = Frame->Nodes[NodeIndex].NextSiblingIndex)
+            {
+                if (Frame->Nodes[NodeIndex].ThreadIndex == ThreadIndex)
+                {
+                    EditorRenderProfilerNode(Profiler, Frame, NodeIndex);
+                }
+            }
+
+            ImGui::TreePop();
+        }
+
+        ImGui::PopID();
+    }
+}
+
+// Hardware counters are inclusive, misses are per thousand instructions
+dummy_internal void
+EditorRenderProfilerFrame(platform_profiler *Profiler, profiler_frame_samples *Frame, const char *TableName, ImGuiTableFlags TableFlags)
+{
+    editor_profiler_counter_columns Columns = GetEditorProfilerCounterColumns(Profiler);
+
+    if (ImGui::BeginTable(TableName, 4 + Columns.Count, TableFlags))
+    {
+        ImGui::TableSetupColumn("Scope", 0, 3.f);
+        ImGui::TableSetupColumn("Calls", 0, 1.f);
+        ImGui::TableSetupColumn("Total", 0, 1.f);
+        ImGui::TableSetupColumn("Self", 0, 1.f);
+
+        if (Columns.Cycles)
+        {
+            ImGui::TableSetupColumn("Cycles", 0, 1.f);
+        }
+
+        if (Columns.IPC)
+        {
+            ImGui::TableSetupColumn("IPC", 0, 1.f);
+        }
+
+        const char *MissColumnNames[] = { "L1D MPKI", "LLC MPKI", "Branch MPKI" };
+
+        for (u32 MissIndex = 0; MissIndex < ArrayCount(Columns.Misses); ++MissIndex)
+        {
+            if (Columns.Misses[MissIndex])
+            {
+                ImGui::TableSetupColumn(MissColumnNames[MissIndex], 0, 1.f);
+            }
+        }
+
+        ImGui::TableHeadersRow();
+
+        u32 ThreadCount = GetProfilerThreadCount(Profiler);
+
+        for (u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            EditorRenderProfilerThread(Profiler, Frame, ThreadIndex);
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+dummy_internal void
+EditorRenderLockStats(platform_profiler *Profiler, const char *Name, job_lock_stats *Lock)
+{
+    f32 MeanWaitMicroseconds = Lock->AcquireCount > 0 ? GetProfilerMilliseconds(Profiler, Lock->WaitTicks) * 1000.f / (f32) Lock->AcquireCount : 0.f;
+    f32 MeanHoldMicroseconds = Lock->AcquireCount > 0 ? GetProfilerMilliseconds(Profiler, Lock->HoldTicks) * 1000.f / (f32) Lock->AcquireCount : 0.f;
+
+    ImGui::Text(
+        "%s: %d acquires, wait %.2f us (max %.2f us), hold %.2f us (max %.2f us)",
+        Name,
+        Lock->AcquireCount,
+        MeanWaitMicroseconds,
+        GetProfilerMilliseconds(Profiler, Lock->MaxWaitTicks) * 1000.f,
+        MeanHoldMicroseconds,
+        GetProfilerMilliseconds(Profiler, Lock->MaxHoldTicks) * 1000.f
+    );
+}
+
+// Stats of the previous frame, imbalance is the slowest job of a batch against the mean job of the batch
+dummy_internal void
+EditorRenderJobQueue(platform_profiler *Profiler, const char *Name, job_queue *JobQueue, ImGuiTableFlags TableFlags)
+{
+    job_queue_stats *Stats = JobQueue->Stats;
+    job_queue_frame *Frame = &Stats->LastFrame;
+
+    ImGui::PushID(Name);
+
+    if (ImGui::TreeNodeEx(Name, ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        char DepthOverlay[32];
+        FormatString(DepthOverlay, "max depth %d", Frame->MaxQueueDepth);
+
+        ImGui::PlotLines("Queue depth", Stats->QueueDepthHistory, JOB_STATS_HISTORY_COUNT, Stats->HistoryIndex, DepthOverlay, 0.f, F32_MAX, ImVec2(0.f, 40.f));
+
+        EditorRenderLockStats(Profiler, "Queue lock", &Frame->Lock);
+
+        if (ImGui::BeginTable("Workers", 6, TableFlags))
+        {
+            ImGui::TableSetupColumn("Worker", 0, 1.f);
+            ImGui::TableSetupColumn("Jobs", 0, 1.f);
+            ImGui::TableSetupColumn("Busy", 0, 1.f);
+            ImGui::TableSetupColumn("Idle", 0, 1.f);
+            ImGui::TableSetupColumn("Dequeue", 0, 1.f);
+            ImGui::TableSetupColumn("Lock Wait", 0, 1.f);
+            ImGui::TableHeadersRow();
+
+            for (u32 WorkerIndex = 0; WorkerIndex < Frame->WorkerCount; ++WorkerIndex)
+            {
+                job_worker_stats *Worker = Frame->Workers + WorkerIndex;
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", WorkerIndex);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", Worker->JobCount);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Worker->BusyTicks));
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Worker->IdleTicks));
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Worker->DequeueTicks));
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Worker->LockWaitTicks));
+            }
+
+            ImGui::EndTable();
+        }
+
+        if (Frame->StageCount > 0 && ImGui::BeginTable("Stages", 6, TableFlags))
+        {
+            ImGui::TableSetupColumn("Stage", 0, 3.f);
+            ImGui::TableSetupColumn("Batches / Jobs", 0, 1.f);
+            ImGui::TableSetupColumn("Mean Job", 0, 1.f);
+            ImGui::TableSetupColumn("Slowest Job", 0, 1.f);
+            ImGui::TableSetupColumn("Imbalance", 0, 1.f);
+            ImGui::TableSetupColumn("Wait", 0, 1.f);
+            ImGui::TableHeadersRow();
+
+            for (u32 StageIndex = 0; StageIndex < Frame->StageCount; ++StageIndex)
+            {
+                job_stage_stats *Stage = Frame->Stages + StageIndex;
+
+                f32 Imbalance = GetJobStageImbalance(Stage);
+                ImVec4 Color = Imbalance >= 2.f ? ImVec4(1.f, 0.f, 0.f, 1.f) : ImVec4(1.f, 1.f, 1.f, 1.f);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", Stage->Name);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%d / %d", Stage->BatchCount, Stage->JobCount);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Stage->MeanJobTicks));
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Stage->SlowestJobTicks));
+
+                ImGui::TableNextColumn();
+                ImGui::TextColored(Color, "%.2f", Imbalance);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", GetProfilerMilliseconds(Profiler, Stage->WaitTicks));
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::TreePop();
+    }
+
+    ImGui::PopID();
+}
+
+inline void
+EditorRenderParallelLoop(platform_profiler *Profiler, const char *Name, parallel_for_site *Site)
+{
+    ImGui::TableNextColumn();
+    ImGui::Text("%s", Name);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%d", Site->ItemCount);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%d", Site->JobCount);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%d", Site->ChunkSize);
+
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f us", Site->TicksPerItem / (f32) Profiler->TicksPerSecond * 1000000.f);
+}
+
+// Chunking picked by ParallelFor from the measured cost per item
+dummy_internal void
+EditorRenderParallelLoops(platform_profiler *Profiler, game_state *GameState, ImGuiTableFlags TableFlags)
+{
+    if (ImGui::BeginTable("Parallel loops", 5, TableFlags))
+    {
+        ImGui::TableSetupColumn("Loop", 0, 3.f);
+        ImGui::TableSetupColumn("Items", 0, 1.f);
+        ImGui::TableSetupColumn("Jobs", 0, 1.f);
+        ImGui::TableSetupColumn("Chunk", 0, 1.f);
+        ImGui::TableSetupColumn("Per Item", 0, 1.f);
+        ImGui::TableHeadersRow();
+
+        EditorRenderParallelLoop(Profiler, "UpdateEntities", &GameState->UpdateEntitiesLoop);
+        EditorRenderParallelLoop(Profiler, "AnimateEntities", &GameState->AnimateEntitiesLoop);
+        EditorRenderParallelLoop(Profiler, "ProcessEntities", &GameState->ProcessEntitiesLoop);
+        EditorRenderParallelLoop(Profiler, "TestOcclusion", &GameState->TestOcclusionLoop);
+        EditorRenderParallelLoop(Profiler, "CullMeshClusters", &GameState->CullMeshClustersLoop);
+        EditorRenderParallelLoop(Profiler, "ProcessParticles", &GameState->ProcessParticlesLoop);
+
+        ImGui::EndTable();
+    }
+}
+
+// Percentiles of the last few seconds, p99 is red once it's over the budget
+dummy_internal void
+EditorRenderFrameBudget(platform_profiler *Profiler, ImGuiTableFlags TableFlags)
+{
+    profiler_frame_budget *Budget = Profiler->FrameBudget;
+    profiler_trace *Trace = &Profiler->Trace;
+
+    ImGui::InputFloat("Budget (ms)", &Budget->BudgetMilliseconds, 0.5f, 1.f, "%.2f");
+    ImGui::Checkbox("Capture spikes", (bool *) &Budget->CaptureSpikes);
+    ImGui::SameLine();
+    ImGui::Text("Captured: %d / %d, over budget: %d of %d frames", Trace->SpikeCount, Budget->MaxSpikeCaptureCount, Budget->OverBudgetFrameCount, Budget->FrameCount);
+
+    if (Trace->SpikeCount >= Budget->MaxSpikeCaptureCount)
+    {
+        ImGui::SameLine();
+
+        if (ImGui::Button("Capture more"))
+        {
+            Budget->MaxSpikeCaptureCount += 8;
+        }
+    }
+
+    if (Budget->TrackCount > 0)
+    {
+        profiler_budget_track *FrameTrack = Budget->Tracks;
+
+        // Frame time buckets up to the last one that has any frames
+        u32 BucketCount = 1;
+        f32 Buckets[FRAME_BUDGET_BUCKET_COUNT];
+
+        for (u32 Bucket = 0; Bucket < FRAME_BUDGET_BUCKET_COUNT; ++Bucket)
+        {
+            Buckets[Bucket] = (f32) FrameTrack->Buckets[Bucket];
+
+            if (FrameTrack->Buckets[Bucket] > 0)
+            {
+                BucketCount = Bucket + 1;
+            }
+        }
+
+        char Overlay[64];
+        FormatString(Overlay, "up to %.2f ms", GetFrameBudgetBucketMilliseconds(BucketCount - 1));
+
+        ImGui::PlotHistogram("Frame time histogram", Buckets, BucketCount, 0, Overlay, 0.f, F32_MAX, ImVec2(0.f, 60.f));
+    }
+
+    // Fixed updates per frame
+    u32 FrameCount = Budget->FrameCount < FRAME_BUDGET_HISTORY_COUNT ? Budget->FrameCount : FRAME_BUDGET_HISTORY_COUNT;
+
+    ImGui::Text("Fixed steps per frame:");
+
+    for (u32 StepCount = 0; StepCount <= FRAME_BUDGET_MAX_UPDATE_STEP_COUNT; ++StepCount)
+    {
+        if (Budget->UpdateStepBuckets[StepCount] > 0)
+        {
+            ImGui::SameLine();
+            ImGui::Text(" %d%s: %.1f%%", StepCount, StepCount == FRAME_BUDGET_MAX_UPDATE_STEP_COUNT ? "+" : "", (f32) Budget->UpdateStepBuckets[StepCount] * 100.f / (f32) FrameCount);
+        }
+    }
+
+    if (ImGui::BeginTable("Frame budget", 5, TableFlags))
+    {
+        ImGui::TableSetupColumn("Track", 0, 3.f);
+        ImGui::TableSetupColumn("p50", 0, 1.f);
+        ImGui::TableSetupColumn("p95", 0, 1.f);
+        ImGui::TableSetupColumn("p99", 0, 1.f);
+        ImGui::TableSetupColumn("p99 / Budget", 0, 1.f);
+        ImGui::TableHeadersRow();
+
+        for (u32 TrackIndex = 0; TrackIndex < Budget->TrackCount; ++TrackIndex)
+        {
+            profiler_budget_track *Track = Budget->Tracks + TrackIndex;
+
+            f32 P99 = GetProfilerBudgetPercentile(Track, 0.99f);
+            ImVec4 Color = P99 > Budget->BudgetMilliseconds ? ImVec4(1.f, 0.f, 0.f, 1.f) : ImVec4(1.f, 1.f, 1.f, 1.f);
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%s", Track->Name);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f ms", GetProfilerBudgetPercentile(Track, 0.5f));
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f ms", GetProfilerBudgetPercentile(Track, 0.95f));
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%.3f ms", P99);
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%.0f%%", P99 * 100.f / Budget->BudgetMilliseconds);
+        }
+
+        ImGui::EndTable();
+    }
+
+    // Call tree of the last frame that went over the budget, its timeline is on disk
+    if (Trace->SpikeCount > 0)
+    {
+        profiler_frame_samples *SpikeFrame = Trace->SpikeFrame;
+        f32 SpikeMilliseconds = GetProfilerMilliseconds(Profiler, SpikeFrame->EndTimestamp - SpikeFrame->StartTimestamp);
+
+        char SpikeLabel[64];
+        FormatString(SpikeLabel, "Last spike: %.3f ms###Last spike", SpikeMilliseconds);
+
+        if (ImGui::TreeNode(SpikeLabel))
+        {
+            EditorRenderProfilerFrame(Profiler, SpikeFrame, "Spike stats", TableFlags);
+            ImGui::TreePop();
+        }
+    }
+}
+
+// Edits go through SetCVarValue, so the owners see the version change. Values without an owner yet are only listed
+dummy_internal void
+EditorRenderCVars(editor_state *EditorState, cvar_registry *Registry, ImGuiTableFlags TableFlags)
+{
+    if (ImGui::Button("Save config"))
+    {
+        scoped_memory ScopedMemory(&EditorState->Arena);
+
+        memory_arena *Arena = ScopedMemory.Arena;
+        umm StartUsed = Arena->Used;
+
+        SaveCVarConfig(Registry, Arena);
+        EditorState->Platform->WriteFile((char *) CVAR_CONFIG_FILE_NAME, (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+    }
+
+    ImGui::SameLine();
+    ImGui::Text("Non-default values go to %s", CVAR_CONFIG_FILE_NAME);
+
+    if (ImGui::BeginTable("Console variables", 3, TableFlags))
+    {
+        ImGui::TableSetupColumn("Name", 0, 2.f);
+        ImGui::TableSetupColumn("Value", 0, 2.f);
+        ImGui::TableSetupColumn("Default", 0, 1.f);
+        ImGui::TableHeadersRow();
+
+        for (u32 CVarIndex = 0; CVarIndex < Registry->CVarCount; ++CVarIndex)
+        {
+            cvar *CVar = Registry->CVars + CVarIndex;
+
+            ImGui::PushID(CVarIndex);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", CVar->Name);
+
+            if (CVar->Description[0] && ImGui::IsItemHovered())
+            {
+                ImGui::SetTooltip("%s", CVar->Description);
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::SetNextItemWidth(-1.f);
+
+            cvar_value Value = CVar->Value;
+
+            switch (CVar->Type)
+            {
+                case CVarType_Bool:
+                {
+                    if (ImGui::Checkbox("##Value", (bool *) &Value.Bool))
+                    {
+                        SetCVarValue(CVar, Value);
+                    }
+
+                    break;
+                }
+                case CVarType_Int:
+                {
+                    if (ImGui::DragInt("##Value", &Value.Int, 1.f, CVar->Min.Int, CVar->Max.Int))
+                    {
+                        SetCVarValue(CVar, Value);
+                    }
+
+                    break;
+                }
+                case CVarType_Float:
+                {
+                    f32 Speed = (CVar->Max.Float - CVar->Min.Float) / 1000.f;
+
+                    if (ImGui::DragFloat("##Value", &Value.Float, Speed, CVar->Min.Float, CVar->Max.Float, "%g"))
+                    {
+                        SetCVarValue(CVar, Value);
+                    }
+
+                    break;
+                }
+                default:
+                {
+                    ImGui::TextDisabled("%s (not registered)", CVar->PendingValue);
+                }
+            }
+
+            ImGui::TableNextColumn();
+
+            if (IsCVarRegistered(CVar))
+            {
+                char Default[CVAR_MAX_VALUE_LENGTH];
+                FormatCVarValue(CVar->Type, CVar->Default, Default, ArrayCount(Default));
+
+                if (ImGui::Button(Default))
+                {
+                    SetCVarValue(CVar, CVar->Default);
+                }
+            }
+
+            ImGui::PopID();
+        }
+
+        ImGui::EndTable();
+    }
 }
 
 dummy_internal void
@@ -1509,6 +2122,9 @@ Win32RenderEditor(
                         ImGui::TableNextColumn();
                         ImGui::Checkbox("Show Skybox", (bool *)&GameState->Options.ShowSkybox);
 
+                        ImGui::TableNextColumn();
+                        ImGui::Checkbox("Occlusion Culling", (bool *)&GameState->Options.EnableOcclusionCulling);
+
                         ImGui::TableNextColumn();
                         ImGui::Checkbox("FullScreen", (bool *)&PlatformState->IsFullScreen.Value);
 
@@ -1518,6 +2134,42 @@ Win32RenderEditor(
                         ImGui::EndTable();
                     }
 
+                    ImGui::SliderFloat("LOD Screen Error (px)", &GameState->Options.MaxLodScreenError, 0.f, 16.f);
+
+                    ImGui::Text("Clusters: %d / %d", GameState->VisibleClusterCount, GameState->TotalClusterCount);
+                    ImGui::Text("Triangles: %d / %d", GameState->SubmittedTriangleCount, GameState->TotalTriangleCount);
+                    ImGui::Text("Assets Load Time: %.2f ms (%s)", GameState->Assets.LoadTime, GameState->Assets.Pack.Contents ? "pack" : "loose files");
+
+                    ImGui::SliderInt("Asset Memory Budget (MB)", &GameState->Options.AssetMemoryBudget, 16, Max(GameState->Assets.MaxMemoryBudget, 16));
+                    ImGui::Text(
+                        "Resident Models: %d, Textures: %d, Audio Clips: %d (%.2f MB), Loading: %d",
+                        GameState->Assets.ResidentModelCount,
+                        GameState->Assets.ResidentTextureCount,
+                        GameState->Assets.ResidentAudioClipCount,
+                        (f32)GameState->Assets.AssetAllocator.Used / (f32)Megabytes(1),
+                        GameState->Assets.LoadingAssetCount
+                    );
+
+                    ImGui::SliderFloat("Cell Load Radius", &GameState->Options.CellLoadRadius, WORLD_AREA_CHUNK_SIZE, 1024.f);
+                    ImGui::SliderFloat("Cell Unload Radius", &GameState->Options.CellUnloadRadius, GameState->Options.CellLoadRadius, 1024.f + WORLD_AREA_CHUNK_SIZE);
+
+                    if (GameState->WorldArea.Partition.Active)
+                    {
+                        world_partition *Partition = &GameState->WorldArea.Partition;
+
+                        ImGui::Text(
+                            "Resident Cells: %d / %d, Loading: %d",
+                            Partition->ResidentCellCount,
+                            Partition->CellCount.x * Partition->CellCount.y,
+                            Partition->LoadingCellCount
+                        );
+                    }
+
+                    if (ImGui::MenuItem("Dump Occlusion Buffer"))
+                    {
+                        GameState->DumpOcclusionBuffer = true;
+                    }
+
                     ImGui::EndMenu();
                 }
 
@@ -1572,7 +2224,7 @@ Win32RenderEditor(
                             model_asset *ModelAsset = LoadModelAsset(Platform, GameAssetPath, &Assets->Arena);
 
                             model *Model = GetModelAsset(Assets, AssetName);
-                            InitModel(GameState, ModelAsset, Model, AssetName, &Assets->Arena, RenderCommands);
+                            ReplaceModel(GameState, Assets, Platform, ModelAsset, Model, AssetName, RenderCommands);
 
                             Out(&GameState->PermanentStream, "Loaded: %s", FilePath);
                         }
@@ -1684,77 +2336,208 @@ Win32RenderEditor(
     platform_profiler *Profiler = GameMemory->Profiler;
     profiler_frame_samples *FrameSamples = ProfilerGetPreviousFrameSamples(Profiler);
 
-    f32 *ElapsedMillisecondsValues = PushArray(ScopedMemory.Arena, FrameSamples->SampleCount, f32);
+    // Frame times from the oldest to the latest completed frame
+    u32 FrameCount = Profiler->MaxFrameSampleCount - 1;
+    f32 *FrameMilliseconds = PushArray(ScopedMemory.Arena, FrameCount, f32);
+
+    for (u32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        u32 SampleIndex = (Profiler->CurrentFrameSampleIndex + 1 + FrameIndex) % Profiler->MaxFrameSampleCount;
+        profiler_frame_samples *Frame = Profiler->FrameSamples + SampleIndex;
+
+        FrameMilliseconds[FrameIndex] = Frame->EndTimestamp > Frame->StartTimestamp
+            ? GetProfilerMilliseconds(Profiler, Frame->EndTimestamp - Frame->StartTimestamp)
+            : 0.f;
+    }
+
+    f32 LastFrameMilliseconds = GetProfilerMilliseconds(Profiler, FrameSamples->EndTimestamp - FrameSamples->StartTimestamp);
+
+    char FrameTimeOverlay[32];
+    FormatString(FrameTimeOverlay, "%.3f ms", LastFrameMilliseconds);
+
+    ImGui::PlotLines("Frame timing", FrameMilliseconds, FrameCount, 0, FrameTimeOverlay, 0.f, F32_MAX, ImVec2(0.f, 60.f));
+
+    // Trace of the next frames for the external viewers (F11 captures it as well)
+    ImGui::InputInt("Trace frames", (i32 *) &PlatformState->TraceFrameCount);
+    ImGui::SameLine();
 
-    for (u32 SampleIndex = 0; SampleIndex < FrameSamples->SampleCount; ++SampleIndex)
+    // Trace takes over the spike watch
+    if (Profiler->Trace.State == ProfilerTrace_Idle || Profiler->Trace.WatchingSpikes)
     {
-        profiler_sample *Sample = FrameSamples->Samples + SampleIndex;
-        f32 *ElapsedMilliseconds = ElapsedMillisecondsValues + SampleIndex;
-        *ElapsedMilliseconds = Sample->ElapsedMilliseconds;
+        if (ImGui::Button("Capture trace"))
+        {
+            PlatformState->TraceRequested = true;
+        }
+    }
+    else
+    {
+        ImGui::Text("Capturing: %d / %d frames", Profiler->Trace.FrameCount, Profiler->Trace.RequestedFrameCount);
     }
 
-    ImGui::PlotLines("Frame timing", ElapsedMillisecondsValues, FrameSamples->SampleCount);
+    if (FrameSamples->DroppedEventCount > 0)
+    {
+        ImGui::TextColored(ImVec4(1.f, 0.f, 0.f, 1.f), "Dropped events: %d", FrameSamples->DroppedEventCount);
+    }
+
+    ImGuiTableFlags ProfilerTableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_RowBg;
 
-    if (ImGui::BeginTable("Profiler stats", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp))
+    if (ImGui::CollapsingHeader("Frame budget", ImGuiTreeNodeFlags_DefaultOpen))
     {
-        ImGui::TableSetupColumn("Block", 0, 3.f);
-        ImGui::TableSetupColumn("Ticks", 0, 1.f);
-        ImGui::TableSetupColumn("Milliseconds", 0, 1.f);
-        ImGui::TableHeadersRow();
+        EditorRenderFrameBudget(Profiler, ProfilerTableFlags);
+    }
+
+    if (ImGui::CollapsingHeader("Jobs"))
+    {
+        EditorRenderJobQueue(Profiler, "Job Queue", GameMemory->JobQueue, ProfilerTableFlags);
+        EditorRenderJobQueue(Profiler, "Background Job Queue", GameMemory->BackgroundJobQueue, ProfilerTableFlags);
+        EditorRenderParallelLoops(Profiler, GameState, ProfilerTableFlags);
+        EditorRenderLockStats(Profiler, "Platform lock", &PlatformState->CriticalSectionFrameStats);
+    }
+
+    if (ImGui::CollapsingHeader("Console variables"))
+    {
+        EditorRenderCVars(EditorState, PlatformState->CVars, ProfilerTableFlags);
+    }
 
-        u64 TotalTicks = 0;
-        f32 TotalMilliseconds = 0.f;
+    EditorRenderProfilerFrame(Profiler, FrameSamples, "Profiler stats", ProfilerTableFlags);
 
-        for (u32 SampleIndex = 0; SampleIndex < FrameSamples->SampleCount; ++SampleIndex)
+    if (ImGui::Button("Dump frame CSV"))
+    {
+        scoped_memory ScopedMemory(&EditorState->Arena);
+
+        memory_arena *Arena = ScopedMemory.Arena;
+        umm StartUsed = Arena->Used;
+
+        WriteProfilerFrameCSV(Profiler, FrameSamples, Arena);
+        EditorState->Platform->WriteFile((char *) "profiler_frame.csv", (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+    }
+
+    ImGui::SameLine();
+
+    if (ImGui::Button("Dump memory CSV"))
+    {
+        scoped_memory ScopedMemory(&EditorState->Arena);
+
+        memory_arena *Arena = ScopedMemory.Arena;
+        umm StartUsed = Arena->Used;
+
+        WriteMemoryTelemetryCSV(Profiler, Arena);
+        EditorState->Platform->WriteFile((char *) "memory_telemetry.csv", (u8 *) Arena->Base + StartUsed, (u32) (Arena->Used - StartUsed));
+    }
+
+    if (ImGui::BeginTable("Memory stats", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Allocator", 0, 3.f);
+        ImGui::TableSetupColumn("Used (KB)", 0, 1.f);
+        ImGui::TableSetupColumn("High Water (KB)", 0, 1.f);
+        ImGui::TableSetupColumn("Committed / Size (KB)", 0, 2.f);
+        ImGui::TableSetupColumn("Allocations", 0, 1.f);
+        ImGui::TableSetupColumn("Frame Allocs", 0, 1.f);
+        ImGui::TableSetupColumn("Frame (KB)", 0, 1.f);
+        ImGui::TableHeadersRow();
+
+        for (u32 SampleIndex = 0; SampleIndex < FrameSamples->MemorySampleCount; ++SampleIndex)
         {
-            profiler_sample *Sample = FrameSamples->Samples + SampleIndex;
+            profiler_memory_sample *Sample = FrameSamples->MemorySamples + SampleIndex;
+            memory_stats *Stats = &Sample->Stats;
 
             ImVec4 Color = ImVec4(0.f, 1.f, 0.f, 1.f);
 
-            if (Sample->ElapsedMilliseconds >= 1.0f)
+            if (Stats->Size > 0 && Stats->HighWater >= Stats->Size / 10 * 9)
             {
                 Color = ImVec4(1.f, 0.f, 0.f, 1.f);
             }
-            else if (0.1f <= Sample->ElapsedMilliseconds && Sample->ElapsedMilliseconds < 1.f)
-            {
-                Color = ImVec4(1.f, 1.f, 0.f, 1.f);
-            }
 
             ImGui::TableNextColumn();
             ImGui::TextColored(Color, "%s", Sample->Name);
 
             ImGui::TableNextColumn();
-            ImGui::TextColored(Color, "%d ticks", Sample->ElapsedTicks);
+            ImGui::TextColored(Color, "%llu", Stats->Used / 1024);
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%llu", Stats->HighWater / 1024);
 
             ImGui::TableNextColumn();
-            ImGui::TextColored(Color, "%.3f ms", Sample->ElapsedMilliseconds);
+            ImGui::TextColored(Color, "%llu / %llu", Stats->Committed / 1024, Stats->Size / 1024);
 
-            TotalTicks += Sample->ElapsedTicks;
-            TotalMilliseconds += Sample->ElapsedMilliseconds;
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%d", Stats->AllocationCount);
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%d", Stats->FrameAllocationCount);
+
+            ImGui::TableNextColumn();
+            ImGui::TextColored(Color, "%.1f", (f32) Stats->FrameAllocatedSize / 1024.f);
         }
 
-        ImVec4 Color = ImVec4(0.f, 1.f, 0.f, 1.f);
+        ImGui::EndTable();
+    }
+
+#if MEMORY_TELEMETRY
+    memory_telemetry *Telemetry = Profiler->MemoryTelemetry;
+
+    if (Telemetry && ImGui::CollapsingHeader("Allocation call sites"))
+    {
+        // Heaviest call sites first
+        u32 CallSiteCount = 0;
+        memory_call_site **CallSites = PushArray(ScopedMemory.Arena, MEMORY_MAX_CALL_SITE_COUNT, memory_call_site *);
 
-        if (TotalMilliseconds >= 4.0f)
+        for (u32 CallSiteIndex = 0; CallSiteIndex < MEMORY_MAX_CALL_SITE_COUNT; ++CallSiteIndex)
         {
-            Color = ImVec4(1.f, 0.f, 0.f, 1.f);
+            memory_call_site *CallSite = Telemetry->CallSites + CallSiteIndex;
+
+            if (CallSite->State == MemoryCallSite_Ready)
+            {
+                u32 InsertIndex = CallSiteCount++;
+
+                while (InsertIndex > 0 && CallSites[InsertIndex - 1]->PeakFrameSize < CallSite->PeakFrameSize)
+                {
+                    CallSites[InsertIndex] = CallSites[InsertIndex - 1];
+                    --InsertIndex;
+                }
+
+                CallSites[InsertIndex] = CallSite;
+            }
         }
-        else if (1.f <= TotalMilliseconds && TotalMilliseconds < 4.f)
+
+        if (ImGui::BeginTable("Allocation call sites", 6, ProfilerTableFlags | ImGuiTableFlags_ScrollY, ImVec2(0.f, 300.f)))
         {
-            Color = ImVec4(1.f, 1.f, 0.f, 1.f);
-        }
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Call Site", 0, 3.f);
+            ImGui::TableSetupColumn("Kind", 0, 1.f);
+            ImGui::TableSetupColumn("Frame Allocs", 0, 1.f);
+            ImGui::TableSetupColumn("Frame (KB)", 0, 1.f);
+            ImGui::TableSetupColumn("Peak Allocs / KB", 0, 2.f);
+            ImGui::TableSetupColumn("Total (KB)", 0, 1.f);
+            ImGui::TableHeadersRow();
+
+            for (u32 CallSiteIndex = 0; CallSiteIndex < CallSiteCount; ++CallSiteIndex)
+            {
+                memory_call_site *CallSite = CallSites[CallSiteIndex];
 
-        ImGui::TableNextColumn();
-        ImGui::TextColored(Color, "Total");
+                ImGui::TableNextColumn();
+                ImGui::Text("%s:%d", CallSite->FileName, CallSite->Line);
 
-        ImGui::TableNextColumn();
-        ImGui::TextColored(Color, "%d ticks", TotalTicks);
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", CallSite->Region ? "Region" : "Push");
 
-        ImGui::TableNextColumn();
-        ImGui::TextColored(Color, "%.3f ms", TotalMilliseconds);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", CallSite->LastFrameCount);
 
-        ImGui::EndTable();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", (f32) CallSite->LastFrameSize / 1024.f);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%d / %.1f", CallSite->PeakFrameCount, (f32) CallSite->PeakFrameSize / 1024.f);
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", CallSite->TotalSize / 1024);
+            }
+
+            ImGui::EndTable();
+        }
     }
+#endif
 
     ImGui::End();
 
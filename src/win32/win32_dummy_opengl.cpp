@@ -68,6 +68,11 @@ Win32InitOpenGL(opengl_state *State, win32_platform_state *PlatformState)
 
     State->WindowDC = GetDC(PlatformState->WindowHandle);
 
+    State->CascadeShadowMapSizeCVar = RegisterCVarInt(
+        PlatformState->CVars, "render.cascade_shadow_map_size", 4096, 256, 8192,
+        "Width and height of each shadow cascade"
+    );
+
     WNDCLASS FakeWindowClass = {};
     FakeWindowClass.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
     FakeWindowClass.lpfnWndProc = DefWindowProc;
@@ -292,6 +297,25 @@ OpenGLVertexAttributeInteger(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 Ele
     glVertexArrayAttribBinding(VAO, AttributeIndex, AttributeIndex);
 }
 
+// Normalized integer types are converted to [0, 1] (unsigned) or [-1, 1] (signed) floats
+inline void
+OpenGLPackedVertexAttribute(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 ElementCount, GLenum Type, GLboolean Normalized, u32 Offset, u32 Stride)
+{
+    glEnableVertexArrayAttrib(VAO, AttributeIndex);
+    glVertexArrayAttribFormat(VAO, AttributeIndex, ElementCount, Type, Normalized, 0);
+    glVertexArrayVertexBuffer(VAO, AttributeIndex, VBO, Offset, Stride);
+    glVertexArrayAttribBinding(VAO, AttributeIndex, AttributeIndex);
+}
+
+inline void
+OpenGLPackedVertexAttributeInteger(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 ElementCount, GLenum Type, u32 Offset, u32 Stride)
+{
+    glEnableVertexArrayAttrib(VAO, AttributeIndex);
+    glVertexArrayAttribIFormat(VAO, AttributeIndex, ElementCount, Type, 0);
+    glVertexArrayVertexBuffer(VAO, AttributeIndex, VBO, Offset, Stride);
+    glVertexArrayAttribBinding(VAO, AttributeIndex, AttributeIndex);
+}
+
 inline void
 OpenGLInstanceAttribute(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 ElementCount, u32 Offset, u32 RelativeOffset, u32 Stride)
 {
@@ -302,6 +326,16 @@ OpenGLInstanceAttribute(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 ElementC
     glVertexArrayBindingDivisor(VAO, AttributeIndex, 1);
 }
 
+inline void
+OpenGLInstanceAttributeInteger(GLuint VAO, GLuint VBO, u32 AttributeIndex, u32 ElementCount, u32 Offset, u32 RelativeOffset, u32 Stride)
+{
+    glEnableVertexArrayAttrib(VAO, AttributeIndex);
+    glVertexArrayAttribIFormat(VAO, AttributeIndex, ElementCount, GL_UNSIGNED_INT, RelativeOffset);
+    glVertexArrayVertexBuffer(VAO, AttributeIndex, VBO, Offset, Stride);
+    glVertexArrayAttribBinding(VAO, AttributeIndex, AttributeIndex);
+    glVertexArrayBindingDivisor(VAO, AttributeIndex, 1);
+}
+
 dummy_internal void
 OpenGLInitLine(opengl_state *State)
 {
@@ -447,6 +481,16 @@ OpenGLGetSkinningBuffer(opengl_state *State, u32 Id)
     return Result;
 }
 
+inline opengl_instance_buffer *
+OpenGLGetInstanceBuffer(opengl_state *State, u32 Id)
+{
+    opengl_instance_buffer *Result = HashTableLookup(&State->InstanceBuffers, Id);
+
+    Assert(Result);
+
+    return Result;
+}
+
 inline opengl_texture *
 OpenGLGetTexture(opengl_state *State, u32 Id)
 {
@@ -477,58 +521,6 @@ OpenGLGetSkybox(opengl_state *State, u32 Id)
     return Result;
 }
 
-inline u32
-GetMeshVerticesSize(
-    u32 VertexCount,
-    vec3 *Positions,
-    vec3 *Normals,
-    vec3 *Tangents,
-    vec3 *Bitangents,
-    vec2 *TextureCoords,
-    vec4 *Weights,
-    ivec4 *JointIndices
-)
-{
-    u32 Size = 0;
-
-    if (Positions)
-    {
-        Size += VertexCount * sizeof(vec3);
-    }
-
-    if (Normals)
-    {
-        Size += VertexCount * sizeof(vec3);
-    }
-
-    if (Tangents)
-    {
-        Size += VertexCount * sizeof(vec3);
-    }
-
-    if (Bitangents)
-    {
-        Size += VertexCount * sizeof(vec3);
-    }
-
-    if (TextureCoords)
-    {
-        Size += VertexCount * sizeof(vec2);
-    }
-
-    if (Weights)
-    {
-        Size += VertexCount * sizeof(vec4);
-    }
-
-    if (JointIndices)
-    {
-        Size += VertexCount * sizeof(ivec4);
-    }
-
-    return Size;
-}
-
 inline u32
 OpenGLGetMipmapLevelCount(u32 Width, u32 Height)
 {
@@ -558,6 +550,27 @@ OpenGLAddSkinningBuffer(opengl_state *State, u32 Id, u32 SkinningMatrixCount)
     }
 }
 
+dummy_internal void
+OpenGLAddInstanceBuffer(opengl_state *State, u32 Id, u32 MaxInstanceCount)
+{
+    opengl_instance_buffer *InstanceBuffer = HashTableLookup(&State->InstanceBuffers, Id);
+
+    if (IsSlotEmpty(InstanceBuffer->Key))
+    {
+        InstanceBuffer->Key = Id;
+        InstanceBuffer->MaxInstanceCount = 0;
+
+        glCreateBuffers(1, &InstanceBuffer->Handle);
+    }
+
+    // Previous content is lost, game uploads all instances again after resize
+    if (InstanceBuffer->MaxInstanceCount < MaxInstanceCount)
+    {
+        InstanceBuffer->MaxInstanceCount = MaxInstanceCount;
+        glNamedBufferData(InstanceBuffer->Handle, MaxInstanceCount * sizeof(mesh_instance), 0, GL_DYNAMIC_DRAW);
+    }
+}
+
 dummy_internal void
 OpenGLAddSkybox(opengl_state *State, texture *EquirectEnvMap, u32 EnvMapSize, u32 SkyboxId)
 {
@@ -676,6 +689,10 @@ OpenGLAddSkybox(opengl_state *State, texture *EquirectEnvMap, u32 EnvMapSize, u3
     glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 }
 
+/*
+    Vertex shaders only read the quantized layout (see quantized_mesh_vertices), so float meshes are quantized here.
+    Weights and joint indices are also stored in separate buffers, which the skinning compute shaders read.
+*/
 dummy_internal void
 OpenGLAddMeshBuffer(
     opengl_state *State,
@@ -688,21 +705,45 @@ OpenGLAddMeshBuffer(
     vec2 *TextureCoords,
     vec4 *Weights,
     ivec4 *JointIndices,
+    quantized_mesh_vertices *QuantizedVertices,
     u32 IndexCount,
     u32 *Indices
 )
 {
     opengl_mesh_buffer *MeshBuffer = HashTableLookup(&State->MeshBuffers, MeshId);
 
-    Assert(IsSlotEmpty(MeshBuffer->Key));
+    // Removed mesh buffers keep their key, so the id can be added again
+    Assert(IsSlotEmpty(MeshBuffer->Key) || (MeshBuffer->Key == MeshId && !MeshBuffer->VAO));
+
+    scoped_memory ScopedMemory(State->Arena);
+
+    quantized_mesh_vertices Vertices = {};
 
-    u32 BufferSize = GetMeshVerticesSize(VertexCount, Positions, Normals, Tangents, Bitangents, TextureCoords, Weights, JointIndices);
+    if (QuantizedVertices)
+    {
+        Vertices = *QuantizedVertices;
+    }
+    else
+    {
+        if (Positions) Vertices.Positions = PushArray(ScopedMemory.Arena, VertexCount, quantized_position, NoClear());
+        if (Normals) Vertices.Normals = PushArray(ScopedMemory.Arena, VertexCount, u32, NoClear());
+        if (Tangents) Vertices.Tangents = PushArray(ScopedMemory.Arena, VertexCount, u32, NoClear());
+        if (TextureCoords) Vertices.TextureCoords = PushArray(ScopedMemory.Arena, VertexCount, u32, NoClear());
+        if (Weights) Vertices.Weights = PushArray(ScopedMemory.Arena, VertexCount, u32, NoClear());
+        if (JointIndices) Vertices.JointIndices = PushArray(ScopedMemory.Arena, VertexCount, u32, NoClear());
+
+        QuantizeMeshVertices(VertexCount, Positions, Normals, Tangents, Bitangents, TextureCoords, Weights, JointIndices, &Vertices);
+    }
+
+    u32 BufferSize = GetQuantizedMeshVerticesSize(VertexCount, &Vertices);
 
     MeshBuffer->Key = MeshId;
     MeshBuffer->VertexCount = VertexCount;
     MeshBuffer->IndexCount = IndexCount;
     MeshBuffer->BufferSize = BufferSize;
     MeshBuffer->InstanceCount = 0;
+    MeshBuffer->PositionOffset = Vertices.PositionOffset;
+    MeshBuffer->PositionScale = Vertices.PositionScale;
 
     glCreateVertexArrays(1, &MeshBuffer->VAO);
 
@@ -711,81 +752,55 @@ OpenGLAddMeshBuffer(
 
     // per-vertex attributes
     u32 Offset = 0;
-    if (Positions)
-    {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 0, 3, Offset, 0, sizeof(vec3));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec3), Positions);
-        Offset += VertexCount * sizeof(vec3);
-
-        //
-        scoped_memory ScopedMemory(State->Arena);
-        vec4 *PositionsVec4 = PushArray(ScopedMemory.Arena, VertexCount, vec4);
-
-        for (u32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
-        {
-            vec3 Position = Positions[VertexIndex];
-            vec4 *PositionVec4 = PositionsVec4 + VertexIndex;
-
-            PositionVec4->x = Position.x;
-            PositionVec4->y = Position.y;
-            PositionVec4->z = Position.z;
-            PositionVec4->w = 1.f;
-        }
-
-        glCreateBuffers(1, &MeshBuffer->PositionsBuffer);
-        glNamedBufferData(MeshBuffer->PositionsBuffer, VertexCount * sizeof(vec4), PositionsVec4, GL_STATIC_DRAW);
-        //
-    }
-
-    if (Normals)
+    if (Vertices.Positions)
     {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 1, 3, Offset, 0, sizeof(vec3));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec3), Normals);
-        Offset += VertexCount * sizeof(vec3);
+        OpenGLPackedVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, Offset, sizeof(quantized_position));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(quantized_position), Vertices.Positions);
+        Offset += VertexCount * sizeof(quantized_position);
     }
 
-    if (Tangents)
+    if (Vertices.Normals)
     {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 2, 3, Offset, 0, sizeof(vec3));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec3), Tangents);
-        Offset += VertexCount * sizeof(vec3);
+        OpenGLPackedVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 1, 2, GL_SHORT, GL_TRUE, Offset, sizeof(u32));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(u32), Vertices.Normals);
+        Offset += VertexCount * sizeof(u32);
     }
 
-    if (Bitangents)
+    if (Vertices.Tangents)
     {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 3, 3, Offset, 0, sizeof(vec3));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec3), Bitangents);
-        Offset += VertexCount * sizeof(vec3);
+        OpenGLPackedVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 2, 2, GL_SHORT, GL_TRUE, Offset, sizeof(u32));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(u32), Vertices.Tangents);
+        Offset += VertexCount * sizeof(u32);
     }
 
-    if (TextureCoords)
+    if (Vertices.TextureCoords)
     {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 4, 2, Offset, 0, sizeof(vec2));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec2), TextureCoords);
-        Offset += VertexCount * sizeof(vec2);
+        OpenGLPackedVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 4, 2, GL_HALF_FLOAT, GL_FALSE, Offset, sizeof(u32));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(u32), Vertices.TextureCoords);
+        Offset += VertexCount * sizeof(u32);
     }
 
-    if (Weights)
+    if (Vertices.Weights)
     {
-        OpenGLVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 5, 4, Offset, 0, sizeof(vec4));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(vec4), Weights);
-        Offset += VertexCount * sizeof(vec4);
+        OpenGLPackedVertexAttribute(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 5, 4, GL_UNSIGNED_BYTE, GL_TRUE, Offset, sizeof(u32));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(u32), Vertices.Weights);
+        Offset += VertexCount * sizeof(u32);
 
         glCreateBuffers(1, &MeshBuffer->WeightsBuffer);
-        glNamedBufferData(MeshBuffer->WeightsBuffer, VertexCount * sizeof(vec4), Weights, GL_STATIC_DRAW);
+        glNamedBufferData(MeshBuffer->WeightsBuffer, VertexCount * sizeof(u32), Vertices.Weights, GL_STATIC_DRAW);
     }
 
-    if (JointIndices)
+    if (Vertices.JointIndices)
     {
-        OpenGLVertexAttributeInteger(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 6, 4, Offset, 0, sizeof(ivec4));
-        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(ivec4), JointIndices);
-        Offset += VertexCount * sizeof(ivec4);
+        OpenGLPackedVertexAttributeInteger(MeshBuffer->VAO, MeshBuffer->VertexBuffer, 6, 4, GL_UNSIGNED_BYTE, Offset, sizeof(u32));
+        glNamedBufferSubData(MeshBuffer->VertexBuffer, Offset, VertexCount * sizeof(u32), Vertices.JointIndices);
+        Offset += VertexCount * sizeof(u32);
 
         glCreateBuffers(1, &MeshBuffer->JointIndicesBuffer);
-        glNamedBufferData(MeshBuffer->JointIndicesBuffer, VertexCount * sizeof(ivec4), JointIndices, GL_STATIC_DRAW);
+        glNamedBufferData(MeshBuffer->JointIndicesBuffer, VertexCount * sizeof(u32), Vertices.JointIndices, GL_STATIC_DRAW);
     }
 
-    if (Weights && JointIndices)
+    if (Vertices.Weights && Vertices.JointIndices)
     {
         glCreateBuffers(1, &MeshBuffer->SkinningMatricesBuffer);
         glNamedBufferData(MeshBuffer->SkinningMatricesBuffer, VertexCount * sizeof(mat4), 0, GL_STREAM_DRAW);
@@ -794,12 +809,8 @@ OpenGLAddMeshBuffer(
     glCreateBuffers(1, &MeshBuffer->InstanceBuffer);
     glNamedBufferData(MeshBuffer->InstanceBuffer, 0, 0, GL_STREAM_DRAW);
 
-    // per-instance attributes
-    OpenGLInstanceAttribute(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 7, 4, 0, (StructOffset(mesh_instance, Model) + 0 * sizeof(vec4)), sizeof(mesh_instance));
-    OpenGLInstanceAttribute(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 8, 4, 0, (StructOffset(mesh_instance, Model) + 1 * sizeof(vec4)), sizeof(mesh_instance));
-    OpenGLInstanceAttribute(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 9, 4, 0, (StructOffset(mesh_instance, Model) + 2 * sizeof(vec4)), sizeof(mesh_instance));
-    OpenGLInstanceAttribute(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 10, 4, 0, (StructOffset(mesh_instance, Model) + 3 * sizeof(vec4)), sizeof(mesh_instance));
-    OpenGLInstanceAttribute(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 11, 3, 0, StructOffset(mesh_instance, Color), sizeof(mesh_instance));
+    // per-instance attributes (index into the instance buffer, see mesh_instanced.vert)
+    OpenGLInstanceAttributeInteger(MeshBuffer->VAO, MeshBuffer->InstanceBuffer, 7, 1, 0, 0, sizeof(u32));
 
     glCreateBuffers(1, &MeshBuffer->IndexBuffer);
     glNamedBufferStorage(MeshBuffer->IndexBuffer, IndexCount * sizeof(u32), Indices, 0);
@@ -834,12 +845,24 @@ OpenGLGetTextureInternalFormat(bitmap *Bitmap)
     return -1;
 }
 
+inline GLenum
+OpenGLGetCompressedTextureFormat(bitmap_format Format)
+{
+    if (Format == BitmapFormat_BC1) return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (Format == BitmapFormat_BC3) return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    if (Format == BitmapFormat_BC4) return GL_COMPRESSED_RED_RGTC1;
+    if (Format == BitmapFormat_BC5) return GL_COMPRESSED_RG_RGTC2;
+    if (Format == BitmapFormat_BC1_SRGB) return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    if (Format == BitmapFormat_BC3_SRGB) return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+
+    Assert(!"Invalid compressed format");
+
+    return 0;
+}
+
 dummy_internal void
 OpenGLAddTexture(opengl_state *State, u32 Id, bitmap *Bitmap)
 {
-    GLint Format = OpenGLGetTextureFormat(Bitmap);
-    GLint InternalFormat = OpenGLGetTextureInternalFormat(Bitmap);
-
     GLuint TextureHandle;
 
     glCreateTextures(GL_TEXTURE_2D, 1, &TextureHandle);
@@ -849,24 +872,51 @@ OpenGLAddTexture(opengl_state *State, u32 Id, bitmap *Bitmap)
     glTextureParameteri(TextureHandle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTextureParameteri(TextureHandle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    u32 Levels = OpenGLGetMipmapLevelCount(Bitmap->Width, Bitmap->Height);
+    if (Bitmap->Format == BitmapFormat_Raw)
+    {
+        GLint Format = OpenGLGetTextureFormat(Bitmap);
+        GLint InternalFormat = OpenGLGetTextureInternalFormat(Bitmap);
 
-    glTextureStorage2D(TextureHandle, Levels, InternalFormat, Bitmap->Width, Bitmap->Height);
+        u32 Levels = OpenGLGetMipmapLevelCount(Bitmap->Width, Bitmap->Height);
 
-    if (Bitmap->IsHDR)
-    {
-        glTextureSubImage2D(TextureHandle, 0, 0, 0, Bitmap->Width, Bitmap->Height, Format, GL_FLOAT, Bitmap->Pixels);
+        glTextureStorage2D(TextureHandle, Levels, InternalFormat, Bitmap->Width, Bitmap->Height);
+
+        if (Bitmap->IsHDR)
+        {
+            glTextureSubImage2D(TextureHandle, 0, 0, 0, Bitmap->Width, Bitmap->Height, Format, GL_FLOAT, Bitmap->Pixels);
+        }
+        else
+        {
+            glTextureSubImage2D(TextureHandle, 0, 0, 0, Bitmap->Width, Bitmap->Height, Format, GL_UNSIGNED_BYTE, Bitmap->Pixels);
+        }
+
+        glGenerateTextureMipmap(TextureHandle);
     }
     else
     {
-        glTextureSubImage2D(TextureHandle, 0, 0, 0, Bitmap->Width, Bitmap->Height, Format, GL_UNSIGNED_BYTE, Bitmap->Pixels);
-    }
+        // Mip chain is built by the assets builder
+        GLenum InternalFormat = OpenGLGetCompressedTextureFormat(Bitmap->Format);
 
-    glGenerateTextureMipmap(TextureHandle);
+        if (Bitmap->MipCount > 1)
+        {
+            glTextureParameteri(TextureHandle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        }
+
+        glTextureStorage2D(TextureHandle, Bitmap->MipCount, InternalFormat, Bitmap->Width, Bitmap->Height);
+
+        for (u32 MipIndex = 0; MipIndex < Bitmap->MipCount; ++MipIndex)
+        {
+            i32 MipWidth = GetBitmapMipDimension(Bitmap->Width, MipIndex);
+            i32 MipHeight = GetBitmapMipDimension(Bitmap->Height, MipIndex);
+            u32 MipSize = GetBitmapMipSize(Bitmap->Format, Bitmap->Width, Bitmap->Height, MipIndex);
+
+            glCompressedTextureSubImage2D(TextureHandle, MipIndex, 0, 0, MipWidth, MipHeight, InternalFormat, MipSize, Bitmap->Mips[MipIndex]);
+        }
+    }
 
     opengl_texture *Texture = HashTableLookup(&State->Textures, Id);
 
-    Assert(IsSlotEmpty(Texture->Key));
+    Assert(IsSlotEmpty(Texture->Key) || (Texture->Key == Id && !Texture->Handle));
 
     Texture->Key = Id;
     Texture->Handle = TextureHandle;
@@ -874,6 +924,50 @@ OpenGLAddTexture(opengl_state *State, u32 Id, bitmap *Bitmap)
     Texture->Height = Bitmap->Height;
 }
 
+/*
+    Hash tables use open addressing, so removed entries keep their key (emptying the slot would break the probe chains of other keys).
+    Zero handle marks the entry as removed.
+*/
+dummy_internal void
+OpenGLRemoveMeshBuffer(opengl_state *State, u32 MeshId)
+{
+    opengl_mesh_buffer *MeshBuffer = HashTableLookup(&State->MeshBuffers, MeshId);
+
+    Assert(MeshBuffer->Key == MeshId && MeshBuffer->VAO);
+
+    GLuint Buffers[] =
+    {
+        MeshBuffer->VertexBuffer,
+        MeshBuffer->InstanceBuffer,
+        MeshBuffer->IndexBuffer,
+        MeshBuffer->WeightsBuffer,
+        MeshBuffer->JointIndicesBuffer,
+        MeshBuffer->SkinningMatricesBuffer
+    };
+
+    // Zero names are silently ignored
+    glDeleteBuffers(ArrayCount(Buffers), Buffers);
+    glDeleteVertexArrays(1, &MeshBuffer->VAO);
+
+    u32 Key = MeshBuffer->Key;
+    *MeshBuffer = {};
+    MeshBuffer->Key = Key;
+}
+
+dummy_internal void
+OpenGLRemoveTexture(opengl_state *State, u32 Id)
+{
+    opengl_texture *Texture = HashTableLookup(&State->Textures, Id);
+
+    Assert(Texture->Key == Id && Texture->Handle);
+
+    glDeleteTextures(1, &Texture->Handle);
+
+    u32 Key = Texture->Key;
+    *Texture = {};
+    Texture->Key = Key;
+}
+
 inline opengl_uniform *
 OpengLGetUniform(opengl_shader *Shader, const char *UniformName)
 {
@@ -889,6 +983,14 @@ OpenGLGetUniformLocation(opengl_shader *Shader, const char *UniformName)
     return Uniform->Location;
 }
 
+// Quantized positions are relative to the mesh bounds
+inline void
+OpenGLMeshVertexDecoding(opengl_shader *Shader, opengl_mesh_buffer *MeshBuffer)
+{
+    glUniform3f(OpenGLGetUniformLocation(Shader, "u_PositionOffset"), MeshBuffer->PositionOffset.x, MeshBuffer->PositionOffset.y, MeshBuffer->PositionOffset.z);
+    glUniform3f(OpenGLGetUniformLocation(Shader, "u_PositionScale"), MeshBuffer->PositionScale.x, MeshBuffer->PositionScale.y, MeshBuffer->PositionScale.z);
+}
+
 dummy_internal void
 OpenGLLoadShaderUniforms(opengl_shader *Shader, memory_arena *Arena)
 {
@@ -929,7 +1031,9 @@ OpenGLPreprocessShader(char *ShaderSource, u32 InitialSize, memory_arena *Arena)
     u32 Size = InitialSize + 256;
     char *Result = PushString(Arena, Size);
     FormatString_(Result, Size, ShaderSource,
-        OPENGL_MAX_POINT_LIGHT_COUNT,
+        LIGHT_CLUSTER_COUNT_X,
+        LIGHT_CLUSTER_COUNT_Y,
+        LIGHT_CLUSTER_COUNT_Z,
         OPENGL_WORLD_SPACE_MODE,
         OPENGL_SCREEN_SPACE_MODE,
         OPENGL_MAX_JOINT_COUNT,
@@ -1533,32 +1637,10 @@ OpenGLLogMessage(GLenum Source, GLenum Type, GLuint Id, GLenum Severity, GLsizei
 }
 
 dummy_internal void
-OpenGLInitRenderer(opengl_state *State, i32 WindowWidth, i32 WindowHeight, u32 Samples)
+OpenGLInitCascadeShadowMaps(opengl_state *State, u32 CascadeShadowMapSize)
 {
-    State->Vendor = (char *)glGetString(GL_VENDOR);
-    State->Renderer = (char *)glGetString(GL_RENDERER);
-    State->Version = (char *)glGetString(GL_VERSION);
-    State->ShadingLanguageVersion = (char *)glGetString(GL_SHADING_LANGUAGE_VERSION);
-
-    InitHashTable(&State->MeshBuffers, 1021, State->Arena);
-    InitHashTable(&State->SkinningBuffers, 509, State->Arena);
-    InitHashTable(&State->Textures, 509, State->Arena);
-    InitHashTable(&State->Shaders, 61, State->Arena);
-    InitHashTable(&State->Skyboxes, 31, State->Arena);
-
-    State->CascadeShadowMapSize = 4096;
+    State->CascadeShadowMapSize = CascadeShadowMapSize;
 
-    OpenGLInitLine(State);
-    OpenGLInitRectangle(State);
-    OpenGLInitBox(State);
-    OpenGLInitText(State);
-    OpenGLInitParticles(State);
-
-    OpenGLInitShaders(State);
-    OpenGLInitFramebuffers(State, WindowWidth, WindowHeight, Samples);
-
-    // Shadow Map Configuration
-    glCreateFramebuffers(1, &State->CascadeShadowMapFBO);
     glCreateTextures(GL_TEXTURE_2D, 4, State->CascadeShadowMaps);
 
     // todo: use Array Texture
@@ -1584,6 +1666,35 @@ OpenGLInitRenderer(opengl_state *State, i32 WindowWidth, i32 WindowHeight, u32 S
 
     GLenum FramebufferStatus = glCheckNamedFramebufferStatus(State->CascadeShadowMapFBO, GL_FRAMEBUFFER);
     Assert(FramebufferStatus == GL_FRAMEBUFFER_COMPLETE);
+}
+
+dummy_internal void
+OpenGLInitRenderer(opengl_state *State, i32 WindowWidth, i32 WindowHeight, u32 Samples)
+{
+    State->Vendor = (char *)glGetString(GL_VENDOR);
+    State->Renderer = (char *)glGetString(GL_RENDERER);
+    State->Version = (char *)glGetString(GL_VERSION);
+    State->ShadingLanguageVersion = (char *)glGetString(GL_SHADING_LANGUAGE_VERSION);
+
+    InitHashTable(&State->MeshBuffers, 1021, State->Arena);
+    InitHashTable(&State->SkinningBuffers, 509, State->Arena);
+    InitHashTable(&State->InstanceBuffers, 1021, State->Arena);
+    InitHashTable(&State->Textures, 509, State->Arena);
+    InitHashTable(&State->Shaders, 61, State->Arena);
+    InitHashTable(&State->Skyboxes, 31, State->Arena);
+
+    OpenGLInitLine(State);
+    OpenGLInitRectangle(State);
+    OpenGLInitBox(State);
+    OpenGLInitText(State);
+    OpenGLInitParticles(State);
+
+    OpenGLInitShaders(State);
+    OpenGLInitFramebuffers(State, WindowWidth, WindowHeight, Samples);
+
+    // Shadow Map Configuration
+    glCreateFramebuffers(1, &State->CascadeShadowMapFBO);
+    OpenGLInitCascadeShadowMaps(State, (u32) GetCVarInt(State->CascadeShadowMapSizeCVar));
     //
 
     glCreateBuffers(1, &State->TransformUBO);
@@ -1594,6 +1705,27 @@ OpenGLInitRenderer(opengl_state *State, i32 WindowWidth, i32 WindowHeight, u32 S
     glNamedBufferStorage(State->ShadingUBO, sizeof(opengl_uniform_buffer_shading), 0, GL_DYNAMIC_STORAGE_BIT);
     glBindBufferBase(GL_UNIFORM_BUFFER, 1, State->ShadingUBO);
 
+    State->MaxPointLightCount = 64;
+    glCreateBuffers(1, &State->PointLightsBuffer);
+    glNamedBufferData(State->PointLightsBuffer, State->MaxPointLightCount * sizeof(opengl_point_light), 0, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, State->PointLightsBuffer);
+
+    {
+        scoped_memory ScopedMemory(State->Arena);
+
+        // Empty clusters until the first SetLightClusters command
+        light_cluster *Clusters = PushArray(ScopedMemory.Arena, LIGHT_CLUSTER_COUNT, light_cluster);
+
+        glCreateBuffers(1, &State->LightClustersBuffer);
+        glNamedBufferStorage(State->LightClustersBuffer, LIGHT_CLUSTER_COUNT * sizeof(light_cluster), Clusters, GL_DYNAMIC_STORAGE_BIT);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, State->LightClustersBuffer);
+    }
+
+    State->MaxLightIndexCount = 1024;
+    glCreateBuffers(1, &State->LightIndicesBuffer);
+    glNamedBufferData(State->LightIndicesBuffer, State->MaxLightIndexCount * sizeof(u32), 0, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, State->LightIndicesBuffer);
+
     // todo: cleanup
     bitmap WhiteTexture = {};
     WhiteTexture.Width = 1;
@@ -1648,7 +1780,7 @@ OpenGLPrepareScene(opengl_state *State, render_commands *Commands)
                 OpenGLAddMeshBuffer(
                     State, Command->MeshId, Command->VertexCount,
                     Command->Positions, Command->Normals, Command->Tangents, Command->Bitangents, Command->TextureCoords,
-                    Command->Weights, Command->JointIndices, Command->IndexCount, Command->Indices
+                    Command->Weights, Command->JointIndices, Command->QuantizedVertices, Command->IndexCount, Command->Indices
                 );
 
                 break;
@@ -1669,6 +1801,14 @@ OpenGLPrepareScene(opengl_state *State, render_commands *Commands)
 
                 break;
             }
+            case RenderCommand_AddInstanceBuffer:
+            {
+                render_command_add_instance_buffer *Command = (render_command_add_instance_buffer *)Entry;
+
+                OpenGLAddInstanceBuffer(State, Command->InstanceBufferId, Command->MaxInstanceCount);
+
+                break;
+            }
             case RenderCommand_AddSkybox:
             {
                 render_command_add_skybox *Command = (render_command_add_skybox *)Entry;
@@ -1677,6 +1817,39 @@ OpenGLPrepareScene(opengl_state *State, render_commands *Commands)
 
                 break;
             }
+            case RenderCommand_RemoveMesh:
+            {
+                render_command_remove_mesh *Command = (render_command_remove_mesh *)Entry;
+
+                OpenGLRemoveMeshBuffer(State, Command->MeshId);
+
+                break;
+            }
+            case RenderCommand_RemoveTexture:
+            {
+                render_command_remove_texture *Command = (render_command_remove_texture *)Entry;
+
+                OpenGLRemoveTexture(State, Command->Id);
+
+                break;
+            }
+            case RenderCommand_UpdateInstanceBuffer:
+            {
+                render_command_update_instance_buffer *Command = (render_command_update_instance_buffer *)Entry;
+
+                opengl_instance_buffer *InstanceBuffer = OpenGLGetInstanceBuffer(State, Command->InstanceBufferId);
+
+                Assert(Command->StartInstance + Command->InstanceCount <= InstanceBuffer->MaxInstanceCount);
+
+                glNamedBufferSubData(
+                    InstanceBuffer->Handle,
+                    Command->StartInstance * sizeof(mesh_instance),
+                    Command->InstanceCount * sizeof(mesh_instance),
+                    Command->Instances
+                );
+
+                break;
+            }
             case RenderCommand_DrawSkinnedMesh:
             {
                 render_command_draw_skinned_mesh *Command = (render_command_draw_skinned_mesh *) Entry;
@@ -1688,7 +1861,6 @@ OpenGLPrepareScene(opengl_state *State, render_commands *Commands)
 
                 glUseProgram(Shader->Program);
 
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->PositionsBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, MeshBuffer->WeightsBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, MeshBuffer->JointIndicesBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, MeshBuffer->SkinningMatricesBuffer);
@@ -1749,7 +1921,6 @@ OpenGLPrepareScene(opengl_state *State, render_commands *Commands)
 
                 glUseProgram(Shader->Program);
 
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->PositionsBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, MeshBuffer->WeightsBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, MeshBuffer->JointIndicesBuffer);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, MeshBuffer->SkinningMatricesBuffer);
@@ -1892,8 +2063,34 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                         Dest->Attenuation = vec3(Source->Attenuation.Constant, Source->Attenuation.Linear, Source->Attenuation.Quadratic);
                     }
 
+                    if (State->MaxPointLightCount < Command->PointLightCount)
+                    {
+                        State->MaxPointLightCount = (u32)(Command->PointLightCount * 1.5f);
+                        glNamedBufferData(State->PointLightsBuffer, State->MaxPointLightCount * sizeof(opengl_point_light), 0, GL_DYNAMIC_DRAW);
+                    }
+
                     glNamedBufferSubData(State->ShadingUBO, StructOffset(opengl_uniform_buffer_shading, PointLightCount), sizeof(u32), &Command->PointLightCount);
-                    glNamedBufferSubData(State->ShadingUBO, StructOffset(opengl_uniform_buffer_shading, PointLights), Command->PointLightCount * sizeof(opengl_point_light), PointLights);
+                    glNamedBufferSubData(State->PointLightsBuffer, 0, Command->PointLightCount * sizeof(opengl_point_light), PointLights);
+                }
+
+                break;
+            }
+            case RenderCommand_SetLightClusters:
+            {
+                if (!Options->RenderShadowMap)
+                {
+                    render_command_set_light_clusters *Command = (render_command_set_light_clusters *)Entry;
+
+                    if (State->MaxLightIndexCount < Command->LightIndexCount)
+                    {
+                        State->MaxLightIndexCount = (u32)(Command->LightIndexCount * 1.5f);
+                        glNamedBufferData(State->LightIndicesBuffer, State->MaxLightIndexCount * sizeof(u32), 0, GL_DYNAMIC_DRAW);
+                    }
+
+                    glNamedBufferSubData(State->ShadingUBO, StructOffset(opengl_uniform_buffer_shading, LightClusterNear), sizeof(f32), &Command->Near);
+                    glNamedBufferSubData(State->ShadingUBO, StructOffset(opengl_uniform_buffer_shading, LightClusterFar), sizeof(f32), &Command->Far);
+                    glNamedBufferSubData(State->LightClustersBuffer, 0, LIGHT_CLUSTER_COUNT * sizeof(light_cluster), Command->Clusters);
+                    glNamedBufferSubData(State->LightIndicesBuffer, 0, Command->LightIndexCount * sizeof(u32), Command->LightIndices);
                 }
 
                 break;
@@ -2274,7 +2471,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
             {
                 render_command_draw_mesh *Command = (render_command_draw_mesh *) Entry;
 
-                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || !Options->RenderShadowMap)
+                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || (!Options->RenderShadowMap && !Command->Material.Options.ShadowOnly))
                 {
                     opengl_mesh_buffer *MeshBuffer = OpenGLGetMeshBuffer(State, Command->MeshId);
 
@@ -2289,6 +2486,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "mesh.phong");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glUniformMatrix4fv(OpenGLGetUniformLocation(Shader, "u_Model"), 1, GL_TRUE, (f32 *)Model.Elements);
                             glUniform3f(OpenGLGetUniformLocation(Shader, "u_Color"), Command->Material.Color.r, Command->Material.Color.g, Command->Material.Color.b);
                             
@@ -2304,6 +2502,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "mesh.pbr");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glUniformMatrix4fv(OpenGLGetUniformLocation(Shader, "u_Model"), 1, GL_TRUE, (f32 *)Model.Elements);
                             glUniform3f(OpenGLGetUniformLocation(Shader, "u_Color"), Command->Material.Color.r, Command->Material.Color.g, Command->Material.Color.b);
 
@@ -2319,7 +2518,29 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                         }
                     }
 
-                    glDrawElements(GL_TRIANGLES, MeshBuffer->IndexCount, GL_UNSIGNED_INT, 0);
+                    if (Command->IndexRangeOffsets && !Options->RenderShadowMap)
+                    {
+                        if (Command->IndexRangeCount > 0)
+                        {
+                            scoped_memory ScopedMemory(State->Arena);
+
+                            void **IndexRangeOffsets = PushArray(ScopedMemory.Arena, Command->IndexRangeCount, void *, NoClear());
+
+                            for (u32 RangeIndex = 0; RangeIndex < Command->IndexRangeCount; ++RangeIndex)
+                            {
+                                IndexRangeOffsets[RangeIndex] = (void *)(Command->IndexRangeOffsets[RangeIndex] * sizeof(u32));
+                            }
+
+                            glMultiDrawElements(
+                                GL_TRIANGLES, (GLsizei *)Command->IndexRangeCounts, GL_UNSIGNED_INT,
+                                IndexRangeOffsets, Command->IndexRangeCount
+                            );
+                        }
+                    }
+                    else
+                    {
+                        glDrawElements(GL_TRIANGLES, Command->IndexCount, GL_UNSIGNED_INT, (void *)(Command->IndexOffset * sizeof(u32)));
+                    }
                 }
 
                 break;
@@ -2328,7 +2549,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
             {
                 render_command_draw_mesh_instanced *Command = (render_command_draw_mesh_instanced *)Entry;
 
-                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || !Options->RenderShadowMap)
+                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || (!Options->RenderShadowMap && !Command->Material.Options.ShadowOnly))
                 {
                     opengl_mesh_buffer *MeshBuffer = OpenGLGetMeshBuffer(State, Command->MeshId);
                     mesh_material *MeshMaterial = Command->Material.MeshMaterial;
@@ -2339,10 +2560,13 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                     if (MeshBuffer->InstanceCount < Command->InstanceCount)
                     {
                         MeshBuffer->InstanceCount = (u32)(Command->InstanceCount * 1.5f);
-                        glNamedBufferData(MeshBuffer->InstanceBuffer, MeshBuffer->InstanceCount * sizeof(mesh_instance), 0, GL_STREAM_DRAW);
+                        glNamedBufferData(MeshBuffer->InstanceBuffer, MeshBuffer->InstanceCount * sizeof(u32), 0, GL_STREAM_DRAW);
                     }
 
-                    glNamedBufferSubData(MeshBuffer->InstanceBuffer, 0, Command->InstanceCount * sizeof(mesh_instance), Command->Instances);
+                    glNamedBufferSubData(MeshBuffer->InstanceBuffer, 0, Command->InstanceCount * sizeof(u32), Command->InstanceIndices);
+
+                    opengl_instance_buffer *InstanceBuffer = OpenGLGetInstanceBuffer(State, Command->InstanceBufferId);
+                    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, InstanceBuffer->Handle);
 
                     switch (Command->Material.Type)
                     {
@@ -2351,6 +2575,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "mesh_instanced.phong");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             OpenGLCascadeShadows(State, Shader, Options);
                             OpenGLBlinnPhongShading(State, Shader, &Command->Material);
 
@@ -2361,6 +2586,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "mesh_instanced.pbr");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             OpenGLCascadeShadows(State, Shader, Options);
                             OpenGLPBRShading(State, Shader, &Command->Material);
 
@@ -2372,7 +2598,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                         }
                     }
 
-                    glDrawElementsInstanced(GL_TRIANGLES, MeshBuffer->IndexCount, GL_UNSIGNED_INT, 0, Command->InstanceCount);
+                    glDrawElementsInstanced(GL_TRIANGLES, Command->IndexCount, GL_UNSIGNED_INT, (void *)(Command->IndexOffset * sizeof(u32)), Command->InstanceCount);
                 }
 
                 break;
@@ -2381,7 +2607,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
             {
                 render_command_draw_skinned_mesh *Command = (render_command_draw_skinned_mesh *)Entry;
 
-                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || !Options->RenderShadowMap)
+                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || (!Options->RenderShadowMap && !Command->Material.Options.ShadowOnly))
                 {
                     opengl_mesh_buffer *MeshBuffer = OpenGLGetMeshBuffer(State, Command->MeshId);
                     mesh_material *MeshMaterial = Command->Material.MeshMaterial;
@@ -2395,6 +2621,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "skinned_mesh.phong");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->SkinningMatricesBuffer);
 
                             OpenGLCascadeShadows(State, Shader, Options);
@@ -2407,6 +2634,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "skinned_mesh.pbr");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->SkinningMatricesBuffer);
 
                             OpenGLCascadeShadows(State, Shader, Options);
@@ -2421,7 +2649,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                         }
                     }
 
-                    glDrawElements(GL_TRIANGLES, MeshBuffer->IndexCount, GL_UNSIGNED_INT, 0);
+                    glDrawElements(GL_TRIANGLES, Command->IndexCount, GL_UNSIGNED_INT, (void *)(Command->IndexOffset * sizeof(u32)));
                 }
 
                 break;
@@ -2430,7 +2658,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
             {
                 render_command_draw_skinned_mesh_instanced *Command = (render_command_draw_skinned_mesh_instanced *)Entry;
 
-                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || !Options->RenderShadowMap)
+                if ((Options->RenderShadowMap && Command->Material.Options.CastShadow) || (!Options->RenderShadowMap && !Command->Material.Options.ShadowOnly))
                 {
                     opengl_mesh_buffer *MeshBuffer = OpenGLGetMeshBuffer(State, Command->MeshId);
                     mesh_material *MeshMaterial = Command->Material.MeshMaterial;
@@ -2444,6 +2672,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "skinned_mesh_instanced.phong");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->SkinningMatricesBuffer);
                             glUniform1i(OpenGLGetUniformLocation(Shader, "u_VertexCount"), MeshBuffer->VertexCount);
 
@@ -2457,6 +2686,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                             opengl_shader *Shader = OpenGLGetShader(State, "skinned_mesh_instanced.pbr");
 
                             glUseProgram(Shader->Program);
+                            OpenGLMeshVertexDecoding(Shader, MeshBuffer);
                             glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, MeshBuffer->SkinningMatricesBuffer);
                             glUniform1i(OpenGLGetUniformLocation(Shader, "u_VertexCount"), MeshBuffer->VertexCount);
 
@@ -2472,7 +2702,7 @@ OpenGLRenderScene(opengl_state *State, render_commands *Commands, opengl_render_
                         }
                     }
 
-                    glDrawElementsInstanced(GL_TRIANGLES, MeshBuffer->IndexCount, GL_UNSIGNED_INT, 0, Command->InstanceCount);
+                    glDrawElementsInstanced(GL_TRIANGLES, Command->IndexCount, GL_UNSIGNED_INT, (void *)(Command->IndexOffset * sizeof(u32)), Command->InstanceCount);
                 }
 
                 break;
@@ -2528,6 +2758,14 @@ OpenGLProcessRenderCommands(opengl_state *State, render_commands *Commands)
 {
     ClearStream(State->Stream);
 
+    u32 CascadeShadowMapSize = (u32) GetCVarInt(State->CascadeShadowMapSizeCVar);
+
+    if (CascadeShadowMapSize != State->CascadeShadowMapSize)
+    {
+        glDeleteTextures(ArrayCount(State->CascadeShadowMaps), State->CascadeShadowMaps);
+        OpenGLInitCascadeShadowMaps(State, CascadeShadowMapSize);
+    }
+
     for (u32 BaseAddress = 0; BaseAddress < Commands->RenderCommandsBufferSize;)
     {
         render_command_header *Entry = (render_command_header *)((u8 *)Commands->RenderCommandsBuffer + BaseAddress);
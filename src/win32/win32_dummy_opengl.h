@@ -12,8 +12,6 @@ extern "C" {
 #define OPENGL_RELOADABLE_SHADERS 1
 #define OPENGL_MAX_SHADER_FILE_PATH 256
 
-#define OPENGL_MAX_POINT_LIGHT_COUNT 16
-
 #define OPENGL_WORLD_SPACE_MODE 0x1
 #define OPENGL_SCREEN_SPACE_MODE 0x2
 #define OPENGL_MAX_JOINT_COUNT 256
@@ -21,6 +19,13 @@ extern "C" {
 #define OPENGL_UNIFORM_MAX_LENGTH 64
 #define OPENGL_UNIFORM_MAX_COUNT 509
 
+// EXT_texture_compression_s3tc (not in the generated glad loader, supported by every desktop driver)
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+// EXT_texture_sRGB
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+
 const char *OpenGLCommonShaders[] =
 {
     "shaders\\glsl\\common\\version.glsl",
@@ -198,13 +203,16 @@ struct opengl_mesh_buffer
     GLuint InstanceBuffer;
     GLuint IndexBuffer;
 
-    GLuint PositionsBuffer;
     GLuint WeightsBuffer;
     GLuint JointIndicesBuffer;
     GLuint SkinningMatricesBuffer;
 
     u32 BufferSize;
     u32 InstanceCount;
+
+    // See quantized_mesh_vertices
+    vec3 PositionOffset;
+    vec3 PositionScale;
 };
 
 struct opengl_skinning_buffer
@@ -215,6 +223,14 @@ struct opengl_skinning_buffer
     GLuint SkinningTBOTexture;
 };
 
+struct opengl_instance_buffer
+{
+    u32 Key;
+
+    u32 MaxInstanceCount;
+    GLuint Handle;
+};
+
 struct opengl_texture
 {
     u32 Key;
@@ -291,7 +307,8 @@ struct opengl_uniform_buffer_shading
     opengl_directional_light DirectinalLight;
 
     u32 PointLightCount;
-    opengl_point_light PointLights[OPENGL_MAX_POINT_LIGHT_COUNT];
+    f32 LightClusterNear;
+    f32 LightClusterFar;
 };
 
 struct opengl_render_options
@@ -338,14 +355,24 @@ struct opengl_state
     GLuint TransformUBO;
     GLuint ShadingUBO;
 
+    // Shader storage buffers for clustered point lights (see common/uniform.glsl)
+    GLuint PointLightsBuffer;
+    GLuint LightClustersBuffer;
+    GLuint LightIndicesBuffer;
+    u32 MaxPointLightCount;
+    u32 MaxLightIndexCount;
+
     hash_table<opengl_mesh_buffer> MeshBuffers;
     hash_table<opengl_skinning_buffer> SkinningBuffers;
+    hash_table<opengl_instance_buffer> InstanceBuffers;
     hash_table<opengl_texture> Textures;
     hash_table<opengl_shader> Shaders;
     hash_table<opengl_skybox> Skyboxes;
 
     u32 CurrentSkyboxId;
 
+    // Shadow maps are reallocated once the cvar changes
+    cvar *CascadeShadowMapSizeCVar;
     u32 CascadeShadowMapSize;
     GLuint CascadeShadowMapFBO;
     GLuint CascadeShadowMaps[4];